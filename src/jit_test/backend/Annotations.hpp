@@ -0,0 +1,58 @@
+#ifndef BACKEND_ANNOTATIONS_HPP
+#define BACKEND_ANNOTATIONS_HPP
+#pragma once
+#include <cstdint>
+#include "../instructions/Base.hpp"
+
+namespace JIT {
+    class Annotations;
+}
+
+/**
+ * @brief Notes of a generator about the code it emitted ("k-loop start", "C store"), for the Disassembler.
+ * The entries are stored in a caller provided array, the texts are not copied (string literals).
+ * Offsets are in halfwords from the start of the code buffer of the Backend.
+ */
+class JIT::Annotations {
+    public:
+        static constexpr uint16_t NONE = UINT16_MAX;
+
+        struct Entry {
+            uint16_t offset;
+            uint16_t dataHalfwords; // the following halfwords are data (a literal pool), 0 for code
+            char const * text;
+        };
+
+        Annotations(Entry * entries, uint16_t capacity) : entries(entries), capacity(capacity) {}
+
+        /// @brief Returns the index of the new entry, NONE if the table is full
+        uint16_t add(uint16_t offset, char const * text, uint16_t dataHalfwords = 0) {
+            if (count == capacity) {
+                Instructions::Base::printValidationError("Annotations::add: table is full - returning NONE");
+                return NONE;
+            }
+            entries[count] = {offset, dataHalfwords, text};
+            return count++;
+        }
+        /// @brief Moves an entry, for the annotations of a program whose offsets are only known after the passes
+        void setOffset(uint16_t index, uint16_t offset) {
+            if (index < count) entries[index].offset = offset;
+        }
+
+        Entry const * getEntries() const {
+            return entries;
+        }
+        uint16_t getCount() const {
+            return count;
+        }
+        void reset() {
+            count = 0;
+        }
+
+    private:
+        Entry * entries;
+        uint16_t capacity;
+        uint16_t count = 0;
+};
+
+#endif // BACKEND_ANNOTATIONS_HPP
@@ -1,4 +1,6 @@
 #include "Backend.hpp"
+#include "Scheduler.hpp"
+#include "instructions/Arithmetic.hpp"
 #include "instructions/Base.hpp"
 #include "instructions/DataProcessing.hpp"
 #include "instructions/Vector.hpp"
@@ -7,7 +9,9 @@
 using namespace JIT::Instructions;
 
 void JIT::Backend::addInstruction(Instruction16 instruction) {
-    if (instructionCount + 1 >= maxInstructionCount) {
+    if (program != nullptr) {
+        program->addInstruction(instruction);
+    } else if (instructionCount + 1 >= maxInstructionCount) {
         Base::printValidationError("Instruction count exceeded");
     } else {
         instructions[instructionCount++] = instruction;
@@ -15,7 +19,9 @@ void JIT::Backend::addInstruction(Instruction16 instruction) {
 }
 
 void JIT::Backend::addInstruction(Instruction32 instruction) {
-    if (instructionCount + 2 >= maxInstructionCount) {
+    if (program != nullptr) {
+        program->addInstruction(instruction);
+    } else if (instructionCount + 2 >= maxInstructionCount) {
         Base::printValidationError("Instruction count exceeded");
     } else {
         instructions[instructionCount++] = static_cast<Instruction16>(instruction >> 16U); // select 16 highest bits
@@ -24,6 +30,10 @@ void JIT::Backend::addInstruction(Instruction32 instruction) {
 }
 
 void JIT::Backend::addHeliumInstruction(Instruction32 instruction) {
+    if (program != nullptr) {
+        program->addInstruction(instruction, true); // the layout pads it
+        return;
+    }
     if (reinterpret_cast<uintptr_t>(&instructions[instructionCount]) % 4 != 0) { // if not word aligned
         addInstruction(Base::nop16());
     }
@@ -31,17 +41,28 @@ void JIT::Backend::addHeliumInstruction(Instruction32 instruction) {
 }
 
 Instruction16 * JIT::Backend::addBranchTargetInstruction(Instruction32 branchInstruction) {
+    if (inProgram("addBranchTargetInstruction: use bindLabel in a program - returning nullptr")) return nullptr;
+    scheduleBlock();
     addInstruction(branchInstruction);
     return &instructions[instructionCount - 2]; // eingefügte Instruction war 32 Bit = 2 16 Bit Instruktions lang
 }
 
 Instruction16 * JIT::Backend::addBranchTargetInstruction(Instruction16 branchInstruction) {
+    if (inProgram("addBranchTargetInstruction: use bindLabel in a program - returning nullptr")) return nullptr;
+    scheduleBlock();
     addInstruction(branchInstruction);
     return &instructions[instructionCount - 1];
 }
 
-Instruction16 * JIT::Backend::addBranchPlaceholder(bool shortBranch) {
-    return shortBranch ? addBranchTargetInstruction(Base::nop16()) : addBranchTargetInstruction(Base::nop32());
+Instruction16 * JIT::Backend::startBasicBlock() {
+    if (inProgram("startBasicBlock: use bindLabel in a program - returning nullptr")) return nullptr;
+    scheduleBlock();
+    return &instructions[instructionCount];
+}
+
+void JIT::Backend::scheduleBlock() {
+    if (scheduling && instructionCount > blockStart) Scheduler::schedule(&instructions[blockStart], instructionCount - blockStart);
+    blockStart = instructionCount;
 }
 
 void JIT::Backend::addLowOverheadBranchFromCurrentPosition(Instruction16 * loopStart, bool letp) {
@@ -65,39 +86,150 @@ void JIT::Backend::addBackwardsBranchFromCurrentPosition(Instruction16 * branchT
     }
 }
 
-void JIT::Backend::setForwardsBranch(Instruction16 * branchInstruction, Instruction16 * branchTarget, Condition branchCondition) {
-    int16_t branchOffset = (branchTarget - branchInstruction) * 2 - 4;
-    if (*branchInstruction == Base::nop16()) { // can only use 16bit branch instruction
-        if (branchCondition == AL) {
-            if (branchOffset > 2046 || branchOffset < -2048) {
-                Base::printValidationError("setForwardsBranch: 16bit branch only supports branch from [-2048, 2046] - please replace nop16 with nop32");
-                return;
-            }
-            *branchInstruction = Base::b16(branchOffset);
-        } else {
-            if (branchOffset > 254 || branchOffset < -256) {
-                Base::printValidationError("setForwardsBranch: 16bit branch only supports branch from [-256, 254] - please replace nop16 with nop32");
-                return;
-            }
-            *branchInstruction = Base::bCond16(branchCondition, branchOffset);
+int16_t JIT::Backend::getBranchOffset(Instruction16 * instrStart) {
+    if (inProgram("getBranchOffset: use labels in a program - returning 0")) return 0;
+    return (instrStart - &instructions[instructionCount]) * 2; // jede Instruktion sind 16 Bit = 2 Byte
+    //return &instructions[instructionCount] - instrStart;
+}
+
+bool JIT::Backend::inProgram(char const * message) const {
+    if (program == nullptr) return false;
+    Base::printValidationError(message);
+    return true;
+}
+
+void JIT::Backend::beginProgram(IR::Program & program) {
+    scheduleBlock();
+    this->program = &program;
+}
+
+void JIT::Backend::endProgram() {
+    endProgram(IR::Pipeline::defaultPipeline(scheduling));
+}
+
+void JIT::Backend::endProgram(IR::Pipeline const & pipeline) {
+    if (program == nullptr) {
+        Base::printValidationError("endProgram: no program started - returning");
+        return;
+    }
+    IR::Program & kernel = *program;
+    program = nullptr;
+    kernel.setBaseAddress(reinterpret_cast<uintptr_t>(&instructions[instructionCount]));
+    pipeline.run(kernel);
+    uint16_t const start = instructionCount;
+    // the last halfword stays free, as with addInstruction
+    instructionCount += kernel.encode(&instructions[instructionCount], maxInstructionCount - instructionCount - 1);
+    blockStart = instructionCount; // already scheduled by the pipeline
+    if (annotations != nullptr && instructionCount > start) annotateProgram(kernel, start);
+}
+
+/*
+The annotations of the program get their final offsets, the literal pools are added as data entries.
+*/
+void JIT::Backend::annotateProgram(IR::Program const & kernel, uint16_t start) {
+    IR::Program::Node const * nodes = kernel.getNodes();
+    uint16_t literals = 0;
+    for (uint16_t i = 0; i <= kernel.getNodeCount(); i++) {
+        if (i < kernel.getNodeCount() && nodes[i].opcode == IR::Program::LITERAL) {
+            literals++;
+            continue;
         }
-    } else if ((static_cast<Instruction32>(*branchInstruction << 16)) + *(branchInstruction+1) == Base::nop32() ) { // can use 32bit branch instruction
-        Instruction32 instr;
-        if (branchCondition == AL) {
-            instr = Base::b32(branchOffset);
-        } else {
-            instr = Base::bCond32(branchCondition, branchOffset);
+        if (literals > 0) {
+            annotations->add(start + kernel.getOffset(i - literals), "literal pool", 2 * literals);
+            literals = 0;
         }
-        *branchInstruction = instr >> 16;
-        *(branchInstruction+1) = 0xffff & instr;
+        if (i < kernel.getNodeCount() && nodes[i].opcode == IR::Program::ANNOTATION) {
+            annotations->setOffset(nodes[i].label, start + kernel.getOffset(i));
+        }
+    }
+}
+
+void JIT::Backend::annotate(char const * text) {
+    if (annotations == nullptr) return;
+    if (program == nullptr) {
+        annotations->add(instructionCount, text);
+        return;
+    }
+    uint16_t const index = annotations->add(Annotations::NONE, text); // the offset is known after endProgram
+    if (index != Annotations::NONE) program->addAnnotation(index);
+}
+
+JIT::IR::Program::Label JIT::Backend::newLabel() {
+    if (program == nullptr) {
+        Base::printValidationError("newLabel: labels need a program (beginProgram) - returning NO_LABEL");
+        return IR::Program::NO_LABEL;
+    }
+    return program->newLabel();
+}
+
+void JIT::Backend::bindLabel(IR::Program::Label label) {
+    if (program == nullptr) {
+        Base::printValidationError("bindLabel: labels need a program (beginProgram) - returning");
+        return;
+    }
+    program->bindLabel(label);
+}
+
+void JIT::Backend::addBranch(IR::Program::Label label, Condition branchCondition) {
+    if (program == nullptr) {
+        Base::printValidationError("addBranch: labels need a program (beginProgram) - returning");
+        return;
+    }
+    program->addBranch(label, branchCondition);
+}
+
+void JIT::Backend::addCompareBranch(Register Rn, IR::Program::Label label, bool nonZero) {
+    if (program == nullptr) {
+        Base::printValidationError("addCompareBranch: labels need a program (beginProgram) - returning");
+        return;
+    }
+    program->addCompareBranch(Rn, label, nonZero);
+}
+
+void JIT::Backend::addLowOverheadBranch(IR::Program::Label loopStart, bool letp) {
+    if (program == nullptr) {
+        Base::printValidationError("addLowOverheadBranch: labels need a program (beginProgram) - returning");
+        return;
+    }
+    program->addLoopEnd(loopStart, letp);
+}
+
+void JIT::Backend::addLoopStart(Register Rn, IR::Program::Label loopExit, bool wlstp, Size size) {
+    if (program == nullptr) {
+        Base::printValidationError("addLoopStart: labels need a program (beginProgram) - returning");
+        return;
+    }
+    program->addLoopStart(Rn, loopExit, wlstp, size);
+}
+
+void JIT::Backend::addMoveImmediate(Register Rd, uint32_t imm) {
+    if (program != nullptr && imm > 0xffff) {
+        program->addLiteralLoad(Rd, imm);
+        return;
+    }
+    addInstruction(DataProcessing::movImmediate32(Rd, imm));
+    if (imm > 0xffff) addInstruction(DataProcessing::movtImmediate32(Rd, imm >> 16));
+}
+
+void JIT::Backend::addAddImmediate(Register Rd, Register Rn, uint32_t imm, Register temp, bool subtract) {
+    if (imm == 0 && Rd == Rn) return;
+    if (imm <= 4095) { // imm12 of ADDW/SUBW
+        if (subtract) addInstruction(Arithmetic::subImmediate32(Rd, Rn, imm));
+        else addInstruction(Arithmetic::addImmediate32(Rd, Rn, imm));
     } else {
-        Base::printValidationError("setForwardsBranch: can only set if placeholder nop is set - returning");
+        addMoveImmediate(temp, imm);
+        if (subtract) addInstruction(Arithmetic::subRegister32(Rd, Rn, temp));
+        else addInstruction(Arithmetic::addRegister32(Rd, Rn, temp));
     }
 }
 
-int16_t JIT::Backend::getBranchOffset(Instruction16 * instrStart) {
-    return (instrStart - &instructions[instructionCount]) * 2; // jede Instruktion sind 16 Bit = 2 Byte
-    //return &instructions[instructionCount] - instrStart;
+void JIT::Backend::addCompareImmediate(Register Rn, uint32_t imm, Register temp) {
+    if (imm < 255 || Base::canEncodeImmediateConstant(imm)) {
+        addInstruction(Base::cmpImmediate32(Rn, imm));
+    } else {
+        addMoveImmediate(temp, imm);
+        addInstruction(Base::cmpRegister32(Rn, temp));
+    }
 }
 
 void JIT::Backend::predicateNextInstructions(uint32_t countInstructions) {
@@ -139,10 +271,47 @@ uintptr_t JIT::Backend::getThumbAddress() const {
 void JIT::Backend::resetKernel() {
     // as no dynamic memory allocation is used, it is sufficient to just reset the instruction count/pointer
     instructionCount = 0;
+    blockStart = 0;
+    program = nullptr; // a program which was not ended is dropped
+    if (annotations != nullptr) annotations->reset();
 }
 
 void JIT::Backend::clearCaches() {
+    scheduleBlock();
+    clearCaches(instructions, instructionCount);
+}
+
+/*
+Cortex-M55 cache maintenance by address (see SCB_CleanDCache_by_Addr and SCB_InvalidateICache_by_Addr of CMSIS):
+the lines are cleaned to the point of coherency, afterwards the I-cache lines are invalidated.
+The ITCM and the DTCM are mapped to the first 16 MB at 0x0000'0000 and 0x2000'0000 and are never cached.
+*/
+constexpr uintptr_t ITCM_BASE = 0x0000'0000;
+constexpr uintptr_t DTCM_BASE = 0x2000'0000;
+constexpr uintptr_t TCM_WINDOW = 0x0100'0000;
+constexpr uintptr_t CACHE_LINE_SIZE = 32;
+constexpr uintptr_t SCB_ICIMVAU = 0xe000'ef58;
+constexpr uintptr_t SCB_DCCMVAC = 0xe000'ef68;
+
+void JIT::Backend::clearCaches(Instruction16 const * code, uint32_t halfwords) {
+    #if defined(__arm__)
+    uintptr_t const start = reinterpret_cast<uintptr_t>(code);
+    uintptr_t const end = start + halfwords * sizeof(Instruction16);
+    bool const tcm = (end <= ITCM_BASE + TCM_WINDOW) || (start >= DTCM_BASE && end <= DTCM_BASE + TCM_WINDOW);
     __asm("dsb");
+    if (!tcm) {
+        for (uintptr_t line = start & ~(CACHE_LINE_SIZE - 1); line < end; line += CACHE_LINE_SIZE) {
+            *reinterpret_cast<uint32_t volatile *>(SCB_DCCMVAC) = line;
+        }
+        __asm("dsb");
+        for (uintptr_t line = start & ~(CACHE_LINE_SIZE - 1); line < end; line += CACHE_LINE_SIZE) {
+            *reinterpret_cast<uint32_t volatile *>(SCB_ICIMVAU) = line;
+        }
+        __asm("dsb");
+    }
     __asm("isb");
-
+    #else
+    (void) code;
+    (void) halfwords;
+    #endif
 }
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include <cstdint>
 #include <cstring>
 #include "../instructions/Base.hpp"
+#include "Annotations.hpp"
+#include "IR.hpp"
 
 namespace JIT {
     class Backend;
@@ -35,14 +37,53 @@ class JIT::Backend {
         /// @param instruction 
         void addHeliumInstruction(Instructions::Instruction32 instruction);
         
+        /// @brief Adds an instruction which is the target of a branch, it starts a new basic block for the scheduler
         Instructions::Instruction16* addBranchTargetInstruction(Instructions::Instruction16 branchInstruction);
         Instructions::Instruction16* addBranchTargetInstruction(Instructions::Instruction32 branchInstruction);
-        Instructions::Instruction16* addBranchPlaceholder(bool shortBranch = false);
         void addLowOverheadBranchFromCurrentPosition(Instructions::Instruction16 * loopStart, bool letp = false);
         void addBackwardsBranchFromCurrentPosition(Instructions::Instruction16 * branchTarget, Instructions::Condition branchCondition);
-        void setForwardsBranch(Instructions::Instruction16 * branchInstruction, Instructions::Instruction16 * branchTarget, Instructions::Condition branchCondition);
+        /// @brief Starts a new basic block at the current position and returns it (for branches to the next instruction)
+        Instructions::Instruction16 * startBasicBlock();
         int16_t getBranchOffset(Instructions::Instruction16 * instrStart);
-        void insertWlsLabel(Instructions::Instruction16 wlsPosition, int16_t imm12);
+
+        /**
+         * @brief Emits the following instructions into program instead of the code buffer, until endProgram().
+         * Branches then use labels (newLabel, bindLabel, addBranch, addCompareBranch, addLowOverheadBranch, addLoopStart), the pointer
+         * based branch functions are not available as the final positions are only known after the passes.
+         * All branches are resolved in endProgram with the shortest encoding which reaches their label, forward branches included.
+         */
+        void beginProgram(IR::Program & program);
+        /// @brief Runs the default pipeline (with the schedule pass if scheduling is enabled) and encodes the program into the code buffer
+        void endProgram();
+        void endProgram(IR::Pipeline const & pipeline);
+        IR::Program::Label newLabel();
+        void bindLabel(IR::Program::Label label);
+        void addBranch(IR::Program::Label label, Instructions::Condition branchCondition = Instructions::AL);
+        /// @brief CBZ/CBNZ Rn to label, see IR::Program::addCompareBranch (the flags are overwritten if it needs CMP + Bcc)
+        void addCompareBranch(Instructions::Register Rn, IR::Program::Label label, bool nonZero = false);
+        void addLowOverheadBranch(IR::Program::Label loopStart, bool letp = false);
+        /// @brief WLS/WLSTP Rn which branches to loopExit (bound after the LE/LETP) if Rn is zero
+        void addLoopStart(Instructions::Register Rn, IR::Program::Label loopExit, bool wlstp = false, Instructions::Size size = Instructions::Size32);
+
+        /**
+         * @brief Moves a 32 bit constant into Rd: MOVW and, if the upper half is used, MOVT.
+         * Between beginProgram and endProgram the upper half costs a load from a literal pool instead (one instruction, 2-4 bytes + 4 bytes pool).
+         */
+        void addMoveImmediate(Instructions::Register Rd, uint32_t imm);
+        /// @brief Rd = Rn +/- imm. Constants which don't fit into ADDW/SUBW are moved into the temp register first
+        void addAddImmediate(Instructions::Register Rd, Instructions::Register Rn, uint32_t imm, Instructions::Register temp, bool subtract = false);
+        /// @brief Compares Rn with imm. Constants which can't be encoded are moved into the temp register first
+        void addCompareImmediate(Instructions::Register Rn, uint32_t imm, Instructions::Register temp);
+
+        /**
+         * @brief Records the annotations of the following kernels in table (nullptr to stop), they are reset with the kernel.
+         * The offsets are relative to getInstructions().
+         */
+        void setAnnotations(Annotations * table) {
+            annotations = table;
+        }
+        /// @brief Annotates the position of the next instruction with text (a string literal), nothing without a table
+        void annotate(char const * text);
 
         void predicateNextInstructions(uint32_t countInstructions);
         void insertPredicatedInstruction(Instructions::Instruction32 instr);
@@ -58,7 +99,23 @@ class JIT::Backend {
         uintptr_t getBufferThumbAddress(Instructions::Instruction16 * globalBuffer) const {
             return reinterpret_cast<uintptr_t>(globalBuffer) | 0x1U;
         }
+        /// @brief Schedules the last basic block and makes the kernel visible to the instruction fetch
         void clearCaches();
+        /**
+         * @brief Makes code which was written (or copied) by the CPU visible to the instruction fetch.
+         * Outside of the TCMs the D-cache lines of the code are cleaned and its I-cache lines invalidated, so kernels in SRAM0
+         * are correct with enabled caches. The TCMs are not cached, there only the barriers are needed.
+         */
+        static void clearCaches(Instructions::Instruction16 const * code, uint32_t halfwords);
+
+        /**
+         * @brief Reorders the movable instructions of each basic block for the M55 pipeline (see Scheduler).
+         * Blocks end at branch targets and the kernel is complete with clearCaches(). Off by default, as the
+         * micro benchmarks have to run exactly the emitted sequence.
+         */
+        void enableScheduling(bool enable = true) {
+            scheduling = enable;
+        }
 
     private:
         // Instructions::Instruction16 * instructionBuffer;
@@ -68,6 +125,14 @@ class JIT::Backend {
         uint16_t instructionCount = 0;
         int32_t predicateCounter = 0;
         int32_t maxPredicateInstructions = 0;
+        bool scheduling = false;
+        IR::Program * program = nullptr; // set between beginProgram and endProgram
+        Annotations * annotations = nullptr;
+        uint16_t blockStart = 0; // first halfword of the basic block which is not scheduled yet
+
+        void scheduleBlock();
+        bool inProgram(char const * message) const;
+        void annotateProgram(IR::Program const & kernel, uint16_t start);
 };
 
 #endif // BACKEND_HPP
\ No newline at end of file
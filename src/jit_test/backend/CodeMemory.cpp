@@ -0,0 +1,193 @@
+#include "CodeMemory.hpp"
+#include "Backend.hpp"
+#include <cstdint>
+#include <cstring>
+
+bool JIT::CodeMemory::addRegion(Region region, Instructions::Instruction16 * base, uint32_t size) {
+    if (reinterpret_cast<uintptr_t>(base) % 4 != 0) {
+        Instructions::Base::printValidationError("CodeMemory::addRegion: base has to be 4 byte aligned - returning false");
+        return false;
+    }
+    regions[region] = {base, size & ~1U};
+    return true;
+}
+
+// first fit over the gaps between the kernels of the region
+bool JIT::CodeMemory::findGap(Kernel const * table, Region region, uint32_t size, uint32_t & offset) const {
+    uint32_t candidate = 0;
+    while (candidate + size <= regions[region].size) {
+        bool overlaps = false;
+        for (Handle i = 0; i < MAX_KERNELS; i++) {
+            Kernel const & kernel = table[i];
+            if (kernel.used && kernel.region == region && kernel.offset < candidate + size && candidate < kernel.offset + kernel.size) {
+                candidate = kernel.offset + kernel.size; // continue searching behind the overlapping kernel
+                overlaps = true;
+                break;
+            }
+        }
+        if (!overlaps) {
+            offset = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+JIT::CodeMemory::Handle JIT::CodeMemory::add(Instructions::Instruction16 const * code, uint32_t size, Priority priority) {
+    if (kernelCount == MAX_KERNELS) {
+        Instructions::Base::printValidationError("CodeMemory::add: table is full - returning NONE");
+        return NONE;
+    }
+    uint32_t const paddedSize = (size + 1) & ~1U; // keep the following kernels word aligned
+    for (uint8_t i = 0; i < REGION_COUNT; i++) {
+        Region const region = static_cast<Region>(priority == HOT ? i : REGION_COUNT - 1 - i);
+        uint32_t offset;
+        if (!findGap(kernels, region, paddedSize, offset)) continue;
+
+        Handle handle = 0;
+        while (kernels[handle].used) handle++;
+        kernels[handle] = {offset, paddedSize, 0, region, priority, true};
+        kernelCount++;
+        Instructions::Instruction16 * target = regions[region].base + offset;
+        std::memcpy(target, code, size * sizeof(Instructions::Instruction16));
+        if (paddedSize != size) target[size] = Instructions::Base::nop16();
+        Backend::clearCaches(target, paddedSize);
+        return handle;
+    }
+    Instructions::Base::printValidationError("CodeMemory::add: no region has space for the kernel - returning NONE");
+    return NONE;
+}
+
+void JIT::CodeMemory::remove(Handle handle) {
+    if (handle >= MAX_KERNELS || !kernels[handle].used) return;
+    kernels[handle].used = false;
+    kernelCount--;
+}
+
+void JIT::CodeMemory::place(Handle handle, Region region, uint32_t offset) {
+    Kernel & kernel = kernels[handle];
+    Instructions::Instruction16 * target = regions[region].base + offset;
+    std::memcpy(target, regions[kernel.region].base + kernel.offset, kernel.size * sizeof(Instructions::Instruction16));
+    Backend::clearCaches(target, kernel.size);
+    kernel.region = region;
+    kernel.offset = offset;
+}
+
+bool JIT::CodeMemory::move(Handle handle, Region region) {
+    if (handle >= MAX_KERNELS || !kernels[handle].used) {
+        Instructions::Base::printValidationError("CodeMemory::move: invalid handle - returning false");
+        return false;
+    }
+    if (kernels[handle].region == region) return true;
+    uint32_t offset;
+    if (!findGap(kernels, region, kernels[handle].size, offset)) return false;
+    place(handle, region, offset);
+    return true;
+}
+
+bool JIT::CodeMemory::hotter(Handle a, Handle b) const {
+    if (kernels[a].calls != kernels[b].calls) return kernels[a].calls > kernels[b].calls;
+    return kernels[a].priority > kernels[b].priority;
+}
+
+// into the slowest region with a gap, only the entry of table is updated
+bool JIT::CodeMemory::planDemotion(Kernel * table, Handle handle) const {
+    for (uint8_t r = REGION_COUNT - 1; r > table[handle].region; r--) {
+        uint32_t offset;
+        if (findGap(table, static_cast<Region>(r), table[handle].size, offset)) {
+            table[handle].region = static_cast<Region>(r);
+            table[handle].offset = offset;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+Demotes kernels of the region which are colder than handle to make a gap for it. The moves are planned on a copy of the
+kernel table first and nothing is copied unless the whole plan works: the gap has to fit and every kernel in the way needs a
+gap in a slower region. The coldest kernels are removed from the plan until the gap fits, only those which overlap the gap
+are demoted.
+*/
+bool JIT::CodeMemory::promote(Handle handle, Region region) {
+    Kernel plan[MAX_KERNELS];
+    std::memcpy(plan, kernels, sizeof(plan));
+    uint32_t const size = kernels[handle].size;
+    uint32_t offset;
+    while (!findGap(plan, region, size, offset)) {
+        Handle coldest = NONE;
+        for (Handle i = 0; i < MAX_KERNELS; i++) {
+            if (!plan[i].used || plan[i].region != region || !hotter(handle, i)) continue;
+            if (coldest == NONE || hotter(coldest, i)) coldest = i;
+        }
+        if (coldest == NONE) return false;
+        plan[coldest].used = false;
+    }
+
+    // the handle keeps its current place in the plan, so no demoted kernel is copied over it
+    bool demoted[MAX_KERNELS] = {};
+    for (Handle i = 0; i < MAX_KERNELS; i++) {
+        if (!kernels[i].used || plan[i].used) continue;
+        plan[i].used = true;
+        demoted[i] = plan[i].offset < offset + size && offset < plan[i].offset + plan[i].size;
+        if (demoted[i] && !planDemotion(plan, i)) return false;
+    }
+
+    for (Handle i = 0; i < MAX_KERNELS; i++) {
+        if (demoted[i]) place(i, plan[i].region, plan[i].offset);
+    }
+    place(handle, region, offset);
+    return true;
+}
+
+uint32_t JIT::CodeMemory::rebalance() {
+    // hottest kernels first, so a kernel is never demoted for a colder one
+    Handle order[MAX_KERNELS];
+    uint32_t count = 0;
+    for (Handle i = 0; i < MAX_KERNELS; i++) {
+        if (!kernels[i].used) continue;
+        uint32_t position = count++;
+        while (position > 0 && hotter(i, order[position - 1])) {
+            order[position] = order[position - 1];
+            position--;
+        }
+        order[position] = i;
+    }
+
+    Region before[MAX_KERNELS];
+    for (Handle i = 0; i < MAX_KERNELS; i++) before[i] = kernels[i].region;
+    for (uint32_t i = 0; i < count; i++) {
+        Handle const handle = order[i];
+        for (uint8_t r = 0; r < kernels[handle].region; r++) {
+            if (regions[r].size != 0 && promote(handle, static_cast<Region>(r))) break;
+        }
+    }
+
+    uint32_t moves = 0;
+    for (Handle i = 0; i < MAX_KERNELS; i++) {
+        if (kernels[i].used && kernels[i].region != before[i]) moves++;
+        kernels[i].calls /= 2;
+    }
+    return moves;
+}
+
+uint32_t JIT::CodeMemory::getUsedSize(Region region) const {
+    uint32_t used = 0;
+    for (Kernel const & kernel : kernels) {
+        if (kernel.used && kernel.region == region) used += kernel.size;
+    }
+    return used;
+}
+
+char const * JIT::CodeMemory::regionName(Region region) {
+    switch (region) {
+        case ITCM:
+            return "ITCM";
+        case DTCM:
+            return "DTCM";
+        case SRAM0:
+            return "SRAM0";
+        default:
+            return "?";
+    }
+}
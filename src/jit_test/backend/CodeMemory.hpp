@@ -0,0 +1,117 @@
+#ifndef BACKEND_CODE_MEMORY_HPP
+#define BACKEND_CODE_MEMORY_HPP
+#pragma once
+#include <cstdint>
+#include "../instructions/Base.hpp"
+
+namespace JIT {
+    class CodeMemory;
+}
+
+/**
+ * @brief Owns the code regions (ITCM, DTCM, SRAM0) and places the generated kernels in them.
+ * Kernels are copied in from a staging buffer (the buffer of a generator) and placed first fit, hot kernels start in the
+ * fastest region, cold ones in the slowest. The calls are counted by get, rebalance then promotes the most called kernels
+ * into the faster regions and demotes colder kernels to make room for them.
+ *
+ * Kernels move, so they are called through their handle: a function pointer from get is only valid until the next
+ * rebalance or move. The kernels only use PC-relative branches and keep their 4 byte alignment, so they can be moved.
+ * No dynamic memory is used: at most MAX_KERNELS kernels are kept.
+ */
+class JIT::CodeMemory {
+    public:
+        static constexpr uint32_t MAX_KERNELS = 32;
+
+        using Handle = uint8_t;
+        static constexpr Handle NONE = 0xff;
+
+        // ordered by speed, zero wait states first
+        enum Region : uint8_t {
+            ITCM,
+            DTCM,
+            SRAM0,
+            REGION_COUNT
+        };
+
+        enum Priority : uint8_t {
+            COLD, // placed in the slowest region with space, promoted once it is called
+            HOT // placed in the fastest region with space
+        };
+
+        /**
+         * @brief Hands a region to the manager, a region which is not added is not used.
+         * Returns false if the base is not 4 byte aligned.
+         *
+         * @param size in halfwords
+         */
+        bool addRegion(Region region, Instructions::Instruction16 * base, uint32_t size);
+
+        /**
+         * @brief Copies a kernel of size halfwords (starting 4 byte aligned) into a region.
+         * Returns NONE if no region has space for it or the table is full.
+         */
+        Handle add(Instructions::Instruction16 const * code, uint32_t size, Priority priority = COLD);
+        void remove(Handle handle);
+
+        /// @brief Moves the kernel into the region, false if there is no gap for it
+        bool move(Handle handle, Region region);
+
+        /**
+         * @brief Promotes the most called kernels into the fastest regions, colder kernels are demoted to the slowest region
+         * with space to make room for them. Afterwards the call counts are halved, so the placement follows the recent calls.
+         * Returns the count of moved kernels.
+         */
+        uint32_t rebalance();
+
+        /// @brief Counts a call and returns the kernel as callable function
+        template <typename Func>
+        Func get(Handle handle) {
+            kernels[handle].calls++;
+            return reinterpret_cast<Func>(getThumbAddress(handle));
+        }
+        uintptr_t getThumbAddress(Handle handle) const {
+            return reinterpret_cast<uintptr_t>(regions[kernels[handle].region].base + kernels[handle].offset) | 0x1U;
+        }
+        Region getRegion(Handle handle) const {
+            return kernels[handle].region;
+        }
+        uint32_t getCalls(Handle handle) const {
+            return kernels[handle].calls;
+        }
+        /// @brief Halfwords of the region which are occupied by kernels
+        uint32_t getUsedSize(Region region) const;
+        uint32_t getKernelCount() const {
+            return kernelCount;
+        }
+
+        static char const * regionName(Region region);
+
+    private:
+        struct RegionInfo {
+            Instructions::Instruction16 * base;
+            uint32_t size; // in halfwords
+        };
+
+        struct Kernel {
+            uint32_t offset; // in halfwords from the start of the region
+            uint32_t size; // in halfwords, even
+            uint32_t calls;
+            Region region;
+            Priority priority;
+            bool used;
+        };
+
+        RegionInfo regions[REGION_COUNT] = {};
+        Kernel kernels[MAX_KERNELS] = {};
+        uint32_t kernelCount = 0;
+
+        /// @brief first fit between the used kernels of table (kernels or a planned copy of it)
+        bool findGap(Kernel const * table, Region region, uint32_t size, uint32_t & offset) const;
+        void place(Handle handle, Region region, uint32_t offset);
+        /// @brief a is called more often than b (or as often with a higher priority)
+        bool hotter(Handle a, Handle b) const;
+        bool promote(Handle handle, Region region);
+        bool planDemotion(Kernel * table, Handle handle) const;
+};
+
+#endif // BACKEND_CODE_MEMORY_HPP
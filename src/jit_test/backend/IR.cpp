@@ -0,0 +1,716 @@
+#include "IR.hpp"
+#include "Scheduler.hpp"
+#include "instructions/Arithmetic.hpp"
+#include "instructions/Base.hpp"
+#include "instructions/DataProcessing.hpp"
+#include "instructions/Vector.hpp"
+#include <cstdint>
+
+using namespace JIT::Instructions;
+using JIT::IR::Program;
+
+namespace {
+    constexpr int32_t B16_MIN = -2048;
+    constexpr int32_t B16_MAX = 2046;
+    constexpr int32_t BCOND16_MIN = -256;
+    constexpr int32_t BCOND16_MAX = 254;
+    constexpr int32_t CBZ_MAX = 126; // CBZ/CBNZ only branch forwards
+    constexpr int32_t LOOP_MAX_DISTANCE = 4094; // LE/LETP only branch backwards, WLS/WLSTP only forwards
+    constexpr int32_t LDR_LITERAL16_MAX = 1020;
+    constexpr int32_t LDR_LITERAL32_MAX = 4095;
+    /* literals of a pool, the loads are always in front of their pool */
+    constexpr uint8_t MAX_POOL_LITERALS = 32;
+    /* branch around the pool and the padding to a word address, in halfwords */
+    constexpr uint32_t POOL_OVERHEAD = 3;
+    /* bytes kept free for alignment padding, which moves when relaxBranches shrinks the code in front of it */
+    constexpr int32_t POOL_SLACK = 64;
+
+    bool fitsShortBranch(Condition condition, int32_t offset) {
+        if (condition == AL) return offset >= B16_MIN && offset <= B16_MAX;
+        return offset >= BCOND16_MIN && offset <= BCOND16_MAX;
+    }
+
+    Condition branchCondition(Program::Node const & node) {
+        if (node.opcode == Program::COMPARE_BRANCH) return (node.flags & Program::NON_ZERO) ? NE : EQ;
+        return static_cast<Condition>(node.encoding);
+    }
+
+    void write(Instruction16 * buffer, uint32_t & position, Instruction32 instr, uint8_t size) {
+        if (size == 2) buffer[position++] = static_cast<Instruction16>(instr >> 16);
+        if (size > 0) buffer[position++] = static_cast<Instruction16>(instr);
+    }
+
+    /* code behind the node is only reached through a label: B, POP/LDM with PC and BX */
+    bool endsFlow(Program::Node const & node) {
+        if (node.opcode == Program::BRANCH) return static_cast<Condition>(node.encoding) == AL;
+        if (node.opcode != Program::INSTRUCTION) return false;
+        if (node.size == 1) return (node.encoding & 0xff00) == 0xbd00 || (node.encoding & 0xff87) == 0x4700;
+        return (node.encoding & 0xffff'8000) == 0xe8bd'8000 || node.encoding == 0xf85d'fb04; // LDMIA SP!, {..., PC}, LDR PC, [SP], #4
+    }
+
+    /* inserts the pending literals at index, behind a branch around them if the code falls through, returns the inserted nodes */
+    uint16_t insertPool(Program & program, uint16_t index, uint16_t const * pending, uint8_t count, bool branchAround) {
+        uint16_t inserted = 0;
+        Program::Label skip = Program::NO_LABEL;
+        if (branchAround) {
+            skip = program.newLabel();
+            if (skip == Program::NO_LABEL || !program.insert(index + inserted, {AL, skip, Program::BRANCH, 2, 0})) return inserted;
+            inserted++;
+        }
+        for (uint8_t i = 0; i < count; i++) {
+            if (!program.insert(index + inserted, {program.getLiteral(pending[i]), pending[i], Program::LITERAL, 2, Program::ALIGNED})) return inserted;
+            inserted++;
+        }
+        if (branchAround && program.insert(index + inserted, {0, skip, Program::LABEL, 0, 0})) inserted++;
+        return inserted;
+    }
+
+    /* MOV Rd, Rd (no shift, no flags) */
+    bool isSelfMove(Instruction32 instr) {
+        return (instr & 0xFFFF'F0F0) == 0xEA4F'0000 && ((instr >> 8) & 0xf) == (instr & 0xf);
+    }
+
+    /* ADDW/SUBW Rd, Rn, #imm12 */
+    bool isAddImmediate(Instruction32 instr) {
+        return (instr & 0xFBF0'8000) == 0xF200'0000 || (instr & 0xFBF0'8000) == 0xF2A0'0000;
+    }
+
+    /* immediate of ADDW/SUBW, negative for SUBW */
+    int32_t addedValue(Instruction32 instr) {
+        int32_t const imm12 = ((instr >> 26 & 1) << 11) | ((instr >> 12 & 0x7) << 8) | (instr & 0xff);
+        return (instr & 0x00A0'0000) ? -imm12 : imm12;
+    }
+
+    /* ADDW/SUBW Rd, Rd, #imm12 */
+    bool isPointerUpdate(Instruction32 instr) {
+        return isAddImmediate(instr) && ((instr >> 8) & 0xf) == ((instr >> 16) & 0xf);
+    }
+
+    /* ADDW/SUBW Rd, Rd, #0 */
+    bool isZeroAdd(Instruction32 instr) {
+        return isPointerUpdate(instr) && addedValue(instr) == 0;
+    }
+
+    /* registers of a node for the peephole rewrites, BARRIER for everything but the movable instructions and literal loads */
+    JIT::Scheduler::Operation operation(Program::Node const & node) {
+        if (node.opcode == Program::LITERAL_LOAD) return {JIT::Scheduler::SCALAR_ALU, static_cast<uint16_t>(1 << (node.encoding & 0xf)), 0, 0, 0};
+        if (node.opcode != Program::INSTRUCTION || node.size != 2) return {JIT::Scheduler::BARRIER, 0, 0, 0, 0};
+        return JIT::Scheduler::decode(node.encoding);
+    }
+
+    /* first node after start which reads or writes reg, UINT16_MAX if a barrier comes first */
+    uint16_t nextAccess(Program & program, uint16_t start, uint8_t reg) {
+        Program::Node const * nodes = program.getNodes();
+        for (uint16_t j = start + 1; j < program.getNodeCount(); j++) {
+            if (nodes[j].opcode == Program::REMOVED || nodes[j].opcode == Program::ANNOTATION) continue;
+            JIT::Scheduler::Operation const op = operation(nodes[j]);
+            if (op.type == JIT::Scheduler::BARRIER) return UINT16_MAX;
+            if ((op.uses | op.defs) & (1 << reg)) return j;
+        }
+        return UINT16_MAX;
+    }
+
+    /*
+    Pointer update of the base of a VLDRW/VSTRW/LDR (immediate offset) folded into the access:
+    [Rn, #imm] + ADDW Rn, Rn, #imm becomes [Rn, #imm]! and [Rn] + ADDW Rn, Rn, #imm becomes [Rn], #imm. Returns 0 if not encodable.
+    */
+    Instruction32 foldUpdate(Instruction32 access, int32_t added) {
+        Register const Rn = static_cast<Register>((access >> 16) & 0xf);
+        if ((access & 0xFE70'1F80) == 0xEC10'1F00 || (access & 0xFE70'1F80) == 0xEC00'1F00) { // VLDRW/VSTRW [Rn, #imm]
+            if ((access >> 24 & 1) == 0 || (access >> 21 & 1) == 1) return 0;
+            int32_t const offset = (access >> 23 & 1) ? (access & 0x7f) << 2 : -((access & 0x7f) << 2);
+            if ((offset != added && offset != 0) || added < -508 || added > 508 || (added & 0x3) != 0) return 0;
+            VectorRegister const Qd = static_cast<VectorRegister>((access >> 13) & 0x7);
+            bool const preIndexed = offset != 0;
+            return (access >> 20 & 1) ? Vector::vldrw(Qd, Rn, added, preIndexed, true) : Vector::vstrw(Qd, Rn, added, preIndexed, true);
+        }
+        if ((access & 0xFFF0'0000) == 0xF8D0'0000) { // LDR (immediate, T3)
+            Register const Rt = static_cast<Register>((access >> 12) & 0xf);
+            int32_t const offset = access & 0xfff;
+            if (Rt == Rn || (offset != added && offset != 0) || added < -255 || added > 255) return 0;
+            return DataProcessing::ldrImmediate32(Rt, Rn, added, offset != 0, true);
+        }
+        return 0;
+    }
+
+    bool isLow(uint32_t reg) {
+        return reg < 8;
+    }
+
+    /* CMP (immediate/register), 16- and 32-bit */
+    bool isCompare(Program::Node const & node) {
+        if (node.opcode != Program::INSTRUCTION) return false;
+        if (node.size == 1) return (node.encoding & 0xF800) == 0x2800 || (node.encoding & 0xFFC0) == 0x4280 || (node.encoding & 0xFF00) == 0x4500;
+        return (node.encoding & 0xFBF0'8F00) == 0xF1B0'0F00 || (node.encoding & 0xFFF0'8F00) == 0xEBB0'0F00;
+    }
+
+    /* Bcc to a label, or an encoded Bcc/IT */
+    bool readsFlags(Program::Node const & node) {
+        if (node.opcode == Program::BRANCH) return static_cast<Condition>(node.encoding) != AL;
+        if (node.opcode != Program::INSTRUCTION) return false;
+        if (node.size == 1) return ((node.encoding & 0xF000) == 0xD000 && (node.encoding & 0x0E00) != 0x0E00) || ((node.encoding & 0xFF00) == 0xBF00 && (node.encoding & 0xf) != 0);
+        return (node.encoding & 0xF800'D000) == 0xF000'8000 && (node.encoding & 0x0380'0000) != 0x0380'0000;
+    }
+
+    /* neither reads nor writes the flags */
+    bool keepsFlags(Program::Node const & node) {
+        return node.opcode == Program::ANNOTATION || operation(node).type != JIT::Scheduler::BARRIER;
+    }
+
+    /*
+    True if every flag reader directly follows its CMP, with only instructions between them which keep the flags.
+    The flags are then dead at every other instruction, no matter how the program branches.
+    */
+    bool flagsFollowCompares(Program & program) {
+        Program::Node const * nodes = program.getNodes();
+        for (uint16_t i = 0; i < program.getNodeCount(); i++) {
+            if (!readsFlags(nodes[i])) continue;
+            uint16_t k = i;
+            while (k > 0 && keepsFlags(nodes[k - 1])) k--;
+            if (k == 0 || !isCompare(nodes[k - 1])) return false;
+        }
+        return true;
+    }
+
+    /*
+    16-bit encoding of a 32-bit instruction, 0 if there is none. LDR, MOV and ADD with Rd == Rn keep the flags,
+    the narrow ADDS/SUBS/MOVS encodings are only used if flagsDead.
+    */
+    Instruction16 narrowEncoding(Instruction32 instr, bool flagsDead) {
+        uint32_t const Rn = (instr >> 16) & 0xf;
+        uint32_t const Rd = (instr >> 8) & 0xf;
+        uint32_t const Rm = instr & 0xf;
+        if ((instr & 0xFFF0'0000) == 0xF8D0'0000) { // LDR (immediate, T3)
+            uint32_t const Rt = (instr >> 12) & 0xf;
+            uint32_t const imm12 = instr & 0xfff;
+            if (!isLow(Rt) || !isLow(Rn) || imm12 > 124 || (imm12 & 0x3) != 0) return 0;
+            return DataProcessing::ldrImmediate16(static_cast<Register>(Rt), static_cast<Register>(Rn), imm12);
+        }
+        bool const special = Rd >= SP || Rn >= SP || Rm >= SP;
+        if ((instr & 0xFFFF'F0F0) == 0xEA4F'0000) { // MOV (register) without shift and flags
+            if (Rd >= SP || Rm >= SP) return 0;
+            return DataProcessing::movRegister16(static_cast<Register>(Rd), static_cast<Register>(Rm));
+        }
+        if ((instr & 0xFFF0'F0F0) == 0xEB00'0000 && !special) { // ADD (register) without shift and flags
+            if (Rd == Rn) return Arithmetic::addRegister16(static_cast<Register>(Rd), static_cast<Register>(Rm));
+            if (Rd == Rm) return Arithmetic::addRegister16(static_cast<Register>(Rd), static_cast<Register>(Rn));
+            if (!flagsDead || !isLow(Rd) || !isLow(Rn) || !isLow(Rm)) return 0;
+            return Arithmetic::addRegister16(static_cast<Register>(Rd), static_cast<Register>(Rn), static_cast<Register>(Rm));
+        }
+        if (!flagsDead) return 0;
+        if ((instr & 0xFFF0'F0F0) == 0xEBA0'0000 && isLow(Rd) && isLow(Rn) && isLow(Rm)) { // SUB (register) without shift and flags
+            return Arithmetic::subRegister16(static_cast<Register>(Rd), static_cast<Register>(Rn), static_cast<Register>(Rm));
+        }
+        if (isAddImmediate(instr) && isLow(Rd) && isLow(Rn)) {
+            int32_t const added = addedValue(instr);
+            int32_t const magnitude = added < 0 ? -added : added;
+            uint8_t const imm = static_cast<uint8_t>(magnitude);
+            if (Rd == Rn && magnitude <= 255) {
+                return added < 0 ? Arithmetic::subImmediate16(static_cast<Register>(Rd), imm) : Arithmetic::addImmediate16(static_cast<Register>(Rd), imm);
+            }
+            if (magnitude <= 7) {
+                return added < 0 ? Arithmetic::subImmediate16(static_cast<Register>(Rd), static_cast<Register>(Rn), imm)
+                                 : Arithmetic::addImmediate16(static_cast<Register>(Rd), static_cast<Register>(Rn), imm);
+            }
+            return 0;
+        }
+        if ((instr & 0xFBF0'8000) == 0xF240'0000 && isLow(Rd)) { // MOVW
+            uint32_t const imm16 = ((instr >> 16 & 0xf) << 12) | ((instr >> 26 & 1) << 11) | ((instr >> 12 & 0x7) << 8) | (instr & 0xff);
+            if (imm16 <= 255) return DataProcessing::movImmediate16(static_cast<Register>(Rd), imm16);
+        }
+        return 0;
+    }
+
+    /* reorders a run of movable nodes (at indices, annotations in between stay in place) in the order of the scheduler */
+    void scheduleRun(Program::Node * nodes, uint16_t const * indices, Instruction32 const * run, uint8_t count) {
+        if (count < 2) return;
+        uint8_t order[JIT::Scheduler::MAX_WINDOW];
+        JIT::Scheduler::order(run, count, order);
+        Program::Node copies[JIT::Scheduler::MAX_WINDOW];
+        for (uint8_t i = 0; i < count; i++) copies[i] = nodes[indices[i]];
+        for (uint8_t slot = 0; slot < count; slot++) nodes[indices[slot]] = copies[order[slot]];
+    }
+}
+
+Program::Program(Arena & arena, uint16_t maxNodes, uint16_t maxLabels, uint16_t maxLiterals) {
+    nodes = arena.allocate<Node>(maxNodes);
+    offsets = arena.allocate<uint16_t>(maxNodes);
+    labelOffsets = arena.allocate<uint16_t>(maxLabels);
+    literals = arena.allocate<uint32_t>(maxLiterals);
+    bool const valid = nodes != nullptr && offsets != nullptr && labelOffsets != nullptr && literals != nullptr;
+    this->maxNodes = valid ? maxNodes : 0;
+    this->maxLabels = valid ? maxLabels : 0;
+    this->maxLiterals = valid ? maxLiterals : 0;
+}
+
+void Program::add(Node const & node) {
+    if (nodeCount == maxNodes) {
+        Base::printValidationError("Program::add: node capacity exceeded - dropping instruction");
+        overflowed = true;
+        return;
+    }
+    nodes[nodeCount++] = node;
+}
+
+void Program::addInstruction(Instruction16 instruction) {
+    add({instruction, NO_LABEL, INSTRUCTION, 1, 0});
+}
+
+void Program::addInstruction(Instruction32 instruction, bool aligned) {
+    add({instruction, NO_LABEL, INSTRUCTION, 2, static_cast<uint8_t>(aligned ? ALIGNED : 0)});
+}
+
+Program::Label Program::newLabel() {
+    if (labelCount == maxLabels) {
+        Base::printValidationError("Program::newLabel: label capacity exceeded - returning NO_LABEL");
+        overflowed = true;
+        return NO_LABEL;
+    }
+    labelOffsets[labelCount] = UNBOUND;
+    return labelCount++;
+}
+
+void Program::bindLabel(Label label) {
+    if (label >= labelCount) {
+        Base::printValidationError("Program::bindLabel: unknown label - returning");
+        return;
+    }
+    add({0, label, LABEL, 0, 0});
+}
+
+void Program::addBranch(Label label, Condition condition) {
+    add({condition, label, BRANCH, 2, 0});
+}
+
+void Program::addCompareBranch(Register Rn, Label label, bool nonZero) {
+    Node node = {Rn, label, COMPARE_BRANCH, 0, static_cast<uint8_t>(nonZero ? NON_ZERO : 0)};
+    node.size = getCompareSize(node) + 2;
+    add(node);
+}
+
+void Program::addLoopEnd(Label label, bool tailPredicated) {
+    add({0, label, LOOP_END, 2, static_cast<uint8_t>(tailPredicated ? TAIL_PREDICATED : 0)});
+}
+
+void Program::addLiteralLoad(Register Rt, uint32_t value) {
+    uint16_t index = 0;
+    while (index < literalCount && literals[index] != value) index++;
+    if (index == maxLiterals) {
+        addInstruction(DataProcessing::movImmediate32(Rt, value));
+        if (value > 0xffff) addInstruction(DataProcessing::movtImmediate32(Rt, value >> 16));
+        return;
+    }
+    if (index == literalCount) literals[literalCount++] = value;
+    add({Rt, index, LITERAL_LOAD, 2, 0});
+}
+
+bool Program::insert(uint16_t index, Node const & node) {
+    if (nodeCount == maxNodes) {
+        Base::printValidationError("Program::insert: node capacity exceeded - returning false");
+        return false;
+    }
+    for (uint16_t i = nodeCount; i > index; i--) nodes[i] = nodes[i - 1];
+    nodes[index] = node;
+    nodeCount++;
+    return true;
+}
+
+void Program::addAnnotation(uint16_t index) {
+    add({0, index, ANNOTATION, 0, 0});
+}
+
+void Program::addLoopStart(Register Rn, Label label, bool tailPredicated, Size size) {
+    add({static_cast<Instruction32>(Rn | size << 4), label, LOOP_START, 2, static_cast<uint8_t>(tailPredicated ? TAIL_PREDICATED : 0)});
+}
+
+void Program::compact() {
+    uint16_t kept = 0;
+    for (uint16_t i = 0; i < nodeCount; i++) {
+        if (nodes[i].opcode != REMOVED) nodes[kept++] = nodes[i];
+    }
+    nodeCount = kept;
+}
+
+/*
+ALIGNED nodes are padded to a word address, except inside a VPT block where the padding NOP would be predicated.
+*/
+uint32_t Program::layout() {
+    uint32_t const baseParity = (baseAddress >> 1) & 1U;
+    uint32_t position = 0;
+    uint8_t predicated = 0;
+    for (uint16_t i = 0; i < nodeCount; i++) {
+        Node const & node = nodes[i];
+        if ((node.flags & ALIGNED) && predicated == 0 && ((position + baseParity) & 1U)) position++;
+        offsets[i] = static_cast<uint16_t>(position);
+        if (node.opcode == LABEL) labelOffsets[node.label] = static_cast<uint16_t>(position);
+        if (node.opcode == INSTRUCTION) {
+            if (predicated > 0) predicated--;
+            else if (node.size == 2) predicated = Scheduler::predicatedInstructions(node.encoding);
+        }
+        position += node.size;
+    }
+    return position;
+}
+
+int32_t Program::getBranchOffset(uint16_t node) const {
+    return (static_cast<int32_t>(labelOffsets[nodes[node].label]) - offsets[node]) * 2 - 4;
+}
+
+int32_t Program::getLiteralOffset(uint16_t node) const {
+    for (uint16_t i = node + 1; i < nodeCount; i++) {
+        if (nodes[i].opcode != LITERAL || nodes[i].label != nodes[node].label) continue;
+        uintptr_t const pc = (baseAddress + offsets[node] * 2 + 4) & ~static_cast<uintptr_t>(3);
+        return static_cast<int32_t>(baseAddress + offsets[i] * 2 - pc);
+    }
+    return INT32_MAX;
+}
+
+uint32_t Program::encode(Instruction16 * buffer, uint32_t capacity) {
+    if (overflowed) {
+        Base::printValidationError("Program::encode: nodes or labels were dropped - returning 0");
+        return 0;
+    }
+    uint32_t const size = layout();
+    if (size > capacity) {
+        Base::printValidationError("Program::encode: kernel does not fit into the buffer - returning 0");
+        return 0;
+    }
+    uint32_t position = 0;
+    for (uint16_t i = 0; i < nodeCount; i++) {
+        Node const & node = nodes[i];
+        while (position < offsets[i]) buffer[position++] = Base::nop16();
+
+        if (node.opcode == INSTRUCTION || node.opcode == LABEL || node.opcode == ANNOTATION) {
+            write(buffer, position, node.encoding, node.size);
+            continue;
+        }
+        if (node.opcode == LITERAL) { // data, the lower half is at the lower address
+            buffer[position++] = static_cast<Instruction16>(node.encoding);
+            buffer[position++] = static_cast<Instruction16>(node.encoding >> 16);
+            continue;
+        }
+        if (node.opcode == LITERAL_LOAD) {
+            int32_t const offset = getLiteralOffset(i);
+            Register const Rt = static_cast<Register>(node.encoding & 0xf);
+            bool const inRange = node.size == 1
+                ? offset >= 0 && offset <= LDR_LITERAL16_MAX && Base::assertLowRegister(Rt)
+                : offset >= -LDR_LITERAL32_MAX && offset <= LDR_LITERAL32_MAX;
+            if (!inRange) {
+                Base::printValidationError("Program::encode: literal out of range (missing placeLiteralPools?) - returning 0");
+                return 0;
+            }
+            if (node.size == 1) write(buffer, position, DataProcessing::ldrLiteral16(Rt, offset), 1);
+            else write(buffer, position, DataProcessing::ldrLiteral32(Rt, offset), 2);
+            continue;
+        }
+        if (node.label >= labelCount || labelOffsets[node.label] == UNBOUND) {
+            Base::printValidationError("Program::encode: branch to an unbound label - returning 0");
+            return 0;
+        }
+        int32_t offset = getBranchOffset(i);
+        Register const Rn = static_cast<Register>(node.encoding & 0xf);
+        if (node.opcode == LOOP_END) {
+            if (offset > 0 || offset < -LOOP_MAX_DISTANCE) {
+                Base::printValidationError("Program::encode: LE/LETP target out of range - returning 0");
+                return 0;
+            }
+            write(buffer, position, (node.flags & TAIL_PREDICATED) ? Base::letp(offset) : Base::le(offset), 2);
+            continue;
+        }
+        if (node.opcode == LOOP_START) {
+            if (offset < 0 || offset > LOOP_MAX_DISTANCE) {
+                Base::printValidationError("Program::encode: WLS/WLSTP target out of range - returning 0");
+                return 0;
+            }
+            Instruction32 const instr = (node.flags & TAIL_PREDICATED)
+                ? Base::wlstp(Rn, static_cast<Size>((node.encoding >> 4) & 0x3), offset)
+                : Base::wls(Rn, offset);
+            write(buffer, position, instr, 2);
+            continue;
+        }
+
+        uint8_t branchSize = node.size;
+        if (node.opcode == COMPARE_BRANCH) {
+            if (node.size == 1) {
+                if (offset < 0 || offset > CBZ_MAX || !Base::assertLowRegister(Rn)) {
+                    Base::printValidationError("Program::encode: CBZ/CBNZ out of range (missing relaxBranches?) - returning 0");
+                    return 0;
+                }
+                write(buffer, position, (node.flags & NON_ZERO) ? Base::cbnz(Rn, offset) : Base::cbz(Rn, offset), 1);
+                continue;
+            }
+            uint8_t const compareSize = getCompareSize(node);
+            write(buffer, position, compareSize == 1 ? Base::cmpImmediate16(Rn, 0) : Base::cmpImmediate32(Rn, 0), compareSize);
+            offset -= compareSize * 2;
+            branchSize -= compareSize;
+        }
+        Condition const condition = branchCondition(node);
+        if (branchSize == 1) {
+            if (!fitsShortBranch(condition, offset)) {
+                Base::printValidationError("Program::encode: 16-bit branch out of range (missing relaxBranches?) - returning 0");
+                return 0;
+            }
+            write(buffer, position, Base::bCond16(condition, offset), 1);
+        } else {
+            write(buffer, position, Base::bCond32(condition, offset), 2);
+        }
+    }
+    return position;
+}
+
+void Program::reset() {
+    nodeCount = 0;
+    labelCount = 0;
+    literalCount = 0;
+    overflowed = false;
+}
+
+/*
+The rewrites only look at the movable instructions (see Scheduler::decode) up to the next barrier, label or branch,
+so a register which is not accessed in between has the same value on every path.
+*/
+void JIT::IR::Passes::peephole(Program & program) {
+    Program::Node * nodes = program.getNodes();
+    for (uint16_t i = 0; i < program.getNodeCount(); i++) {
+        Program::Node & node = nodes[i];
+        if (node.opcode != Program::INSTRUCTION) continue;
+        bool const noEffect = node.size == 1
+            ? node.encoding == Base::nop16()
+            : node.encoding == Base::nop32() || isSelfMove(node.encoding) || isZeroAdd(node.encoding);
+        if (noEffect) node.opcode = Program::REMOVED;
+    }
+
+    uint8_t predicated = 0;
+    for (uint16_t i = 0; i < program.getNodeCount(); i++) {
+        Program::Node & node = nodes[i];
+        if (node.opcode == Program::INSTRUCTION) {
+            bool const inBlock = predicated > 0;
+            if (predicated > 0) predicated--;
+            else if (node.size == 2) predicated = Scheduler::predicatedInstructions(node.encoding);
+            if (inBlock) continue;
+        }
+        Scheduler::Operation const op = operation(node);
+        if (op.type == Scheduler::BARRIER) continue;
+
+        // ADDW/SUBW Rn, Rn, #imm behind a load or store from Rn is folded into its addressing mode
+        uint8_t const base = (node.encoding >> 16) & 0xf;
+        if (op.type == Scheduler::SCALAR_LOAD || op.type == Scheduler::VECTOR_LOAD || op.type == Scheduler::VECTOR_STORE) {
+            uint16_t const j = nextAccess(program, i, base);
+            if (j != UINT16_MAX && isPointerUpdate(nodes[j].encoding) && ((nodes[j].encoding >> 8) & 0xf) == base) {
+                Instruction32 const folded = foldUpdate(node.encoding, addedValue(nodes[j].encoding));
+                if (folded != 0) {
+                    node.encoding = folded;
+                    nodes[j].opcode = Program::REMOVED;
+                }
+            }
+            continue;
+        }
+        if (op.type != Scheduler::SCALAR_ALU) continue;
+
+        // a result which is overwritten before it is read is dropped, consecutive updates of a pointer (rewinds) are merged
+        uint8_t defined = 0;
+        while ((op.defs >> defined) != 1) defined++;
+        uint16_t const j = nextAccess(program, i, defined);
+        if (j == UINT16_MAX) continue;
+        Scheduler::Operation const next = operation(nodes[j]);
+        if ((next.uses & (1 << defined)) == 0) {
+            node.opcode = Program::REMOVED;
+        } else if (node.opcode == Program::INSTRUCTION && isPointerUpdate(node.encoding) && nodes[j].opcode == Program::INSTRUCTION
+                   && isPointerUpdate(nodes[j].encoding) && ((nodes[j].encoding >> 8) & 0xf) == defined) {
+            int32_t const added = addedValue(node.encoding) + addedValue(nodes[j].encoding);
+            if (added < -4095 || added > 4095) continue;
+            Register const Rd = static_cast<Register>(defined);
+            nodes[j].encoding = added < 0 ? Arithmetic::subImmediate32(Rd, Rd, -added) : Arithmetic::addImmediate32(Rd, Rd, added);
+            if (added == 0) nodes[j].opcode = Program::REMOVED;
+            node.opcode = Program::REMOVED;
+        }
+    }
+    program.compact();
+}
+
+/*
+Walks backwards, so the flags are known to be dead if no reader comes before the next instruction which might write them.
+Only the movable scalar instructions are narrowed, they are never part of a VPT block.
+*/
+void JIT::IR::Passes::narrow(Program & program) {
+    Program::Node * nodes = program.getNodes();
+    bool const flagsTracked = flagsFollowCompares(program);
+    bool flagsLive = false; // the kernel returns at the end
+    for (uint16_t i = program.getNodeCount(); i-- > 0;) {
+        Program::Node & node = nodes[i];
+        bool const reads = readsFlags(node);
+        bool const keeps = keepsFlags(node);
+        if (keeps && node.opcode == Program::INSTRUCTION) {
+            Instruction16 const narrowed = narrowEncoding(node.encoding, flagsTracked && !flagsLive);
+            if (narrowed != 0) {
+                node.encoding = narrowed;
+                node.size = 1;
+            }
+        }
+        if (reads) flagsLive = true;
+        else if (!keeps) flagsLive = false;
+    }
+}
+
+/*
+Runs of movable 32-bit instructions end at labels, branches, barriers and VPT blocks (same rules as Scheduler::schedule).
+Annotations don't end a run, so the schedule is the same with and without them.
+*/
+void JIT::IR::Passes::schedule(Program & program) {
+    Program::Node * nodes = program.getNodes();
+    Instruction32 run[Scheduler::MAX_WINDOW];
+    uint16_t indices[Scheduler::MAX_WINDOW];
+    uint8_t runLength = 0;
+    uint8_t predicated = 0;
+    for (uint16_t i = 0; i < program.getNodeCount(); i++) {
+        Program::Node const & node = nodes[i];
+        if (node.opcode == Program::ANNOTATION) continue;
+        bool movable = false;
+        if (node.opcode == Program::INSTRUCTION && node.size == 2) {
+            movable = predicated == 0 && Scheduler::decode(node.encoding).type != Scheduler::BARRIER;
+            if (predicated > 0) predicated--;
+            else predicated = Scheduler::predicatedInstructions(node.encoding);
+        } else if (node.opcode == Program::INSTRUCTION && predicated > 0) {
+            predicated--;
+        }
+
+        if (movable) {
+            indices[runLength] = i;
+            run[runLength++] = node.encoding;
+        }
+        if ((!movable || runLength == Scheduler::MAX_WINDOW) && runLength > 0) {
+            scheduleRun(nodes, indices, run, runLength);
+            runLength = 0;
+        }
+    }
+    scheduleRun(nodes, indices, run, runLength);
+}
+
+void JIT::IR::Passes::alignLoops(Program & program) {
+    Program::Node * nodes = program.getNodes();
+    for (uint16_t i = 0; i < program.getNodeCount(); i++) {
+        if (nodes[i].opcode != Program::LOOP_END) continue;
+        for (uint16_t j = i; j-- > 0;) {
+            if (nodes[j].opcode == Program::LABEL && nodes[j].label == nodes[i].label) {
+                nodes[j].flags |= Program::ALIGNED;
+                break;
+            }
+        }
+    }
+}
+
+/*
+Every load reads from the first pool behind it, a pool holds the literals of the loads since the previous pool.
+Pools are placed behind instructions which don't fall through. If a pending literal would get out of reach of its load
+(or the pool is full), the pool is placed in front of the current node with a branch around it.
+The literals left at the end are placed behind the last instruction, so a program with literals must not fall through at its end.
+The loads are 32-bit and the branches at most as long as after relaxBranches, so the distances only shrink afterwards.
+*/
+void JIT::IR::Passes::placeLiteralPools(Program & program) {
+    Program::Node * nodes = program.getNodes();
+    uint16_t pending[MAX_POOL_LITERALS];
+    uint8_t pendingCount = 0;
+    uint32_t firstLoad = 0;
+    uint8_t predicated = 0;
+    program.layout();
+    for (uint16_t i = 0; i < program.getNodeCount(); i++) {
+        if (pendingCount > 0 && predicated == 0) {
+            uint32_t const poolEnd = program.getOffset(i) + nodes[i].size + POOL_OVERHEAD + 2 * (pendingCount + 1);
+            if (static_cast<int32_t>(poolEnd - firstLoad) * 2 > LDR_LITERAL32_MAX - POOL_SLACK || pendingCount == MAX_POOL_LITERALS) {
+                i += insertPool(program, i, pending, pendingCount, true);
+                pendingCount = 0;
+                program.layout();
+            }
+        }
+
+        Program::Node const & node = nodes[i];
+        if (node.opcode == Program::INSTRUCTION) {
+            if (predicated > 0) predicated--;
+            else if (node.size == 2) predicated = Scheduler::predicatedInstructions(node.encoding);
+        }
+        if (node.opcode == Program::LITERAL_LOAD) {
+            if (pendingCount == 0) firstLoad = program.getOffset(i);
+            uint8_t known = 0;
+            while (known < pendingCount && pending[known] != node.label) known++;
+            if (known == pendingCount) pending[pendingCount++] = node.label;
+        }
+        if (pendingCount > 0 && predicated == 0 && endsFlow(node)) {
+            i += insertPool(program, i + 1, pending, pendingCount, false);
+            pendingCount = 0;
+            program.layout();
+        }
+    }
+    if (pendingCount > 0) insertPool(program, program.getNodeCount(), pending, pendingCount, false);
+}
+
+/*
+Starts with the shortest encodings and widens the branches which don't reach their label until the layout is stable.
+Branches only grow, so this terminates after at most two rounds per branch.
+B/Bcc: 16-bit, 32-bit. CBZ/CBNZ: CBZ (low registers), CMP + 16-bit Bcc, CMP + 32-bit Bcc. LDR (literal): 16-bit (low registers), 32-bit.
+*/
+void JIT::IR::Passes::relaxBranches(Program & program) {
+    Program::Node * nodes = program.getNodes();
+    for (uint16_t i = 0; i < program.getNodeCount(); i++) {
+        Program::Node & node = nodes[i];
+        if (node.opcode == Program::BRANCH) node.size = 1;
+        if (node.opcode == Program::COMPARE_BRANCH) node.size = Program::getCompareSize(node) == 1 ? 1 : 3;
+        if (node.opcode == Program::LITERAL_LOAD) node.size = Base::assertLowRegister(node.encoding & 0xf) ? 1 : 2;
+    }
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        program.layout();
+        for (uint16_t i = 0; i < program.getNodeCount(); i++) {
+            Program::Node & node = nodes[i];
+            if (node.opcode == Program::LITERAL_LOAD && node.size == 1) {
+                int32_t const offset = program.getLiteralOffset(i);
+                if (offset >= 0 && offset <= LDR_LITERAL16_MAX) continue;
+                node.size = 2;
+                changed = true;
+                continue;
+            }
+            if (node.opcode != Program::BRANCH && node.opcode != Program::COMPARE_BRANCH) continue;
+            int32_t offset = program.getBranchOffset(i);
+            if (node.opcode == Program::COMPARE_BRANCH) {
+                uint8_t const compareSize = Program::getCompareSize(node);
+                if (node.size == 1) {
+                    if (offset >= 0 && offset <= CBZ_MAX) continue;
+                    node.size = 2; // CMP + 16-bit Bcc
+                    changed = true;
+                    continue;
+                }
+                if (node.size == compareSize + 2) continue;
+                offset -= compareSize * 2;
+            } else if (node.size == 2) {
+                continue;
+            }
+            if (!fitsShortBranch(branchCondition(node), offset)) {
+                node.size++;
+                changed = true;
+            }
+        }
+    }
+}
+
+JIT::IR::Pipeline JIT::IR::Pipeline::defaultPipeline(bool scheduling) {
+    Pipeline pipeline;
+    pipeline.addPass(Passes::peephole);
+    if (scheduling) pipeline.addPass(Passes::schedule);
+    pipeline.addPass(Passes::narrow);
+    pipeline.addPass(Passes::alignLoops);
+    pipeline.addPass(Passes::placeLiteralPools);
+    pipeline.addPass(Passes::relaxBranches);
+    return pipeline;
+}
+
+void JIT::IR::Pipeline::addPass(Pass pass) {
+    if (passCount == MAX_PASSES) {
+        Base::printValidationError("Pipeline::addPass: too many passes - returning");
+        return;
+    }
+    passes[passCount++] = pass;
+}
+
+void JIT::IR::Pipeline::run(Program & program) const {
+    for (uint8_t i = 0; i < passCount; i++) passes[i](program);
+}
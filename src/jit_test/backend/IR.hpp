@@ -0,0 +1,239 @@
+#ifndef BACKEND_IR_HPP
+#define BACKEND_IR_HPP
+#pragma once
+#include <cstdint>
+#include "../instructions/Base.hpp"
+
+namespace JIT {
+    namespace IR {
+        class Arena;
+        class Program;
+        class Passes;
+        class Pipeline;
+    }
+}
+
+/**
+ * @brief Bump allocator over a caller provided buffer. Nothing is freed individually, reset() releases everything at once,
+ * so a generator can size the arena for its largest kernel and reuse it for every kernel.
+ */
+class JIT::IR::Arena {
+    public:
+        Arena(void * memory, uint32_t bytes) : memory(static_cast<uint8_t *>(memory)), size(bytes) {}
+
+        /// @brief Returns storage for count objects of T, nullptr if the arena is exhausted
+        template<typename T>
+        T * allocate(uint32_t count) {
+            uint32_t const start = (used + alignof(T) - 1) & ~static_cast<uint32_t>(alignof(T) - 1);
+            if (start + count * sizeof(T) > size) {
+                Instructions::Base::printValidationError("Arena::allocate: arena exhausted - returning nullptr");
+                return nullptr;
+            }
+            used = start + count * sizeof(T);
+            return reinterpret_cast<T *>(memory + start);
+        }
+
+        void reset() {
+            used = 0;
+        }
+        uint32_t getUsed() const {
+            return used;
+        }
+
+    private:
+        uint8_t * memory;
+        uint32_t size;
+        uint32_t used = 0;
+};
+
+/**
+ * @brief Instruction list of a kernel before it is written to the code buffer.
+ *
+ * Instructions are still encoded by the instruction classes (instruction selection), the list adds what the encoded
+ * halfwords can't express: labels, branches which reference them, the size class of each instruction and alignment requests.
+ * The passes (see Passes) rewrite the list, encode() resolves the labels and writes the halfwords.
+ */
+class JIT::IR::Program {
+    public:
+        using Label = uint16_t;
+        static constexpr Label NO_LABEL = UINT16_MAX;
+
+        enum Opcode : uint8_t {
+            INSTRUCTION = 0, // encoded 16- or 32-bit instruction
+            LABEL, // position of a label, no code
+            BRANCH, // B/Bcc to a label, 16- or 32-bit
+            COMPARE_BRANCH, // CBZ/CBNZ forward to a label, CMP + Bcc if the label is out of reach
+            LOOP_END, // LE/LETP back to a label
+            LOOP_START, // WLS/WLSTP forward to the label after the loop
+            LITERAL_LOAD, // LDR (literal) from the next pool
+            LITERAL, // word of a literal pool
+            ANNOTATION, // note of the generator at this position (index in label), no code
+            REMOVED, // dropped by the next compact()
+        };
+
+        enum Flags : uint8_t {
+            ALIGNED = 1 << 0, // starts at a word address (padded with a 16-bit nop)
+            TAIL_PREDICATED = 1 << 1, // LOOP_END, LOOP_START: LETP/WLSTP instead of LE/WLS
+            NON_ZERO = 1 << 2, // COMPARE_BRANCH: CBNZ instead of CBZ
+        };
+
+        /*
+        8 bytes per node, a program holds one node per emitted instruction. Branches keep their operands in encoding:
+        BRANCH the condition, COMPARE_BRANCH the register, LOOP_START the register and (WLSTP) the element size in bits 4-5.
+        LITERAL_LOAD keeps the target register in encoding, LITERAL the value, both refer to the literal by its index in label.
+        */
+        struct Node {
+            Instructions::Instruction32 encoding; // INSTRUCTION: the halfwords, 16-bit instructions in the lower half
+            Label label; // branches: target, LABEL: the label, LITERAL_LOAD/LITERAL: index of the literal, ANNOTATION: its index
+            Opcode opcode;
+            uint8_t size : 3; // halfwords, 0 for labels, up to 4 for an expanded COMPARE_BRANCH
+            uint8_t flags : 5;
+        };
+
+        /// @brief Arena bytes needed for a program with the given capacities
+        static constexpr uint32_t storageSize(uint16_t maxNodes, uint16_t maxLabels, uint16_t maxLiterals = 0) {
+            return maxNodes * (sizeof(Node) + sizeof(uint16_t)) + maxLabels * sizeof(uint16_t) + maxLiterals * sizeof(uint32_t) + 3 * alignof(Node);
+        }
+        /// @brief Nodes which fit into an arena of bytes next to the labels and literals, the inverse of storageSize
+        static constexpr uint16_t nodeCapacity(uint32_t bytes, uint16_t maxLabels, uint16_t maxLiterals = 0) {
+            uint32_t const fixed = storageSize(0, maxLabels, maxLiterals);
+            if (bytes <= fixed) return 0;
+            uint32_t const nodes = (bytes - fixed) / (sizeof(Node) + sizeof(uint16_t));
+            return nodes > UINT16_MAX ? UINT16_MAX : static_cast<uint16_t>(nodes);
+        }
+
+        Program(Arena & arena, uint16_t maxNodes, uint16_t maxLabels, uint16_t maxLiterals = 0);
+
+        void addInstruction(Instructions::Instruction16 instruction);
+        void addInstruction(Instructions::Instruction32 instruction, bool aligned = false);
+        Label newLabel();
+        /// @brief Places the label before the next instruction
+        void bindLabel(Label label);
+        /// @brief Branch to label, the size is chosen by Passes::relaxBranches (32-bit without it)
+        void addBranch(Label label, Instructions::Condition condition = Instructions::AL);
+        /**
+         * @brief Forward branch to label if Rn is zero (or nonzero). CBZ/CBNZ if the label is in reach of it and Rn is a low register,
+         * otherwise CMP Rn, #0 and a conditional branch, which overwrites the flags.
+         */
+        void addCompareBranch(Instructions::Register Rn, Label label, bool nonZero = false);
+        /// @brief LE (or LETP) back to label
+        void addLoopEnd(Label label, bool tailPredicated = false);
+        /// @brief WLS (or WLSTP with the element size) which skips the loop if Rn is zero, label is bound after the LE
+        void addLoopStart(Instructions::Register Rn, Label label, bool tailPredicated = false, Instructions::Size size = Instructions::Size32);
+        /**
+         * @brief Rt = value with a single LDR (literal), the value is placed in a literal pool by Passes::placeLiteralPools.
+         * Equal values share a literal. Falls back to MOVW/MOVT if the literal table is full.
+         */
+        void addLiteralLoad(Instructions::Register Rt, uint32_t value);
+        /// @brief Marks the position of the next instruction with an annotation (see Annotations), the passes move it along
+        void addAnnotation(uint16_t index);
+        /// @brief Inserts node in front of the node at index, false if the program is full
+        bool insert(uint16_t index, Node const & node);
+
+        Node * getNodes() {
+            return nodes;
+        }
+        Node const * getNodes() const {
+            return nodes;
+        }
+        uint16_t getNodeCount() const {
+            return nodeCount;
+        }
+        /// @brief Drops the nodes which a pass marked as REMOVED
+        void compact();
+
+        /// @brief Address of the first halfword, the alignment of ALIGNED nodes depends on it
+        void setBaseAddress(uintptr_t address) {
+            baseAddress = address;
+        }
+        /// @brief Assigns the offsets (in halfwords) of all nodes and labels, returns the size of the kernel in halfwords
+        uint32_t layout();
+        uint16_t getOffset(uint16_t node) const {
+            return offsets[node];
+        }
+        uint16_t getLabelOffset(Label label) const {
+            return labelOffsets[label];
+        }
+        /// @brief Byte offset of a branch at node to its label, relative to the PC (node + 4 bytes), valid after layout()
+        int32_t getBranchOffset(uint16_t node) const;
+        /// @brief Offset of the literal of a LITERAL_LOAD at node from Align(PC, 4), valid after layout(). INT32_MAX if no pool follows the load
+        int32_t getLiteralOffset(uint16_t node) const;
+        uint32_t getLiteral(uint16_t index) const {
+            return literals[index];
+        }
+        /// @brief Halfwords of the CMP in front of the conditional branch of an expanded COMPARE_BRANCH
+        static uint8_t getCompareSize(Node const & node) {
+            return Instructions::Base::assertLowRegister(node.encoding & 0xf) ? 1 : 2;
+        }
+
+        /// @brief Writes the kernel to buffer, returns the halfwords written (0 if it does not fit, the program is invalid or dropped nodes or labels)
+        uint32_t encode(Instructions::Instruction16 * buffer, uint32_t capacity);
+
+        /// @brief Removes all nodes and labels, the storage is kept
+        void reset();
+
+    private:
+        static constexpr uint16_t UNBOUND = UINT16_MAX;
+
+        Node * nodes;
+        uint16_t * offsets;
+        uint16_t * labelOffsets;
+        uint32_t * literals;
+        uint16_t maxNodes;
+        uint16_t maxLabels;
+        uint16_t maxLiterals;
+        uint16_t nodeCount = 0;
+        uint16_t labelCount = 0;
+        uint16_t literalCount = 0;
+        uintptr_t baseAddress = 0;
+        bool overflowed = false; // a node or label was dropped, the program can't be encoded
+
+        void add(Node const & node);
+};
+
+/**
+ * @brief The passes run between instruction selection (the generator) and Program::encode.
+ */
+class JIT::IR::Passes {
+    public:
+        /**
+         * @brief Removes instructions without effect (NOPs, MOV Rd, Rd, ADDW/SUBW Rd, Rd, #0 and results which are overwritten unread),
+         * merges consecutive ADDW/SUBW of a register and folds pointer updates into the writeback of the preceding load or store.
+         */
+        static void peephole(Program & program);
+        /// @brief Reorders the movable instructions between labels and branches with the Scheduler
+        static void schedule(Program & program);
+        /**
+         * @brief Replaces 32-bit instructions by their 16-bit encodings (LDR, MOV, ADD, SUB, MOVW with low registers and small immediates).
+         * The flag setting ADDS/SUBS/MOVS are only used where the flags are dead, which is only tracked if every conditional branch
+         * directly follows its CMP (as the generators emit them).
+         */
+        static void narrow(Program & program);
+        /// @brief Word aligns the start of low overhead loops, so the loop body is fetched in full words
+        static void alignLoops(Program & program);
+        /// @brief Places the literals of the LITERAL_LOADs in pools within reach of the loads
+        static void placeLiteralPools(Program & program);
+        /// @brief Picks the shortest encoding which reaches the label for every branch and literal load
+        static void relaxBranches(Program & program);
+};
+
+/**
+ * @brief Ordered list of passes.
+ */
+class JIT::IR::Pipeline {
+    public:
+        using Pass = void (*)(Program & program);
+        static constexpr uint8_t MAX_PASSES = 8;
+
+        /// @brief peephole, schedule (optional), narrow, alignLoops, placeLiteralPools, relaxBranches
+        static Pipeline defaultPipeline(bool scheduling);
+
+        void addPass(Pass pass);
+        void run(Program & program) const;
+
+    private:
+        Pass passes[MAX_PASSES] = {};
+        uint8_t passCount = 0;
+};
+
+#endif // BACKEND_IR_HPP
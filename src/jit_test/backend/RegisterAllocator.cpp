@@ -0,0 +1,131 @@
+#include "RegisterAllocator.hpp"
+#include "instructions/Base.hpp"
+#include <cstdint>
+
+using namespace JIT::Instructions;
+
+void JIT::RegisterAllocator::addRegister(Register reg) {
+    if (registerCount == MAX_REGISTERS) {
+        Base::printValidationError("RegisterAllocator::addRegister: pool is full");
+        return;
+    }
+    registerPool[registerCount++] = reg;
+}
+
+void JIT::RegisterAllocator::addVectorRegister(VectorRegister reg) {
+    if (vectorCount == MAX_REGISTERS) {
+        Base::printValidationError("RegisterAllocator::addVectorRegister: pool is full");
+        return;
+    }
+    vectorPool[vectorCount++] = reg;
+}
+
+JIT::RegisterAllocator::Interval JIT::RegisterAllocator::addInterval(uint16_t start, uint16_t end, uint8_t weight) {
+    return addInterval(start, end, weight, false);
+}
+
+JIT::RegisterAllocator::Interval JIT::RegisterAllocator::addVectorInterval(uint16_t start, uint16_t end, uint8_t weight) {
+    return addInterval(start, end, weight, true);
+}
+
+JIT::RegisterAllocator::Interval JIT::RegisterAllocator::addInterval(uint16_t start, uint16_t end, uint8_t weight, bool vector) {
+    if (start >= end) {
+        Base::printValidationError("RegisterAllocator::addInterval: empty live range - returning NO_INTERVAL");
+        return NO_INTERVAL;
+    }
+    if (intervalCount == MAX_INTERVALS) {
+        Base::printValidationError("RegisterAllocator::addInterval: too many intervals - returning NO_INTERVAL");
+        return NO_INTERVAL;
+    }
+    intervals[intervalCount] = {start, end, weight, vector, NO_REGISTER};
+    return intervalCount++;
+}
+
+void JIT::RegisterAllocator::allocate() {
+    allocate(false, registerPool, registerCount);
+    allocate(true, vectorPool, vectorCount);
+}
+
+/*
+Linear scan: the intervals are visited by increasing start (higher weight first at equal starts).
+Intervals which ended before the current start release their register. If no register is free,
+the active interval with the lowest weight is spilled if it weighs less than the current one.
+*/
+void JIT::RegisterAllocator::allocate(bool vector, uint8_t const * pool, uint8_t poolCount) {
+    uint8_t order[MAX_INTERVALS];
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < intervalCount; i++) {
+        if (intervals[i].vector != vector) continue;
+        intervals[i].reg = NO_REGISTER;
+        // insertion sort, stable for equal keys
+        uint8_t position = count++;
+        while (position > 0) {
+            IntervalData const & previous = intervals[order[position - 1]];
+            if (previous.start < intervals[i].start || (previous.start == intervals[i].start && previous.weight >= intervals[i].weight)) break;
+            order[position] = order[position - 1];
+            position--;
+        }
+        order[position] = i;
+    }
+
+    uint8_t active[MAX_INTERVALS];
+    uint8_t activeCount = 0;
+    for (uint8_t o = 0; o < count; o++) {
+        IntervalData & current = intervals[order[o]];
+        // expire the intervals which ended before the current one starts
+        uint8_t kept = 0;
+        for (uint8_t a = 0; a < activeCount; a++) {
+            if (intervals[active[a]].end > current.start) active[kept++] = active[a];
+        }
+        activeCount = kept;
+
+        for (uint8_t p = 0; p < poolCount && current.reg == NO_REGISTER; p++) {
+            bool used = false;
+            for (uint8_t a = 0; a < activeCount; a++) {
+                if (intervals[active[a]].reg == pool[p]) used = true;
+            }
+            if (!used) current.reg = pool[p];
+        }
+        if (current.reg != NO_REGISTER) {
+            active[activeCount++] = order[o];
+            continue;
+        }
+
+        // no free register: spill the lightest interval (on equal weights the one which ends last)
+        uint8_t victim = NO_INTERVAL;
+        for (uint8_t a = 0; a < activeCount; a++) {
+            IntervalData const & candidate = intervals[active[a]];
+            if (victim == NO_INTERVAL || candidate.weight < intervals[active[victim]].weight
+                || (candidate.weight == intervals[active[victim]].weight && candidate.end > intervals[active[victim]].end)) {
+                victim = a;
+            }
+        }
+        if (victim != NO_INTERVAL && intervals[active[victim]].weight < current.weight) {
+            current.reg = intervals[active[victim]].reg;
+            intervals[active[victim]].reg = NO_REGISTER;
+            active[victim] = order[o];
+        }
+    }
+}
+
+bool JIT::RegisterAllocator::isAllocated(Interval interval) const {
+    return interval < intervalCount && intervals[interval].reg != NO_REGISTER;
+}
+
+Register JIT::RegisterAllocator::getRegister(Interval interval) const {
+    return static_cast<Register>(intervals[interval].reg);
+}
+
+VectorRegister JIT::RegisterAllocator::getVectorRegister(Interval interval) const {
+    return static_cast<VectorRegister>(intervals[interval].reg);
+}
+
+void JIT::RegisterAllocator::clearIntervals() {
+    intervalCount = 0;
+}
+
+void JIT::RegisterAllocator::reset() {
+    intervalCount = 0;
+    registerCount = 0;
+    vectorCount = 0;
+}
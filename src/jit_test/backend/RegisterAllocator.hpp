@@ -0,0 +1,84 @@
+#ifndef BACKEND_REGISTER_ALLOCATOR_HPP
+#define BACKEND_REGISTER_ALLOCATOR_HPP
+#pragma once
+#include <cstdint>
+#include "../instructions/Base.hpp"
+
+namespace JIT {
+    class RegisterAllocator;
+}
+
+/**
+ * @brief Linear scan register allocator for the values of a kernel.
+ * The generator describes each value by its live range [start, end) in positions of its own choosing
+ * (e.g. prologue, microkernel, loop control) and a weight. Registers are taken from the pools in the order
+ * they were added, so the preferred registers have to be added first.
+ *
+ * If all registers of a pool are occupied, the interval with the lowest weight is spilled (the new one or an active one).
+ * Spilled intervals are spilled for their whole range, the generator has to materialize their value before each use.
+ * General-purpose and vector registers are allocated independently. No dynamic memory is used.
+ */
+class JIT::RegisterAllocator {
+    public:
+        using Interval = uint8_t;
+        static constexpr uint8_t MAX_INTERVALS = 16;
+        static constexpr Interval NO_INTERVAL = UINT8_MAX;
+
+        RegisterAllocator() = default;
+
+        /// @brief Adds a general-purpose register to the pool. Registers are handed out in the order they were added
+        void addRegister(Instructions::Register reg);
+        /// @brief Adds a vector register to the pool. Registers are handed out in the order they were added
+        void addVectorRegister(Instructions::VectorRegister reg);
+
+        /**
+         * @brief Adds the live range [start, end) of a value which needs a general-purpose register.
+         * Of overlapping intervals the one with the higher weight keeps its register, at equal weights the first one added.
+         * Returns NO_INTERVAL if start >= end or MAX_INTERVALS are exceeded.
+         */
+        Interval addInterval(uint16_t start, uint16_t end, uint8_t weight);
+        /// @brief Same as addInterval for a value which needs a vector register
+        Interval addVectorInterval(uint16_t start, uint16_t end, uint8_t weight);
+
+        /// @brief Assigns the registers. Can be called again after adding further intervals
+        void allocate();
+
+        /// @brief false if the interval was spilled (or not allocated yet)
+        bool isAllocated(Interval interval) const;
+        /// @brief Register of an allocated general-purpose interval
+        Instructions::Register getRegister(Interval interval) const;
+        /// @brief Register of an allocated vector interval
+        Instructions::VectorRegister getVectorRegister(Interval interval) const;
+        uint8_t getIntervalCount() const {
+            return intervalCount;
+        }
+
+        /// @brief Removes the intervals, the pools are kept
+        void clearIntervals();
+        /// @brief Removes the intervals and the pools
+        void reset();
+
+    private:
+        static constexpr uint8_t NO_REGISTER = UINT8_MAX;
+        static constexpr uint8_t MAX_REGISTERS = 16;
+
+        struct IntervalData {
+            uint16_t start;
+            uint16_t end;
+            uint8_t weight;
+            bool vector;
+            uint8_t reg;
+        };
+
+        IntervalData intervals[MAX_INTERVALS] = {};
+        uint8_t intervalCount = 0;
+        uint8_t registerPool[MAX_REGISTERS] = {};
+        uint8_t registerCount = 0;
+        uint8_t vectorPool[MAX_REGISTERS] = {};
+        uint8_t vectorCount = 0;
+
+        Interval addInterval(uint16_t start, uint16_t end, uint8_t weight, bool vector);
+        void allocate(bool vector, uint8_t const * pool, uint8_t poolCount);
+};
+
+#endif // BACKEND_REGISTER_ALLOCATOR_HPP
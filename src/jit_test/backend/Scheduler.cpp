@@ -0,0 +1,286 @@
+#include "Scheduler.hpp"
+#include "instructions/Base.hpp"
+#include <cstdint>
+
+using namespace JIT::Instructions;
+
+namespace {
+    enum Unit : uint8_t {
+        UNIT_INTEGER = 0,
+        UNIT_LOAD_STORE = 1,
+        UNIT_MAC = 2,
+        UNIT_COUNT = 3,
+    };
+
+    struct Timing {
+        Unit unit;
+        uint8_t occupancy; // cycles until the unit accepts the next instruction
+        uint8_t latency; // cycles until a dependent instruction can start
+    };
+
+    /*
+    Cortex-M55 model, indexed by Scheduler::OperationType. The M55 executes two beats of an MVE instruction per cycle,
+    so a 128-bit VLDR/VSTR/VFMA occupies its unit for two cycles. Instructions on different units overlap and a VFMA
+    can consume the first beats of a VLDR while the load finishes. FP results are only available after the FP pipeline,
+    e.g. VFMA followed by a VFMA reading the result stalls. Scalar loads have a load-use penalty of one cycle.
+    */
+    constexpr Timing TIMINGS[] = {
+        {UNIT_INTEGER, 1, 1}, // BARRIER (never scheduled)
+        {UNIT_INTEGER, 1, 1}, // SCALAR_ALU
+        {UNIT_LOAD_STORE, 1, 2}, // SCALAR_LOAD
+        {UNIT_LOAD_STORE, 2, 1}, // VECTOR_LOAD
+        {UNIT_LOAD_STORE, 2, 1}, // VECTOR_STORE
+        {UNIT_MAC, 2, 3}, // VECTOR_MAC
+    };
+
+    constexpr uint16_t SP_OR_PC = (1 << 13) | (1 << 15);
+
+    bool is32Bit(Instruction16 firstHalfword) {
+        return (firstHalfword >> 11) >= 0b11101;
+    }
+
+    bool isSpecialRegister(uint32_t reg) {
+        return ((1U << reg) & SP_OR_PC) != 0;
+    }
+
+    /* RRX (ROR #0) reads the carry flag */
+    bool shiftReadsFlags(Instruction32 instr) {
+        return ((instr >> 4) & 0x3) == 0x3 && ((instr >> 6) & 0x3) == 0 && ((instr >> 12) & 0x7) == 0;
+    }
+
+    bool isMemory(JIT::Scheduler::OperationType type) {
+        return type == JIT::Scheduler::SCALAR_LOAD || type == JIT::Scheduler::VECTOR_LOAD || type == JIT::Scheduler::VECTOR_STORE;
+    }
+
+    /*
+    depends[j]: bit i is set if instruction j has to stay behind instruction i,
+    readsResult[j]: bit i is set if j reads a register written by i (the latency of i applies)
+    */
+    void buildDependencies(JIT::Scheduler::Operation const * ops, uint8_t count, uint32_t * depends, uint32_t * readsResult) {
+        for (uint8_t j = 0; j < count; j++) {
+            depends[j] = 0;
+            readsResult[j] = 0;
+            for (uint8_t i = 0; i < j; i++) {
+                bool const raw = (ops[i].defs & ops[j].uses) != 0 || (ops[i].vectorDefs & ops[j].vectorUses) != 0;
+                bool const war = (ops[i].uses & ops[j].defs) != 0 || (ops[i].vectorUses & ops[j].vectorDefs) != 0;
+                bool const waw = (ops[i].defs & ops[j].defs) != 0 || (ops[i].vectorDefs & ops[j].vectorDefs) != 0;
+                // no alias analysis: only loads are reordered with each other
+                bool const memory = isMemory(ops[i].type) && isMemory(ops[j].type)
+                    && (ops[i].type == JIT::Scheduler::VECTOR_STORE || ops[j].type == JIT::Scheduler::VECTOR_STORE);
+                if (raw || war || waw || memory) depends[j] |= 1U << i;
+                if (raw) readsResult[j] |= 1U << i;
+            }
+        }
+    }
+
+    struct PipelineState {
+        uint32_t unitFree[UNIT_COUNT];
+        uint32_t nextIssue; // single issue
+        uint32_t start[JIT::Scheduler::MAX_WINDOW];
+    };
+
+    uint32_t earliestStart(PipelineState const & state, JIT::Scheduler::Operation const * ops, uint8_t j, uint32_t depends, uint32_t readsResult) {
+        Timing const & timing = TIMINGS[ops[j].type];
+        uint32_t start = state.nextIssue;
+        if (state.unitFree[timing.unit] > start) start = state.unitFree[timing.unit];
+        for (uint8_t i = 0; i < JIT::Scheduler::MAX_WINDOW; i++) {
+            if ((depends >> i & 1U) == 0) continue;
+            uint32_t const ready = state.start[i] + ((readsResult >> i & 1U) ? TIMINGS[ops[i].type].latency : 1);
+            if (ready > start) start = ready;
+        }
+        return start;
+    }
+
+    void issue(PipelineState & state, JIT::Scheduler::Operation const * ops, uint8_t j, uint32_t start) {
+        Timing const & timing = TIMINGS[ops[j].type];
+        state.start[j] = start;
+        state.unitFree[timing.unit] = start + timing.occupancy;
+        state.nextIssue = start + 1;
+    }
+}
+
+JIT::Scheduler::Operation JIT::Scheduler::decode(Instruction32 instr) {
+    Operation op = {BARRIER, 0, 0, 0, 0};
+    uint32_t const rn = (instr >> 16) & 0xf;
+    uint32_t const rt = (instr >> 12) & 0xf; // Rt of loads
+    uint32_t const rd = (instr >> 8) & 0xf; // Rd of data processing
+    uint32_t const rm = instr & 0xf;
+    uint32_t const qd = (instr >> 13) & 0x7;
+    uint32_t const qn = (instr >> 17) & 0x7;
+
+    if ((instr & 0xFE40'1F80) == 0xEC00'1F00) { // VLDRW/VSTRW (contiguous)
+        bool const preIndexed = instr >> 24 & 1;
+        bool const writeBack = instr >> 21 & 1;
+        if ((!preIndexed && !writeBack) || rn == PC) return op;
+        op.uses = 1 << rn;
+        if (writeBack) op.defs = 1 << rn;
+        if (instr >> 20 & 1) {
+            op.type = VECTOR_LOAD;
+            op.vectorDefs = 1 << qd;
+        } else {
+            op.type = VECTOR_STORE;
+            op.vectorUses = 1 << qd;
+        }
+    } else if ((instr & 0xEFF1'1FD0) == 0xEE31'0E40) { // VFMA/VMUL (vector by scalar)
+        if (isSpecialRegister(rm)) return op;
+        bool const multiply = instr >> 5 & 1;
+        op.type = VECTOR_MAC;
+        op.uses = 1 << rm;
+        op.vectorDefs = 1 << qd;
+        op.vectorUses = (1 << qn) | (multiply ? 0 : 1 << qd);
+    } else if ((instr & 0xFFE1'1FF1) == 0xEF00'0C50) { // VFMA (vector)
+        op.type = VECTOR_MAC;
+        op.vectorDefs = 1 << qd;
+        op.vectorUses = (1 << qd) | (1 << qn) | (1 << ((instr >> 1) & 0x7));
+    } else if ((instr & 0xFFE1'1FF1) == 0xEF00'0D40 || (instr & 0xFFC1'1FF1) == 0xFF00'0F50) { // VADD/VMAXNM/VMINNM (floating point)
+        op.type = VECTOR_MAC;
+        op.vectorDefs = 1 << qd;
+        op.vectorUses = (1 << qn) | (1 << ((instr >> 1) & 0x7));
+    } else if ((instr & 0xEFF1'1FF0) == 0xEE30'0F40) { // VADD (floating point, vector by scalar)
+        if (isSpecialRegister(rm)) return op;
+        op.type = VECTOR_MAC;
+        op.uses = 1 << rm;
+        op.vectorDefs = 1 << qd;
+        op.vectorUses = 1 << qn;
+    } else if ((instr & 0xFFF0'0000) == 0xF8D0'0000) { // LDR (immediate, T3)
+        if (rn == PC || isSpecialRegister(rt)) return op;
+        op.type = SCALAR_LOAD;
+        op.uses = 1 << rn;
+        op.defs = 1 << rt;
+    } else if ((instr & 0xFFF0'0800) == 0xF850'0800) { // LDR (immediate, T4)
+        bool const preIndexed = instr >> 10 & 1;
+        bool const add = instr >> 9 & 1;
+        bool const writeBack = instr >> 8 & 1;
+        // LDRT and the undefined combination are barriers
+        if ((!preIndexed && !writeBack) || (preIndexed && add && !writeBack)) return op;
+        if (rn == PC || isSpecialRegister(rt) || (writeBack && rn == rt)) return op;
+        op.type = SCALAR_LOAD;
+        op.uses = 1 << rn;
+        op.defs = (1 << rt) | (writeBack ? 1 << rn : 0);
+    } else if ((instr & 0xFBF0'8000) == 0xF200'0000 || (instr & 0xFBF0'8000) == 0xF2A0'0000) { // ADDW/SUBW
+        if (rn == PC || isSpecialRegister(rd)) return op;
+        op.type = SCALAR_ALU;
+        op.uses = 1 << rn;
+        op.defs = 1 << rd;
+    } else if ((instr & 0xFBF0'8000) == 0xF240'0000 || (instr & 0xFBF0'8000) == 0xF2C0'0000) { // MOVW/MOVT
+        if (isSpecialRegister(rd)) return op;
+        bool const top = instr >> 23 & 1;
+        op.type = SCALAR_ALU;
+        op.uses = top ? 1 << rd : 0; // MOVT keeps the lower half
+        op.defs = 1 << rd;
+    } else if ((instr & 0xFFF0'8000) == 0xEB00'0000 || (instr & 0xFFF0'8000) == 0xEBA0'0000) { // ADD/SUB (register) without flags
+        if (isSpecialRegister(rd) || isSpecialRegister(rn) || isSpecialRegister(rm) || shiftReadsFlags(instr)) return op;
+        op.type = SCALAR_ALU;
+        op.uses = (1 << rn) | (1 << rm);
+        op.defs = 1 << rd;
+    } else if ((instr & 0xFFFF'8000) == 0xEA4F'0000) { // MOV (register) without flags
+        if (isSpecialRegister(rd) || isSpecialRegister(rm) || shiftReadsFlags(instr)) return op;
+        op.type = SCALAR_ALU;
+        op.uses = 1 << rm;
+        op.defs = 1 << rd;
+    }
+    return op;
+}
+
+uint8_t JIT::Scheduler::predicatedInstructions(Instruction32 instr) {
+    if ((instr & ~((1U << 22) | (0x7U << 13))) != 0xFE31'0F4D) return 0; // VPST
+    uint32_t const mask = ((instr >> 22 & 1) << 3) | ((instr >> 13) & 0x7);
+    if (mask == 0) return 0;
+    uint8_t trailingZeros = 0;
+    while ((mask >> trailingZeros & 1) == 0) trailingZeros++;
+    return 4 - trailingZeros;
+}
+
+uint32_t JIT::Scheduler::estimateCycles(Instruction32 const * instructions, uint8_t count) {
+    if (count > MAX_WINDOW) count = MAX_WINDOW;
+    Operation ops[MAX_WINDOW];
+    for (uint8_t i = 0; i < count; i++) ops[i] = decode(instructions[i]);
+    uint32_t depends[MAX_WINDOW];
+    uint32_t readsResult[MAX_WINDOW];
+    buildDependencies(ops, count, depends, readsResult);
+
+    PipelineState state = {};
+    uint32_t end = 0;
+    for (uint8_t j = 0; j < count; j++) {
+        uint32_t const start = earliestStart(state, ops, j, depends[j], readsResult[j]);
+        issue(state, ops, j, start);
+        uint32_t const finish = start + TIMINGS[ops[j].type].occupancy;
+        if (finish > end) end = finish;
+    }
+    return end;
+}
+
+void JIT::Scheduler::order(Instruction32 const * instructions, uint8_t count, uint8_t * order) {
+    Operation ops[MAX_WINDOW];
+    for (uint8_t i = 0; i < count; i++) ops[i] = decode(instructions[i]);
+    uint32_t depends[MAX_WINDOW];
+    uint32_t readsResult[MAX_WINDOW];
+    buildDependencies(ops, count, depends, readsResult);
+
+    PipelineState state = {};
+    uint32_t scheduled = 0;
+    for (uint8_t slot = 0; slot < count; slot++) {
+        uint8_t best = MAX_WINDOW;
+        uint32_t bestStart = UINT32_MAX;
+        for (uint8_t j = 0; j < count; j++) {
+            if ((scheduled >> j & 1U) || (depends[j] & ~scheduled) != 0) continue;
+            uint32_t const candidateStart = earliestStart(state, ops, j, depends[j], readsResult[j]);
+            // ties keep the emitted order
+            if (candidateStart < bestStart) {
+                best = j;
+                bestStart = candidateStart;
+            }
+        }
+        issue(state, ops, best, bestStart);
+        scheduled |= 1U << best;
+        order[slot] = best;
+    }
+}
+
+void JIT::Scheduler::scheduleWindow(Instruction16 * start, uint8_t count) {
+    Instruction32 instructions[MAX_WINDOW];
+    for (uint8_t i = 0; i < count; i++) {
+        instructions[i] = static_cast<Instruction32>(start[2 * i]) << 16 | start[2 * i + 1];
+    }
+    uint8_t issueOrder[MAX_WINDOW];
+    order(instructions, count, issueOrder);
+    for (uint8_t slot = 0; slot < count; slot++) {
+        start[2 * slot] = static_cast<Instruction16>(instructions[issueOrder[slot]] >> 16);
+        start[2 * slot + 1] = static_cast<Instruction16>(instructions[issueOrder[slot]]);
+    }
+}
+
+/*
+Splits the block into runs of movable instructions. Barriers and the instructions of a VPT block stay in place.
+*/
+void JIT::Scheduler::schedule(Instruction16 * block, uint16_t halfwords) {
+    Instruction16 * runStart = block;
+    uint8_t runLength = 0;
+    uint8_t predicated = 0;
+    uint16_t position = 0;
+    while (position < halfwords) {
+        Instruction16 * current = block + position;
+        bool movable = false;
+        uint16_t size = 1;
+        if (is32Bit(*current) && position + 1 < halfwords) {
+            size = 2;
+            Instruction32 const instr = static_cast<Instruction32>(current[0]) << 16 | current[1];
+            movable = predicated == 0 && decode(instr).type != BARRIER;
+            if (predicated > 0) predicated--;
+            else predicated = predicatedInstructions(instr);
+        } else if (predicated > 0) {
+            predicated--;
+        }
+
+        if (movable) {
+            if (runLength == 0) runStart = current;
+            runLength++;
+        }
+        if ((!movable || runLength == MAX_WINDOW) && runLength > 0) {
+            if (runLength > 1) scheduleWindow(runStart, runLength);
+            runLength = 0;
+        }
+        position += size;
+    }
+    if (runLength > 1) scheduleWindow(runStart, runLength);
+}
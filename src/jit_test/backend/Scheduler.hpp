@@ -0,0 +1,71 @@
+#ifndef BACKEND_SCHEDULER_HPP
+#define BACKEND_SCHEDULER_HPP
+#pragma once
+#include <cstdint>
+#include "../instructions/Base.hpp"
+
+namespace JIT {
+    class Scheduler;
+}
+
+/**
+ * @brief List scheduler for the encoded instructions of a basic block, tuned for the beat-wise Helium pipeline of the Cortex-M55.
+ *
+ * The generators emit encoded instructions, so the scheduler decodes the subset which it may move:
+ * VLDRW/VSTRW (contiguous), VFMA/VMUL, LDR (immediate) and the 32-bit MOVW/MOVT/MOV/ADD/SUB without flags.
+ * Every other instruction (16-bit instructions, branches, VPT blocks, flag setting instructions, ...) is a barrier
+ * which keeps its position, only runs of movable instructions between barriers are reordered.
+ * As all movable instructions are 32-bit, the size and alignment of every slot stays the same.
+ *
+ * Inside a run the instructions are kept in dependency order (registers, and loads/stores are never swapped with stores).
+ * The instruction with the earliest possible start in the latency/resource model is picked next, ties keep the emitted order.
+ */
+class JIT::Scheduler {
+    public:
+        /* instructions which are reordered together, longer runs are split */
+        static constexpr uint8_t MAX_WINDOW = 32;
+
+        enum OperationType : uint8_t {
+            BARRIER = 0,
+            SCALAR_ALU,
+            SCALAR_LOAD,
+            VECTOR_LOAD,
+            VECTOR_STORE,
+            VECTOR_MAC,
+        };
+
+        struct Operation {
+            OperationType type;
+            uint16_t defs; // general-purpose registers which are written
+            uint16_t uses; // general-purpose registers which are read
+            uint8_t vectorDefs;
+            uint8_t vectorUses;
+        };
+
+        /**
+         * @brief Reorders the instructions of a basic block in place.
+         *
+         * @param block first halfword of the block, branches must not target instructions after it
+         * @param halfwords size of the block
+         */
+        static void schedule(Instructions::Instruction16 * block, uint16_t halfwords);
+
+        /**
+         * @brief Issue order of a run of movable instructions (no barriers), used by the passes which keep their own instruction list.
+         *
+         * @param order receives the indices into instructions, count entries (count <= MAX_WINDOW)
+         */
+        static void order(Instructions::Instruction32 const * instructions, uint8_t count, uint8_t * order);
+
+        /// @brief Decodes the registers of a movable 32-bit instruction, type is BARRIER for all other instructions
+        static Operation decode(Instructions::Instruction32 instr);
+        /// @brief Count of instructions predicated by a VPST, 0 for all other instructions
+        static uint8_t predicatedInstructions(Instructions::Instruction32 instr);
+        /// @brief Estimated cycles of a sequence of movable instructions in the latency/resource model
+        static uint32_t estimateCycles(Instructions::Instruction32 const * instructions, uint8_t count);
+
+    private:
+        static void scheduleWindow(Instructions::Instruction16 * start, uint8_t count);
+};
+
+#endif // BACKEND_SCHEDULER_HPP
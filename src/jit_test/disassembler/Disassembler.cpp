@@ -0,0 +1,455 @@
+#include "Disassembler.hpp"
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#if defined(__arm__)
+#include "SEGGER_RTT.h"
+#endif
+
+using namespace JIT::Instructions;
+
+namespace {
+    char const * const REGISTERS[16] = {"r0", "r1", "r2", "r3", "r4", "r5", "r6", "r7", "r8", "r9", "r10", "r11", "r12", "sp", "lr", "pc"};
+    char const * const CONDITIONS[16] = {"eq", "ne", "hs", "lo", "mi", "pl", "vs", "vc", "hi", "ls", "ge", "lt", "gt", "le", "", ""};
+    char const * const SHIFTS[4] = {"lsl", "lsr", "asr", "ror"};
+    // data processing (modified immediate and shifted register), by op
+    char const * const DATA_PROCESSING[16] = {"and", "bic", "orr", "orn", "eor", nullptr, nullptr, nullptr, "add", nullptr, "adc", "sbc", nullptr, "sub", "rsb", nullptr};
+    char const * const DATA_PROCESSING16[16] = {"ands", "eors", "lsls", "lsrs", "asrs", "adcs", "sbcs", "rors", "tst", "rsbs", "cmp", "cmn", "orrs", "muls", "bics", "mvns"};
+    char const * const LOAD_STORE_REGISTER16[8] = {"str", "strh", "strb", "ldrsb", "ldr", "ldrh", "ldrb", "ldrsh"};
+
+    struct Text {
+        char * text;
+        uint32_t size;
+        uint32_t length = 0;
+
+        void add(char const * format, ...) __attribute__((format(printf, 2, 3))) {
+            if (length + 1 >= size) return;
+            va_list arguments;
+            va_start(arguments, format);
+            int const written = vsnprintf(text + length, size - length, format, arguments);
+            va_end(arguments);
+            if (written > 0) length = length + written < size ? length + written : size - 1;
+        }
+    };
+
+    int32_t signExtend(uint32_t value, uint8_t bits) {
+        uint32_t const sign = 1U << (bits - 1);
+        return static_cast<int32_t>((value ^ sign) - sign);
+    }
+
+    void registerList(Text & text, uint16_t list) {
+        text.add("{");
+        bool first = true;
+        for (uint8_t reg = 0; reg < 16; reg++) {
+            if (((list >> reg) & 1) == 0) continue;
+            text.add(first ? "%s" : ", %s", REGISTERS[reg]);
+            first = false;
+        }
+        text.add("}");
+    }
+
+    void shift(Text & text, uint8_t type, uint8_t amount) {
+        if (type == ROR && amount == 0) text.add(", rrx");
+        else if (type != LSL || amount != 0) text.add(", %s #%u", SHIFTS[type], amount == 0 ? 32U : amount);
+    }
+
+    /* ThumbExpandImm of i:imm3:imm8 */
+    uint32_t expandImmediate(uint32_t imm12) {
+        uint32_t const imm8 = imm12 & 0xff;
+        switch (imm12 >> 8) {
+            case 0: return imm8;
+            case 1: return imm8 << 16 | imm8;
+            case 2: return imm8 << 24 | imm8 << 8;
+            case 3: return imm8 << 24 | imm8 << 16 | imm8 << 8 | imm8;
+            default: {
+                uint32_t const value = 0x80 | (imm12 & 0x7f);
+                uint8_t const rotation = imm12 >> 7;
+                return value >> rotation | value << (32 - rotation);
+            }
+        }
+    }
+
+    /* [Rn, #imm], [Rn, #imm]! or [Rn], #imm of the loads and stores with an 8-bit immediate */
+    void indexedAddress(Text & text, uint8_t rn, int32_t imm, bool preIndexed, bool writeBack) {
+        if (!preIndexed) text.add("[%s], #%d", REGISTERS[rn], imm);
+        else if (imm == 0 && !writeBack) text.add("[%s]", REGISTERS[rn]);
+        else text.add("[%s, #%d]%s", REGISTERS[rn], imm, writeBack ? "!" : "");
+    }
+
+    /* MVE mnemonic, with the T suffix inside a VPT block (vldrwt.u32) */
+    void vector(Text & text, char const * mnemonic, bool inBlock, char const * type = "") {
+        text.add("%s%s%s ", mnemonic, inBlock ? "t" : "", type);
+    }
+
+    void decode16(Text & text, Instruction16 instruction, uint32_t offset) {
+        uint8_t const low = instruction & 0x7;
+        uint8_t const middle = (instruction >> 3) & 0x7;
+        uint8_t const high = (instruction >> 8) & 0x7;
+
+        if (instruction < 0x1800) { // LSL/LSR/ASR Rd, Rm, #imm5, MOVS Rd, Rm
+            uint8_t const type = (instruction >> 11) & 0x3;
+            uint8_t const amount = (instruction >> 6) & 0x1f;
+            if (type == LSL && amount == 0) text.add("movs %s, %s", REGISTERS[low], REGISTERS[middle]);
+            else text.add("%ss %s, %s, #%u", SHIFTS[type], REGISTERS[low], REGISTERS[middle], amount == 0 ? 32U : amount);
+        } else if (instruction < 0x2000) { // ADDS/SUBS Rd, Rn, Rm and #imm3
+            char const * const mnemonic = (instruction & 0x0200) != 0 ? "subs" : "adds";
+            uint8_t const operand = (instruction >> 6) & 0x7;
+            if ((instruction & 0x0400) != 0) text.add("%s %s, %s, #%u", mnemonic, REGISTERS[low], REGISTERS[middle], operand);
+            else text.add("%s %s, %s, %s", mnemonic, REGISTERS[low], REGISTERS[middle], REGISTERS[operand]);
+        } else if (instruction < 0x4000) { // MOVS/CMP/ADDS/SUBS Rdn, #imm8
+            char const * const mnemonics[4] = {"movs", "cmp", "adds", "subs"};
+            text.add("%s %s, #%u", mnemonics[(instruction >> 11) & 0x3], REGISTERS[high], instruction & 0xffU);
+        } else if (instruction < 0x4400) { // data processing (register)
+            uint8_t const opcode = (instruction >> 6) & 0xf;
+            if (opcode == 0x9) text.add("rsbs %s, %s, #0", REGISTERS[low], REGISTERS[middle]);
+            else if (opcode == 0xd) text.add("muls %s, %s, %s", REGISTERS[low], REGISTERS[middle], REGISTERS[low]);
+            else text.add("%s %s, %s", DATA_PROCESSING16[opcode], REGISTERS[low], REGISTERS[middle]);
+        } else if (instruction < 0x4800) { // ADD/CMP/MOV with high registers, BX/BLX
+            uint8_t const rdn = ((instruction >> 7) & 0x1) << 3 | low;
+            uint8_t const rm = (instruction >> 3) & 0xf;
+            uint8_t const opcode = (instruction >> 8) & 0x3;
+            char const * const mnemonics[3] = {"add", "cmp", "mov"};
+            if (opcode == 3) text.add("%s %s", (instruction & 0x80) != 0 ? "blx" : "bx", REGISTERS[rm]);
+            else text.add("%s %s, %s", mnemonics[opcode], REGISTERS[rdn], REGISTERS[rm]);
+        } else if (instruction < 0x5000) { // LDR Rt, [PC, #imm8]
+            uint32_t const imm = (instruction & 0xff) * 4;
+            text.add("ldr %s, [pc, #%u] @ 0x%x", REGISTERS[high], imm, ((offset + 4) & ~3U) + imm);
+        } else if (instruction < 0x6000) { // LDR/STR (register)
+            text.add("%s %s, [%s, %s]", LOAD_STORE_REGISTER16[(instruction >> 9) & 0x7], REGISTERS[low], REGISTERS[middle], REGISTERS[(instruction >> 6) & 0x7]);
+        } else if (instruction < 0x9000) { // LDR/STR, LDRB/STRB, LDRH/STRH Rt, [Rn, #imm5]
+            uint8_t const kind = (instruction >> 12) - 0x6; // word, byte, halfword
+            char const * const suffixes[3] = {"", "b", "h"};
+            uint8_t const scale[3] = {4, 1, 2};
+            uint32_t const imm = ((instruction >> 6) & 0x1f) * scale[kind];
+            text.add("%s%s %s, ", (instruction & 0x0800) != 0 ? "ldr" : "str", suffixes[kind], REGISTERS[low]);
+            indexedAddress(text, middle, imm, true, false);
+        } else if (instruction < 0xa000) { // LDR/STR Rt, [SP, #imm8]
+            text.add("%s %s, ", (instruction & 0x0800) != 0 ? "ldr" : "str", REGISTERS[high]);
+            indexedAddress(text, SP, (instruction & 0xff) * 4, true, false);
+        } else if (instruction < 0xb000) { // ADR, ADD Rd, SP, #imm8
+            if ((instruction & 0x0800) != 0) text.add("add %s, sp, #%u", REGISTERS[high], (instruction & 0xffU) * 4);
+            else text.add("adr %s, #%u", REGISTERS[high], (instruction & 0xffU) * 4);
+        } else if ((instruction & 0xff00) == 0xb000) { // ADD/SUB SP, SP, #imm7
+            text.add("%s sp, #%u", (instruction & 0x80) != 0 ? "sub" : "add", (instruction & 0x7fU) * 4);
+        } else if ((instruction & 0xf500) == 0xb100) { // CBZ/CBNZ
+            uint32_t const imm = ((instruction >> 9) & 0x1) << 6 | ((instruction >> 3) & 0x1f) << 1;
+            text.add("%s %s, 0x%x", (instruction & 0x0800) != 0 ? "cbnz" : "cbz", REGISTERS[low], offset + 4 + imm);
+        } else if ((instruction & 0xfe00) == 0xb400) { // PUSH
+            text.add("push ");
+            registerList(text, (instruction & 0xff) | ((instruction & 0x0100) != 0 ? 1 << LR : 0));
+        } else if ((instruction & 0xfe00) == 0xbc00) { // POP
+            text.add("pop ");
+            registerList(text, (instruction & 0xff) | ((instruction & 0x0100) != 0 ? 1 << PC : 0));
+        } else if (instruction == 0xbf00) {
+            text.add("nop");
+        } else if ((instruction & 0xf000) == 0xd000) { // B<c>, UDF, SVC
+            uint8_t const condition = (instruction >> 8) & 0xf;
+            if (condition == 0xe) text.add("udf #%u", instruction & 0xffU);
+            else if (condition == 0xf) text.add("svc #%u", instruction & 0xffU);
+            else text.add("b%s 0x%x", CONDITIONS[condition], offset + 4 + signExtend((instruction & 0xff) << 1, 9));
+        } else if ((instruction & 0xf800) == 0xe000) { // B
+            text.add("b 0x%x", offset + 4 + signExtend((instruction & 0x7ff) << 1, 12));
+        } else {
+            text.add(".inst.n 0x%04x", instruction);
+        }
+    }
+
+    bool decodeScalar32(Text & text, Instruction32 instruction, uint32_t offset) {
+        uint8_t const rn = (instruction >> 16) & 0xf;
+        uint8_t const rt = (instruction >> 12) & 0xf;
+        uint8_t const rd = (instruction >> 8) & 0xf;
+        uint8_t const rm = instruction & 0xf;
+        bool const setFlags = (instruction & 0x0010'0000) != 0;
+        uint8_t const opcode = (instruction >> 21) & 0xf;
+
+        if (instruction == Base::nop32()) {
+            text.add("nop.w");
+        } else if ((instruction & 0xffff'0000) == 0xe92d'0000 || (instruction & 0xffff'0000) == 0xe8bd'0000) { // PUSH.W/POP.W
+            text.add("%s.w ", (instruction & 0x0010'0000) != 0 ? "pop" : "push");
+            registerList(text, instruction & 0xffff);
+        } else if ((instruction & 0xfebf'0f00) == 0xec2d'0b00 || (instruction & 0xfebf'0f00) == 0xecbd'0b00) { // VPUSH/VPOP
+            uint8_t const first = ((instruction >> 22) & 0x1) << 4 | ((instruction >> 12) & 0xf);
+            text.add("%s {", (instruction & 0x0080'0000) != 0 ? "vpop" : "vpush");
+            for (uint8_t d = first; d < first + (instruction & 0xff) / 2; d++) text.add(d == first ? "d%u" : ", d%u", d);
+            text.add("}");
+        } else if ((instruction & 0xff80'ffff) == 0xf000'e001) { // DLS/DLSTP
+            uint8_t const size = (instruction >> 20) & 0x7;
+            if (size == 0x4) text.add("dls lr, %s", REGISTERS[rn]);
+            else text.add("dlstp.%u lr, %s", 8U << size, REGISTERS[rn]);
+        } else if ((instruction & 0xffef'f001) == 0xf00f'c001) { // LE/LETP
+            uint32_t const imm = ((instruction >> 1) & 0x3ff) << 2 | ((instruction >> 11) & 0x1) << 1;
+            text.add("%s lr, 0x%x", (instruction & 0x0010'0000) != 0 ? "letp" : "le", offset + 4 - imm);
+        } else if ((instruction & 0xff80'f001) == 0xf000'c001) { // WLS/WLSTP
+            uint32_t const imm = ((instruction >> 1) & 0x3ff) << 2 | ((instruction >> 11) & 0x1) << 1;
+            uint8_t const size = (instruction >> 20) & 0x7;
+            if (size == 0x4) text.add("wls lr, %s, 0x%x", REGISTERS[rn], offset + 4 + imm);
+            else text.add("wlstp.%u lr, %s, 0x%x", 8U << size, REGISTERS[rn], offset + 4 + imm);
+        } else if ((instruction & 0xf800'd000) == 0xf000'9000) { // B.W
+            uint32_t const s = (instruction >> 26) & 0x1;
+            uint32_t const i1 = ~(((instruction >> 13) & 0x1) ^ s) & 0x1;
+            uint32_t const i2 = ~(((instruction >> 11) & 0x1) ^ s) & 0x1;
+            uint32_t const imm = s << 24 | i1 << 23 | i2 << 22 | ((instruction >> 16) & 0x3ff) << 12 | (instruction & 0x7ff) << 1;
+            text.add("b.w 0x%x", offset + 4 + signExtend(imm, 25));
+        } else if ((instruction & 0xf800'd000) == 0xf000'8000 && ((instruction >> 22) & 0xf) < AL) { // B<c>.W
+            uint32_t const imm = ((instruction >> 26) & 0x1) << 20 | ((instruction >> 11) & 0x1) << 19 | ((instruction >> 13) & 0x1) << 18
+                | ((instruction >> 16) & 0x3f) << 12 | (instruction & 0x7ff) << 1;
+            text.add("b%s.w 0x%x", CONDITIONS[(instruction >> 22) & 0xf], offset + 4 + signExtend(imm, 21));
+        } else if ((instruction & 0xfbf0'8000) == 0xf240'0000 || (instruction & 0xfbf0'8000) == 0xf2c0'0000) { // MOVW/MOVT
+            uint32_t const imm = rn << 12 | ((instruction >> 26) & 0x1) << 11 | ((instruction >> 12) & 0x7) << 8 | (instruction & 0xff);
+            text.add("%s %s, #%u", (instruction & 0x0080'0000) != 0 ? "movt" : "movw", REGISTERS[rd], imm);
+        } else if ((instruction & 0xfbf0'8000) == 0xf200'0000 || (instruction & 0xfbf0'8000) == 0xf2a0'0000) { // ADDW/SUBW
+            uint32_t const imm = ((instruction >> 26) & 0x1) << 11 | ((instruction >> 12) & 0x7) << 8 | (instruction & 0xff);
+            text.add("%s %s, %s, #%u", (instruction & 0x0080'0000) != 0 ? "subw" : "addw", REGISTERS[rd], REGISTERS[rn], imm);
+        } else if ((instruction & 0xfa00'8000) == 0xf000'0000 && DATA_PROCESSING[opcode] != nullptr) { // data processing (modified immediate)
+            uint32_t const imm = expandImmediate(((instruction >> 26) & 0x1) << 11 | ((instruction >> 12) & 0x7) << 8 | (instruction & 0xff));
+            char const * const compares[16] = {"tst", nullptr, nullptr, nullptr, "teq", nullptr, nullptr, nullptr, "cmn", nullptr, nullptr, nullptr, nullptr, "cmp"};
+            if (rd == PC && setFlags && compares[opcode] != nullptr) text.add("%s.w %s, #%u", compares[opcode], REGISTERS[rn], imm);
+            else if (rn == PC && (opcode == 2 || opcode == 3)) text.add("%s%s %s, #%u", opcode == 2 ? "mov" : "mvn", setFlags ? "s" : "", REGISTERS[rd], imm);
+            else text.add("%s%s %s, %s, #%u", DATA_PROCESSING[opcode], setFlags ? "s" : "", REGISTERS[rd], REGISTERS[rn], imm);
+        } else if ((instruction & 0xfe00'0000) == 0xea00'0000 && DATA_PROCESSING[opcode] != nullptr) { // data processing (shifted register)
+            uint8_t const type = (instruction >> 4) & 0x3;
+            uint8_t const amount = ((instruction >> 12) & 0x7) << 2 | ((instruction >> 6) & 0x3);
+            char const * const compares[16] = {"tst", nullptr, nullptr, nullptr, "teq", nullptr, nullptr, nullptr, "cmn", nullptr, nullptr, nullptr, nullptr, "cmp"};
+            if (rd == PC && setFlags && compares[opcode] != nullptr) {
+                text.add("%s.w %s, %s", compares[opcode], REGISTERS[rn], REGISTERS[rm]);
+                shift(text, type, amount);
+            } else if (rn == PC && opcode == 2) { // MOV, LSL/LSR/ASR/ROR (immediate)
+                if (type == LSL && amount == 0) text.add("mov%s.w %s, %s", setFlags ? "s" : "", REGISTERS[rd], REGISTERS[rm]);
+                else if (type == ROR && amount == 0) text.add("rrx%s %s, %s", setFlags ? "s" : "", REGISTERS[rd], REGISTERS[rm]);
+                else text.add("%s%s.w %s, %s, #%u", SHIFTS[type], setFlags ? "s" : "", REGISTERS[rd], REGISTERS[rm], amount == 0 ? 32U : amount);
+            } else {
+                text.add("%s%s.w %s, %s, %s", DATA_PROCESSING[opcode], setFlags ? "s" : "", REGISTERS[rd], REGISTERS[rn], REGISTERS[rm]);
+                shift(text, type, amount);
+            }
+        } else if ((instruction & 0xfff0'f0f0) == 0xfb00'f000) { // MUL
+            text.add("mul %s, %s, %s", REGISTERS[rd], REGISTERS[rn], REGISTERS[rm]);
+        } else if ((instruction & 0xff7f'0000) == 0xf85f'0000) { // LDR Rt, [PC, #+/-imm12]
+            int32_t const imm = (instruction & 0x0080'0000) != 0 ? static_cast<int32_t>(instruction & 0xfff) : -static_cast<int32_t>(instruction & 0xfff);
+            text.add("ldr.w %s, [pc, #%d] @ 0x%x", REGISTERS[rt], imm, ((offset + 4) & ~3U) + imm);
+        } else if ((instruction & 0xff00'0000) == 0xf800'0000 && (instruction & 0x0060'0000) != 0x0060'0000) { // LDR/STR{B,H}, PLD
+            bool const load = (instruction & 0x0010'0000) != 0;
+            uint8_t const size = (instruction >> 21) & 0x3;
+            char const * const suffixes[3] = {"b", "h", ""};
+            if (load && rt == PC && size != 2) { // PLD/PLDW (immediate)
+                text.add("%s ", size == 1 ? "pldw" : "pld");
+                indexedAddress(text, rn, instruction & 0xfff, true, false);
+            } else if ((instruction & 0x0080'0000) != 0) { // T3, imm12
+                text.add("%s%s.w %s, ", load ? "ldr" : "str", suffixes[size], REGISTERS[rt]);
+                indexedAddress(text, rn, instruction & 0xfff, true, false);
+            } else if ((instruction & 0x0800) != 0) { // T4, imm8 with index and writeback
+                int32_t const imm = (instruction & 0x0200) != 0 ? static_cast<int32_t>(instruction & 0xff) : -static_cast<int32_t>(instruction & 0xff);
+                text.add("%s%s %s, ", load ? "ldr" : "str", suffixes[size], REGISTERS[rt]);
+                indexedAddress(text, rn, imm, (instruction & 0x0400) != 0, (instruction & 0x0100) != 0);
+            } else if ((instruction & 0x0fc0) == 0 || (instruction & 0x0fc0) == 0x0040 || (instruction & 0x0fc0) == 0x0080 || (instruction & 0x0fc0) == 0x00c0) { // register
+                text.add("%s%s.w %s, [%s, %s", load ? "ldr" : "str", suffixes[size], REGISTERS[rt], REGISTERS[rn], REGISTERS[rm]);
+                shift(text, LSL, (instruction >> 4) & 0x3);
+                text.add("]");
+            } else {
+                return false;
+            }
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    /* VLDR/VSTR (contiguous, widening and narrowing) */
+    void vectorLoadStore(Text & text, Instruction32 instruction, bool inBlock) {
+        bool const load = (instruction & 0x0010'0000) != 0;
+        bool const widening = (instruction & 0x1000) == 0;
+        uint8_t const laneSize = (instruction >> 7) & 0x3; // 0: 8 bit, 1: 16 bit, 2: 32 bit
+        uint8_t const memorySize = widening ? ((instruction >> 19) & 0x1) : laneSize;
+        uint8_t const rn = widening ? (instruction >> 16) & 0x7 : (instruction >> 16) & 0xf;
+        char const * const mnemonics[2][3] = {{"vstrb", "vstrh", "vstrw"}, {"vldrb", "vldrh", "vldrw"}};
+        char type[8];
+        if (load) snprintf(type, sizeof(type), ".%c%u", widening && (instruction & 0x1000'0000) == 0 ? 's' : 'u', 8U << laneSize);
+        else snprintf(type, sizeof(type), ".%u", 8U << laneSize);
+        vector(text, mnemonics[load][memorySize], inBlock, type);
+        int32_t const imm = static_cast<int32_t>((instruction & 0x7f) << memorySize);
+        text.add("q%u, ", (instruction >> 13) & 0x7);
+        indexedAddress(text, rn, (instruction & 0x0080'0000) != 0 ? imm : -imm, (instruction & 0x0100'0000) != 0, (instruction & 0x0020'0000) != 0);
+    }
+
+    /* returns false for unknown encodings, blockSize is set by VPST */
+    bool decodeVector(Text & text, Instruction32 instruction, bool inBlock, uint8_t & blockSize) {
+        uint8_t const qd = (instruction >> 13) & 0x7;
+        uint8_t const qn = (instruction >> 17) & 0x7;
+        uint8_t const qm = (instruction >> 1) & 0x7;
+        uint8_t const rm = instruction & 0xf;
+        uint32_t const size = 8U << ((instruction >> 20) & 0x3);
+        char type[8];
+
+        if ((instruction & 0xffbf'1fff) == 0xfe31'0f4d) { // VPST
+            uint8_t const mask = ((instruction >> 22) & 0x1) << 3 | ((instruction >> 13) & 0x7);
+            if (mask == 0) return false;
+            blockSize = 4;
+            while (((mask >> (4 - blockSize)) & 1) == 0) blockSize--;
+            text.add("vpst");
+            for (uint8_t i = 1; i < blockSize; i++) text.add("%c", ((mask >> (4 - i)) & 1) != 0 ? 'e' : 't');
+        } else if ((instruction & 0xffc0'ffff) == 0xf000'e801) { // VCTP
+            snprintf(type, sizeof(type), ".%u", size);
+            vector(text, "vctp", inBlock, type);
+            text.add("%s", REGISTERS[(instruction >> 16) & 0xf]);
+        } else if ((instruction & 0xfff0'1ff1) == 0xfc90'0f41) { // VLDRW.U32 Qd, [Rn, Qm, UXTW #2]
+            vector(text, "vldrw", inBlock, ".u32");
+            text.add("q%u, [%s, q%u, uxtw #2]", qd, REGISTERS[(instruction >> 16) & 0xf], qm);
+        } else if ((instruction & 0xffe0'1fe0) == 0xec00'0f00) { // VMOV two lanes <-> two registers
+            uint8_t const lane = (instruction >> 4) & 0x1;
+            char const * const rt = REGISTERS[rm];
+            char const * const rt2 = REGISTERS[(instruction >> 16) & 0xf];
+            vector(text, "vmov", inBlock);
+            if ((instruction & 0x0010'0000) != 0) text.add("q%u[%u], q%u[%u], %s, %s", qd, lane + 2, qd, lane, rt, rt2);
+            else text.add("%s, %s, q%u[%u], q%u[%u]", rt, rt2, qd, lane + 2, qd, lane);
+        } else if ((instruction & 0xee00'0000) == 0xec00'0000 && (instruction & 0x0e00) == 0x0e00 && (instruction & 0x0180) != 0x0180) {
+            vectorLoadStore(text, instruction, inBlock);
+        } else if ((instruction & 0xffe0'0f7f) == 0xee00'0a10) { // VMOV Sn, Rt and VMOV Rt, Sn
+            uint8_t const sn = ((instruction >> 16) & 0xf) << 1 | ((instruction >> 7) & 0x1);
+            if ((instruction & 0x0010'0000) != 0) text.add("vmov %s, s%u", REGISTERS[(instruction >> 12) & 0xf], sn);
+            else text.add("vmov s%u, %s", sn, REGISTERS[(instruction >> 12) & 0xf]);
+        } else if ((instruction & 0xfff1'0fff) == 0xeea0'0b10) { // VDUP.32 Qd, Rt
+            vector(text, "vdup", inBlock, ".32");
+            text.add("q%u, %s", qn, REGISTERS[(instruction >> 12) & 0xf]);
+        } else if ((instruction & 0xeff8'10f0) == 0xef80'0050) { // VMOV Qd, #imm
+            uint32_t const imm8 = ((instruction >> 28) & 0x1) << 7 | ((instruction >> 16) & 0x7) << 4 | (instruction & 0xf);
+            uint8_t const cmode = (instruction >> 8) & 0xf;
+            if ((cmode & 0x9) == 0) { // i32, imm8 shifted by 0, 8, 16 or 24
+                vector(text, "vmov", inBlock, ".i32");
+                text.add("q%u, #0x%x", qd, imm8 << (cmode * 4));
+            } else if ((cmode & 0xd) == 0x8) { // i16, imm8 shifted by 0 or 8
+                vector(text, "vmov", inBlock, ".i16");
+                text.add("q%u, #0x%x", qd, imm8 << ((cmode & 0x2) * 4));
+            } else if (cmode == 0xe) {
+                vector(text, "vmov", inBlock, ".i8");
+                text.add("q%u, #0x%x", qd, imm8);
+            } else {
+                return false;
+            }
+        } else if ((instruction & 0xfff1'1ff1) == 0xef20'0150) { // VORR, VMOV Qd, Qm
+            vector(text, qn == qm ? "vmov" : "vorr", inBlock);
+            if (qn == qm) text.add("q%u, q%u", qd, qm);
+            else text.add("q%u, q%u, q%u", qd, qn, qm);
+        } else if ((instruction & 0xfff1'1ff1) == 0xef00'0150) { // VAND
+            vector(text, "vand", inBlock);
+            text.add("q%u, q%u, q%u", qd, qn, qm);
+        } else if ((instruction & 0xefff'0ff1) == 0xee3f'0e01) { // VCVTB/VCVTT
+            vector(text, (instruction & 0x1000) != 0 ? "vcvtt" : "vcvtb", inBlock, (instruction & 0x1000'0000) != 0 ? ".f32.f16" : ".f16.f32");
+            text.add("q%u, q%u", qd, qm);
+        } else if ((instruction & 0xffc1'1f7e) == 0xee01'0f6e) { // VIDUP
+            snprintf(type, sizeof(type), ".u%u", size);
+            vector(text, "vidup", inBlock, type);
+            text.add("q%u, %s, #%u", qd, REGISTERS[qn << 1], 1U << (((instruction >> 7) & 0x1) << 1 | (instruction & 0x1)));
+        } else if ((instruction & 0xfff1'1fd1) == 0xeef0'0f00) { // VMLADAV{A}.S8
+            vector(text, (instruction & 0x20) != 0 ? "vmlava" : "vmlav", inBlock, ".s8");
+            text.add("%s, q%u, q%u", REGISTERS[qd << 1], qn, qm);
+        } else if ((instruction & 0xeff1'1ff0) == 0xee31'0e40 || (instruction & 0xeff1'1ff0) == 0xee31'0e60
+                   || (instruction & 0xeff1'1ff0) == 0xee30'0f40) { // VFMA/VMUL/VADD.F Qd, Qn, Rm
+            char const * const mnemonic = (instruction & 0x0100) != 0 ? "vadd" : (instruction & 0x20) != 0 ? "vmul" : "vfma";
+            vector(text, mnemonic, inBlock, (instruction & 0x1000'0000) != 0 ? ".f16" : ".f32");
+            text.add("q%u, q%u, %s", qd, qn, REGISTERS[rm]);
+        } else if ((instruction & 0xffe1'1ff1) == 0xef00'0c50 || (instruction & 0xffe1'1ff1) == 0xef00'0d40
+                   || (instruction & 0xffc1'1ff1) == 0xff00'0f50) { // VFMA/VADD/VMAXNM/VMINNM.F Qd, Qn, Qm
+            char const * const mnemonic = (instruction & 0x1000'0000) != 0 ? ((instruction & 0x0020'0000) != 0 ? "vminnm" : "vmaxnm")
+                                        : (instruction & 0x0100) != 0 ? "vadd" : "vfma";
+            vector(text, mnemonic, inBlock, (instruction & 0x0010'0000) != 0 ? ".f16" : ".f32");
+            text.add("q%u, q%u, q%u", qd, qn, qm);
+        } else if ((instruction & 0xffc1'1ff0) == 0xee01'1e60 || (instruction & 0xffc1'1ff0) == 0xee01'0f40) { // VMUL.I/VADD.I Qd, Qn, Rm
+            snprintf(type, sizeof(type), ".i%u", size);
+            vector(text, (instruction & 0x1000) != 0 ? "vmul" : "vadd", inBlock, type);
+            text.add("q%u, q%u, %s", qd, qn, REGISTERS[rm]);
+        } else if ((instruction & 0xffc1'1ff1) == 0xff00'0b40) { // VQRDMULH
+            snprintf(type, sizeof(type), ".s%u", size);
+            vector(text, "vqrdmulh", inBlock, type);
+            text.add("q%u, q%u, q%u", qd, qn, qm);
+        } else if ((instruction & 0xefc1'1ff1) == 0xef00'0050) { // VQADD
+            snprintf(type, sizeof(type), ".%c%u", (instruction & 0x1000'0000) != 0 ? 'u' : 's', size);
+            vector(text, "vqadd", inBlock, type);
+            text.add("q%u, q%u, q%u", qd, qn, qm);
+        } else if ((instruction & 0xefc1'1ff1) == 0xef00'0840) { // VADD/VSUB.I
+            snprintf(type, sizeof(type), ".i%u", size);
+            vector(text, (instruction & 0x1000'0000) != 0 ? "vsub" : "vadd", inBlock, type);
+            text.add("q%u, q%u, q%u", qd, qn, qm);
+        } else if ((instruction & 0xefc1'1fe1) == 0xef00'0640) { // VMAX/VMIN
+            snprintf(type, sizeof(type), ".%c%u", (instruction & 0x1000'0000) != 0 ? 'u' : 's', size);
+            vector(text, (instruction & 0x10) != 0 ? "vmin" : "vmax", inBlock, type);
+            text.add("q%u, q%u, q%u", qd, qn, qm);
+        } else if ((instruction & 0xefc1'1ef1) == 0xef00'0440) { // VSHL/VRSHL (register), the shift is in Qn
+            snprintf(type, sizeof(type), ".%c%u", (instruction & 0x1000'0000) != 0 ? 'u' : 's', size);
+            vector(text, (instruction & 0x0100) != 0 ? "vrshl" : "vshl", inBlock, type);
+            text.add("q%u, q%u, q%u", qd, qm, qn);
+        } else if ((instruction & 0xffe0'1ff1) == 0xefa0'0550) { // VSHL.I32 #imm
+            vector(text, "vshl", inBlock, ".i32");
+            text.add("q%u, q%u, #%u", qd, qm, ((instruction >> 16) & 0x3f) - 32);
+        } else if ((instruction & 0xefe0'1df1) == 0xefa0'0050) { // VSHR/VRSHR #imm
+            vector(text, (instruction & 0x200) != 0 ? "vrshr" : "vshr", inBlock, (instruction & 0x1000'0000) != 0 ? ".u32" : ".s32");
+            text.add("q%u, q%u, #%u", qd, qm, 64 - ((instruction >> 16) & 0x3f));
+        } else {
+            return false;
+        }
+        return true;
+    }
+}
+
+uint8_t JIT::Disassembler::decode(Instruction16 const * code, uint32_t halfwords, uint32_t offset, char * text, uint32_t size) {
+    Text out = {text, size};
+    if (size > 0) text[0] = '\0';
+    if (halfwords == 0) return 0;
+    Instruction16 const first = code[0];
+    bool const wide = (first & 0xe000) == 0xe000 && (first & 0x1800) != 0;
+    bool const inBlock = predicated > 0;
+    if (predicated > 0) predicated--;
+
+    if (!wide) {
+        decode16(out, first, offset);
+        return 1;
+    }
+    if (halfwords < 2) {
+        out.add(".short 0x%04x", first);
+        return 1;
+    }
+    Instruction32 const instruction = static_cast<Instruction32>(first) << 16 | code[1];
+    uint8_t blockSize = 0;
+    if (!decodeScalar32(out, instruction, offset) && !decodeVector(out, instruction, inBlock, blockSize)) {
+        out.add(".inst.w 0x%08x", instruction);
+    }
+    if (blockSize > 0) predicated = blockSize;
+    // the mnemonic is separated by a single space, without operands it ends with it
+    if (out.length > 0 && text[out.length - 1] == ' ') text[out.length - 1] = '\0';
+    return 2;
+}
+
+void JIT::Disassembler::print(Instruction16 const * code, uint32_t halfwords, Annotations const * annotations, Writer writer, void * context) {
+    char line[MAX_LINE];
+    char text[MAX_TEXT];
+    reset();
+    uint32_t position = 0;
+    while (position < halfwords) {
+        uint16_t data = 0;
+        for (uint16_t i = 0; annotations != nullptr && i < annotations->getCount(); i++) {
+            Annotations::Entry const & entry = annotations->getEntries()[i];
+            if (entry.offset != position) continue;
+            snprintf(line, sizeof(line), "          @ %s\n", entry.text);
+            writer(context, line);
+            if (entry.dataHalfwords > data) data = entry.dataHalfwords;
+        }
+        for (uint16_t i = 0; i + 1 < data && position + 1 < halfwords; i += 2, position += 2) {
+            uint32_t const word = static_cast<uint32_t>(code[position + 1]) << 16 | code[position];
+            snprintf(line, sizeof(line), "%8x:  %04x %04x  .word 0x%08x\n", position * 2, code[position], code[position + 1], word);
+            writer(context, line);
+        }
+        if (data > 0) continue;
+
+        uint8_t const size = decode(&code[position], halfwords - position, position * 2, text, sizeof(text));
+        if (size == 2) snprintf(line, sizeof(line), "%8x:  %04x %04x  %s\n", position * 2, code[position], code[position + 1], text);
+        else snprintf(line, sizeof(line), "%8x:  %04x       %s\n", position * 2, code[position], text);
+        writer(context, line);
+        position += size;
+    }
+}
+
+void JIT::Disassembler::write(void *, char const * text) {
+    #if defined(__arm__)
+    SEGGER_RTT_WriteString(0, text);
+    #else
+    fputs(text, stdout);
+    #endif
+}
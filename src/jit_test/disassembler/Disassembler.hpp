@@ -0,0 +1,55 @@
+#ifndef JIT_DISASSEMBLER_HPP
+#define JIT_DISASSEMBLER_HPP
+#pragma once
+#include <cstdint>
+#include "../backend/Annotations.hpp"
+#include "../instructions/Base.hpp"
+
+namespace JIT {
+    class Disassembler;
+}
+
+/**
+ * @brief Turns a code buffer back into assembly, for every encoding the instruction classes emit (and the 16-bit ones of
+ * the narrow pass). The syntax follows llvm-objdump, branch targets and literal addresses are byte offsets from the
+ * start of the printed code. Unknown encodings are printed as .inst.n/.inst.w.
+ *
+ * Runs on the target (RTT) and on the host, it neither allocates nor uses more than one line of stack.
+ */
+class JIT::Disassembler {
+    public:
+        using Writer = void (*)(void * context, char const * text);
+        static constexpr uint32_t MAX_TEXT = 64; // mnemonic and operands of one instruction
+        static constexpr uint32_t MAX_LINE = 96;
+
+        /**
+         * @brief Writes mnemonic and operands of the instruction at code to text, returns its size in halfwords.
+         * Instructions behind a VPST get the T suffix, the state of the block is kept between the calls (see reset).
+         *
+         * @param halfwords available halfwords at code, a 32-bit instruction which is cut off is printed as .short
+         * @param offset byte offset of the instruction, for the branch targets
+         */
+        uint8_t decode(Instructions::Instruction16 const * code, uint32_t halfwords, uint32_t offset, char * text, uint32_t size);
+
+        /**
+         * @brief Prints one line per instruction: offset, halfwords, mnemonic and operands. The annotations at an offset are
+         * printed in front of it, the halfwords of a data entry as .word.
+         *
+         * @param annotations offsets relative to code, may be nullptr
+         * @param writer gets every line including the line break, write() by default
+         */
+        void print(Instructions::Instruction16 const * code, uint32_t halfwords, Annotations const * annotations = nullptr, Writer writer = write, void * context = nullptr);
+
+        /// @brief Forgets an open VPT block
+        void reset() {
+            predicated = 0;
+        }
+
+        /// @brief RTT channel 0 on the target, stdout on the host
+        static void write(void * context, char const * text);
+
+    private:
+        uint8_t predicated = 0; // instructions left in the current VPT block
+};
+
+#endif // JIT_DISASSEMBLER_HPP
@@ -0,0 +1,520 @@
+#include "CycleEstimator.hpp"
+#include "instructions/Base.hpp"
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+using namespace JIT;
+using namespace JIT::Instructions;
+
+/*
+The instructions are classified by the same masks as in the Emulator, only the registers they read and write and the
+unit which executes them are kept. Encodings which are not known are single cycle scalar instructions without operands.
+*/
+
+namespace {
+    enum Unit : uint8_t {
+        UNIT_INTEGER = 0, // vector integer ALU, moves and predication
+        UNIT_MULTIPLY, // vector integer multiply
+        UNIT_FLOAT,
+        UNIT_LOAD, // only as producer of a vector register, the vector memory accesses use the load/store unit
+        UNIT_NONE,
+    };
+
+    constexpr uint16_t P0 = 1 << 8; // bit of VPR.P0 in the vector register masks
+
+    struct Operation {
+        Unit unit = UNIT_NONE;
+        uint8_t occupancy = 1; // cycles on the vector unit or the load/store unit
+        uint8_t issueCycles = 1; // issue slots, more than one for the multi register loads and stores
+        uint8_t resultLatency = 1; // of the general-purpose registers in defs
+        uint16_t defs = 0;
+        uint16_t writeBackDefs = 0; // base registers which are updated by the address generation (latency one)
+        uint16_t uses = 0;
+        uint16_t vectorDefs = 0;
+        uint16_t vectorUses = 0;
+        uint16_t accumulatorUses = 0; // accumulator of a FMA, read late
+        bool memory = false;
+        bool vectorMemory = false;
+        bool branch = false; // may change the control flow
+        bool loopStart = false;
+        bool loopEnd = false;
+        bool setsFlags = false;
+        bool readsFlags = false;
+        uint8_t flopsPerLane = 0;
+        uint8_t elementBytes = 4;
+    };
+
+    uint16_t bit(uint32_t reg) {
+        return static_cast<uint16_t>(1U << reg);
+    }
+
+    // multi register loads and stores move two words per cycle
+    void stack(Operation & op, uint32_t words) {
+        op.memory = true;
+        op.occupancy = static_cast<uint8_t>(1 + (words + 1) / 2);
+        op.issueCycles = op.occupancy;
+    }
+
+    Operation classify16(uint16_t instruction) {
+        Operation op;
+        uint8_t const low = instruction & 0x7;
+        uint8_t const middle = (instruction >> 3) & 0x7;
+        uint8_t const high = (instruction >> 8) & 0x7;
+
+        if (instruction < 0x1800) { // LSL/LSR/ASR Rd, Rm, #imm5
+            op.uses = bit(middle);
+            op.defs = bit(low);
+            op.setsFlags = true;
+        } else if (instruction < 0x2000) { // ADDS/SUBS Rd, Rn, Rm and #imm3
+            op.uses = bit(middle) | ((instruction & 0x0400) == 0 ? bit((instruction >> 6) & 0x7) : 0);
+            op.defs = bit(low);
+            op.setsFlags = true;
+        } else if (instruction < 0x4000) { // MOVS/CMP/ADDS/SUBS Rdn, #imm8
+            uint8_t const opcode = (instruction >> 11) & 0x3;
+            if (opcode != 0) op.uses = bit(high);
+            if (opcode != 1) op.defs = bit(high);
+            op.setsFlags = true;
+        } else if (instruction < 0x4400) { // data processing (register)
+            uint8_t const opcode = (instruction >> 6) & 0xf;
+            op.uses = bit(low) | bit(middle);
+            if (opcode != 0x8 && opcode != 0xa && opcode != 0xb) op.defs = bit(low); // not TST/CMP/CMN
+            op.setsFlags = true;
+            op.readsFlags = opcode == 0x5 || opcode == 0x6; // ADC/SBC
+        } else if (instruction < 0x4800) { // ADD/CMP/MOV with high registers, BX/BLX
+            uint8_t const rdn = ((instruction >> 7) & 0x1) << 3 | low;
+            uint8_t const rm = (instruction >> 3) & 0xf;
+            uint8_t const opcode = (instruction >> 8) & 0x3;
+            if (opcode == 3) {
+                op.uses = bit(rm);
+                op.branch = true;
+            } else {
+                op.uses = bit(rm) | (opcode != 2 ? bit(rdn) : 0);
+                if (opcode == 1) op.setsFlags = true;
+                else if (rdn == PC) op.branch = true;
+                else op.defs = bit(rdn);
+            }
+        } else if (instruction < 0x5000) { // LDR Rt, [PC, #imm8]
+            op.defs = bit(high);
+            op.memory = true;
+            op.resultLatency = CycleEstimator::SCALAR_LOAD_LATENCY;
+        } else if (instruction < 0x9000) { // LDR/STR with register offset or imm5
+            bool const registerOffset = instruction < 0x6000;
+            bool const load = registerOffset ? ((instruction >> 9) & 0x7) >= 3 : (instruction & 0x0800) != 0;
+            op.uses = bit(middle) | (registerOffset ? bit((instruction >> 6) & 0x7) : 0) | (load ? 0 : bit(low));
+            if (load) op.defs = bit(low);
+            op.memory = true;
+            op.resultLatency = CycleEstimator::SCALAR_LOAD_LATENCY;
+        } else if (instruction < 0xa000) { // LDR/STR Rt, [SP, #imm8]
+            bool const load = (instruction & 0x0800) != 0;
+            op.uses = bit(SP) | (load ? 0 : bit(high));
+            if (load) op.defs = bit(high);
+            op.memory = true;
+            op.resultLatency = CycleEstimator::SCALAR_LOAD_LATENCY;
+        } else if (instruction < 0xb000) { // ADR, ADD Rd, SP, #imm8
+            op.uses = (instruction & 0x0800) != 0 ? bit(SP) : 0;
+            op.defs = bit(high);
+        } else if ((instruction & 0xff00) == 0xb000) { // ADD/SUB SP, SP, #imm7
+            op.uses = bit(SP);
+            op.defs = bit(SP);
+        } else if ((instruction & 0xf500) == 0xb100) { // CBZ/CBNZ
+            op.uses = bit(low);
+            op.branch = true;
+        } else if ((instruction & 0xfe00) == 0xb400) { // PUSH {registers}
+            uint16_t const list = (instruction & 0xff) | ((instruction & 0x0100) != 0 ? bit(LR) : 0);
+            op.uses = list | bit(SP);
+            op.defs = bit(SP);
+            stack(op, std::popcount(list));
+        } else if ((instruction & 0xfe00) == 0xbc00) { // POP {registers}
+            uint16_t const list = (instruction & 0xff) | ((instruction & 0x0100) != 0 ? bit(PC) : 0);
+            op.uses = bit(SP);
+            op.defs = (list & ~bit(PC)) | bit(SP);
+            op.branch = (list & bit(PC)) != 0;
+            op.resultLatency = CycleEstimator::SCALAR_LOAD_LATENCY;
+            stack(op, std::popcount(list));
+        } else if ((instruction & 0xf000) == 0xd000) { // B<c>, UDF, SVC
+            op.branch = ((instruction >> 8) & 0xf) < AL;
+            op.readsFlags = op.branch;
+        } else if ((instruction & 0xf800) == 0xe000) { // B
+            op.branch = true;
+        }
+        return op;
+    }
+
+    void vectorInstruction(Operation & op, Unit unit, uint16_t defs, uint16_t uses) {
+        op.unit = unit;
+        op.occupancy = CycleEstimator::VECTOR_OCCUPANCY;
+        op.vectorDefs = defs;
+        op.vectorUses = uses;
+    }
+
+    void classifyVector(uint32_t instruction, Operation & op) {
+        uint16_t const qd = bit((instruction >> 13) & 0x7);
+        uint16_t const qn = bit((instruction >> 17) & 0x7);
+        uint16_t const qm = bit((instruction >> 1) & 0x7);
+        uint8_t const rn = (instruction >> 16) & 0xf;
+        uint8_t const rm = instruction & 0xf;
+
+        if ((instruction & 0xffbf'1fff) == 0xfe31'0f4d) { // VPST
+            op.vectorUses = P0;
+        } else if ((instruction & 0xffc0'ffff) == 0xf000'e801) { // VCTP
+            vectorInstruction(op, UNIT_INTEGER, P0, 0);
+            op.occupancy = 1;
+            op.uses = bit(rn);
+        } else if ((instruction & 0xfff0'1ff1) == 0xfc90'0f41) { // VLDRW.U32 Qd, [Rn, Qm, UXTW #2]
+            vectorInstruction(op, UNIT_NONE, qd, qm);
+            op.occupancy = CycleEstimator::GATHER_OCCUPANCY;
+            op.uses = bit(rn);
+            op.memory = true;
+            op.vectorMemory = true;
+        } else if ((instruction & 0xffe0'1fe0) == 0xec00'0f00) { // VMOV between two lanes and two general-purpose registers
+            vectorInstruction(op, UNIT_INTEGER, 0, qd);
+            op.occupancy = 1;
+            if ((instruction & 0x0010'0000) != 0) {
+                op.vectorDefs = qd;
+                op.uses = bit(rm) | bit(rn);
+            } else {
+                op.defs = bit(rm) | bit(rn);
+                op.resultLatency = CycleEstimator::VECTOR_OCCUPANCY;
+            }
+        } else if ((instruction & 0xee00'0000) == 0xec00'0000) { // contiguous, widening and narrowing loads and stores
+            bool const widening = ((instruction >> 9) & 0xf) == 0x7;
+            uint8_t const base = widening ? rn & 0x7 : rn;
+            bool const load = (instruction & 0x0010'0000) != 0;
+            vectorInstruction(op, UNIT_NONE, load ? qd : 0, load ? 0 : qd);
+            op.uses = bit(base);
+            if ((instruction & 0x0020'0000) != 0) op.writeBackDefs = bit(base);
+            op.memory = true;
+            op.vectorMemory = true;
+        } else if ((instruction & 0xffe0'0f7f) == 0xee00'0a10) { // VMOV Sn, Rt and VMOV Rt, Sn
+            uint16_t const q = bit((((instruction >> 16) & 0xf) << 1 | ((instruction >> 7) & 0x1)) / 4);
+            uint8_t const rt = (instruction >> 12) & 0xf;
+            vectorInstruction(op, UNIT_INTEGER, 0, q);
+            op.occupancy = 1;
+            if ((instruction & 0x0010'0000) != 0) {
+                op.defs = bit(rt);
+                op.resultLatency = CycleEstimator::VECTOR_OCCUPANCY;
+            } else {
+                op.vectorDefs = q;
+                op.uses = bit(rt);
+            }
+        } else if ((instruction & 0xfff1'0fff) == 0xeea0'0b10) { // VDUP.32 Qd, Rt (Qd in the bits of Qn)
+            vectorInstruction(op, UNIT_INTEGER, qn, 0);
+            op.uses = bit((instruction >> 12) & 0xf);
+        } else if ((instruction & 0xeff8'10f0) == 0xef80'0050) { // VMOV Qd, #imm8
+            vectorInstruction(op, UNIT_INTEGER, qd, 0);
+        } else if ((instruction & 0xffd1'1ff1) == 0xef00'0150) { // VORR/VAND
+            vectorInstruction(op, UNIT_INTEGER, qd, qn | qm);
+        } else if ((instruction & 0xefff'0ff1) == 0xee3f'0e01) { // VCVTB/VCVTT, the other half of Qd is kept
+            vectorInstruction(op, UNIT_FLOAT, qd, qd | qm);
+        } else if ((instruction & 0xffc1'1f7e) == 0xee01'0f6e) { // VIDUP
+            vectorInstruction(op, UNIT_INTEGER, qd, 0);
+            op.uses = bit(((instruction >> 17) & 0x7) << 1);
+            op.defs = op.uses;
+        } else if ((instruction & 0xfff1'1fd1) == 0xeef0'0f00) { // VMLADAV{A}.S8 Rda, Qn, Qm
+            uint8_t const rda = ((instruction >> 13) & 0x7) << 1;
+            vectorInstruction(op, UNIT_MULTIPLY, 0, qn | qm);
+            op.uses = (instruction & 0x20) != 0 ? bit(rda) : 0;
+            op.defs = bit(rda);
+            op.resultLatency = CycleEstimator::VECTOR_OCCUPANCY + 1;
+        } else if ((instruction & 0xeff1'1ff0) == 0xee31'0e40 || (instruction & 0xeff1'1ff0) == 0xee31'0e60
+            || (instruction & 0xeff1'1ff0) == 0xee30'0f40) { // VFMA/VMUL/VADD.F<size> Qd, Qn, Rm
+            bool const fma = (instruction & 0xeff1'1ff0) == 0xee31'0e40;
+            vectorInstruction(op, UNIT_FLOAT, qd, qn);
+            if (fma) op.accumulatorUses = qd;
+            op.uses = bit(rm);
+            op.flopsPerLane = fma ? 2 : 1;
+            op.elementBytes = (instruction & 0x1000'0000) != 0 ? 2 : 4;
+        } else if ((instruction & 0xffe1'1ff1) == 0xef00'0c50 || (instruction & 0xffe1'1ff1) == 0xef00'0d40
+            || (instruction & 0xffc1'1ff1) == 0xff00'0f50) { // VFMA/VADD/VMAXNM/VMINNM.F<size> Qd, Qn, Qm
+            bool const fma = (instruction & 0xffe1'1ff1) == 0xef00'0c50;
+            vectorInstruction(op, UNIT_FLOAT, qd, qn | qm);
+            if (fma) op.accumulatorUses = qd;
+            op.flopsPerLane = fma ? 2 : 1;
+            op.elementBytes = (instruction & 0x0010'0000) != 0 ? 2 : 4;
+        } else if ((instruction & 0xffc1'1ff0) == 0xee01'1e60) { // VMUL.I<size> Qd, Qn, Rm
+            vectorInstruction(op, UNIT_MULTIPLY, qd, qn);
+            op.uses = bit(rm);
+        } else if ((instruction & 0xffc1'1ff1) == 0xff00'0b40) { // VQRDMULH
+            vectorInstruction(op, UNIT_MULTIPLY, qd, qn | qm);
+        } else if ((instruction & 0xffc1'1ff0) == 0xee01'0f40) { // VADD.I<size> Qd, Qn, Rm
+            vectorInstruction(op, UNIT_INTEGER, qd, qn);
+            op.uses = bit(rm);
+        } else if ((instruction & 0xefc1'1ff1) == 0xef00'0840 || (instruction & 0xffc1'1fe1) == 0xef00'0640
+            || (instruction & 0xfff1'1ef1) == 0xef20'0440 || (instruction & 0xffc1'1ff1) == 0xef00'0050) { // VADD/VSUB.I, VMAX/VMIN.S, VSHL/VRSHL (register), VQADD
+            vectorInstruction(op, UNIT_INTEGER, qd, qn | qm);
+        } else if ((instruction & 0xffe0'1ff1) == 0xefa0'0550 || (instruction & 0xffe0'1df1) == 0xefa0'0050) { // VSHL/VSHR/VRSHR #imm
+            vectorInstruction(op, UNIT_INTEGER, qd, qm);
+        }
+    }
+
+    Operation classify32(uint32_t instruction) {
+        Operation op;
+        uint8_t const rn = (instruction >> 16) & 0xf;
+        uint8_t const rt = (instruction >> 12) & 0xf;
+        uint8_t const rd = (instruction >> 8) & 0xf;
+        uint8_t const rm = instruction & 0xf;
+        bool const setFlags = (instruction & 0x0010'0000) != 0;
+
+        if (instruction == Base::nop32()) {
+            return op;
+        }
+        if ((instruction & 0xffff'0000) == 0xe92d'0000) { // PUSH.W
+            op.uses = (instruction & 0xffff) | bit(SP);
+            op.defs = bit(SP);
+            stack(op, std::popcount(instruction & 0xffff));
+        } else if ((instruction & 0xffff'0000) == 0xe8bd'0000) { // POP.W
+            op.uses = bit(SP);
+            op.defs = (instruction & 0x7fff) | bit(SP);
+            op.branch = (instruction & bit(PC)) != 0;
+            op.resultLatency = CycleEstimator::SCALAR_LOAD_LATENCY;
+            stack(op, std::popcount(instruction & 0xffff));
+        } else if ((instruction & 0xfebf'0f00) == 0xec2d'0b00 || (instruction & 0xfebf'0f00) == 0xecbd'0b00) { // VPUSH/VPOP
+            uint8_t const first = ((instruction >> 22) & 0x1) << 4 | ((instruction >> 12) & 0xf);
+            uint16_t registers = 0;
+            for (uint8_t d = first; d < first + (instruction & 0xff) / 2 && d < 16; d++) registers |= bit(d / 2);
+            op.uses = bit(SP);
+            op.defs = bit(SP);
+            if ((instruction & 0x0080'0000) == 0) op.vectorUses = registers;
+            else op.vectorDefs = registers;
+            stack(op, instruction & 0xff);
+        } else if ((instruction & 0xff80'ffff) == 0xf000'e001) { // DLS/DLSTP
+            op.uses = bit(rn);
+            op.defs = bit(LR);
+            op.loopStart = true;
+        } else if ((instruction & 0xffef'f001) == 0xf00f'c001) { // LE/LETP
+            op.uses = bit(LR);
+            op.defs = bit(LR);
+            op.branch = true;
+            op.loopEnd = true;
+        } else if ((instruction & 0xff80'f001) == 0xf000'c001) { // WLS/WLSTP
+            op.uses = bit(rn);
+            op.defs = bit(LR);
+            op.branch = true;
+            op.loopStart = true;
+        } else if ((instruction & 0xf800'd000) == 0xf000'9000) { // B.W
+            op.branch = true;
+        } else if ((instruction & 0xf800'd000) == 0xf000'8000 && ((instruction >> 22) & 0xf) < AL) { // B<c>.W
+            op.branch = true;
+            op.readsFlags = true;
+        } else if ((instruction & 0xfbf0'8000) == 0xf240'0000) { // MOVW
+            op.defs = bit(rd);
+        } else if ((instruction & 0xfbf0'8000) == 0xf2c0'0000) { // MOVT
+            op.uses = bit(rd);
+            op.defs = bit(rd);
+        } else if ((instruction & 0xfbf0'8000) == 0xf200'0000 || (instruction & 0xfbf0'8000) == 0xf2a0'0000) { // ADDW/SUBW
+            op.uses = bit(rn);
+            op.defs = bit(rd);
+        } else if ((instruction & 0xfbf0'8f00) == 0xf1b0'0f00) { // CMP Rn, #constant
+            op.uses = bit(rn);
+            op.setsFlags = true;
+        } else if ((instruction & 0xfbe0'8000) == 0xf000'0000) { // AND(S)/TST #constant
+            op.uses = bit(rn);
+            if (rd != PC || !setFlags) op.defs = bit(rd);
+            op.setsFlags = setFlags;
+        } else if ((instruction & 0xffef'8000) == 0xea4f'0000) { // MOV(S).W Rd, Rm{, shift}
+            op.uses = bit(rm);
+            op.defs = bit(rd);
+            op.setsFlags = setFlags;
+        } else if ((instruction & 0xffe0'8000) == 0xeb00'0000 || (instruction & 0xffe0'8000) == 0xeba0'0000) { // ADD/SUB(S).W, CMP/CMN
+            op.uses = bit(rn) | bit(rm);
+            if (rd != PC || !setFlags) op.defs = bit(rd);
+            op.setsFlags = setFlags;
+        } else if ((instruction & 0xfff0'f0f0) == 0xfb00'f000) { // MUL
+            op.uses = bit(rn) | bit(rm);
+            op.defs = bit(rd);
+        } else if ((instruction & 0xff7f'0000) == 0xf85f'0000) { // LDR Rt, [PC, #+/-imm12]
+            op.defs = bit(rt);
+            op.memory = true;
+            op.resultLatency = CycleEstimator::SCALAR_LOAD_LATENCY;
+        } else if ((instruction & 0xfe00'0000) == 0xf800'0000 && (instruction & 0x0100'0000) == 0) { // LDR/STR (immediate and register), PLD
+            bool const load = (instruction & 0x0010'0000) != 0;
+            bool const t4 = (instruction & 0x0080'0000) == 0 && (instruction & 0x0800) != 0;
+            bool const registerOffset = (instruction & 0x0080'0000) == 0 && (instruction & 0x0fc0) == 0;
+            op.uses = bit(rn) | (registerOffset ? bit(rm) : 0) | (load ? 0 : bit(rt));
+            if (load && rt != PC) op.defs = bit(rt);
+            if (t4 && (instruction & 0x0100) != 0) op.writeBackDefs = bit(rn);
+            op.branch = load && rt == PC && ((instruction >> 21) & 0x3) == 2;
+            op.memory = true;
+            op.resultLatency = CycleEstimator::SCALAR_LOAD_LATENCY;
+        } else {
+            classifyVector(instruction, op);
+        }
+        return op;
+    }
+
+    uint8_t activeLanes(uint16_t lanes, uint8_t elementBytes) {
+        uint8_t count = 0;
+        for (uint8_t byte = 0; byte < 16; byte += elementBytes) count += (lanes >> byte) & 1;
+        return count;
+    }
+}
+
+Emulator::Status CycleEstimator::run(Emulator & emulator, uint32_t entry, uint32_t r0, uint32_t r1, uint32_t r2, uint64_t maxSteps) {
+    reset();
+    emulator.setObserver(observe, this);
+    Emulator::Status const status = emulator.call(entry, r0, r1, r2, maxSteps);
+    emulator.setObserver(nullptr, nullptr);
+    return status;
+}
+
+void CycleEstimator::reset() {
+    InstructionStatistics * const keepStatistics = statistics;
+    uint32_t const keepHalfwords = halfwords;
+    *this = CycleEstimator(codeAddress, keepStatistics, keepHalfwords);
+    if (statistics != nullptr) std::memset(statistics, 0, halfwords * sizeof(InstructionStatistics));
+}
+
+void CycleEstimator::observe(void * context, Emulator::Step const & step) {
+    static_cast<CycleEstimator *>(context)->step(step);
+}
+
+CycleEstimator::InstructionStatistics const * CycleEstimator::getStatistics(uint32_t address) const {
+    if (statistics == nullptr || address < codeAddress || (address - codeAddress) / 2 >= halfwords) return nullptr;
+    return &statistics[(address - codeAddress) / 2];
+}
+
+CycleEstimator::InstructionStatistics * CycleEstimator::find(uint32_t address) {
+    return const_cast<InstructionStatistics *>(getStatistics(address));
+}
+
+char const * CycleEstimator::getStallReasonName(StallReason reason) {
+    switch (reason) {
+        case FETCH: return "fetch";
+        case BRANCH: return "branch";
+        case SCALAR_RESULT: return "scalar result";
+        case LOAD_STORE_UNIT: return "load/store unit";
+        case VECTOR_UNIT: return "vector unit";
+        case LOAD_FP_INTERLOCK: return "load/FP interlock";
+        case VECTOR_RESULT: return "vector result";
+        default: return "unknown";
+    }
+}
+
+uint64_t CycleEstimator::fetchReady(uint32_t address) const {
+    uint32_t const word = address / 4;
+    uint32_t const first = fetchAddress / 4;
+    return word < first ? fetchCycle : fetchCycle + (word - first);
+}
+
+void CycleEstimator::redirect(uint64_t cycle, uint32_t address, bool branch) {
+    fetchCycle = cycle;
+    fetchAddress = address;
+    fetchAfterBranch = branch;
+}
+
+void CycleEstimator::step(Emulator::Step const & step) {
+    Operation const op = step.halfwords == 1 ? classify16(static_cast<uint16_t>(step.encoding)) : classify32(step.encoding);
+    InstructionStatistics * const entry = find(step.address);
+    if (entry != nullptr) entry->executions++;
+    estimate.instructions++;
+    if (op.flopsPerLane != 0) estimate.flops += op.flopsPerLane * activeLanes(step.lanes, op.elementBytes);
+    if (!started) {
+        started = true;
+        redirect(0, step.address, false);
+    }
+    bool const taken = step.next != step.address + 2 * step.halfwords;
+
+    // after the first iteration the loop cache continues with the start of the body (or after the loop), LE isn't issued
+    if (op.loopEnd && loopCached && loopEndAddress == step.address) {
+        redirect(fetchReady(step.address - 2) + 1, step.next, false);
+        return;
+    }
+
+    /* the earliest cycle in which all operands and units are available, and which of them is the last one */
+    uint64_t ready = 0;
+    StallReason reason = FETCH;
+    auto require = [&](uint64_t cycle, StallReason why) {
+        if (cycle > ready) {
+            ready = cycle;
+            reason = why;
+        }
+    };
+    uint32_t const last = step.address + 2 * step.halfwords - 2;
+    require(fetchReady(last), fetchAfterBranch && last / 4 == fetchAddress / 4 ? BRANCH : FETCH);
+    for (uint8_t reg = 0; reg < 16; reg++) {
+        if ((op.uses >> reg) & 1) require(registerReady[reg], registerFromVector[reg] ? VECTOR_RESULT : SCALAR_RESULT);
+    }
+    // a conditional branch dual issues with the compare in front of it
+    bool const fusedCompare = pairOpen && pairSetsFlags && op.branch && step.halfwords == 1;
+    if (op.readsFlags && !fusedCompare) require(flagsReady, SCALAR_RESULT);
+    uint16_t const vectorUses = op.vectorUses | op.accumulatorUses;
+    for (uint8_t reg = 0; reg < 9; reg++) {
+        if (((vectorUses >> reg) & 1) == 0) continue;
+        uint8_t const producer = vectorProducer[reg];
+        if (producer == UNIT_LOAD) {
+            bool const interlock = op.unit == UNIT_FLOAT || op.unit == UNIT_MULTIPLY;
+            require(vectorStart[reg] + (interlock ? 2 : 1), interlock ? LOAD_FP_INTERLOCK : VECTOR_RESULT);
+        } else if (producer == UNIT_FLOAT) {
+            bool const accumulator = ((op.accumulatorUses >> reg) & 1) != 0 && ((op.vectorUses >> reg) & 1) == 0;
+            require(vectorStart[reg] + (accumulator ? ACCUMULATE_LATENCY : FLOAT_LATENCY), VECTOR_RESULT);
+        } else {
+            require(vectorStart[reg] + (producer == UNIT_MULTIPLY ? MULTIPLY_LATENCY : 1), VECTOR_RESULT);
+        }
+    }
+    if (op.memory) require(loadStoreFree, LOAD_STORE_UNIT);
+    bool const vector = op.unit != UNIT_NONE || op.vectorMemory;
+    if (op.unit != UNIT_NONE) require(vectorUnitFree[op.unit], VECTOR_UNIT);
+    if (vector) require(vectorEnd[0], VECTOR_UNIT);
+
+    /* dual issue with the previous 16-bit instruction, otherwise the next issue slot */
+    bool const dual = pairOpen && step.halfwords == 1 && op.issueCycles == 1 && ready <= lastIssue
+        && (op.uses & pairDefs) == 0 && (op.defs & (pairDefs | pairUses)) == 0 && !(op.memory && pairMemory)
+        && (!op.readsFlags || fusedCompare);
+    uint64_t issue = lastIssue;
+    if (!dual) {
+        issue = ready > nextIssue ? ready : nextIssue;
+        uint64_t const stall = issue - nextIssue;
+        if (stall > 0) {
+            estimate.stalls[reason] += stall;
+            if (entry != nullptr) entry->stalls[reason] += stall;
+        }
+    } else {
+        estimate.dualIssued++;
+        if (entry != nullptr) entry->dualIssued++;
+    }
+
+    /* results and units */
+    for (uint8_t reg = 0; reg < 16; reg++) {
+        if ((op.defs >> reg) & 1) {
+            registerReady[reg] = issue + op.resultLatency;
+            registerFromVector[reg] = vector;
+        } else if ((op.writeBackDefs >> reg) & 1) {
+            registerReady[reg] = issue + 1;
+            registerFromVector[reg] = false;
+        }
+    }
+    if (op.setsFlags) flagsReady = issue + 1;
+    for (uint8_t reg = 0; reg < 9; reg++) {
+        if ((op.vectorDefs >> reg) & 1) {
+            vectorStart[reg] = issue;
+            vectorProducer[reg] = op.vectorMemory ? UNIT_LOAD : op.unit;
+        }
+    }
+    uint64_t const end = issue + op.occupancy;
+    if (op.memory) loadStoreFree = end;
+    if (op.unit != UNIT_NONE) vectorUnitFree[op.unit] = end;
+    if (vector) {
+        vectorEnd[0] = vectorEnd[1];
+        vectorEnd[1] = end;
+    }
+    if (end > completion) completion = end;
+
+    lastIssue = issue;
+    nextIssue = issue + op.issueCycles;
+    pairOpen = !dual && step.halfwords == 1 && op.issueCycles == 1 && !op.branch;
+    pairDefs = op.defs | op.writeBackDefs;
+    pairUses = op.uses;
+    pairMemory = op.memory;
+    pairSetsFlags = op.setsFlags;
+
+    /* control flow */
+    if (op.loopStart) loopCached = false;
+    if (op.loopEnd && taken) {
+        loopCached = true;
+        loopEndAddress = step.address;
+    }
+    if (taken) redirect(nextIssue - 1 + BRANCH_REDIRECT, step.next, true);
+    if (nextIssue > completion) completion = nextIssue;
+    estimate.cycles = completion;
+}
@@ -0,0 +1,138 @@
+#ifndef JIT_CYCLE_ESTIMATOR_HPP
+#define JIT_CYCLE_ESTIMATOR_HPP
+#pragma once
+#include <cstdint>
+#include "../instructions/Base.hpp"
+#include "Emulator.hpp"
+
+namespace JIT {
+    class CycleEstimator;
+}
+
+/**
+ * @brief Estimates the cycles of a kernel on the Cortex-M55 from the instructions the Emulator executes, so candidates
+ * (e.g. of the GemmTuner) can be compared on the host before they are timed on the board.
+ *
+ * The control flow (loop counts, taken branches, predicated lanes) is exact as it comes from the emulator, the timing
+ * is a static model of the in-order pipeline:
+ * - Fetch: one word per cycle. A taken branch fetches its target two cycles after it issued. The end of a low overhead
+ *   loop is only executed in the first iteration (and after DLS/WLS), afterwards the loop cache jumps to the start directly
+ *   after the last word of the body was fetched, so a body which starts unaligned needs an additional fetch cycle.
+ * - Issue: one instruction per cycle. Two independent 16-bit instructions dual issue (at most one of them a memory access,
+ *   a compare with the following conditional branch), 32-bit instructions never do.
+ * - Beat overlap: MVE instructions execute two beats per cycle, i.e. a 128-bit instruction occupies its unit (load/store,
+ *   integer, multiply or floating point) for two cycles. An instruction on another unit can start one cycle later, at most
+ *   two vector instructions are in flight. Scalar loads and stores share the load/store unit with the vector memory accesses.
+ * - Interlocks: integer vector instructions consume the beats of their operands as they are produced, floating point and
+ *   multiply instructions can't consume the beats of a vector load (one cycle) and floating point results have a latency
+ *   of three cycles. The accumulator of a FMA is read late, so chained FMAs into the same register don't stall.
+ *   Scalar loads have a load-use penalty of one cycle.
+ *
+ * With the constants below the model reproduces the micro benchmarks in results/branch_operations (LOB, backward and
+ * forward branches) and the aligned and unaligned loop bodies of lob_alignment. Memory wait states are not modelled, the
+ * estimate assumes that code and operands are in the TCMs.
+ */
+class JIT::CycleEstimator {
+    public:
+        static constexpr uint8_t BRANCH_REDIRECT = 2; // cycles from a taken branch to the fetch of its target
+        static constexpr uint8_t VECTOR_OCCUPANCY = 2; // cycles of a 128-bit vector instruction on its unit
+        static constexpr uint8_t GATHER_OCCUPANCY = 4; // one word per cycle
+        static constexpr uint8_t FLOAT_LATENCY = 3;
+        static constexpr uint8_t ACCUMULATE_LATENCY = 2; // floating point result to the accumulator of a FMA
+        static constexpr uint8_t MULTIPLY_LATENCY = 2;
+        static constexpr uint8_t SCALAR_LOAD_LATENCY = 2;
+
+        enum StallReason : uint8_t {
+            FETCH = 0, // the instruction wasn't fetched yet (unaligned loop bodies, fetch after a taken branch)
+            BRANCH, // first word after a taken branch
+            SCALAR_RESULT, // operand or flags from a scalar instruction (load-use)
+            LOAD_STORE_UNIT, // memory interface busy with a previous load or store
+            VECTOR_UNIT, // beats of the previous instruction on the same vector unit or two vector instructions in flight
+            LOAD_FP_INTERLOCK, // floating point or multiply instruction reads the result of a vector load
+            VECTOR_RESULT, // operand from a vector instruction which has not been computed yet
+            STALL_REASON_COUNT,
+        };
+
+        struct InstructionStatistics {
+            uint32_t executions;
+            uint32_t dualIssued; // executions which issued together with the previous instruction
+            uint32_t stalls[STALL_REASON_COUNT]; // cycles the instruction issued later than the previous one allowed
+        };
+
+        struct Estimate {
+            uint64_t cycles; // from the first issue until the last instruction has completed
+            uint64_t instructions; // executed instructions, including the loop ends handled by the loop cache
+            uint64_t dualIssued;
+            uint64_t flops; // floating point operations of the active lanes, a FMA counts twice
+            uint64_t stalls[STALL_REASON_COUNT];
+
+            float getFlopsPerCycle() const {
+                return cycles == 0 ? 0.0f : static_cast<float>(flops) / static_cast<float>(cycles);
+            }
+        };
+
+        /**
+         * @param codeAddress emulated address of the code, statistics[i] counts the instruction at codeAddress + 2 * i
+         * @param statistics per instruction breakdown, may be nullptr. Instructions outside of it are only part of the Estimate
+         * @param halfwords entries of statistics
+         */
+        CycleEstimator(uint32_t codeAddress = 0, InstructionStatistics * statistics = nullptr, uint32_t halfwords = 0)
+            : codeAddress(codeAddress), statistics(statistics), halfwords(halfwords) {}
+
+        /// @brief Emulator::call with the estimator as observer, the estimate and the statistics start from zero
+        Emulator::Status run(Emulator & emulator, uint32_t entry, uint32_t r0 = 0, uint32_t r1 = 0, uint32_t r2 = 0, uint64_t maxSteps = 100'000'000);
+
+        /// @brief Clears the estimate, the statistics and the pipeline state
+        void reset();
+        /// @brief Adds an executed instruction, the observer of Emulator::setObserver (context is the estimator)
+        static void observe(void * context, Emulator::Step const & step);
+
+        Estimate const & getEstimate() const {
+            return estimate;
+        }
+        /// @brief Statistics of the instruction at address, nullptr if it is outside of the statistics
+        InstructionStatistics const * getStatistics(uint32_t address) const;
+        static char const * getStallReasonName(StallReason reason);
+
+    private:
+        uint32_t codeAddress;
+        InstructionStatistics * statistics;
+        uint32_t halfwords;
+        Estimate estimate = {};
+
+        /* pipeline state, times are cycles since the first issue */
+        uint64_t lastIssue = 0;
+        uint64_t nextIssue = 0; // earliest issue of the next instruction without stalls
+        uint64_t completion = 0;
+        bool started = false;
+        // fetch: the word at fetchAddress / 4 is available at fetchCycle, the following words one per cycle
+        uint64_t fetchCycle = 0;
+        uint32_t fetchAddress = 0;
+        bool fetchAfterBranch = false;
+        // the previous instruction if it may be the first of a dual issued pair
+        bool pairOpen = false;
+        uint16_t pairDefs = 0;
+        uint16_t pairUses = 0;
+        bool pairMemory = false;
+        bool pairSetsFlags = false;
+        // results
+        uint64_t registerReady[16] = {};
+        bool registerFromVector[16] = {};
+        uint64_t flagsReady = 0;
+        uint64_t vectorStart[9] = {}; // Q0-Q7 and VPR.P0
+        uint8_t vectorProducer[9] = {};
+        // units
+        uint64_t loadStoreFree = 0;
+        uint64_t vectorUnitFree[3] = {};
+        uint64_t vectorEnd[2] = {}; // completion of the last two vector instructions
+        // low overhead loop cache
+        uint32_t loopEndAddress = 0;
+        bool loopCached = false;
+
+        void step(Emulator::Step const & step);
+        uint64_t fetchReady(uint32_t address) const;
+        void redirect(uint64_t cycle, uint32_t address, bool branch);
+        InstructionStatistics * find(uint32_t address);
+};
+
+#endif // JIT_CYCLE_ESTIMATOR_HPP
@@ -0,0 +1,953 @@
+#include "Emulator.hpp"
+#include "instructions/Base.hpp"
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+using namespace JIT;
+using namespace JIT::Instructions;
+
+/*
+The decoder matches the encodings of the instruction classes by mask and value, the masks clear the operand fields.
+Registers and memory are little endian like the host, lanes are copied with memcpy.
+*/
+
+namespace {
+    float toFloat(uint32_t bits) {
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    uint32_t toBits(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    float halfToFloat(uint16_t half) {
+        uint32_t const sign = static_cast<uint32_t>(half & 0x8000) << 16;
+        uint32_t const exponent = (half >> 10) & 0x1f;
+        uint32_t const mantissa = half & 0x3ff;
+        if (exponent == 0x1f) {
+            return toFloat(sign | 0x7f80'0000 | mantissa << 13);
+        }
+        if (exponent == 0) { // zero and subnormals: mantissa * 2^-24
+            float const value = std::ldexp(static_cast<float>(mantissa), -24);
+            return sign != 0 ? -value : value;
+        }
+        return toFloat(sign | (exponent + 112) << 23 | mantissa << 13);
+    }
+
+    // round to nearest, ties to even
+    uint16_t floatToHalf(float value) {
+        uint32_t const bits = toBits(value);
+        uint16_t const sign = (bits >> 16) & 0x8000;
+        if (std::isnan(value)) {
+            return sign | 0x7e00;
+        }
+        float const magnitude = std::fabs(value);
+        if (magnitude >= 65520.0f) {
+            return sign | 0x7c00;
+        }
+        if (magnitude < std::ldexp(1.0f, -14)) { // subnormal, 1024 rounds to the smallest normal
+            return sign | static_cast<uint16_t>(std::nearbyint(std::ldexp(magnitude, 24)));
+        }
+        uint32_t half = (((bits >> 23) & 0xff) - 112) << 10 | (bits & 0x7f'ffff) >> 13;
+        uint32_t const rest = bits & 0x1fff;
+        if (rest > 0x1000 || (rest == 0x1000 && (half & 1) != 0)) {
+            half++; // a carry into the exponent is still correct
+        }
+        return sign | static_cast<uint16_t>(half);
+    }
+
+    uint32_t getLane(uint8_t const * vector, uint8_t lane, uint8_t bytes) {
+        uint32_t value = 0;
+        std::memcpy(&value, vector + lane * bytes, bytes);
+        return value;
+    }
+
+    void setLane(uint8_t * vector, uint8_t lane, uint8_t bytes, uint32_t value) {
+        std::memcpy(vector + lane * bytes, &value, bytes);
+    }
+
+    int32_t signExtend(uint32_t value, uint8_t bits) {
+        return bits >= 32 ? static_cast<int32_t>(value) : static_cast<int32_t>(value << (32 - bits)) >> (32 - bits);
+    }
+
+    float getFloat(uint8_t const * vector, uint8_t lane, bool half) {
+        return half ? halfToFloat(getLane(vector, lane, 2)) : toFloat(getLane(vector, lane, 4));
+    }
+
+    void setFloat(uint8_t * vector, uint8_t lane, bool half, float value) {
+        if (half) {
+            setLane(vector, lane, 2, floatToHalf(value));
+        } else {
+            setLane(vector, lane, 4, toBits(value));
+        }
+    }
+
+    // IEEE 754 maxNum/minNum
+    float maxNum(float a, float b, bool minimum) {
+        if (std::isnan(a)) return b;
+        if (std::isnan(b)) return a;
+        return minimum ? std::fmin(a, b) : std::fmax(a, b);
+    }
+
+    int64_t saturate(int64_t value, uint8_t bits) {
+        int64_t const maximum = (int64_t{1} << (bits - 1)) - 1;
+        return value > maximum ? maximum : (value < -maximum - 1 ? -maximum - 1 : value);
+    }
+
+    // VSHL/VRSHL (register) of a signed lane, negative amounts shift right
+    int64_t shiftLane(int64_t value, int8_t amount, bool rounding) {
+        if (amount >= 0) {
+            return amount >= 64 ? 0 : static_cast<int64_t>(static_cast<uint64_t>(value) << amount);
+        }
+        uint8_t const right = amount < -63 ? 63 : -amount;
+        int64_t const roundingValue = rounding ? (value >> (right - 1)) & 1 : 0;
+        return (value >> right) + roundingValue;
+    }
+
+    enum FloatOperation : uint8_t {
+        FLOAT_FMA, FLOAT_MUL, FLOAT_ADD, FLOAT_MAX, FLOAT_MIN, FLOAT_NONE,
+    };
+
+    enum IntegerOperation : uint8_t {
+        INTEGER_ADD, INTEGER_SUB, INTEGER_MUL, INTEGER_MAX, INTEGER_MIN, INTEGER_QRDMULH, INTEGER_QADD, INTEGER_SHL, INTEGER_RSHL, INTEGER_NONE,
+    };
+}
+
+Emulator::Emulator() {
+    map(STACK_TOP - STACK_BYTES, stack, STACK_BYTES);
+}
+
+bool Emulator::map(uint32_t address, void * memory, uint32_t bytes) {
+    if (regionCount == MAX_REGIONS) {
+        Base::printValidationError("Emulator::map: all regions are used - returning false");
+        return false;
+    }
+    if (static_cast<uint64_t>(address) + bytes > UINT64_C(1) << 32) {
+        Base::printValidationError("Emulator::map: region exceeds the address space - returning false");
+        return false;
+    }
+    for (uint8_t i = 0; i < regionCount; i++) {
+        Region const & region = regions[i];
+        if (static_cast<uint64_t>(address) < static_cast<uint64_t>(region.address) + region.bytes && region.address < static_cast<uint64_t>(address) + bytes) {
+            Base::printValidationError("Emulator::map: region overlaps a mapped region - returning false");
+            return false;
+        }
+    }
+    regions[regionCount++] = {address, bytes, static_cast<uint8_t *>(memory)};
+    return true;
+}
+
+void Emulator::unmapAll() {
+    regionCount = 1; // the stack is always the first region
+}
+
+uint32_t Emulator::getVectorLane(VectorRegister reg, uint8_t lane) const {
+    return getLane(q[reg], lane, 4);
+}
+
+void Emulator::setVectorLane(VectorRegister reg, uint8_t lane, uint32_t value) {
+    setLane(q[reg], lane, 4, value);
+}
+
+Emulator::Status Emulator::call(uint32_t entry, uint32_t r0, uint32_t r1, uint32_t r2, uint64_t maxSteps) {
+    r[R0] = r0;
+    r[R1] = r1;
+    r[R2] = r2;
+    r[SP] = STACK_TOP;
+    r[LR] = RETURN_ADDRESS | 1;
+    r[PC] = entry & ~1U;
+    flags = {};
+    vptRemaining = 0;
+    loopElementSize = 4;
+    steps = 0;
+    faulted = false;
+    faultAddress = 0;
+
+    while (steps < maxSteps) {
+        uint32_t const pc = r[PC];
+        uint16_t const first = load(pc, 2);
+        if (faulted) return MEMORY_FAULT;
+        steps++;
+        blockMask = 0xffff;
+        if (vptRemaining > 0) {
+            blockMask = p0;
+            vptRemaining--;
+        }
+
+        Status status;
+        uint32_t next;
+        Step step = {pc, first, 0, predicate(), 1};
+        if ((first >> 11) >= 0b11101) { // 32-bit instruction, the first halfword holds the upper bits
+            uint32_t const instruction = static_cast<uint32_t>(first) << 16 | load(pc + 2, 2);
+            if (faulted) return MEMORY_FAULT;
+            next = pc + 4;
+            step.encoding = instruction;
+            step.halfwords = 2;
+            status = execute32(instruction, next);
+        } else {
+            next = pc + 2;
+            status = execute16(first, next);
+        }
+        if (faulted) return MEMORY_FAULT;
+        if (status == UNDEFINED_INSTRUCTION) faultAddress = pc;
+        if (observer != nullptr && (status == RUNNING || status == RETURNED)) {
+            step.next = next;
+            observer(observerContext, step);
+        }
+        if (status != RUNNING) return status;
+        r[PC] = next;
+    }
+    return STEP_LIMIT;
+}
+
+uint8_t * Emulator::translate(uint32_t address, uint32_t bytes) {
+    for (uint8_t i = 0; i < regionCount; i++) {
+        Region const & region = regions[i];
+        if (address >= region.address && static_cast<uint64_t>(address - region.address) + bytes <= region.bytes) {
+            return region.memory + (address - region.address);
+        }
+    }
+    return nullptr;
+}
+
+void Emulator::fault(uint32_t address) {
+    if (!faulted) faultAddress = address; // the first fault stops the execution
+    faulted = true;
+}
+
+uint32_t Emulator::load(uint32_t address, uint8_t bytes) {
+    uint8_t const * memory = translate(address, bytes);
+    if (memory == nullptr) {
+        fault(address);
+        return 0;
+    }
+    uint32_t value = 0;
+    std::memcpy(&value, memory, bytes);
+    return value;
+}
+
+void Emulator::store(uint32_t address, uint32_t value, uint8_t bytes) {
+    uint8_t * memory = translate(address, bytes);
+    if (memory == nullptr) {
+        fault(address);
+        return;
+    }
+    std::memcpy(memory, &value, bytes);
+}
+
+bool Emulator::conditionPassed(Condition condition) const {
+    switch (condition) {
+        case EQ: return flags.z;
+        case NE: return !flags.z;
+        case CS: return flags.c;
+        case CC: return !flags.c;
+        case MI: return flags.n;
+        case PL: return !flags.n;
+        case VS: return flags.v;
+        case VC: return !flags.v;
+        case HI: return flags.c && !flags.z;
+        case LS: return !flags.c || flags.z;
+        case GE: return flags.n == flags.v;
+        case LT: return flags.n != flags.v;
+        case GT: return !flags.z && flags.n == flags.v;
+        case LE: return flags.z || flags.n != flags.v;
+        default: return true;
+    }
+}
+
+void Emulator::setNZ(uint32_t result) {
+    flags.n = (result >> 31) != 0;
+    flags.z = result == 0;
+}
+
+uint32_t Emulator::addWithCarry(uint32_t a, uint32_t b, bool carry, bool setFlags) {
+    uint64_t const unsignedSum = static_cast<uint64_t>(a) + b + carry;
+    int64_t const signedSum = static_cast<int64_t>(static_cast<int32_t>(a)) + static_cast<int32_t>(b) + carry;
+    uint32_t const result = static_cast<uint32_t>(unsignedSum);
+    if (setFlags) {
+        setNZ(result);
+        flags.c = unsignedSum != result;
+        flags.v = signedSum != static_cast<int32_t>(result);
+    }
+    return result;
+}
+
+// Immediate shifts (DecodeImmShift): LSR and ASR #0 encode a shift by 32, ROR #0 is RRX
+uint32_t Emulator::shift(uint32_t value, uint8_t type, uint8_t amount, bool setFlags) {
+    bool carry = flags.c;
+    uint32_t result = value;
+    uint8_t const distance = amount == 0 ? 32 : amount;
+    switch (type) {
+        case LSL:
+            if (amount != 0) {
+                carry = ((value >> (32 - amount)) & 1) != 0;
+                result = value << amount;
+            }
+            break;
+        case LSR:
+            carry = ((value >> (distance - 1)) & 1) != 0;
+            result = distance == 32 ? 0 : value >> distance;
+            break;
+        case ASR:
+            carry = ((static_cast<int32_t>(value) >> (distance - 1)) & 1) != 0;
+            result = static_cast<uint32_t>(static_cast<int32_t>(value) >> (distance == 32 ? 31 : distance));
+            break;
+        default: // ROR
+            if (amount != 0) {
+                result = std::rotr(value, amount);
+                carry = (result >> 31) != 0;
+            } else {
+                result = static_cast<uint32_t>(flags.c) << 31 | value >> 1;
+                carry = (value & 1) != 0;
+            }
+            break;
+    }
+    if (setFlags) flags.c = carry;
+    return result;
+}
+
+// ThumbExpandImm of the i:imm3:imm8 field
+uint32_t Emulator::expandImmediate(uint32_t instruction) {
+    uint32_t const imm12 = ((instruction >> 26) & 1) << 11 | ((instruction >> 12) & 0x7) << 8 | (instruction & 0xff);
+    uint32_t const imm8 = imm12 & 0xff;
+    if ((imm12 >> 10) == 0) {
+        switch ((imm12 >> 8) & 0x3) {
+            case 0: return imm8;
+            case 1: return imm8 << 16 | imm8;
+            case 2: return imm8 << 24 | imm8 << 8;
+            default: return imm8 * 0x0101'0101;
+        }
+    }
+    return std::rotr(0x80 | (imm12 & 0x7f), static_cast<int>(imm12 >> 7));
+}
+
+uint16_t Emulator::predicate() {
+    uint16_t mask = blockMask;
+    if (loopElementSize < 4 && r[LR] < (16U >> loopElementSize)) { // last iteration of a tail predicated loop
+        mask &= (1U << (r[LR] << loopElementSize)) - 1;
+    }
+    return mask;
+}
+
+void Emulator::writeVector(uint8_t qd, uint8_t const * result, uint16_t mask) {
+    for (uint8_t i = 0; i < 16; i++) {
+        if ((mask >> i) & 1) q[qd][i] = result[i];
+    }
+}
+
+bool Emulator::branch(uint32_t target, uint32_t & next) {
+    next = target & ~1U;
+    return next == RETURN_ADDRESS;
+}
+
+Emulator::Status Emulator::execute16(uint16_t instruction, uint32_t & next) {
+    uint32_t const pc = r[PC];
+    uint8_t const rd = instruction & 0x7; // Rd/Rt/Rdn of the low register encodings
+    uint8_t const rn = (instruction >> 3) & 0x7;
+
+    if (instruction == Base::nop16()) return RUNNING;
+    if ((instruction & 0xff87) == 0x4700) { // BX Rm
+        return branch(r[(instruction >> 3) & 0xf], next) ? RETURNED : RUNNING;
+    }
+    if ((instruction & 0xe000) == 0x0000 && (instruction & 0x1800) != 0x1800) { // LSLS/LSRS/ASRS Rd, Rm, #imm5 (MOVS Rd, Rm)
+        r[rd] = shift(r[rn], (instruction >> 11) & 0x3, (instruction >> 6) & 0x1f, true);
+        setNZ(r[rd]);
+        return RUNNING;
+    }
+    if ((instruction & 0xf800) == 0x1800) { // ADDS/SUBS Rd, Rn, Rm/#imm3
+        uint32_t const operand = (instruction & 0x0400) != 0 ? (instruction >> 6) & 0x7 : r[(instruction >> 6) & 0x7];
+        bool const subtract = (instruction & 0x0200) != 0;
+        r[rd] = addWithCarry(r[rn], subtract ? ~operand : operand, subtract, true);
+        return RUNNING;
+    }
+    if ((instruction & 0xe000) == 0x2000) { // MOVS/CMP/ADDS/SUBS Rdn, #imm8
+        uint8_t const rdn = (instruction >> 8) & 0x7;
+        uint32_t const imm8 = instruction & 0xff;
+        switch ((instruction >> 11) & 0x3) {
+            case 0:
+                r[rdn] = imm8;
+                setNZ(imm8);
+                break;
+            case 1:
+                addWithCarry(r[rdn], ~imm8, true, true);
+                break;
+            case 2:
+                r[rdn] = addWithCarry(r[rdn], imm8, false, true);
+                break;
+            default:
+                r[rdn] = addWithCarry(r[rdn], ~imm8, true, true);
+                break;
+        }
+        return RUNNING;
+    }
+    if ((instruction & 0xffc0) == 0x4340) { // MULS Rdm, Rn, Rdm
+        r[rd] = r[rn] * r[rd];
+        setNZ(r[rd]);
+        return RUNNING;
+    }
+    if ((instruction & 0xffc0) == 0x4280) { // CMP Rn, Rm (low registers)
+        addWithCarry(r[rd], ~r[rn], true, true);
+        return RUNNING;
+    }
+    if ((instruction & 0xfc00) == 0x4400 && (instruction & 0x0300) != 0x0300) { // ADD/CMP/MOV with high registers
+        uint8_t const d = ((instruction >> 7) & 0x1) << 3 | rd;
+        uint8_t const m = (instruction >> 3) & 0xf;
+        uint32_t const value = m == PC ? pc + 4 : r[m];
+        switch ((instruction >> 8) & 0x3) {
+            case 0:
+                if (d == PC) return branch(pc + 4 + value, next) ? RETURNED : RUNNING;
+                r[d] += value;
+                break;
+            case 1:
+                addWithCarry(r[d], ~value, true, true);
+                break;
+            default:
+                if (d == PC) return branch(value, next) ? RETURNED : RUNNING;
+                r[d] = value;
+                break;
+        }
+        return RUNNING;
+    }
+    if ((instruction & 0xf800) == 0x4800) { // LDR Rt, [PC, #imm8]
+        r[(instruction >> 8) & 0x7] = load(((pc + 4) & ~3U) + ((instruction & 0xff) << 2), 4);
+        return RUNNING;
+    }
+    if ((instruction & 0xfe00) == 0x5800) { // LDR Rt, [Rn, Rm]
+        r[rd] = load(r[rn] + r[(instruction >> 6) & 0x7], 4);
+        return RUNNING;
+    }
+    if ((instruction & 0xf000) == 0x6000) { // STR/LDR Rt, [Rn, #imm5]
+        uint32_t const address = r[rn] + (((instruction >> 6) & 0x1f) << 2);
+        if ((instruction & 0x0800) != 0) {
+            r[rd] = load(address, 4);
+        } else {
+            store(address, r[rd], 4);
+        }
+        return RUNNING;
+    }
+    if ((instruction & 0xfe00) == 0xb400) { // PUSH {registers, LR}
+        uint32_t const list = (instruction & 0xff) | ((instruction >> 8) & 0x1) << LR;
+        uint32_t address = r[SP] - 4 * std::popcount(list);
+        r[SP] = address;
+        for (uint8_t reg = 0; reg < 16; reg++) {
+            if ((list >> reg) & 1) {
+                store(address, r[reg], 4);
+                address += 4;
+            }
+        }
+        return RUNNING;
+    }
+    if ((instruction & 0xfe00) == 0xbc00) { // POP {registers, PC}
+        uint32_t address = r[SP];
+        for (uint8_t reg = 0; reg < 8; reg++) {
+            if ((instruction >> reg) & 1) {
+                r[reg] = load(address, 4);
+                address += 4;
+            }
+        }
+        bool returned = false;
+        if ((instruction & 0x0100) != 0) {
+            returned = branch(load(address, 4), next);
+            address += 4;
+        }
+        r[SP] = address;
+        return returned ? RETURNED : RUNNING;
+    }
+    if ((instruction & 0xf500) == 0xb100) { // CBZ/CBNZ Rn, label
+        uint32_t const offset = ((instruction >> 9) & 0x1) << 6 | ((instruction >> 3) & 0x1f) << 1;
+        bool const nonZero = (instruction & 0x0800) != 0;
+        if ((r[rd] != 0) == nonZero) next = pc + 4 + offset;
+        return RUNNING;
+    }
+    if ((instruction & 0xf000) == 0xd000) { // B<c> label, UDF
+        Condition const condition = static_cast<Condition>((instruction >> 8) & 0xf);
+        if (condition >= AL) return UNDEFINED_INSTRUCTION;
+        if (conditionPassed(condition)) next = pc + 4 + signExtend((instruction & 0xff) << 1, 9);
+        return RUNNING;
+    }
+    if ((instruction & 0xf800) == 0xe000) { // B label
+        next = pc + 4 + signExtend((instruction & 0x7ff) << 1, 12);
+        return RUNNING;
+    }
+    return UNDEFINED_INSTRUCTION;
+}
+
+Emulator::Status Emulator::execute32(uint32_t instruction, uint32_t & next) {
+    uint32_t const pc = r[PC];
+    uint8_t const rn = (instruction >> 16) & 0xf;
+    uint8_t const rt = (instruction >> 12) & 0xf; // Rt of loads and stores
+    uint8_t const rd = (instruction >> 8) & 0xf; // Rd of data processing
+    uint8_t const rm = instruction & 0xf;
+
+    if (instruction == Base::nop32()) return RUNNING;
+
+    /* stack */
+    if ((instruction & 0xffff'0000) == 0xe92d'0000) { // PUSH.W {registers}
+        uint32_t const list = instruction & 0xffff;
+        uint32_t address = r[SP] - 4 * std::popcount(list);
+        r[SP] = address;
+        for (uint8_t reg = 0; reg < 16; reg++) {
+            if ((list >> reg) & 1) {
+                store(address, r[reg], 4);
+                address += 4;
+            }
+        }
+        return RUNNING;
+    }
+    if ((instruction & 0xffff'0000) == 0xe8bd'0000) { // POP.W {registers}
+        uint32_t address = r[SP];
+        bool returned = false;
+        for (uint8_t reg = 0; reg < 16; reg++) {
+            if ((instruction >> reg) & 1) {
+                uint32_t const value = load(address, 4);
+                address += 4;
+                if (reg == PC) {
+                    returned = branch(value, next);
+                } else {
+                    r[reg] = value;
+                }
+            }
+        }
+        r[SP] = address;
+        return returned ? RETURNED : RUNNING;
+    }
+    if ((instruction & 0xfebf'0f00) == 0xec2d'0b00 || (instruction & 0xfebf'0f00) == 0xecbd'0b00) { // VPUSH/VPOP {D registers}
+        bool const push = (instruction & 0x0080'0000) == 0;
+        uint8_t const first = ((instruction >> 22) & 0x1) << 4 | ((instruction >> 12) & 0xf);
+        uint8_t const count = (instruction & 0xff) / 2;
+        if (first + count > 16) return UNDEFINED_INSTRUCTION;
+        uint32_t address = push ? r[SP] - 8 * count : r[SP];
+        for (uint8_t d = first; d < first + count; d++) {
+            uint8_t * reg = q[d / 2] + 8 * (d % 2);
+            for (uint8_t word = 0; word < 2; word++) {
+                if (push) {
+                    store(address, getLane(reg, word, 4), 4);
+                } else {
+                    setLane(reg, word, 4, load(address, 4));
+                }
+                address += 4;
+            }
+        }
+        r[SP] = push ? r[SP] - 8 * count : address;
+        return RUNNING;
+    }
+
+    /* branches and low overhead loops */
+    if ((instruction & 0xff80'ffff) == 0xf000'e001) { // DLS/DLSTP LR, Rn
+        r[LR] = r[rn];
+        loopElementSize = (instruction >> 20) & 0x7;
+        return RUNNING;
+    }
+    if ((instruction & 0xffef'f001) == 0xf00f'c001) { // LE/LETP LR, label (WLS with Rn = PC)
+        uint32_t const offset = ((instruction & 0x7fe) | ((instruction >> 11) & 0x1)) << 1;
+        uint32_t const elements = loopElementSize < 4 ? 16U >> loopElementSize : 1;
+        if (r[LR] > elements) {
+            r[LR] -= elements;
+            next = pc + 4 - offset;
+        } else if ((instruction & 0x0010'0000) != 0) {
+            loopElementSize = 4; // tail predication ends with the loop
+        }
+        return RUNNING;
+    }
+    if ((instruction & 0xff80'f001) == 0xf000'c001) { // WLS/WLSTP LR, Rn, label
+        uint32_t const offset = ((instruction & 0x7fe) | ((instruction >> 11) & 0x1)) << 1;
+        if (r[rn] == 0) {
+            next = pc + 4 + offset;
+        } else {
+            r[LR] = r[rn];
+            loopElementSize = (instruction >> 20) & 0x7;
+        }
+        return RUNNING;
+    }
+    if ((instruction & 0xf800'd000) == 0xf000'9000) { // B.W label
+        uint32_t const s = (instruction >> 26) & 0x1;
+        uint32_t const i1 = ~(((instruction >> 13) & 0x1) ^ s) & 0x1;
+        uint32_t const i2 = ~(((instruction >> 11) & 0x1) ^ s) & 0x1;
+        uint32_t const offset = s << 24 | i1 << 23 | i2 << 22 | ((instruction >> 16) & 0x3ff) << 12 | (instruction & 0x7ff) << 1;
+        return branch(pc + 4 + signExtend(offset, 25), next) ? RETURNED : RUNNING;
+    }
+    if ((instruction & 0xf800'd000) == 0xf000'8000 && ((instruction >> 22) & 0xf) < AL) { // B<c>.W label
+        uint32_t const offset = ((instruction >> 26) & 0x1) << 20 | ((instruction >> 11) & 0x1) << 19 | ((instruction >> 13) & 0x1) << 18
+            | ((instruction >> 16) & 0x3f) << 12 | (instruction & 0x7ff) << 1;
+        if (conditionPassed(static_cast<Condition>((instruction >> 22) & 0xf))) next = pc + 4 + signExtend(offset, 21);
+        return RUNNING;
+    }
+
+    /* data processing */
+    uint32_t const imm16 = ((instruction >> 16) & 0xf) << 12 | ((instruction >> 26) & 0x1) << 11 | ((instruction >> 12) & 0x7) << 8 | (instruction & 0xff);
+    uint32_t const imm12 = imm16 & 0xfff;
+    if ((instruction & 0xfbf0'8000) == 0xf240'0000) { // MOVW Rd, #imm16
+        r[rd] = imm16;
+        return RUNNING;
+    }
+    if ((instruction & 0xfbf0'8000) == 0xf2c0'0000) { // MOVT Rd, #imm16
+        r[rd] = (r[rd] & 0xffff) | imm16 << 16;
+        return RUNNING;
+    }
+    if ((instruction & 0xfbf0'8000) == 0xf200'0000) { // ADDW Rd, Rn, #imm12
+        r[rd] = r[rn] + imm12;
+        return RUNNING;
+    }
+    if ((instruction & 0xfbf0'8000) == 0xf2a0'0000) { // SUBW Rd, Rn, #imm12
+        r[rd] = r[rn] - imm12;
+        return RUNNING;
+    }
+    if ((instruction & 0xfbf0'8f00) == 0xf1b0'0f00) { // CMP Rn, #constant
+        addWithCarry(r[rn], ~expandImmediate(instruction), true, true);
+        return RUNNING;
+    }
+    if ((instruction & 0xfbe0'8000) == 0xf000'0000) { // AND(S) Rd, Rn, #constant (TST without Rd)
+        uint32_t const result = r[rn] & expandImmediate(instruction);
+        bool const setFlags = (instruction & 0x0010'0000) != 0;
+        if (setFlags) setNZ(result);
+        if (rd != PC || !setFlags) r[rd] = result;
+        return RUNNING;
+    }
+    uint8_t const amount = ((instruction >> 12) & 0x7) << 2 | ((instruction >> 6) & 0x3);
+    uint8_t const shiftType = (instruction >> 4) & 0x3;
+    bool const setFlags = (instruction & 0x0010'0000) != 0;
+    if ((instruction & 0xffef'8000) == 0xea4f'0000) { // MOV(S).W Rd, Rm{, shift}
+        r[rd] = shift(r[rm], shiftType, amount, setFlags);
+        if (setFlags) setNZ(r[rd]);
+        return RUNNING;
+    }
+    if ((instruction & 0xffe0'8000) == 0xeb00'0000 || (instruction & 0xffe0'8000) == 0xeba0'0000) { // ADD/SUB(S).W Rd, Rn, Rm{, shift}, CMP/CMN without Rd
+        uint32_t const operand = shift(r[rm], shiftType, amount, false);
+        bool const subtract = (instruction & 0x00a0'0000) == 0x00a0'0000;
+        uint32_t const result = addWithCarry(r[rn], subtract ? ~operand : operand, subtract, setFlags);
+        if (rd != PC || !setFlags) r[rd] = result;
+        return RUNNING;
+    }
+    if ((instruction & 0xfff0'f0f0) == 0xfb00'f000) { // MUL Rd, Rn, Rm
+        r[rd] = r[rn] * r[rm];
+        return RUNNING;
+    }
+
+    /* loads */
+    if ((instruction & 0xff7f'0000) == 0xf85f'0000) { // LDR Rt, [PC, #+/-imm12]
+        uint32_t const base = (pc + 4) & ~3U;
+        r[rt] = load((instruction & 0x0080'0000) != 0 ? base + (instruction & 0xfff) : base - (instruction & 0xfff), 4);
+        return RUNNING;
+    }
+    if ((instruction & 0xff10'0000) == 0xf810'0000) { // LDR, LDRH, LDRB and PLD (immediate or register offset)
+        uint8_t const bytes = 1 << ((instruction >> 21) & 0x3);
+        uint32_t address;
+        uint32_t writeBackAddress = 0;
+        bool writeBack = false;
+        if ((instruction & 0x0080'0000) != 0) { // T3: [Rn, #imm12]
+            address = r[rn] + (instruction & 0xfff);
+        } else if ((instruction & 0x0800) != 0) { // T4: [Rn, #+/-imm8]{!} and [Rn], #+/-imm8
+            uint32_t const imm8 = instruction & 0xff;
+            uint32_t const offsetAddress = (instruction & 0x0200) != 0 ? r[rn] + imm8 : r[rn] - imm8;
+            address = (instruction & 0x0400) != 0 ? offsetAddress : r[rn];
+            writeBack = (instruction & 0x0100) != 0;
+            writeBackAddress = offsetAddress;
+        } else if ((instruction & 0x0fc0) == 0) { // [Rn, Rm, LSL #imm2]
+            address = r[rn] + (r[rm] << ((instruction >> 4) & 0x3));
+        } else {
+            return UNDEFINED_INSTRUCTION;
+        }
+        if (bytes == 8) return UNDEFINED_INSTRUCTION;
+        if (rt == PC && bytes < 4) return RUNNING; // PLD/PLDW, a hint
+        uint32_t const value = load(address, bytes);
+        if (writeBack) r[rn] = writeBackAddress;
+        if (rt == PC) return branch(value, next) ? RETURNED : RUNNING;
+        r[rt] = value;
+        return RUNNING;
+    }
+
+    return executeVector(instruction);
+}
+
+Emulator::Status Emulator::executeVector(uint32_t instruction) {
+    uint8_t const qd = (instruction >> 13) & 0x7;
+    uint8_t const qn = (instruction >> 17) & 0x7;
+    uint8_t const qm = (instruction >> 1) & 0x7;
+    uint8_t const rm = instruction & 0xf; // scalar operand
+    uint8_t const size = (instruction >> 20) & 0x3; // element size of the integer instructions
+    uint16_t const mask = predicate();
+    uint8_t result[16];
+    std::memcpy(result, q[qd], sizeof(result));
+
+    if ((instruction & 0xffbf'1fff) == 0xfe31'0f4d) { // VPST, the position of the lowest set mask bit gives the block length
+        if ((instruction & 0x2000) != 0) vptRemaining = 4;
+        else if ((instruction & 0x4000) != 0) vptRemaining = 3;
+        else if ((instruction & 0x8000) != 0) vptRemaining = 2;
+        else vptRemaining = 1;
+        return RUNNING;
+    }
+    if ((instruction & 0xffc0'ffff) == 0xf000'e801) { // VCTP.<size> Rn
+        uint32_t const elements = 16U >> size;
+        uint32_t const active = r[(instruction >> 16) & 0xf] < elements ? r[(instruction >> 16) & 0xf] : elements;
+        p0 = static_cast<uint16_t>((1U << (active << size)) - 1) & mask;
+        return RUNNING;
+    }
+    if ((instruction & 0xee00'0000) == 0xec00'0000) {
+        return vectorLoadStore(instruction);
+    }
+
+    /* moves */
+    if ((instruction & 0xffe0'0f7f) == 0xee00'0a10) { // VMOV Sn, Rt and VMOV Rt, Sn
+        uint8_t const sn = ((instruction >> 16) & 0xf) << 1 | ((instruction >> 7) & 0x1);
+        uint8_t * reg = q[sn / 4] + 4 * (sn % 4);
+        if ((instruction & 0x0010'0000) != 0) {
+            r[(instruction >> 12) & 0xf] = getLane(reg, 0, 4);
+        } else {
+            setLane(reg, 0, 4, r[(instruction >> 12) & 0xf]);
+        }
+        return RUNNING;
+    }
+    if ((instruction & 0xfff1'0fff) == 0xeea0'0b10) { // VDUP.32 Qd, Rt
+        for (uint8_t lane = 0; lane < 4; lane++) setLane(result, lane, 4, r[(instruction >> 12) & 0xf]);
+        writeVector(qn, result, mask); // Qd is encoded in the bits of Qn
+        return RUNNING;
+    }
+    if ((instruction & 0xeff8'10f0) == 0xef80'0050) { // VMOV.I8/I16/I32 Qd, #imm8
+        uint32_t const imm8 = ((instruction >> 28) & 0x1) << 7 | ((instruction >> 16) & 0x7) << 4 | (instruction & 0xf);
+        uint8_t bytes;
+        switch ((instruction >> 8) & 0xf) {
+            case 0x0: bytes = 4; break;
+            case 0x8: bytes = 2; break;
+            case 0xe: bytes = 1; break;
+            default: return UNDEFINED_INSTRUCTION;
+        }
+        for (uint8_t lane = 0; lane < 16 / bytes; lane++) setLane(result, lane, bytes, imm8);
+        writeVector(qd, result, mask);
+        return RUNNING;
+    }
+    if ((instruction & 0xffd1'1ff1) == 0xef00'0150) { // VORR/VAND Qd, Qn, Qm
+        bool const orr = (instruction & 0x0020'0000) != 0;
+        for (uint8_t i = 0; i < 16; i++) result[i] = orr ? q[qn][i] | q[qm][i] : q[qn][i] & q[qm][i];
+        writeVector(qd, result, mask);
+        return RUNNING;
+    }
+    if ((instruction & 0xefff'0ff1) == 0xee3f'0e01) { // VCVTB/VCVTT.F32.F16 and .F16.F32
+        bool const top = (instruction & 0x1000) != 0;
+        for (uint8_t lane = 0; lane < 4; lane++) {
+            if ((instruction & 0x1000'0000) != 0) {
+                setLane(result, lane, 4, toBits(halfToFloat(getLane(q[qm], 2 * lane + top, 2))));
+            } else {
+                setLane(result, 2 * lane + top, 2, floatToHalf(toFloat(getLane(q[qm], lane, 4))));
+            }
+        }
+        writeVector(qd, result, mask);
+        return RUNNING;
+    }
+    if ((instruction & 0xffc1'1f7e) == 0xee01'0f6e) { // VIDUP.U<size> Qd, Rn, #imm
+        uint8_t const reg = ((instruction >> 17) & 0x7) << 1;
+        uint32_t const imm = 1U << (((instruction >> 7) & 0x1) << 1 | (instruction & 0x1));
+        uint8_t const bytes = 1 << size;
+        uint32_t const base = r[reg];
+        for (uint8_t lane = 0; lane < 16 / bytes; lane++) setLane(result, lane, bytes, base + lane * imm);
+        writeVector(qd, result, mask);
+        r[reg] = base + (16U / bytes) * imm;
+        return RUNNING;
+    }
+    if ((instruction & 0xfff1'1fd1) == 0xeef0'0f00) { // VMLADAV{A}.S8 Rda, Qn, Qm
+        uint8_t const rda = ((instruction >> 13) & 0x7) << 1;
+        int32_t sum = (instruction & 0x20) != 0 ? static_cast<int32_t>(r[rda]) : 0;
+        for (uint8_t i = 0; i < 16; i++) {
+            if ((mask >> i) & 1) sum += static_cast<int8_t>(q[qn][i]) * static_cast<int8_t>(q[qm][i]);
+        }
+        r[rda] = static_cast<uint32_t>(sum);
+        return RUNNING;
+    }
+
+    /* floating point, F16 or F32 */
+    FloatOperation floatOperation = FLOAT_NONE;
+    bool half = false;
+    bool byScalar = false;
+    if ((instruction & 0xeff1'1ff0) == 0xee31'0e40) { // VFMA.F<size> Qda, Qn, Rm
+        floatOperation = FLOAT_FMA;
+        half = (instruction & 0x1000'0000) != 0;
+        byScalar = true;
+    } else if ((instruction & 0xeff1'1ff0) == 0xee31'0e60) { // VMUL.F<size> Qd, Qn, Rm
+        floatOperation = FLOAT_MUL;
+        half = (instruction & 0x1000'0000) != 0;
+        byScalar = true;
+    } else if ((instruction & 0xeff1'1ff0) == 0xee30'0f40) { // VADD.F<size> Qd, Qn, Rm
+        floatOperation = FLOAT_ADD;
+        half = (instruction & 0x1000'0000) != 0;
+        byScalar = true;
+    } else if ((instruction & 0xffe1'1ff1) == 0xef00'0c50) { // VFMA.F<size> Qda, Qn, Qm
+        floatOperation = FLOAT_FMA;
+        half = (instruction & 0x0010'0000) != 0;
+    } else if ((instruction & 0xffe1'1ff1) == 0xef00'0d40) { // VADD.F<size> Qd, Qn, Qm
+        floatOperation = FLOAT_ADD;
+        half = (instruction & 0x0010'0000) != 0;
+    } else if ((instruction & 0xffc1'1ff1) == 0xff00'0f50) { // VMAXNM/VMINNM.F<size> Qd, Qn, Qm
+        floatOperation = (instruction & 0x0020'0000) != 0 ? FLOAT_MIN : FLOAT_MAX;
+        half = (instruction & 0x0010'0000) != 0;
+    }
+    if (floatOperation != FLOAT_NONE) {
+        float const scalar = half ? halfToFloat(r[rm] & 0xffff) : toFloat(r[rm]);
+        for (uint8_t lane = 0; lane < (half ? 8 : 4); lane++) {
+            float const d = getFloat(q[qd], lane, half);
+            float const n = getFloat(q[qn], lane, half);
+            float const m = byScalar ? scalar : getFloat(q[qm], lane, half);
+            float value;
+            switch (floatOperation) {
+                case FLOAT_FMA: value = std::fma(n, m, d); break;
+                case FLOAT_MUL: value = n * m; break;
+                case FLOAT_ADD: value = n + m; break;
+                default: value = maxNum(n, m, floatOperation == FLOAT_MIN); break;
+            }
+            setFloat(result, lane, half, value);
+        }
+        writeVector(qd, result, mask);
+        return RUNNING;
+    }
+
+    /* integer, the lanes are signed where it matters */
+    IntegerOperation integerOperation = INTEGER_NONE;
+    uint8_t bytes = 1 << size;
+    byScalar = false;
+    int8_t immediateShift = 0;
+    bool immediate = false;
+    if ((instruction & 0xefc1'1ff1) == 0xef00'0840) { // VADD/VSUB.I<size> Qd, Qn, Qm
+        integerOperation = (instruction & 0x1000'0000) != 0 ? INTEGER_SUB : INTEGER_ADD;
+    } else if ((instruction & 0xffc1'1ff0) == 0xee01'0f40) { // VADD.I<size> Qd, Qn, Rm
+        integerOperation = INTEGER_ADD;
+        byScalar = true;
+    } else if ((instruction & 0xffc1'1ff0) == 0xee01'1e60) { // VMUL.I<size> Qd, Qn, Rm
+        integerOperation = INTEGER_MUL;
+        byScalar = true;
+    } else if ((instruction & 0xffc1'1fe1) == 0xef00'0640) { // VMAX/VMIN.S<size> Qd, Qn, Qm
+        integerOperation = (instruction & 0x10) != 0 ? INTEGER_MIN : INTEGER_MAX;
+    } else if ((instruction & 0xffc1'1ff1) == 0xff00'0b40) { // VQRDMULH.S<size> Qd, Qn, Qm
+        integerOperation = INTEGER_QRDMULH;
+    } else if ((instruction & 0xffc1'1ff1) == 0xef00'0050) { // VQADD.S<size> Qd, Qn, Qm
+        integerOperation = INTEGER_QADD;
+    } else if ((instruction & 0xfff1'1ef1) == 0xef20'0440) { // VSHL/VRSHL.S32 Qd, Qm, Qn
+        integerOperation = (instruction & 0x100) != 0 ? INTEGER_RSHL : INTEGER_SHL;
+    } else if ((instruction & 0xffe0'1ff1) == 0xefa0'0550) { // VSHL.I32 Qd, Qm, #imm
+        integerOperation = INTEGER_SHL;
+        bytes = 4;
+        immediate = true;
+        immediateShift = static_cast<int8_t>(((instruction >> 16) & 0x3f) - 32);
+    } else if ((instruction & 0xffe0'1df1) == 0xefa0'0050) { // VSHR/VRSHR.S32 Qd, Qm, #imm
+        integerOperation = (instruction & 0x200) != 0 ? INTEGER_RSHL : INTEGER_SHL;
+        bytes = 4;
+        immediate = true;
+        immediateShift = static_cast<int8_t>(((instruction >> 16) & 0x3f) - 64);
+    }
+    if (integerOperation == INTEGER_NONE || bytes == 8) {
+        return UNDEFINED_INSTRUCTION;
+    }
+    uint8_t const bits = 8 * bytes;
+    for (uint8_t lane = 0; lane < 16 / bytes; lane++) {
+        int64_t const n = signExtend(getLane(q[qn], lane, bytes), bits);
+        int64_t const m = signExtend(byScalar ? r[rm] : getLane(q[qm], lane, bytes), bits);
+        int64_t value;
+        switch (integerOperation) {
+            case INTEGER_ADD: value = n + m; break;
+            case INTEGER_SUB: value = n - m; break;
+            case INTEGER_MUL: value = n * m; break;
+            case INTEGER_MAX: value = n > m ? n : m; break;
+            case INTEGER_MIN: value = n < m ? n : m; break;
+            case INTEGER_QRDMULH: value = saturate((2 * n * m + (int64_t{1} << (bits - 1))) >> bits, bits); break;
+            case INTEGER_QADD: value = saturate(n + m, bits); break;
+            default: // the shifted value is in Qm, the amount in the bottom byte of Qn (or the immediate)
+                value = shiftLane(m, immediate ? immediateShift : static_cast<int8_t>(n), integerOperation == INTEGER_RSHL);
+                break;
+        }
+        setLane(result, lane, bytes, static_cast<uint32_t>(value));
+    }
+    writeVector(qd, result, mask);
+    return RUNNING;
+}
+
+Emulator::Status Emulator::vectorLoadStore(uint32_t instruction) {
+    uint8_t const qd = (instruction >> 13) & 0x7;
+    bool const load = (instruction & 0x0010'0000) != 0;
+    uint16_t const mask = predicate();
+
+    if ((instruction & 0xfff0'1ff1) == 0xfc90'0f41) { // VLDRW.U32 Qd, [Rn, Qm, UXTW #2]
+        uint8_t const qm = (instruction >> 1) & 0x7;
+        uint8_t result[16] = {};
+        for (uint8_t lane = 0; lane < 4; lane++) {
+            if (((mask >> (4 * lane)) & 1) == 0) continue;
+            uint32_t const address = r[(instruction >> 16) & 0xf] + (getLane(q[qm], lane, 4) << 2);
+            if (address % 4 != 0) {
+                fault(address);
+                return MEMORY_FAULT;
+            }
+            setLane(result, lane, 4, this->load(address, 4));
+        }
+        std::memcpy(q[qd], result, sizeof(result));
+        return RUNNING;
+    }
+    if ((instruction & 0xffe0'1fe0) == 0xec00'0f00) { // VMOV Rt, Rt2, Qd[2 + odd], Qd[odd] and the other direction
+        uint8_t const rt = instruction & 0xf;
+        uint8_t const rt2 = (instruction >> 16) & 0xf;
+        uint8_t const odd = (instruction >> 4) & 0x1;
+        if (load) {
+            setLane(q[qd], 2 + odd, 4, r[rt]);
+            setLane(q[qd], odd, 4, r[rt2]);
+        } else {
+            r[rt] = getLane(q[qd], 2 + odd, 4);
+            r[rt2] = getLane(q[qd], odd, 4);
+        }
+        return RUNNING;
+    }
+
+    bool const preIndexed = (instruction & 0x0100'0000) != 0;
+    bool const writeBack = (instruction & 0x0020'0000) != 0;
+    if ((!preIndexed && !writeBack) || (instruction & 0x0040'0000) != 0) {
+        return UNDEFINED_INSTRUCTION;
+    }
+    uint8_t memoryBytes;
+    uint8_t laneBytes;
+    uint8_t rn;
+    uint32_t offset = instruction & 0x7f;
+    bool signedLoad = false;
+    if (((instruction >> 9) & 0xf) == 0xf && (instruction & 0x1000'0000) == 0) { // VLDRB/H/W, VSTRB/H/W
+        uint8_t const size = (instruction >> 7) & 0x3;
+        if (size == 3) return UNDEFINED_INSTRUCTION;
+        memoryBytes = 1 << size;
+        laneBytes = memoryBytes;
+        rn = (instruction >> 16) & 0xf;
+        offset <<= size;
+    } else if (((instruction >> 9) & 0xf) == 0x7) { // widening loads and narrowing stores of bytes or halfwords
+        bool const halfword = (instruction & 0x0008'0000) != 0;
+        memoryBytes = halfword ? 2 : 1;
+        laneBytes = 1 << ((instruction >> 7) & 0x3);
+        if (laneBytes <= memoryBytes || laneBytes == 8) return UNDEFINED_INSTRUCTION;
+        rn = (instruction >> 16) & 0x7;
+        offset <<= halfword;
+        signedLoad = (instruction & 0x1000'0000) == 0;
+    } else {
+        return UNDEFINED_INSTRUCTION;
+    }
+
+    uint32_t const offsetAddress = (instruction & 0x0080'0000) != 0 ? r[rn] + offset : r[rn] - offset;
+    uint32_t const address = preIndexed ? offsetAddress : r[rn];
+    if (address % memoryBytes != 0) {
+        fault(address);
+        return MEMORY_FAULT;
+    }
+    uint8_t const lanes = 16 / laneBytes;
+    if (load) {
+        uint8_t result[16] = {}; // predicated-false lanes are zeroed
+        for (uint8_t lane = 0; lane < lanes; lane++) {
+            if (((mask >> (lane * laneBytes)) & 1) == 0) continue;
+            uint32_t value = this->load(address + lane * memoryBytes, memoryBytes);
+            if (signedLoad) value = static_cast<uint32_t>(signExtend(value, 8 * memoryBytes));
+            setLane(result, lane, laneBytes, value);
+        }
+        std::memcpy(q[qd], result, sizeof(result));
+    } else {
+        for (uint8_t lane = 0; lane < lanes; lane++) {
+            if (((mask >> (lane * laneBytes)) & 1) == 0) continue;
+            store(address + lane * memoryBytes, getLane(q[qd], lane, laneBytes), memoryBytes);
+        }
+    }
+    if (writeBack) r[rn] = offsetAddress;
+    return faulted ? MEMORY_FAULT : RUNNING;
+}
@@ -0,0 +1,134 @@
+#ifndef JIT_EMULATOR_HPP
+#define JIT_EMULATOR_HPP
+#pragma once
+#include <cstdint>
+#include "../instructions/Base.hpp"
+
+namespace JIT {
+    class Emulator;
+}
+
+/**
+ * @brief Interpreter for the Thumb-2 and MVE instructions the encoders in instructions/ produce, so generated kernels can be
+ * executed on the host (e.g. by the tests) instead of the board.
+ *
+ * The emulated address space is 32 bit: the host buffers (code, operands) are mapped to addresses of the emulated machine
+ * and every access outside of them stops the execution. Code has to be mapped at an address with the same alignment
+ * (modulo 4) it was generated for, the literal pools and aligned loops depend on it.
+ * Low overhead loops (including tail predication), VPT blocks and VCTP are executed with the architectural predication,
+ * predicated-false lanes of loads are zeroed. Timing is not modelled, only the executed instructions are counted.
+ */
+class JIT::Emulator {
+    public:
+        enum Status : uint8_t {
+            RETURNED = 0, // the kernel branched to the return address
+            UNDEFINED_INSTRUCTION, // an encoding the emulator does not know (or UDF), see getFaultAddress()
+            MEMORY_FAULT, // access outside of the mapped memory or unaligned vector access, see getFaultAddress()
+            STEP_LIMIT, // maxSteps instructions were executed without returning
+        };
+
+        static constexpr uint8_t MAX_REGIONS = 8;
+        static constexpr uint32_t STACK_BYTES = 4096;
+        /// @brief Initial SP of call(), the stack is the region below it
+        static constexpr uint32_t STACK_TOP = 0x7000'0000;
+        /// @brief LR of call(), returning to it ends the execution
+        static constexpr uint32_t RETURN_ADDRESS = 0xffff'fff0;
+
+        /// @brief An executed instruction, see setObserver()
+        struct Step {
+            uint32_t address;
+            Instructions::Instruction32 encoding; // 16-bit instructions in the lower half
+            uint32_t next; // address of the next instruction, differs from address + size if a branch was taken
+            uint16_t lanes; // byte mask of the lanes a vector instruction may write (VPT block and tail predication)
+            uint8_t halfwords;
+        };
+        using Observer = void (*)(void * context, Step const & step);
+
+        Emulator();
+
+        /// @brief Maps bytes of host memory at address. false if the region overlaps another one or all regions are used
+        bool map(uint32_t address, void * memory, uint32_t bytes);
+        /// @brief Removes all mappings except the stack
+        void unmapAll();
+
+        /**
+         * @brief Calls the function at entry (Thumb address, bit 0 set) with the arguments in R0-R2 and a fresh stack.
+         * All other registers keep their values, so the caller can check that the callee saved registers are preserved.
+         */
+        Status call(uint32_t entry, uint32_t r0 = 0, uint32_t r1 = 0, uint32_t r2 = 0, uint64_t maxSteps = 100'000'000);
+
+        /// @brief Calls observer after every instruction which executed without a fault, nullptr removes it
+        void setObserver(Observer observer, void * context) {
+            this->observer = observer;
+            observerContext = context;
+        }
+
+        uint32_t getRegister(Instructions::Register reg) const {
+            return r[reg];
+        }
+        void setRegister(Instructions::Register reg, uint32_t value) {
+            r[reg] = value;
+        }
+        uint32_t getVectorLane(Instructions::VectorRegister reg, uint8_t lane) const;
+        void setVectorLane(Instructions::VectorRegister reg, uint8_t lane, uint32_t value);
+        /// @brief Instructions executed by the last call()
+        uint64_t getSteps() const {
+            return steps;
+        }
+        /// @brief Address of the instruction (UNDEFINED_INSTRUCTION) or the access (MEMORY_FAULT) which stopped the last call()
+        uint32_t getFaultAddress() const {
+            return faultAddress;
+        }
+
+    private:
+        struct Region {
+            uint32_t address;
+            uint32_t bytes;
+            uint8_t * memory;
+        };
+        struct Flags {
+            bool n, z, c, v;
+        };
+
+        Region regions[MAX_REGIONS];
+        uint8_t regionCount = 0;
+        alignas(16) uint8_t stack[STACK_BYTES];
+
+        uint32_t r[16] = {};
+        uint8_t q[8][16] = {}; // Q0-Q7 (S0-S31, D0-D15), little endian lanes
+        Flags flags = {};
+        uint16_t p0 = 0; // VPR.P0, one bit per byte lane
+        uint8_t vptRemaining = 0; // instructions left in the VPT block
+        uint8_t loopElementSize = 4; // LTPSIZE: log2 of the element bytes of a tail predicated loop, 4 = no tail predication
+        uint64_t steps = 0;
+        uint16_t blockMask = 0xffff; // P0 inside a VPT block, all lanes outside
+        uint32_t faultAddress = 0;
+        bool faulted = false;
+        Observer observer = nullptr;
+        void * observerContext = nullptr;
+
+        uint8_t * translate(uint32_t address, uint32_t bytes);
+        void fault(uint32_t address);
+        uint32_t load(uint32_t address, uint8_t bytes);
+        void store(uint32_t address, uint32_t value, uint8_t bytes);
+
+        bool conditionPassed(Instructions::Condition condition) const;
+        void setNZ(uint32_t result);
+        uint32_t addWithCarry(uint32_t a, uint32_t b, bool carry, bool setFlags);
+        uint32_t shift(uint32_t value, uint8_t type, uint8_t amount, bool setFlags);
+        static uint32_t expandImmediate(uint32_t instruction);
+        /// @brief Byte mask of the lanes the next vector instruction writes (VPT block and tail predication)
+        uint16_t predicate();
+        void writeVector(uint8_t qd, uint8_t const * result, uint16_t mask);
+
+        /// @brief Sets next to target, true if the target is the return address
+        static bool branch(uint32_t target, uint32_t & next);
+        Status execute16(uint16_t instruction, uint32_t & next);
+        Status execute32(uint32_t instruction, uint32_t & next);
+        Status executeVector(uint32_t instruction);
+        Status vectorLoadStore(uint32_t instruction);
+
+        static constexpr Status RUNNING = static_cast<Status>(0xff);
+};
+
+#endif // JIT_EMULATOR_HPP
@@ -1,10 +1,12 @@
 #include "Gemm.hpp"
-#include "SEGGER_RTT.h"
+#include "GemmTuningTable.hpp"
 #include "backend/Backend.hpp"
+#include "backend/RegisterAllocator.hpp"
 #include "instructions/Arithmetic.hpp"
 #include "instructions/Base.hpp"
 #include "instructions/DataProcessing.hpp"
 #include "instructions/Vector.hpp"
+#include <bit>
 #include <cstdint>
 
 
@@ -30,10 +32,42 @@ constexpr JIT::Instructions::Register B_Pointer = JIT::Instructions::R1;
 constexpr JIT::Instructions::Register C_Pointer = JIT::Instructions::R2;
 constexpr JIT::Instructions::Register DLS_COUNT_REGISTER = JIT::Instructions::R9;
 constexpr JIT::Instructions::Register A_Base_Pointer = JIT::Instructions::R3;
-/* The LENx registers are assigned when determining the microkernel strategy */
-constexpr JIT::Instructions::Register LEN1_REGISTER = JIT::Instructions::R10;
-constexpr JIT::Instructions::Register LEN2_REGISTER = JIT::Instructions::R11;
-constexpr JIT::Instructions::Register LEN3_REGISTER = JIT::Instructions::R12;
+/* Registers for the values which can't be encoded as immediates. The register allocator hands them out first,
+followed by the loop registers which are not needed for the shape */
+constexpr JIT::Instructions::Register SPARE_REGISTERS[] = {JIT::Instructions::R10, JIT::Instructions::R11, JIT::Instructions::R12};
+/* Live ranges of the NN kernels, one position per part of the loops. Values which are set in the prologue live until their
+last use, the C row pointers and the second B pointer are set at the start of each 8x3 / 4x6 microkernel and die with it */
+constexpr uint16_t KERNEL_PROLOGUE = 0;
+constexpr uint16_t KERNEL_WIDE_MICROKERNELS = 1; // 8x3 and 16x1 microkernels
+constexpr uint16_t KERNEL_NARROW_MICROKERNELS = 2; // 4x6 microkernels
+constexpr uint16_t KERNEL_LOOP_CONTROL = 3; // pointer updates and compares of the i / j loops
+constexpr uint16_t KERNEL_END = 4;
+/* Holds alpha or beta / alpha when C has to be scaled. LR is only used as loop counter between DLS and LE, kernels which need neither hand it to the register allocator */
+constexpr JIT::Instructions::Register SCALE_REGISTER = JIT::Instructions::LR;
+
+/* Registers of the kernels for transposed operands */
+constexpr JIT::Instructions::Register B_Base_Pointer = JIT::Instructions::R10;
+constexpr JIT::Instructions::Register LDC_BYTES_REGISTER = JIT::Instructions::R11;
+constexpr JIT::Instructions::Register A_STRIDE_REGISTER = JIT::Instructions::R12; // lda if A is transposed, otherwise lda * DT_SIZE
+constexpr JIT::Instructions::VectorRegister A_Offsets_Register = JIT::Instructions::Q7; // offsets of the gathered rows of a transposed A
+
+/* Registers of the epilogue, only used after the k loop of the strided microkernels (B_Pointer is reset by the next microkernel) */
+constexpr JIT::Instructions::Register Bias_Pointer = B0_Register;
+constexpr JIT::Instructions::Register Bias_Register = B2_Register; // bias of the current column
+constexpr JIT::Instructions::Register Lower_Bound_Register = B1_Register;
+constexpr JIT::Instructions::Register Upper_Bound_Register = B_Pointer;
+/* Registers of the kernels with alpha == 0 (see generateScaleOnly), they only access C and the epilogue registers above */
+constexpr JIT::Instructions::Register Row_Pointer = A_Base_Pointer;
+constexpr JIT::Instructions::Register Beta_Register = B_Base_Pointer;
+constexpr JIT::Instructions::VectorRegister Bias_Vector = JIT::Instructions::Q1;
+constexpr JIT::Instructions::VectorRegister Lower_Bound_Vector = JIT::Instructions::Q2;
+constexpr JIT::Instructions::VectorRegister Upper_Bound_Vector = JIT::Instructions::Q3;
+/* Live ranges of the epilogue of a vector: the bounds are set up once, the temp register holds the row bias and reloaded bounds */
+constexpr uint16_t EPILOGUE_SETUP = 0;
+constexpr uint16_t EPILOGUE_BIAS = 1;
+constexpr uint16_t EPILOGUE_END = 2;
+/* The bias of the microkernels inside the I/J loops is addressed with the loop registers */
+constexpr uint32_t EPILOGUE_OFFSET_FROM_LOOP = UINT32_MAX;
  
 /* VLDRW uses 7bit immediate with LSL 2, i.e. 4byte aligned 9bit immediate */
 constexpr uint32_t VLDR_TRESHOLD = 508;
@@ -47,12 +81,15 @@ constexpr uint32_t MOV_TRESHOLD = 65535;
             K=3: 1.46
             K=10: 1.46
 */
+/* defaults of Gemm::Tuning, a tuning table can override them per shape */
 constexpr uint32_t K_MAX_UNROLL = 5;
 constexpr uint32_t M_MAX_UNROLL = 5;
 constexpr uint32_t N_MAX_UNROLL = 3;
 /* Use 8x3 microkernel by default */
 constexpr uint32_t DEFAULT_MICROKERNEL_M = 8;
 constexpr uint32_t DEFAULT_MICROKERNEL_N = 3;
+constexpr uint32_t STRIDED_MICROKERNEL_M_TRANSPOSED_A = 4;
+constexpr uint32_t STRIDED_MICROKERNEL_N_TRANSPOSED_A = 6;
 
 constexpr uint32_t VECTOR_SIZE = 16; // == 128 Bit
 /* Count of vector registers */
@@ -61,13 +98,11 @@ constexpr uint32_t DT_SIZE = 4; // == 32 Bit (FP32)
 /* Calculate elements of elements which fit into a single vector register */
 constexpr uint32_t VECTOR_ELEMENTS = VECTOR_SIZE / DT_SIZE;
 
-void JIT::Generators::Gemm::emitLoadB(JIT::Instructions::Register targetReg, MicroKernelConfiguration & configuration, uint32_t leftShiftAmount, uint32_t offset, bool secondHalf, bool try16Bit) {
+void JIT::Generators::Gemm::emitLoadB(JIT::Instructions::Register targetReg, MicroKernelConfiguration & configuration, uint32_t leftShiftAmount, uint32_t offset, bool secondHalf) {
     if ((configuration.registerStrategy & (secondHalf ? USE_BCOL3_REGISTER : USE_LDB_REGISTER)) && (targetReg == B1_Register || targetReg == B2_Register)) {
         backend.addInstruction(Instructions::DataProcessing::ldrRegister32(targetReg, secondHalf ? configuration.BCOL3_REGISTER : B_Pointer, configuration.LDB_REGISTER, leftShiftAmount));
     } else if (targetReg == B1_Register || targetReg == B2_Register) {
-        if (try16Bit && Instructions::Base::assertLowRegister(targetReg) && offset <= 124 && offset % 4 == 0) {
-            backend.addInstruction(Instructions::DataProcessing::ldrImmediate32(targetReg, B_Pointer , offset));
-        } else if (offset <= LDR_TRESHOLD) {
+        if (offset <= LDR_TRESHOLD) { // narrowed to 16-bit by the backend if the register and offset allow it
             backend.addInstruction(Instructions::DataProcessing::ldrImmediate32(targetReg, B_Pointer , offset));
         } else {
             // no fallback is provided as it is absolutely essential for performance that no extra instructions are wasted for b loads
@@ -91,52 +126,376 @@ void JIT::Generators::Gemm::emitLoadB(JIT::Instructions::Register targetReg, Mic
     }
 }
 
-void JIT::Generators::Gemm::emitLoadStoreC(MicroKernelConfiguration & configuration, Instructions::VectorRegister targetReg, uint32_t ldc, bool store) {
-    #ifdef FLAG_NO_C_LOAD
-    if (!store) {
-        backend.addInstruction(Instructions::Vector::vmovImmediate(targetReg, 0, Instructions::I32));
-        return;
+void JIT::Generators::Gemm::emitScaleC(MicroKernelConfiguration & configuration, Instructions::VectorRegister targetReg, bool store) {
+    // combineC: the accumulators are scaled by emitCombineC, storesScaled: by emitDeferredStores before the epilogue
+    if (store ? !configuration.scaleResult || configuration.combineC || configuration.storesScaled : !configuration.scaleLoadedC) return;
+    emitScale(configuration, targetReg, store ? configuration.alpha : configuration.betaOverAlpha);
+}
+
+void JIT::Generators::Gemm::emitScale(MicroKernelConfiguration & configuration, Instructions::VectorRegister targetReg, uint32_t scale) {
+    if (!configuration.scaleRegisterValid || configuration.scaleRegisterValue != scale) {
+        backend.addMoveImmediate(SCALE_REGISTER, scale);
+        configuration.scaleRegisterValid = true;
+        configuration.scaleRegisterValue = scale;
+    }
+    backend.addInstruction(Instructions::Vector::vmulVectorByScalar(targetReg, targetReg, SCALE_REGISTER));
+}
+
+static bool hasLowerBound(JIT::Generators::Gemm::Epilogue const & epilogue) {
+    return epilogue.activation != JIT::Generators::Gemm::Epilogue::ACTIVATION_NONE;
+}
+
+static bool hasUpperBound(JIT::Generators::Gemm::Epilogue const & epilogue) {
+    return epilogue.activation == JIT::Generators::Gemm::Epilogue::ACTIVATION_RELU6 || epilogue.activation == JIT::Generators::Gemm::Epilogue::ACTIVATION_CLAMP;
+}
+
+// bit patterns of the bounds of the activation, +0.0f is set with VMOV
+static uint32_t lowerBoundBits(JIT::Generators::Gemm::Epilogue const & epilogue) {
+    bool const relu = epilogue.activation == JIT::Generators::Gemm::Epilogue::ACTIVATION_RELU || epilogue.activation == JIT::Generators::Gemm::Epilogue::ACTIVATION_RELU6;
+    return relu ? 0 : std::bit_cast<uint32_t>(epilogue.clampMin);
+}
+
+static uint32_t upperBoundBits(JIT::Generators::Gemm::Epilogue const & epilogue) {
+    return epilogue.activation == JIT::Generators::Gemm::Epilogue::ACTIVATION_RELU6 ? std::bit_cast<uint32_t>(6.0f) : std::bit_cast<uint32_t>(epilogue.clampMax);
+}
+
+/*
+Moves the bias pointer to the first row / column of the microkernel.
+*/
+void JIT::Generators::Gemm::emitBiasPointer(MicroKernelConfiguration & configuration) {
+    Epilogue const & epilogue = configuration.epilogue;
+    if (epilogue.bias == Epilogue::BIAS_NONE) return;
+    bool const rowBias = epilogue.bias == Epilogue::BIAS_PER_ROW;
+    uint32_t const offset = rowBias ? configuration.epilogueRowOffset : configuration.epilogueColumnOffset;
+    uint32_t const address = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(epilogue.biasValues));
+    if (offset == EPILOGUE_OFFSET_FROM_LOOP) {
+        backend.addMoveImmediate(Bias_Pointer, address);
+        backend.addInstruction(Instructions::Arithmetic::addRegister32(Bias_Pointer, rowBias ? I_Loop_Register : J_Loop_Register, Instructions::LSL, 2));
+    } else {
+        backend.addMoveImmediate(Bias_Pointer, address + offset * DT_SIZE);
+    }
+}
+
+/*
+Prepares the epilogue after the k loop of the strided microkernels: the bias pointer is set and the bounds of the activation
+are allocated to the free A registers. Q7 holds the gather offsets of a transposed A and the row bias needs a temp register,
+so bounds which don't fit are reloaded from the GP registers before each use.
+*/
+void JIT::Generators::Gemm::emitEpilogueSetup(MicroKernelConfiguration & configuration) {
+    Epilogue const & epilogue = configuration.epilogue;
+    bool const rowBias = epilogue.bias == Epilogue::BIAS_PER_ROW;
+    emitBiasPointer(configuration);
+
+    bool const lower = hasLowerBound(epilogue);
+    bool const upper = hasUpperBound(epilogue);
+    RegisterAllocator allocator;
+    if (!configuration.transposeA) allocator.addVectorRegister(A1_Register);
+    allocator.addVectorRegister(A0_Register);
+    RegisterAllocator::Interval const lowerInterval = lower ? allocator.addVectorInterval(EPILOGUE_SETUP, EPILOGUE_END, 2) : RegisterAllocator::NO_INTERVAL;
+    RegisterAllocator::Interval const upperInterval = upper ? allocator.addVectorInterval(EPILOGUE_SETUP, EPILOGUE_END, 1) : RegisterAllocator::NO_INTERVAL;
+    // the temp register must never be spilled
+    RegisterAllocator::Interval tempInterval = rowBias ? allocator.addVectorInterval(EPILOGUE_BIAS, EPILOGUE_END, UINT8_MAX) : RegisterAllocator::NO_INTERVAL;
+    allocator.allocate();
+    bool const spilled = (lower && !allocator.isAllocated(lowerInterval)) || (upper && !allocator.isAllocated(upperInterval));
+    if (spilled && tempInterval == RegisterAllocator::NO_INTERVAL) {
+        // spilled bounds are reloaded into the temp register
+        tempInterval = allocator.addVectorInterval(EPILOGUE_BIAS, EPILOGUE_END, UINT8_MAX);
+        allocator.allocate();
+    }
+    configuration.epilogueTempVector = allocator.isAllocated(tempInterval) ? allocator.getVectorRegister(tempInterval) : A0_Register;
+    configuration.reloadLowerBound = lower && !allocator.isAllocated(lowerInterval);
+    configuration.lowerBoundVector = allocator.isAllocated(lowerInterval) ? allocator.getVectorRegister(lowerInterval) : configuration.epilogueTempVector;
+    configuration.reloadUpperBound = upper && !allocator.isAllocated(upperInterval);
+    configuration.upperBoundVector = allocator.isAllocated(upperInterval) ? allocator.getVectorRegister(upperInterval) : configuration.epilogueTempVector;
+
+    uint32_t const lowerBound = lowerBoundBits(epilogue);
+    uint32_t const upperBound = upperBoundBits(epilogue);
+    // +0.0f is set with VMOV, all other bounds are duplicated from a GP register
+    if (lower && lowerBound != 0) backend.addMoveImmediate(Lower_Bound_Register, lowerBound);
+    if (lower && !configuration.reloadLowerBound) {
+        if (lowerBound == 0) backend.addInstruction(Instructions::Vector::vmovImmediate(configuration.lowerBoundVector, 0, Instructions::I32));
+        else backend.addInstruction(Instructions::Vector::vdup(configuration.lowerBoundVector, Lower_Bound_Register));
+    }
+    if (upper && upperBound != 0) backend.addMoveImmediate(Upper_Bound_Register, upperBound);
+    if (upper && !configuration.reloadUpperBound) {
+        if (upperBound == 0) backend.addInstruction(Instructions::Vector::vmovImmediate(configuration.upperBoundVector, 0, Instructions::I32));
+        else backend.addInstruction(Instructions::Vector::vdup(configuration.upperBoundVector, Upper_Bound_Register));
+    }
+    // the values are needed to reload the bounds
+    configuration.epilogueLowerBound = lowerBound;
+    configuration.epilogueUpperBound = upperBound;
+}
+
+/*
+Applies the bias and the activation to the scaled accumulator of the given column and vector of the microkernel.
+*/
+void JIT::Generators::Gemm::emitEpilogue(MicroKernelConfiguration & configuration, Instructions::VectorRegister targetReg, uint32_t column, uint32_t vector, bool predicated) {
+    Epilogue const & epilogue = configuration.epilogue;
+    if (epilogue.bias == Epilogue::BIAS_PER_ROW) {
+        // the bias ends with the last row of C
+        if (predicated) backend.addInstruction(Instructions::Vector::vpst(1));
+        backend.addInstruction(Instructions::Vector::vldrw(configuration.epilogueTempVector, Bias_Pointer, vector * VECTOR_SIZE));
+        backend.addInstruction(Instructions::Vector::vaddFloat(targetReg, targetReg, configuration.epilogueTempVector));
+    } else if (epilogue.bias == Epilogue::BIAS_PER_COLUMN) {
+        if (vector == 0) backend.addInstruction(Instructions::DataProcessing::ldrImmediate32(Bias_Register, Bias_Pointer, column * DT_SIZE));
+        backend.addInstruction(Instructions::Vector::vaddFloatScalar(targetReg, targetReg, Bias_Register));
+    }
+    if (hasLowerBound(epilogue)) {
+        if (configuration.reloadLowerBound) {
+            if (configuration.epilogueLowerBound == 0) backend.addInstruction(Instructions::Vector::vmovImmediate(configuration.epilogueTempVector, 0, Instructions::I32));
+            else backend.addInstruction(Instructions::Vector::vdup(configuration.epilogueTempVector, Lower_Bound_Register));
+        }
+        backend.addInstruction(Instructions::Vector::vmaxnm(targetReg, targetReg, configuration.lowerBoundVector));
+    }
+    if (hasUpperBound(epilogue)) {
+        if (configuration.reloadUpperBound) {
+            if (configuration.epilogueUpperBound == 0) backend.addInstruction(Instructions::Vector::vmovImmediate(configuration.epilogueTempVector, 0, Instructions::I32));
+            else backend.addInstruction(Instructions::Vector::vdup(configuration.epilogueTempVector, Upper_Bound_Register));
+        }
+        backend.addInstruction(Instructions::Vector::vminnm(targetReg, targetReg, configuration.upperBoundVector));
+    }
+}
+
+// column and vector of the accumulator Qreg in the NN microkernel which is selected by m
+static void deferredPosition(uint32_t m, uint32_t reg, uint32_t & column, uint32_t & vector) {
+    if (m <= 4) { // C00, C10, C20 are Q0, Q2, Q4 and C30, C40, C50 are Q1, Q3, Q5
+        column = reg / 2 + (reg % 2) * 3;
+        vector = 0;
+    } else if (m <= 8) {
+        column = reg / 2;
+        vector = reg % 2;
+    } else {
+        column = 0;
+        vector = reg;
+    }
+}
+
+/*
+Applies the epilogue to the scaled accumulators of an NN microkernel before emitDeferredStores stores them (bit i of deferred: Qi).
+Each step is emitted for all accumulators before the next one, so they don't wait for each other, and a row bias vector is loaded
+once for all columns. A0 and A1 are free: they hold the row bias, afterwards the bounds.
+*/
+void JIT::Generators::Gemm::emitDeferredEpilogue(MicroKernelConfiguration & configuration, uint32_t m, uint32_t deferred) {
+    Epilogue const & epilogue = configuration.epilogue;
+    uint32_t const vectors = m <= 4 ? 1 : m <= 8 ? 2 : (m + VECTOR_ELEMENTS - 1) / VECTOR_ELEMENTS;
+    uint32_t const columns = m <= 4 ? 6 : m <= 8 ? 3 : 1;
+    emitBiasPointer(configuration);
+    if (epilogue.bias == Epilogue::BIAS_PER_ROW) {
+        for (uint32_t vector = 0; vector < vectors; vector++) {
+            Instructions::VectorRegister const biasReg = vector % 2 == 0 ? A0_Register : A1_Register;
+            // the bias ends with the last row of C, the partially used vector is predicated like its stores
+            bool const partial = configuration.predicateStores && (m <= 4 || (m <= 8 ? vector == 1 : (vector + 1) * VECTOR_ELEMENTS > m));
+            if (partial) backend.addInstruction(Instructions::Vector::vpst(1));
+            backend.addInstruction(Instructions::Vector::vldrw(biasReg, Bias_Pointer, vector * VECTOR_SIZE));
+            for (uint32_t reg = 0; reg < VECTOR_COUNT; reg++) {
+                uint32_t column, regVector;
+                deferredPosition(m, reg, column, regVector);
+                if (deferred & (1u << reg) && regVector == vector) {
+                    Instructions::VectorRegister const targetReg = static_cast<Instructions::VectorRegister>(reg);
+                    backend.addInstruction(Instructions::Vector::vaddFloat(targetReg, targetReg, biasReg));
+                }
+            }
+        }
+    } else if (epilogue.bias == Epilogue::BIAS_PER_COLUMN) {
+        for (uint32_t column = 0; column < columns; column++) {
+            // alternating registers, the lower bound is set up afterwards
+            Instructions::Register const biasReg = column % 2 == 0 ? Bias_Register : Lower_Bound_Register;
+            bool loaded = false;
+            for (uint32_t reg = 0; reg < VECTOR_COUNT; reg++) {
+                uint32_t regColumn, vector;
+                deferredPosition(m, reg, regColumn, vector);
+                if (!(deferred & (1u << reg)) || regColumn != column) continue;
+                if (!loaded) backend.addInstruction(Instructions::DataProcessing::ldrImmediate32(biasReg, Bias_Pointer, column * DT_SIZE));
+                loaded = true;
+                Instructions::VectorRegister const targetReg = static_cast<Instructions::VectorRegister>(reg);
+                backend.addInstruction(Instructions::Vector::vaddFloatScalar(targetReg, targetReg, biasReg));
+            }
+        }
+    }
+
+    // B_Pointer is still needed, the upper bound is moved through the bias register
+    bool const lower = hasLowerBound(epilogue);
+    bool const upper = hasUpperBound(epilogue);
+    uint32_t const lowerBound = lowerBoundBits(epilogue);
+    uint32_t const upperBound = upperBoundBits(epilogue);
+    if (lower && lowerBound == 0) backend.addInstruction(Instructions::Vector::vmovImmediate(A0_Register, 0, Instructions::I32));
+    else if (lower) {
+        backend.addMoveImmediate(Lower_Bound_Register, lowerBound);
+        backend.addInstruction(Instructions::Vector::vdup(A0_Register, Lower_Bound_Register));
+    }
+    if (upper && upperBound == 0) backend.addInstruction(Instructions::Vector::vmovImmediate(A1_Register, 0, Instructions::I32));
+    else if (upper) {
+        backend.addMoveImmediate(Bias_Register, upperBound);
+        backend.addInstruction(Instructions::Vector::vdup(A1_Register, Bias_Register));
+    }
+    for (uint32_t reg = 0; reg < VECTOR_COUNT; reg++) {
+        Instructions::VectorRegister const targetReg = static_cast<Instructions::VectorRegister>(reg);
+        if (lower && deferred & (1u << reg)) backend.addInstruction(Instructions::Vector::vmaxnm(targetReg, targetReg, A0_Register));
+    }
+    for (uint32_t reg = 0; reg < VECTOR_COUNT; reg++) {
+        Instructions::VectorRegister const targetReg = static_cast<Instructions::VectorRegister>(reg);
+        if (upper && deferred & (1u << reg)) backend.addInstruction(Instructions::Vector::vminnm(targetReg, targetReg, A1_Register));
+    }
+}
+
+/*
+C = alpha * A * B + beta * C for an alpha which is not a power of two (see MicroKernelConfiguration::combineC):
+the accumulator is scaled by alpha and C, which the caller loaded into A0, is added with VFMA by beta (held in B0).
+*/
+void JIT::Generators::Gemm::emitCombineC(MicroKernelConfiguration & configuration, Instructions::VectorRegister targetReg) {
+    emitScale(configuration, targetReg, configuration.alpha);
+    backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(targetReg, A0_Register, B0_Register));
+}
+
+/*
+Emits the C stores which the NN microkernels collected while accumulating the last k iteration (see MicroKernelConfiguration::deferStores).
+The microkernel is selected by m like in generateMicroKernel.
+*/
+void JIT::Generators::Gemm::emitDeferredStores(MicroKernelConfiguration & configuration, uint32_t m, uint32_t ldc) {
+    uint32_t const count = configuration.deferredStoreCount;
+    configuration.deferStores = false;
+    configuration.deferredStoreCount = 0;
+    if (configuration.combineC) {
+        backend.addMoveImmediate(B0_Register, configuration.beta);
+        uint32_t const imm = ldc * DT_SIZE;
+        for (uint32_t i = 0; i < count; i++) {
+            Instructions::VectorRegister const targetReg = configuration.deferredStores[i];
+            if (m <= 4) { // the columns of the 4x6 microkernel are stored in order by advancing the C pointer
+                if (imm > VLDR_TRESHOLD) {
+                    backend.addInstruction(Instructions::Vector::vldrw(A0_Register, C_Pointer));
+                    backend.addAddImmediate(C_Pointer, C_Pointer, imm, DLS_COUNT_REGISTER);
+                } else {
+                    backend.addInstruction(Instructions::Vector::vldrw(A0_Register, C_Pointer, imm, false, true));
+                }
+            } else if (m <= 8) {
+                uint32_t offset;
+                Instructions::Register const baseReg = emitAddressC(configuration, targetReg, ldc, offset);
+                backend.addInstruction(Instructions::Vector::vldrw(A0_Register, baseReg, offset));
+            } else {
+                backend.addInstruction(Instructions::Vector::vldrw(A0_Register, C_Pointer, targetReg * VECTOR_SIZE));
+            }
+            emitCombineC(configuration, targetReg);
+        }
+        if (m <= 4) backend.addAddImmediate(C_Pointer, C_Pointer, count * imm, DLS_COUNT_REGISTER, true);
+    }
+    if (configuration.hasEpilogue) {
+        uint32_t deferred = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            deferred |= 1u << configuration.deferredStores[i];
+            emitScaleC(configuration, configuration.deferredStores[i], true);
+        }
+        emitDeferredEpilogue(configuration, m, deferred);
+        configuration.storesScaled = true;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        Instructions::VectorRegister const targetReg = configuration.deferredStores[i];
+        if (m <= 4) emitLoadStoreC46(configuration, targetReg, ldc, true);
+        else if (m <= 8) emitLoadStoreC(configuration, targetReg, ldc, true);
+        else emitStoreC16(configuration, targetReg, configuration.predicateStores && (targetReg + 1) * VECTOR_ELEMENTS > m);
     }
-    #endif
-    if (targetReg == C00_Register || targetReg == C01_Register) {
-        if (store) backend.addInstruction(Instructions::Vector::vstrw(targetReg, C_Pointer, targetReg == C01_Register ? 16 : 0));
-        else backend.addInstruction(Instructions::Vector::vldrw(targetReg, C_Pointer, targetReg == C01_Register ? 16 : 0));
+    configuration.storesScaled = false;
+}
+
+/*
+Advances A by the given number of columns in the 16x1 microkernel: one column with the lda register if it was allocated,
+otherwise ADDW or a constant in B1 (only loaded and used inside the unrolled k loop, so it is free between the FMAs)
+*/
+void JIT::Generators::Gemm::emitAdvanceA16(MicroKernelConfiguration & configuration, uint32_t columns, uint32_t lda) {
+    if (configuration.registerStrategy & USE_A_ADD_REGISTER && columns == 1) {
+        backend.addInstruction(Instructions::Arithmetic::addRegister32(A_Pointer, configuration.A_ADD_REGISTER));
     } else {
-        bool secondRow = targetReg == C20_Register || targetReg == C21_Register;
-        bool rightSide = targetReg == C11_Register || targetReg == C21_Register;
+        backend.addAddImmediate(A_Pointer, A_Pointer, columns * lda * DT_SIZE, B1_Register);
+    }
+}
+
+void JIT::Generators::Gemm::emitStoreC16(MicroKernelConfiguration & configuration, Instructions::VectorRegister targetReg, bool predicated) {
+    if (configuration.deferStores) {
+        configuration.deferredStores[configuration.deferredStoreCount++] = targetReg;
+        return;
+    }
+    emitScaleC(configuration, targetReg, true);
+    if (predicated) backend.addInstruction(Instructions::Vector::vpst(1));
+    backend.addInstruction(Instructions::Vector::vstrw(targetReg, C_Pointer, targetReg * VECTOR_SIZE));
+}
+
+/*
+Base register and offset of the vector of C which targetReg holds in the 8x3 microkernel.
+Offsets which VLDRW/VSTRW can't encode are added to the C pointer in DLS_COUNT_REGISTER.
+*/
+JIT::Instructions::Register JIT::Generators::Gemm::emitAddressC(MicroKernelConfiguration & configuration, Instructions::VectorRegister targetReg, uint32_t ldc, uint32_t & offset) {
+    bool secondRow = targetReg == C20_Register || targetReg == C21_Register;
+    bool rightSide = targetReg == C01_Register || targetReg == C11_Register || targetReg == C21_Register;
+    Instructions::Register baseReg = C_Pointer;
+    offset = rightSide ? 4 * DT_SIZE : 0;
+    if (targetReg != C00_Register && targetReg != C01_Register) {
         if ((configuration.registerStrategy & USE_CROW2_REGISTER && secondRow) || (configuration.registerStrategy & USE_CROW1_REGISTER && !secondRow)) {
-            if (store) backend.addInstruction(Instructions::Vector::vstrw(targetReg, secondRow ? configuration.CROW2_REGISTER : configuration.CROW1_REGISTER, rightSide ? 16 : 0));
-            else backend.addInstruction(Instructions::Vector::vldrw(targetReg, secondRow ? configuration.CROW2_REGISTER : configuration.CROW1_REGISTER, rightSide ? 16 : 0));
+            baseReg = secondRow ? configuration.CROW2_REGISTER : configuration.CROW1_REGISTER;
         } else {
-            uint32_t offset = secondRow ? 2 * DT_SIZE * ldc : DT_SIZE * ldc;
-            if (rightSide) offset += 4 * DT_SIZE;
-            if (offset <= VLDR_TRESHOLD) {
-                if (store) backend.addInstruction(Instructions::Vector::vstrw(targetReg, C_Pointer, offset));
-                else backend.addInstruction(Instructions::Vector::vldrw(targetReg, C_Pointer, offset));
-            } else {
+            offset += secondRow ? 2 * DT_SIZE * ldc : DT_SIZE * ldc;
+            if (offset > VLDR_TRESHOLD) {
                 if (offset > LDR_TRESHOLD) {
-                    if (offset > MOV_TRESHOLD) backend.addInstruction(Instructions::DataProcessing::movtImmediate32(DLS_COUNT_REGISTER, offset >> 16));
-                    backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, offset));
+                    backend.addMoveImmediate(DLS_COUNT_REGISTER, offset);
                     backend.addInstruction(Instructions::Arithmetic::addRegister32(DLS_COUNT_REGISTER, C_Pointer));
                 } else {
                     backend.addInstruction(Instructions::Arithmetic::addImmediate32(DLS_COUNT_REGISTER, C_Pointer, offset));
                 }
-                if (store) backend.addInstruction(Instructions::Vector::vstrw(targetReg, DLS_COUNT_REGISTER));
-                else backend.addInstruction(Instructions::Vector::vldrw(targetReg, DLS_COUNT_REGISTER));
+                baseReg = DLS_COUNT_REGISTER;
+                offset = 0;
             }
         }
     }
+    return baseReg;
+}
+
+void JIT::Generators::Gemm::emitLoadStoreC(MicroKernelConfiguration & configuration, Instructions::VectorRegister targetReg, uint32_t ldc, bool store) {
+    // beta == 0: C is only written
+    if (!store && !configuration.loadC) {
+        backend.addInstruction(Instructions::Vector::vmovImmediate(targetReg, 0, Instructions::I32));
+        return;
+    }
+    if (store && configuration.deferStores) {
+        configuration.deferredStores[configuration.deferredStoreCount++] = targetReg;
+        return;
+    }
+    if (store) {
+        backend.annotate("C store");
+        emitScaleC(configuration, targetReg, true);
+    }
 
+    bool rightSide = targetReg == C01_Register || targetReg == C11_Register || targetReg == C21_Register;
+    uint32_t offset;
+    Instructions::Register const baseReg = emitAddressC(configuration, targetReg, ldc, offset);
+    if (store) {
+        // only the right side is partially used in the 8x3 microkernel
+        if (configuration.predicateStores && rightSide) backend.addInstruction(Instructions::Vector::vpst(1));
+        backend.addInstruction(Instructions::Vector::vstrw(targetReg, baseReg, offset));
+    } else {
+        backend.addInstruction(Instructions::Vector::vldrw(targetReg, baseReg, offset));
+        emitScaleC(configuration, targetReg, false);
+    }
 }
 
-void JIT::Generators::Gemm::emitLoadStoreC46(Instructions::VectorRegister targetReg, uint32_t ldc, bool store) {
+void JIT::Generators::Gemm::emitLoadStoreC46(MicroKernelConfiguration & configuration, Instructions::VectorRegister targetReg, uint32_t ldc, bool store) {
+    // beta == 0: C is only written. the pointer is not advanced, so it isn't restored after the first iteration
+    if (!store && !configuration.loadC) {
+        backend.addInstruction(Instructions::Vector::vmovImmediate(targetReg, 0, Instructions::I32));
+        return;
+    }
+    if (store && configuration.deferStores) {
+        configuration.deferredStores[configuration.deferredStoreCount++] = targetReg;
+        return;
+    }
+    if (store) {
+        backend.annotate("C store");
+        emitScaleC(configuration, targetReg, true);
+        if (configuration.predicateStores) backend.addInstruction(Instructions::Vector::vpst(1));
+    }
     uint32_t imm = ldc * DT_SIZE;
     if (imm > VLDR_TRESHOLD) {
         if (store) backend.addInstruction(Instructions::Vector::vstrw(targetReg, C_Pointer));
         else backend.addInstruction(Instructions::Vector::vldrw(targetReg, C_Pointer));
         if (imm > LDR_TRESHOLD) {
-            if (imm > MOV_TRESHOLD) backend.addInstruction(Instructions::DataProcessing::movtImmediate32(DLS_COUNT_REGISTER, imm >> 16));
-            backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, imm));
+            backend.addMoveImmediate(DLS_COUNT_REGISTER, imm);
             backend.addInstruction(Instructions::Arithmetic::addRegister32(C_Pointer, DLS_COUNT_REGISTER));
         } else {
             backend.addInstruction(Instructions::Arithmetic::addImmediate32(C_Pointer, imm));
@@ -145,6 +504,22 @@ void JIT::Generators::Gemm::emitLoadStoreC46(Instructions::VectorRegister target
         if (store) backend.addInstruction(Instructions::Vector::vstrw(targetReg, C_Pointer, imm, false, true));
         else backend.addInstruction(Instructions::Vector::vldrw(targetReg, C_Pointer, imm, false, true));
     }
+    if (!store) emitScaleC(configuration, targetReg, false);
+}
+
+/*
+The right vector of the 8x3 microkernel holds rows 4-7. At a compile-time edge the count of its used rows is m % 4,
+at a predicated edge (see MicroKernelConfiguration::predicatedEdge) it is m - 4 - i, which VCTP saturates to a full
+predicate for all blocks but the last one.
+*/
+void JIT::Generators::Gemm::emitRightSidePredicate(uint32_t m, MicroKernelConfiguration & configuration) {
+    if (configuration.predicatedEdge) {
+        backend.addMoveImmediate(DLS_COUNT_REGISTER, configuration.edgeRows - VECTOR_ELEMENTS);
+        backend.addInstruction(Instructions::Arithmetic::subRegister32(DLS_COUNT_REGISTER, DLS_COUNT_REGISTER, I_Loop_Register));
+    } else {
+        backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, m % VECTOR_ELEMENTS));
+    }
+    backend.addInstruction(Instructions::Vector::vctp(Instructions::Size32, DLS_COUNT_REGISTER));
 }
 
 void JIT::Generators::Gemm::generateMicroKernel(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, MicroKernelConfiguration & configuration) {
@@ -162,10 +537,22 @@ void JIT::Generators::Gemm::generateMicroKernel(uint32_t m, uint32_t k, uint32_t
     // if the immediate for loading from A can't be encoded in VLDR we have to add to the pointer earlier
     bool aNeedsPreadd = lda * DT_SIZE > VLDR_TRESHOLD;
     // if not all elements fit into a single vector register, the instructions have to be predicated
-    bool predicated = m % VECTOR_ELEMENTS != 0;
+    bool predicated = m % VECTOR_ELEMENTS != 0 || configuration.predicatedEdge;
+    // C is added and the epilogue is applied after the last FMAs, which need all registers before
+    configuration.deferStores = configuration.combineC || configuration.hasEpilogue;
+    configuration.deferredStoreCount = 0;
+    // when scaling C the VMULs would end up in the VPT blocks (deferred stores leave them), so only the stores are predicated
+    // the same holds for the address of a C row of the 8x3 microkernel which VLDRW / VSTRW can't reach (see emitAddressC)
+    bool const secondRowAddress = n >= 2 && !(configuration.registerStrategy & USE_CROW1_REGISTER) && DT_SIZE * ldc + 4 * DT_SIZE > VLDR_TRESHOLD;
+    bool const thirdRowAddress = n >= 3 && !(configuration.registerStrategy & USE_CROW2_REGISTER) && 2 * DT_SIZE * ldc + 4 * DT_SIZE > VLDR_TRESHOLD;
+    bool const cNeedsAddress = m > 4 && m <= 8 && (secondRowAddress || thirdRowAddress);
+    configuration.predicateStores = predicated && (configuration.scaleLoadedC || configuration.scaleResult || configuration.predicatedEdge || configuration.deferStores || cNeedsAddress);
+    bool blockPredicated = predicated && !configuration.predicateStores;
+    // microkernels may be placed in loops, so the scale register has to be loaded again
+    configuration.scaleRegisterValid = false;
     // determine amount of k loop unrolling depending on the amount of possible skipped ADDs (possible if we can still encode next immediate with VLDR)
     uint32_t unrollK = VLDR_TRESHOLD / (DT_SIZE * lda);
-    unrollK = unrollK > K_MAX_UNROLL ? K_MAX_UNROLL : unrollK; // limit k unrolling (priorize code size over (really small) performance gain)
+    unrollK = unrollK > configuration.kMaxUnroll ? configuration.kMaxUnroll : unrollK; // limit k unrolling (priorize code size over (really small) performance gain)
     unrollK = unrollK > kMiddle ? kMiddle : unrollK; // limit unrolling if k is small
     unrollK = unrollK < 1 ? 1 : unrollK; // at least one iteration
     // we can omit the loop if we have only one iteration anyways (and k must be large enough; if k == 1, kMiddle == -1 == INT_MAX-1)
@@ -176,8 +563,7 @@ void JIT::Generators::Gemm::generateMicroKernel(uint32_t m, uint32_t k, uint32_t
         if (configuration.registerStrategy & USE_BCOL3_REGISTER) {
             uint32_t imm = 3 * ldb * DT_SIZE;
             if (imm > LDR_TRESHOLD) {
-                if (imm > MOV_TRESHOLD) backend.addInstruction(Instructions::DataProcessing::movtImmediate32(configuration.BCOL3_REGISTER, imm >> 16));
-                backend.addInstruction(Instructions::DataProcessing::movImmediate32(configuration.BCOL3_REGISTER, imm));
+                backend.addMoveImmediate(configuration.BCOL3_REGISTER, imm);
                 backend.addInstruction(Instructions::Arithmetic::addRegister32(configuration.BCOL3_REGISTER, B_Pointer));
             } else backend.addInstruction(Instructions::Arithmetic::addImmediate32(configuration.BCOL3_REGISTER, B_Pointer, imm));
         }
@@ -185,7 +571,7 @@ void JIT::Generators::Gemm::generateMicroKernel(uint32_t m, uint32_t k, uint32_t
         if (n >= 2) emitLoadB(B1_Register, configuration, 2, DT_SIZE * ldb); // load b[ldb]
         if (n >= 3) emitLoadB(B2_Register, configuration, 3, 2 * DT_SIZE * ldb); // load b[2ldb]
         backend.addHeliumInstruction(Instructions::Vector::vldrw(A0_Register, A_Pointer)); // load a[0]
-        uint32_t vldrImmA = ldc * DT_SIZE;
+        uint32_t vldrImmA = lda * DT_SIZE;
         // if immediate doesn't fit into VLDR
         if (configuration.registerStrategy & USE_A_ADD_REGISTER) { //  we can use extra register with lda stored
             backend.addInstruction(Instructions::Arithmetic::addRegister32(A_Pointer, configuration.A_ADD_REGISTER));
@@ -194,33 +580,34 @@ void JIT::Generators::Gemm::generateMicroKernel(uint32_t m, uint32_t k, uint32_t
             if (vldrImmA < LDR_TRESHOLD) {
                 backend.addInstruction(Instructions::Arithmetic::addImmediate32(A_Pointer, lda * DT_SIZE));
             } else {
-                if (vldrImmA > MOV_TRESHOLD) backend.addInstruction(Instructions::DataProcessing::movtImmediate32(DLS_COUNT_REGISTER, vldrImmA >> 16));
-                backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, vldrImmA));
+                backend.addMoveImmediate(DLS_COUNT_REGISTER, vldrImmA);
                 backend.addInstruction(Instructions::Arithmetic::addRegister32(A_Pointer, DLS_COUNT_REGISTER));
             }
             vldrImmA = 0;
         }
         // load b[0] is emitted last in the first block of b load as it will perform a write back to step forward one row for the next k iteration
         backend.addInstruction(Instructions::DataProcessing::ldrImmediate32(B0_Register, B_Pointer, DT_SIZE, false, true)); // load b[0]
+        // k == 1 stores each column right after loading it, which advances the C pointer. deferred stores come after all loads
+        uint32_t const loadLdc = k > 1 || configuration.deferStores ? ldc : 0;
         if (predicated && k == 1) {
             backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, m % VECTOR_ELEMENTS));
             backend.addInstruction(Instructions::Vector::vctp(Instructions::Size32, DLS_COUNT_REGISTER));
-            backend.addInstruction(Instructions::Vector::vpst(3));
+            if (blockPredicated) backend.addInstruction(Instructions::Vector::vpst(3));
         }
-        emitLoadStoreC46(C00_Register, k > 1 ? ldc : 0); // load c[0][0-3]
+        emitLoadStoreC46(configuration, C00_Register, loadLdc); // load c[0][0-3]
         backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(C00_Register, A0_Register, B0_Register)); // vfma c[0][0]
-        if (k == 1) emitLoadStoreC46(C00_Register, ldc, true);
+        if (k == 1) emitLoadStoreC46(configuration, C00_Register, ldc, true);
         if (n >= 2) {
-            if (predicated && k == 1) backend.addInstruction(Instructions::Vector::vpst(3));
-            emitLoadStoreC46(C10_Register, k > 1 ? ldc : 0); // load c[1][0-3]
+            if (blockPredicated && k == 1) backend.addInstruction(Instructions::Vector::vpst(3));
+            emitLoadStoreC46(configuration, C10_Register, loadLdc); // load c[1][0-3]
             backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(C10_Register, A0_Register, B1_Register)); // vfma c[1][0...]
-            if (k == 1) emitLoadStoreC46(C10_Register, ldc, true);
+            if (k == 1) emitLoadStoreC46(configuration, C10_Register, ldc, true);
         }
         if (n >= 3) {
-            if (predicated && k == 1) backend.addInstruction(Instructions::Vector::vpst(3));
-            emitLoadStoreC46(C20_Register, k > 1 ? ldc : 0); // load c[2][0...]
+            if (blockPredicated && k == 1) backend.addInstruction(Instructions::Vector::vpst(3));
+            emitLoadStoreC46(configuration, C20_Register, loadLdc); // load c[2][0...]
             backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(C20_Register, A0_Register, B2_Register)); // vfma c[2][0...]
-            if (k == 1) emitLoadStoreC46(C20_Register, ldc, true);
+            if (k == 1) emitLoadStoreC46(configuration, C20_Register, ldc, true);
         }
 
         if (n >= 5) emitLoadB(B1_Register, configuration, 2, 4 * ldb * DT_SIZE - 4, true); // load b[4ldb]
@@ -229,31 +616,32 @@ void JIT::Generators::Gemm::generateMicroKernel(uint32_t m, uint32_t k, uint32_t
         if (n >= 4) emitLoadB(B0_Register, configuration, 0, 3 * ldb * DT_SIZE - 4, true); // load b[3ldb]
         
         if (n >= 4) {
-            if (predicated && k == 1) backend.addInstruction(Instructions::Vector::vpst(3));
-            emitLoadStoreC46(C30_Register, k > 1 ? ldc : 0);
+            if (blockPredicated && k == 1) backend.addInstruction(Instructions::Vector::vpst(3));
+            emitLoadStoreC46(configuration, C30_Register, loadLdc);
             backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(C30_Register, A0_Register, B0_Register));
-            if (k == 1) emitLoadStoreC46(C30_Register, ldc, true);
+            if (k == 1) emitLoadStoreC46(configuration, C30_Register, ldc, true);
         }
         if (n >= 5) {
-            if (predicated && k == 1) backend.addInstruction(Instructions::Vector::vpst(3));
-            emitLoadStoreC46(C40_Register, k > 1 ? ldc : 0);
+            if (blockPredicated && k == 1) backend.addInstruction(Instructions::Vector::vpst(3));
+            emitLoadStoreC46(configuration, C40_Register, loadLdc);
             backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(C40_Register, A0_Register, B1_Register));
-            if (k == 1) emitLoadStoreC46(C40_Register, ldc, true);
+            if (k == 1) emitLoadStoreC46(configuration, C40_Register, ldc, true);
         }
         if (n >= 6) {
-            if (predicated && k == 1) backend.addInstruction(Instructions::Vector::vpst(3));
-            emitLoadStoreC46(C50_Register, k > 1 ? ldc : 0);
+            if (blockPredicated && k == 1) backend.addInstruction(Instructions::Vector::vpst(3));
+            emitLoadStoreC46(configuration, C50_Register, loadLdc);
             backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(C50_Register, A0_Register, B2_Register));
-            if (k == 1) emitLoadStoreC46(C50_Register, ldc, true);
+            if (k == 1) emitLoadStoreC46(configuration, C50_Register, ldc, true);
         }
 
         // early return for k == 1. only reset c pointer now
         if (k == 1) {
+            if (configuration.deferStores) {
+                if (configuration.loadC) backend.addAddImmediate(C_Pointer, C_Pointer, n * ldc * DT_SIZE, DLS_COUNT_REGISTER, true);
+                emitDeferredStores(configuration, m, ldc);
+            }
             if (n * ldc * DT_SIZE > LDR_TRESHOLD) {
-                if (n * ldc * DT_SIZE > MOV_TRESHOLD) {
-                    backend.addInstruction(Instructions::DataProcessing::movtImmediate32(DLS_COUNT_REGISTER, (n * ldc * DT_SIZE) >> 16));
-                }
-                backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, n * ldc * DT_SIZE));
+                backend.addMoveImmediate(DLS_COUNT_REGISTER, n * ldc * DT_SIZE);
                 backend.addInstruction(Instructions::Arithmetic::subRegister32(C_Pointer, DLS_COUNT_REGISTER));
             } else {
                 backend.addInstruction(Instructions::Arithmetic::subImmediate32(C_Pointer, n * ldc * DT_SIZE));
@@ -269,25 +657,29 @@ void JIT::Generators::Gemm::generateMicroKernel(uint32_t m, uint32_t k, uint32_t
         // to use this, we need to unroll the k loop
         if (needsDls) {
             // handle edge case for really huge k
-            if (kMiddle / unrollK > 65535) backend.addInstruction(Instructions::DataProcessing::movtImmediate32(DLS_COUNT_REGISTER, (kMiddle / unrollK) >> 16));
-            backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, kMiddle / unrollK));
+            backend.addMoveImmediate(DLS_COUNT_REGISTER, kMiddle / unrollK);
         }
 
         /* Load B */
         if (n >= 2) emitLoadB(B1_Register, configuration, 2, DT_SIZE * ldb); // load b[ldb]
         if (n >= 3) emitLoadB(B2_Register, configuration, 3, 2 * DT_SIZE * ldb); // load b[2ldb]
 
-        Instructions::Instruction16 * kLoopStart;
-        if (needsDls) backend.addInstruction(Instructions::Base::dls(DLS_COUNT_REGISTER));
+        IR::Program::Label const kLoopStart = backend.newLabel();
+        if (needsDls) {
+            backend.addInstruction(Instructions::Base::dls(DLS_COUNT_REGISTER));
+            configuration.scaleRegisterValid = false; // DLS overwrites LR
+        }
         if (k >= 3) {
             for (uint32_t i = 0; i < unrollK; i++) { // unroll k loop
                 // first iteration of unrolling (for large M there will be no unrolling)
                 // in the first iteration we have to set the starting point of the loop
                 if (i == 0) {
                     // for 4x1 microkernel we have to omit the vfma c[1][0...]
-                    if (n == 1) kLoopStart = backend.addBranchTargetInstruction(Instructions::DataProcessing::ldrImmediate32(B0_Register, B_Pointer, DT_SIZE, false, true)); // 
+                    backend.annotate("k-loop start");
+                    backend.bindLabel(kLoopStart);
+                    if (n == 1) backend.addInstruction(Instructions::DataProcessing::ldrImmediate32(B0_Register, B_Pointer, DT_SIZE, false, true));
                     else {
-                        kLoopStart = backend.addBranchTargetInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(C10_Register, A0_Register, B1_Register));
+                        backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(C10_Register, A0_Register, B1_Register));
                         backend.addInstruction(Instructions::DataProcessing::ldrImmediate32(B0_Register, B_Pointer, DT_SIZE, false, true));
                     }
                 } else { // in all other iterations no starting point is set
@@ -312,16 +704,13 @@ void JIT::Generators::Gemm::generateMicroKernel(uint32_t m, uint32_t k, uint32_t
             if (skipAdds <= LDR_TRESHOLD) {
                 backend.addInstruction(Instructions::Arithmetic::addImmediate32(A_Pointer, skipAdds));
             } else {
-                if (skipAdds > MOV_TRESHOLD) {
-                    backend.addInstruction(Instructions::DataProcessing::movtImmediate32(DLS_COUNT_REGISTER, skipAdds >> 16));
-                }
-                backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, skipAdds));
+                backend.addMoveImmediate(DLS_COUNT_REGISTER, skipAdds);
                 backend.addInstruction(Instructions::Arithmetic::addRegister32(A_Pointer, DLS_COUNT_REGISTER));
             }
             // if immediate doesn't fit place vldr for next A load at the end after adding the immediate (loop isn't unrolled then)
             if (aNeedsPreadd) backend.addInstruction(Instructions::Vector::vldrw(A0_Register, A_Pointer));
         }
-        if (needsDls) backend.addLowOverheadBranchFromCurrentPosition(kLoopStart);
+        if (needsDls) backend.addLowOverheadBranch(kLoopStart);
         
         // process rest of k-loop (in the same way as the k-loop)
         for (uint32_t i = 0; i < kMiddle % unrollK; i++) {
@@ -346,60 +735,57 @@ void JIT::Generators::Gemm::generateMicroKernel(uint32_t m, uint32_t k, uint32_t
             backend.addInstruction(Instructions::Vector::vctp(Instructions::Size32, DLS_COUNT_REGISTER));
         }
 
-        // restore C Pointer
-        if (n * ldc * DT_SIZE > LDR_TRESHOLD) {
-            if (n * ldc * DT_SIZE > MOV_TRESHOLD) {
-                backend.addInstruction(Instructions::DataProcessing::movtImmediate32(DLS_COUNT_REGISTER, (n * ldc * DT_SIZE) >> 16));
+        // restore C Pointer (not advanced if C wasn't loaded)
+        if (configuration.loadC) {
+            if (n * ldc * DT_SIZE > LDR_TRESHOLD) {
+                backend.addMoveImmediate(DLS_COUNT_REGISTER, n * ldc * DT_SIZE);
+                backend.addInstruction(Instructions::Arithmetic::subRegister32(C_Pointer, DLS_COUNT_REGISTER));
+            } else {
+                backend.addInstruction(Instructions::Arithmetic::subImmediate32(C_Pointer, n * ldc * DT_SIZE));
             }
-            backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, n * ldc * DT_SIZE));
-            backend.addInstruction(Instructions::Arithmetic::subRegister32(C_Pointer, DLS_COUNT_REGISTER));
-        } else {
-            backend.addInstruction(Instructions::Arithmetic::subImmediate32(C_Pointer, n * ldc * DT_SIZE));
         }
 
         backend.addInstruction(Instructions::DataProcessing::ldrImmediate32(B0_Register, B_Pointer, DT_SIZE, false, true));
 
         bool cNeedsPreadd = ldc * DT_SIZE > VLDR_TRESHOLD;
-        if (predicated) backend.addInstruction(Instructions::Vector::vpst(2));
+        if (blockPredicated) backend.addInstruction(Instructions::Vector::vpst(2));
         backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(C00_Register, A0_Register, B0_Register));
-        emitLoadStoreC46(C00_Register, ldc, true);
-        if (predicated && n >= 2) backend.addInstruction(Instructions::Vector::vpst(n >= 3 && !cNeedsPreadd  ? 4 : 2));
+        emitLoadStoreC46(configuration, C00_Register, ldc, true);
+        if (blockPredicated && n >= 2) backend.addInstruction(Instructions::Vector::vpst(n >= 3 && !cNeedsPreadd  ? 4 : 2));
         if (n >= 2) {
             backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(C10_Register, A0_Register, B1_Register));
-            emitLoadStoreC46(C10_Register, ldc, true);
+            emitLoadStoreC46(configuration, C10_Register, ldc, true);
         }
         if (n >= 3) {
-            if (predicated && cNeedsPreadd) backend.addInstruction(Instructions::Vector::vpst(2));
+            if (blockPredicated && cNeedsPreadd) backend.addInstruction(Instructions::Vector::vpst(2));
             backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(C20_Register, A0_Register, B2_Register));
-            emitLoadStoreC46(C20_Register, ldc, true);
+            emitLoadStoreC46(configuration, C20_Register, ldc, true);
         }
         
         if (n >= 5) emitLoadB(B1_Register, configuration, 2, 4 * ldb * DT_SIZE - 4, true);
         if (n >= 6) emitLoadB(B2_Register, configuration, 3, 5 * ldb * DT_SIZE - 4, true);
         if (n >= 4) emitLoadB(B0_Register, configuration, 0, 3 * ldb * DT_SIZE - 4, true);
 
-        if (predicated && n >= 4) backend.addInstruction(Instructions::Vector::vpst(n >= 5 && !cNeedsPreadd ? 4 : 2));
+        if (blockPredicated && n >= 4) backend.addInstruction(Instructions::Vector::vpst(n >= 5 && !cNeedsPreadd ? 4 : 2));
         if (n >= 4) {
             backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(C30_Register, A0_Register, B0_Register));
-            emitLoadStoreC46(C30_Register, ldc, true);
+            emitLoadStoreC46(configuration, C30_Register, ldc, true);
         }
         if (n >= 5) {
-            if (predicated && cNeedsPreadd) backend.addInstruction(Instructions::Vector::vpst(2));
+            if (blockPredicated && cNeedsPreadd) backend.addInstruction(Instructions::Vector::vpst(2));
             backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(C40_Register, A0_Register, B1_Register));
-            emitLoadStoreC46(C40_Register, ldc, true);
+            emitLoadStoreC46(configuration, C40_Register, ldc, true);
         }
-        if (predicated && n >= 6) backend.addInstruction(Instructions::Vector::vpst(2));
+        if (blockPredicated && n >= 6) backend.addInstruction(Instructions::Vector::vpst(2));
         if (n >= 6) {
             backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(C50_Register, A0_Register, B2_Register));
-            emitLoadStoreC46(C50_Register, ldc, true);
+            emitLoadStoreC46(configuration, C50_Register, ldc, true);
         }
+        if (configuration.deferStores) emitDeferredStores(configuration, m, ldc);
 
         // reset c pointer
         if (n * ldc * DT_SIZE > LDR_TRESHOLD) {
-            if (n * ldc * DT_SIZE > MOV_TRESHOLD) {
-                backend.addInstruction(Instructions::DataProcessing::movtImmediate32(DLS_COUNT_REGISTER, (n * ldc * DT_SIZE) >> 16));
-            }
-            backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, n * ldc * DT_SIZE));
+            backend.addMoveImmediate(DLS_COUNT_REGISTER, n * ldc * DT_SIZE);
             backend.addInstruction(Instructions::Arithmetic::subRegister32(C_Pointer, DLS_COUNT_REGISTER));
         } else {
             backend.addInstruction(Instructions::Arithmetic::subImmediate32(C_Pointer, n * ldc * DT_SIZE));
@@ -411,10 +797,7 @@ void JIT::Generators::Gemm::generateMicroKernel(uint32_t m, uint32_t k, uint32_t
         if (configuration.registerStrategy & USE_CROW1_REGISTER) {
             uint32_t cRowAdd = DT_SIZE * ldc;
             if (cRowAdd > LDR_TRESHOLD) {
-                if (cRowAdd > MOV_TRESHOLD) {
-                    backend.addInstruction(Instructions::DataProcessing::movtImmediate32(DLS_COUNT_REGISTER, cRowAdd >> 16));
-                }
-                backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, cRowAdd));
+                backend.addMoveImmediate(DLS_COUNT_REGISTER, cRowAdd);
                 backend.addInstruction(Instructions::Arithmetic::addRegister32(configuration.CROW1_REGISTER, C_Pointer, DLS_COUNT_REGISTER));
             } else {
                 backend.addInstruction(Instructions::Arithmetic::addImmediate32(configuration.CROW1_REGISTER, C_Pointer, cRowAdd));
@@ -424,10 +807,7 @@ void JIT::Generators::Gemm::generateMicroKernel(uint32_t m, uint32_t k, uint32_t
         if (configuration.registerStrategy & USE_CROW2_REGISTER) {
             uint32_t cRowAdd = 2 * DT_SIZE * ldc;
             if (cRowAdd > LDR_TRESHOLD) {
-                if (cRowAdd > MOV_TRESHOLD) {
-                    backend.addInstruction(Instructions::DataProcessing::movtImmediate32(DLS_COUNT_REGISTER, cRowAdd >> 16));
-                }
-                backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, cRowAdd));
+                backend.addMoveImmediate(DLS_COUNT_REGISTER, cRowAdd);
                 backend.addInstruction(Instructions::Arithmetic::addRegister32(configuration.CROW2_REGISTER, C_Pointer, DLS_COUNT_REGISTER));
             } else {
                 backend.addInstruction(Instructions::Arithmetic::addImmediate32(configuration.CROW2_REGISTER, C_Pointer, cRowAdd));
@@ -441,7 +821,7 @@ void JIT::Generators::Gemm::generateMicroKernel(uint32_t m, uint32_t k, uint32_t
         backend.addInstruction(Instructions::Vector::vldrw(A1_Register, A_Pointer, 16));
         // Add to A Pointer. If not large enough reuse DLS Count register
         // Load A[0]
-        uint32_t vldrImmA = ldc * DT_SIZE;
+        uint32_t vldrImmA = lda * DT_SIZE;
         if (configuration.registerStrategy & USE_A_ADD_REGISTER) {
             backend.addInstruction(Instructions::Arithmetic::addRegister32(A_Pointer, configuration.A_ADD_REGISTER));
             vldrImmA = 0;
@@ -450,26 +830,24 @@ void JIT::Generators::Gemm::generateMicroKernel(uint32_t m, uint32_t k, uint32_t
                 backend.addInstruction(Instructions::Arithmetic::addImmediate32(A_Pointer, vldrImmA));
                 vldrImmA = 0;
             } else {
-                if (vldrImmA > MOV_TRESHOLD) backend.addInstruction(Instructions::DataProcessing::movtImmediate32(DLS_COUNT_REGISTER, vldrImmA >> 16));
-                backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, vldrImmA));
+                backend.addMoveImmediate(DLS_COUNT_REGISTER, vldrImmA);
                 backend.addInstruction(Instructions::Arithmetic::addRegister32(A_Pointer, DLS_COUNT_REGISTER));
             }
             vldrImmA = 0;
         }
         backend.addInstruction(Instructions::DataProcessing::ldrImmediate32(B0_Register, B_Pointer, DT_SIZE, false, true));
         if (predicated && k == 1) {
-            backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, m % VECTOR_ELEMENTS));
-            backend.addInstruction(Instructions::Vector::vctp(Instructions::Size32, DLS_COUNT_REGISTER));
-            backend.addInstruction(Instructions::Vector::vpst(3));
+            emitRightSidePredicate(m, configuration);
+            if (blockPredicated) backend.addInstruction(Instructions::Vector::vpst(3));
         }
-        backend.addInstruction(Instructions::Vector::vldrw(C01_Register, C_Pointer, 16));
+        emitLoadStoreC(configuration, C01_Register, ldc, false);
         backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(C01_Register, A1_Register, B0_Register));
         if (k == 1) emitLoadStoreC(configuration, C01_Register, ldc, true);
         if (n >= 2) {
             emitLoadStoreC(configuration, C10_Register, ldc, false);
             backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(C10_Register, A0_Register, B1_Register));
             if (k == 1) emitLoadStoreC(configuration, C10_Register, ldc, true);
-            if (predicated && k == 1) backend.addInstruction(Instructions::Vector::vpst(3));
+            if (blockPredicated && k == 1) backend.addInstruction(Instructions::Vector::vpst(3));
             emitLoadStoreC(configuration, C11_Register, ldc, false);
             backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(C11_Register, A1_Register, B1_Register));
             if (k == 1) emitLoadStoreC(configuration, C11_Register, ldc, true);
@@ -478,42 +856,49 @@ void JIT::Generators::Gemm::generateMicroKernel(uint32_t m, uint32_t k, uint32_t
             emitLoadStoreC(configuration, C20_Register, ldc, false);
             backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(C20_Register, A0_Register, B2_Register));
             if (k == 1) emitLoadStoreC(configuration, C20_Register, ldc, true);
-            if (predicated && k == 1) backend.addInstruction(Instructions::Vector::vpst(3));
+            if (blockPredicated && k == 1) backend.addInstruction(Instructions::Vector::vpst(3));
             emitLoadStoreC(configuration, C21_Register, ldc, false);
             backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(C21_Register, A1_Register, B2_Register));
             if (k == 1) emitLoadStoreC(configuration, C21_Register, ldc, true);
         }
-        backend.addInstruction(Instructions::Vector::vldrw(C00_Register, C_Pointer));
+        emitLoadStoreC(configuration, C00_Register, ldc, false);
         backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(C00_Register, A0_Register, B0_Register));
         if (k == 1) emitLoadStoreC(configuration, C00_Register, ldc, true);
         // early return for k == 1
-        if (k == 1) return;
+        if (k == 1) {
+            if (configuration.deferStores) emitDeferredStores(configuration, m, ldc);
+            return;
+        }
 
         backend.addInstruction(Instructions::Vector::vldrw(A0_Register, A_Pointer, vldrImmA));
         vldrImmA = 0;
-        if (!aNeedsPreadd) backend.addInstruction(Instructions::Arithmetic::addImmediate32(A_Pointer, ldc * DT_SIZE));
+        if (!aNeedsPreadd) backend.addInstruction(Instructions::Arithmetic::addImmediate32(A_Pointer, lda * DT_SIZE));
 
         // if the next vldrw can be used with an immediate, use the immediate instead of the add instruction
         // to use this, we need to unroll the k loop
         // handle edge case for really huge k
         if (needsDls) {
-            if (kMiddle / unrollK > 65535) backend.addInstruction(Instructions::DataProcessing::movtImmediate32(DLS_COUNT_REGISTER, (kMiddle / unrollK) >> 16));
-            backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, kMiddle / unrollK));
+            backend.addMoveImmediate(DLS_COUNT_REGISTER, kMiddle / unrollK);
         }
 
         if (n >= 2) emitLoadB(B1_Register, configuration, 2, DT_SIZE * ldb); // load b[ldb]
         if (n == 3) emitLoadB(B2_Register, configuration, 3, 2 * DT_SIZE * ldb); // load b[2ldb]
 
-        Instructions::Instruction16 * kLoopStart;
-        if (needsDls) backend.addInstruction(Instructions::Base::dls(DLS_COUNT_REGISTER));
+        IR::Program::Label const kLoopStart = backend.newLabel();
+        if (needsDls) {
+            backend.addInstruction(Instructions::Base::dls(DLS_COUNT_REGISTER));
+            configuration.scaleRegisterValid = false; // DLS overwrites LR
+        }
         if (k >= 3) {
             for (uint32_t i = 0; i < unrollK; i++) {
                 if (i == 0) {
+                    backend.annotate("k-loop start");
+                    backend.bindLabel(kLoopStart);
                     if (n == 1) {
-                        kLoopStart = backend.addBranchTargetInstruction(Instructions::DataProcessing::ldrImmediate32(B0_Register, B_Pointer, DT_SIZE, false, true));
+                        backend.addInstruction(Instructions::DataProcessing::ldrImmediate32(B0_Register, B_Pointer, DT_SIZE, false, true));
                     }
                     else {
-                        kLoopStart = backend.addBranchTargetInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(C10_Register, A0_Register, B1_Register));
+                        backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(C10_Register, A0_Register, B1_Register));
                         backend.addInstruction(Instructions::DataProcessing::ldrImmediate32(B0_Register, B_Pointer, DT_SIZE, false, true));
                     }
                 } else {
@@ -528,10 +913,7 @@ void JIT::Generators::Gemm::generateMicroKernel(uint32_t m, uint32_t k, uint32_t
                     if (skipAdds <= LDR_TRESHOLD) {
                         backend.addInstruction(Instructions::Arithmetic::addImmediate32(A_Pointer, skipAdds));
                     } else {
-                        if (skipAdds > MOV_TRESHOLD) {
-                            backend.addInstruction(Instructions::DataProcessing::movtImmediate32(DLS_COUNT_REGISTER, skipAdds >> 16));
-                        }
-                        backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, skipAdds));
+                        backend.addMoveImmediate(DLS_COUNT_REGISTER, skipAdds);
                         backend.addInstruction(Instructions::Arithmetic::addRegister32(A_Pointer, DLS_COUNT_REGISTER));
                     }
                 }
@@ -542,23 +924,19 @@ void JIT::Generators::Gemm::generateMicroKernel(uint32_t m, uint32_t k, uint32_t
                     if (skipAdds <= LDR_TRESHOLD) {
                         backend.addInstruction(Instructions::Arithmetic::addImmediate32(A_Pointer, skipAdds));
                     } else {
-                        if (skipAdds > MOV_TRESHOLD) {
-                            backend.addInstruction(Instructions::DataProcessing::movtImmediate32(DLS_COUNT_REGISTER, skipAdds >> 16));
-                        }
-                        backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, skipAdds));
+                        backend.addMoveImmediate(DLS_COUNT_REGISTER, skipAdds);
                         backend.addInstruction(Instructions::Arithmetic::addRegister32(A_Pointer, DLS_COUNT_REGISTER));
                     }
                 }
                 if (aNeedsPreadd) backend.addInstruction(Instructions::Vector::vldrw(A0_Register, A_Pointer));
                 if (n >= 2) backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(C11_Register, A1_Register, B1_Register));
-                bool try16 = unrollK % 2 == 0 || i < (unrollK - 1);
-                if (n >= 2) emitLoadB(B1_Register, configuration, 2, DT_SIZE * ldb, false, try16); // load b[ldb]
+                if (n >= 2) emitLoadB(B1_Register, configuration, 2, DT_SIZE * ldb); // load b[ldb]
                 if (n == 3) backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(C21_Register, A1_Register, B2_Register));
-                if (n == 3) emitLoadB(B2_Register, configuration, 3, 2 * DT_SIZE * ldb, false, try16); // load b[2ldb]
+                if (n == 3) emitLoadB(B2_Register, configuration, 3, 2 * DT_SIZE * ldb); // load b[2ldb]
                 if (configuration.insertPreloadHints) backend.addInstruction(Instructions::Base::pldImmediate(A_Pointer, (i+1) * lda * DT_SIZE));
             }
         }
-        if (needsDls) backend.addLowOverheadBranchFromCurrentPosition(kLoopStart);
+        if (needsDls) backend.addLowOverheadBranch(kLoopStart);
 
         // process rest of k-loop
         for (uint32_t i = 0; i < kMiddle % unrollK; i++) {
@@ -577,22 +955,20 @@ void JIT::Generators::Gemm::generateMicroKernel(uint32_t m, uint32_t k, uint32_t
         }
         backend.addInstruction(Instructions::DataProcessing::ldrImmediate32(B0_Register, B_Pointer, DT_SIZE, false, true));
         if (predicated) { // predicate next 3 instructions
-            backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, m % VECTOR_ELEMENTS));
-            backend.addInstruction(Instructions::Vector::vctp(Instructions::Size32, DLS_COUNT_REGISTER));
-
-            backend.addInstruction(Instructions::Vector::vpst(n >= 2 ? 3 : 2));
+            emitRightSidePredicate(m, configuration);
+            if (blockPredicated) backend.addInstruction(Instructions::Vector::vpst(3));
         }
         backend.addInstruction(Instructions::Vector::vldrw(A1_Register, A_Pointer, aNeedsPreadd ? 4 * DT_SIZE : ((k - 2) % unrollK) * lda * DT_SIZE + (4 * DT_SIZE)));
         backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(C01_Register, A1_Register, B0_Register));
-        backend.addInstruction(Instructions::Vector::vstrw(C01_Register, C_Pointer, 16));
+        emitLoadStoreC(configuration, C01_Register, ldc, true);
         backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(C00_Register, A0_Register, B0_Register));
-        backend.addInstruction(Instructions::Vector::vstrw(C00_Register, C_Pointer));
+        emitLoadStoreC(configuration, C00_Register, ldc, true);
         if (n >= 2) {
             backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(C10_Register, A0_Register, B1_Register));
             emitLoadStoreC(configuration, C10_Register, ldc, true);
         }
         // predicate the next rows. only needed if the rows are used (i.e. for 8x2, 8x3 microkernel)
-        if (predicated && n >= 2) backend.addInstruction(Instructions::Vector::vpst(n == 3 ? 4 : 2));
+        if (blockPredicated && n >= 2) backend.addInstruction(Instructions::Vector::vpst(n == 3 ? 4 : 2));
         if (n >= 2) {
             backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(C11_Register, A1_Register, B1_Register));
             emitLoadStoreC(configuration, C11_Register, ldc, true);
@@ -603,6 +979,7 @@ void JIT::Generators::Gemm::generateMicroKernel(uint32_t m, uint32_t k, uint32_t
             backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(C20_Register, A0_Register, B2_Register));
             emitLoadStoreC(configuration, C20_Register, ldc, true);
         }
+        if (configuration.deferStores) emitDeferredStores(configuration, m, ldc);
     /* path for 16x1 microkernel */
     } else {
         // initialize accumulators and calculate first iteration of k
@@ -621,11 +998,16 @@ void JIT::Generators::Gemm::generateMicroKernel(uint32_t m, uint32_t k, uint32_t
             Instructions::VectorRegister cReg = static_cast<Instructions::VectorRegister>(i / 4);
             Instructions::VectorRegister aReg = static_cast<Instructions::VectorRegister>(i / 4 + 4);
 
-            backend.addInstruction(Instructions::Vector::vldrw(cReg, C_Pointer, i * DT_SIZE));
+            if (configuration.loadC) backend.addInstruction(Instructions::Vector::vldrw(cReg, C_Pointer, i * DT_SIZE));
+            else backend.addInstruction(Instructions::Vector::vmovImmediate(cReg, 0, Instructions::I32));
             backend.addInstruction(Instructions::Vector::vldrw(aReg, A_Pointer, i * DT_SIZE));
+            emitScaleC(configuration, cReg, false);
             backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(cReg, aReg, B0_Register));
-            if (k == 1) {
-                if (predicated && i == (m - 1)) {
+            if (k == 1 && configuration.deferStores) {
+                emitStoreC16(configuration, cReg, false); // collected, predicated below
+            } else if (k == 1) {
+                emitScaleC(configuration, cReg, true);
+                if (predicated && i + VECTOR_ELEMENTS > m) {
                     backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, m % 4));
                     backend.addInstruction(Instructions::Vector::vctp(Instructions::Size32, DLS_COUNT_REGISTER));
                     backend.addInstruction(Instructions::Vector::vpst(1));
@@ -634,14 +1016,28 @@ void JIT::Generators::Gemm::generateMicroKernel(uint32_t m, uint32_t k, uint32_t
             }
         }
 
-        if (k == 1) return;
+        if (k == 1) {
+            if (configuration.deferStores) {
+                if (predicated) {
+                    backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, m % 4));
+                    backend.addInstruction(Instructions::Vector::vctp(Instructions::Size32, DLS_COUNT_REGISTER));
+                }
+                emitDeferredStores(configuration, m, ldc);
+            }
+            return;
+        }
 
-        backend.addInstruction(Instructions::Arithmetic::addImmediate32(A_Pointer, lda * 4));
+        emitAdvanceA16(configuration, 1, lda);
 
-        Instructions::Instruction16 * kLoopStart;
-        if (k > 3) backend.addInstruction(Instructions::Base::dls(DLS_COUNT_REGISTER));
+        IR::Program::Label const kLoopStart = backend.newLabel();
+        if (k > 3) {
+            backend.addInstruction(Instructions::Base::dls(DLS_COUNT_REGISTER));
+            configuration.scaleRegisterValid = false; // DLS overwrites LR
+        }
         if (k >= 3) {
-            if (unrollK >= 1) kLoopStart = backend.addBranchTargetInstruction(Instructions::DataProcessing::ldrImmediate32(B0_Register, B_Pointer, DT_SIZE, false, true));
+            backend.annotate("k-loop start");
+            backend.bindLabel(kLoopStart);
+            if (unrollK >= 1) backend.addInstruction(Instructions::DataProcessing::ldrImmediate32(B0_Register, B_Pointer, DT_SIZE, false, true));
             if (unrollK >= 2) backend.addInstruction(Instructions::DataProcessing::ldrImmediate32(B1_Register, B_Pointer, DT_SIZE, false, true));
             if (unrollK >= 3) backend.addInstruction(Instructions::DataProcessing::ldrImmediate32(B2_Register, B_Pointer, DT_SIZE, false, true));
             for (uint32_t i = 0; i < unrollK; i++) {
@@ -656,9 +1052,9 @@ void JIT::Generators::Gemm::generateMicroKernel(uint32_t m, uint32_t k, uint32_t
                     if (i == 2) backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(cReg, aReg, B2_Register));
                 }
             }
-            backend.addInstruction(Instructions::Arithmetic::addImmediate32(A_Pointer, unrollK * lda * DT_SIZE));
+            emitAdvanceA16(configuration, unrollK, lda);
         }
-        if (k > 3) backend.addLowOverheadBranchFromCurrentPosition(kLoopStart);
+        if (k > 3) backend.addLowOverheadBranch(kLoopStart);
         
         // process rest of k-loop
         for (uint32_t i = 0; i < kMiddle % unrollK; i++) {
@@ -672,7 +1068,7 @@ void JIT::Generators::Gemm::generateMicroKernel(uint32_t m, uint32_t k, uint32_t
             }
         }
         // only add immediate if needed (TODO: is never needed and we can just use immediate in the next vldrw instructions)
-        if (kMiddle % unrollK > 0) backend.addInstruction(Instructions::Arithmetic::addImmediate32(A_Pointer, (kMiddle % unrollK) * lda * 4));
+        if (kMiddle % unrollK > 0) emitAdvanceA16(configuration, kMiddle % unrollK, lda);
 
         /* Last Iteration */
         backend.addInstruction(Instructions::DataProcessing::ldrImmediate32(B0_Register, B_Pointer, 4, false, true));
@@ -680,7 +1076,7 @@ void JIT::Generators::Gemm::generateMicroKernel(uint32_t m, uint32_t k, uint32_t
         if (predicated) {
             backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, m % 4));
             backend.addInstruction(Instructions::Vector::vctp(Instructions::Size32, DLS_COUNT_REGISTER));
-            backend.addInstruction(Instructions::Vector::vpst(3));
+            if (blockPredicated) backend.addInstruction(Instructions::Vector::vpst(3));
         }
         for (uint32_t i = predicated ? (m / 4) + 1 : m / 4; i > 0; i -= 1) {
             Instructions::VectorRegister cReg = static_cast<Instructions::VectorRegister>(i - 1);
@@ -688,30 +1084,443 @@ void JIT::Generators::Gemm::generateMicroKernel(uint32_t m, uint32_t k, uint32_t
 
             backend.addInstruction(Instructions::Vector::vldrw(aReg, A_Pointer, (i-1) * 4 * 4));
             backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(cReg, aReg, B0_Register));
-            backend.addInstruction(Instructions::Vector::vstrw(cReg, C_Pointer, (i-1) * 4 * 4));
+            emitStoreC16(configuration, cReg, configuration.predicateStores && i * VECTOR_ELEMENTS > m);
         }
+        if (configuration.deferStores) emitDeferredStores(configuration, m, ldc);
     }
 }
 
-void (*JIT::Generators::Gemm::generate(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, bool insertPreloadHints)) (float const * __restrict__ a, float const * __restrict__ b, float * __restrict__ c) {
+/*
+Microkernel for transposed operands. The columns of op(A) are loaded into A0 (and A1):
+- A not transposed: contiguous VLDRW, the pointer is advanced by lda
+- A transposed: a column of op(A) is a row of A, i.e. the elements are lda apart. They are gathered with VLDRW [A, Q7, UXTW #2]
+  where Q7 holds the row offsets [0, lda, 2 * lda, 3 * lda]. The pointer is advanced by one element.
+The rows of op(B) are loaded with scalar LDRs: B not transposed means the elements are ldb apart, transposed means they are contiguous.
+Packed operands are read sequentially: A and B are only loaded with post-increments.
+
+C is accessed via the C pointer and LDC_BYTES_REGISTER, so there are no restrictions on ldc.
+The label of the first instruction is returned, so the caller can branch to the start of the microkernel.
+*/
+JIT::IR::Program::Label JIT::Generators::Gemm::generateStridedMicroKernel(uint32_t m, uint32_t k, uint32_t n, uint32_t ldb, MicroKernelConfiguration & configuration) {
+    uint32_t const vectors = (m + VECTOR_ELEMENTS - 1) / VECTOR_ELEMENTS;
+    bool const predicated = m % VECTOR_ELEMENTS != 0;
+    Instructions::Register const bRegisters[] = {B0_Register, B1_Register, B2_Register};
+    configuration.scaleRegisterValid = false;
+
+    // packed A: the slivers are consecutive, so the A pointer already points to the next one
+    IR::Program::Label const microKernelStart = backend.newLabel();
+    backend.bindLabel(microKernelStart);
+    backend.addInstruction(configuration.packed
+        ? Instructions::DataProcessing::movRegister32(B_Pointer, B_Base_Pointer)
+        : Instructions::DataProcessing::movRegister32(A_Pointer, A_Base_Pointer));
+    if (!configuration.packed) backend.addInstruction(Instructions::DataProcessing::movRegister32(B_Pointer, B_Base_Pointer));
+
+    if (predicated) {
+        backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, m % VECTOR_ELEMENTS));
+        backend.addInstruction(Instructions::Vector::vctp(Instructions::Size32, DLS_COUNT_REGISTER));
+    }
+
+    // load C, column j is in the registers [j * vectors, (j + 1) * vectors)
+    for (uint32_t j = 0; j < n; j++) {
+        if (configuration.loadC && j > 0) {
+            backend.addInstruction(Instructions::Arithmetic::addRegister32(DLS_COUNT_REGISTER, j == 1 ? C_Pointer : DLS_COUNT_REGISTER, LDC_BYTES_REGISTER));
+        }
+        for (uint32_t v = 0; v < vectors; v++) {
+            Instructions::VectorRegister cReg = static_cast<Instructions::VectorRegister>(j * vectors + v);
+            if (!configuration.loadC) {
+                backend.addInstruction(Instructions::Vector::vmovImmediate(cReg, 0, Instructions::I32));
+                continue;
+            }
+            if (predicated && v == vectors - 1) backend.addInstruction(Instructions::Vector::vpst(1));
+            backend.addInstruction(Instructions::Vector::vldrw(cReg, j == 0 ? C_Pointer : DLS_COUNT_REGISTER, v * VECTOR_SIZE));
+            emitScaleC(configuration, cReg, false);
+        }
+    }
+
+    bool const needsDls = k > 1;
+    if (needsDls) {
+        backend.addMoveImmediate(DLS_COUNT_REGISTER, k);
+        backend.addInstruction(Instructions::Base::dls(DLS_COUNT_REGISTER));
+        configuration.scaleRegisterValid = false;
+    }
+
+    // load the column of op(A)
+    IR::Program::Label const kLoopStart = backend.newLabel();
+    backend.annotate("k-loop start");
+    backend.bindLabel(kLoopStart);
+    if (configuration.packed) {
+        // the rows behind m are zero in the packed sliver, so no predication is needed
+        backend.addInstruction(Instructions::Vector::vldrw(A0_Register, A_Pointer, VECTOR_SIZE, false, true));
+        if (vectors == 2) backend.addInstruction(Instructions::Vector::vldrw(A1_Register, A_Pointer, VECTOR_SIZE, false, true));
+    } else if (configuration.transposeA) {
+        // rows behind m must not be gathered, they can lie outside of A
+        if (predicated) {
+            backend.addInstruction(Instructions::Vector::vpst(1));
+            backend.addInstruction(Instructions::Vector::vldrwGather(A0_Register, A_Pointer, A_Offsets_Register));
+        } else {
+            backend.addInstruction(Instructions::Vector::vldrwGather(A0_Register, A_Pointer, A_Offsets_Register));
+        }
+        backend.addInstruction(Instructions::Arithmetic::addImmediate32(A_Pointer, DT_SIZE));
+    } else {
+        // the last column of A might end inside the last vector
+        if (predicated && vectors == 1) {
+            backend.addInstruction(Instructions::Vector::vpst(1));
+            backend.addInstruction(Instructions::Vector::vldrw(A0_Register, A_Pointer));
+        } else {
+            backend.addInstruction(Instructions::Vector::vldrw(A0_Register, A_Pointer));
+        }
+        if (vectors == 2) {
+            if (predicated) backend.addInstruction(Instructions::Vector::vpst(1));
+            backend.addInstruction(Instructions::Vector::vldrw(A1_Register, A_Pointer, VECTOR_SIZE));
+        }
+        backend.addInstruction(Instructions::Arithmetic::addRegister32(A_Pointer, A_STRIDE_REGISTER));
+    }
+
+    // load the row of op(B) in groups of three and accumulate
+    for (uint32_t jStart = 0; jStart < n; jStart += 3) {
+        uint32_t const jEnd = jStart + 3 < n ? jStart + 3 : n;
+        for (uint32_t j = jStart; j < jEnd; j++) {
+            uint32_t offset = configuration.transposeB ? j * DT_SIZE : j * ldb * DT_SIZE;
+            if (configuration.packed) {
+                backend.addInstruction(Instructions::DataProcessing::ldrImmediate32(bRegisters[j % 3], B_Pointer, DT_SIZE, false, true));
+            } else if (offset <= LDR_TRESHOLD) {
+                backend.addInstruction(Instructions::DataProcessing::ldrImmediate32(bRegisters[j % 3], B_Pointer, offset));
+            } else { // LR holds the loop count, so DLS_COUNT_REGISTER is free inside the loop
+                backend.addMoveImmediate(DLS_COUNT_REGISTER, offset);
+                backend.addInstruction(Instructions::DataProcessing::ldrRegister32(bRegisters[j % 3], B_Pointer, DLS_COUNT_REGISTER));
+            }
+        }
+        for (uint32_t j = jStart; j < jEnd; j++) {
+            for (uint32_t v = 0; v < vectors; v++) {
+                Instructions::VectorRegister cReg = static_cast<Instructions::VectorRegister>(j * vectors + v);
+                Instructions::VectorRegister aReg = v == 0 ? A0_Register : A1_Register;
+                backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(cReg, aReg, bRegisters[j % 3]));
+            }
+        }
+    }
+    if (!configuration.packed) backend.addAddImmediate(B_Pointer, B_Pointer, configuration.transposeB ? ldb * DT_SIZE : DT_SIZE, DLS_COUNT_REGISTER);
+
+    if (needsDls) backend.addLowOverheadBranch(kLoopStart);
+
+    // C is loaded into A0, which is free after the k loop, and added to the scaled accumulators
+    if (configuration.combineC) {
+        backend.addMoveImmediate(B0_Register, configuration.beta);
+        for (uint32_t j = 0; j < n; j++) {
+            if (j > 0) {
+                backend.addInstruction(Instructions::Arithmetic::addRegister32(DLS_COUNT_REGISTER, j == 1 ? C_Pointer : DLS_COUNT_REGISTER, LDC_BYTES_REGISTER));
+            }
+            for (uint32_t v = 0; v < vectors; v++) {
+                if (predicated && v == vectors - 1) backend.addInstruction(Instructions::Vector::vpst(1));
+                backend.addInstruction(Instructions::Vector::vldrw(A0_Register, j == 0 ? C_Pointer : DLS_COUNT_REGISTER, v * VECTOR_SIZE));
+                emitCombineC(configuration, static_cast<Instructions::VectorRegister>(j * vectors + v));
+            }
+        }
+    }
+
+    if (configuration.hasEpilogue) emitEpilogueSetup(configuration);
+
+    // store C
+    for (uint32_t j = 0; j < n; j++) {
+        if (j > 0) {
+            backend.addInstruction(Instructions::Arithmetic::addRegister32(DLS_COUNT_REGISTER, j == 1 ? C_Pointer : DLS_COUNT_REGISTER, LDC_BYTES_REGISTER));
+        }
+        for (uint32_t v = 0; v < vectors; v++) {
+            Instructions::VectorRegister cReg = static_cast<Instructions::VectorRegister>(j * vectors + v);
+            emitScaleC(configuration, cReg, true);
+            if (configuration.hasEpilogue) emitEpilogue(configuration, cReg, j, v, predicated && v == vectors - 1);
+            if (predicated && v == vectors - 1) backend.addInstruction(Instructions::Vector::vpst(1));
+            backend.addInstruction(Instructions::Vector::vstrw(cReg, j == 0 ? C_Pointer : DLS_COUNT_REGISTER, v * VECTOR_SIZE));
+        }
+    }
+    return microKernelStart;
+}
+
+/*
+Runs the microkernels over all rows of a block of n columns of C.
+Afterwards A_Base_Pointer and C_Pointer point to the first row again.
+*/
+JIT::IR::Program::Label JIT::Generators::Gemm::generateStridedColumnBlock(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, MicroKernelConfiguration & configuration) {
+    uint32_t const mr = configuration.transposeA ? STRIDED_MICROKERNEL_M_TRANSPOSED_A : DEFAULT_MICROKERNEL_M;
+    uint32_t const mFull = m - (m % mr);
+
+    IR::Program::Label const blockStart = backend.newLabel();
+    backend.bindLabel(blockStart);
+    // the microkernels walk through the packed slivers of A
+    if (configuration.packed) backend.addInstruction(Instructions::DataProcessing::movRegister32(A_Pointer, A_Base_Pointer));
+    backend.addInstruction(Instructions::DataProcessing::movImmediate32(I_Loop_Register, 0));
+    if (mFull > 0) {
+        configuration.epilogueRowOffset = EPILOGUE_OFFSET_FROM_LOOP;
+        IR::Program::Label const iLoopStart = generateStridedMicroKernel(mr, k, n, ldb, configuration);
+        // next row block: A += mr rows of op(A) (packed A: already advanced), C += mr rows
+        if (configuration.transposeA) {
+            backend.addInstruction(Instructions::Arithmetic::addRegister32(A_Base_Pointer, A_STRIDE_REGISTER, Instructions::LSL, 4)); // mr * DT_SIZE * lda
+        } else if (!configuration.packed) {
+            backend.addInstruction(Instructions::Arithmetic::addImmediate32(A_Base_Pointer, mr * DT_SIZE));
+        }
+        backend.addInstruction(Instructions::Arithmetic::addImmediate32(C_Pointer, mr * DT_SIZE));
+        if (mFull > mr) {
+            backend.addInstruction(Instructions::Arithmetic::addImmediate32(I_Loop_Register, mr));
+            backend.addCompareImmediate(I_Loop_Register, mFull, DLS_COUNT_REGISTER);
+            backend.addBranch(iLoopStart, Instructions::LT);
+        }
+    }
+    if (m % mr != 0) {
+        // I is only advanced if there is more than one full microkernel
+        configuration.epilogueRowOffset = mFull;
+        generateStridedMicroKernel(m % mr, k, n, ldb, configuration);
+    }
+
+    // rewind A and C to the first row
+    if (!configuration.packed) backend.addAddImmediate(A_Base_Pointer, A_Base_Pointer, configuration.transposeA ? mFull * lda * DT_SIZE : mFull * DT_SIZE, DLS_COUNT_REGISTER, true);
+    backend.addAddImmediate(C_Pointer, C_Pointer, mFull * DT_SIZE, DLS_COUNT_REGISTER, true);
+    return blockStart;
+}
+
+/*
+Kernel for layouts with transposed operands.
+A transposed A needs Q7 for the gather offsets, so only a single A vector is available and 4x6 microkernels are used.
+Otherwise the 8x3 microkernel shape of the NN kernel is used. Packed operands use the same microkernels.
+*/
+void JIT::Generators::Gemm::generateStrided(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, MicroKernelConfiguration & configuration) {
+    uint32_t const nr = configuration.transposeA ? STRIDED_MICROKERNEL_N_TRANSPOSED_A : DEFAULT_MICROKERNEL_N;
+    uint32_t const nFull = n - (n % nr);
+
+    backend.addMoveImmediate(LDC_BYTES_REGISTER, ldc * DT_SIZE);
+    if (configuration.transposeA) {
+        // row offsets in elements, the gather load scales them by DT_SIZE
+        backend.addMoveImmediate(A_STRIDE_REGISTER, lda);
+        backend.addInstruction(Instructions::DataProcessing::movImmediate32(B0_Register, 0));
+        backend.addInstruction(Instructions::Vector::vidup(A_Offsets_Register, B0_Register, 1));
+        backend.addInstruction(Instructions::Vector::vmulIntegerVectorByScalar(A_Offsets_Register, A_Offsets_Register, A_STRIDE_REGISTER));
+    } else if (!configuration.packed) { // the loads of packed operands only use post-increments
+        backend.addMoveImmediate(A_STRIDE_REGISTER, lda * DT_SIZE);
+    }
+    emitBatchLoopStart(configuration);
+    backend.addInstruction(Instructions::DataProcessing::movRegister32(A_Base_Pointer, A_Pointer));
+    backend.addInstruction(Instructions::DataProcessing::movRegister32(B_Base_Pointer, B_Pointer));
+
+    if (nFull > 0) {
+        backend.addInstruction(Instructions::DataProcessing::movImmediate32(J_Loop_Register, 0));
+        configuration.epilogueColumnOffset = EPILOGUE_OFFSET_FROM_LOOP;
+        IR::Program::Label const jLoopStart = generateStridedColumnBlock(m, k, nr, lda, ldb, configuration);
+        // next column block: B += nr columns of op(B) (packed B: one sliver), C += nr columns
+        uint32_t const bStride = configuration.packed ? nr * k * DT_SIZE : configuration.transposeB ? nr * DT_SIZE : nr * ldb * DT_SIZE;
+        backend.addAddImmediate(B_Base_Pointer, B_Base_Pointer, bStride, DLS_COUNT_REGISTER);
+        backend.addAddImmediate(C_Pointer, C_Pointer, nr * ldc * DT_SIZE, DLS_COUNT_REGISTER);
+        if (nFull > nr) {
+            backend.addInstruction(Instructions::Arithmetic::addImmediate32(J_Loop_Register, nr));
+            backend.addCompareImmediate(J_Loop_Register, nFull, DLS_COUNT_REGISTER);
+            backend.addBranch(jLoopStart, Instructions::LT);
+        }
+    }
+    if (n % nr != 0) {
+        configuration.epilogueColumnOffset = nFull;
+        generateStridedColumnBlock(m, k, n % nr, lda, ldb, configuration);
+    }
+}
+
+/*
+alpha == 0: C = beta * C and the epilogue, A and B are not read. Each column of C is processed by a tail predicated loop over
+its rows, so the gaps of ldc are not touched. Without scaling and epilogue C stays as it is and only the registers are restored.
+*/
+void JIT::Generators::Gemm::generateScaleOnly(uint32_t m, uint32_t n, uint32_t ldc, float beta, MicroKernelConfiguration & configuration) {
+    Epilogue const & epilogue = configuration.epilogue;
+    bool const loadC = beta != 0.0f;
+    bool const scale = loadC && beta != 1.0f;
+    if (loadC && !scale && !configuration.hasEpilogue) return;
+
+    if (scale) backend.addMoveImmediate(Beta_Register, std::bit_cast<uint32_t>(beta));
+    uint32_t const lowerBound = lowerBoundBits(epilogue);
+    uint32_t const upperBound = upperBoundBits(epilogue);
+    // +0.0f is set with VMOV, all other bounds are duplicated from a GP register
+    if (hasLowerBound(epilogue)) {
+        if (lowerBound == 0) backend.addInstruction(Instructions::Vector::vmovImmediate(Lower_Bound_Vector, 0, Instructions::I32));
+        else {
+            backend.addMoveImmediate(Lower_Bound_Register, lowerBound);
+            backend.addInstruction(Instructions::Vector::vdup(Lower_Bound_Vector, Lower_Bound_Register));
+        }
+    }
+    if (hasUpperBound(epilogue)) {
+        if (upperBound == 0) backend.addInstruction(Instructions::Vector::vmovImmediate(Upper_Bound_Vector, 0, Instructions::I32));
+        else {
+            backend.addMoveImmediate(Upper_Bound_Register, upperBound);
+            backend.addInstruction(Instructions::Vector::vdup(Upper_Bound_Vector, Upper_Bound_Register));
+        }
+    }
+    // DLSTP doesn't change the row count
+    backend.addMoveImmediate(I_Loop_Register, m);
+    uint32_t const biasAddress = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(epilogue.biasValues));
+
+    emitBatchLoopStart(configuration);
+    // the column bias is walked with post-increments, each matrix starts at the first column
+    if (epilogue.bias == Epilogue::BIAS_PER_COLUMN) backend.addMoveImmediate(Bias_Pointer, biasAddress);
+    if (n > 1) backend.addInstruction(Instructions::DataProcessing::movImmediate32(J_Loop_Register, 0));
+    IR::Program::Label const columnLoopStart = backend.newLabel();
+    backend.bindLabel(columnLoopStart);
+    backend.addInstruction(Instructions::DataProcessing::movRegister32(Row_Pointer, C_Pointer));
+    if (epilogue.bias == Epilogue::BIAS_PER_ROW) backend.addMoveImmediate(Bias_Pointer, biasAddress);
+    if (epilogue.bias == Epilogue::BIAS_PER_COLUMN) backend.addInstruction(Instructions::DataProcessing::ldrImmediate32(Bias_Register, Bias_Pointer, DT_SIZE, false, true));
+    backend.addInstruction(Instructions::Base::dlstp(I_Loop_Register, Instructions::Size32));
+
+    IR::Program::Label const rowLoopStart = backend.newLabel();
+    backend.bindLabel(rowLoopStart);
+    if (loadC) backend.addInstruction(Instructions::Vector::vldrw(C00_Register, Row_Pointer));
+    else backend.addInstruction(Instructions::Vector::vmovImmediate(C00_Register, 0, Instructions::I32));
+    if (scale) backend.addInstruction(Instructions::Vector::vmulVectorByScalar(C00_Register, C00_Register, Beta_Register));
+    if (epilogue.bias == Epilogue::BIAS_PER_ROW) {
+        backend.addInstruction(Instructions::Vector::vldrw(Bias_Vector, Bias_Pointer, VECTOR_SIZE, false, true));
+        backend.addInstruction(Instructions::Vector::vaddFloat(C00_Register, C00_Register, Bias_Vector));
+    } else if (epilogue.bias == Epilogue::BIAS_PER_COLUMN) {
+        backend.addInstruction(Instructions::Vector::vaddFloatScalar(C00_Register, C00_Register, Bias_Register));
+    }
+    if (hasLowerBound(epilogue)) backend.addInstruction(Instructions::Vector::vmaxnm(C00_Register, C00_Register, Lower_Bound_Vector));
+    if (hasUpperBound(epilogue)) backend.addInstruction(Instructions::Vector::vminnm(C00_Register, C00_Register, Upper_Bound_Vector));
+    backend.addInstruction(Instructions::Vector::vstrw(C00_Register, Row_Pointer, VECTOR_SIZE, false, true));
+    backend.addLowOverheadBranch(rowLoopStart, true);
+
+    if (n > 1) {
+        backend.addAddImmediate(C_Pointer, C_Pointer, ldc * DT_SIZE, DLS_COUNT_REGISTER);
+        backend.addInstruction(Instructions::Arithmetic::addImmediate32(J_Loop_Register, 1));
+        backend.addCompareImmediate(J_Loop_Register, n, DLS_COUNT_REGISTER);
+        backend.addBranch(columnLoopStart, Instructions::LT);
+    }
+    emitBatchLoopEnd(configuration);
+}
+
+void (*JIT::Generators::Gemm::generate(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, bool insertPreloadHints, float alpha, float beta, Layout layout, Epilogue const & epilogue)) (float const * __restrict__ a, float const * __restrict__ b, float * __restrict__ c) {
+    return generateFitting(m, k, n, lda, ldb, ldc, insertPreloadHints, alpha, beta, layout, epilogue, lookupTuning(m, k, n, lda, ldb, ldc, layout), 0, 0, 0, 0);
+}
+
+JIT::Generators::Gemm::Func JIT::Generators::Gemm::generateTuned(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, Tuning const & tuning, bool insertPreloadHints, float alpha, float beta, Layout layout) {
+    if (!isSupported(layout, {})) return nullptr;
+    return generateKernel(m, k, n, lda, ldb, ldc, insertPreloadHints, alpha, beta, layout, {}, tuning, 0, 0, 0, 0);
+}
+
+JIT::Generators::Gemm::Tuning JIT::Generators::Gemm::defaultTuning() {
+    // predicated edges save the edge microkernels but add a VCTP and the store predicates to each block of the i loops, they are
+    // slower for all measured shapes and only used if the kernel doesn't fit into the buffer otherwise (see generateFitting)
+    return {true, K_MAX_UNROLL, M_MAX_UNROLL, N_MAX_UNROLL, false};
+}
+
+JIT::Generators::Gemm::Tuning JIT::Generators::Gemm::lookupTuning(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, Layout layout) const {
+    Tuning const * tuning = tuningTable != nullptr ? tuningTable->find(m, k, n, lda, ldb, ldc, layout) : nullptr;
+    return tuning != nullptr ? *tuning : defaultTuning();
+}
+
+JIT::Generators::Gemm::Func JIT::Generators::Gemm::generateBatched(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, uint32_t batch, uint32_t strideA, uint32_t strideB, uint32_t strideC, bool insertPreloadHints, float alpha, float beta, Layout layout, Epilogue const & epilogue) {
+    if (batch == 0) {
+        Instructions::Base::printValidationError("generateBatched: batch == 0 - returning nullptr");
+        return nullptr;
+    }
+    // a single matrix does not need the batch loop
+    Tuning const tuning = lookupTuning(m, k, n, lda, ldb, ldc, layout);
+    if (batch == 1) return generateFitting(m, k, n, lda, ldb, ldc, insertPreloadHints, alpha, beta, layout, epilogue, tuning, 0, 0, 0, 0);
+    return generateFitting(m, k, n, lda, ldb, ldc, insertPreloadHints, alpha, beta, layout, epilogue, tuning, batch, strideA, strideB, strideC);
+}
+
+JIT::Generators::Gemm::Func JIT::Generators::Gemm::generateFitting(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, bool insertPreloadHints, float alpha, float beta, Layout layout, Epilogue const & epilogue, Tuning const & tuning, uint32_t batch, uint32_t strideA, uint32_t strideB, uint32_t strideC) {
+    if (!isSupported(layout, epilogue)) return nullptr;
+    Func const kernel = generateKernel(m, k, n, lda, ldb, ldc, insertPreloadHints, alpha, beta, layout, epilogue, tuning, batch, strideA, strideB, strideC);
+    // nullptr: the kernel doesn't fit into the buffer
+    if (kernel != nullptr || tuning.predicatedEdges) return kernel;
+    // predicated edges are never faster, but they save the edge microkernels of the i loops
+    Tuning smaller = tuning;
+    smaller.predicatedEdges = true;
+    return generateKernel(m, k, n, lda, ldb, ldc, insertPreloadHints, alpha, beta, layout, epilogue, smaller, batch, strideA, strideB, strideC);
+}
+
+bool JIT::Generators::Gemm::isSupported(Layout layout, Epilogue const & epilogue) {
+    if ((layout & PACKED) && layout != PACKED) {
+        Instructions::Base::printValidationError("generate: PACKED can't be combined with other layouts - returning nullptr");
+        return false;
+    }
+    if (epilogue.bias != Epilogue::BIAS_NONE && epilogue.biasValues == nullptr) {
+        Instructions::Base::printValidationError("generate: bias without values - returning nullptr");
+        return false;
+    }
+    return true;
+}
+
+JIT::Generators::Gemm::Func JIT::Generators::Gemm::generateKernel(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, bool insertPreloadHints, float alpha, float beta, Layout layout, Epilogue const & epilogue, Tuning const & tuning, uint32_t batch, uint32_t strideA, uint32_t strideB, uint32_t strideC) {
     backend.resetKernel();
+    // all branches are resolved with their shortest encoding when the kernel is finalized
+    IR::Arena arena(programStorage, programStorageBytes);
+    IR::Program program(arena, programMaxNodes, PROGRAM_MAX_LABELS, PROGRAM_MAX_LITERALS);
+    backend.beginProgram(program); // ended by finalizeKernel
 
     // push all registers to the stack
+    backend.annotate("save registers");
     backend.addInstruction(JIT::Instructions::DataProcessing::push32(Instructions::R4, Instructions::R5, Instructions::R6, Instructions::R7, Instructions::R8, Instructions::R9, Instructions::R10, Instructions::R11, Instructions::R12, Instructions::LR));
     backend.addInstruction(JIT::Instructions::DataProcessing::vpush(Instructions::Q4, 4));
 
     MicroKernelConfiguration configuration = {};
+    configuration.transposeA = layout & TRANSPOSE_A;
+    configuration.transposeB = layout & TRANSPOSE_B;
+    configuration.packed = layout & PACKED;
+    configuration.epilogue = epilogue;
+    configuration.hasEpilogue = epilogue.bias != Epilogue::BIAS_NONE || epilogue.activation != Epilogue::ACTIVATION_NONE;
+    configuration.kMaxUnroll = tuning.kMaxUnroll;
+    configuration.batch = batch;
+    configuration.batchStrideA = strideA * DT_SIZE;
+    configuration.batchStrideB = strideB * DT_SIZE;
+    configuration.batchStrideC = strideC * DT_SIZE;
+    if (layout & ROW_MAJOR) {
+        // row-major C = op(A) * op(B) is column-major C^T = op(B)^T * op(A)^T: swap the operands and their dimensions
+        uint32_t tmp = m;
+        m = n;
+        n = tmp;
+        tmp = lda;
+        lda = ldb;
+        ldb = tmp;
+        bool const transposeA = configuration.transposeA;
+        configuration.transposeA = configuration.transposeB;
+        configuration.transposeB = transposeA;
+        backend.addInstruction(Instructions::DataProcessing::movRegister32(DLS_COUNT_REGISTER, A_Pointer));
+        backend.addInstruction(Instructions::DataProcessing::movRegister32(A_Pointer, B_Pointer));
+        backend.addInstruction(Instructions::DataProcessing::movRegister32(B_Pointer, DLS_COUNT_REGISTER));
+        tmp = configuration.batchStrideA;
+        configuration.batchStrideA = configuration.batchStrideB;
+        configuration.batchStrideB = tmp;
+        // the rows of the row-major C are the columns of C^T
+        if (epilogue.bias == Epilogue::BIAS_PER_ROW) configuration.epilogue.bias = Epilogue::BIAS_PER_COLUMN;
+        else if (epilogue.bias == Epilogue::BIAS_PER_COLUMN) configuration.epilogue.bias = Epilogue::BIAS_PER_ROW;
+    }
     configuration.registerStrategy = ALL_IMMEDIATES;
     configuration.insertPreloadHints = insertPreloadHints;
+    if (alpha == 0.0f) {
+        generateScaleOnly(m, n, ldc, beta, configuration);
+        return finalizeKernel();
+    }
+    // C is loaded and scaled by beta / alpha, so the accumulators only have to be scaled by alpha before storing
+    configuration.loadC = beta != 0.0f;
+    configuration.scaleLoadedC = configuration.loadC && beta != alpha;
+    configuration.scaleResult = alpha != 1.0f;
+    configuration.betaOverAlpha = std::bit_cast<uint32_t>(beta / alpha);
+    configuration.alpha = std::bit_cast<uint32_t>(alpha);
+    // C * fl(beta / alpha) * alpha is only exact if alpha is a power of two (zero mantissa, normal exponent)
+    uint32_t const alphaExponent = (configuration.alpha >> 23) & 0xff;
+    bool const alphaPowerOfTwo = (configuration.alpha & 0x7fffff) == 0 && alphaExponent != 0 && alphaExponent != 0xff;
+    configuration.combineC = configuration.scaleLoadedC && !alphaPowerOfTwo;
+    configuration.beta = std::bit_cast<uint32_t>(beta);
+    if (configuration.combineC) {
+        configuration.loadC = false;
+        configuration.scaleLoadedC = false;
+    }
+
+    if (configuration.transposeA || configuration.transposeB || configuration.packed) {
+        generateStrided(m, k, n, lda, ldb, ldc, configuration);
+        emitBatchLoopEnd(configuration);
+        return finalizeKernel();
+    }
     /*
     Determine where it is not possible to use immediates
     */
     /* Use 4x6 microkernel if it possible to run it every second iteration, i.e. if n minus the rest is dividible by 6 */
     bool use46Microkernel = (m <= 4 && n > 3) || // also used if m loop is not needed (or if single microkernel is generated)
-        (m % DEFAULT_MICROKERNEL_M != 0 && m % DEFAULT_MICROKERNEL_M <= 4 && (n - (n % DEFAULT_MICROKERNEL_N)) % 6 == 0);
+        (tuning.use46Microkernel && m % DEFAULT_MICROKERNEL_M != 0 && m % DEFAULT_MICROKERNEL_M <= 4 && (n - (n % DEFAULT_MICROKERNEL_N)) % 6 == 0);
     // use46Microkernel = false;
     /* We need the second B pointer if the 4x6 microkernel is used and the immediate is too large */
-    bool needsBCol3Reg = use46Microkernel && 5 * DT_SIZE * k > LDR_TRESHOLD;
+    bool needsBCol3Reg = use46Microkernel && 5 * DT_SIZE * ldb > LDR_TRESHOLD;
     /* we need the ldb register if the load from B is not possible with immediates, i.e. if k is large. is also needed whenever we have to use a second B pointer */
     bool needsLdbReg = 2 * DT_SIZE * ldb > LDR_TRESHOLD || needsBCol3Reg;
     /* if ADD can not use immediates before the VLDR */
@@ -726,80 +1535,116 @@ void (*JIT::Generators::Gemm::generate(uint32_t m, uint32_t k, uint32_t n, uint3
     bool needsMReg = m > 255 && !Instructions::Base::canEncodeImmediateConstant(m);
 
     /* can we unroll M and N? only unrolled if everything can be unrolled */
-    bool canUnrollM = M_MAX_UNROLL * DEFAULT_MICROKERNEL_M >= m - (m % DEFAULT_MICROKERNEL_M);
-    bool canUnrollN = N_MAX_UNROLL * DEFAULT_MICROKERNEL_N >= n - (n % DEFAULT_MICROKERNEL_N);
+    bool canUnrollM = tuning.mMaxUnroll * DEFAULT_MICROKERNEL_M >= m - (m % DEFAULT_MICROKERNEL_M);
+    bool canUnrollN = tuning.nMaxUnroll * DEFAULT_MICROKERNEL_N >= n - (n % DEFAULT_MICROKERNEL_N);
+    /*
+    Predicated edges: the i loops run ceil(m / 8) iterations and the last one is limited by VCTP, so the remaining rows don't need their
+    own microkernel. Only possible for m % 8 >= 5, fewer rows would leave the left vector partially used as well (one predicate can't
+    limit both vectors). An unrolled i loop places the edge microkernel at compile time anyway. The N edges keep their microkernels:
+    the columns are not vectorized, so a predicate can't drop them and the j loop would need a column count check per block.
+    */
+    bool const predicatedEdges = tuning.predicatedEdges && m % DEFAULT_MICROKERNEL_M > VECTOR_ELEMENTS;
+    bool const edgeInILoop = predicatedEdges && !canUnrollM;
+    // i loops run while I_Loop_Register < mCmp
+    uint32_t const mCmp = predicatedEdges ? m : m - (m % DEFAULT_MICROKERNEL_M);
+    configuration.edgeRows = m;
+
+    /* choose the loops: a single microkernel, only the i loop, only the j loop or both */
+    bool const singleMicroKernel = (m <= 16 && n == 1) || (m <= 8 && n <= 3) || (m <= 4 && n <= 6);
+    bool const onlyILoop = !singleMicroKernel && n <= DEFAULT_MICROKERNEL_N;
+    bool const onlyJLoop = !singleMicroKernel && !onlyILoop && m <= DEFAULT_MICROKERNEL_M;
+    // select highest n for microkernel depending on the size of m (only j loop)
+    uint32_t const highestN = m <= 4 ? (n <= 6 ? n : 6) : (n <= 3 ? n : 3);
+    if (onlyJLoop) canUnrollN = tuning.nMaxUnroll * highestN >= n - (n % highestN);
 
-    uint8_t regCount = 0; // counter for used registers (max. three)
-    Instructions::Register lenRegister[] = {LEN1_REGISTER, LEN2_REGISTER, LEN3_REGISTER}; // used registers
+    /*
+    Allocate the spare registers. Loop registers are only live if the loop counts: the j counter is not needed
+    if the j loop is unrolled (the 4x6 microkernels are placed at compile time), A_Base only if there is a loop at all.
+    LR is free if no microkernel has a k loop (k <= 3), scales C or is placed in the batch loop, which uses it as temp.
+    */
+    RegisterAllocator allocator;
+    for (Instructions::Register const reg : SPARE_REGISTERS) allocator.addRegister(reg);
+    if (singleMicroKernel || onlyILoop || canUnrollN) allocator.addRegister(J_Loop_Register);
+    if (singleMicroKernel || onlyJLoop) allocator.addRegister(I_Loop_Register);
+    if (singleMicroKernel) allocator.addRegister(A_Base_Pointer);
+    bool const scales = configuration.scaleResult || configuration.scaleLoadedC || configuration.combineC;
+    if (k <= 3 && !scales && configuration.batch == 0) allocator.addRegister(Instructions::LR);
+    // LDB register has highest priority, it is also used to reset the B pointer after the i loop
+    RegisterAllocator::Interval const ldbInterval = needsLdbReg ? allocator.addInterval(KERNEL_PROLOGUE, KERNEL_END, 7) : RegisterAllocator::NO_INTERVAL;
+    // BCol3 register also has high priority as it is used in k loop
+    // value is calculated in the 4x6 microkernel, so it can share the register of the C row pointers
+    RegisterAllocator::Interval const bCol3Interval = needsBCol3Reg ? allocator.addInterval(KERNEL_NARROW_MICROKERNELS, KERNEL_LOOP_CONTROL, 6) : RegisterAllocator::NO_INTERVAL;
+    // last important register is lda register as it is also used in the k loop
+    RegisterAllocator::Interval const ldaInterval = needsLdaReg ? allocator.addInterval(KERNEL_PROLOGUE, KERNEL_LOOP_CONTROL, 5) : RegisterAllocator::NO_INTERVAL;
+    // crow1 and crow2 pointer are important but are only needed at the start and end of the microkernel
+    // value is calculated in the 8x3 microkernel
+    RegisterAllocator::Interval const cRow1Interval = needsCRow1Reg ? allocator.addInterval(KERNEL_WIDE_MICROKERNELS, KERNEL_NARROW_MICROKERNELS, 4) : RegisterAllocator::NO_INTERVAL;
+    RegisterAllocator::Interval const cRow2Interval = needsCRow2Reg ? allocator.addInterval(KERNEL_WIDE_MICROKERNELS, KERNEL_NARROW_MICROKERNELS, 3) : RegisterAllocator::NO_INTERVAL;
+    // not important as it only means one extra instructions per microkernel
+    RegisterAllocator::Interval const mInterval = needsMReg ? allocator.addInterval(KERNEL_PROLOGUE, KERNEL_END, 2) : RegisterAllocator::NO_INTERVAL;
+    RegisterAllocator::Interval const nInterval = needsNReg ? allocator.addInterval(KERNEL_PROLOGUE, KERNEL_END, 1) : RegisterAllocator::NO_INTERVAL;
+    allocator.allocate();
 
-    // LDB register has highest priority
-    if (needsLdbReg && regCount < 3) {
+    if (allocator.isAllocated(ldbInterval)) {
         configuration.registerStrategy = static_cast<RegisterImmediateStrategy>(configuration.registerStrategy | USE_LDB_REGISTER);
-        configuration.LDB_REGISTER = lenRegister[regCount++];
-        if (ldb > MOV_TRESHOLD) backend.addInstruction(Instructions::DataProcessing::movtImmediate32(configuration.LDB_REGISTER, ldb >> 16));
-        backend.addInstruction(Instructions::DataProcessing::movImmediate32(configuration.LDB_REGISTER, ldb));
+        configuration.LDB_REGISTER = allocator.getRegister(ldbInterval);
+        backend.addMoveImmediate(configuration.LDB_REGISTER, ldb);
     }
-
-    // BCol3 register also has high priority as it is used in k loop
-    // value is calculated in the microkernel
-    if (needsBCol3Reg && regCount < 3) {
+    if (allocator.isAllocated(bCol3Interval)) {
         configuration.registerStrategy = static_cast<RegisterImmediateStrategy>(configuration.registerStrategy | USE_BCOL3_REGISTER);
-        configuration.BCOL3_REGISTER = lenRegister[regCount++];
+        configuration.BCOL3_REGISTER = allocator.getRegister(bCol3Interval);
     }
-
-    // last important register is lda register as it is also used in the k loop
-    if (needsLdaReg && regCount < 3) {
+    if (allocator.isAllocated(ldaInterval)) {
         configuration.registerStrategy = static_cast<RegisterImmediateStrategy>(configuration.registerStrategy | USE_A_ADD_REGISTER);
-        configuration.A_ADD_REGISTER = lenRegister[regCount++];
-        if (lda * DT_SIZE > MOV_TRESHOLD) backend.addInstruction(Instructions::DataProcessing::movtImmediate32(configuration.A_ADD_REGISTER, (lda * DT_SIZE) >> 16));
-        backend.addInstruction(Instructions::DataProcessing::movImmediate32(configuration.A_ADD_REGISTER, lda * DT_SIZE));
+        configuration.A_ADD_REGISTER = allocator.getRegister(ldaInterval);
+        backend.addMoveImmediate(configuration.A_ADD_REGISTER, lda * DT_SIZE);
     }
-
-    // crow1 and crow2 pointer are important but are only needed at the start and end of the microkernel
-    // value is calculated in the microkernel
-    if (needsCRow1Reg && regCount < 3) {
+    if (allocator.isAllocated(cRow1Interval)) {
         configuration.registerStrategy = static_cast<RegisterImmediateStrategy>(configuration.registerStrategy | USE_CROW1_REGISTER);
-        configuration.CROW1_REGISTER = lenRegister[regCount++];
+        configuration.CROW1_REGISTER = allocator.getRegister(cRow1Interval);
     }
-
-    if (needsCRow2Reg && regCount < 3) {
+    if (allocator.isAllocated(cRow2Interval)) {
         configuration.registerStrategy = static_cast<RegisterImmediateStrategy>(configuration.registerStrategy | USE_CROW2_REGISTER);
-        configuration.CROW2_REGISTER = lenRegister[regCount++];
+        configuration.CROW2_REGISTER = allocator.getRegister(cRow2Interval);
     }
-
-    // not important as it only means one extra instructions per microkernel
-    if (needsMReg && regCount < 3) {
+    if (allocator.isAllocated(mInterval)) {
         configuration.registerStrategy = static_cast<RegisterImmediateStrategy>(configuration.registerStrategy | USE_M_LEN_REGISTER);
-        configuration.M_LEN_REGISTER = lenRegister[regCount++];
-        if (m - (m % DEFAULT_MICROKERNEL_M) > MOV_TRESHOLD) backend.addInstruction(Instructions::DataProcessing::movtImmediate32(configuration.M_LEN_REGISTER, (m - (m % DEFAULT_MICROKERNEL_M)) >> 16));
-        backend.addInstruction(Instructions::DataProcessing::movImmediate32(configuration.M_LEN_REGISTER, m - (m % DEFAULT_MICROKERNEL_M)));
+        configuration.M_LEN_REGISTER = allocator.getRegister(mInterval);
+        backend.addMoveImmediate(configuration.M_LEN_REGISTER, mCmp);
     }
-
-    // not important as it only means one extra instructions per microkernel
-    if (needsNReg && regCount < 3) {
+    if (allocator.isAllocated(nInterval)) {
         configuration.registerStrategy = static_cast<RegisterImmediateStrategy>(configuration.registerStrategy | USE_N_LEN_REGISTER);
-        configuration.N_LEN_REGISTER = lenRegister[regCount++];
-        if (n - (n % DEFAULT_MICROKERNEL_N) > MOV_TRESHOLD) backend.addInstruction(Instructions::DataProcessing::movtImmediate32(configuration.N_LEN_REGISTER, (n - (n % DEFAULT_MICROKERNEL_N)) >> 16));
-        backend.addInstruction(Instructions::DataProcessing::movImmediate32(configuration.N_LEN_REGISTER, n - (n % DEFAULT_MICROKERNEL_N)));
+        configuration.N_LEN_REGISTER = allocator.getRegister(nInterval);
+        backend.addMoveImmediate(configuration.N_LEN_REGISTER, n - (n % DEFAULT_MICROKERNEL_N));
     }
 
+    emitBatchLoopStart(configuration);
+
     // can be solved by using a single microkernel (no loops required)
     // - 16x1
     // - 8x2, 8x3
     // - 4x4-4x6
-    if ((m <= 16 && n == 1) || (m <= 8 && n <= 3) || (m <= 4 && n <= 6)) {
+    // first row / column of the microkernels for the epilogue: constants where they are placed at compile time, otherwise the loop counters
+    if (singleMicroKernel) {
+        configuration.epilogueRowOffset = 0;
+        configuration.epilogueColumnOffset = 0;
         generateMicroKernel(m, k, n, lda, ldb, ldc, configuration);
-    } else if (n <= DEFAULT_MICROKERNEL_N) { // dont need j=n loop (only i loop) and use wide microkernel
+    } else if (onlyILoop) { // dont need j=n loop (only i loop) and use wide microkernel
         backend.addInstruction(JIT::Instructions::DataProcessing::movRegister32(A_Base_Pointer, A_Pointer)); // save a pointer
         backend.addInstruction(Instructions::DataProcessing::movImmediate32(I_Loop_Register, 0)); // initialize I loop
         /*
         * Loop i (m loop): Count from 0 to m
         */
-        Instructions::Instruction16 * iLoopStart;
-        if (!canUnrollM) iLoopStart = backend.addBranchTargetInstruction(Instructions::Base::nop32()); // start i loop
+        IR::Program::Label const iLoopStart = backend.newLabel();
+        backend.annotate("m loop");
+        if (!canUnrollM) backend.bindLabel(iLoopStart); // start i loop
         uint32_t unrollM = canUnrollM ? (m - (m % DEFAULT_MICROKERNEL_M)) / DEFAULT_MICROKERNEL_M : 1;
+        configuration.epilogueColumnOffset = 0;
         for (uint32_t i = 0; i < unrollM; i++) {
+            configuration.epilogueRowOffset = canUnrollM ? i * DEFAULT_MICROKERNEL_M : EPILOGUE_OFFSET_FROM_LOOP;
+            configuration.predicatedEdge = edgeInILoop;
             generateMicroKernel(DEFAULT_MICROKERNEL_M, k, n, lda, ldb, ldc, configuration); // generate microkernel and pass n
+            configuration.predicatedEdge = false;
 
             backend.addInstruction(Instructions::Arithmetic::addImmediate32(I_Loop_Register, DEFAULT_MICROKERNEL_M)); // prepare for next iteration
 
@@ -812,8 +1657,7 @@ void (*JIT::Generators::Gemm::generate(uint32_t m, uint32_t k, uint32_t n, uint3
                 if (configuration.registerStrategy & USE_LDB_REGISTER && k == ldb) {
                     backend.addInstruction(Instructions::Arithmetic::subRegister32(B_Pointer, configuration.LDB_REGISTER, Instructions::LSL, 2));
                 } else {
-                    if (DT_SIZE * k > MOV_TRESHOLD) backend.addInstruction(Instructions::DataProcessing::movtImmediate32(DLS_COUNT_REGISTER, (DT_SIZE * k) >> 16));
-                    backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, DT_SIZE * k));
+                    backend.addMoveImmediate(DLS_COUNT_REGISTER, DT_SIZE * k);
                     backend.addInstruction(Instructions::Arithmetic::subRegister32(B_Pointer, DLS_COUNT_REGISTER));
                 }
             } else {
@@ -823,8 +1667,7 @@ void (*JIT::Generators::Gemm::generate(uint32_t m, uint32_t k, uint32_t n, uint3
             backend.addInstruction(Instructions::Arithmetic::addImmediate32(C_Pointer, DEFAULT_MICROKERNEL_M * DT_SIZE));
         }
         if (!canUnrollM) {
-            // ensure that only full microkernels can be executed
-            uint32_t const mCmp = m - (m % DEFAULT_MICROKERNEL_M);
+            // ensure that only full microkernels can be executed (or the predicated edge)
             // check if we need to branch back or if the loop is at its end
             if (mCmp < 255 || Instructions::Base::canEncodeImmediateConstant(mCmp)) {
                 backend.addInstruction(Instructions::Base::cmpImmediate32(I_Loop_Register, mCmp));
@@ -834,45 +1677,41 @@ void (*JIT::Generators::Gemm::generate(uint32_t m, uint32_t k, uint32_t n, uint3
                     backend.addInstruction(Instructions::Base::cmpRegister32(I_Loop_Register, configuration.M_LEN_REGISTER));
                 } else {
                     // if no register can be used then just repurpose the DLS_COUNT_REGISTER as it will be written again in the next iteration anyways
-                    if (mCmp > MOV_TRESHOLD) backend.addInstruction(Instructions::DataProcessing::movtImmediate32(DLS_COUNT_REGISTER, mCmp >> 16));
-                    backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, mCmp));
+                    backend.addMoveImmediate(DLS_COUNT_REGISTER, mCmp);
                     backend.addInstruction(Instructions::Base::cmpRegister32(I_Loop_Register, DLS_COUNT_REGISTER));
                 }
             }
-            backend.addBackwardsBranchFromCurrentPosition(iLoopStart, Instructions::LT); // branch back to loop start (new iteration)
+            backend.addBranch(iLoopStart, Instructions::LT); // branch back to loop start (new iteration)
         }
 
         // if there are remaining rows process them with an added microkernel
-        if (m % DEFAULT_MICROKERNEL_M != 0) {
+        if (m % DEFAULT_MICROKERNEL_M != 0 && !edgeInILoop) {
+            configuration.epilogueRowOffset = m - (m % DEFAULT_MICROKERNEL_M);
             generateMicroKernel(m % DEFAULT_MICROKERNEL_M, k, n, lda, ldb, ldc, configuration);
         }
-    } else if (m <= DEFAULT_MICROKERNEL_M) { // dont need i=m loop (only j loop)
+    } else if (onlyJLoop) { // dont need i=m loop (only j loop)
         backend.addInstruction(JIT::Instructions::DataProcessing::movRegister32(A_Base_Pointer, A_Pointer)); // save a pointer
-        backend.addInstruction(JIT::Instructions::DataProcessing::movImmediate32(J_Loop_Register, 0)); // initialize j loop
-
-        // select highest n for microkernel depending on the size of m
-        uint32_t highestN = 0;
-        if (m <= 4) highestN = n <= 6 ? n : 6;
-        else highestN = n <= 3 ? n : 3;
-        canUnrollN = N_MAX_UNROLL * highestN >= n - (n % highestN);
+        if (!canUnrollN) backend.addInstruction(JIT::Instructions::DataProcessing::movImmediate32(J_Loop_Register, 0)); // initialize j loop
         /*
         * Loop j (n loop): Count from 0 to n
         */
-        Instructions::Instruction16 * jLoopStart;
-        if (!canUnrollN) jLoopStart = backend.addBranchTargetInstruction(Instructions::Base::nop32()); // start of the j loop
+        IR::Program::Label const jLoopStart = backend.newLabel();
+        backend.annotate("n loop");
+        if (!canUnrollN) backend.bindLabel(jLoopStart); // start of the j loop
         uint32_t unrollN = canUnrollN ? (n - (n % highestN)) / highestN : 1;
 
+        configuration.epilogueRowOffset = 0;
         for (uint32_t j = 0; j < unrollN; j++) {
+            configuration.epilogueColumnOffset = canUnrollN ? j * highestN : EPILOGUE_OFFSET_FROM_LOOP;
             generateMicroKernel(m, k, highestN, lda, ldb, ldc, configuration); // generate microkernel and pass the highestN value
 
             // only restore base pointer as a[i] is always a[0] because no i loop exists
             backend.addInstruction(Instructions::DataProcessing::movRegister32(A_Pointer, A_Base_Pointer));
             // gemm loop i end (next j)
-            // Rewind B -> calculate b[j]. b is advanced in the microkernel by a whole row. so we have to move a few rows forward depending on the size of n
-            uint32_t const addB = ldb * (highestN - 1) * DT_SIZE;
+            // Rewind B -> calculate b[j]. b is advanced in the microkernel by k elements of its first column, so we have to move forward to column highestN
+            uint32_t const addB = (ldb * highestN - k) * DT_SIZE;
             if (addB > LDR_TRESHOLD) {
-                if (addB > MOV_TRESHOLD) backend.addInstruction(Instructions::DataProcessing::movtImmediate32(DLS_COUNT_REGISTER, addB >> 16));
-                backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, addB));
+                backend.addMoveImmediate(DLS_COUNT_REGISTER, addB);
                 backend.addInstruction(Instructions::Arithmetic::addRegister32(B_Pointer, DLS_COUNT_REGISTER));
             } else {
                 backend.addInstruction(Instructions::Arithmetic::addImmediate32(B_Pointer, addB));
@@ -881,8 +1720,7 @@ void (*JIT::Generators::Gemm::generate(uint32_t m, uint32_t k, uint32_t n, uint3
             // C has to move forward to the next block. no m-loop so we have to add the column size
             uint32_t const addC = (highestN) * ldc * DT_SIZE;
             if (addC > LDR_TRESHOLD) {
-                if (addC > MOV_TRESHOLD) backend.addInstruction(Instructions::DataProcessing::movtImmediate32(DLS_COUNT_REGISTER, addC >> 16));
-                backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, addC));
+                backend.addMoveImmediate(DLS_COUNT_REGISTER, addC);
                 backend.addInstruction(Instructions::Arithmetic::addRegister32(C_Pointer, DLS_COUNT_REGISTER));
             } else {
                 backend.addInstruction(Instructions::Arithmetic::addImmediate32(C_Pointer, addC));
@@ -902,37 +1740,45 @@ void (*JIT::Generators::Gemm::generate(uint32_t m, uint32_t k, uint32_t n, uint3
                     backend.addInstruction(Instructions::Base::cmpRegister32(J_Loop_Register, configuration.N_LEN_REGISTER));
                 } else {
                     // if no register can be used then just repurpose the DLS_COUNT_REGISTER as it will be written again in the next iteration anyways
-                    if (nCmp > MOV_TRESHOLD) backend.addInstruction(Instructions::DataProcessing::movtImmediate32(DLS_COUNT_REGISTER, nCmp >> 16));
-                    backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, nCmp));
+                    backend.addMoveImmediate(DLS_COUNT_REGISTER, nCmp);
                     backend.addInstruction(Instructions::Base::cmpRegister32(J_Loop_Register, DLS_COUNT_REGISTER));
                 }
             }
-            backend.addBackwardsBranchFromCurrentPosition(jLoopStart, Instructions::LT); // next iteration (jump back to beginning of the loop)
+            backend.addBranch(jLoopStart, Instructions::LT); // next iteration (jump back to beginning of the loop)
         }
 
         // handle j loop edge cases
         if (n % highestN != 0) {
+            configuration.epilogueColumnOffset = n - (n % highestN);
             generateMicroKernel(m, k, n % highestN, lda, ldb, ldc, configuration);
         } 
     } else { // both i and j loop needed (normally the case if both m and n are large enough)
         backend.addInstruction(JIT::Instructions::DataProcessing::movRegister32(A_Base_Pointer, A_Pointer)); // save a pointer
-        backend.addInstruction(JIT::Instructions::DataProcessing::movImmediate32(J_Loop_Register, 0)); // initialize j loop counter
+        if (!canUnrollN) backend.addInstruction(JIT::Instructions::DataProcessing::movImmediate32(J_Loop_Register, 0)); // initialize j loop counter
 
         /*
         * Loop j (n loop): Count from 0 to n
         */
-        Instructions::Instruction16 * jLoopStart = backend.addBranchTargetInstruction(Instructions::DataProcessing::movImmediate32(I_Loop_Register, 0)); // start j loop: initialize i loop counter
+        IR::Program::Label const jLoopStart = backend.newLabel();
+        backend.annotate("n loop");
+        backend.bindLabel(jLoopStart);
+        backend.addInstruction(Instructions::DataProcessing::movImmediate32(I_Loop_Register, 0)); // start j loop: initialize i loop counter
         uint32_t unrollN = canUnrollN ? (n - (n % DEFAULT_MICROKERNEL_N)) / DEFAULT_MICROKERNEL_N : 1;
         for (uint32_t j = 0; j < unrollN; j++) {
+            configuration.epilogueColumnOffset = canUnrollN ? j * DEFAULT_MICROKERNEL_N : EPILOGUE_OFFSET_FROM_LOOP;
             if (j > 0) backend.addInstruction(Instructions::DataProcessing::movImmediate32(I_Loop_Register, 0)); // initialize i loop counter in each iteration
             /*
             * Loop i (m loop): Count from 0 to m
             */
-            Instructions::Instruction16 * iLoopStart;
-            if (!canUnrollM) iLoopStart = backend.addBranchTargetInstruction(Instructions::Base::nop32()); // start i loop
+            IR::Program::Label const iLoopStart = backend.newLabel();
+            backend.annotate("m loop");
+            if (!canUnrollM) backend.bindLabel(iLoopStart); // start i loop
             uint32_t unrollM = canUnrollM ? (m - (m % DEFAULT_MICROKERNEL_M)) / DEFAULT_MICROKERNEL_M : 1;
             for (uint32_t i = 0; i < unrollM; i++) {
+                configuration.epilogueRowOffset = canUnrollM ? i * DEFAULT_MICROKERNEL_M : EPILOGUE_OFFSET_FROM_LOOP;
+                configuration.predicatedEdge = edgeInILoop;
                 generateMicroKernel(DEFAULT_MICROKERNEL_M, k, DEFAULT_MICROKERNEL_N, lda, ldb, ldc, configuration); // generate microkernel with default parameters
+                configuration.predicatedEdge = false;
 
                 backend.addInstruction(Instructions::Arithmetic::addImmediate32(I_Loop_Register, DEFAULT_MICROKERNEL_M)); // increment i loop counter
                 
@@ -946,8 +1792,7 @@ void (*JIT::Generators::Gemm::generate(uint32_t m, uint32_t k, uint32_t n, uint3
                     if (configuration.registerStrategy & USE_LDB_REGISTER && k == ldb) {
                         backend.addInstruction(Instructions::Arithmetic::subRegister32(B_Pointer, configuration.LDB_REGISTER, Instructions::LSL, 2));
                     } else {
-                        if (DT_SIZE * k > MOV_TRESHOLD) backend.addInstruction(Instructions::DataProcessing::movtImmediate32(DLS_COUNT_REGISTER, (DT_SIZE * k) >> 16));
-                        backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, DT_SIZE * k));
+                        backend.addMoveImmediate(DLS_COUNT_REGISTER, DT_SIZE * k);
                         backend.addInstruction(Instructions::Arithmetic::subRegister32(B_Pointer, DLS_COUNT_REGISTER));
                     }
                 } else {
@@ -958,9 +1803,8 @@ void (*JIT::Generators::Gemm::generate(uint32_t m, uint32_t k, uint32_t n, uint3
                 backend.addInstruction(Instructions::Arithmetic::addImmediate32(C_Pointer, DEFAULT_MICROKERNEL_M * DT_SIZE));
             }
 
-            // ensure that only full microkernels can be executed
+            // ensure that only full microkernels can be executed (or the predicated edge)
             if (!canUnrollM) {
-                uint32_t const mCmp = m - (m % DEFAULT_MICROKERNEL_M);
                 if (mCmp < 255) {
                     backend.addInstruction(Instructions::Base::cmpImmediate32(I_Loop_Register, mCmp));
                 } else if (Instructions::Base::canEncodeImmediateConstant(mCmp)) {
@@ -971,17 +1815,16 @@ void (*JIT::Generators::Gemm::generate(uint32_t m, uint32_t k, uint32_t n, uint3
                         backend.addInstruction(Instructions::Base::cmpRegister32(I_Loop_Register, configuration.M_LEN_REGISTER));
                     } else {
                         // if no register can be used then just repurpose the DLS_COUNT_REGISTER as it will be written again in the next iteration anyways
-                        if (mCmp > MOV_TRESHOLD) backend.addInstruction(Instructions::DataProcessing::movtImmediate32(DLS_COUNT_REGISTER, mCmp >> 16));
-                        backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, mCmp));
+                        backend.addMoveImmediate(DLS_COUNT_REGISTER, mCmp);
                         backend.addInstruction(Instructions::Base::cmpRegister32(I_Loop_Register, DLS_COUNT_REGISTER));
                     }
                 }
-                backend.addBackwardsBranchFromCurrentPosition(iLoopStart, Instructions::LT); // next iteration of i loop
+                backend.addBranch(iLoopStart, Instructions::LT); // next iteration of i loop
             }
 
             // handle i loop edge cases
-            if (m % DEFAULT_MICROKERNEL_M != 0) {
-                Instructions::Instruction16 * branchToTailEnd;
+            if (m % DEFAULT_MICROKERNEL_M != 0 && !edgeInILoop) {
+                IR::Program::Label const tailEnd46 = backend.newLabel();
                 // if we use 4x6 microkernel check if the kernel shall be executed in the current iteration or we have to skip in this iteration
                 // this is done by AND and checking if the loop counter is even. if it is even (0, 6, 12, ...) we can execute the 4x6 microkernel
                 // if it is uneven (3, 9, 15, ...) we have to skip
@@ -989,12 +1832,13 @@ void (*JIT::Generators::Gemm::generate(uint32_t m, uint32_t k, uint32_t n, uint3
                 if (use46Microkernel && !canUnrollN) {
                     backend.addInstruction(Instructions::Arithmetic::andImmediate32(DLS_COUNT_REGISTER, J_Loop_Register, 1));
                     backend.addInstruction(Instructions::Base::cmpImmediate32(DLS_COUNT_REGISTER, 1));
-                    // insert placeholder for forward branch. if we dont execute in this iteration we have to skip to the next iteration (handling for this is at the end)
-                    branchToTailEnd = backend.addBranchPlaceholder(); // beq tailEnd
+                    // if we dont execute in this iteration we have to skip to the next iteration (handling for this is at the end)
+                    backend.addBranch(tailEnd46, Instructions::EQ); // beq tailEnd
                 }
                 // generate edge case microkernel and use 4x6 if possible
                 // if unrolled only insert in correct places
                 if (!use46Microkernel || !canUnrollN || (canUnrollN && use46Microkernel && j % 2 == 0)) {
+                    configuration.epilogueRowOffset = m - (m % DEFAULT_MICROKERNEL_M);
                     generateMicroKernel(m % DEFAULT_MICROKERNEL_M, k, use46Microkernel ? 6 : DEFAULT_MICROKERNEL_N, lda, ldb, ldc, configuration);
 
                     // Rewind
@@ -1004,8 +1848,7 @@ void (*JIT::Generators::Gemm::generate(uint32_t m, uint32_t k, uint32_t n, uint3
                         if (configuration.registerStrategy & USE_LDB_REGISTER && k == ldb) {
                             backend.addInstruction(Instructions::Arithmetic::subRegister32(B_Pointer, configuration.LDB_REGISTER, Instructions::LSL, 2));
                         } else {
-                            if (DT_SIZE * k > MOV_TRESHOLD) backend.addInstruction(Instructions::DataProcessing::movtImmediate32(DLS_COUNT_REGISTER, (DT_SIZE * k) >> 16));
-                            backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, DT_SIZE * k));
+                            backend.addMoveImmediate(DLS_COUNT_REGISTER, DT_SIZE * k);
                             backend.addInstruction(Instructions::Arithmetic::subRegister32(B_Pointer, DLS_COUNT_REGISTER));
                         }
                     } else {
@@ -1014,8 +1857,8 @@ void (*JIT::Generators::Gemm::generate(uint32_t m, uint32_t k, uint32_t n, uint3
                 }
                 // Rewind C => C += 8*4
                 // jump point if 4x6 microkernel is used and not executed in current iteration
-                Instructions::Instruction16 * tailEnd46 = backend.addBranchTargetInstruction(Instructions::Arithmetic::addImmediate32(C_Pointer, (m % DEFAULT_MICROKERNEL_M) * DT_SIZE));
-                if (use46Microkernel && !canUnrollN) backend.setForwardsBranch(branchToTailEnd, tailEnd46, Instructions::EQ);
+                backend.bindLabel(tailEnd46);
+                backend.addInstruction(Instructions::Arithmetic::addImmediate32(C_Pointer, (m % DEFAULT_MICROKERNEL_M) * DT_SIZE));
             }
 
             // gemm loop i end (next j)
@@ -1024,23 +1867,22 @@ void (*JIT::Generators::Gemm::generate(uint32_t m, uint32_t k, uint32_t n, uint3
             // Rewind B -> rewinded by i to start. add 3*len
             uint32_t const addB = ldb * DEFAULT_MICROKERNEL_N * DT_SIZE;
             if (addB > LDR_TRESHOLD) {
-                if (addB > MOV_TRESHOLD) backend.addInstruction(Instructions::DataProcessing::movtImmediate32(DLS_COUNT_REGISTER, addB >> 16));
-                backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, addB));
+                backend.addMoveImmediate(DLS_COUNT_REGISTER, addB);
                 backend.addInstruction(Instructions::Arithmetic::addRegister32(B_Pointer, DLS_COUNT_REGISTER));
             } else {
                 backend.addInstruction(Instructions::Arithmetic::addImmediate32(B_Pointer, addB));
             }
-            // Rewind C -> still have to go two lines -> 2ldc
-            uint32_t const addC = (DEFAULT_MICROKERNEL_N - 1) * ldc * DT_SIZE;
+            // Rewind C -> the i loop advanced C by m elements (a predicated edge by a full block), go to the start of the next block of columns
+            uint32_t const mAdvanced = edgeInILoop ? m - (m % DEFAULT_MICROKERNEL_M) + DEFAULT_MICROKERNEL_M : m;
+            uint32_t const addC = (DEFAULT_MICROKERNEL_N * ldc - mAdvanced) * DT_SIZE;
             if (addC > LDR_TRESHOLD) {
-                if (addC > MOV_TRESHOLD) backend.addInstruction(Instructions::DataProcessing::movtImmediate32(DLS_COUNT_REGISTER, addC >> 16));
-                backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, addC));
+                backend.addMoveImmediate(DLS_COUNT_REGISTER, addC);
                 backend.addInstruction(Instructions::Arithmetic::addRegister32(C_Pointer, DLS_COUNT_REGISTER));
             } else {
                 backend.addInstruction(Instructions::Arithmetic::addImmediate32(C_Pointer, addC));
             }
-            // increment j loop counter (needed for 4x6 microkernel even if unrolled)
-            backend.addInstruction(Instructions::Arithmetic::addImmediate32(J_Loop_Register, DEFAULT_MICROKERNEL_N)); 
+            // increment j loop counter (also selects the iterations of the 4x6 microkernel), an unrolled j loop doesn't need it
+            if (!canUnrollN) backend.addInstruction(Instructions::Arithmetic::addImmediate32(J_Loop_Register, DEFAULT_MICROKERNEL_N));
         }
 
         if (!canUnrollN) {
@@ -1056,21 +1898,26 @@ void (*JIT::Generators::Gemm::generate(uint32_t m, uint32_t k, uint32_t n, uint3
                     backend.addInstruction(Instructions::Base::cmpRegister32(J_Loop_Register, configuration.N_LEN_REGISTER));
                 } else {
                     // if no register can be used then just repurpose the DLS_COUNT_REGISTER as it will be written again in the next iteration anyways
-                    if (nCmp > MOV_TRESHOLD) backend.addInstruction(Instructions::DataProcessing::movtImmediate32(DLS_COUNT_REGISTER, nCmp >> 16));
-                    backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, nCmp));
+                    backend.addMoveImmediate(DLS_COUNT_REGISTER, nCmp);
                     backend.addInstruction(Instructions::Base::cmpRegister32(J_Loop_Register, DLS_COUNT_REGISTER));
                 }
             }
-            backend.addBackwardsBranchFromCurrentPosition(jLoopStart, Instructions::LT);
+            backend.addBranch(jLoopStart, Instructions::LT);
         }
 
         // handle j loop edge cases
         if (n % DEFAULT_MICROKERNEL_N != 0) {
             // new i loop is created for 8x2/8x1 microkernel over which is looped 
             backend.addInstruction(Instructions::DataProcessing::movImmediate32(I_Loop_Register, 0)); //  loop counter for new i loop
-            Instructions::Instruction16 * iLoopStartjTail = backend.addBranchTargetInstruction(Instructions::Base::nop32());
+            IR::Program::Label const iLoopStartjTail = backend.newLabel();
+            backend.annotate("m loop (n tail)");
+            backend.bindLabel(iLoopStartjTail);
 
+            configuration.epilogueRowOffset = EPILOGUE_OFFSET_FROM_LOOP;
+            configuration.epilogueColumnOffset = n - (n % DEFAULT_MICROKERNEL_N);
+            configuration.predicatedEdge = predicatedEdges;
             generateMicroKernel(DEFAULT_MICROKERNEL_M, k, n % DEFAULT_MICROKERNEL_N, lda, ldb, ldc, configuration);
+            configuration.predicatedEdge = false;
             
             backend.addInstruction(Instructions::Arithmetic::addImmediate32(I_Loop_Register, DEFAULT_MICROKERNEL_M));
 
@@ -1093,8 +1940,7 @@ void (*JIT::Generators::Gemm::generate(uint32_t m, uint32_t k, uint32_t n, uint3
             // Rewind C => C += 8*4
             backend.addInstruction(Instructions::Arithmetic::addImmediate32(C_Pointer, DEFAULT_MICROKERNEL_M * DT_SIZE));
 
-            // ensure that only full microkernels can be executed
-            uint32_t const mCmp = m - (m % DEFAULT_MICROKERNEL_M);
+            // ensure that only full microkernels can be executed (or the predicated edge)
             if (mCmp < 255) {
                 backend.addInstruction(Instructions::Base::cmpImmediate32(I_Loop_Register, mCmp));
             } else if (Instructions::Base::canEncodeImmediateConstant(mCmp)) {
@@ -1105,25 +1951,58 @@ void (*JIT::Generators::Gemm::generate(uint32_t m, uint32_t k, uint32_t n, uint3
                     backend.addInstruction(Instructions::Base::cmpRegister32(I_Loop_Register, configuration.M_LEN_REGISTER));
                 } else {
                     // if no register can be used then just repurpose the DLS_COUNT_REGISTER as it will be written again in the next iteration anyways
-                    if (mCmp > MOV_TRESHOLD) backend.addInstruction(Instructions::DataProcessing::movtImmediate32(DLS_COUNT_REGISTER, mCmp >> 16));
-                    backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, mCmp));
+                    backend.addMoveImmediate(DLS_COUNT_REGISTER, mCmp);
                     backend.addInstruction(Instructions::Base::cmpRegister32(I_Loop_Register, DLS_COUNT_REGISTER));
                 }
             }
 
-            backend.addBackwardsBranchFromCurrentPosition(iLoopStartjTail, Instructions::LT);
+            backend.addBranch(iLoopStartjTail, Instructions::LT);
 
             // last corner
-            if (m % DEFAULT_MICROKERNEL_M != 0) {
+            if (m % DEFAULT_MICROKERNEL_M != 0 && !predicatedEdges) {
+                configuration.epilogueRowOffset = m - (m % DEFAULT_MICROKERNEL_M);
                 generateMicroKernel(m % DEFAULT_MICROKERNEL_M, k, n % DEFAULT_MICROKERNEL_N, lda, ldb, ldc, configuration);
             }
         }
     }
 
     // gemm loop j end
+    emitBatchLoopEnd(configuration);
+    return finalizeKernel();
+}
+
+/*
+The pointers of the current matrices and the remaining count are pushed at the start of each batch iteration,
+so all registers can be used by the matrix loops.
+*/
+void JIT::Generators::Gemm::emitBatchLoopStart(MicroKernelConfiguration & configuration) {
+    if (configuration.batch == 0) return;
+    backend.addMoveImmediate(DLS_COUNT_REGISTER, configuration.batch);
+    configuration.batchLoopStart = backend.newLabel();
+    backend.bindLabel(configuration.batchLoopStart);
+    backend.addInstruction(Instructions::DataProcessing::push32(A_Pointer, B_Pointer, C_Pointer, DLS_COUNT_REGISTER));
+}
+
+void JIT::Generators::Gemm::emitBatchLoopEnd(MicroKernelConfiguration & configuration) {
+    if (configuration.batch == 0) return;
+    backend.addInstruction(Instructions::DataProcessing::pop32(A_Pointer, B_Pointer, C_Pointer, DLS_COUNT_REGISTER));
+    // LR is only used inside the microkernels, the loop registers might hold allocated values
+    if (configuration.batchStrideA != 0) backend.addAddImmediate(A_Pointer, A_Pointer, configuration.batchStrideA, SCALE_REGISTER);
+    if (configuration.batchStrideB != 0) backend.addAddImmediate(B_Pointer, B_Pointer, configuration.batchStrideB, SCALE_REGISTER);
+    if (configuration.batchStrideC != 0) backend.addAddImmediate(C_Pointer, C_Pointer, configuration.batchStrideC, SCALE_REGISTER);
+    backend.addInstruction(Instructions::Arithmetic::subImmediate32(DLS_COUNT_REGISTER, 1));
+    backend.addInstruction(Instructions::Base::cmpImmediate32(DLS_COUNT_REGISTER, 0));
+    backend.addBranch(configuration.batchLoopStart, Instructions::NE);
+}
+
+JIT::Generators::Gemm::Func JIT::Generators::Gemm::finalizeKernel() {
+    backend.annotate("restore registers");
     backend.addInstruction(Instructions::DataProcessing::vpop(Instructions::Q4, 4));
     backend.addInstruction(Instructions::DataProcessing::pop32(Instructions::R4, Instructions::R5, Instructions::R6, Instructions::R7, Instructions::R8, Instructions::R9, Instructions::R10, Instructions::R11, Instructions::R12, Instructions::PC));
 
+    backend.endProgram(); // resolves the branches
+    // a program which doesn't fit into the buffer (or the program arena) is not encoded at all, the buffer still holds the previous kernel
+    if (backend.getInstructionCount() == 0) return nullptr;
     backend.clearCaches();
     return reinterpret_cast<Func>(backend.getThumbAddress());
 }
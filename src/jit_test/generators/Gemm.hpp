@@ -8,12 +8,58 @@
 namespace JIT {
     namespace Generators {
         class Gemm;
+        class GemmTuningTable;
     }
 }
 
 class JIT::Generators::Gemm {
+    public:
+        /**
+         * @brief Operations which are applied to the accumulators before C is stored:
+         * C = activation(alpha * A * B + beta * C + bias)
+         * The address of the bias is embedded into the kernel, it has to stay valid as long as the kernel is used.
+         */
+        struct Epilogue {
+            enum Bias : uint8_t {
+                BIAS_NONE = 0,
+                BIAS_PER_ROW = 1, // m values, bias[i] is added to row i of C
+                BIAS_PER_COLUMN = 2, // n values, bias[j] is added to column j of C
+            };
+            enum Activation : uint8_t {
+                ACTIVATION_NONE = 0,
+                ACTIVATION_RELU = 1, // max(x, 0)
+                ACTIVATION_RELU6 = 2, // min(max(x, 0), 6)
+                ACTIVATION_CLAMP = 3, // min(max(x, clampMin), clampMax)
+            };
+            Bias bias;
+            float const * biasValues;
+            Activation activation;
+            float clampMin;
+            float clampMax;
+        };
+
+        /**
+         * @brief Parameters of the NN kernels which are otherwise fixed heuristics, see defaultTuning().
+         * The transposed and packed layouts use the strided microkernels and ignore them.
+         */
+        struct Tuning {
+            bool use46Microkernel; // remaining m % 8 rows use the 4x6 microkernel where possible (otherwise 8x3)
+            uint8_t kMaxUnroll; // k iterations per loop iteration of the microkernel
+            uint8_t mMaxUnroll; // full microkernels of the i loop which are unrolled instead of looped
+            uint8_t nMaxUnroll; // full microkernels of the j loop which are unrolled instead of looped
+            /*
+            m % 8 >= 5 remaining rows run in the last iteration of a looped i loop under a VCTP predicate instead of an own microkernel.
+            Smaller but slower kernels, m % 8 <= 4 rows, unrolled i loops and the N edges keep their microkernels.
+            */
+            bool predicatedEdges;
+        };
+
     private:
         Backend backend;
+        GemmTuningTable const * tuningTable;
+        void * programStorage;
+        uint32_t programStorageBytes;
+        uint16_t programMaxNodes;
         /*
         If no immediates can be used, the priority has to be given to loads from B and A.
         C only has to be accessed at the first and last iteration.
@@ -33,6 +79,9 @@ class JIT::Generators::Gemm {
             - for A VLDR smaller is better, but can be done with a single 
 
         - provide a slow fallback which won't be needed as a 256*256*512 matrix does not fit into the storage of the Ensemble E7 board
+
+        The flags are combined freely: the register allocator assigns the spare registers (R10-R12 and the loop registers
+        which are not needed for the shape) by priority, values without a register use the fallback.
         */
         enum RegisterImmediateStrategy : uint8_t {
             /*
@@ -48,29 +97,6 @@ class JIT::Generators::Gemm {
             USE_N_LEN_REGISTER = 1 << 4,
             USE_M_LEN_REGISTER = 1 << 5,
             USE_BCOL3_REGISTER = 1 << 6,
-
-            /* List all possible combinations */
-            // Large K and large M but priority given to using fast C loads/stores. before each CMP the value has to be loaded and afterwards removed in temp register
-            USE_K_CROW1_CROW2_REGISTER = USE_LDB_REGISTER | USE_CROW1_REGISTER | USE_CROW2_REGISTER,
-            USE_K_CROW1_REGISTER = USE_LDB_REGISTER | USE_CROW1_REGISTER,
-            USE_K_A_CROW1_REGISTER = USE_LDB_REGISTER | USE_A_ADD_REGISTER | USE_CROW1_REGISTER,
-            // Large N and large M but priority given to using fast C loads/stores. before each CMP the value has to be loaded and afterwards removed in temp register
-            USE_N_CROW1_CROW2_REGISTER = USE_N_LEN_REGISTER | USE_CROW1_REGISTER | USE_CROW2_REGISTER,
-            USE_N_CROW1_REGISTER = USE_N_LEN_REGISTER | USE_CROW1_REGISTER,
-            // Large N and large N
-            USE_K_N_LEN_REGISTER = USE_LDB_REGISTER | USE_N_LEN_REGISTER,
-            USE_K_CROW1_N_LEN_REGISTER = USE_LDB_REGISTER | USE_CROW1_REGISTER | USE_N_LEN_REGISTER,
-            USE_CROW1_CROW2_M_REGISTER = USE_CROW1_REGISTER | USE_CROW2_REGISTER | USE_M_LEN_REGISTER,
-            // Large M
-            USE_CROW1_CROW2_REGISTER = USE_CROW1_REGISTER | USE_CROW2_REGISTER,
-            USE_A_CROW1_REGISTER = USE_A_ADD_REGISTER | USE_CROW1_REGISTER,
-            USE_A_CROW1_CROW2_REGISTER = USE_A_ADD_REGISTER | USE_CROW1_REGISTER | USE_CROW2_REGISTER,
-
-            // Using 4x6 Microkernel and needing to use the second K_LEN Register
-            USE_K_K2_REGISTER = USE_LDB_REGISTER | USE_BCOL3_REGISTER,
-            USE_K_K2_CROW1_REGISTER = USE_LDB_REGISTER | USE_BCOL3_REGISTER | USE_CROW1_REGISTER,
-            USE_K_K2_N_LEN_REGISTER = USE_LDB_REGISTER | USE_BCOL3_REGISTER | USE_N_LEN_REGISTER,
-            USE_K_K2_A_REGISTER = USE_LDB_REGISTER | USE_BCOL3_REGISTER | USE_A_ADD_REGISTER,
         };
         struct MicroKernelConfiguration {
             bool insertPreloadHints;
@@ -83,26 +109,225 @@ class JIT::Generators::Gemm {
             Instructions::Register A_ADD_REGISTER;
             Instructions::Register N_LEN_REGISTER;
             Instructions::Register M_LEN_REGISTER;
+            /* operands are transposed (after mapping row-major to column-major) */
+            bool transposeA;
+            bool transposeB;
+            /* operands are stored in the packed panel format, see PACKED */
+            bool packed;
+            /* applied before storing C: by the strided microkernels after the k loop, by emitDeferredStores in the NN microkernels */
+            Epilogue epilogue;
+            bool hasEpilogue;
+            /* first row / column of the current microkernel for the bias, UINT32_MAX: taken from the I/J loop register */
+            uint32_t epilogueRowOffset;
+            uint32_t epilogueColumnOffset;
+            /* vector registers with the bounds of the activation, reloaded before each use if they don't fit into the free registers */
+            Instructions::VectorRegister lowerBoundVector;
+            Instructions::VectorRegister upperBoundVector;
+            bool reloadLowerBound;
+            bool reloadUpperBound;
+            Instructions::VectorRegister epilogueTempVector; // row bias and reloaded bounds
+            uint32_t epilogueLowerBound;
+            uint32_t epilogueUpperBound;
+            /* C = alpha * A * B + beta * C */
+            bool loadC; // false if beta == 0: accumulators are zeroed instead of loading C
+            bool scaleLoadedC; // C is multiplied by beta / alpha after loading
+            bool scaleResult; // accumulators are multiplied by alpha before storing
+            uint32_t betaOverAlpha; // bit patterns of the scalars which are moved into the scale register
+            uint32_t alpha;
+            /* alpha is not a power of two, so beta / alpha isn't exact: the accumulators start at zero and C is added
+               with VFMA by beta after they are scaled by alpha (see emitCombineC) */
+            bool combineC;
+            uint32_t beta;
+            /* set per NN microkernel: the stores of the last k iteration are collected and emitted by emitDeferredStores
+               after all FMAs, when the A and B registers are free */
+            bool deferStores;
+            bool storesScaled; // emitDeferredStores already scaled the accumulators for the epilogue
+            uint32_t deferredStoreCount;
+            Instructions::VectorRegister deferredStores[6];
+            /* set per microkernel: when scaling or when C rows of the 8x3 need address instructions, each store of a partially used
+               vector gets its own VPST instead of the larger VPT blocks */
+            bool predicateStores;
+            /* tracks the value of the scale register to avoid reloading it (LR is overwritten by DLS) */
+            bool scaleRegisterValid;
+            uint32_t scaleRegisterValue;
+            /* 8x3 microkernel in an i loop which also covers the m % 8 >= 5 edge rows: the right vector is predicated with VCTP
+               on the remaining rows (edgeRows - I_Loop_Register), the stores are predicated like predicateStores */
+            bool predicatedEdge;
+            uint32_t edgeRows;
+            /* limit of the k unrolling (Tuning::kMaxUnroll) */
+            uint32_t kMaxUnroll;
+            /* generateBatched: number of matrices (0: no batch loop) and the distance between them in bytes */
+            uint32_t batch;
+            uint32_t batchStrideA;
+            uint32_t batchStrideB;
+            uint32_t batchStrideC;
+            IR::Program::Label batchLoopStart;
         };
 
         void generateMicroKernel(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, MicroKernelConfiguration & configuration);
-        void emitLoadB(Instructions::Register targetReg, MicroKernelConfiguration & configuration, uint32_t leftShiftAmount, uint32_t offset, bool secondHalf = false, bool try16Bit = false);
+        void emitLoadB(Instructions::Register targetReg, MicroKernelConfiguration & configuration, uint32_t leftShiftAmount, uint32_t offset, bool secondHalf = false);
+        void emitRightSidePredicate(uint32_t m, MicroKernelConfiguration & configuration);
         void emitLoadStoreC(MicroKernelConfiguration & configuration, Instructions::VectorRegister targetReg, uint32_t ldc, bool store);
-        void emitLoadStoreC46(Instructions::VectorRegister targetReg, uint32_t ldc, bool store = false);
+        void emitLoadStoreC46(MicroKernelConfiguration & configuration, Instructions::VectorRegister targetReg, uint32_t ldc, bool store = false);
+        void emitScaleC(MicroKernelConfiguration & configuration, Instructions::VectorRegister targetReg, bool store);
+        void emitScale(MicroKernelConfiguration & configuration, Instructions::VectorRegister targetReg, uint32_t scale);
+        void emitCombineC(MicroKernelConfiguration & configuration, Instructions::VectorRegister targetReg);
+        void emitStoreC16(MicroKernelConfiguration & configuration, Instructions::VectorRegister targetReg, bool predicated);
+        void emitAdvanceA16(MicroKernelConfiguration & configuration, uint32_t columns, uint32_t lda);
+        void emitDeferredStores(MicroKernelConfiguration & configuration, uint32_t m, uint32_t ldc);
+        Instructions::Register emitAddressC(MicroKernelConfiguration & configuration, Instructions::VectorRegister targetReg, uint32_t ldc, uint32_t & offset);
+        void emitBiasPointer(MicroKernelConfiguration & configuration);
+        void emitEpilogueSetup(MicroKernelConfiguration & configuration);
+        void emitDeferredEpilogue(MicroKernelConfiguration & configuration, uint32_t m, uint32_t deferred);
+        void emitEpilogue(MicroKernelConfiguration & configuration, Instructions::VectorRegister targetReg, uint32_t column, uint32_t vector, bool predicated);
+
+        /* path for transposed operands */
+        void generateStrided(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, MicroKernelConfiguration & configuration);
+        IR::Program::Label generateStridedColumnBlock(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, MicroKernelConfiguration & configuration);
+        IR::Program::Label generateStridedMicroKernel(uint32_t m, uint32_t k, uint32_t n, uint32_t ldb, MicroKernelConfiguration & configuration);
+        /* path for alpha == 0 */
+        void generateScaleOnly(uint32_t m, uint32_t n, uint32_t ldc, float beta, MicroKernelConfiguration & configuration);
+        /// @brief restores the registers and returns the kernel, nullptr if it doesn't fit into the buffer
+        void (*finalizeKernel())(float const *, float const *, float *);
+        /* the batch loop is placed between the setup of the constant registers and the matrix loops */
+        void emitBatchLoopStart(MicroKernelConfiguration & configuration);
+        void emitBatchLoopEnd(MicroKernelConfiguration & configuration);
     
     public:
-        Gemm(Instructions::Instruction16 * globalBuffer, uint32_t bufferSize) : backend(globalBuffer, bufferSize) {}
+        /**
+         * @brief Memory layout of the operands (same semantics as the CBLAS order and transpose arguments).
+         * lda, ldb and ldc are always the leading dimensions of the matrices as they are stored.
+         */
+        enum Layout : uint8_t {
+            COLUMN_MAJOR = 0, // all matrices are stored column-major
+            TRANSPOSE_A = 1 << 0, // op(A) = A^T
+            TRANSPOSE_B = 1 << 1, // op(B) = B^T
+            ROW_MAJOR = 1 << 2, // all matrices are stored row-major
+            /*
+            A and B are packed panels (see GemmPack), C is column-major. lda and ldb are ignored.
+            A: slivers of PACKED_MR rows, each sliver stores its rows for k = 0, 1, ... contiguously. The last sliver
+               stores m % PACKED_MR rows padded with zeros to a multiple of the vector size.
+            B: slivers of PACKED_NR columns, each sliver stores its columns for k = 0, 1, ... contiguously (k-major).
+               The last sliver has n % PACKED_NR columns.
+            The inner loop only uses post-increment loads, independent of the leading dimensions of the original matrices.
+            */
+            PACKED = 1 << 3,
+
+            /* List all possible combinations */
+            COLUMN_MAJOR_NN = COLUMN_MAJOR,
+            COLUMN_MAJOR_NT = COLUMN_MAJOR | TRANSPOSE_B,
+            COLUMN_MAJOR_TN = COLUMN_MAJOR | TRANSPOSE_A,
+            COLUMN_MAJOR_TT = COLUMN_MAJOR | TRANSPOSE_A | TRANSPOSE_B,
+            ROW_MAJOR_NN = ROW_MAJOR,
+            ROW_MAJOR_NT = ROW_MAJOR | TRANSPOSE_B,
+            ROW_MAJOR_TN = ROW_MAJOR | TRANSPOSE_A,
+            ROW_MAJOR_TT = ROW_MAJOR | TRANSPOSE_A | TRANSPOSE_B,
+        };
+
+        static constexpr uint32_t PACKED_MR = 8;
+        static constexpr uint32_t PACKED_NR = 3;
+
+        static constexpr uint16_t PROGRAM_MAX_LABELS = 256;
+        static constexpr uint16_t PROGRAM_MAX_LITERALS = 64;
+
+        /**
+         * @brief The kernels are built as an IR::Program in the arena programStorage (programStorageBytes bytes), which is only used while
+         * a kernel is generated. Generators which don't generate at the same time (e.g. from an interrupt) may share it.
+         * A kernel whose program doesn't fit into the arena is not returned, see programStorageSize().
+         */
+        Gemm(Instructions::Instruction16 * globalBuffer, uint32_t bufferSize, void * programStorage, uint32_t programStorageBytes)
+            : backend(globalBuffer, bufferSize), tuningTable(nullptr), programStorage(programStorage), programStorageBytes(programStorageBytes),
+              programMaxNodes(IR::Program::nodeCapacity(programStorageBytes, PROGRAM_MAX_LABELS, PROGRAM_MAX_LITERALS)) {
+            backend.enableScheduling();
+        }
+        /**
+         * @brief Arena bytes for the program of any kernel which fits into bufferSize halfwords: every node except the labels holds at least
+         * one halfword. Annotated kernels (Backend::setAnnotations) need a node per annotation on top.
+         */
+        static constexpr uint32_t programStorageSize(uint32_t bufferSize) {
+            uint32_t const nodes = bufferSize + PROGRAM_MAX_LABELS;
+            return IR::Program::storageSize(nodes > UINT16_MAX ? UINT16_MAX : static_cast<uint16_t>(nodes), PROGRAM_MAX_LABELS, PROGRAM_MAX_LITERALS);
+        }
         using Func = void (*) (float const *, float const *, float *);
-        void (*generate(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, bool insertPreloadHints = false))(float const * __restrict__ a, float const * __restrict__ b, float * __restrict__ c);
-        // Func thumbAddressToFunc(uintptr_t thumbAddress) {
-        //     __asm("dsb");
-        //     __asm("isb");
-        //     return reinterpret_cast<JIT::Generators::Gemm::Func>(thumbAddress);
-        // }
-        // Func bufferToFunc(Instructions::Instruction16 * buffer) {
-        //     backend.copyToBuffer(buffer);
-        //     return thumbAddressToFunc(backend.getBufferThumbAddress(buffer));
-        // }
+        /**
+         * @brief Generates C = alpha * A * B + beta * C
+         * beta == 0 skips loading C (C is only written) and alpha == 1, beta == 1 emits the plain C += A * B kernel.
+         * For all other values C is scaled in the first and the last k iteration of the microkernels, so no extra pass over C is needed.
+         * If alpha is a power of two, C is loaded scaled by beta / alpha and the result is scaled by alpha. Otherwise C * (beta / alpha) * alpha
+         * would round, so the accumulators are scaled by alpha and C is loaded again and added with VFMA by beta before storing.
+         * alpha == 0 computes C = beta * C (and the epilogue) without reading A and B, beta == 0 then stores zeros without loading C.
+         *
+         * Row-major problems are generated as the column-major problem C^T = op(B)^T * op(A)^T, i.e. row-major NN uses the same
+         * microkernels as column-major NN. All layouts which still need a transposed operand afterwards use separate microkernels:
+         * a transposed B is loaded with strided scalar loads, a transposed A is loaded with gather loads.
+         * PACKED can't be combined with the other layout flags.
+         *
+         * With an epilogue the bias and the activation are applied to the accumulators before they are stored, so no extra passes over C
+         * are needed. The NN microkernels defer their stores until the FMAs of the last k iteration are done, the other layouts apply
+         * it after the k loop of the strided microkernels.
+         * For row-major layouts the bias refers to the rows and columns of the row-major C.
+         *
+         * Returns nullptr if the arguments are not supported or the kernel doesn't fit into the buffer, also with predicatedEdges.
+         */
+        void (*generate(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, bool insertPreloadHints = false, float alpha = 1.0f, float beta = 1.0f, Layout layout = COLUMN_MAJOR_NN, Epilogue const & epilogue = {}))(float const * __restrict__ a, float const * __restrict__ b, float * __restrict__ c);
+        /**
+         * @brief Generates a single kernel which computes batch GEMMs of the same shape: for i in [0, batch)
+         * C_i = alpha * A_i * B_i + beta * C_i with A_i = a + i * strideA, B_i = b + i * strideB, C_i = c + i * strideC.
+         * The strides are given in elements, a stride of 0 reuses the operand (e.g. shared weights).
+         * The registers are only saved once and the constant registers of the microkernels are set up once, the pointers
+         * and the batch counter are kept on the stack between the matrices. All matrices use the same bias.
+         * The NN microkernels load whole vectors at the M edges (up to 3 elements behind the last column of A and C), the stores
+         * are predicated, so consecutive C matrices may be packed without a gap.
+         * Returns nullptr if batch == 0 or in the cases of generate.
+         */
+        Func generateBatched(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, uint32_t batch, uint32_t strideA, uint32_t strideB, uint32_t strideC, bool insertPreloadHints = false, float alpha = 1.0f, float beta = 1.0f, Layout layout = COLUMN_MAJOR_NN, Epilogue const & epilogue = {});
+        /**
+         * @brief Generates the kernel with explicit parameters instead of the tuning table or the heuristics (used by GemmTuner).
+         * A kernel which doesn't fit into the buffer is not retried with predicatedEdges, nullptr is returned.
+         */
+        Func generateTuned(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, Tuning const & tuning, bool insertPreloadHints = false, float alpha = 1.0f, float beta = 1.0f, Layout layout = COLUMN_MAJOR_NN);
+        /**
+         * @brief generate and generateBatched use the parameters of the table for the shapes it contains, all other shapes use
+         * defaultTuning(). The table is not copied. nullptr only uses the heuristics.
+         * Both generate kernels which don't fit into the buffer again with predicatedEdges.
+         * Kernels which were generated before (e.g. resident in a GemmCache) are not regenerated.
+         */
+        void setTuningTable(GemmTuningTable const * table) {
+            tuningTable = table;
+        }
+        /// @brief The hard-coded heuristics
+        static Tuning defaultTuning();
+        /**
+         * @brief Records the loops, the register saves and the C stores of the next kernel in table (see Disassembler::print).
+         * The table is reset with every kernel, nullptr stops recording. The code is the same with and without annotations.
+         */
+        void setAnnotations(Annotations * table) {
+            backend.setAnnotations(table);
+        }
+        /// @brief Size of the last generated kernel in halfwords
+        uint16_t getInstructionCount() {
+            return backend.getInstructionCount();
+        }
+        /**
+         * @brief Copies the last generated kernel into another buffer and returns it as callable function.
+         * The generated code only uses PC-relative branches, so it can be moved as long as the 4 byte alignment is kept.
+         * 
+         * @param buffer Target buffer (has to be 4 byte aligned)
+         * @return Func 
+         */
+        Func bufferToFunc(Instructions::Instruction16 * buffer) {
+            backend.copyToBuffer(buffer);
+            Backend::clearCaches(buffer, backend.getInstructionCount());
+            return reinterpret_cast<Func>(backend.getBufferThumbAddress(buffer));
+        }
+
+    private:
+        /// @brief Prints why the arguments can't be generated
+        static bool isSupported(Layout layout, Epilogue const & epilogue);
+        /// @brief generateKernel, which is repeated with predicated edges if the kernel doesn't fit into the buffer
+        Func generateFitting(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, bool insertPreloadHints, float alpha, float beta, Layout layout, Epilogue const & epilogue, Tuning const & tuning, uint32_t batch, uint32_t strideA, uint32_t strideB, uint32_t strideC);
+        Func generateKernel(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, bool insertPreloadHints, float alpha, float beta, Layout layout, Epilogue const & epilogue, Tuning const & tuning, uint32_t batch, uint32_t strideA, uint32_t strideB, uint32_t strideC);
+        Tuning lookupTuning(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, Layout layout) const;
 };
 
 #endif // JIT_GENERATORS_GEMM_HPP
\ No newline at end of file
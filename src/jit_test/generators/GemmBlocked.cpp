@@ -0,0 +1,77 @@
+#include "GemmBlocked.hpp"
+#include "instructions/Base.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+static uint32_t roundUp(uint32_t value, uint32_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+JIT::Generators::GemmBlocked::Blocking JIT::Generators::GemmBlocked::chooseBlocking(uint32_t m, uint32_t k, uint32_t n, uint32_t scratchSize) {
+    uint32_t kc = std::min(k, KC_MAX);
+    uint32_t mc = m;
+    uint32_t nc = n;
+    auto fits = [&]() { return static_cast<uint64_t>(kc) * (mc + nc) <= scratchSize; };
+    while (!fits()) {
+        uint32_t const halfM = roundUp((mc + 1) / 2, MR);
+        uint32_t const halfN = roundUp((nc + 1) / 2, NR);
+        if (mc >= nc && halfM < mc) mc = halfM;
+        else if (halfN < nc) nc = halfN;
+        else if (halfM < mc) mc = halfM;
+        else break;
+    }
+    // only a single microkernel is left: shorten the panels instead
+    if (!fits()) kc = scratchSize / (mc + nc);
+    if (kc == 0 || m == 0 || n == 0) return {0, 0, 0};
+    return {mc, kc, nc};
+}
+
+void JIT::Generators::GemmBlocked::packPanel(float const * src, uint32_t ld, uint32_t rows, uint32_t cols, float * dst) {
+    if (ld == rows) {
+        std::memcpy(dst, src, rows * cols * sizeof(float));
+        return;
+    }
+    for (uint32_t j = 0; j < cols; j++) {
+        std::memcpy(dst + j * rows, src + j * ld, rows * sizeof(float));
+    }
+}
+
+bool JIT::Generators::GemmBlocked::run(float const * a, float const * b, float * c, uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, float alpha, float beta) {
+    Blocking blocking = chooseBlocking(m, k, n, scratchSize);
+    if (blocking.kc == 0) {
+        Instructions::Base::printValidationError("GemmBlocked::run: scratch area too small for a single microkernel");
+        return false;
+    }
+    return run(a, b, c, m, k, n, lda, ldb, ldc, blocking, alpha, beta);
+}
+
+bool JIT::Generators::GemmBlocked::run(float const * a, float const * b, float * c, uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, Blocking const & blocking, float alpha, float beta) {
+    if (blocking.mc == 0 || blocking.kc == 0 || blocking.nc == 0 || k == 0
+        || static_cast<uint64_t>(blocking.kc) * (blocking.mc + blocking.nc) > scratchSize) {
+        Instructions::Base::printValidationError("GemmBlocked::run: invalid blocking");
+        return false;
+    }
+    float * packedA = scratch;
+    float * packedB = scratch + blocking.mc * blocking.kc;
+
+    for (uint32_t jc = 0; jc < n; jc += blocking.nc) {
+        uint32_t const nc = std::min(blocking.nc, n - jc);
+        for (uint32_t pc = 0; pc < k; pc += blocking.kc) {
+            uint32_t const kc = std::min(blocking.kc, k - pc);
+            packPanel(b + jc * ldb + pc, ldb, kc, nc, packedB);
+            // beta is applied once, the following panels add their contribution
+            float const panelBeta = pc == 0 ? beta : 1.0f;
+            for (uint32_t ic = 0; ic < m; ic += blocking.mc) {
+                uint32_t const mc = std::min(blocking.mc, m - ic);
+                packPanel(a + pc * lda + ic, lda, mc, kc, packedA);
+                // valid until the next miss of the cache
+                Gemm::Func kernel = cache.get(mc, kc, nc, mc, kc, ldc, false, alpha, panelBeta);
+                if (kernel == nullptr) return false;
+                if (kernelCaller != nullptr) kernelCaller(kernel, packedA, packedB, c + jc * ldc + ic, kernelCallerContext);
+                else kernel(packedA, packedB, c + jc * ldc + ic);
+            }
+        }
+    }
+    return true;
+}
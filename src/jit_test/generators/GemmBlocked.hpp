@@ -0,0 +1,86 @@
+#ifndef JIT_GENERATORS_GEMM_BLOCKED_HPP
+#define JIT_GENERATORS_GEMM_BLOCKED_HPP
+
+#include "generators/Gemm.hpp"
+#include "generators/GemmCache.hpp"
+#include <cstdint>
+
+namespace JIT {
+    namespace Generators {
+        class GemmBlocked;
+    }
+}
+
+/**
+ * @brief Blocked driver around the generated kernels for matrices which live in slow memory (SRAM0).
+ * C = alpha * A * B + beta * C is split into mc x kc x nc blocks. For each block the panels of A (mc x kc) and B (kc x nc)
+ * are copied into a scratch area (normally DTCM) and a kernel generated for the panel shape runs on the copies.
+ * C is accessed in place: the kernels only load and store C once per kc panel.
+ *
+ * Loop order: nc columns of C, kc panel of B (packed once), mc rows of A (packed per block).
+ * Only the first kc panel applies beta, all following panels accumulate into C.
+ * The kernels (at most eight panel shapes times two betas) are kept resident by the passed cache.
+ * All matrices are column-major (COLUMN_MAJOR_NN), the packed panels are stored with the minimal leading dimension.
+ */
+class JIT::Generators::GemmBlocked {
+    public:
+        struct Blocking {
+            uint32_t mc;
+            uint32_t kc;
+            uint32_t nc;
+        };
+
+        /* granularity of the blocks: full 8x3 and 4x6 microkernels */
+        static constexpr uint32_t MR = 8;
+        static constexpr uint32_t NR = 6;
+        /* larger kc panels amortize the C accesses, but the packed A panel grows */
+        static constexpr uint32_t KC_MAX = 256;
+
+        /**
+         * @brief Construct a new blocked driver
+         *
+         * @param cache Cache which generates and keeps the kernels for the panel shapes
+         * @param scratch Area for the packed panels (normally in DTCM)
+         * @param scratchSize Size of the scratch area in floats
+         */
+        GemmBlocked(GemmCache & cache, float * scratch, uint32_t scratchSize) : cache(cache), scratch(scratch), scratchSize(scratchSize), kernelCaller(nullptr), kernelCallerContext(nullptr) {}
+
+        /// @brief Runs a kernel on the packed panels and a block of C
+        using KernelCaller = void (*)(Gemm::Func kernel, float const * a, float const * b, float * c, void * context);
+        /**
+         * @brief The kernels are called through caller instead of directly (the host tests run them in the emulator).
+         * nullptr calls them directly.
+         */
+        void setKernelCaller(KernelCaller caller, void * context) {
+            kernelCaller = caller;
+            kernelCallerContext = context;
+        }
+
+        /**
+         * @brief Picks the largest blocks with mc * kc + kc * nc <= scratchSize.
+         * kc is limited by KC_MAX, afterwards the larger of mc and nc is halved (rounded up to MR/NR) until both panels fit.
+         * Returns {0, 0, 0} if not even a single kc iteration of one microkernel fits.
+         */
+        static Blocking chooseBlocking(uint32_t m, uint32_t k, uint32_t n, uint32_t scratchSize);
+
+        /**
+         * @brief Computes C = alpha * A * B + beta * C for column-major A (lda >= m), B (ldb >= k) and C (ldc >= m).
+         * Returns false if the problem can't be blocked for the scratch area or a kernel could not be generated.
+         * k == 0 is not supported.
+         */
+        bool run(float const * a, float const * b, float * c, uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, float alpha = 1.0f, float beta = 1.0f);
+        /// @brief Same as above with fixed blocks (mc * kc + kc * nc <= scratchSize)
+        bool run(float const * a, float const * b, float * c, uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, Blocking const & blocking, float alpha = 1.0f, float beta = 1.0f);
+
+    private:
+        GemmCache & cache;
+        float * scratch;
+        uint32_t scratchSize;
+        KernelCaller kernelCaller;
+        void * kernelCallerContext;
+
+        /// @brief Copies a rows x cols panel of a column-major matrix into dst (leading dimension rows)
+        static void packPanel(float const * src, uint32_t ld, uint32_t rows, uint32_t cols, float * dst);
+};
+
+#endif // JIT_GENERATORS_GEMM_BLOCKED_HPP
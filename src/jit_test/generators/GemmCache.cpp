@@ -0,0 +1,165 @@
+#include "GemmCache.hpp"
+#include "instructions/Base.hpp"
+#include <cstdint>
+
+JIT::Generators::GemmCache::GemmCache(Gemm & generator, Instructions::Instruction16 * codeRegion, uint32_t regionSize)
+    : generator(generator), codeRegion(codeRegion), regionSize(regionSize) {
+    clear();
+}
+
+// FNV-1a over all fields of the key
+uint32_t JIT::Generators::GemmCache::hash(Key const & key) {
+    uint32_t const fields[] = {key.m, key.k, key.n, key.lda, key.ldb, key.ldc, key.flags, key.alpha, key.beta, key.epilogue, key.biasAddress, key.clampMin, key.clampMax};
+    uint32_t h = 2166136261U;
+    for (uint32_t field : fields) {
+        h ^= field;
+        h *= 16777619U;
+    }
+    return h;
+}
+
+uint8_t JIT::Generators::GemmCache::find(Key const & key) const {
+    // linear probing: the table is never full, so there is always an empty slot which ends the search
+    for (uint32_t slot = hash(key) & (HASH_SLOTS - 1); hashTable[slot] != NONE; slot = (slot + 1) & (HASH_SLOTS - 1)) {
+        if (entries[hashTable[slot]].key == key) return hashTable[slot];
+    }
+    return NONE;
+}
+
+void JIT::Generators::GemmCache::insertHash(uint8_t entry) {
+    uint32_t slot = hash(entries[entry].key) & (HASH_SLOTS - 1);
+    while (hashTable[slot] != NONE) slot = (slot + 1) & (HASH_SLOTS - 1);
+    hashTable[slot] = entry;
+}
+
+// backward shift deletion, so no tombstones are needed and lookups stay short
+void JIT::Generators::GemmCache::eraseHash(uint8_t entry) {
+    uint32_t slot = hash(entries[entry].key) & (HASH_SLOTS - 1);
+    while (hashTable[slot] != entry) slot = (slot + 1) & (HASH_SLOTS - 1);
+    hashTable[slot] = NONE;
+    uint32_t next = (slot + 1) & (HASH_SLOTS - 1);
+    while (hashTable[next] != NONE) {
+        uint32_t home = hash(entries[hashTable[next]].key) & (HASH_SLOTS - 1);
+        // move the entry into the hole if its home slot is not between the hole and its current position
+        bool movable = slot <= next ? (home <= slot || home > next) : (home <= slot && home > next);
+        if (movable) {
+            hashTable[slot] = hashTable[next];
+            hashTable[next] = NONE;
+            slot = next;
+        }
+        next = (next + 1) & (HASH_SLOTS - 1);
+    }
+}
+
+void JIT::Generators::GemmCache::unlink(uint8_t entry) {
+    Entry & e = entries[entry];
+    if (e.prev != NONE) entries[e.prev].next = e.next;
+    else mostRecent = e.next;
+    if (e.next != NONE) entries[e.next].prev = e.prev;
+    else leastRecent = e.prev;
+    e.prev = NONE;
+    e.next = NONE;
+}
+
+void JIT::Generators::GemmCache::pushFront(uint8_t entry) {
+    Entry & e = entries[entry];
+    e.prev = NONE;
+    e.next = mostRecent;
+    if (mostRecent != NONE) entries[mostRecent].prev = entry;
+    mostRecent = entry;
+    if (leastRecent == NONE) leastRecent = entry;
+}
+
+void JIT::Generators::GemmCache::evictLeastRecent() {
+    uint8_t entry = leastRecent;
+    if (entry == NONE) return;
+    unlink(entry);
+    eraseHash(entry);
+    entries[entry].used = false;
+    kernelCount--;
+    statistics.evictions++;
+}
+
+// first fit over the gaps between the resident kernels
+bool JIT::Generators::GemmCache::findGap(uint32_t size, uint32_t & offset) const {
+    uint32_t candidate = 0;
+    while (candidate + size <= regionSize) {
+        // find a resident kernel which overlaps with [candidate, candidate + size)
+        bool overlaps = false;
+        for (uint32_t i = 0; i < MAX_KERNELS; i++) {
+            Entry const & e = entries[i];
+            if (e.used && e.offset < candidate + size && candidate < e.offset + e.size) {
+                candidate = e.offset + e.size; // continue searching behind the overlapping kernel
+                overlaps = true;
+                break;
+            }
+        }
+        if (!overlaps) {
+            offset = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+JIT::Generators::Gemm::Func JIT::Generators::GemmCache::get(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, bool insertPreloadHints, float alpha, float beta, Gemm::Layout layout, Gemm::Epilogue const & epilogue) {
+    Key key = makeKey(m, k, n, lda, ldb, ldc, insertPreloadHints, alpha, beta, layout, epilogue);
+    uint8_t entry = find(key);
+    if (entry != NONE) {
+        statistics.hits++;
+        if (entry != mostRecent) {
+            unlink(entry);
+            pushFront(entry);
+        }
+        return entries[entry].func;
+    }
+
+    statistics.misses++;
+    Gemm::Func stagedFunc = generator.generate(m, k, n, lda, ldb, ldc, insertPreloadHints, alpha, beta, layout, epilogue);
+    // an empty kernel (not encoded, see Gemm::finalizeKernel) is a miss without an entry
+    if (stagedFunc == nullptr || generator.getInstructionCount() == 0) return nullptr;
+    // keep kernels word aligned, so the alignment of the Helium instructions in the staging buffer is kept
+    uint32_t size = (generator.getInstructionCount() + 1) & ~1U;
+    if (size > regionSize) {
+        Instructions::Base::printValidationError("GemmCache: kernel larger than code region - returning kernel from staging buffer");
+        return stagedFunc;
+    }
+
+    uint32_t offset = 0;
+    while (kernelCount == MAX_KERNELS || !findGap(size, offset)) {
+        evictLeastRecent();
+    }
+
+    entry = 0;
+    while (entries[entry].used) entry++;
+    Entry & e = entries[entry];
+    e.key = key;
+    e.offset = offset;
+    e.size = size;
+    e.used = true;
+    e.func = generator.bufferToFunc(&codeRegion[offset]);
+    insertHash(entry);
+    pushFront(entry);
+    kernelCount++;
+    return e.func;
+}
+
+uint32_t JIT::Generators::GemmCache::getUsedSize() const {
+    uint32_t used = 0;
+    for (uint32_t i = 0; i < MAX_KERNELS; i++) {
+        if (entries[i].used) used += entries[i].size;
+    }
+    return used;
+}
+
+void JIT::Generators::GemmCache::clear() {
+    for (uint32_t i = 0; i < MAX_KERNELS; i++) {
+        entries[i].used = false;
+        entries[i].prev = NONE;
+        entries[i].next = NONE;
+    }
+    for (uint32_t i = 0; i < HASH_SLOTS; i++) hashTable[i] = NONE;
+    mostRecent = NONE;
+    leastRecent = NONE;
+    kernelCount = 0;
+}
@@ -0,0 +1,154 @@
+#ifndef JIT_GENERATORS_GEMM_CACHE_HPP
+#define JIT_GENERATORS_GEMM_CACHE_HPP
+
+#include "generators/Gemm.hpp"
+#include "instructions/Base.hpp"
+#include <bit>
+#include <cstdint>
+
+namespace JIT {
+    namespace Generators {
+        class GemmCache;
+    }
+}
+
+/**
+ * @brief Cache in front of the GEMM generator.
+ * Kernels are generated into the buffer of the passed generator (staging buffer) and afterwards copied into the code region.
+ * Several kernels stay resident in the code region (normally ITCM). If the region or the entry table is full,
+ * the least recently used kernels are evicted.
+ *
+ * A returned function pointer is valid until the kernel is evicted, i.e. until the next miss.
+ * No dynamic memory is used: the entry table and the hash table have a fixed size.
+ */
+class JIT::Generators::GemmCache {
+    public:
+        static constexpr uint32_t MAX_KERNELS = 16;
+
+        enum Flags : uint32_t {
+            FLAG_NONE = 0,
+            FLAG_PRELOAD_HINTS = 1 << 0,
+            FLAG_LAYOUT_SHIFT = 1, // Gemm::Layout is stored in the bits above
+        };
+
+        struct Key {
+            uint32_t m;
+            uint32_t k;
+            uint32_t n;
+            uint32_t lda;
+            uint32_t ldb;
+            uint32_t ldc;
+            uint32_t flags;
+            uint32_t alpha; // bit patterns of the scalars
+            uint32_t beta;
+            uint32_t epilogue; // Gemm::Epilogue::Bias | Gemm::Epilogue::Activation << 8
+            uint32_t biasAddress; // embedded into the kernel, 0 without a bias
+            uint32_t clampMin; // bit patterns of the bounds of ACTIVATION_CLAMP, 0 for the other activations
+            uint32_t clampMax;
+            bool operator==(Key const & other) const {
+                return m == other.m && k == other.k && n == other.n && lda == other.lda && ldb == other.ldb && ldc == other.ldc && flags == other.flags
+                    && alpha == other.alpha && beta == other.beta && epilogue == other.epilogue && biasAddress == other.biasAddress
+                    && clampMin == other.clampMin && clampMax == other.clampMax;
+            }
+        };
+
+        /**
+         * @brief Key of generate(m, k, n, lda, ldb, ldc, insertPreloadHints, alpha, beta, layout, epilogue), also used by the kernel images.
+         * Only the parts of the epilogue which end up in the kernel are stored, so epilogues which generate the same kernel share a key.
+         */
+        static Key makeKey(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, bool insertPreloadHints = false, float alpha = 1.0f, float beta = 1.0f, Gemm::Layout layout = Gemm::COLUMN_MAJOR_NN, Gemm::Epilogue const & epilogue = {}) {
+            uint32_t flags = (insertPreloadHints ? FLAG_PRELOAD_HINTS : FLAG_NONE) | static_cast<uint32_t>(layout) << FLAG_LAYOUT_SHIFT;
+            // the kernels only hold the lower 32 bit of the address (the host builds run them in the emulator)
+            uint32_t const biasAddress = epilogue.bias != Gemm::Epilogue::BIAS_NONE ? static_cast<uint32_t>(reinterpret_cast<uintptr_t>(epilogue.biasValues)) : 0;
+            bool const clamp = epilogue.activation == Gemm::Epilogue::ACTIVATION_CLAMP;
+            return {m, k, n, lda, ldb, ldc, flags, std::bit_cast<uint32_t>(alpha), std::bit_cast<uint32_t>(beta),
+                static_cast<uint32_t>(epilogue.bias) | static_cast<uint32_t>(epilogue.activation) << 8, biasAddress,
+                clamp ? std::bit_cast<uint32_t>(epilogue.clampMin) : 0, clamp ? std::bit_cast<uint32_t>(epilogue.clampMax) : 0};
+        }
+
+        /// @brief Epilogue of the kernel of key (inverse of makeKey)
+        static Gemm::Epilogue epilogueOf(Key const & key) {
+            Gemm::Epilogue epilogue = {};
+            epilogue.bias = static_cast<Gemm::Epilogue::Bias>(key.epilogue & 0xff);
+            epilogue.biasValues = reinterpret_cast<float const *>(static_cast<uintptr_t>(key.biasAddress));
+            epilogue.activation = static_cast<Gemm::Epilogue::Activation>(key.epilogue >> 8);
+            epilogue.clampMin = std::bit_cast<float>(key.clampMin);
+            epilogue.clampMax = std::bit_cast<float>(key.clampMax);
+            return epilogue;
+        }
+
+        struct Statistics {
+            uint32_t hits;
+            uint32_t misses;
+            uint32_t evictions;
+        };
+
+        /**
+         * @brief Construct a new Gemm Cache
+         *
+         * @param generator Generator which is used on a miss. Its buffer is used as staging buffer and has to be 4 byte aligned
+         * @param codeRegion Region in which the kernels are kept (has to be 4 byte aligned)
+         * @param regionSize Size of the region in halfwords
+         */
+        GemmCache(Gemm & generator, Instructions::Instruction16 * codeRegion, uint32_t regionSize);
+
+        /**
+         * @brief Returns the kernel for the given shape. On a hit the resident kernel is returned in constant time.
+         * On a miss the kernel is generated and copied into the code region. If the kernel is larger than the whole region,
+         * the kernel in the staging buffer is returned (valid until the next call). nullptr if the kernel can't be generated
+         * or doesn't fit into the staging buffer, no entry is added then.
+         */
+        Gemm::Func get(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, bool insertPreloadHints = false, float alpha = 1.0f, float beta = 1.0f, Gemm::Layout layout = Gemm::COLUMN_MAJOR_NN, Gemm::Epilogue const & epilogue = {});
+
+        Statistics const & getStatistics() const {
+            return statistics;
+        }
+        void resetStatistics() {
+            statistics = {};
+        }
+        /// @brief Count of halfwords which are currently occupied by resident kernels
+        uint32_t getUsedSize() const;
+        uint32_t getKernelCount() const {
+            return kernelCount;
+        }
+        /// @brief Evicts all kernels (statistics are kept)
+        void clear();
+
+    private:
+        static constexpr uint8_t NONE = 0xff;
+        static constexpr uint32_t HASH_SLOTS = 2 * MAX_KERNELS; // power of two, load factor <= 0.5
+
+        struct Entry {
+            Key key;
+            Gemm::Func func;
+            uint32_t offset; // in halfwords from the start of the code region
+            uint32_t size; // in halfwords
+            uint8_t prev; // more recently used entry
+            uint8_t next; // less recently used entry
+            bool used;
+        };
+
+        Gemm & generator;
+        Instructions::Instruction16 * codeRegion;
+        uint32_t regionSize;
+
+        Entry entries[MAX_KERNELS] = {};
+        uint8_t hashTable[HASH_SLOTS];
+        uint8_t mostRecent = NONE;
+        uint8_t leastRecent = NONE;
+        uint32_t kernelCount = 0;
+        Statistics statistics = {};
+
+        static uint32_t hash(Key const & key);
+        uint8_t find(Key const & key) const;
+        void insertHash(uint8_t entry);
+        void eraseHash(uint8_t entry);
+
+        void unlink(uint8_t entry);
+        void pushFront(uint8_t entry);
+        void evictLeastRecent();
+
+        bool findGap(uint32_t size, uint32_t & offset) const;
+};
+
+#endif // JIT_GENERATORS_GEMM_CACHE_HPP
@@ -0,0 +1,324 @@
+#include "GemmF16.hpp"
+#include "backend/Backend.hpp"
+#include "instructions/Arithmetic.hpp"
+#include "instructions/Base.hpp"
+#include "instructions/DataProcessing.hpp"
+#include "instructions/Vector.hpp"
+#include <cstdint>
+
+constexpr JIT::Instructions::Register A_Pointer = JIT::Instructions::R0;
+constexpr JIT::Instructions::Register B_Pointer = JIT::Instructions::R1;
+constexpr JIT::Instructions::Register C_Pointer = JIT::Instructions::R2;
+constexpr JIT::Instructions::Register A_Base_Pointer = JIT::Instructions::R3;
+constexpr JIT::Instructions::Register J_Loop_Register = JIT::Instructions::R4;
+constexpr JIT::Instructions::Register I_Loop_Register = JIT::Instructions::R5;
+constexpr JIT::Instructions::Register DLS_COUNT_REGISTER = JIT::Instructions::R9; // also used as temp register
+constexpr JIT::Instructions::Register B_Base_Pointer = JIT::Instructions::R10;
+constexpr JIT::Instructions::Register LDC_BYTES_REGISTER = JIT::Instructions::R11;
+constexpr JIT::Instructions::Register LDA_BYTES_REGISTER = JIT::Instructions::R12;
+
+/* FP16 accumulation */
+constexpr JIT::Instructions::Register B_Registers[] = {JIT::Instructions::R8, JIT::Instructions::R7, JIT::Instructions::R6};
+constexpr JIT::Instructions::VectorRegister A0_Register = JIT::Instructions::Q6;
+constexpr JIT::Instructions::VectorRegister A1_Register = JIT::Instructions::Q7;
+
+/* FP32 accumulation: C in Q0-Q2, the four k of A in Q3-Q6 and the four k of B in Q7 */
+constexpr JIT::Instructions::VectorRegister A_K0_Register = JIT::Instructions::Q3;
+constexpr JIT::Instructions::VectorRegister B_Vector_Register = JIT::Instructions::Q7;
+// the lanes of B_Vector_Register are moved into these registers (k + 0, k + 1, k + 2, k + 3)
+constexpr JIT::Instructions::Register B_Lane_Registers[] = {JIT::Instructions::R7, JIT::Instructions::R9, JIT::Instructions::R6, JIT::Instructions::R8};
+// widening loads and narrowing stores need a low register as base
+constexpr JIT::Instructions::Register C_Column_Pointer_F32 = JIT::Instructions::R7;
+constexpr JIT::Instructions::Register B_Column_Pointer_F32 = JIT::Instructions::R6;
+
+/* Thresholds for immediates */
+// VLDRH/VSTRH (imm7 << 1)
+constexpr uint32_t VLDRH_TRESHOLD = 254;
+// LDRH (imm12)
+constexpr uint32_t LDRH_TRESHOLD = 4095;
+
+constexpr uint32_t MICROKERNEL_M = 16;
+constexpr uint32_t MICROKERNEL_N = 3;
+// used if m <= 8
+constexpr uint32_t SMALL_M_MICROKERNEL_M = 8;
+constexpr uint32_t SMALL_M_MICROKERNEL_N = 6;
+constexpr uint32_t F32_MICROKERNEL_M = 4;
+constexpr uint32_t F32_MICROKERNEL_N = 3;
+constexpr uint32_t F32_K_UNROLL = 4;
+
+constexpr uint32_t VECTOR_SIZE = 16; // == 128 Bit
+constexpr uint32_t DT_SIZE = 2; // == 16 Bit (FP16)
+constexpr uint32_t VECTOR_ELEMENTS = VECTOR_SIZE / DT_SIZE;
+constexpr uint32_t VECTOR_ELEMENTS_F32 = VECTOR_SIZE / 4;
+
+void JIT::Generators::GemmF16::emitPredicate(MicroKernelConfiguration & configuration, Instructions::Size size, uint32_t count) {
+    if (configuration.predicateCount == count) return;
+    backend.addInstruction(Instructions::DataProcessing::movImmediate32(DLS_COUNT_REGISTER, count));
+    backend.addInstruction(Instructions::Vector::vctp(size, DLS_COUNT_REGISTER));
+    configuration.predicateCount = count;
+}
+
+/*
+FP16 accumulation: the columns of A are loaded into A0 (and A1) with eight elements each, the scalars of B are loaded with LDRH.
+VFMA.F16 (vector by scalar) only uses the bottom halfword of the scalar register.
+The label of the first instruction is returned, so the caller can branch to the start of the microkernel.
+*/
+JIT::IR::Program::Label JIT::Generators::GemmF16::generateMicroKernel(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, MicroKernelConfiguration & configuration) {
+    (void) ldc; // C is accessed via LDC_BYTES_REGISTER
+    uint32_t const vectors = (m + VECTOR_ELEMENTS - 1) / VECTOR_ELEMENTS;
+    bool const predicated = m % VECTOR_ELEMENTS != 0;
+    configuration.predicateCount = 0;
+
+    IR::Program::Label const microKernelStart = backend.newLabel();
+    backend.bindLabel(microKernelStart);
+    backend.addInstruction(Instructions::DataProcessing::movRegister32(A_Pointer, A_Base_Pointer));
+    backend.addInstruction(Instructions::DataProcessing::movRegister32(B_Pointer, B_Base_Pointer));
+    if (predicated) emitPredicate(configuration, Instructions::Size16, m % VECTOR_ELEMENTS);
+
+    // load C, column j is in the registers [j * vectors, (j + 1) * vectors)
+    for (uint32_t j = 0; j < n; j++) {
+        if (j > 0) backend.addInstruction(Instructions::Arithmetic::addRegister32(DLS_COUNT_REGISTER, j == 1 ? C_Pointer : DLS_COUNT_REGISTER, LDC_BYTES_REGISTER));
+        for (uint32_t v = 0; v < vectors; v++) {
+            if (predicated && v == vectors - 1) backend.addInstruction(Instructions::Vector::vpst(1));
+            backend.addInstruction(Instructions::Vector::vldrh(static_cast<Instructions::VectorRegister>(j * vectors + v), j == 0 ? C_Pointer : DLS_COUNT_REGISTER, v * VECTOR_SIZE));
+        }
+    }
+
+    bool const needsDls = k > 1;
+    if (needsDls) {
+        backend.addMoveImmediate(DLS_COUNT_REGISTER, k);
+        backend.addInstruction(Instructions::Base::dls(DLS_COUNT_REGISTER));
+    }
+
+    // load the column of A, the second vector first so the pointer can be advanced by the load of the first one
+    bool const writeBackA = lda * DT_SIZE <= VLDRH_TRESHOLD;
+    IR::Program::Label const kLoopStart = backend.newLabel();
+    backend.annotate("k-loop start");
+    backend.bindLabel(kLoopStart);
+    for (int32_t v = vectors - 1; v >= 0; v--) {
+        Instructions::VectorRegister aReg = v == 0 ? A0_Register : A1_Register;
+        // the last column of A might end inside the last vector
+        Instructions::Instruction32 load = v == 0 && writeBackA
+            ? Instructions::Vector::vldrh(aReg, A_Pointer, lda * DT_SIZE, false, true)
+            : Instructions::Vector::vldrh(aReg, A_Pointer, v * VECTOR_SIZE);
+        if (predicated && v == static_cast<int32_t>(vectors) - 1) backend.addInstruction(Instructions::Vector::vpst(1));
+        backend.addInstruction(load);
+    }
+    if (!writeBackA) backend.addInstruction(Instructions::Arithmetic::addRegister32(A_Pointer, LDA_BYTES_REGISTER));
+
+    // load the row of B in groups of three and accumulate
+    for (uint32_t jStart = 0; jStart < n; jStart += 3) {
+        uint32_t const jEnd = jStart + 3 < n ? jStart + 3 : n;
+        for (uint32_t j = jStart; j < jEnd; j++) {
+            uint32_t const offset = j * ldb * DT_SIZE;
+            if (offset <= LDRH_TRESHOLD) {
+                backend.addInstruction(Instructions::DataProcessing::ldrhImmediate32(B_Registers[j % 3], B_Pointer, offset));
+            } else { // LR holds the loop count, so DLS_COUNT_REGISTER is free inside the loop
+                backend.addMoveImmediate(DLS_COUNT_REGISTER, offset);
+                backend.addInstruction(Instructions::DataProcessing::ldrhRegister32(B_Registers[j % 3], B_Pointer, DLS_COUNT_REGISTER));
+            }
+        }
+        for (uint32_t j = jStart; j < jEnd; j++) {
+            for (uint32_t v = 0; v < vectors; v++) {
+                backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(static_cast<Instructions::VectorRegister>(j * vectors + v), v == 0 ? A0_Register : A1_Register, B_Registers[j % 3], true));
+            }
+        }
+    }
+    backend.addInstruction(Instructions::Arithmetic::addImmediate32(B_Pointer, DT_SIZE));
+
+    if (needsDls) backend.addLowOverheadBranch(kLoopStart);
+
+    // store C
+    for (uint32_t j = 0; j < n; j++) {
+        if (j > 0) backend.addInstruction(Instructions::Arithmetic::addRegister32(DLS_COUNT_REGISTER, j == 1 ? C_Pointer : DLS_COUNT_REGISTER, LDC_BYTES_REGISTER));
+        for (uint32_t v = 0; v < vectors; v++) {
+            if (predicated && v == vectors - 1) backend.addInstruction(Instructions::Vector::vpst(1));
+            backend.addInstruction(Instructions::Vector::vstrh(static_cast<Instructions::VectorRegister>(j * vectors + v), j == 0 ? C_Pointer : DLS_COUNT_REGISTER, v * VECTOR_SIZE));
+        }
+    }
+    return microKernelStart;
+}
+
+/*
+One unrolled step of the FP32 accumulating k loop (kCount <= 4):
+- the kCount columns of A are loaded widened into the 32 bit lanes and converted to FP32
+- per column of C, the kCount elements of B are loaded the same way and moved to GP registers for VFMA (vector by scalar)
+If kCount < 4 the load of B is predicated, so no element behind the column of B is accessed.
+*/
+void JIT::Generators::GemmF16::emitKGroupF32(uint32_t kCount, uint32_t m, uint32_t n, uint32_t lda, uint32_t ldb, MicroKernelConfiguration & configuration) {
+    bool const predicated = m % VECTOR_ELEMENTS_F32 != 0;
+    bool const writeBackA = lda * DT_SIZE <= VLDRH_TRESHOLD;
+
+    for (uint32_t kk = 0; kk < kCount; kk++) {
+        Instructions::VectorRegister aReg = static_cast<Instructions::VectorRegister>(A_K0_Register + kk);
+        Instructions::Instruction32 load = writeBackA
+            ? Instructions::Vector::vldrhWidening(aReg, A_Pointer, lda * DT_SIZE, false, true)
+            : Instructions::Vector::vldrhWidening(aReg, A_Pointer);
+        if (predicated) backend.addInstruction(Instructions::Vector::vpst(1)); // the last column of A might end inside the vector
+        backend.addInstruction(load);
+        if (!writeBackA) backend.addInstruction(Instructions::Arithmetic::addRegister32(A_Pointer, LDA_BYTES_REGISTER));
+        backend.addInstruction(Instructions::Vector::vcvtb(aReg, aReg, true));
+    }
+
+    if (kCount < F32_K_UNROLL) emitPredicate(configuration, Instructions::Size32, kCount);
+    for (uint32_t j = 0; j < n; j++) {
+        Instructions::Register bBase = B_Pointer;
+        uint32_t offset = j * ldb * DT_SIZE;
+        if (offset > VLDRH_TRESHOLD) {
+            backend.addAddImmediate(B_Column_Pointer_F32, B_Pointer, offset, B_Column_Pointer_F32);
+            bBase = B_Column_Pointer_F32;
+            offset = 0;
+        }
+        if (kCount < F32_K_UNROLL) backend.addInstruction(Instructions::Vector::vpst(1));
+        backend.addInstruction(Instructions::Vector::vldrhWidening(B_Vector_Register, bBase, offset));
+        backend.addInstruction(Instructions::Vector::vcvtb(B_Vector_Register, B_Vector_Register, true));
+        backend.addInstruction(Instructions::Vector::vmovLanesToGP(B_Lane_Registers[2], B_Lane_Registers[0], B_Vector_Register, false));
+        if (kCount > 1) backend.addInstruction(Instructions::Vector::vmovLanesToGP(B_Lane_Registers[3], B_Lane_Registers[1], B_Vector_Register, true));
+        for (uint32_t kk = 0; kk < kCount; kk++) {
+            backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(static_cast<Instructions::VectorRegister>(j), static_cast<Instructions::VectorRegister>(A_K0_Register + kk), B_Lane_Registers[kk]));
+        }
+    }
+    backend.addInstruction(Instructions::Arithmetic::addImmediate32(B_Pointer, kCount * DT_SIZE));
+}
+
+JIT::IR::Program::Label JIT::Generators::GemmF16::generateMicroKernelF32(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, MicroKernelConfiguration & configuration) {
+    (void) ldc; // C is accessed via LDC_BYTES_REGISTER
+    bool const predicated = m % VECTOR_ELEMENTS_F32 != 0;
+    configuration.predicateCount = 0;
+
+    IR::Program::Label const microKernelStart = backend.newLabel();
+    backend.bindLabel(microKernelStart);
+    backend.addInstruction(Instructions::DataProcessing::movRegister32(A_Pointer, A_Base_Pointer));
+    backend.addInstruction(Instructions::DataProcessing::movRegister32(B_Pointer, B_Base_Pointer));
+    if (predicated) emitPredicate(configuration, Instructions::Size32, m);
+
+    // load C, column j is in Qj
+    for (uint32_t j = 0; j < n; j++) {
+        if (j > 0) backend.addInstruction(Instructions::Arithmetic::addRegister32(C_Column_Pointer_F32, j == 1 ? C_Pointer : C_Column_Pointer_F32, LDC_BYTES_REGISTER));
+        Instructions::VectorRegister cReg = static_cast<Instructions::VectorRegister>(j);
+        if (predicated) backend.addInstruction(Instructions::Vector::vpst(1));
+        backend.addInstruction(Instructions::Vector::vldrhWidening(cReg, j == 0 ? C_Pointer : C_Column_Pointer_F32));
+        backend.addInstruction(Instructions::Vector::vcvtb(cReg, cReg, true));
+    }
+
+    uint32_t const groups = k / F32_K_UNROLL;
+    if (groups > 1) {
+        backend.addMoveImmediate(DLS_COUNT_REGISTER, groups);
+        backend.addInstruction(Instructions::Base::dls(DLS_COUNT_REGISTER));
+        IR::Program::Label const kLoopStart = backend.newLabel();
+        backend.annotate("k-loop start");
+        backend.bindLabel(kLoopStart);
+        emitKGroupF32(F32_K_UNROLL, m, n, lda, ldb, configuration);
+        backend.addLowOverheadBranch(kLoopStart);
+    } else if (groups == 1) {
+        emitKGroupF32(F32_K_UNROLL, m, n, lda, ldb, configuration);
+    }
+    if (k % F32_K_UNROLL != 0) {
+        emitKGroupF32(k % F32_K_UNROLL, m, n, lda, ldb, configuration);
+    }
+
+    // store C
+    if (predicated) emitPredicate(configuration, Instructions::Size32, m);
+    for (uint32_t j = 0; j < n; j++) {
+        if (j > 0) backend.addInstruction(Instructions::Arithmetic::addRegister32(C_Column_Pointer_F32, j == 1 ? C_Pointer : C_Column_Pointer_F32, LDC_BYTES_REGISTER));
+        Instructions::VectorRegister cReg = static_cast<Instructions::VectorRegister>(j);
+        backend.addInstruction(Instructions::Vector::vcvtb(cReg, cReg, false));
+        if (predicated) backend.addInstruction(Instructions::Vector::vpst(1));
+        backend.addInstruction(Instructions::Vector::vstrhNarrowing(cReg, j == 0 ? C_Pointer : C_Column_Pointer_F32));
+    }
+    return microKernelStart;
+}
+
+/*
+Runs the microkernels over all rows of a block of n columns of C.
+Afterwards A_Base_Pointer and C_Pointer point to the first row again.
+*/
+JIT::IR::Program::Label JIT::Generators::GemmF16::generateColumnBlock(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, MicroKernelConfiguration & configuration) {
+    uint32_t const mr = configuration.mr;
+    uint32_t const mFull = m - (m % mr);
+    auto microKernel = [&](uint32_t mTile) {
+        return configuration.accumulation == ACCUMULATE_F32
+            ? generateMicroKernelF32(mTile, k, n, lda, ldb, ldc, configuration)
+            : generateMicroKernel(mTile, k, n, lda, ldb, ldc, configuration);
+    };
+
+    IR::Program::Label const blockStart = backend.newLabel();
+    backend.bindLabel(blockStart);
+    backend.addInstruction(Instructions::DataProcessing::movImmediate32(I_Loop_Register, 0));
+    if (mFull > 0) {
+        IR::Program::Label const iLoopStart = microKernel(mr);
+        backend.addInstruction(Instructions::Arithmetic::addImmediate32(A_Base_Pointer, mr * DT_SIZE));
+        backend.addInstruction(Instructions::Arithmetic::addImmediate32(C_Pointer, mr * DT_SIZE));
+        if (mFull > mr) {
+            backend.addInstruction(Instructions::Arithmetic::addImmediate32(I_Loop_Register, mr));
+            backend.addCompareImmediate(I_Loop_Register, mFull, DLS_COUNT_REGISTER);
+            backend.addBranch(iLoopStart, Instructions::LT);
+        }
+    }
+    if (m % mr != 0) {
+        microKernel(m % mr);
+    }
+
+    // rewind A and C to the first row
+    backend.addAddImmediate(A_Base_Pointer, A_Base_Pointer, mFull * DT_SIZE, DLS_COUNT_REGISTER, true);
+    backend.addAddImmediate(C_Pointer, C_Pointer, mFull * DT_SIZE, DLS_COUNT_REGISTER, true);
+    return blockStart;
+}
+
+JIT::Generators::GemmF16::Func JIT::Generators::GemmF16::generate(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, Accumulation accumulation) {
+    backend.resetKernel();
+    IR::Arena arena(programStorage, sizeof(programStorage));
+    IR::Program program(arena, MAX_NODES, MAX_LABELS, MAX_LITERALS);
+    backend.beginProgram(program);
+
+    // push all registers to the stack
+    backend.annotate("save registers");
+    backend.addInstruction(Instructions::DataProcessing::push32(Instructions::R4, Instructions::R5, Instructions::R6, Instructions::R7, Instructions::R8, Instructions::R9, Instructions::R10, Instructions::R11, Instructions::R12, Instructions::LR));
+    backend.addInstruction(Instructions::DataProcessing::vpush(Instructions::Q4, 4));
+
+    MicroKernelConfiguration configuration = {};
+    configuration.accumulation = accumulation;
+    if (accumulation == ACCUMULATE_F32) {
+        configuration.mr = F32_MICROKERNEL_M;
+        configuration.nr = F32_MICROKERNEL_N;
+    } else if (m <= SMALL_M_MICROKERNEL_M) {
+        configuration.mr = SMALL_M_MICROKERNEL_M;
+        configuration.nr = SMALL_M_MICROKERNEL_N;
+    } else {
+        configuration.mr = MICROKERNEL_M;
+        configuration.nr = MICROKERNEL_N;
+    }
+    uint32_t const nr = configuration.nr;
+    uint32_t const nFull = n - (n % nr);
+
+    backend.addMoveImmediate(LDC_BYTES_REGISTER, ldc * DT_SIZE);
+    backend.addMoveImmediate(LDA_BYTES_REGISTER, lda * DT_SIZE);
+    backend.addInstruction(Instructions::DataProcessing::movRegister32(A_Base_Pointer, A_Pointer));
+    backend.addInstruction(Instructions::DataProcessing::movRegister32(B_Base_Pointer, B_Pointer));
+
+    if (nFull > 0) {
+        backend.addInstruction(Instructions::DataProcessing::movImmediate32(J_Loop_Register, 0));
+        IR::Program::Label const jLoopStart = generateColumnBlock(m, k, nr, lda, ldb, ldc, configuration);
+        // next column block: B += nr columns, C += nr columns
+        backend.addAddImmediate(B_Base_Pointer, B_Base_Pointer, nr * ldb * DT_SIZE, DLS_COUNT_REGISTER);
+        backend.addAddImmediate(C_Pointer, C_Pointer, nr * ldc * DT_SIZE, DLS_COUNT_REGISTER);
+        if (nFull > nr) {
+            backend.addInstruction(Instructions::Arithmetic::addImmediate32(J_Loop_Register, nr));
+            backend.addCompareImmediate(J_Loop_Register, nFull, DLS_COUNT_REGISTER);
+            backend.addBranch(jLoopStart, Instructions::LT);
+        }
+    }
+    if (n % nr != 0) {
+        generateColumnBlock(m, k, n % nr, lda, ldb, ldc, configuration);
+    }
+
+    backend.annotate("restore registers");
+    backend.addInstruction(Instructions::DataProcessing::vpop(Instructions::Q4, 4));
+    backend.addInstruction(Instructions::DataProcessing::pop32(Instructions::R4, Instructions::R5, Instructions::R6, Instructions::R7, Instructions::R8, Instructions::R9, Instructions::R10, Instructions::R11, Instructions::R12, Instructions::PC));
+    backend.endProgram(); // resolves the branches
+
+    // a program which doesn't fit into the buffer is not encoded at all
+    if (backend.getInstructionCount() == 0) return nullptr;
+    backend.clearCaches();
+    return reinterpret_cast<Func>(backend.getThumbAddress());
+}
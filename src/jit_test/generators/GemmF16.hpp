@@ -0,0 +1,70 @@
+#ifndef JIT_GENERATORS_GEMM_F16_HPP
+#define JIT_GENERATORS_GEMM_F16_HPP
+
+#include "backend/Backend.hpp"
+#include "instructions/Base.hpp"
+#include <cstdint>
+
+namespace JIT {
+    namespace Generators {
+        class GemmF16;
+    }
+}
+
+/**
+ * @brief Generator for half precision GEMMs: C += A * B with column-major A, B and C stored as FP16.
+ * A vector holds eight FP16 lanes, so the microkernels cover twice the rows of the FP32 generator:
+ * 16x3 (two A vectors) and 8x6 (one A vector, used if m <= 8).
+ *
+ * With FP32 accumulation only the storage is FP16: A and C are loaded with widening loads and converted with VCVTB,
+ * C is converted back before the narrowing store. B is loaded four k at a time, converted and moved into GP registers
+ * with VMOV (two lanes per instruction), so the k loop is unrolled by four and the microkernel is 4x3.
+ */
+class JIT::Generators::GemmF16 {
+    public:
+        enum Accumulation : uint8_t {
+            ACCUMULATE_F16 = 0, // twice the throughput of FP32, the rounding error grows with k
+            ACCUMULATE_F32 = 1,
+        };
+
+    private:
+        // the kernels only contain the loops and microkernels of two column blocks, their size doesn't grow with the shape
+        static constexpr uint16_t MAX_NODES = 1024;
+        static constexpr uint16_t MAX_LABELS = 32;
+        static constexpr uint16_t MAX_LITERALS = 16;
+
+        Backend backend;
+        alignas(4) uint8_t programStorage[IR::Program::storageSize(MAX_NODES, MAX_LABELS, MAX_LITERALS)];
+        struct MicroKernelConfiguration {
+            Accumulation accumulation;
+            /* size of the full microkernels */
+            uint32_t mr;
+            uint32_t nr;
+            /* elements enabled by the last VCTP, 0 if unknown (e.g. at the start of each microkernel as it is a branch target) */
+            uint32_t predicateCount;
+        };
+
+        IR::Program::Label generateColumnBlock(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, MicroKernelConfiguration & configuration);
+        IR::Program::Label generateMicroKernel(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, MicroKernelConfiguration & configuration);
+        IR::Program::Label generateMicroKernelF32(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, MicroKernelConfiguration & configuration);
+        void emitKGroupF32(uint32_t kCount, uint32_t m, uint32_t n, uint32_t lda, uint32_t ldb, MicroKernelConfiguration & configuration);
+        void emitPredicate(MicroKernelConfiguration & configuration, Instructions::Size size, uint32_t count);
+
+    public:
+        using Func = void (*) (_Float16 const *, _Float16 const *, _Float16 *);
+
+        GemmF16(Instructions::Instruction16 * globalBuffer, uint32_t bufferSize) : backend(globalBuffer, bufferSize) {
+            backend.enableScheduling();
+        }
+        /**
+         * @brief Generates C += A * B for column-major FP16 matrices (lda, ldb and ldc in elements)
+         * Returns nullptr if the kernel doesn't fit into the buffer.
+         */
+        Func generate(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, Accumulation accumulation = ACCUMULATE_F16);
+        /// @brief Size of the last generated kernel in halfwords
+        uint16_t getInstructionCount() {
+            return backend.getInstructionCount();
+        }
+};
+
+#endif // JIT_GENERATORS_GEMM_F16_HPP
@@ -0,0 +1,234 @@
+#include "GemmGeneric.hpp"
+#include "backend/Backend.hpp"
+#include "instructions/Arithmetic.hpp"
+#include "instructions/Base.hpp"
+#include "instructions/DataProcessing.hpp"
+#include "instructions/Vector.hpp"
+#include <cstddef>
+#include <cstdint>
+
+/*
+Register map of the generic kernel:
+- R0, R1, R2: A, B, C (current block)
+- R3: Shape on entry, afterwards R3, R4, R5: elements of the three B columns
+- R6, R7, R8: lda, ldb, ldc in bytes
+- R9: address of the second and third C column
+- R10, R11: remaining rows and columns
+- R12: temp (values of the stack frame, vctp count)
+- LR: k loop (WLS/LE)
+- Q0 - Q5: accumulators (column * vectors + vector), Q6 - Q7: A
+The values which are only needed once per microkernel are kept in a stack frame below the saved registers.
+*/
+constexpr JIT::Instructions::Register A_Pointer = JIT::Instructions::R0;
+constexpr JIT::Instructions::Register B_Pointer = JIT::Instructions::R1;
+constexpr JIT::Instructions::Register C_Pointer = JIT::Instructions::R2;
+constexpr JIT::Instructions::Register Shape_Pointer = JIT::Instructions::R3;
+constexpr JIT::Instructions::Register B_Registers[] = {JIT::Instructions::R3, JIT::Instructions::R4, JIT::Instructions::R5};
+constexpr JIT::Instructions::Register LDA_Register = JIT::Instructions::R6;
+constexpr JIT::Instructions::Register LDB_Register = JIT::Instructions::R7;
+constexpr JIT::Instructions::Register LDC_Register = JIT::Instructions::R8;
+constexpr JIT::Instructions::Register C_Column_Pointer = JIT::Instructions::R9;
+constexpr JIT::Instructions::Register I_Register = JIT::Instructions::R10;
+constexpr JIT::Instructions::Register J_Register = JIT::Instructions::R11;
+constexpr JIT::Instructions::Register Temp_Register = JIT::Instructions::R12;
+constexpr JIT::Instructions::VectorRegister A_Register = JIT::Instructions::Q6;
+
+/* stack frame, pushed as {R4, R5, R9, R12} (lowest register at the lowest address) */
+constexpr JIT::Instructions::Register Frame_M = JIT::Instructions::R4;
+constexpr JIT::Instructions::Register Frame_A_Rewind = JIT::Instructions::R5; // k * lda in bytes
+constexpr JIT::Instructions::Register Frame_B_Rewind = JIT::Instructions::R9; // k in bytes
+constexpr JIT::Instructions::Register Frame_K_Loop = JIT::Instructions::R12; // k - 1
+constexpr int16_t FRAME_M = 0;
+constexpr int16_t FRAME_A_REWIND = 4;
+constexpr int16_t FRAME_B_REWIND = 8;
+constexpr int16_t FRAME_K_LOOP = 12;
+
+constexpr uint32_t VECTOR_SIZE = 16; // == 128 Bit
+constexpr uint32_t DT_SIZE = 4; // == 32 Bit (FP32)
+constexpr uint32_t VECTOR_ELEMENTS = VECTOR_SIZE / DT_SIZE;
+
+/*
+One block of up to 8 rows and up to 3 columns of C, for all k: the block is loaded, k rank-1 updates are accumulated
+in a low overhead loop and the block is stored. Afterwards A points to the next rows, B back to its first row and C to
+the next rows. Predicated blocks limit the last vector with the predicate of the VCTP in front of them, they are the
+last rows of the columns: A and C advance by the remaining rows.
+*/
+void JIT::Generators::GemmGeneric::emitMicroKernel(uint32_t vectors, bool predicated, uint32_t columns) {
+    using namespace Instructions;
+
+    auto accumulator = [vectors](uint32_t column, uint32_t vector) {
+        return static_cast<VectorRegister>(column * vectors + vector);
+    };
+    auto loadStoreC = [&](bool store) {
+        for (uint32_t column = 0; column < columns; column++) {
+            if (column == 1) backend.addInstruction(Arithmetic::addRegister32(C_Column_Pointer, C_Pointer, LDC_Register));
+            if (column == 2) backend.addInstruction(Arithmetic::addRegister32(C_Column_Pointer, C_Pointer, LDC_Register, LSL, 1));
+            Register const base = column == 0 ? C_Pointer : C_Column_Pointer;
+            for (uint32_t vector = 0; vector < vectors; vector++) {
+                int16_t const offset = static_cast<int16_t>(vector * VECTOR_SIZE);
+                if (predicated && vector == vectors - 1) backend.addInstruction(Vector::vpst(1));
+                backend.addInstruction(store ? Vector::vstrw(accumulator(column, vector), base, offset) : Vector::vldrw(accumulator(column, vector), base, offset));
+            }
+        }
+    };
+
+    auto loadA = [&](uint32_t vector) {
+        if (predicated && vector == vectors - 1) backend.addInstruction(Vector::vpst(1));
+        backend.addInstruction(Vector::vldrw(static_cast<VectorRegister>(A_Register + vector), A_Pointer, static_cast<int16_t>(vector * VECTOR_SIZE)));
+    };
+    // B0 is loaded last, it advances B to the next k
+    auto loadB = [&](uint32_t column) {
+        if (column == 0) backend.addInstruction(DataProcessing::ldrImmediate32(B_Registers[0], B_Pointer, DT_SIZE, false, true));
+        else backend.addInstruction(DataProcessing::ldrRegister32(B_Registers[column], B_Pointer, LDB_Register, column - 1));
+    };
+    /*
+    One k: the columns are accumulated from the last one, so each B value and (after the first column) each A vector is
+    reloaded for the next k right after its last use and the loads fill the gaps between the FMAs. A advances after the first FMA.
+    */
+    auto rankOneUpdate = [&](bool loadNext) {
+        for (uint32_t column = columns; column-- > 0;) {
+            for (uint32_t vector = 0; vector < vectors; vector++) {
+                backend.addInstruction(Vector::vfmaVectorByScalarPlusVector(accumulator(column, vector), static_cast<VectorRegister>(A_Register + vector), B_Registers[column]));
+                if (column == columns - 1 && vector == 0) backend.addInstruction(Arithmetic::addRegister32(A_Pointer, LDA_Register));
+                if (loadNext && column == 0 && vector == vectors - 1) loadB(0);
+                if (loadNext && column == 0) loadA(vector);
+            }
+            if (loadNext && column > 0) loadB(column);
+        }
+    };
+
+    // the loop runs k - 1 times with the loads of the next k, the last k is peeled so nothing behind A and B is read
+    loadStoreC(false);
+    for (uint32_t vector = 0; vector < vectors; vector++) loadA(vector);
+    for (uint32_t column = columns; column-- > 0;) loadB(column);
+    IR::Program::Label const kLoop = backend.newLabel();
+    IR::Program::Label const kLast = backend.newLabel();
+    backend.addInstruction(DataProcessing::ldrImmediate32(Temp_Register, SP, FRAME_K_LOOP));
+    backend.addLoopStart(Temp_Register, kLast);
+    backend.bindLabel(kLoop);
+    rankOneUpdate(true);
+    backend.addLowOverheadBranch(kLoop);
+    backend.bindLabel(kLast);
+    rankOneUpdate(false);
+    loadStoreC(true);
+
+    backend.addInstruction(DataProcessing::ldrImmediate32(Temp_Register, SP, FRAME_A_REWIND));
+    backend.addInstruction(Arithmetic::subRegister32(A_Pointer, Temp_Register));
+    if (predicated) {
+        backend.addInstruction(Arithmetic::addRegister32(A_Pointer, I_Register, LSL, 2));
+        backend.addInstruction(Arithmetic::addRegister32(C_Pointer, I_Register, LSL, 2));
+    } else {
+        backend.addInstruction(Arithmetic::addImmediate32(A_Pointer, MR * DT_SIZE));
+        backend.addInstruction(Arithmetic::addImmediate32(C_Pointer, MR * DT_SIZE));
+    }
+    backend.addInstruction(DataProcessing::ldrImmediate32(Temp_Register, SP, FRAME_B_REWIND));
+    backend.addInstruction(Arithmetic::subRegister32(B_Pointer, Temp_Register));
+}
+
+/*
+All m rows of one block of columns: the full microkernels while at least MR rows remain, then the rest with a
+predicated microkernel of one (1-4 rows) or two vectors (5-7 rows).
+*/
+void JIT::Generators::GemmGeneric::emitRows(uint32_t columns) {
+    using namespace Instructions;
+    IR::Program::Label const rowLoop = backend.newLabel();
+    IR::Program::Label const rowTail = backend.newLabel();
+    IR::Program::Label const twoVectors = backend.newLabel();
+    IR::Program::Label const rowsDone = backend.newLabel();
+
+    backend.addInstruction(DataProcessing::ldrImmediate32(I_Register, SP, FRAME_M));
+    backend.addInstruction(Base::cmpImmediate32(I_Register, MR));
+    backend.addBranch(rowTail, LT);
+    backend.bindLabel(rowLoop);
+    emitMicroKernel(MR / VECTOR_ELEMENTS, false, columns);
+    backend.addInstruction(Arithmetic::subImmediate32(I_Register, MR));
+    backend.addInstruction(Base::cmpImmediate32(I_Register, MR));
+    backend.addBranch(rowLoop, GE);
+
+    backend.bindLabel(rowTail);
+    backend.addCompareBranch(I_Register, rowsDone);
+    backend.addInstruction(Base::cmpImmediate32(I_Register, VECTOR_ELEMENTS));
+    backend.addBranch(twoVectors, GT);
+    backend.addInstruction(Vector::vctp(Size32, I_Register));
+    emitMicroKernel(1, true, columns);
+    backend.addBranch(rowsDone);
+
+    backend.bindLabel(twoVectors);
+    backend.addInstruction(Arithmetic::subImmediate32(Temp_Register, I_Register, VECTOR_ELEMENTS));
+    backend.addInstruction(Vector::vctp(Size32, Temp_Register));
+    emitMicroKernel(2, true, columns);
+    backend.bindLabel(rowsDone);
+}
+
+JIT::Generators::GemmGeneric::Func JIT::Generators::GemmGeneric::generate() {
+    using namespace Instructions;
+    backend.resetKernel();
+    IR::Arena arena(programStorage, sizeof(programStorage));
+    IR::Program program(arena, MAX_NODES, MAX_LABELS);
+    backend.beginProgram(program);
+    IR::Program::Label const columnLoop = backend.newLabel();
+    IR::Program::Label const columnTail = backend.newLabel();
+    IR::Program::Label const oneColumn = backend.newLabel();
+    IR::Program::Label const done = backend.newLabel();
+    IR::Program::Label const exit = backend.newLabel();
+
+    backend.annotate("save registers");
+    backend.addInstruction(DataProcessing::push32(R4, R5, R6, R7, R8, R9, R10, R11, R12, LR));
+    backend.addInstruction(DataProcessing::vpush(Q4, 4));
+
+    backend.annotate("load shape");
+    backend.addInstruction(DataProcessing::ldrImmediate32(Frame_M, Shape_Pointer, offsetof(Shape, m)));
+    backend.addInstruction(DataProcessing::ldrImmediate32(Frame_K_Loop, Shape_Pointer, offsetof(Shape, k)));
+    backend.addInstruction(DataProcessing::ldrImmediate32(J_Register, Shape_Pointer, offsetof(Shape, n)));
+    backend.addInstruction(DataProcessing::ldrImmediate32(LDA_Register, Shape_Pointer, offsetof(Shape, lda)));
+    backend.addInstruction(DataProcessing::ldrImmediate32(LDB_Register, Shape_Pointer, offsetof(Shape, ldb)));
+    backend.addInstruction(DataProcessing::ldrImmediate32(LDC_Register, Shape_Pointer, offsetof(Shape, ldc)));
+    backend.addCompareBranch(Frame_M, exit);
+    backend.addCompareBranch(Frame_K_Loop, exit);
+    backend.addCompareBranch(J_Register, exit);
+    backend.addInstruction(DataProcessing::movRegister32(LDA_Register, LDA_Register, LSL, 2));
+    backend.addInstruction(DataProcessing::movRegister32(LDB_Register, LDB_Register, LSL, 2));
+    backend.addInstruction(DataProcessing::movRegister32(LDC_Register, LDC_Register, LSL, 2));
+    backend.addInstruction(Arithmetic::mul32(Frame_A_Rewind, Frame_K_Loop, LDA_Register));
+    backend.addInstruction(DataProcessing::movRegister32(Frame_B_Rewind, Frame_K_Loop, LSL, 2));
+    backend.addInstruction(Arithmetic::subImmediate32(Frame_K_Loop, 1));
+    backend.addInstruction(DataProcessing::push32(Frame_M, Frame_A_Rewind, Frame_B_Rewind, Frame_K_Loop));
+
+    // blocks of NR columns, A back to the first row, B and C to the next block of columns
+    backend.annotate("column blocks");
+    backend.bindLabel(columnLoop);
+    backend.addInstruction(Base::cmpImmediate32(J_Register, NR));
+    backend.addBranch(columnTail, LT);
+    emitRows(NR);
+    backend.addInstruction(DataProcessing::ldrImmediate32(Temp_Register, SP, FRAME_M));
+    backend.addInstruction(Arithmetic::subRegister32(A_Pointer, Temp_Register, LSL, 2));
+    backend.addInstruction(Arithmetic::addRegister32(B_Pointer, LDB_Register));
+    backend.addInstruction(Arithmetic::addRegister32(B_Pointer, LDB_Register, LSL, 1));
+    backend.addInstruction(Arithmetic::addRegister32(C_Pointer, LDC_Register));
+    backend.addInstruction(Arithmetic::addRegister32(C_Pointer, LDC_Register, LSL, 1));
+    backend.addInstruction(Arithmetic::subRegister32(C_Pointer, Temp_Register, LSL, 2));
+    backend.addInstruction(Arithmetic::subImmediate32(J_Register, NR));
+    backend.addBranch(columnLoop);
+
+    // the last one or two columns
+    backend.annotate("column tail");
+    backend.bindLabel(columnTail);
+    backend.addCompareBranch(J_Register, done);
+    backend.addInstruction(Base::cmpImmediate32(J_Register, 1));
+    backend.addBranch(oneColumn, EQ);
+    emitRows(2);
+    backend.addBranch(done);
+    backend.bindLabel(oneColumn);
+    emitRows(1);
+
+    backend.bindLabel(done);
+    backend.addInstruction(DataProcessing::pop32(Frame_M, Frame_A_Rewind, Frame_B_Rewind, Frame_K_Loop));
+    backend.bindLabel(exit);
+    backend.annotate("restore registers");
+    backend.addInstruction(DataProcessing::vpop(Q4, 4));
+    backend.addInstruction(DataProcessing::pop32(R4, R5, R6, R7, R8, R9, R10, R11, R12, PC));
+    backend.endProgram();
+
+    backend.clearCaches();
+    return reinterpret_cast<Func>(backend.getThumbAddress());
+}
@@ -0,0 +1,63 @@
+#ifndef JIT_GENERATORS_GEMM_GENERIC_HPP
+#define JIT_GENERATORS_GEMM_GENERIC_HPP
+
+#include "backend/Backend.hpp"
+#include "instructions/Base.hpp"
+#include <cstdint>
+
+namespace JIT {
+    namespace Generators {
+        class GemmGeneric;
+    }
+}
+
+/**
+ * @brief Generator for a single C += A * B kernel (column-major, COLUMN_MAJOR_NN) which takes the shape at runtime.
+ * The dimensions and leading dimensions are passed in a Shape, so the kernel is generated once and runs any shape
+ * without generation latency, e.g. for one-off shapes until the cache or the tuner decides to specialize them.
+ *
+ * The 8x3 microkernels are the ones of Gemm without unrolling: the k loop loads the A and B values of the next k between
+ * the FMAs and the last k is peeled, the row tails are limited with VCTP on the remaining rows and the column tails are
+ * selected by the J loop. Compared to a specialized kernel A advances with an ADD per k, each microkernel costs a few
+ * loads from the stack frame and the pointer rewinds use registers. The CycleEstimator puts the kernel at 151211 cycles
+ * for 64 x 64 x 64 (Gemm::generate: 137451, +10%) and 8789 cycles for 24 x 24 x 24 (7646, +15%).
+ */
+class JIT::Generators::GemmGeneric {
+    public:
+        /// @brief Shape of the call, A is m x k (lda >= m), B is k x n (ldb >= k) and C is m x n (ldc >= m)
+        struct Shape {
+            uint32_t m;
+            uint32_t k;
+            uint32_t n;
+            uint32_t lda;
+            uint32_t ldb;
+            uint32_t ldc;
+        };
+        using Func = void (*) (float const *, float const *, float *, Shape const *);
+
+        static constexpr uint32_t MR = 8; // rows of the microkernel (two vectors)
+        static constexpr uint32_t NR = 3; // columns of the microkernel
+
+        GemmGeneric(Instructions::Instruction16 * globalBuffer, uint32_t bufferSize) : backend(globalBuffer, bufferSize) {
+            backend.enableScheduling();
+        }
+
+        /// @brief Generates the kernel, a shape with m, k or n == 0 returns without touching C
+        Func generate();
+        /// @brief Size of the last generated kernel in halfwords
+        uint16_t getInstructionCount() {
+            return backend.getInstructionCount();
+        }
+
+    private:
+        static constexpr uint16_t MAX_NODES = 512;
+        static constexpr uint16_t MAX_LABELS = 48;
+
+        Backend backend;
+        alignas(4) uint8_t programStorage[IR::Program::storageSize(MAX_NODES, MAX_LABELS)];
+
+        void emitMicroKernel(uint32_t vectors, bool predicated, uint32_t columns);
+        void emitRows(uint32_t columns);
+};
+
+#endif // JIT_GENERATORS_GEMM_GENERIC_HPP
@@ -0,0 +1,43 @@
+#include "GemmImage.hpp"
+#include "instructions/Base.hpp"
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+uint32_t JIT::Generators::GemmImage::write(Gemm & generator, GemmCache::Key const & key, Core core, uint8_t * image, uint32_t capacity) {
+    if (reinterpret_cast<uintptr_t>(image) % CODE_ALIGNMENT != 0) {
+        Instructions::Base::printValidationError("GemmImage::write: image has to be 4 byte aligned - returning 0");
+        return 0;
+    }
+    bool const insertPreloadHints = key.flags & GemmCache::FLAG_PRELOAD_HINTS;
+    Gemm::Layout const layout = static_cast<Gemm::Layout>(key.flags >> GemmCache::FLAG_LAYOUT_SHIFT);
+    if (generator.generate(key.m, key.k, key.n, key.lda, key.ldb, key.ldc, insertPreloadHints, std::bit_cast<float>(key.alpha), std::bit_cast<float>(key.beta), layout, GemmCache::epilogueOf(key)) == nullptr) {
+        return 0;
+    }
+    uint32_t const codeSize = generator.getInstructionCount() * sizeof(Instructions::Instruction16);
+    if (codeSize == 0) {
+        Instructions::Base::printValidationError("GemmImage::write: empty kernel - returning 0");
+        return 0;
+    }
+    uint32_t const size = imageSize(codeSize);
+    if (size > capacity) {
+        Instructions::Base::printValidationError("GemmImage::write: image larger than capacity - returning 0");
+        return 0;
+    }
+
+    uint8_t * code = image + sizeof(Header);
+    Gemm::Func const func = generator.bufferToFunc(reinterpret_cast<Instructions::Instruction16 *>(code));
+    std::memset(code + codeSize, 0, size - sizeof(Header) - codeSize);
+
+    Header header = {};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.core = core;
+    header.alignment = CODE_ALIGNMENT;
+    header.key = key;
+    header.entryOffset = static_cast<uint32_t>((reinterpret_cast<uintptr_t>(func) & ~1U) - reinterpret_cast<uintptr_t>(code));
+    header.codeSize = codeSize;
+    header.checksum = checksum(header, code);
+    std::memcpy(image, &header, sizeof(header));
+    return size;
+}
@@ -0,0 +1,89 @@
+#ifndef JIT_GENERATORS_GEMM_IMAGE_HPP
+#define JIT_GENERATORS_GEMM_IMAGE_HPP
+
+#include "generators/Gemm.hpp"
+#include "generators/GemmCache.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace JIT {
+    namespace Generators {
+        class GemmImage;
+    }
+}
+
+/**
+ * @brief Serialized kernel images for shapes which are known at build time.
+ * An image is a Header followed by the code of one kernel. The kernels only use PC-relative branches and literals,
+ * so the code can be copied to any address with the required alignment (see Gemm::bufferToFunc).
+ * Images are concatenated into one blob, every image is padded to a multiple of 4 bytes.
+ *
+ * The images are written on the host (tools/gemm_images.cpp) or the target with write, and loaded at boot by
+ * GemmImageLoader, which does not need the generator.
+ */
+class JIT::Generators::GemmImage {
+    public:
+        static constexpr uint32_t MAGIC = 0x4b4d4a47; // "GJMK"
+        static constexpr uint16_t VERSION = 3; // 2: the key holds the epilogue, 3: the checksum covers the header
+        static constexpr uint8_t CODE_ALIGNMENT = 4; // Program::layout() places the ALIGNED nodes and the literal pools (scalar LDR literal) at word offsets of the code
+
+        enum Core : uint8_t {
+            CORE_ANY = 0,
+            CORE_HP = 1,
+            CORE_HE = 2,
+        };
+
+        struct Header {
+            uint32_t magic;
+            uint16_t version;
+            Core core; // images of the other core are skipped by the loader, CORE_ANY loads on both
+            uint8_t alignment; // required alignment of the code in bytes
+            GemmCache::Key key;
+            uint32_t entryOffset; // in bytes from the start of the code
+            uint32_t codeSize; // in bytes
+            uint32_t checksum; // of the header (without the checksum) and the code, see checksum()
+        };
+        static_assert(sizeof(Header) % CODE_ALIGNMENT == 0, "the code has to follow the header aligned");
+
+        /// @brief Core of this build (M55_HP or M55_HE), CORE_ANY on the host
+        static constexpr Core currentCore() {
+            #if defined(M55_HP)
+            return CORE_HP;
+            #elif defined(M55_HE)
+            return CORE_HE;
+            #else
+            return CORE_ANY;
+            #endif
+        }
+
+        /// @brief Size of the image of a kernel with codeSize bytes, including the padding
+        static constexpr uint32_t imageSize(uint32_t codeSize) {
+            return (sizeof(Header) + codeSize + 3) & ~3U;
+        }
+
+        /// @brief FNV-1a over all fields of the header except the checksum (the last field), followed by the codeSize bytes of code
+        static uint32_t checksum(Header const & header, uint8_t const * code) {
+            static_assert(offsetof(Header, checksum) + sizeof(Header::checksum) == sizeof(Header), "the checksum has to be the last field");
+            uint8_t bytes[sizeof(Header)];
+            std::memcpy(bytes, &header, sizeof(Header));
+            return hash(code, header.codeSize, hash(bytes, offsetof(Header, checksum), 2166136261U));
+        }
+
+        /**
+         * @brief Generates the kernel of key and writes its image to image (4 byte aligned).
+         * Returns the size of the image in bytes, 0 if the kernel could not be generated or does not fit into capacity.
+         */
+        static uint32_t write(Gemm & generator, GemmCache::Key const & key, Core core, uint8_t * image, uint32_t capacity);
+
+    private:
+        static uint32_t hash(uint8_t const * bytes, uint32_t size, uint32_t h) {
+            for (uint32_t i = 0; i < size; i++) {
+                h ^= bytes[i];
+                h *= 16777619U;
+            }
+            return h;
+        }
+};
+
+#endif // JIT_GENERATORS_GEMM_IMAGE_HPP
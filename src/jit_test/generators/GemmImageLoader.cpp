@@ -0,0 +1,60 @@
+#include "GemmImageLoader.hpp"
+#include "backend/Backend.hpp"
+#include "instructions/Base.hpp"
+#include <cstdint>
+#include <cstring>
+
+uint32_t JIT::Generators::GemmImageLoader::load(uint8_t const * images, uint32_t size) {
+    uint32_t loaded = 0;
+    uint32_t position = 0;
+    while (position + sizeof(GemmImage::Header) <= size) {
+        GemmImage::Header header;
+        std::memcpy(&header, images + position, sizeof(header));
+        if (header.magic != GemmImage::MAGIC || header.version != GemmImage::VERSION) {
+            Instructions::Base::printValidationError("GemmImageLoader::load: invalid image header - stopping");
+            break;
+        }
+        // checked before imageSize, which wraps for huge sizes
+        uint32_t const imageSize = header.codeSize <= size - position - sizeof(header) ? GemmImage::imageSize(header.codeSize) : 0;
+        if (imageSize == 0 || imageSize > size - position) {
+            Instructions::Base::printValidationError("GemmImageLoader::load: image is cut off - stopping");
+            break;
+        }
+        uint8_t const * code = images + position + sizeof(header);
+        position += imageSize;
+
+        if (header.core != GemmImage::CORE_ANY && header.core != GemmImage::currentCore()) continue;
+        if (GemmImage::checksum(header, code) != header.checksum) {
+            Instructions::Base::printValidationError("GemmImageLoader::load: checksum mismatch - skipping image");
+            continue;
+        }
+        if (header.entryOffset >= header.codeSize) {
+            Instructions::Base::printValidationError("GemmImageLoader::load: entry behind the code - skipping image");
+            continue;
+        }
+        // the region is 4 byte aligned, keep the alignment of the image within it
+        uint32_t const alignment = header.alignment / sizeof(Instructions::Instruction16);
+        uint32_t const offset = alignment > 1 ? (usedSize + alignment - 1) / alignment * alignment : usedSize;
+        uint32_t const halfwords = (header.codeSize + 1) / sizeof(Instructions::Instruction16);
+        if (kernelCount == MAX_KERNELS || offset + halfwords > regionSize) {
+            Instructions::Base::printValidationError("GemmImageLoader::load: code region or table full - stopping");
+            break;
+        }
+
+        std::memcpy(codeRegion + offset, code, header.codeSize);
+        Backend::clearCaches(codeRegion + offset, halfwords);
+        uintptr_t const entry = reinterpret_cast<uintptr_t>(codeRegion + offset) + header.entryOffset;
+        entries[kernelCount++] = {header.key, reinterpret_cast<Gemm::Func>(entry | 1U)};
+        usedSize = offset + halfwords;
+        loaded++;
+    }
+    return loaded;
+}
+
+JIT::Generators::Gemm::Func JIT::Generators::GemmImageLoader::get(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, bool insertPreloadHints, float alpha, float beta, Gemm::Layout layout, Gemm::Epilogue const & epilogue) const {
+    GemmCache::Key const key = GemmCache::makeKey(m, k, n, lda, ldb, ldc, insertPreloadHints, alpha, beta, layout, epilogue);
+    for (uint32_t i = 0; i < kernelCount; i++) {
+        if (entries[i].key == key) return entries[i].func;
+    }
+    return nullptr;
+}
@@ -0,0 +1,69 @@
+#ifndef JIT_GENERATORS_GEMM_IMAGE_LOADER_HPP
+#define JIT_GENERATORS_GEMM_IMAGE_LOADER_HPP
+
+#include "generators/Gemm.hpp"
+#include "generators/GemmCache.hpp"
+#include "generators/GemmImage.hpp"
+#include "instructions/Base.hpp"
+#include <cstdint>
+
+namespace JIT {
+    namespace Generators {
+        class GemmImageLoader;
+    }
+}
+
+/**
+ * @brief Copies prebuilt kernel images (GemmImage) into a code region (normally ITCM) and returns the kernels by shape.
+ * Only the images are needed at runtime, so builds with a fixed set of shapes can drop the generator (Gemm.cpp) and
+ * skip the generation at boot.
+ *
+ * The kernels stay loaded until clear. No dynamic memory is used: at most MAX_KERNELS kernels are kept.
+ */
+class JIT::Generators::GemmImageLoader {
+    public:
+        static constexpr uint32_t MAX_KERNELS = 16;
+
+        /**
+         * @param codeRegion Region the kernels are copied to (has to be 4 byte aligned)
+         * @param regionSize Size of the region in halfwords
+         */
+        GemmImageLoader(Instructions::Instruction16 * codeRegion, uint32_t regionSize) : codeRegion(codeRegion), regionSize(regionSize) {}
+
+        /**
+         * @brief Loads all images of the blob (concatenated images, 4 byte aligned).
+         * Images for the other core, with a wrong checksum (of the header and the code) or an entry outside of the code are skipped,
+         * loading stops at the first invalid header or cut off image, if the region or the table is full. Returns the number of loaded kernels.
+         */
+        uint32_t load(uint8_t const * images, uint32_t size);
+
+        /// @brief Returns the loaded kernel for the shape, nullptr if there is no image for it
+        Gemm::Func get(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, bool insertPreloadHints = false, float alpha = 1.0f, float beta = 1.0f, Gemm::Layout layout = Gemm::COLUMN_MAJOR_NN, Gemm::Epilogue const & epilogue = {}) const;
+
+        uint32_t getKernelCount() const {
+            return kernelCount;
+        }
+        /// @brief Count of halfwords which are occupied by the loaded kernels
+        uint32_t getUsedSize() const {
+            return usedSize;
+        }
+        /// @brief Forgets all kernels, the returned function pointers are invalid afterwards
+        void clear() {
+            kernelCount = 0;
+            usedSize = 0;
+        }
+
+    private:
+        struct Entry {
+            GemmCache::Key key;
+            Gemm::Func func;
+        };
+
+        Instructions::Instruction16 * codeRegion;
+        uint32_t regionSize;
+        Entry entries[MAX_KERNELS] = {};
+        uint32_t kernelCount = 0;
+        uint32_t usedSize = 0;
+};
+
+#endif // JIT_GENERATORS_GEMM_IMAGE_LOADER_HPP
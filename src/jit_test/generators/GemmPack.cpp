@@ -0,0 +1,154 @@
+#include "GemmPack.hpp"
+#include "generators/Gemm.hpp"
+#include "backend/Backend.hpp"
+#include "instructions/Arithmetic.hpp"
+#include "instructions/Base.hpp"
+#include "instructions/DataProcessing.hpp"
+#include "instructions/Vector.hpp"
+#include <cstdint>
+
+/*
+Register map of the packing routines:
+- R0: first element of the current sliver in the source matrix
+- R1: packed matrix, only advanced with post-increments
+- R2: source pointer inside the sliver
+- R3: lda in bytes (A) or ldb in elements for the gather offsets (B)
+- R4: sliver loop counter
+- R5: temp / DLS count
+*/
+constexpr JIT::Instructions::Register Source_Pointer = JIT::Instructions::R0;
+constexpr JIT::Instructions::Register Packed_Pointer = JIT::Instructions::R1;
+constexpr JIT::Instructions::Register Sliver_Pointer = JIT::Instructions::R2;
+constexpr JIT::Instructions::Register Stride_Register = JIT::Instructions::R3;
+constexpr JIT::Instructions::Register Sliver_Loop_Register = JIT::Instructions::R4;
+constexpr JIT::Instructions::Register Temp_Register = JIT::Instructions::R5;
+/* Q3 holds the offsets [0, ldb, 2 * ldb, 3 * ldb] of the B gather */
+constexpr JIT::Instructions::VectorRegister B_Offsets_Register = JIT::Instructions::Q3;
+
+constexpr uint32_t VECTOR_SIZE = 16; // == 128 Bit
+constexpr uint32_t DT_SIZE = 4; // == 32 Bit (FP32)
+constexpr uint32_t VECTOR_ELEMENTS = VECTOR_SIZE / DT_SIZE;
+
+uint32_t JIT::Generators::GemmPack::packedSizeA(uint32_t m, uint32_t k) {
+    uint32_t const rest = m % Gemm::PACKED_MR;
+    return (m - rest + (rest + VECTOR_ELEMENTS - 1) / VECTOR_ELEMENTS * VECTOR_ELEMENTS) * k;
+}
+
+/*
+Copies one sliver of A: rows [R0, R0 + rows) of all k columns. Rows behind the sliver are stored as zero,
+so the GEMM kernel does not need predicated loads.
+*/
+JIT::Instructions::Instruction16 * JIT::Generators::GemmPack::emitCopySliverA(uint32_t rows, uint32_t k) {
+    uint32_t const vectors = (rows + VECTOR_ELEMENTS - 1) / VECTOR_ELEMENTS;
+    bool const predicated = rows % VECTOR_ELEMENTS != 0;
+
+    Instructions::Instruction16 * sliverStart = backend.addBranchTargetInstruction(Instructions::DataProcessing::movRegister32(Sliver_Pointer, Source_Pointer));
+    if (predicated) {
+        // MVE predicated loads zero the disabled lanes, so the rows behind the sliver are stored as zero
+        backend.addInstruction(Instructions::DataProcessing::movImmediate32(Temp_Register, rows % VECTOR_ELEMENTS));
+        backend.addInstruction(Instructions::Vector::vctp(Instructions::Size32, Temp_Register));
+    }
+    if (k > 1) {
+        backend.addMoveImmediate(Temp_Register, k);
+        backend.addInstruction(Instructions::Base::dls(Temp_Register));
+    }
+
+    Instructions::Instruction16 * kLoopStart = nullptr;
+    for (uint32_t v = 0; v < vectors; v++) {
+        Instructions::VectorRegister const reg = static_cast<Instructions::VectorRegister>(v);
+        Instructions::Instruction32 const load = Instructions::Vector::vldrw(reg, Sliver_Pointer, v * VECTOR_SIZE);
+        // the last column of A might end inside the last vector
+        bool const predicatedLoad = predicated && v == vectors - 1;
+        Instructions::Instruction32 const first = predicatedLoad ? Instructions::Vector::vpst(1) : load;
+        if (v == 0) kLoopStart = backend.addBranchTargetInstruction(first);
+        else backend.addInstruction(first);
+        if (predicatedLoad) backend.addInstruction(load);
+    }
+    backend.addInstruction(Instructions::Arithmetic::addRegister32(Sliver_Pointer, Stride_Register));
+    for (uint32_t v = 0; v < vectors; v++) {
+        backend.addInstruction(Instructions::Vector::vstrw(static_cast<Instructions::VectorRegister>(v), Packed_Pointer, VECTOR_SIZE, false, true));
+    }
+    if (k > 1) backend.addLowOverheadBranchFromCurrentPosition(kLoopStart);
+    return sliverStart;
+}
+
+/*
+Copies one sliver of B: columns [R0, R0 + columns * ldb) of all k rows, k-major.
+*/
+JIT::Instructions::Instruction16 * JIT::Generators::GemmPack::emitCopySliverB(uint32_t columns, uint32_t k) {
+    Instructions::Instruction16 * sliverStart = backend.addBranchTargetInstruction(Instructions::DataProcessing::movRegister32(Sliver_Pointer, Source_Pointer));
+    // only the columns of the sliver are gathered and stored
+    backend.addInstruction(Instructions::DataProcessing::movImmediate32(Temp_Register, columns));
+    backend.addInstruction(Instructions::Vector::vctp(Instructions::Size32, Temp_Register));
+    if (k > 1) {
+        backend.addMoveImmediate(Temp_Register, k);
+        backend.addInstruction(Instructions::Base::dls(Temp_Register));
+    }
+    Instructions::Instruction16 * kLoopStart = backend.addBranchTargetInstruction(Instructions::Vector::vpst(2));
+    backend.addInstruction(Instructions::Vector::vldrwGather(Instructions::Q0, Sliver_Pointer, B_Offsets_Register));
+    backend.addInstruction(Instructions::Vector::vstrw(Instructions::Q0, Packed_Pointer, columns * DT_SIZE, false, true));
+    backend.addInstruction(Instructions::Arithmetic::addImmediate32(Sliver_Pointer, DT_SIZE));
+    if (k > 1) backend.addLowOverheadBranchFromCurrentPosition(kLoopStart);
+    return sliverStart;
+}
+
+JIT::Generators::GemmPack::Func JIT::Generators::GemmPack::generatePackA(uint32_t m, uint32_t k, uint32_t lda) {
+    if (m == 0 || k == 0) {
+        Instructions::Base::printValidationError("generatePackA: empty matrix - returning nullptr");
+        return nullptr;
+    }
+    backend.resetKernel();
+    backend.addInstruction(Instructions::DataProcessing::push32(Instructions::R4, Instructions::R5, Instructions::LR));
+    backend.addMoveImmediate(Stride_Register, lda * DT_SIZE);
+
+    uint32_t const mr = Gemm::PACKED_MR;
+    uint32_t const mFull = m - (m % mr);
+    if (mFull > 0) {
+        backend.addInstruction(Instructions::DataProcessing::movImmediate32(Sliver_Loop_Register, 0));
+        Instructions::Instruction16 * sliverLoopStart = emitCopySliverA(mr, k);
+        backend.addInstruction(Instructions::Arithmetic::addImmediate32(Source_Pointer, mr * DT_SIZE));
+        if (mFull > mr) {
+            backend.addInstruction(Instructions::Arithmetic::addImmediate32(Sliver_Loop_Register, mr));
+            backend.addCompareImmediate(Sliver_Loop_Register, mFull, Temp_Register);
+            backend.addBackwardsBranchFromCurrentPosition(sliverLoopStart, Instructions::LT);
+        }
+    }
+    if (m % mr != 0) emitCopySliverA(m % mr, k);
+    return finalizeRoutine();
+}
+
+JIT::Generators::GemmPack::Func JIT::Generators::GemmPack::generatePackB(uint32_t k, uint32_t n, uint32_t ldb) {
+    if (n == 0 || k == 0) {
+        Instructions::Base::printValidationError("generatePackB: empty matrix - returning nullptr");
+        return nullptr;
+    }
+    backend.resetKernel();
+    backend.addInstruction(Instructions::DataProcessing::push32(Instructions::R4, Instructions::R5, Instructions::LR));
+    // gather offsets in elements, the gather load scales them by DT_SIZE
+    backend.addMoveImmediate(Stride_Register, ldb);
+    // VIDUP needs an even register
+    backend.addInstruction(Instructions::DataProcessing::movImmediate32(Sliver_Loop_Register, 0));
+    backend.addInstruction(Instructions::Vector::vidup(B_Offsets_Register, Sliver_Loop_Register, 1));
+    backend.addInstruction(Instructions::Vector::vmulIntegerVectorByScalar(B_Offsets_Register, B_Offsets_Register, Stride_Register));
+
+    uint32_t const nr = Gemm::PACKED_NR;
+    uint32_t const nFull = n - (n % nr);
+    if (nFull > 0) {
+        backend.addInstruction(Instructions::DataProcessing::movImmediate32(Sliver_Loop_Register, 0));
+        Instructions::Instruction16 * sliverLoopStart = emitCopySliverB(nr, k);
+        backend.addAddImmediate(Source_Pointer, Source_Pointer, nr * ldb * DT_SIZE, Temp_Register);
+        if (nFull > nr) {
+            backend.addInstruction(Instructions::Arithmetic::addImmediate32(Sliver_Loop_Register, nr));
+            backend.addCompareImmediate(Sliver_Loop_Register, nFull, Temp_Register);
+            backend.addBackwardsBranchFromCurrentPosition(sliverLoopStart, Instructions::LT);
+        }
+    }
+    if (n % nr != 0) emitCopySliverB(n % nr, k);
+    return finalizeRoutine();
+}
+
+JIT::Generators::GemmPack::Func JIT::Generators::GemmPack::finalizeRoutine() {
+    backend.addInstruction(Instructions::DataProcessing::pop32(Instructions::R4, Instructions::R5, Instructions::PC));
+    backend.clearCaches();
+    return reinterpret_cast<Func>(backend.getThumbAddress());
+}
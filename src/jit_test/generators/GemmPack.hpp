@@ -0,0 +1,60 @@
+#ifndef JIT_GENERATORS_GEMM_PACK_HPP
+#define JIT_GENERATORS_GEMM_PACK_HPP
+
+#include "backend/Backend.hpp"
+#include "instructions/Base.hpp"
+#include <cstdint>
+
+namespace JIT {
+    namespace Generators {
+        class GemmPack;
+    }
+}
+
+/**
+ * @brief Generator for the routines which copy column-major A and B into the packed panel format of Gemm::PACKED.
+ * A is copied with vector loads (one column of a sliver per k), rows behind m are zeroed.
+ * B is copied with gather loads: the elements of one k of a sliver are ldb apart and stored contiguously with a predicated store.
+ *
+ * The packing routines only depend on the shape and the leading dimension, so they can be reused for all panels
+ * of a blocked GEMM.
+ */
+class JIT::Generators::GemmPack {
+    private:
+        Backend backend;
+
+        Instructions::Instruction16 * emitCopySliverA(uint32_t rows, uint32_t k);
+        Instructions::Instruction16 * emitCopySliverB(uint32_t columns, uint32_t k);
+        /// @brief restores the registers and returns the routine
+        void (*finalizeRoutine())(float const *, float *);
+
+    public:
+        using Func = void (*) (float const *, float *);
+
+        GemmPack(Instructions::Instruction16 * globalBuffer, uint32_t bufferSize) : backend(globalBuffer, bufferSize) {
+            backend.enableScheduling();
+        }
+        /**
+         * @brief Generates the routine which packs the m x k matrix A (column-major, lda >= m) into slivers of Gemm::PACKED_MR rows.
+         * Returns nullptr if m == 0 or k == 0.
+         */
+        Func generatePackA(uint32_t m, uint32_t k, uint32_t lda);
+        /**
+         * @brief Generates the routine which packs the k x n matrix B (column-major, ldb >= k) into k-major slivers of Gemm::PACKED_NR columns.
+         * Returns nullptr if n == 0 or k == 0.
+         */
+        Func generatePackB(uint32_t k, uint32_t n, uint32_t ldb);
+        /// @brief Size of the last generated routine in halfwords
+        uint16_t getInstructionCount() {
+            return backend.getInstructionCount();
+        }
+
+        /// @brief Size of the packed A in floats (the last sliver is padded to a multiple of the vector size)
+        static uint32_t packedSizeA(uint32_t m, uint32_t k);
+        /// @brief Size of the packed B in floats
+        static uint32_t packedSizeB(uint32_t k, uint32_t n) {
+            return k * n;
+        }
+};
+
+#endif // JIT_GENERATORS_GEMM_PACK_HPP
@@ -0,0 +1,247 @@
+#include "GemmS8.hpp"
+#include "backend/Backend.hpp"
+#include "instructions/Arithmetic.hpp"
+#include "instructions/Base.hpp"
+#include "instructions/DataProcessing.hpp"
+#include "instructions/Vector.hpp"
+#include <cstdint>
+
+constexpr JIT::Instructions::Register A_Row_Pointer = JIT::Instructions::R0; // current row of A
+constexpr JIT::Instructions::Register B_Base_Pointer = JIT::Instructions::R1; // first row of B of the current column block
+constexpr JIT::Instructions::Register C_Pointer = JIT::Instructions::R2; // has to be a low register (narrowing store)
+constexpr JIT::Instructions::Register A_Stream_Register = JIT::Instructions::R3; // also used as temp register outside of the k loop
+constexpr JIT::Instructions::Register TEMP_REGISTER = JIT::Instructions::R3;
+constexpr JIT::Instructions::Register B_Stream_Registers[] = {JIT::Instructions::R5, JIT::Instructions::R7, JIT::Instructions::R9, JIT::Instructions::R11};
+// VMLADAVA can only accumulate into even registers
+constexpr JIT::Instructions::Register Accumulator_Registers[] = {JIT::Instructions::R4, JIT::Instructions::R6, JIT::Instructions::R8, JIT::Instructions::R10};
+constexpr JIT::Instructions::Register I_Loop_Register = JIT::Instructions::R12;
+constexpr JIT::Instructions::Register J_Register = JIT::Instructions::R5; // J is loaded into R5 (free outside of the k loop)
+// all GP registers are in use, the column block counter is kept in a FP register
+constexpr JIT::Instructions::FloatRegister J_Loop_Register = JIT::Instructions::S28;
+
+constexpr JIT::Instructions::VectorRegister A_Vector_Register = JIT::Instructions::Q0;
+// the rows of B are loaded alternating, so the next load does not have to wait for VMLADAVA
+constexpr JIT::Instructions::VectorRegister B_Vector_Registers[] = {JIT::Instructions::Q1, JIT::Instructions::Q2};
+constexpr JIT::Instructions::VectorRegister Result_Register = JIT::Instructions::Q2;
+constexpr JIT::Instructions::VectorRegister Bias_Register = JIT::Instructions::Q3;
+constexpr JIT::Instructions::VectorRegister Multiplier_Register = JIT::Instructions::Q4;
+/* per-channel: shifts of the current column block, per-tensor: activation range of the whole kernel */
+constexpr JIT::Instructions::VectorRegister Left_Shift_Register = JIT::Instructions::Q5;
+constexpr JIT::Instructions::VectorRegister Right_Shift_Register = JIT::Instructions::Q6;
+constexpr JIT::Instructions::VectorRegister Activation_Min_Register = JIT::Instructions::Q5;
+constexpr JIT::Instructions::VectorRegister Activation_Max_Register = JIT::Instructions::Q6;
+/* per-channel: the activation range is loaded after the k loop into the registers of A and B */
+constexpr JIT::Instructions::VectorRegister Row_Activation_Min_Register = JIT::Instructions::Q0;
+constexpr JIT::Instructions::VectorRegister Row_Activation_Max_Register = JIT::Instructions::Q1;
+/* Q7 holds J_Loop_Register, the rounding fixup uses the register of A (the activation range is loaded after it) */
+constexpr JIT::Instructions::VectorRegister Fixup_Register = JIT::Instructions::Q0;
+
+constexpr uint32_t MICROKERNEL_N = 4;
+constexpr uint32_t VECTOR_SIZE = 16; // == 128 Bit == 16 int8
+constexpr uint32_t PARAMETER_SIZE = 4; // int32 per channel
+
+void JIT::Generators::GemmS8::computeKernelSums(int8_t const * b, uint32_t k, uint32_t n, uint32_t ldb, int32_t const * bias, int32_t inputOffset, int32_t * kernelSums) {
+    for (uint32_t j = 0; j < n; j++) {
+        int32_t sum = 0;
+        for (uint32_t p = 0; p < k; p++) {
+            sum += b[j * ldb + p];
+        }
+        kernelSums[j] = (bias != nullptr ? bias[j] : 0) + inputOffset * sum;
+    }
+}
+
+/*
+Loads the bias and the per-channel parameters of the columns [column, column + n) (J_Loop_Register is added if variableColumn).
+For n < 4 the loads are predicated, so nothing behind the arrays is read.
+The shifts are split into a left shift (>= 0) and a rounding right shift (<= 0).
+*/
+void JIT::Generators::GemmS8::emitLoadChannelParameters(uint32_t n, bool variableColumn, uint32_t column, Requantization const & requantization, MicroKernelConfiguration const & configuration) {
+    struct Parameter {
+        int32_t const * values;
+        Instructions::VectorRegister reg;
+    };
+    Parameter parameters[3];
+    uint32_t parameterCount = 0;
+    if (configuration.hasBias) parameters[parameterCount++] = {requantization.bias, Bias_Register};
+    if (configuration.perChannel) {
+        parameters[parameterCount++] = {requantization.multipliers, Multiplier_Register};
+        parameters[parameterCount++] = {requantization.shifts, Left_Shift_Register};
+    }
+    if (parameterCount == 0) return;
+
+    if (variableColumn) backend.addInstruction(Instructions::Vector::vmovGPxScalar(true, J_Loop_Register, J_Register));
+    if (n < MICROKERNEL_N) {
+        backend.addInstruction(Instructions::DataProcessing::movImmediate32(TEMP_REGISTER, n));
+        backend.addInstruction(Instructions::Vector::vctp(Instructions::Size32, TEMP_REGISTER));
+    }
+    for (uint32_t p = 0; p < parameterCount; p++) {
+        uint32_t address = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(parameters[p].values + column));
+        backend.addMoveImmediate(TEMP_REGISTER, address);
+        if (variableColumn) backend.addInstruction(Instructions::Arithmetic::addRegister32(TEMP_REGISTER, TEMP_REGISTER, J_Register, Instructions::LSL, 2));
+        if (n < MICROKERNEL_N) backend.addInstruction(Instructions::Vector::vpst(1));
+        backend.addInstruction(Instructions::Vector::vldrw(parameters[p].reg, TEMP_REGISTER));
+    }
+    if (configuration.perChannel) {
+        // right = min(shift, 0), left = shift - right
+        backend.addInstruction(Instructions::Vector::vmovImmediate(Right_Shift_Register, 0, Instructions::I32));
+        backend.addInstruction(Instructions::Vector::vmin(Right_Shift_Register, Left_Shift_Register, Right_Shift_Register));
+        backend.addInstruction(Instructions::Vector::vsub(Left_Shift_Register, Left_Shift_Register, Right_Shift_Register));
+    }
+}
+
+/*
+Moves the accumulators of the n columns into Result_Register and requantizes them (same rounding as arm_requantize_mve_32x4):
+result = clamp(rshr(fixup(vqrdmulh(acc + bias << left, multiplier)), right) + outputOffset)
+The rounding right shift rounds ties up, the fixup subtracts 1 from negative values which are shifted right first, so ties
+are rounded away from zero (RoundingDivideByPOT of gemmlowp).
+*/
+void JIT::Generators::GemmS8::emitRequantize(uint32_t n, Requantization const & requantization, MicroKernelConfiguration const & configuration) {
+    backend.addInstruction(Instructions::Vector::vmovGPToLanes(Result_Register, Accumulator_Registers[2], Accumulator_Registers[0], false));
+    if (n > 1) backend.addInstruction(Instructions::Vector::vmovGPToLanes(Result_Register, Accumulator_Registers[3], Accumulator_Registers[1], true));
+    if (configuration.hasBias) backend.addInstruction(Instructions::Vector::vadd(Result_Register, Result_Register, Bias_Register));
+
+    if (configuration.perChannel) {
+        backend.addInstruction(Instructions::Vector::vshl(Result_Register, Result_Register, Left_Shift_Register));
+        backend.addInstruction(Instructions::Vector::vqrdmulh(Result_Register, Result_Register, Multiplier_Register));
+        // fixup = (result & right) >> 31, i.e. -1 for negative results with a right shift (right < 0)
+        backend.addInstruction(Instructions::Vector::vand(Fixup_Register, Result_Register, Right_Shift_Register));
+        backend.addInstruction(Instructions::Vector::vshrImmediate(Fixup_Register, Fixup_Register, 31));
+        backend.addInstruction(Instructions::Vector::vqadd(Result_Register, Result_Register, Fixup_Register));
+        backend.addInstruction(Instructions::Vector::vrshl(Result_Register, Result_Register, Right_Shift_Register));
+    } else {
+        if (requantization.shift > 0) backend.addInstruction(Instructions::Vector::vshlImmediate(Result_Register, Result_Register, requantization.shift));
+        backend.addInstruction(Instructions::Vector::vqrdmulh(Result_Register, Result_Register, Multiplier_Register));
+        if (requantization.shift < 0) {
+            backend.addInstruction(Instructions::Vector::vshrImmediate(Fixup_Register, Result_Register, 31));
+            backend.addInstruction(Instructions::Vector::vqadd(Result_Register, Result_Register, Fixup_Register));
+            backend.addInstruction(Instructions::Vector::vrshrImmediate(Result_Register, Result_Register, -requantization.shift));
+        }
+    }
+
+    if (requantization.outputOffset != 0) {
+        backend.addMoveImmediate(TEMP_REGISTER, static_cast<uint32_t>(requantization.outputOffset));
+        backend.addInstruction(Instructions::Vector::vaddScalar(Result_Register, Result_Register, TEMP_REGISTER));
+    }
+
+    Instructions::VectorRegister minRegister = Activation_Min_Register;
+    Instructions::VectorRegister maxRegister = Activation_Max_Register;
+    if (configuration.perChannel) {
+        minRegister = Row_Activation_Min_Register;
+        maxRegister = Row_Activation_Max_Register;
+        backend.addMoveImmediate(TEMP_REGISTER, static_cast<uint32_t>(requantization.activationMin));
+        backend.addInstruction(Instructions::Vector::vdup(minRegister, TEMP_REGISTER));
+        backend.addMoveImmediate(TEMP_REGISTER, static_cast<uint32_t>(requantization.activationMax));
+        backend.addInstruction(Instructions::Vector::vdup(maxRegister, TEMP_REGISTER));
+    }
+    backend.addInstruction(Instructions::Vector::vmax(Result_Register, Result_Register, minRegister));
+    backend.addInstruction(Instructions::Vector::vmin(Result_Register, Result_Register, maxRegister));
+}
+
+/*
+Computes n (<= 4) columns of C for all m rows. Afterwards A_Row_Pointer and C_Pointer point to the first row again.
+Returns the first instruction, so the caller can branch to the start of the block.
+*/
+JIT::Instructions::Instruction16 * JIT::Generators::GemmS8::generateColumnBlock(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, bool variableColumn, uint32_t column, Requantization const & requantization, MicroKernelConfiguration const & configuration) {
+    Instructions::Instruction16 * blockStart = backend.startBasicBlock();
+    emitLoadChannelParameters(n, variableColumn, column, requantization, configuration);
+    if (m > 1) backend.addInstruction(Instructions::DataProcessing::movImmediate32(I_Loop_Register, 0));
+
+    Instructions::Instruction16 * rowLoopStart = backend.addBranchTargetInstruction(Instructions::DataProcessing::movRegister32(A_Stream_Register, A_Row_Pointer));
+    backend.addInstruction(Instructions::DataProcessing::movRegister32(B_Stream_Registers[0], B_Base_Pointer));
+    for (uint32_t j = 1; j < n; j++) { // the accumulator is free until it is zeroed
+        backend.addAddImmediate(B_Stream_Registers[j], B_Stream_Registers[j - 1], ldb, Accumulator_Registers[0]);
+    }
+
+    // tail predicated k loop: the last iteration only loads the remaining k % 16 bytes
+    backend.addMoveImmediate(Accumulator_Registers[0], k);
+    backend.addInstruction(Instructions::Base::dlstp(Accumulator_Registers[0], Instructions::Size8));
+    for (uint32_t j = 0; j < n; j++) {
+        backend.addInstruction(Instructions::DataProcessing::movImmediate32(Accumulator_Registers[j], 0));
+    }
+    Instructions::Instruction16 * kLoopStart = backend.addBranchTargetInstruction(Instructions::Vector::vldrb(A_Vector_Register, A_Stream_Register, VECTOR_SIZE, false, true));
+    for (uint32_t j = 0; j < n; j++) {
+        Instructions::VectorRegister bReg = B_Vector_Registers[j % 2];
+        backend.addInstruction(Instructions::Vector::vldrb(bReg, B_Stream_Registers[j], VECTOR_SIZE, false, true));
+        backend.addInstruction(Instructions::Vector::vmladav(Accumulator_Registers[j], A_Vector_Register, bReg));
+    }
+    backend.addLowOverheadBranchFromCurrentPosition(kLoopStart, true);
+
+    emitRequantize(n, requantization, configuration);
+    if (n < MICROKERNEL_N) {
+        backend.addInstruction(Instructions::DataProcessing::movImmediate32(TEMP_REGISTER, n));
+        backend.addInstruction(Instructions::Vector::vctp(Instructions::Size32, TEMP_REGISTER));
+        backend.addInstruction(Instructions::Vector::vpst(1));
+    }
+    backend.addInstruction(Instructions::Vector::vstrbNarrowing(Result_Register, C_Pointer));
+
+    if (m > 1) {
+        backend.addAddImmediate(A_Row_Pointer, A_Row_Pointer, lda, TEMP_REGISTER);
+        backend.addAddImmediate(C_Pointer, C_Pointer, ldc, TEMP_REGISTER);
+        backend.addInstruction(Instructions::Arithmetic::addImmediate32(I_Loop_Register, 1));
+        backend.addCompareImmediate(I_Loop_Register, m, TEMP_REGISTER);
+        backend.addBackwardsBranchFromCurrentPosition(rowLoopStart, Instructions::LT);
+        // rewind A and C to the first row
+        backend.addAddImmediate(A_Row_Pointer, A_Row_Pointer, m * lda, TEMP_REGISTER, true);
+        backend.addAddImmediate(C_Pointer, C_Pointer, m * ldc, TEMP_REGISTER, true);
+    }
+    return blockStart;
+}
+
+JIT::Generators::GemmS8::Func JIT::Generators::GemmS8::generate(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, Requantization const & requantization) {
+    if (k == 0) {
+        Instructions::Base::printValidationError("GemmS8::generate: k == 0 not supported - returning nullptr");
+        return nullptr;
+    }
+    if (requantization.multipliers == nullptr && (requantization.shift > 31 || requantization.shift < -32)) {
+        Instructions::Base::printValidationError("GemmS8::generate: shift has to be in [-32, 31] - returning nullptr");
+        return nullptr;
+    }
+    backend.resetKernel();
+
+    // push all registers to the stack
+    backend.addInstruction(Instructions::DataProcessing::push32(Instructions::R4, Instructions::R5, Instructions::R6, Instructions::R7, Instructions::R8, Instructions::R9, Instructions::R10, Instructions::R11, Instructions::R12, Instructions::LR));
+    backend.addInstruction(Instructions::DataProcessing::vpush(Instructions::Q4, 4));
+
+    MicroKernelConfiguration configuration = {};
+    configuration.perChannel = requantization.multipliers != nullptr;
+    configuration.hasBias = requantization.bias != nullptr;
+    if (!configuration.perChannel) { // the per-tensor parameters are kept in vector registers for the whole kernel
+        backend.addMoveImmediate(TEMP_REGISTER, static_cast<uint32_t>(requantization.multiplier));
+        backend.addInstruction(Instructions::Vector::vdup(Multiplier_Register, TEMP_REGISTER));
+        backend.addMoveImmediate(TEMP_REGISTER, static_cast<uint32_t>(requantization.activationMin));
+        backend.addInstruction(Instructions::Vector::vdup(Activation_Min_Register, TEMP_REGISTER));
+        backend.addMoveImmediate(TEMP_REGISTER, static_cast<uint32_t>(requantization.activationMax));
+        backend.addInstruction(Instructions::Vector::vdup(Activation_Max_Register, TEMP_REGISTER));
+    }
+
+    uint32_t const nFull = n - (n % MICROKERNEL_N);
+    bool const columnLoop = nFull > MICROKERNEL_N;
+    if (nFull > 0) {
+        if (columnLoop) {
+            backend.addInstruction(Instructions::DataProcessing::movImmediate32(TEMP_REGISTER, 0));
+            backend.addInstruction(Instructions::Vector::vmovGPxScalar(false, J_Loop_Register, TEMP_REGISTER));
+        }
+        Instructions::Instruction16 * jLoopStart = generateColumnBlock(m, k, MICROKERNEL_N, lda, ldb, ldc, columnLoop, 0, requantization, configuration);
+        if (columnLoop || n % MICROKERNEL_N != 0) {
+            // next column block: B += 4 rows, C += 4 columns
+            backend.addAddImmediate(B_Base_Pointer, B_Base_Pointer, MICROKERNEL_N * ldb, TEMP_REGISTER);
+            backend.addInstruction(Instructions::Arithmetic::addImmediate32(C_Pointer, MICROKERNEL_N));
+        }
+        if (columnLoop) {
+            backend.addInstruction(Instructions::Vector::vmovGPxScalar(true, J_Loop_Register, TEMP_REGISTER));
+            backend.addInstruction(Instructions::Arithmetic::addImmediate32(TEMP_REGISTER, MICROKERNEL_N));
+            backend.addInstruction(Instructions::Vector::vmovGPxScalar(false, J_Loop_Register, TEMP_REGISTER));
+            backend.addCompareImmediate(TEMP_REGISTER, nFull, J_Register);
+            backend.addBackwardsBranchFromCurrentPosition(jLoopStart, Instructions::LT);
+        }
+    }
+    if (n % MICROKERNEL_N != 0) {
+        generateColumnBlock(m, k, n % MICROKERNEL_N, lda, ldb, ldc, false, nFull, requantization, configuration);
+    }
+
+    backend.addInstruction(Instructions::DataProcessing::vpop(Instructions::Q4, 4));
+    backend.addInstruction(Instructions::DataProcessing::pop32(Instructions::R4, Instructions::R5, Instructions::R6, Instructions::R7, Instructions::R8, Instructions::R9, Instructions::R10, Instructions::R11, Instructions::R12, Instructions::PC));
+
+    backend.clearCaches();
+    return reinterpret_cast<Func>(backend.getThumbAddress());
+}
@@ -0,0 +1,76 @@
+#ifndef JIT_GENERATORS_GEMM_S8_HPP
+#define JIT_GENERATORS_GEMM_S8_HPP
+
+#include "backend/Backend.hpp"
+#include "instructions/Base.hpp"
+#include <cstdint>
+
+namespace JIT {
+    namespace Generators {
+        class GemmS8;
+    }
+}
+
+/**
+ * @brief Generator for int8 GEMMs with int32 accumulation and requantization to int8 (same semantics as CMSIS-NN arm_nn_mat_mult_nt_t_s8):
+ * C[i][j] = clamp(requantize(sum_k A[i][k] * B[j][k] + bias[j], multiplier[j], shift[j]) + outputOffset, activationMin, activationMax)
+ * A (m x k, lhs), B (n x k, rhs/weights) and C (m x n) are row-major, i.e. both operands are contiguous along k.
+ *
+ * The microkernel computes one row of C times four columns: per 16 k, one row of A and four rows of B are loaded
+ * and multiplied with VMLADAVA (dot product into GP registers). The k loop is tail predicated (DLSTP/LETP), so k does not
+ * have to be a multiple of 16. Afterwards the four accumulators are moved into one vector, so the per-channel parameters
+ * of the four columns can be loaded with a single VLDRW and the four bytes of C are written with a narrowing store.
+ *
+ * The input offset (zero point of A) is not applied in the kernel: it has to be folded into the bias with computeKernelSums
+ * (as arm_vector_sum_s8 does for CMSIS-NN). The weights are symmetric (zero point 0).
+ */
+class JIT::Generators::GemmS8 {
+    public:
+        struct Requantization {
+            int32_t const * bias; // n values or nullptr, see computeKernelSums
+            int32_t const * multipliers; // n values (Q31) for per-channel quantization, nullptr: per-tensor multiplier and shift are used
+            int32_t const * shifts; // n values, positive: left shift
+            int32_t multiplier; // per-tensor (Q31)
+            int32_t shift; // per-tensor, in [-32, 31]
+            int32_t outputOffset;
+            int32_t activationMin;
+            int32_t activationMax;
+        };
+
+    private:
+        Backend backend;
+        struct MicroKernelConfiguration {
+            bool perChannel;
+            bool hasBias;
+        };
+
+        Instructions::Instruction16 * generateColumnBlock(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, bool variableColumn, uint32_t column, Requantization const & requantization, MicroKernelConfiguration const & configuration);
+        void emitLoadChannelParameters(uint32_t n, bool variableColumn, uint32_t column, Requantization const & requantization, MicroKernelConfiguration const & configuration);
+        void emitRequantize(uint32_t n, Requantization const & requantization, MicroKernelConfiguration const & configuration);
+
+    public:
+        using Func = void (*) (int8_t const *, int8_t const *, int8_t *);
+
+        GemmS8(Instructions::Instruction16 * globalBuffer, uint32_t bufferSize) : backend(globalBuffer, bufferSize) {
+            backend.enableScheduling();
+        }
+        /**
+         * @brief Generates the kernel for the given shape (lda, ldb and ldc in bytes, lda and ldb >= k).
+         * The addresses of the parameter arrays are embedded into the kernel, they have to stay valid as long as the kernel is used.
+         * Returns nullptr if the shift is out of range or k == 0.
+         */
+        Func generate(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, Requantization const & requantization);
+        /// @brief Size of the last generated kernel in halfwords
+        uint16_t getInstructionCount() {
+            return backend.getInstructionCount();
+        }
+
+        /**
+         * @brief Folds the input offset into the bias: kernelSums[j] = bias[j] + inputOffset * sum_k B[j][k]
+         * Only has to be computed once per layer (the weights are known at deploy time).
+         * @param bias n values or nullptr
+         */
+        static void computeKernelSums(int8_t const * b, uint32_t k, uint32_t n, uint32_t ldb, int32_t const * bias, int32_t inputOffset, int32_t * kernelSums);
+};
+
+#endif // JIT_GENERATORS_GEMM_S8_HPP
@@ -0,0 +1,305 @@
+#include "GemmStencil.hpp"
+#include "backend/Backend.hpp"
+#include "instructions/Arithmetic.hpp"
+#include "instructions/Base.hpp"
+#include "instructions/DataProcessing.hpp"
+#include "instructions/Vector.hpp"
+#include <cstdint>
+#include <cstring>
+
+/*
+Register map of the stencils:
+- R0, R1, R2: A, B, C (current block)
+- R3, R4, R5: elements of the three B columns
+- R6, R7, R8: lda, ldb, ldc in bytes
+- R9: address of the second and third C column
+- R10, R11: I and J loop counters
+- R12: temp (vctp count, k, 32-bit constants)
+- LR: k loop (DLS/LE)
+- Q0 - Q5: accumulators (column * vectors + vector), Q6 - Q7: A
+*/
+constexpr JIT::Instructions::Register A_Pointer = JIT::Instructions::R0;
+constexpr JIT::Instructions::Register B_Pointer = JIT::Instructions::R1;
+constexpr JIT::Instructions::Register C_Pointer = JIT::Instructions::R2;
+constexpr JIT::Instructions::Register B_Registers[] = {JIT::Instructions::R3, JIT::Instructions::R4, JIT::Instructions::R5};
+constexpr JIT::Instructions::Register LDA_Register = JIT::Instructions::R6;
+constexpr JIT::Instructions::Register LDB_Register = JIT::Instructions::R7;
+constexpr JIT::Instructions::Register LDC_Register = JIT::Instructions::R8;
+constexpr JIT::Instructions::Register C_Column_Pointer = JIT::Instructions::R9;
+constexpr JIT::Instructions::Register Loop_Registers[] = {JIT::Instructions::R10, JIT::Instructions::R11};
+constexpr JIT::Instructions::Register Temp_Register = JIT::Instructions::R12;
+constexpr JIT::Instructions::VectorRegister A_Register = JIT::Instructions::Q6;
+
+constexpr uint32_t VECTOR_SIZE = 16; // == 128 Bit
+constexpr uint32_t DT_SIZE = 4; // == 32 Bit (FP32)
+constexpr uint32_t VECTOR_ELEMENTS = VECTOR_SIZE / DT_SIZE;
+
+/* fields of the immediates of the T3 MOVW/MOVT, T4 ADDW/SUBW and T3 B<c>.W encodings */
+constexpr JIT::Instructions::Instruction32 IMM16_MASK = 0x040f'70ff;
+constexpr JIT::Instructions::Instruction32 IMM12_MASK = 0x0400'70ff;
+constexpr JIT::Instructions::Instruction32 BRANCH_MASK = 0x043f'2fff;
+
+static JIT::Instructions::Instruction32 read32(JIT::Instructions::Instruction16 const * code) {
+    return static_cast<JIT::Instructions::Instruction32>(code[0]) << 16 | code[1];
+}
+
+static void write32(JIT::Instructions::Instruction16 * code, JIT::Instructions::Instruction32 instruction) {
+    code[0] = static_cast<JIT::Instructions::Instruction16>(instruction >> 16);
+    code[1] = static_cast<JIT::Instructions::Instruction16>(instruction);
+}
+
+static void patchImmediate16(JIT::Instructions::Instruction16 * code, uint32_t imm16) {
+    JIT::Instructions::Instruction32 instr = read32(code) & ~IMM16_MASK;
+    instr |= 0xff & imm16; // set imm8
+    instr |= (0x7 & (imm16 >> 8)) << 12; // set imm3
+    instr |= (0x1 & (imm16 >> 11)) << 26; // set i
+    instr |= (0xf & (imm16 >> 12)) << 16; // set imm4
+    write32(code, instr);
+}
+
+static void patchImmediate12(JIT::Instructions::Instruction16 * code, uint32_t imm12) {
+    JIT::Instructions::Instruction32 instr = read32(code) & ~IMM12_MASK;
+    instr |= 0xff & imm12; // set imm8
+    instr |= (0x7 & (imm12 >> 8)) << 12; // set imm3
+    instr |= (0x1 & (imm12 >> 11)) << 26; // set i
+    write32(code, instr);
+}
+
+/* offset in bytes relative to the PC (instruction + 4) */
+static void patchBranch(JIT::Instructions::Instruction16 * code, int32_t offset) {
+    uint32_t const imm = static_cast<uint32_t>(offset);
+    JIT::Instructions::Instruction32 instr = read32(code) & ~BRANCH_MASK;
+    instr |= (0x7ff & (imm >> 1)); // set imm11
+    instr |= (0x3f & (imm >> 12)) << 16; // set imm6
+    instr |= (0x1 & (imm >> 18)) << 13; // set J1
+    instr |= (0x1 & (imm >> 19)) << 11; // set J2
+    instr |= (0x1 & (imm >> 20)) << 26; // set S
+    write32(code, instr);
+}
+
+void JIT::Generators::GemmStencil::Stencil::add(Instructions::Instruction16 instruction) {
+    code[size++] = instruction;
+}
+
+void JIT::Generators::GemmStencil::Stencil::add(Instructions::Instruction32 instruction) {
+    write32(code + size, instruction);
+    size += 2;
+}
+
+void JIT::Generators::GemmStencil::Stencil::addHole(Instructions::Instruction32 instruction, HoleKind kind, Parameter parameter) {
+    holes[holeCount++] = {size, kind, parameter};
+    add(instruction);
+    if (kind == IMM32) {
+        Instructions::Register const Rd = static_cast<Instructions::Register>(0xf & (instruction >> 8));
+        add(Instructions::DataProcessing::movtImmediate32(Rd, 0));
+    }
+}
+
+void JIT::Generators::GemmStencil::Stencil::align() {
+    if (size % 2 != 0) add(Instructions::Base::nop16());
+}
+
+JIT::Generators::GemmStencil::GemmStencil(Instructions::Instruction16 * globalBuffer, uint32_t bufferSize) : buffer(globalBuffer), bufferSize(bufferSize) {
+    using namespace Instructions;
+
+    prologue.add(DataProcessing::push32(R4, R5, R6, R7, R8, R9, R10, R11, R12, LR));
+    prologue.add(DataProcessing::vpush(Q4, 4));
+    prologue.addHole(DataProcessing::movImmediate32(LDA_Register, 0), IMM32, LDA_BYTES);
+    prologue.addHole(DataProcessing::movImmediate32(LDB_Register, 0), IMM32, LDB_BYTES);
+    prologue.addHole(DataProcessing::movImmediate32(LDC_Register, 0), IMM32, LDC_BYTES);
+
+    epilogue.add(DataProcessing::vpop(Q4, 4));
+    epilogue.add(DataProcessing::pop32(R4, R5, R6, R7, R8, R9, R10, R11, R12, PC));
+
+    for (uint8_t loop = LOOP_I; loop <= LOOP_J; loop++) {
+        Register const counter = Loop_Registers[loop];
+        loopHead[loop].addHole(DataProcessing::movImmediate32(counter, 0), IMM16, LOOP_COUNT);
+        loopEnd[loop].add(Arithmetic::subImmediate32(counter, 1));
+        loopEnd[loop].add(Base::cmpImmediate32(counter, 0));
+        loopEnd[loop].addHole(Base::bCond32(NE, 0), BRANCH, LOOP_TARGET);
+    }
+
+    // A back to the first row, B and C to the next block of columns
+    columnStep.addHole(DataProcessing::movImmediate32(Temp_Register, 0), IMM32, A_COLUMN);
+    columnStep.add(Arithmetic::subRegister32(A_Pointer, Temp_Register));
+    columnStep.addHole(DataProcessing::movImmediate32(Temp_Register, 0), IMM32, B_COLUMN);
+    columnStep.add(Arithmetic::addRegister32(B_Pointer, Temp_Register));
+    columnStep.addHole(DataProcessing::movImmediate32(Temp_Register, 0), IMM32, C_COLUMN);
+    columnStep.add(Arithmetic::addRegister32(C_Pointer, Temp_Register));
+
+    for (uint32_t vectors = 1; vectors <= 2; vectors++) {
+        for (uint32_t predicated = 0; predicated <= 1; predicated++) {
+            for (uint32_t columns = 1; columns <= NR; columns++) {
+                buildMicrokernel(microkernels[vectors - 1][predicated][columns - 1], vectors, predicated == 1, columns);
+            }
+        }
+    }
+}
+
+/*
+One block of up to 8 rows and 3 columns of C, for all k:
+the C block is loaded, k rank-1 updates are accumulated in a low overhead loop and the block is stored.
+Afterwards A points to the next rows, B back to its first row and C to the next rows.
+Tail blocks (predicated) limit the last vector with VCTP to the REMAINDER rows.
+*/
+void JIT::Generators::GemmStencil::buildMicrokernel(Stencil & stencil, uint32_t vectors, bool predicated, uint32_t columns) {
+    using namespace Instructions;
+
+    auto accumulator = [vectors](uint32_t column, uint32_t vector) {
+        return static_cast<VectorRegister>(column * vectors + vector);
+    };
+    auto loadStoreC = [&](bool store) {
+        for (uint32_t column = 0; column < columns; column++) {
+            if (column == 1) stencil.add(Arithmetic::addRegister32(C_Column_Pointer, C_Pointer, LDC_Register));
+            if (column == 2) stencil.add(Arithmetic::addRegister32(C_Column_Pointer, C_Pointer, LDC_Register, LSL, 1));
+            Register const base = column == 0 ? C_Pointer : C_Column_Pointer;
+            for (uint32_t vector = 0; vector < vectors; vector++) {
+                int16_t const offset = static_cast<int16_t>(vector * VECTOR_SIZE);
+                if (predicated && vector == vectors - 1) stencil.add(Vector::vpst(1));
+                stencil.add(store ? Vector::vstrw(accumulator(column, vector), base, offset) : Vector::vldrw(accumulator(column, vector), base, offset));
+            }
+        }
+    };
+
+    if (predicated) {
+        stencil.addHole(DataProcessing::movImmediate32(Temp_Register, 0), IMM16, REMAINDER);
+        stencil.add(Vector::vctp(Size32, Temp_Register));
+    }
+    loadStoreC(false);
+
+    stencil.addHole(DataProcessing::movImmediate32(Temp_Register, 0), IMM16, K);
+    stencil.add(Base::dls(Temp_Register));
+    stencil.align();
+    uint8_t const loopStart = stencil.size;
+    for (uint32_t vector = 0; vector < vectors; vector++) {
+        if (predicated && vector == vectors - 1) stencil.add(Vector::vpst(1));
+        stencil.add(Vector::vldrw(static_cast<VectorRegister>(A_Register + vector), A_Pointer, static_cast<int16_t>(vector * VECTOR_SIZE)));
+    }
+    stencil.add(Arithmetic::addRegister32(A_Pointer, LDA_Register));
+    if (columns > 1) stencil.add(DataProcessing::ldrRegister32(B_Registers[1], B_Pointer, LDB_Register));
+    if (columns > 2) stencil.add(DataProcessing::ldrRegister32(B_Registers[2], B_Pointer, LDB_Register, 1));
+    stencil.add(DataProcessing::ldrImmediate32(B_Registers[0], B_Pointer, DT_SIZE, false, true));
+    for (uint32_t column = 0; column < columns; column++) {
+        for (uint32_t vector = 0; vector < vectors; vector++) {
+            stencil.add(Vector::vfmaVectorByScalarPlusVector(accumulator(column, vector), static_cast<VectorRegister>(A_Register + vector), B_Registers[column]));
+        }
+    }
+    stencil.add(Base::le(static_cast<int16_t>(2 * loopStart - (2 * stencil.size + 4))));
+
+    loadStoreC(true);
+    stencil.addHole(DataProcessing::movImmediate32(Temp_Register, 0), IMM32, A_REWIND);
+    stencil.add(Arithmetic::subRegister32(A_Pointer, Temp_Register));
+    stencil.addHole(DataProcessing::movImmediate32(Temp_Register, 0), IMM32, B_REWIND);
+    stencil.add(Arithmetic::subRegister32(B_Pointer, Temp_Register));
+    stencil.addHole(Arithmetic::addImmediate32(C_Pointer, 0), IMM12, C_ADVANCE);
+    stencil.align();
+}
+
+bool JIT::Generators::GemmStencil::emit(Stencil const & stencil) {
+    if (count + stencil.size > bufferSize) {
+        Instructions::Base::printValidationError("GemmStencil::emit: buffer is full - returning false");
+        return false;
+    }
+    Instructions::Instruction16 * code = buffer + count;
+    std::memcpy(code, stencil.code, stencil.size * sizeof(Instructions::Instruction16));
+    for (uint8_t i = 0; i < stencil.holeCount; i++) {
+        Hole const & hole = stencil.holes[i];
+        uint32_t const value = parameters[hole.parameter];
+        switch (hole.kind) {
+            case IMM16:
+                patchImmediate16(code + hole.offset, value);
+                break;
+            case IMM32:
+                patchImmediate16(code + hole.offset, value & 0xffff);
+                patchImmediate16(code + hole.offset + 2, value >> 16);
+                break;
+            case IMM12:
+                patchImmediate12(code + hole.offset, value);
+                break;
+            case BRANCH:
+                patchBranch(code + hole.offset, 2 * static_cast<int32_t>(value) - 2 * static_cast<int32_t>(count + hole.offset) - 4);
+                break;
+        }
+    }
+    count += stencil.size;
+    return true;
+}
+
+/* all rows of one block of columns: the full microkernels in the I loop and the tail */
+bool JIT::Generators::GemmStencil::emitRows(uint32_t m, uint32_t columns) {
+    uint32_t const blocks = m / MR;
+    uint32_t const rest = m % MR;
+    uint32_t loopStart = 0;
+
+    if (blocks > 1) {
+        parameters[LOOP_COUNT] = blocks;
+        if (!emit(loopHead[LOOP_I])) return false;
+        loopStart = count;
+    }
+    if (blocks > 0) {
+        parameters[REMAINDER] = 0;
+        parameters[A_REWIND] = parameters[K] * parameters[LDA_BYTES] - MR * DT_SIZE;
+        parameters[C_ADVANCE] = MR * DT_SIZE;
+        if (!emit(microkernels[1][0][columns - 1])) return false;
+    }
+    if (blocks > 1) {
+        parameters[LOOP_TARGET] = loopStart;
+        if (!emit(loopEnd[LOOP_I])) return false;
+    }
+    if (rest > 0) {
+        uint32_t const vectors = (rest + VECTOR_ELEMENTS - 1) / VECTOR_ELEMENTS;
+        bool const predicated = rest % VECTOR_ELEMENTS != 0;
+        parameters[REMAINDER] = rest % VECTOR_ELEMENTS;
+        parameters[A_REWIND] = parameters[K] * parameters[LDA_BYTES] - rest * DT_SIZE;
+        parameters[C_ADVANCE] = rest * DT_SIZE;
+        if (!emit(microkernels[vectors - 1][predicated][columns - 1])) return false;
+    }
+    return true;
+}
+
+bool JIT::Generators::GemmStencil::emitColumnBlocks(uint32_t m, uint32_t columns, uint32_t blocks, uint32_t ldb, uint32_t ldc) {
+    uint32_t loopStart = 0;
+    if (blocks == 0) return true;
+
+    if (blocks > 1) {
+        parameters[LOOP_COUNT] = blocks;
+        if (!emit(loopHead[LOOP_J])) return false;
+        loopStart = count;
+    }
+    if (!emitRows(m, columns)) return false;
+    parameters[A_COLUMN] = m * DT_SIZE;
+    parameters[B_COLUMN] = columns * ldb * DT_SIZE;
+    parameters[C_COLUMN] = columns * ldc * DT_SIZE - m * DT_SIZE;
+    if (!emit(columnStep)) return false;
+    if (blocks > 1) {
+        parameters[LOOP_TARGET] = loopStart;
+        if (!emit(loopEnd[LOOP_J])) return false;
+    }
+    return true;
+}
+
+JIT::Generators::GemmStencil::Func JIT::Generators::GemmStencil::generate(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc) {
+    if (m == 0 || k == 0 || n == 0) {
+        Instructions::Base::printValidationError("GemmStencil::generate: m, k and n must be > 0 - returning nullptr");
+        return nullptr;
+    }
+    if (k > MAX_K) {
+        Instructions::Base::printValidationError("GemmStencil::generate: k must be <= MAX_K - returning nullptr");
+        return nullptr;
+    }
+
+    count = 0;
+    parameters[LDA_BYTES] = lda * DT_SIZE;
+    parameters[LDB_BYTES] = ldb * DT_SIZE;
+    parameters[LDC_BYTES] = ldc * DT_SIZE;
+    parameters[K] = k;
+    parameters[B_REWIND] = k * DT_SIZE;
+
+    if (!emit(prologue)) return nullptr;
+    if (!emitColumnBlocks(m, NR, n / NR, ldb, ldc)) return nullptr;
+    if (!emitColumnBlocks(m, n % NR, n % NR == 0 ? 0 : 1, ldb, ldc)) return nullptr;
+    if (!emit(epilogue)) return nullptr;
+
+    Backend::clearCaches(buffer, count);
+    return reinterpret_cast<Func>(reinterpret_cast<uintptr_t>(buffer) | 1);
+}
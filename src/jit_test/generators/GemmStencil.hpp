@@ -0,0 +1,122 @@
+#ifndef JIT_GENERATORS_GEMM_STENCIL_HPP
+#define JIT_GENERATORS_GEMM_STENCIL_HPP
+
+#include "instructions/Base.hpp"
+#include <cstdint>
+
+namespace JIT {
+    namespace Generators {
+        class GemmStencil;
+    }
+}
+
+/**
+ * @brief Copy-and-patch generator for C += A * B (column-major, COLUMN_MAJOR_NN) with near-zero generation latency.
+ * The code pieces of a kernel (prologue, epilogue, loop heads and ends, column step and the 8x3 microkernel with all
+ * row and column tails) are encoded once in the constructor. Generating a kernel only copies the stencils into the
+ * buffer and patches the holes: MOVW/MOVT and ADDW immediates (leading dimensions, k, pointer rewinds) and the B<c>.W
+ * offsets of the loops. Neither the IR passes nor the scheduler run, so the kernels are slower than the ones of Gemm,
+ * but a kernel is built with a few hundred bytes of memcpy.
+ *
+ * The buffer has to be word aligned, all stencils have an even number of halfwords so the loop starts stay aligned.
+ */
+class JIT::Generators::GemmStencil {
+    public:
+        using Func = void (*) (float const *, float const *, float *);
+
+        static constexpr uint32_t MR = 8; // rows of the microkernel (two vectors)
+        static constexpr uint32_t NR = 3; // columns of the microkernel
+        static constexpr uint32_t MAX_K = UINT16_MAX; // the k loop count is a MOVW hole
+
+        /**
+         * @brief Builds the stencils, the kernels are generated into globalBuffer
+         *
+         * @param bufferSize size of globalBuffer in halfwords
+         */
+        GemmStencil(Instructions::Instruction16 * globalBuffer, uint32_t bufferSize);
+
+        /**
+         * @brief Generates C += A * B for column-major A (lda >= m), B (ldb >= k) and C (ldc >= m).
+         * Returns nullptr if a dimension is 0, k > MAX_K or the kernel does not fit into the buffer.
+         */
+        Func generate(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc);
+
+        /// @brief Size of the last generated kernel in halfwords
+        uint32_t getInstructionCount() const {
+            return count;
+        }
+
+    private:
+        /* values of the holes, set by generate before a stencil is copied */
+        enum Parameter : uint8_t {
+            LDA_BYTES,
+            LDB_BYTES,
+            LDC_BYTES,
+            LOOP_COUNT,
+            LOOP_TARGET, // position of the loop start in halfwords
+            K,
+            REMAINDER, // rows in the last vector of a tail microkernel
+            A_REWIND,
+            B_REWIND,
+            C_ADVANCE,
+            A_COLUMN,
+            B_COLUMN,
+            C_COLUMN,
+            PARAMETER_COUNT
+        };
+
+        enum HoleKind : uint8_t {
+            IMM16, // MOVW
+            IMM32, // MOVW followed by MOVT
+            IMM12, // ADDW/SUBW
+            BRANCH // B<c>.W (T3), the parameter is the absolute target
+        };
+
+        struct Hole {
+            uint8_t offset; // halfwords from the start of the stencil
+            HoleKind kind;
+            Parameter parameter;
+        };
+
+        static constexpr uint32_t MAX_STENCIL_SIZE = 128;
+        static constexpr uint32_t MAX_HOLES = 6;
+
+        struct Stencil {
+            Instructions::Instruction16 code[MAX_STENCIL_SIZE];
+            Hole holes[MAX_HOLES];
+            uint8_t size = 0;
+            uint8_t holeCount = 0;
+
+            void add(Instructions::Instruction16 instruction);
+            void add(Instructions::Instruction32 instruction);
+            /// @brief Adds the instruction(s) of the hole with zero immediates
+            void addHole(Instructions::Instruction32 instruction, HoleKind kind, Parameter parameter);
+            /// @brief Pads with a NOP to an even number of halfwords
+            void align();
+        };
+
+        enum LoopRegister : uint8_t {
+            LOOP_I,
+            LOOP_J
+        };
+
+        Stencil prologue;
+        Stencil epilogue;
+        Stencil loopHead[2];
+        Stencil loopEnd[2];
+        Stencil columnStep;
+        Stencil microkernels[2][2][NR]; // [vectors - 1][predicated][columns - 1]
+
+        Instructions::Instruction16 * buffer;
+        uint32_t bufferSize;
+        uint32_t count = 0;
+        uint32_t parameters[PARAMETER_COUNT] = {};
+
+        void buildMicrokernel(Stencil & stencil, uint32_t vectors, bool predicated, uint32_t columns);
+        /// @brief Copies the stencil to the end of the kernel and patches its holes, false if the buffer is full
+        bool emit(Stencil const & stencil);
+        bool emitRows(uint32_t m, uint32_t columns);
+        bool emitColumnBlocks(uint32_t m, uint32_t columns, uint32_t blocks, uint32_t ldb, uint32_t ldc);
+};
+
+#endif // JIT_GENERATORS_GEMM_STENCIL_HPP
@@ -0,0 +1,89 @@
+#include "GemmTuner.hpp"
+#include "instructions/Base.hpp"
+#include <cstdint>
+#if defined(__arm__)
+#include "timing.hpp"
+#include <chrono>
+#endif
+
+/* Candidates of the search, the defaults are always measured first */
+constexpr uint8_t K_UNROLL_CANDIDATES[] = {1, 2, 3, 8};
+constexpr uint8_t M_UNROLL_CANDIDATES[] = {0, 2, 8};
+constexpr uint8_t N_UNROLL_CANDIDATES[] = {0, 1, 5};
+
+static bool sameTuning(JIT::Generators::Gemm::Tuning const & lhs, JIT::Generators::Gemm::Tuning const & rhs) {
+    return lhs.use46Microkernel == rhs.use46Microkernel && lhs.kMaxUnroll == rhs.kMaxUnroll && lhs.mMaxUnroll == rhs.mMaxUnroll && lhs.nMaxUnroll == rhs.nMaxUnroll
+        && lhs.predicatedEdges == rhs.predicatedEdges;
+}
+
+uint32_t JIT::Generators::GemmTuner::measure(Gemm::Tuning const & tuning, float const * a, float const * b, float * c, uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, Gemm::Layout layout, uint32_t iterations) {
+    Gemm::Func kernel = generator.generateTuned(m, k, n, lda, ldb, ldc, tuning, false, 1.0f, 1.0f, layout);
+    // the backend drops instructions when the buffer is full, a program which doesn't fit is not generated at all (nullptr)
+    if (kernel == nullptr || generator.getInstructionCount() + 2U >= bufferSize) return NOT_MEASURED;
+    uint32_t const cycles = timer(context, kernel, a, b, c, iterations);
+    if (cycles != NOT_MEASURED) candidateCount++;
+    return cycles;
+}
+
+uint32_t JIT::Generators::GemmTuner::countCycles(void *, Gemm::Func kernel, float const * a, float const * b, float * c, uint32_t iterations) {
+    #if defined(__arm__)
+    kernel(a, b, c);
+    auto start = CYCCNT_Clock::now();
+    for (uint32_t it = 0; it < iterations; it++) {
+        kernel(a, b, c);
+    }
+    auto end = CYCCNT_Clock::now();
+    return (end - start).count();
+    #else
+    // no cycle counter on the host, the candidates are skipped
+    (void) kernel;
+    (void) a;
+    (void) b;
+    (void) c;
+    (void) iterations;
+    return NOT_MEASURED;
+    #endif
+}
+
+JIT::Generators::Gemm::Tuning JIT::Generators::GemmTuner::tune(float const * a, float const * b, float * c, uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, Gemm::Layout layout, uint32_t iterations) {
+    candidateCount = 0;
+    stored = false;
+    Gemm::Tuning best = Gemm::defaultTuning();
+    defaultCycles = bestCycles = measure(best, a, b, c, m, k, n, lda, ldb, ldc, layout, iterations);
+    if (bestCycles == NOT_MEASURED) return best;
+
+    auto tryCandidate = [&](Gemm::Tuning const & candidate) {
+        if (sameTuning(candidate, best)) return;
+        uint32_t const cycles = measure(candidate, a, b, c, m, k, n, lda, ldb, ldc, layout, iterations);
+        if (cycles < bestCycles) {
+            bestCycles = cycles;
+            best = candidate;
+        }
+    };
+
+    Gemm::Tuning candidate = best;
+    candidate.use46Microkernel = !best.use46Microkernel;
+    tryCandidate(candidate);
+    candidate = best;
+    candidate.predicatedEdges = !best.predicatedEdges;
+    tryCandidate(candidate);
+    for (uint8_t unroll : K_UNROLL_CANDIDATES) {
+        candidate = best;
+        candidate.kMaxUnroll = unroll;
+        tryCandidate(candidate);
+    }
+    for (uint8_t unroll : M_UNROLL_CANDIDATES) {
+        candidate = best;
+        candidate.mMaxUnroll = unroll;
+        tryCandidate(candidate);
+    }
+    for (uint8_t unroll : N_UNROLL_CANDIDATES) {
+        candidate = best;
+        candidate.nMaxUnroll = unroll;
+        tryCandidate(candidate);
+    }
+
+    stored = table.insert({m, k, n, lda, ldb, ldc, layout, best});
+    if (!stored) Instructions::Base::printValidationError("GemmTuner::tune: tuning table full - winner not stored");
+    return best;
+}
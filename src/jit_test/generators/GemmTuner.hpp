@@ -0,0 +1,83 @@
+#ifndef JIT_GENERATORS_GEMM_TUNER_HPP
+#define JIT_GENERATORS_GEMM_TUNER_HPP
+
+#include "generators/Gemm.hpp"
+#include "generators/GemmTuningTable.hpp"
+#include <cstdint>
+
+namespace JIT {
+    namespace Generators {
+        class GemmTuner;
+    }
+}
+
+/**
+ * @brief On-target autotuner for the parameters of the NN kernels (Gemm::Tuning).
+ * For a shape the candidates are generated and timed with the cycle counter on the passed matrices, so the measurement
+ * includes the memory regions of the operands and of the generator buffer. Another Timer replaces the cycle counter,
+ * e.g. the CycleEstimator on the host. The parameters are searched one after the other
+ * (4x6 tail, predicated edges, k unrolling, m unrolling, n unrolling), each starting from the best parameters found so far.
+ * The winner is stored in the tuning table, which can be passed to Gemm::setTuningTable.
+ *
+ * The loop order of the NN kernels is fixed (j outer, i inner), so it is not part of the search.
+ */
+class JIT::Generators::GemmTuner {
+    public:
+        /// @brief Runs the kernel once for warm up and returns the cycles of iterations further calls, UINT32_MAX if it can't be timed
+        using Timer = uint32_t (*)(void * context, Gemm::Func kernel, float const * a, float const * b, float * c, uint32_t iterations);
+
+        /**
+         * @param generator Generator for the candidates
+         * @param bufferSize Size of the buffer of the generator in halfwords, candidates which don't fit are skipped
+         * @param table Table which receives the results
+         * @param timer countCycles() by default
+         */
+        GemmTuner(Gemm & generator, uint32_t bufferSize, GemmTuningTable & table, Timer timer = countCycles, void * context = nullptr)
+            : generator(generator), bufferSize(bufferSize), table(table), timer(timer), context(context) {}
+
+        /**
+         * @brief Times the candidates for the shape and stores the fastest in the table.
+         * C is overwritten. Each candidate runs once for warm up and is then timed over the given iterations.
+         * Returns the winner (the defaults if no candidate could be generated). If the table is full and doesn't contain
+         * the shape yet, the winner is only returned (validation error, see isStored).
+         */
+        Gemm::Tuning tune(float const * a, float const * b, float * c, uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, Gemm::Layout layout = Gemm::COLUMN_MAJOR_NN, uint32_t iterations = 10);
+
+        /// @brief Cycles of the winner of the last tune call (all iterations)
+        uint32_t getBestCycles() const {
+            return bestCycles;
+        }
+        /// @brief Cycles of the defaults in the last tune call (all iterations)
+        uint32_t getDefaultCycles() const {
+            return defaultCycles;
+        }
+        /// @brief Count of candidates which were generated and timed in the last tune call
+        uint32_t getCandidateCount() const {
+            return candidateCount;
+        }
+        /// @brief Whether the last tune call stored its winner in the table
+        bool isStored() const {
+            return stored;
+        }
+
+        /// @brief The cycle counter (CYCCNT) on the target, on the host nothing can be timed
+        static uint32_t countCycles(void * context, Gemm::Func kernel, float const * a, float const * b, float * c, uint32_t iterations);
+
+    private:
+        static constexpr uint32_t NOT_MEASURED = UINT32_MAX;
+
+        Gemm & generator;
+        uint32_t bufferSize;
+        GemmTuningTable & table;
+        Timer timer;
+        void * context;
+
+        uint32_t bestCycles = NOT_MEASURED;
+        uint32_t defaultCycles = NOT_MEASURED;
+        uint32_t candidateCount = 0;
+        bool stored = false;
+
+        uint32_t measure(Gemm::Tuning const & tuning, float const * a, float const * b, float * c, uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, Gemm::Layout layout, uint32_t iterations);
+};
+
+#endif // JIT_GENERATORS_GEMM_TUNER_HPP
@@ -0,0 +1,58 @@
+#include "GemmTuningTable.hpp"
+#include <cstdint>
+#include <cstdio>
+#if defined(__arm__)
+#include "SEGGER_RTT.h"
+#endif
+
+JIT::Generators::GemmTuningTable::GemmTuningTable(Entry const * entries, uint32_t count) {
+    for (uint32_t i = 0; i < count && i < MAX_ENTRIES; i++) insert(entries[i]);
+}
+
+int32_t JIT::Generators::GemmTuningTable::indexOf(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, Gemm::Layout layout) const {
+    // the table is small and only searched when a kernel is generated
+    for (uint32_t i = 0; i < count; i++) {
+        Entry const & entry = entries[i];
+        if (entry.m == m && entry.k == k && entry.n == n && entry.lda == lda && entry.ldb == ldb && entry.ldc == ldc && entry.layout == layout) {
+            return static_cast<int32_t>(i);
+        }
+    }
+    return -1;
+}
+
+JIT::Generators::Gemm::Tuning const * JIT::Generators::GemmTuningTable::find(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, Gemm::Layout layout) const {
+    int32_t const index = indexOf(m, k, n, lda, ldb, ldc, layout);
+    return index < 0 ? nullptr : &entries[index].tuning;
+}
+
+bool JIT::Generators::GemmTuningTable::insert(Entry const & entry) {
+    int32_t const index = indexOf(entry.m, entry.k, entry.n, entry.lda, entry.ldb, entry.ldc, entry.layout);
+    if (index >= 0) {
+        entries[index] = entry;
+        return true;
+    }
+    if (count == MAX_ENTRIES) return false;
+    entries[count++] = entry;
+    return true;
+}
+
+void JIT::Generators::GemmTuningTable::print(Writer writer, void * context) const {
+    char line[MAX_LINE];
+    for (uint32_t i = 0; i < count; i++) {
+        Entry const & entry = entries[i];
+        snprintf(line, sizeof(line), "{%u, %u, %u, %u, %u, %u, static_cast<JIT::Generators::Gemm::Layout>(%u), {%s, %u, %u, %u, %s}},\n",
+            static_cast<unsigned>(entry.m), static_cast<unsigned>(entry.k), static_cast<unsigned>(entry.n),
+            static_cast<unsigned>(entry.lda), static_cast<unsigned>(entry.ldb), static_cast<unsigned>(entry.ldc), static_cast<unsigned>(entry.layout),
+            entry.tuning.use46Microkernel ? "true" : "false", static_cast<unsigned>(entry.tuning.kMaxUnroll), static_cast<unsigned>(entry.tuning.mMaxUnroll),
+            static_cast<unsigned>(entry.tuning.nMaxUnroll), entry.tuning.predicatedEdges ? "true" : "false");
+        writer(context, line);
+    }
+}
+
+void JIT::Generators::GemmTuningTable::write(void *, char const * text) {
+    #if defined(__arm__)
+    SEGGER_RTT_WriteString(0, text);
+    #else
+    fputs(text, stdout);
+    #endif
+}
@@ -0,0 +1,73 @@
+#ifndef JIT_GENERATORS_GEMM_TUNING_TABLE_HPP
+#define JIT_GENERATORS_GEMM_TUNING_TABLE_HPP
+
+#include "generators/Gemm.hpp"
+#include <cstdint>
+
+namespace JIT {
+    namespace Generators {
+        class GemmTuningTable;
+    }
+}
+
+/**
+ * @brief Measured parameters of the GEMM kernels per shape (see Gemm::setTuningTable and GemmTuner).
+ * The entries are plain data: a table which was filled by GemmTuner can be printed (see print) and compiled into the
+ * application as a constant array, so later runs use the measured parameters without tuning again.
+ * No dynamic memory is used, the table has a fixed capacity.
+ */
+class JIT::Generators::GemmTuningTable {
+    public:
+        static constexpr uint32_t MAX_ENTRIES = 32;
+        static constexpr uint32_t MAX_LINE = 128;
+        using Writer = void (*)(void * context, char const * text);
+
+        struct Entry {
+            uint32_t m;
+            uint32_t k;
+            uint32_t n;
+            uint32_t lda;
+            uint32_t ldb;
+            uint32_t ldc;
+            Gemm::Layout layout;
+            Gemm::Tuning tuning;
+        };
+
+        GemmTuningTable() = default;
+        /// @brief Copies the entries of a previous tuning run (at most MAX_ENTRIES)
+        GemmTuningTable(Entry const * entries, uint32_t count);
+
+        /// @brief Returns the parameters of the shape or nullptr if it was not tuned
+        Gemm::Tuning const * find(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, Gemm::Layout layout) const;
+        /// @brief Adds the entry or replaces the entry of the same shape. Returns false if the table is full.
+        bool insert(Entry const & entry);
+        void clear() {
+            count = 0;
+        }
+
+        uint32_t getCount() const {
+            return count;
+        }
+        Entry const & getEntry(uint32_t index) const {
+            return entries[index];
+        }
+
+        /**
+         * @brief Prints one initializer of Entry[] per line, e.g.
+         * {24, 24, 24, 24, 24, 24, static_cast<JIT::Generators::Gemm::Layout>(0), {true, 5, 5, 3, false}},
+         * The lines can be pasted into an array which is passed to GemmTuningTable(entries, count).
+         *
+         * @param writer gets every line including the line break, write() by default
+         */
+        void print(Writer writer = write, void * context = nullptr) const;
+        /// @brief RTT channel 0 on the target, stdout on the host
+        static void write(void * context, char const * text);
+
+    private:
+        Entry entries[MAX_ENTRIES] = {};
+        uint32_t count = 0;
+
+        int32_t indexOf(uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, Gemm::Layout layout) const;
+};
+
+#endif // JIT_GENERATORS_GEMM_TUNING_TABLE_HPP
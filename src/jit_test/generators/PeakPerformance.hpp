@@ -20,6 +20,10 @@ class JIT::Generators::PeakPerformance {
         using FuncVoid = void (*) ();
         void (*generate(uint32_t operational_intensity))(uint32_t len);
         void (*generateVfma(uint32_t vfmaCount))();
+        /// @brief Size of the last generated kernel in halfwords
+        uint16_t getInstructionCount() {
+            return backend.getInstructionCount();
+        }
         // void (*generate(uint32_t flops, uint32_t vectorCount))(float const *a, float const *b, float *c, uint32_t);
         // void (*generateNoMem(uint32_t operational_intensity))(float const *a, float const *b, float *c, uint32_t);
         // void (*generateSteps(float operational_intensity)) (float const * a, float const * b, float * c, uint32_t size);
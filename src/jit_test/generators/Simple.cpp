@@ -14,7 +14,6 @@ uint32_t ( *JIT::Generators::Simple::generate())() {
     backend.addInstruction(Instructions::Base::bx(Instructions::Register::LR));
 
 
-    __asm("dsb");
-    __asm("isb");
+    backend.clearCaches();
     return reinterpret_cast<Func>(backend.getThumbAddress());
 }
@@ -23,8 +23,7 @@ void (*JIT::Generators::Throughput::generate()) (float const *a, uint32_t size)
     // pop {pc}
     backend.addInstruction(Instructions::DataProcessing::pop32(Instructions::PC));
 
-    __asm("dsb");
-    __asm("isb");
+    backend.clearCaches();
 
     return reinterpret_cast<Func>(backend.getThumbAddress());
 }
@@ -5,10 +5,13 @@
 #include <cstdint>
 
 void (*JIT::Generators::Triad::generate(uint32_t count)) (float const * a, float const * b, float * c, float const scalar) {
-    // push r4
-    backend.addInstruction(Instructions::DataProcessing::push32(Instructions::R4));
-    // push {lr}
-    backend.addInstruction(Instructions::DataProcessing::push32(Instructions::Register::LR));
+    backend.resetKernel();
+    IR::Arena arena(programStorage, sizeof(programStorage));
+    IR::Program program(arena, MAX_NODES, MAX_LABELS);
+    backend.beginProgram(program);
+
+    // push {r4, lr}
+    backend.addInstruction(Instructions::DataProcessing::push32(Instructions::R4, Instructions::Register::LR));
     // vmov.f32 r3, s0
     backend.addInstruction(Instructions::Vector::vmovGPxScalar(true, Instructions::S0, Instructions::R3));
 
@@ -16,26 +19,26 @@ void (*JIT::Generators::Triad::generate(uint32_t count)) (float const * a, float
     backend.addInstruction(Instructions::DataProcessing::movImmediate32(Instructions::R4, count));
 
     // dlstp
-    Instructions::Instruction16 * dlstpStart = backend.addBranchTargetInstruction(Instructions::Base::dlstp(Instructions::Register::R4, Instructions::Size32));
+    backend.addInstruction(Instructions::Base::dlstp(Instructions::Register::R4, Instructions::Size32));
+    IR::Program::Label loopStart = backend.newLabel();
+    backend.bindLabel(loopStart);
     // vldrw.f32 q0, [r0], #16
-    backend.addInstruction(Instructions::Vector::vldrw(Instructions::Q0, Instructions::R0, 4, 0, 1));
-    // vldrw.f32 q0, [r1], #16
-    backend.addInstruction(Instructions::Vector::vldrw(Instructions::Q0, Instructions::R1, 4, 0, 1));
-    // vfma.f32 q2, q0, r3
-    backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(Instructions::Q2, Instructions::Q0, Instructions::R3, 0));
-    // vstrw.f32 q2, [r2], #16
-    backend.addInstruction(Instructions::Vector::vstrw(Instructions::Q2, Instructions::R2, 4, 0, 1));
-
-    // letp lr, -> branch to dlstpStart
-    backend.addInstruction(Instructions::Base::letp(backend.getBranchOffset(dlstpStart) + 2));
-
-    // pop r4
-    backend.addInstruction(Instructions::DataProcessing::pop32(Instructions::R4));
-    // pop {pc}
-    backend.addInstruction(Instructions::DataProcessing::pop32(Instructions::PC));
-
-    __asm("dsb");
-    __asm("isb");
+    backend.addInstruction(Instructions::Vector::vldrw(Instructions::Q0, Instructions::R0, 16, 0, 1));
+    // vldrw.f32 q1, [r1], #16
+    backend.addInstruction(Instructions::Vector::vldrw(Instructions::Q1, Instructions::R1, 16, 0, 1));
+    // vfma.f32 q0, q1, r3: c = a + scalar * b
+    backend.addInstruction(Instructions::Vector::vfmaVectorByScalarPlusVector(Instructions::Q0, Instructions::Q1, Instructions::R3, 0));
+    // vstrw.f32 q0, [r2], #16
+    backend.addInstruction(Instructions::Vector::vstrw(Instructions::Q0, Instructions::R2, 16, 0, 1));
+
+    // letp lr, -> branch to loopStart
+    backend.addLowOverheadBranch(loopStart, true);
+
+    // pop {r4, pc}
+    backend.addInstruction(Instructions::DataProcessing::pop32(Instructions::R4, Instructions::PC));
+    backend.endProgram();
+
+    backend.clearCaches();
 
     return reinterpret_cast<Func>(backend.getThumbAddress());
 }
\ No newline at end of file
@@ -12,10 +12,16 @@ namespace JIT {
 
 class JIT::Generators::Triad {
     private:
+        static constexpr uint16_t MAX_NODES = 16;
+        static constexpr uint16_t MAX_LABELS = 1;
+
         Backend backend;
+        alignas(4) uint8_t programStorage[IR::Program::storageSize(MAX_NODES, MAX_LABELS)];
 
     public:
-        Triad(Instructions::Instruction16 * globalBuffer, uint32_t bufferSize) : backend(globalBuffer, bufferSize) {}
+        Triad(Instructions::Instruction16 * globalBuffer, uint32_t bufferSize) : backend(globalBuffer, bufferSize) {
+            backend.enableScheduling();
+        }
         using Func = void (*) (float const *, float const *, float *, float const);
         void (*generate(uint32_t count))(float const *a, float const *b, float *c, float const);
 };
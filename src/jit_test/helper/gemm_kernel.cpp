@@ -4,27 +4,6 @@
 #include "../backend/Backend.hpp"
 #include "../generators/Gemm.hpp"
 
-void gemm_reference_row_major(const float * __restrict__ a, const float * __restrict__ b, float * __restrict__ c, const uint32_t n, const uint32_t k, const uint32_t m, const uint32_t lda, const uint32_t ldb, const uint32_t ldc) {
-    for (uint32_t j = 0; j < n; j++) { // j = n
-        for (uint32_t i = 0; i < m; i++) { // i = m
-            for (uint32_t p = 0; p < k; p++) { // p = k
-                c[i * ldc + j] += a[i * lda + p] * b[p * ldb + j];
-            }
-        }
-    }
-}
-
-
-void gemm_reference_column_major(const float * __restrict__ a, const float * __restrict__ b, float * __restrict__ c, const uint32_t n, const uint32_t k, const uint32_t m, const uint32_t lda, const uint32_t ldb, const uint32_t ldc) {
-    for (uint32_t j = 0; j < n; j++) { // j = n
-        for (uint32_t i = 0; i < m; i++) { // i = m
-            for (uint32_t p = 0; p < k; p++) { // p = k
-                c[j * ldc + i] += a[p * lda + i] * b[j * ldb + p];
-            }
-        }
-    }
-}
-
 void addDot8x3_unroll_fused_accumulate_pointers_v2_rowfuse_intrinsics(const float * __restrict__ a, const float * __restrict__ b, float * __restrict__ c, const uint32_t n, const uint32_t k, const uint32_t m, const uint32_t lda, const uint32_t ldb, const uint32_t ldc) {
     // Wir wollen Single Precision, damit die Register auch genutzt werden können
     // So passen 4 Float32 Werte rein, statt nur 2 Double
@@ -0,0 +1,75 @@
+#include "gemm_reference.hpp"
+#include <cstdint>
+
+void gemm_reference_row_major(const float * __restrict__ a, const float * __restrict__ b, float * __restrict__ c, const uint32_t n, const uint32_t k, const uint32_t m, const uint32_t lda, const uint32_t ldb, const uint32_t ldc) {
+    for (uint32_t j = 0; j < n; j++) { // j = n
+        for (uint32_t i = 0; i < m; i++) { // i = m
+            for (uint32_t p = 0; p < k; p++) { // p = k
+                c[i * ldc + j] += a[i * lda + p] * b[p * ldb + j];
+            }
+        }
+    }
+}
+
+
+void gemm_reference_column_major(const float * __restrict__ a, const float * __restrict__ b, float * __restrict__ c, const uint32_t n, const uint32_t k, const uint32_t m, const uint32_t lda, const uint32_t ldb, const uint32_t ldc) {
+    for (uint32_t j = 0; j < n; j++) { // j = n
+        for (uint32_t i = 0; i < m; i++) { // i = m
+            for (uint32_t p = 0; p < k; p++) { // p = k
+                c[j * ldc + i] += a[p * lda + i] * b[j * ldb + p];
+            }
+        }
+    }
+}
+
+// C = op(A) * op(B) + C for all layouts of the generator
+void gemm_reference(const float * __restrict__ a, const float * __restrict__ b, float * __restrict__ c, const uint32_t n, const uint32_t k, const uint32_t m, const uint32_t lda, const uint32_t ldb, const uint32_t ldc, JIT::Generators::Gemm::Layout layout) {
+    bool const rowMajor = layout & JIT::Generators::Gemm::ROW_MAJOR;
+    // element (row, col) of a stored matrix
+    auto element = [rowMajor](const float * x, uint32_t row, uint32_t col, uint32_t ld) {
+        return rowMajor ? x[row * ld + col] : x[col * ld + row];
+    };
+    for (uint32_t j = 0; j < n; j++) { // j = n
+        for (uint32_t i = 0; i < m; i++) { // i = m
+            float & cij = rowMajor ? c[i * ldc + j] : c[j * ldc + i];
+            for (uint32_t p = 0; p < k; p++) { // p = k
+                float aip = layout & JIT::Generators::Gemm::TRANSPOSE_A ? element(a, p, i, lda) : element(a, i, p, lda);
+                float bpj = layout & JIT::Generators::Gemm::TRANSPOSE_B ? element(b, j, p, ldb) : element(b, p, j, ldb);
+                cij += aip * bpj;
+            }
+        }
+    }
+}
+
+// arm_nn_requantize of CMSIS-NN: rounding doubling high multiply (saturating like VQRDMULH), then RoundingDivideByPOT of gemmlowp
+int32_t requantize_s8_reference(int32_t value, int32_t multiplier, int32_t shift) {
+    int32_t const left = shift > 0 ? shift : 0;
+    int32_t const exponent = shift > 0 ? 0 : -shift;
+    int32_t const shifted = static_cast<int32_t>(static_cast<uint32_t>(value) << left);
+    int32_t high = INT32_MAX; // the only overflow: INT32_MIN * INT32_MIN
+    if (shifted != INT32_MIN || multiplier != INT32_MIN) {
+        high = static_cast<int32_t>((static_cast<int64_t>(shifted) * multiplier + (1LL << 30)) >> 31);
+    }
+    // rounds to nearest, ties away from zero (64 bit for exponent == 32)
+    int64_t const mask = (1LL << exponent) - 1;
+    int64_t const remainder = high & mask;
+    int64_t const threshold = (mask >> 1) + (high < 0 ? 1 : 0);
+    return static_cast<int32_t>((static_cast<int64_t>(high) >> exponent) + (remainder > threshold ? 1 : 0));
+}
+
+void gemm_reference_s8(const int8_t * __restrict__ a, const int8_t * __restrict__ b, int8_t * __restrict__ c, const uint32_t m, const uint32_t k, const uint32_t n, const uint32_t lda, const uint32_t ldb, const uint32_t ldc, const int32_t inputOffset, JIT::Generators::GemmS8::Requantization const & requantization) {
+    bool const perChannel = requantization.multipliers != nullptr;
+    for (uint32_t i = 0; i < m; i++) { // i = m
+        for (uint32_t j = 0; j < n; j++) { // j = n
+            int32_t acc = requantization.bias != nullptr ? requantization.bias[j] : 0;
+            for (uint32_t p = 0; p < k; p++) { // p = k
+                acc += (a[i * lda + p] + inputOffset) * b[j * ldb + p];
+            }
+            int32_t result = requantize_s8_reference(acc, perChannel ? requantization.multipliers[j] : requantization.multiplier, perChannel ? requantization.shifts[j] : requantization.shift);
+            result += requantization.outputOffset;
+            result = result < requantization.activationMin ? requantization.activationMin : result;
+            result = result > requantization.activationMax ? requantization.activationMax : result;
+            c[i * ldc + j] = static_cast<int8_t>(result);
+        }
+    }
+}
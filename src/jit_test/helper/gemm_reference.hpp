@@ -0,0 +1,18 @@
+#ifndef GEMM_REFERENCE_HPP
+#define GEMM_REFERENCE_HPP
+#include <cstdint>
+#include "../generators/Gemm.hpp"
+#include "../generators/GemmS8.hpp"
+
+// Plain loop implementations without intrinsics, they are also built for the host tests
+void gemm_reference_row_major(const float * __restrict__ a, const float * __restrict__ b, float * __restrict__ c, const uint32_t n, const uint32_t k, const uint32_t m, const uint32_t lda, const uint32_t ldb, const uint32_t ldc);
+void gemm_reference_column_major(const float * __restrict__ a, const float * __restrict__ b, float * __restrict__ c, const uint32_t n, const uint32_t k, const uint32_t m, const uint32_t lda, const uint32_t ldb, const uint32_t ldc);
+void gemm_reference(const float * __restrict__ a, const float * __restrict__ b, float * __restrict__ c, const uint32_t n, const uint32_t k, const uint32_t m, const uint32_t lda, const uint32_t ldb, const uint32_t ldc, JIT::Generators::Gemm::Layout layout);
+/*
+int8 GEMM of GemmS8: C = clamp(requantize(A * B^T + bias) + outputOffset) with row-major A (m x k), B (n x k) and C (m x n).
+The input offset is added to A here, requantization.bias is the bias without it (the kernel gets the sums of computeKernelSums).
+*/
+int32_t requantize_s8_reference(int32_t value, int32_t multiplier, int32_t shift);
+void gemm_reference_s8(const int8_t * __restrict__ a, const int8_t * __restrict__ b, int8_t * __restrict__ c, const uint32_t m, const uint32_t k, const uint32_t n, const uint32_t lda, const uint32_t ldb, const uint32_t ldc, const int32_t inputOffset, JIT::Generators::GemmS8::Requantization const & requantization);
+
+#endif // GEMM_REFERENCE_HPP
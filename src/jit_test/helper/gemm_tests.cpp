@@ -16,6 +16,8 @@ constexpr float peak = 1.6;
 constexpr uint32_t arrSize = 240;
 #endif
 static char PRINTF_OUT_STRING[256] __attribute__((used, section(".bss.array_region_sram0")));
+// program arena shared by the Gemm generators of the benchmarks (they generate one after another), sized for the largest code buffer
+alignas(4) static uint8_t programStorage[JIT::Generators::Gemm::programStorageSize(8192)];
 
 
 void initMatrices(float * a, float * b, float * c, float * cref, const uint32_t m, const uint32_t n, const uint32_t k, bool zeroC, bool useFloat) {
@@ -41,6 +43,22 @@ int32_t testShapeGenerateTime(
     return time; // return negative value if test not succesful
 }
 
+int32_t testShapeCachedGenerateTime(
+    float * bigA, float * bigB, float * bigC, float * bigCRef,
+    uint32_t m, uint32_t n, uint32_t k, uint32_t iterations, JIT::Generators::GemmCache & cache) {
+    JIT::Generators::Gemm::Func gemmFunc;
+    initMatrices(bigA, bigB, bigC, bigCRef, m, n, k);
+
+    auto start = RTC_Clock::now();
+    for (uint32_t it = 0; it < iterations; it++) {
+        gemmFunc = cache.get(m, k, n, m, k, m);
+    }
+    auto end = RTC_Clock::now();
+    gemmFunc(bigA, bigB, bigC);
+    auto time = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    return time;
+}
+
 int32_t testShape(
     float * bigA, float * bigB, float * bigC, float * bigCRef,
     uint32_t m, uint32_t n, uint32_t k, uint32_t iterations, JIT::Generators::Gemm & generator) {
@@ -136,7 +154,7 @@ void testSquareShapes(
     int32_t time;
     double gflops;
     uint32_t m, n, k;
-    JIT::Generators::Gemm gemmGen(globalBuffer, 3072);
+    JIT::Generators::Gemm gemmGen(globalBuffer, 3072, programStorage, sizeof(programStorage));
     SEGGER_RTT_printf(0, "--- START TEST SQUARE SHAPES ---\n");
     SEGGER_RTT_printf(0, "Test;M;K;N;Type;GFLOPS;Time;Iterations;Correct\n");
     for (uint32_t i = 1; i <= 240; i++) {
@@ -193,7 +211,7 @@ void testGrowingK(
     int32_t time;
     double gflops;
     uint32_t m = 24, n = 24, k;
-    JIT::Generators::Gemm gemmGen(globalBuffer, 3072);
+    JIT::Generators::Gemm gemmGen(globalBuffer, 3072, programStorage, sizeof(programStorage));
     SEGGER_RTT_printf(0, "--- START TEST GROWING K ---\n");
     SEGGER_RTT_printf(0, "Test;M;K;N;Type;GFLOPS;Time;Iterations;Correct\n");
     for (uint32_t i = 1; i <= arrSize; i++) {
@@ -248,7 +266,7 @@ void testGrowingM(
     int32_t time;
     double gflops;
     uint32_t m = 1, n = 24, k = 24;
-    JIT::Generators::Gemm gemmGen(globalBuffer, 3072);
+    JIT::Generators::Gemm gemmGen(globalBuffer, 3072, programStorage, sizeof(programStorage));
     SEGGER_RTT_printf(0, "--- START TEST GROWING M ---\n");
     SEGGER_RTT_printf(0, "Test;M;K;N;Type;GFLOPS;Time;Iterations;Correct\n");
     for (uint32_t i = 1; i <= arrSize; i++) {
@@ -303,7 +321,7 @@ void testGrowingN(
     int32_t time;
     double gflops;
     uint32_t m = 24, n = 1, k = 24;
-    JIT::Generators::Gemm gemmGen(globalBuffer, 3072);
+    JIT::Generators::Gemm gemmGen(globalBuffer, 3072, programStorage, sizeof(programStorage));
     SEGGER_RTT_printf(0, "--- START TEST GROWING N ---\n");
     SEGGER_RTT_printf(0, "Test;M;K;N;Type;GFLOPS;Time;Iterations;Correct\n");
     for (uint32_t i = 1; i <= arrSize; i++) {
@@ -355,7 +373,7 @@ void constSizeTest(
     uint32_t m, uint32_t n, uint32_t k, bool validate) {
 
     initMatrices(bigA, bigB, bigC, bigCRef, m, n, k);
-    JIT::Generators::Gemm gemmGen(globalBuffer, 10000);
+    JIT::Generators::Gemm gemmGen(globalBuffer, 10000, programStorage, sizeof(programStorage));
     uint32_t repeats = 5;
     uint32_t flops = 2 * m * k * n;
     uint32_t iterations = (peak * pow(10, 9)) / flops;
@@ -377,7 +395,7 @@ void testAllSizes(
     uint32_t start, uint32_t end, uint32_t resume, bool validate) {
     int32_t time;
     double gflops;
-    JIT::Generators::Gemm gemmGen(globalBuffer, 3072);
+    JIT::Generators::Gemm gemmGen(globalBuffer, 3072, programStorage, sizeof(programStorage));
     SEGGER_RTT_printf(0, "--- START TEST SQUARE SHAPES ---\n");
     SEGGER_RTT_printf(0, "Test;M;K;N;Type;GFLOPS;Time;Iterations;Correct\n");
     for (uint32_t m = start; m <= end; m++) {
@@ -428,4 +446,586 @@ void testAllSizes(
     }
     SEGGER_RTT_printf(0, "--- END TEST ALL SIZES ---\n\n");
 
-}
\ No newline at end of file
+}
+
+void testPredicatedEdges(
+    float * bigA, float * bigB, float * bigC, float * bigCRef,
+    JIT::Instructions::Instruction16 * globalBuffer,
+    uint32_t start, uint32_t end) {
+    using Gemm = JIT::Generators::Gemm;
+    Gemm gemmGen(globalBuffer, 3072, programStorage, sizeof(programStorage));
+    SEGGER_RTT_printf(0, "--- START TEST PREDICATED EDGES ---\n");
+    SEGGER_RTT_printf(0, "Test;M;K;N;Type;GFLOPS;Time;Iterations;Size;Correct\n");
+    for (uint32_t m = start; m <= end; m++) {
+        // both strategies generate the same code for the other edges
+        if (m % 8 <= 4) continue;
+        for (uint32_t n = start; n <= end; n++) {
+            for (uint32_t k = start; k <= end; k++) {
+                // same iteration count as testAllSizes
+                uint32_t flops = 2 * m * k * n;
+                uint32_t iterations = ((peak * pow(10, 9)) / flops) * 0.2;
+                iterations = iterations > 10000000 ? 10000000 : iterations;
+                for (bool predicatedEdges : {false, true}) {
+                    Gemm::Tuning tuning = Gemm::defaultTuning();
+                    tuning.predicatedEdges = predicatedEdges;
+                    auto gemmFunc = gemmGen.generateTuned(m, k, n, m, k, m, tuning);
+                    uint16_t size = gemmGen.getInstructionCount();
+
+                    initMatrices(bigA, bigB, bigC, bigCRef, m, n, k);
+                    gemmFunc(bigA, bigB, bigC);
+                    gemm_reference_column_major(bigA, bigB, bigCRef, n, k, m, m, k, m);
+                    bool correct = compare(bigC, bigCRef, m*n) == -1;
+
+                    auto startTime = RTC_Clock::now();
+                    for (uint32_t it = 0; it < iterations; it++) {
+                        gemmFunc(bigA, bigB, bigC);
+                    }
+                    auto endTime = RTC_Clock::now();
+                    int32_t time = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
+                    if (time == 0) time = 1;
+                    double gflops = static_cast<float>(flops) / (time * 1000000.0f) * iterations;
+                    sprintf(PRINTF_OUT_STRING, "Edges;%d;%d;%d;%s;%f;%d;%d;%d;%d\r\n", m, k, n, predicatedEdges ? "Predicated" : "Remainder",
+                        gflops, time, iterations, size, correct);
+                    SEGGER_RTT_WriteString(0, PRINTF_OUT_STRING);
+                }
+            }
+        }
+    }
+    SEGGER_RTT_printf(0, "--- END TEST PREDICATED EDGES ---\n\n");
+}
+
+void testKernelCache(
+    float * bigA, float * bigB, float * bigC, float * bigCRef,
+    JIT::Instructions::Instruction16 * codeRegion, uint32_t regionSize,
+    JIT::Instructions::Instruction16 * stagingBuffer, uint32_t rounds) {
+    // handful of layer shapes which are switched between per inference
+    constexpr uint32_t shapes[][3] = {
+        {24, 24, 24}, {16, 32, 8}, {8, 64, 3}, {32, 16, 12}, {20, 24, 24}, {4, 100, 6}
+    };
+    constexpr uint32_t shapeCount = sizeof(shapes) / sizeof(shapes[0]);
+    JIT::Generators::Gemm gemmGen(stagingBuffer, 3072, programStorage, sizeof(programStorage));
+    JIT::Generators::GemmCache cache(gemmGen, codeRegion, regionSize);
+    SEGGER_RTT_printf(0, "--- START TEST KERNEL CACHE ---\n");
+    SEGGER_RTT_printf(0, "Test;M;K;N;Type;Time;Iterations;Correct\n");
+    uint32_t iterations = 1000;
+    for (uint32_t i = 0; i < shapeCount; i++) {
+        uint32_t m = shapes[i][0], k = shapes[i][1], n = shapes[i][2];
+        int32_t time = testShapeGenerateTime(bigA, bigB, bigC, bigCRef, m, n, k, iterations, gemmGen);
+        sprintf(PRINTF_OUT_STRING, "Cache;%d;%d;%d;Generate;%d;%d;1\r\n", m, k, n, time, iterations);
+        SEGGER_RTT_WriteString(0, PRINTF_OUT_STRING);
+        time = testShapeCachedGenerateTime(bigA, bigB, bigC, bigCRef, m, n, k, iterations, cache);
+        sprintf(PRINTF_OUT_STRING, "Cache;%d;%d;%d;Cached;%d;%d;1\r\n", m, k, n, time, iterations);
+        SEGGER_RTT_WriteString(0, PRINTF_OUT_STRING);
+    }
+
+    // switch between the shapes and validate the resident kernels
+    cache.resetStatistics();
+    bool correct = true;
+    for (uint32_t round = 0; round < rounds; round++) {
+        for (uint32_t i = 0; i < shapeCount; i++) {
+            uint32_t m = shapes[i][0], k = shapes[i][1], n = shapes[i][2];
+            auto gemmFunc = cache.get(m, k, n, m, k, m);
+            initMatrices(bigA, bigB, bigC, bigCRef, m, n, k);
+            gemmFunc(bigA, bigB, bigC);
+            gemm_reference_column_major(bigA, bigB, bigCRef, n, k, m, m, k, m);
+            correct &= compare(bigC, bigCRef, m*n) == -1;
+        }
+    }
+    auto const & statistics = cache.getStatistics();
+    sprintf(PRINTF_OUT_STRING, "CacheStatistics;%d;%d;%d;%d;%d;%d;%d\r\n", statistics.hits, statistics.misses, statistics.evictions,
+        cache.getKernelCount(), cache.getUsedSize(), regionSize, correct);
+    SEGGER_RTT_WriteString(0, PRINTF_OUT_STRING);
+    SEGGER_RTT_printf(0, "--- END TEST KERNEL CACHE ---\n\n");
+}
+
+void testAlphaBeta(
+    float * bigA, float * bigB, float * bigC, float * bigCRef,
+    JIT::Instructions::Instruction16 * globalBuffer) {
+    // shapes which cover all microkernels, k == 1 and the predicated edges
+    constexpr uint32_t shapes[][3] = {
+        {4, 5, 6}, {3, 1, 6}, {7, 9, 13}, {7, 1, 2}, {13, 16, 1}, {14, 1, 1}, {24, 24, 24}, {21, 17, 11}
+    };
+    // the inputs are integers, so all products are exact. alpha = 3 adds C after scaling the accumulators
+    constexpr float scalars[][2] = {
+        {1.0f, 0.0f}, {2.0f, 1.0f}, {1.0f, 0.5f}, {0.5f, 2.0f}, {2.0f, 2.0f}, {4.0f, 0.0f}, {3.0f, 1.0f}
+    };
+    JIT::Generators::Gemm gemmGen(globalBuffer, 4096, programStorage, sizeof(programStorage));
+    SEGGER_RTT_printf(0, "--- START TEST ALPHA BETA ---\n");
+    SEGGER_RTT_printf(0, "Test;M;K;N;Alpha;Beta;Correct\n");
+    for (auto const & shape : shapes) {
+        uint32_t m = shape[0], k = shape[1], n = shape[2];
+        for (auto const & scalar : scalars) {
+            float alpha = scalar[0], beta = scalar[1];
+            auto gemmFunc = gemmGen.generate(m, k, n, m, k, m, false, alpha, beta);
+            initMatrices(bigA, bigB, bigC, bigCRef, m, n, k);
+            gemmFunc(bigA, bigB, bigC);
+            // beta * C + (alpha * A) * B
+            for (uint32_t i = 0; i < m*n; i++) bigCRef[i] *= beta;
+            for (uint32_t i = 0; i < m*k; i++) bigA[i] *= alpha;
+            gemm_reference_column_major(bigA, bigB, bigCRef, n, k, m, m, k, m);
+            bool correct = compare(bigC, bigCRef, m*n) == -1;
+            sprintf(PRINTF_OUT_STRING, "AlphaBeta;%d;%d;%d;%f;%f;%d\r\n", m, k, n, alpha, beta, correct);
+            SEGGER_RTT_WriteString(0, PRINTF_OUT_STRING);
+        }
+    }
+    SEGGER_RTT_printf(0, "--- END TEST ALPHA BETA ---\n\n");
+}
+
+void testLayouts(
+    float * bigA, float * bigB, float * bigC, float * bigCRef,
+    JIT::Instructions::Instruction16 * globalBuffer, uint32_t iterations) {
+    using Gemm = JIT::Generators::Gemm;
+    // shapes which cover full and partial microkernels of both strided tile shapes and k == 1
+    constexpr uint32_t shapes[][3] = {
+        {4, 5, 6}, {3, 1, 6}, {7, 9, 13}, {13, 16, 1}, {8, 3, 3}, {24, 24, 24}, {21, 17, 11}, {32, 32, 32}
+    };
+    constexpr Gemm::Layout layouts[] = {
+        Gemm::COLUMN_MAJOR_NN, Gemm::COLUMN_MAJOR_NT, Gemm::COLUMN_MAJOR_TN, Gemm::COLUMN_MAJOR_TT,
+        Gemm::ROW_MAJOR_NN, Gemm::ROW_MAJOR_NT, Gemm::ROW_MAJOR_TN, Gemm::ROW_MAJOR_TT
+    };
+    constexpr char const * layoutNames[] = {"CNN", "CNT", "CTN", "CTT", "RNN", "RNT", "RTN", "RTT"};
+    Gemm gemmGen(globalBuffer, 4096, programStorage, sizeof(programStorage));
+    SEGGER_RTT_printf(0, "--- START TEST LAYOUTS ---\n");
+    SEGGER_RTT_printf(0, "Test;M;K;N;Layout;Time;Iterations;Correct\n");
+    for (auto const & shape : shapes) {
+        uint32_t m = shape[0], k = shape[1], n = shape[2];
+        for (uint32_t l = 0; l < sizeof(layouts) / sizeof(layouts[0]); l++) {
+            Gemm::Layout layout = layouts[l];
+            // minimal leading dimensions of the stored matrices
+            bool rowMajor = layout & Gemm::ROW_MAJOR;
+            uint32_t aRows = layout & Gemm::TRANSPOSE_A ? k : m, aCols = layout & Gemm::TRANSPOSE_A ? m : k;
+            uint32_t bRows = layout & Gemm::TRANSPOSE_B ? n : k, bCols = layout & Gemm::TRANSPOSE_B ? k : n;
+            uint32_t lda = rowMajor ? aCols : aRows;
+            uint32_t ldb = rowMajor ? bCols : bRows;
+            uint32_t ldc = rowMajor ? n : m;
+
+            auto gemmFunc = gemmGen.generate(m, k, n, lda, ldb, ldc, false, 1.0f, 1.0f, layout);
+            initMatrices(bigA, bigB, bigC, bigCRef, m, n, k);
+            gemmFunc(bigA, bigB, bigC);
+            gemm_reference(bigA, bigB, bigCRef, n, k, m, lda, ldb, ldc, layout);
+            bool correct = compare(bigC, bigCRef, m*n) == -1;
+
+            auto start = RTC_Clock::now();
+            for (uint32_t it = 0; it < iterations; it++) {
+                gemmFunc(bigA, bigB, bigC);
+            }
+            auto end = RTC_Clock::now();
+            int32_t time = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+            sprintf(PRINTF_OUT_STRING, "Layout;%d;%d;%d;%s;%d;%d;%d\r\n", m, k, n, layoutNames[l], time, iterations, correct);
+            SEGGER_RTT_WriteString(0, PRINTF_OUT_STRING);
+        }
+    }
+    SEGGER_RTT_printf(0, "--- END TEST LAYOUTS ---\n\n");
+}
+
+void testF16(
+    float * bigA, float * bigB, float * bigC, float * bigCRef,
+    JIT::Instructions::Instruction16 * globalBuffer, uint32_t iterations) {
+    using GemmF16 = JIT::Generators::GemmF16;
+    // the FP16 matrices are stored in the FP32 buffers, the reference is computed in FP32 into bigCRef
+    _Float16 * a = reinterpret_cast<_Float16 *>(bigA);
+    _Float16 * b = reinterpret_cast<_Float16 *>(bigB);
+    _Float16 * c = reinterpret_cast<_Float16 *>(bigC);
+    // full and partial 16x3, 8x6 and 4x3 microkernels, k which is not a multiple of the FP32 unrolling
+    constexpr uint32_t shapes[][3] = {
+        {16, 8, 3}, {5, 3, 7}, {8, 4, 12}, {21, 17, 11}, {33, 6, 5}, {32, 32, 32}, {48, 48, 48}
+    };
+    constexpr GemmF16::Accumulation accumulations[] = {GemmF16::ACCUMULATE_F16, GemmF16::ACCUMULATE_F32};
+    constexpr char const * accumulationNames[] = {"F16", "F32"};
+    GemmF16 gemmGen(globalBuffer, 4096);
+    SEGGER_RTT_printf(0, "--- START TEST F16 ---\n");
+    SEGGER_RTT_printf(0, "Test;M;K;N;Accumulation;Time;Iterations;Correct\n");
+    for (auto const & shape : shapes) {
+        uint32_t m = shape[0], k = shape[1], n = shape[2];
+        for (uint32_t acc = 0; acc < sizeof(accumulations) / sizeof(accumulations[0]); acc++) {
+            auto gemmFunc = gemmGen.generate(m, k, n, m, k, m, accumulations[acc]);
+            // small integers, so all products and sums are exact in FP16
+            for (uint32_t i = 0; i < m*k; i++) a[i] = static_cast<_Float16>(static_cast<int32_t>(i % 5) - 2);
+            for (uint32_t i = 0; i < k*n; i++) b[i] = static_cast<_Float16>(static_cast<int32_t>(i % 3) - 1);
+            for (uint32_t i = 0; i < m*n; i++) c[i] = static_cast<_Float16>(static_cast<int32_t>(i % 7) - 3);
+            for (uint32_t i = 0; i < m*n; i++) bigCRef[i] = static_cast<float>(c[i]);
+            gemmFunc(a, b, c);
+            for (uint32_t j = 0; j < n; j++) {
+                for (uint32_t p = 0; p < k; p++) {
+                    for (uint32_t i = 0; i < m; i++) {
+                        bigCRef[j*m + i] += static_cast<float>(a[p*m + i]) * static_cast<float>(b[j*k + p]);
+                    }
+                }
+            }
+            bool correct = true;
+            for (uint32_t i = 0; i < m*n; i++) {
+                if (static_cast<float>(c[i]) != bigCRef[i]) {
+                    correct = false;
+                    break;
+                }
+            }
+
+            auto start = RTC_Clock::now();
+            for (uint32_t it = 0; it < iterations; it++) {
+                gemmFunc(a, b, c);
+            }
+            auto end = RTC_Clock::now();
+            int32_t time = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+            sprintf(PRINTF_OUT_STRING, "F16;%d;%d;%d;%s;%d;%d;%d\r\n", m, k, n, accumulationNames[acc], time, iterations, correct);
+            SEGGER_RTT_WriteString(0, PRINTF_OUT_STRING);
+        }
+    }
+    SEGGER_RTT_printf(0, "--- END TEST F16 ---\n\n");
+}
+
+void testS8(
+    float * bigA, float * bigB, float * bigC, float * bigCRef,
+    JIT::Instructions::Instruction16 * globalBuffer, uint32_t iterations) {
+    using GemmS8 = JIT::Generators::GemmS8;
+    // the int8 matrices are stored in the FP32 buffers, the per-channel parameters behind the reference matrix
+    int8_t * a = reinterpret_cast<int8_t *>(bigA);
+    int8_t * b = reinterpret_cast<int8_t *>(bigB);
+    int8_t * c = reinterpret_cast<int8_t *>(bigC);
+    int8_t * cRef = reinterpret_cast<int8_t *>(bigCRef);
+    // layer shapes (m = output pixels, k = input channels * kernel size, n = output channels) with partial column blocks and k tails
+    constexpr uint32_t shapes[][3] = {
+        {1, 64, 10}, {16, 27, 8}, {49, 72, 16}, {25, 144, 32}, {10, 50, 7}, {64, 64, 64}
+    };
+    GemmS8 gemmGen(globalBuffer, 4096);
+    SEGGER_RTT_printf(0, "--- START TEST S8 ---\n");
+    SEGGER_RTT_printf(0, "Test;M;K;N;Quantization;Time;Iterations;Correct\n");
+    for (auto const & shape : shapes) {
+        uint32_t m = shape[0], k = shape[1], n = shape[2];
+        int32_t * bias = reinterpret_cast<int32_t *>(bigCRef + m * n);
+        int32_t * multipliers = bias + n;
+        int32_t * shifts = multipliers + n;
+        int32_t * kernelSums = shifts + n;
+        for (uint32_t i = 0; i < m*k; i++) a[i] = static_cast<int8_t>((i * 7) % 256 - 128);
+        for (uint32_t i = 0; i < k*n; i++) b[i] = static_cast<int8_t>((i * 13) % 251 - 125);
+        for (uint32_t j = 0; j < n; j++) {
+            bias[j] = static_cast<int32_t>(j * 97) - 1000;
+            multipliers[j] = 1073741824 + static_cast<int32_t>(j * 12345678);
+            shifts[j] = -static_cast<int32_t>(8 + j % 4);
+        }
+        constexpr int32_t inputOffset = 128;
+        GemmS8::computeKernelSums(b, k, n, k, bias, inputOffset, kernelSums);
+
+        for (uint32_t perChannel = 0; perChannel < 2; perChannel++) {
+            GemmS8::Requantization requantization = {};
+            requantization.bias = bias;
+            requantization.multipliers = perChannel ? multipliers : nullptr;
+            requantization.shifts = perChannel ? shifts : nullptr;
+            requantization.multiplier = multipliers[0];
+            requantization.shift = shifts[0];
+            requantization.outputOffset = -3;
+            requantization.activationMin = -128;
+            requantization.activationMax = 127;
+            gemm_reference_s8(a, b, cRef, m, k, n, k, k, n, inputOffset, requantization);
+            // the kernel gets the bias with the folded input offset
+            requantization.bias = kernelSums;
+            auto gemmFunc = gemmGen.generate(m, k, n, k, k, n, requantization);
+            gemmFunc(a, b, c);
+            bool correct = true;
+            for (uint32_t i = 0; i < m*n; i++) {
+                if (c[i] != cRef[i]) {
+                    correct = false;
+                    break;
+                }
+            }
+
+            auto start = RTC_Clock::now();
+            for (uint32_t it = 0; it < iterations; it++) {
+                gemmFunc(a, b, c);
+            }
+            auto end = RTC_Clock::now();
+            int32_t time = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+            sprintf(PRINTF_OUT_STRING, "S8;%d;%d;%d;%s;%d;%d;%d\r\n", m, k, n, perChannel ? "Channel" : "Tensor", time, iterations, correct);
+            SEGGER_RTT_WriteString(0, PRINTF_OUT_STRING);
+        }
+    }
+    SEGGER_RTT_printf(0, "--- END TEST S8 ---\n\n");
+}
+
+void testBlocked(
+    float * aSram0, float * bSram0, float * cSram0, float * cRefSram0,
+    JIT::Instructions::Instruction16 * codeRegion, uint32_t regionSize,
+    JIT::Instructions::Instruction16 * stagingBuffer,
+    float * scratch, uint32_t scratchSize, uint32_t maxSize) {
+    JIT::Generators::Gemm gemmGen(stagingBuffer, 3072, programStorage, sizeof(programStorage));
+    JIT::Generators::GemmCache cache(gemmGen, codeRegion, regionSize);
+    JIT::Generators::GemmBlocked blocked(cache, scratch, scratchSize);
+    int32_t time;
+    double gflops;
+    SEGGER_RTT_printf(0, "--- START TEST BLOCKED ---\n");
+    SEGGER_RTT_printf(0, "Test;M;K;N;Type;MC;KC;NC;GFLOPS;Time;Iterations;Correct\n");
+    for (uint32_t i = 8; i <= maxSize; i += 8) {
+        uint32_t m = i, n = i, k = i;
+        uint32_t flops = 2 * m * k * n;
+        uint32_t iterations = (peak * pow(10, 9)) / flops / 4;
+        iterations = iterations == 0 ? 1 : iterations;
+
+        // unblocked kernel streaming directly from SRAM0
+        auto gemmFunc = gemmGen.generate(m, k, n, m, k, m);
+        initMatrices(aSram0, bSram0, cSram0, cRefSram0, m, n, k);
+        gemmFunc(aSram0, bSram0, cSram0);
+        gemm_reference_column_major(aSram0, bSram0, cRefSram0, n, k, m, m, k, m);
+        bool correct = compare(cSram0, cRefSram0, m*n) == -1;
+        auto start = RTC_Clock::now();
+        for (uint32_t it = 0; it < iterations; it++) {
+            gemmFunc(aSram0, bSram0, cSram0);
+        }
+        auto end = RTC_Clock::now();
+        time = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+        gflops = static_cast<float>(flops) / (time/1000.0f * pow(10, 9)) * iterations;
+        sprintf(PRINTF_OUT_STRING, "Blocked;%d;%d;%d;Unblocked;%d;%d;%d;%f;%d;%d;%d\r\n", m, k, n, m, k, n, gflops, time, iterations, correct);
+        SEGGER_RTT_WriteString(0, PRINTF_OUT_STRING);
+
+        // panels packed into the scratch area, includes the packing time
+        auto blocking = JIT::Generators::GemmBlocked::chooseBlocking(m, k, n, scratchSize);
+        initMatrices(aSram0, bSram0, cSram0, cRefSram0, m, n, k);
+        correct = blocked.run(aSram0, bSram0, cSram0, m, k, n, m, k, m);
+        gemm_reference_column_major(aSram0, bSram0, cRefSram0, n, k, m, m, k, m);
+        correct &= compare(cSram0, cRefSram0, m*n) == -1;
+        start = RTC_Clock::now();
+        for (uint32_t it = 0; it < iterations; it++) {
+            blocked.run(aSram0, bSram0, cSram0, m, k, n, m, k, m, blocking);
+        }
+        end = RTC_Clock::now();
+        time = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+        gflops = static_cast<float>(flops) / (time/1000.0f * pow(10, 9)) * iterations;
+        sprintf(PRINTF_OUT_STRING, "Blocked;%d;%d;%d;Packed;%d;%d;%d;%f;%d;%d;%d\r\n", m, k, n, blocking.mc, blocking.kc, blocking.nc, gflops, time, iterations, correct);
+        SEGGER_RTT_WriteString(0, PRINTF_OUT_STRING);
+    }
+    auto const & statistics = cache.getStatistics();
+    sprintf(PRINTF_OUT_STRING, "CacheStatistics;%d;%d;%d\r\n", statistics.hits, statistics.misses, statistics.evictions);
+    SEGGER_RTT_WriteString(0, PRINTF_OUT_STRING);
+    SEGGER_RTT_printf(0, "--- END TEST BLOCKED ---\n\n");
+}
+
+void testPacked(
+    float * bigA, float * bigB, float * bigC, float * bigCRef,
+    float * packedA, float * packedB,
+    JIT::Instructions::Instruction16 * globalBuffer, uint32_t ld, uint32_t iterations) {
+    using Gemm = JIT::Generators::Gemm;
+    using GemmPack = JIT::Generators::GemmPack;
+    // the kernel and both packing routines have to stay in the buffer at the same time
+    Gemm gemmGen(globalBuffer, 4096, programStorage, sizeof(programStorage));
+    GemmPack packAGen(globalBuffer + 4096, 2048);
+    GemmPack packBGen(globalBuffer + 6144, 2048);
+    // lda and ldb are large, so the unpacked kernel can't use immediate offsets for A
+    constexpr uint32_t shapes[][3] = {
+        {8, 8, 3}, {13, 7, 5}, {24, 24, 24}, {21, 17, 11}, {32, 32, 32}, {48, 48, 48}
+    };
+    SEGGER_RTT_printf(0, "--- START TEST PACKED ---\n");
+    SEGGER_RTT_printf(0, "Test;M;K;N;LD;Type;Time;Iterations;Correct\n");
+    for (auto const & shape : shapes) {
+        uint32_t m = shape[0], k = shape[1], n = shape[2];
+        uint32_t lda = ld, ldb = ld, ldc = m;
+        for (uint32_t i = 0; i < lda * k; i++) bigA[i] = static_cast<float>(static_cast<int32_t>(i % 13) - 6);
+        for (uint32_t i = 0; i < ldb * n; i++) bigB[i] = static_cast<float>(static_cast<int32_t>(i % 7) - 3);
+
+        auto gemmFunc = gemmGen.generate(m, k, n, lda, ldb, ldc);
+        for (uint32_t i = 0; i < m*n; i++) bigC[i] = bigCRef[i] = static_cast<float>(i % 11);
+        gemmFunc(bigA, bigB, bigC);
+        gemm_reference_column_major(bigA, bigB, bigCRef, n, k, m, lda, ldb, ldc);
+        bool correct = compare(bigC, bigCRef, m*n) == -1;
+        auto start = RTC_Clock::now();
+        for (uint32_t it = 0; it < iterations; it++) {
+            gemmFunc(bigA, bigB, bigC);
+        }
+        auto end = RTC_Clock::now();
+        int32_t time = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+        sprintf(PRINTF_OUT_STRING, "Packed;%d;%d;%d;%d;Strided;%d;%d;%d\r\n", m, k, n, ld, time, iterations, correct);
+        SEGGER_RTT_WriteString(0, PRINTF_OUT_STRING);
+
+        auto packA = packAGen.generatePackA(m, k, lda);
+        auto packB = packBGen.generatePackB(k, n, ldb);
+        auto packedFunc = gemmGen.generate(m, k, n, lda, ldb, ldc, false, 1.0f, 1.0f, Gemm::PACKED);
+        for (uint32_t i = 0; i < m*n; i++) bigC[i] = bigCRef[i] = static_cast<float>(i % 11);
+        packA(bigA, packedA);
+        packB(bigB, packedB);
+        packedFunc(packedA, packedB, bigC);
+        gemm_reference_column_major(bigA, bigB, bigCRef, n, k, m, lda, ldb, ldc);
+        correct = compare(bigC, bigCRef, m*n) == -1;
+        // packing and kernel
+        start = RTC_Clock::now();
+        for (uint32_t it = 0; it < iterations; it++) {
+            packA(bigA, packedA);
+            packB(bigB, packedB);
+            packedFunc(packedA, packedB, bigC);
+        }
+        end = RTC_Clock::now();
+        time = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+        sprintf(PRINTF_OUT_STRING, "Packed;%d;%d;%d;%d;PackAndKernel;%d;%d;%d\r\n", m, k, n, ld, time, iterations, correct);
+        SEGGER_RTT_WriteString(0, PRINTF_OUT_STRING);
+        // kernel only (operands reused, e.g. weights which are packed once)
+        start = RTC_Clock::now();
+        for (uint32_t it = 0; it < iterations; it++) {
+            packedFunc(packedA, packedB, bigC);
+        }
+        end = RTC_Clock::now();
+        time = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+        sprintf(PRINTF_OUT_STRING, "Packed;%d;%d;%d;%d;Kernel;%d;%d;%d\r\n", m, k, n, ld, time, iterations, correct);
+        SEGGER_RTT_WriteString(0, PRINTF_OUT_STRING);
+    }
+    SEGGER_RTT_printf(0, "--- END TEST PACKED ---\n\n");
+}
+
+static void applyEpilogue(float * c, uint32_t m, uint32_t n, uint32_t ldc, JIT::Generators::Gemm::Epilogue const & epilogue) {
+    using Epilogue = JIT::Generators::Gemm::Epilogue;
+    float const lower = epilogue.activation == Epilogue::ACTIVATION_CLAMP ? epilogue.clampMin : 0.0f;
+    float const upper = epilogue.activation == Epilogue::ACTIVATION_RELU6 ? 6.0f : epilogue.clampMax;
+    for (uint32_t j = 0; j < n; j++) {
+        for (uint32_t i = 0; i < m; i++) {
+            float value = c[j * ldc + i];
+            if (epilogue.bias == Epilogue::BIAS_PER_ROW) value += epilogue.biasValues[i];
+            if (epilogue.bias == Epilogue::BIAS_PER_COLUMN) value += epilogue.biasValues[j];
+            if (epilogue.activation != Epilogue::ACTIVATION_NONE && value < lower) value = lower;
+            if ((epilogue.activation == Epilogue::ACTIVATION_RELU6 || epilogue.activation == Epilogue::ACTIVATION_CLAMP) && value > upper) value = upper;
+            c[j * ldc + i] = value;
+        }
+    }
+}
+
+void testEpilogue(
+    float * bigA, float * bigB, float * bigC, float * bigCRef,
+    JIT::Instructions::Instruction16 * globalBuffer, uint32_t iterations) {
+    using Gemm = JIT::Generators::Gemm;
+    using Epilogue = Gemm::Epilogue;
+    static float bias[64];
+    for (uint32_t i = 0; i < 64; i++) bias[i] = static_cast<float>(static_cast<int32_t>(i % 9) - 4) * 1.5f;
+    // full and partial 8x3 microkernels
+    constexpr uint32_t shapes[][3] = {
+        {8, 8, 3}, {13, 7, 5}, {24, 24, 24}, {21, 17, 11}, {32, 32, 32}, {48, 48, 48}
+    };
+    Epilogue const epilogues[] = {
+        {Epilogue::BIAS_PER_ROW, bias, Epilogue::ACTIVATION_RELU, 0.0f, 0.0f},
+        {Epilogue::BIAS_PER_COLUMN, bias, Epilogue::ACTIVATION_NONE, 0.0f, 0.0f},
+        {Epilogue::BIAS_NONE, nullptr, Epilogue::ACTIVATION_RELU6, 0.0f, 0.0f},
+        {Epilogue::BIAS_PER_ROW, bias, Epilogue::ACTIVATION_CLAMP, -20.0f, 20.0f}
+    };
+    constexpr char const * epilogueNames[] = {"RowBiasReLU", "ColumnBias", "ReLU6", "RowBiasClamp"};
+    Gemm gemmGen(globalBuffer, 4096, programStorage, sizeof(programStorage));
+    Gemm fusedGen(globalBuffer + 4096, 4096, programStorage, sizeof(programStorage));
+    SEGGER_RTT_printf(0, "--- START TEST EPILOGUE ---\n");
+    SEGGER_RTT_printf(0, "Test;M;K;N;Epilogue;Type;Time;Iterations;Correct\n");
+    for (auto const & shape : shapes) {
+        uint32_t m = shape[0], k = shape[1], n = shape[2];
+        for (uint32_t i = 0; i < m * k; i++) bigA[i] = static_cast<float>(static_cast<int32_t>(i % 13) - 6);
+        for (uint32_t i = 0; i < k * n; i++) bigB[i] = static_cast<float>(static_cast<int32_t>(i % 7) - 3);
+        auto gemmFunc = gemmGen.generate(m, k, n, m, k, m);
+        for (uint32_t e = 0; e < sizeof(epilogues) / sizeof(epilogues[0]); e++) {
+            Epilogue const & epilogue = epilogues[e];
+            auto fusedFunc = fusedGen.generate(m, k, n, m, k, m, false, 1.0f, 1.0f, Gemm::COLUMN_MAJOR_NN, epilogue);
+            for (uint32_t i = 0; i < m*n; i++) bigC[i] = bigCRef[i] = static_cast<float>(i % 11);
+            fusedFunc(bigA, bigB, bigC);
+            gemm_reference_column_major(bigA, bigB, bigCRef, n, k, m, m, k, m);
+            applyEpilogue(bigCRef, m, n, m, epilogue);
+            bool correct = compare(bigC, bigCRef, m*n) == -1;
+
+            // kernel followed by a separate pass over C
+            auto start = RTC_Clock::now();
+            for (uint32_t it = 0; it < iterations; it++) {
+                gemmFunc(bigA, bigB, bigC);
+                applyEpilogue(bigC, m, n, m, epilogue);
+            }
+            auto end = RTC_Clock::now();
+            int32_t time = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+            sprintf(PRINTF_OUT_STRING, "Epilogue;%d;%d;%d;%s;Separate;%d;%d;%d\r\n", m, k, n, epilogueNames[e], time, iterations, correct);
+            SEGGER_RTT_WriteString(0, PRINTF_OUT_STRING);
+
+            start = RTC_Clock::now();
+            for (uint32_t it = 0; it < iterations; it++) {
+                fusedFunc(bigA, bigB, bigC);
+            }
+            end = RTC_Clock::now();
+            time = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+            sprintf(PRINTF_OUT_STRING, "Epilogue;%d;%d;%d;%s;Fused;%d;%d;%d\r\n", m, k, n, epilogueNames[e], time, iterations, correct);
+            SEGGER_RTT_WriteString(0, PRINTF_OUT_STRING);
+        }
+    }
+    SEGGER_RTT_printf(0, "--- END TEST EPILOGUE ---\n\n");
+}
+
+void testBatched(
+    float * bigA, float * bigB, float * bigC, float * bigCRef,
+    JIT::Instructions::Instruction16 * globalBuffer, uint32_t iterations) {
+    using Gemm = JIT::Generators::Gemm;
+    // small shapes where the prologue is a large part of a single call
+    constexpr uint32_t shapes[][3] = {
+        {4, 4, 4}, {8, 8, 3}, {8, 16, 8}, {13, 7, 5}, {16, 16, 16}
+    };
+    constexpr uint32_t batch = 8;
+    Gemm gemmGen(globalBuffer, 4096, programStorage, sizeof(programStorage));
+    Gemm batchedGen(globalBuffer + 4096, 4096, programStorage, sizeof(programStorage));
+    SEGGER_RTT_printf(0, "--- START TEST BATCHED ---\n");
+    SEGGER_RTT_printf(0, "Test;M;K;N;Batch;Type;Time;Iterations;Correct\n");
+    for (auto const & shape : shapes) {
+        uint32_t m = shape[0], k = shape[1], n = shape[2];
+        // C is padded by a vector, the NN kernels store whole vectors at the M edges
+        uint32_t strideA = m * k, strideB = k * n, strideC = m * n + 4;
+        for (uint32_t i = 0; i < batch * strideA; i++) bigA[i] = static_cast<float>(static_cast<int32_t>(i % 13) - 6);
+        for (uint32_t i = 0; i < batch * strideB; i++) bigB[i] = static_cast<float>(static_cast<int32_t>(i % 7) - 3);
+        for (uint32_t i = 0; i < batch * strideC; i++) bigC[i] = bigCRef[i] = static_cast<float>(i % 11);
+
+        auto gemmFunc = gemmGen.generate(m, k, n, m, k, m);
+        auto batchedFunc = batchedGen.generateBatched(m, k, n, m, k, m, batch, strideA, strideB, strideC);
+        batchedFunc(bigA, bigB, bigC);
+        bool correct = true;
+        for (uint32_t b = 0; b < batch; b++) {
+            gemm_reference_column_major(bigA + b * strideA, bigB + b * strideB, bigCRef + b * strideC, n, k, m, m, k, m);
+            correct = correct && compare(bigC + b * strideC, bigCRef + b * strideC, m*n) == -1;
+        }
+
+        auto start = RTC_Clock::now();
+        for (uint32_t it = 0; it < iterations; it++) {
+            for (uint32_t b = 0; b < batch; b++) {
+                gemmFunc(bigA + b * strideA, bigB + b * strideB, bigC + b * strideC);
+            }
+        }
+        auto end = RTC_Clock::now();
+        int32_t time = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+        sprintf(PRINTF_OUT_STRING, "Batched;%d;%d;%d;%d;Calls;%d;%d;%d\r\n", m, k, n, batch, time, iterations, correct);
+        SEGGER_RTT_WriteString(0, PRINTF_OUT_STRING);
+
+        start = RTC_Clock::now();
+        for (uint32_t it = 0; it < iterations; it++) {
+            batchedFunc(bigA, bigB, bigC);
+        }
+        end = RTC_Clock::now();
+        time = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+        sprintf(PRINTF_OUT_STRING, "Batched;%d;%d;%d;%d;Batched;%d;%d;%d\r\n", m, k, n, batch, time, iterations, correct);
+        SEGGER_RTT_WriteString(0, PRINTF_OUT_STRING);
+    }
+    SEGGER_RTT_printf(0, "--- END TEST BATCHED ---\n\n");
+}
+
+void testTuning(
+    float * bigA, float * bigB, float * bigC, float * bigCRef,
+    JIT::Instructions::Instruction16 * globalBuffer, uint32_t iterations) {
+    using Gemm = JIT::Generators::Gemm;
+    // shapes where the 4x6 tail and the unrolling limits of the heuristics apply
+    constexpr uint32_t shapes[][3] = {
+        {12, 12, 12}, {20, 10, 12}, {24, 24, 24}, {28, 16, 18}, {36, 36, 36}, {48, 48, 48}
+    };
+    static JIT::Generators::GemmTuningTable table;
+    Gemm gemmGen(globalBuffer, 8192, programStorage, sizeof(programStorage));
+    JIT::Generators::GemmTuner tuner(gemmGen, 8192, table);
+    SEGGER_RTT_printf(0, "--- START TEST TUNING ---\n");
+    SEGGER_RTT_printf(0, "Test;M;K;N;DefaultCycles;TunedCycles;Candidates;Use46;KUnroll;MUnroll;NUnroll;PredicatedEdges;Correct\n");
+    for (auto const & shape : shapes) {
+        uint32_t m = shape[0], k = shape[1], n = shape[2];
+        initMatrices(bigA, bigB, bigC, bigCRef, m, n, k);
+        Gemm::Tuning tuning = tuner.tune(bigA, bigB, bigC, m, k, n, m, k, m, Gemm::COLUMN_MAJOR_NN, iterations);
+
+        // generate() picks up the measured parameters
+        gemmGen.setTuningTable(&table);
+        auto gemmFunc = gemmGen.generate(m, k, n, m, k, m);
+        gemmGen.setTuningTable(nullptr);
+        initMatrices(bigA, bigB, bigC, bigCRef, m, n, k);
+        gemmFunc(bigA, bigB, bigC);
+        gemm_reference_column_major(bigA, bigB, bigCRef, n, k, m, m, k, m);
+        bool correct = compare(bigC, bigCRef, m*n) == -1;
+        sprintf(PRINTF_OUT_STRING, "Tuning;%d;%d;%d;%d;%d;%d;%d;%d;%d;%d;%d;%d\r\n", m, k, n, tuner.getDefaultCycles(), tuner.getBestCycles(), tuner.getCandidateCount(),
+            tuning.use46Microkernel, tuning.kMaxUnroll, tuning.mMaxUnroll, tuning.nMaxUnroll, tuning.predicatedEdges, correct);
+        SEGGER_RTT_WriteString(0, PRINTF_OUT_STRING);
+    }
+    // the table as initializer of GemmTuningTable::Entry[], to be compiled into the application
+    table.print();
+    SEGGER_RTT_printf(0, "--- END TEST TUNING ---\n\n");
+}
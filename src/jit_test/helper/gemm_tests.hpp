@@ -3,11 +3,21 @@
 
 #include <cstdint>
 #include "../generators/Gemm.hpp"
+#include "../generators/GemmCache.hpp"
+#include "../generators/GemmBlocked.hpp"
+#include "../generators/GemmPack.hpp"
+#include "../generators/GemmTuner.hpp"
+#include "../generators/GemmTuningTable.hpp"
+#include "../generators/GemmF16.hpp"
+#include "../generators/GemmS8.hpp"
 
 void initMatrices(float * a, float * b, float * c, float * cref, const uint32_t m, const uint32_t n, const uint32_t k, bool zeroC = false, bool useFloat = true);
 int32_t testShapeGenerateTime(
     float * bigA, float * bigB, float * bigC, float * bigCRef,
     uint32_t m, uint32_t n, uint32_t k, uint32_t iterations, JIT::Generators::Gemm & generator);
+int32_t testShapeCachedGenerateTime(
+    float * bigA, float * bigB, float * bigC, float * bigCRef,
+    uint32_t m, uint32_t n, uint32_t k, uint32_t iterations, JIT::Generators::GemmCache & cache);
 int32_t testShape(
     float * bigA, float * bigB, float * bigC, float * bigCRef,
     uint32_t m, uint32_t n, uint32_t k, uint32_t iterations, JIT::Generators::Gemm & generator);
@@ -45,4 +55,42 @@ void testAllSizes(
     JIT::Instructions::Instruction16 * globalBuffer,
     bool testArm, bool testJitter, bool testIntrinsics, bool testReference,
     uint32_t start, uint32_t end, uint32_t resume = 1, bool validate = false);
+void testPredicatedEdges(
+    float * bigA, float * bigB, float * bigC, float * bigCRef,
+    JIT::Instructions::Instruction16 * globalBuffer,
+    uint32_t start, uint32_t end);
+void testKernelCache(
+    float * bigA, float * bigB, float * bigC, float * bigCRef,
+    JIT::Instructions::Instruction16 * codeRegion, uint32_t regionSize,
+    JIT::Instructions::Instruction16 * stagingBuffer, uint32_t rounds = 10);
+void testAlphaBeta(
+    float * bigA, float * bigB, float * bigC, float * bigCRef,
+    JIT::Instructions::Instruction16 * globalBuffer);
+void testLayouts(
+    float * bigA, float * bigB, float * bigC, float * bigCRef,
+    JIT::Instructions::Instruction16 * globalBuffer, uint32_t iterations = 100);
+void testF16(
+    float * bigA, float * bigB, float * bigC, float * bigCRef,
+    JIT::Instructions::Instruction16 * globalBuffer, uint32_t iterations = 100);
+void testS8(
+    float * bigA, float * bigB, float * bigC, float * bigCRef,
+    JIT::Instructions::Instruction16 * globalBuffer, uint32_t iterations = 100);
+void testBlocked(
+    float * aSram0, float * bSram0, float * cSram0, float * cRefSram0,
+    JIT::Instructions::Instruction16 * codeRegion, uint32_t regionSize,
+    JIT::Instructions::Instruction16 * stagingBuffer,
+    float * scratch, uint32_t scratchSize, uint32_t maxSize);
+void testPacked(
+    float * bigA, float * bigB, float * bigC, float * bigCRef,
+    float * packedA, float * packedB,
+    JIT::Instructions::Instruction16 * globalBuffer, uint32_t ld, uint32_t iterations = 100);
+void testEpilogue(
+    float * bigA, float * bigB, float * bigC, float * bigCRef,
+    JIT::Instructions::Instruction16 * globalBuffer, uint32_t iterations = 100);
+void testBatched(
+    float * bigA, float * bigB, float * bigC, float * bigCRef,
+    JIT::Instructions::Instruction16 * globalBuffer, uint32_t iterations = 100);
+void testTuning(
+    float * bigA, float * bigB, float * bigC, float * bigCRef,
+    JIT::Instructions::Instruction16 * globalBuffer, uint32_t iterations = 10);
 #endif // GEMM_TESTS_HPP
\ No newline at end of file
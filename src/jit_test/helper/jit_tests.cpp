@@ -3,12 +3,18 @@
 #include "instructions/Base.hpp"
 #include "timing.hpp"
 #include "SEGGER_RTT.h"
+#include "../backend/CodeMemory.hpp"
 #include "../generators/PeakPerformance.hpp"
 #include "../generators/Throughput.hpp"
 
 static char PRINTF_OUT_STRING[256] __attribute__((used, section(".bss.array_region_sram0")));
+static constexpr uint32_t STAGING_SIZE = 1024;
+static JIT::Instructions::Instruction16 stagingBuffer[STAGING_SIZE] __attribute__((aligned(4)));
 
-void testPeakPerformance(JIT::Instructions::Instruction16 * globalBuffer, JIT::Instructions::Instruction16 * globalBufferSram0, JIT::Instructions::Instruction16 * globalBufferDtcm, uint32_t arrayMaxSize) {
+/*
+The same kernel is benchmarked in all code regions: it is generated once into a staging buffer and moved through the regions.
+*/
+void testPeakPerformance(JIT::Instructions::Instruction16 * globalBuffer, JIT::Instructions::Instruction16 * globalBufferSram0, JIT::Instructions::Instruction16 * globalBufferDtcm, uint32_t bufferSize, uint32_t arrayMaxSize) {
     uint32_t oi = 1;
     uint32_t iterations = 100;
     auto start = CYCCNT_Clock::now();
@@ -16,37 +22,27 @@ void testPeakPerformance(JIT::Instructions::Instruction16 * globalBuffer, JIT::I
 	uint32_t flops = (oi * 8 * 4 * arrayMaxSize * 10000);
 	uint32_t time;
 	double gflops;
-    JIT::Generators::PeakPerformance gen(globalBuffer, 10000);
-    JIT::Generators::PeakPerformance::Func genFunc = gen.generate(oi);
-    // genFunc = gen.bufferToFunc(globalBuffer);
-	start = CYCCNT_Clock::now();
-    for (uint32_t i = 0; i < iterations; i++) genFunc(arrayMaxSize * 10000);
-	end = CYCCNT_Clock::now();
-    time = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-	gflops = static_cast<float>(flops) / (time/1000000.0f * pow(10, 9)) * iterations;
-	sprintf(PRINTF_OUT_STRING, "PeakJIT ITCM;%d;%f\r\n", time, gflops);
-	SEGGER_RTT_WriteString(0, PRINTF_OUT_STRING);
 
-    JIT::Generators::PeakPerformance gen2(globalBufferSram0, 100000);
-    genFunc = gen2.generate(oi);
-	start = CYCCNT_Clock::now();
-    for (uint32_t i = 0; i < iterations; i++) genFunc(arrayMaxSize * 10000);
-	end = CYCCNT_Clock::now();
-    time = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-	gflops = static_cast<float>(flops) / (time/1000000.0f * pow(10, 9)) * iterations;
-	sprintf(PRINTF_OUT_STRING, "PeakJIT SRAM0;%d;%f\r\n", time, gflops);
-	SEGGER_RTT_WriteString(0, PRINTF_OUT_STRING);
+    JIT::CodeMemory codeMemory;
+    codeMemory.addRegion(JIT::CodeMemory::ITCM, globalBuffer, bufferSize);
+    codeMemory.addRegion(JIT::CodeMemory::DTCM, globalBufferDtcm, bufferSize);
+    codeMemory.addRegion(JIT::CodeMemory::SRAM0, globalBufferSram0, bufferSize);
+    JIT::Generators::PeakPerformance gen(stagingBuffer, STAGING_SIZE);
+    gen.generate(oi);
+    JIT::CodeMemory::Handle kernel = codeMemory.add(stagingBuffer, gen.getInstructionCount());
+    if (kernel == JIT::CodeMemory::NONE) return;
 
-    JIT::Generators::PeakPerformance gen3(globalBufferDtcm, 10000);
-    genFunc = gen3.generate(oi);
-    // genFunc = gen.bufferToFunc(globalBuffer);
-	start = CYCCNT_Clock::now();
-    for (uint32_t i = 0; i < iterations; i++) genFunc(arrayMaxSize * 10000);
-	end = CYCCNT_Clock::now();
-    time = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-	gflops = static_cast<float>(flops) / (time/1000000.0f * pow(10, 9)) * iterations;
-	sprintf(PRINTF_OUT_STRING, "PeakJIT DTCM;%d;%f\r\n", time, gflops);
-	SEGGER_RTT_WriteString(0, PRINTF_OUT_STRING);
+    for (JIT::CodeMemory::Region region : {JIT::CodeMemory::ITCM, JIT::CodeMemory::SRAM0, JIT::CodeMemory::DTCM}) {
+        if (!codeMemory.move(kernel, region)) continue;
+        JIT::Generators::PeakPerformance::Func genFunc = codeMemory.get<JIT::Generators::PeakPerformance::Func>(kernel);
+        start = CYCCNT_Clock::now();
+        for (uint32_t i = 0; i < iterations; i++) genFunc(arrayMaxSize * 10000);
+        end = CYCCNT_Clock::now();
+        time = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+        gflops = static_cast<float>(flops) / (time/1000000.0f * pow(10, 9)) * iterations;
+        sprintf(PRINTF_OUT_STRING, "PeakJIT %s;%d;%f\r\n", JIT::CodeMemory::regionName(region), time, gflops);
+        SEGGER_RTT_WriteString(0, PRINTF_OUT_STRING);
+    }
 }
 
 void testThroughput(JIT::Instructions::Instruction16 * globalBuffer, JIT::Instructions::Instruction16 * globalBufferSram0, JIT::Instructions::Instruction16 * globalBufferDtcm, uint32_t arrayMaxSize, float * bigA) {
@@ -3,7 +3,7 @@
 #include <cstdint>
 #include "../backend/Backend.hpp"
 
-void testPeakPerformance(JIT::Instructions::Instruction16 * globalBuffer, JIT::Instructions::Instruction16 * globalBufferSram0, JIT::Instructions::Instruction16 * globalBufferDtcm, uint32_t arrayMaxSize);
+void testPeakPerformance(JIT::Instructions::Instruction16 * globalBuffer, JIT::Instructions::Instruction16 * globalBufferSram0, JIT::Instructions::Instruction16 * globalBufferDtcm, uint32_t bufferSize, uint32_t arrayMaxSize);
 void testThroughput(JIT::Instructions::Instruction16 * globalBuffer, JIT::Instructions::Instruction16 * globalBufferSram0, JIT::Instructions::Instruction16 * globalBufferDtcm, uint32_t arrayMaxSize, float * bigA);
 
 #endif // JIT_TESTS_HPP
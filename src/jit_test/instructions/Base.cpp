@@ -60,6 +60,25 @@ Instruction32 Base::le(int16_t imm11) {
     return instr;
 }
 
+// imm32 = ZeroExtend(immh:imml:'0', 32), same layout as LE
+Instruction32 Base::wls(Register Rn, uint16_t imm11) {
+    if (imm11 > 4094 || imm11 % 2 != 0) {
+        Base::printValidationError("wls: imm11 must be even and in range [0, 4094] - returning nop");
+        return Base::nop32();
+    }
+    Instruction32 instr = 0xf040'c001;
+    instr |= Rn << 16;
+    instr |= (0x1 & (imm11 >> 1)) << 11; // set imml
+    instr |= 0x7fe & (imm11 >> 1); // set immh
+    return instr;
+}
+
+Instruction32 Base::wlstp(Register Rn, Size size, uint16_t imm11) {
+    Instruction32 const instr = wls(Rn, imm11);
+    if (instr == Base::nop32()) return instr;
+    return (instr & ~(0x7 << 20)) | size << 20;
+}
+
 Instruction16 Base::cmpImmediate16(Register Rn, uint8_t imm8) {
     Instruction16 instr = 0x2800;
     instr |= imm8;
@@ -131,6 +150,25 @@ Instruction16 Base::b16(int16_t imm11) {
     return instr;
 }
 
+// imm32 = i:imm5:'0'
+Instruction16 Base::cbz(Register Rn, uint8_t imm6) {
+    if (!assertLowRegister(Rn) || imm6 > 126 || imm6 % 2 != 0) {
+        Base::printValidationError("cbz: needs a low register and an even imm6 in range [0, 126] - returning nop");
+        return Base::nop16();
+    }
+    Instruction16 instr = 0xb100;
+    instr |= Rn;
+    instr |= (0x1f & (imm6 >> 1)) << 3; // set imm5
+    instr |= (imm6 >> 6) << 9; // set i
+    return instr;
+}
+
+Instruction16 Base::cbnz(Register Rn, uint8_t imm6) {
+    Instruction16 const instr = cbz(Rn, imm6);
+    if (instr == Base::nop16()) return instr;
+    return instr | 1 << 11; // set op
+}
+
 // imm32 = S:J2:J1:imm6:imm11:0
 Instruction32 Base::bCond32(Condition cond, int32_t label) {
     if (cond == AL) {
@@ -147,9 +185,22 @@ Instruction32 Base::bCond32(Condition cond, int32_t label) {
     return instr;
 }
 
-// imm32 = S:I2:I1:imm10:imm11:0
-Instruction32 Base::b32(uint32_t label) {
-    return Base::nop32();
+// imm32 = S:I1:I2:imm10:imm11:0, I1 = NOT(J1 EOR S), I2 = NOT(J2 EOR S)
+Instruction32 Base::b32(int32_t label) {
+    if (label > 16777214 || label < -16777216) {
+        Base::printValidationError("b32: label must be in range [-16777216, 16777214] - returning nop");
+        return Base::nop32();
+    }
+    uint32_t const s = (label >> 24) & 0x1;
+    uint32_t const i1 = (label >> 23) & 0x1;
+    uint32_t const i2 = (label >> 22) & 0x1;
+    Instruction32 instr = 0xf000'9000;
+    instr |= s << 26; // set S
+    instr |= (0x3ff & (label >> 12)) << 16; // set imm10
+    instr |= (0x1 & ~(i1 ^ s)) << 13; // set J1
+    instr |= (0x1 & ~(i2 ^ s)) << 11; // set J2
+    instr |= 0x7ff & (label >> 1); // set imm11
+    return instr;
 }
 
 Instruction16 Base::udf(uint8_t imm8) {
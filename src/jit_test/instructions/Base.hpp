@@ -186,6 +186,16 @@ class JIT::Instructions::Base {
          */
         static Instruction32 letp(int16_t imm11);
         static Instruction32 le(int16_t imm1);
+        /**
+         * @brief While Loop Start: branches forward to the end of the loop if Rn is 0, otherwise LR = Rn
+         * @param imm11 Offset to the first instruction after the loop, the instruction size (4 bytes) has to be subtracted. Range [0, 4094]
+         * @see C2.4.445, Encoding T4
+         */
+        static Instruction32 wls(Register Rn, uint16_t imm11);
+        /**
+         * @brief While Loop Start with Tail Predication, see wls and dlstp
+         */
+        static Instruction32 wlstp(Register Rn, Size size, uint16_t imm11);
 
 
         /**
@@ -261,8 +271,17 @@ class JIT::Instructions::Base {
          */
         static Instruction16 bCond16(Condition cond, int16_t imm8);
         static Instruction16 b16(int16_t imm11);
+        /**
+         * @brief Compare and Branch on Zero: forward branch if Rn is 0, the flags are not changed
+         * @param Rn Low register
+         * @param imm6 Offset (PC + 4), range [0, 126]
+         * @see C2.4.31, Encoding T1
+         */
+        static Instruction16 cbz(Register Rn, uint8_t imm6);
+        /// @brief Compare and Branch on Nonzero, see cbz
+        static Instruction16 cbnz(Register Rn, uint8_t imm6);
         static Instruction32 bCond32(Condition cond, int32_t label);
-        static Instruction32 b32(uint32_t label);
+        static Instruction32 b32(int32_t label);
 
         /**
          * @brief Generates UDF (Undefined Instruction)
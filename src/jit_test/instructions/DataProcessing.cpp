@@ -99,6 +99,41 @@ Instruction32 DataProcessing::ldrRegister32(Register Rt, Register Rn, Register R
     return instr;
 }
 
+Instruction16 DataProcessing::ldrLiteral16(Register Rt, uint16_t imm) {
+    if (!Base::assertLowRegister(Rt) || imm > 1020 || imm % 4 != 0) {
+        Base::printValidationError("ldrLiteral16: needs a low register and imm <= 1020 (multiple of 4) - returning nop");
+        return Base::nop16();
+    }
+    Instruction16 instr = 0x4800;
+    instr |= Rt << 8U;
+    instr |= imm >> 2U; // imm32 = imm8:'00'
+    return instr;
+}
+
+Instruction32 DataProcessing::ldrLiteral32(Register Rt, int16_t imm) {
+    if (imm > 4095 || imm < -4095) {
+        Base::printValidationError("ldrLiteral32: imm must be in range [-4095, 4095] - returning nop");
+        return Base::nop32();
+    }
+    Instruction32 instr = 0xf85f'0000;
+    if (imm >= 0) instr |= 1U << 23U; // set U (add)
+    instr |= Rt << 12U;
+    instr |= imm >= 0 ? imm : -imm; // set imm12
+    return instr;
+}
+
+Instruction32 DataProcessing::ldrhImmediate32(Register Rt, Register Rn, int16_t imm, bool preIndexed, bool writeBack) {
+    Instruction32 instr = ldrImmediate32(Rt, Rn, imm, preIndexed, writeBack);
+    if (instr == Base::nop32()) return instr;
+    return (instr & ~(0b11 << 21U)) | (0b01 << 21U); // size = halfword instead of word
+}
+
+Instruction32 DataProcessing::ldrhRegister32(Register Rt, Register Rn, Register Rm, uint8_t imm2) {
+    Instruction32 instr = ldrRegister32(Rt, Rn, Rm, imm2);
+    if (instr == Base::nop32()) return instr;
+    return (instr & ~(0b11 << 21U)) | (0b01 << 21U); // size = halfword instead of word
+}
+
 // Low Reg Variant
 Instruction16 DataProcessing::str(Register Rn, Register Rt) {
     Instruction16 instr = 0b0110'0000'0000'0000;
@@ -74,6 +74,28 @@ class JIT::Instructions::DataProcessing {
         */
         static Instruction32 ldrRegister32(Register Rt, Register Rn, Register Rm, uint8_t imm2 = 0);
 
+        /**
+         * @brief LDR (literal): loads the word at Align(PC, 4) + imm, PC is the address of the instruction + 4
+         * @param Rt Target Register (low register)
+         * @param imm Offset, multiple of 4 in [0, 1020]
+         * @see C2.4.79, Encoding T1
+         */
+        static Instruction16 ldrLiteral16(Register Rt, uint16_t imm);
+        /**
+         * @brief LDR (literal) with an offset in [-4095, 4095]
+         * @see C2.4.79, Encoding T2
+         * -- Performance -- (p. 27)
+         * Latency: 2
+         * Throughput: 1
+         */
+        static Instruction32 ldrLiteral32(Register Rt, int16_t imm);
+
+        /**
+         * @brief Loads a halfword and zero extends it (LDRH). Same addressing modes as ldrImmediate32/ldrRegister32
+         */
+        static Instruction32 ldrhImmediate32(Register Rt, Register Rn, int16_t imm = 0, bool preIndexed = true, bool writeBack = false);
+        static Instruction32 ldrhRegister32(Register Rt, Register Rn, Register Rm, uint8_t imm2 = 0);
+
         static Instruction16 str(Register Rn, Register Rt);
 
         /**
@@ -49,6 +49,138 @@ Instruction32 Vector::vstrw(VectorRegister Qd, Register Rn, int16_t imm, bool pr
     return instr;
 }
 
+Instruction32 Vector::vldrh(VectorRegister Qd, Register Rn, int16_t imm, bool preIndexed, bool writeBack) {
+    if (imm > 254 || imm < -254 || (imm & 0x01) != 0) {
+        Base::printValidationError("vldrh/vstrh: immediate must be +-[0, 254] and multiple of 2 - inserting nop");
+        return Base::nop32();
+    }
+    if (!preIndexed && !writeBack) {
+        Base::printValidationError("vldrh/vstrh: post index must write back - setting write back");
+        writeBack = true;
+    }
+    Instruction32 instr = 0xEC10'1E80;
+    instr |= preIndexed << 24U;
+    instr |= writeBack << 21U;
+    if (imm < 0) {
+        imm = -imm;
+    } else {
+        instr |= 1 << 23; // add immediate
+    }
+    instr |= (0xff & imm) >> 1; // VLDRH does << 1
+    instr |= Qd << 13U;
+    instr |= Rn << 16U;
+    return instr;
+}
+
+Instruction32 Vector::vstrh(VectorRegister Qd, Register Rn, int16_t imm, bool preIndexed, bool writeBack) {
+    Instruction32 instr = vldrh(Qd, Rn, imm, preIndexed, writeBack);
+    if (instr == Base::nop32()) return instr;
+    instr &= ~(1 << 20U); // clear load bit
+    return instr;
+}
+
+Instruction32 Vector::vldrhWidening(VectorRegister Qd, Register Rn, int16_t imm, bool preIndexed, bool writeBack) {
+    if (!Base::assertLowRegister(Rn)) {
+        Base::printValidationError("vldrhWidening/vstrhNarrowing: only low registers allowed as Rn - inserting nop");
+        return Base::nop32();
+    }
+    if (imm > 254 || imm < -254 || (imm & 0x01) != 0) {
+        Base::printValidationError("vldrhWidening/vstrhNarrowing: immediate must be +-[0, 254] and multiple of 2 - inserting nop");
+        return Base::nop32();
+    }
+    if (!preIndexed && !writeBack) {
+        Base::printValidationError("vldrhWidening/vstrhNarrowing: post index must write back - setting write back");
+        writeBack = true;
+    }
+    Instruction32 instr = 0xFC18'0F00; // U = 1 (zero extend), size = 32 bit lanes
+    instr |= preIndexed << 24U;
+    instr |= writeBack << 21U;
+    if (imm < 0) {
+        imm = -imm;
+    } else {
+        instr |= 1 << 23; // add immediate
+    }
+    instr |= (0xff & imm) >> 1;
+    instr |= Qd << 13U;
+    instr |= Rn << 16U;
+    return instr;
+}
+
+Instruction32 Vector::vstrhNarrowing(VectorRegister Qd, Register Rn, int16_t imm, bool preIndexed, bool writeBack) {
+    Instruction32 instr = vldrhWidening(Qd, Rn, imm, preIndexed, writeBack);
+    if (instr == Base::nop32()) return instr;
+    instr &= ~((1 << 28U) | (1 << 20U)); // clear U and load bit
+    return instr;
+}
+
+Instruction32 Vector::vldrb(VectorRegister Qd, Register Rn, int16_t imm, bool preIndexed, bool writeBack) {
+    if (imm > 127 || imm < -127) {
+        Base::printValidationError("vldrb/vstrb: immediate must be +-[0, 127] - inserting nop");
+        return Base::nop32();
+    }
+    if (!preIndexed && !writeBack) {
+        Base::printValidationError("vldrb/vstrb: post index must write back - setting write back");
+        writeBack = true;
+    }
+    Instruction32 instr = 0xEC10'1E00;
+    instr |= preIndexed << 24U;
+    instr |= writeBack << 21U;
+    if (imm < 0) {
+        imm = -imm;
+    } else {
+        instr |= 1 << 23; // add immediate
+    }
+    instr |= 0x7f & imm;
+    instr |= Qd << 13U;
+    instr |= Rn << 16U;
+    return instr;
+}
+
+Instruction32 Vector::vstrb(VectorRegister Qd, Register Rn, int16_t imm, bool preIndexed, bool writeBack) {
+    Instruction32 instr = vldrb(Qd, Rn, imm, preIndexed, writeBack);
+    if (instr == Base::nop32()) return instr;
+    instr &= ~(1 << 20U); // clear load bit
+    return instr;
+}
+
+Instruction32 Vector::vstrbNarrowing(VectorRegister Qd, Register Rn, int16_t imm, bool preIndexed, bool writeBack) {
+    if (!Base::assertLowRegister(Rn)) {
+        Base::printValidationError("vstrbNarrowing: only low registers allowed as Rn - inserting nop");
+        return Base::nop32();
+    }
+    if (imm > 127 || imm < -127) {
+        Base::printValidationError("vstrbNarrowing: immediate must be +-[0, 127] - inserting nop");
+        return Base::nop32();
+    }
+    if (!preIndexed && !writeBack) {
+        Base::printValidationError("vstrbNarrowing: post index must write back - setting write back");
+        writeBack = true;
+    }
+    Instruction32 instr = 0xEC00'0F00; // size = 32 bit lanes
+    instr |= preIndexed << 24U;
+    instr |= writeBack << 21U;
+    if (imm < 0) {
+        imm = -imm;
+    } else {
+        instr |= 1 << 23; // add immediate
+    }
+    instr |= 0x7f & imm;
+    instr |= Qd << 13U;
+    instr |= Rn << 16U;
+    return instr;
+}
+
+Instruction32 Vector::vldrwGather(VectorRegister Qd, Register Rn, VectorRegister Qm) {
+    if (Qd == Qm) {
+        Base::printValidationError("vldrwGather: Qd and Qm must be different - inserting nop");
+        return Base::nop32();
+    }
+    Instruction32 instr = 0xFC90'0F41; // U = 1, os = 1 (offsets are scaled by 4)
+    instr |= Rn << 16U;
+    instr |= Qd << 13U;
+    instr |= Qm << 1U;
+    return instr;
+}
 
 JIT::Instructions::Instruction32 JIT::Instructions::Vector::vfmaVectorByScalarPlusVector(VectorRegister Qda, VectorRegister Qn, Register Rm, bool bf16) {
     Instruction32 instr = 0xEE31'0E40;
@@ -72,6 +204,89 @@ Instruction32 Vector::vfma(VectorRegister Qda, VectorRegister Qn, VectorRegister
     return instr;
 }
 
+Instruction32 Vector::vmulVectorByScalar(VectorRegister Qd, VectorRegister Qn, Register Rm, bool bf16) {
+    Instruction32 instr = 0xEE31'0E60;
+
+    instr |= bf16 << 28U; // use bf16 else use float32
+    instr |= Qd << 13U;
+    instr |= Qn << 17U;
+    instr |= Rm;
+
+    return instr;
+}
+
+Instruction32 Vector::vmulIntegerVectorByScalar(VectorRegister Qd, VectorRegister Qn, Register Rm, Size size) {
+    Instruction32 instr = 0xEE01'1E60;
+
+    instr |= size << 20U;
+    instr |= Qd << 13U;
+    instr |= Qn << 17U;
+    instr |= Rm;
+
+    return instr;
+}
+
+Instruction32 Vector::vaddFloat(VectorRegister Qd, VectorRegister Qn, VectorRegister Qm, bool bf16) {
+    Instruction32 instr = 0xEF00'0D40;
+
+    instr |= bf16 << 20U; // use bf16 else use float32
+    instr |= Qn << 17U;
+    instr |= Qd << 13U;
+    instr |= Qm << 1U;
+
+    return instr;
+}
+
+Instruction32 Vector::vaddFloatScalar(VectorRegister Qd, VectorRegister Qn, Register Rm, bool bf16) {
+    Instruction32 instr = 0xEE30'0F40;
+
+    instr |= bf16 << 28U; // use bf16 else use float32
+    instr |= Qn << 17U;
+    instr |= Qd << 13U;
+    instr |= Rm;
+
+    return instr;
+}
+
+Instruction32 Vector::vmaxnm(VectorRegister Qd, VectorRegister Qn, VectorRegister Qm, bool bf16) {
+    Instruction32 instr = 0xFF00'0F50;
+
+    instr |= bf16 << 20U; // use bf16 else use float32
+    instr |= Qn << 17U;
+    instr |= Qd << 13U;
+    instr |= Qm << 1U;
+
+    return instr;
+}
+
+Instruction32 Vector::vminnm(VectorRegister Qd, VectorRegister Qn, VectorRegister Qm, bool bf16) {
+    return vmaxnm(Qd, Qn, Qm, bf16) | 1 << 21U;
+}
+
+Instruction32 Vector::vidup(VectorRegister Qd, Register Rn, uint8_t imm, Size size) {
+    if ((Rn & 0x1) != 0 || size == Size64) {
+        Base::printValidationError("vidup: Rn has to be an even register and size at most 32 bit - inserting nop");
+        return Base::nop32();
+    }
+    uint8_t immEncoded;
+    switch (imm) {
+        case 1: immEncoded = 0b00; break;
+        case 2: immEncoded = 0b01; break;
+        case 4: immEncoded = 0b10; break;
+        case 8: immEncoded = 0b11; break;
+        default:
+            Base::printValidationError("vidup: immediate has to be 1, 2, 4 or 8 - inserting nop");
+            return Base::nop32();
+    }
+    Instruction32 instr = 0xEE01'0F6E;
+    instr |= size << 20U;
+    instr |= (Rn >> 1) << 17U;
+    instr |= Qd << 13U;
+    instr |= (immEncoded >> 1) << 7U;
+    instr |= immEncoded & 0x1;
+    return instr;
+}
+
 /*
 * you have to use an cmode and op combination to generate the immediate
 * an imm64 is generated, which is put into two lanes (when using single precision).
@@ -139,10 +354,171 @@ Instruction32 Vector::vorr(VectorRegister Qd, VectorRegister Qn, VectorRegister
     return instr;
 }
 
+Instruction32 Vector::vand(VectorRegister Qd, VectorRegister Qn, VectorRegister Qm) {
+    return vorr(Qd, Qn, Qm) & ~(1 << 21U); // size = 0b00
+}
+
 Instruction32 Vector::vmovRegister(VectorRegister Qd, VectorRegister Qm) {
     return vorr(Qd, Qm, Qm); // vmov register is alias of vorr
 }
 
+Instruction32 Vector::vcvtb(VectorRegister Qd, VectorRegister Qm, bool toSingle) {
+    Instruction32 instr = 0xEE3F'0E01;
+    instr |= toSingle << 28U;
+    instr |= Qd << 13U;
+    instr |= Qm << 1U;
+    return instr;
+}
+
+Instruction32 Vector::vcvtt(VectorRegister Qd, VectorRegister Qm, bool toSingle) {
+    return vcvtb(Qd, Qm, toSingle) | 1 << 12U; // T = 1
+}
+
+Instruction32 Vector::vmovLanesToGP(Register Rt, Register Rt2, VectorRegister Qd, bool oddLanes) {
+    if (Rt == Rt2 || Rt == SP || Rt == PC || Rt2 == SP || Rt2 == PC) {
+        Base::printValidationError("vmovLanesToGP: Rt and Rt2 must be different and not SP or PC - inserting nop");
+        return Base::nop32();
+    }
+    Instruction32 instr = 0xEC00'0F00;
+    instr |= Rt2 << 16U;
+    instr |= Qd << 13U;
+    instr |= oddLanes << 4U;
+    instr |= Rt;
+    return instr;
+}
+
+Instruction32 Vector::vmovGPToLanes(VectorRegister Qd, Register Rt, Register Rt2, bool oddLanes) {
+    if (Rt == SP || Rt == PC || Rt2 == SP || Rt2 == PC) {
+        Base::printValidationError("vmovGPToLanes: Rt and Rt2 must not be SP or PC - inserting nop");
+        return Base::nop32();
+    }
+    Instruction32 instr = 0xEC10'0F00;
+    instr |= Rt2 << 16U;
+    instr |= Qd << 13U;
+    instr |= oddLanes << 4U;
+    instr |= Rt;
+    return instr;
+}
+
+Instruction32 Vector::vdup(VectorRegister Qd, Register Rt) {
+    Instruction32 instr = 0xEEA0'0B10; // 32 bit
+    instr |= Qd << 17U;
+    instr |= Rt << 12U;
+    return instr;
+}
+
+Instruction32 Vector::vmladav(Register Rda, VectorRegister Qn, VectorRegister Qm, bool accumulate) {
+    if ((Rda & 0x1) != 0) {
+        Base::printValidationError("vmladav: Rda has to be an even register - inserting nop");
+        return Base::nop32();
+    }
+    Instruction32 instr = 0xEEF0'0F00;
+    instr |= Qn << 17U;
+    instr |= Rda << 12U; // Rda<3:1>, bit 12 is always zero for even registers
+    instr |= accumulate << 5U;
+    instr |= Qm << 1U;
+    return instr;
+}
+
+Instruction32 Vector::vadd(VectorRegister Qd, VectorRegister Qn, VectorRegister Qm, Size size) {
+    Instruction32 instr = 0xEF00'0840;
+    instr |= size << 20U;
+    instr |= Qn << 17U;
+    instr |= Qd << 13U;
+    instr |= Qm << 1U;
+    return instr;
+}
+
+Instruction32 Vector::vaddScalar(VectorRegister Qd, VectorRegister Qn, Register Rm, Size size) {
+    Instruction32 instr = 0xEE01'0F40;
+    instr |= size << 20U;
+    instr |= Qn << 17U;
+    instr |= Qd << 13U;
+    instr |= Rm;
+    return instr;
+}
+
+Instruction32 Vector::vsub(VectorRegister Qd, VectorRegister Qn, VectorRegister Qm, Size size) {
+    return vadd(Qd, Qn, Qm, size) | 1 << 28U;
+}
+
+Instruction32 Vector::vmax(VectorRegister Qd, VectorRegister Qn, VectorRegister Qm, Size size) {
+    Instruction32 instr = 0xEF00'0640;
+    instr |= size << 20U;
+    instr |= Qn << 17U;
+    instr |= Qd << 13U;
+    instr |= Qm << 1U;
+    return instr;
+}
+
+Instruction32 Vector::vmin(VectorRegister Qd, VectorRegister Qn, VectorRegister Qm, Size size) {
+    return vmax(Qd, Qn, Qm, size) | 1 << 4U;
+}
+
+Instruction32 Vector::vqadd(VectorRegister Qd, VectorRegister Qn, VectorRegister Qm, Size size) {
+    Instruction32 instr = 0xEF00'0050;
+    instr |= size << 20U;
+    instr |= Qn << 17U;
+    instr |= Qd << 13U;
+    instr |= Qm << 1U;
+    return instr;
+}
+
+Instruction32 Vector::vqrdmulh(VectorRegister Qd, VectorRegister Qn, VectorRegister Qm, Size size) {
+    Instruction32 instr = 0xFF00'0B40;
+    instr |= size << 20U;
+    instr |= Qn << 17U;
+    instr |= Qd << 13U;
+    instr |= Qm << 1U;
+    return instr;
+}
+
+Instruction32 Vector::vshl(VectorRegister Qd, VectorRegister Qm, VectorRegister Qn) {
+    Instruction32 instr = 0xEF20'0440; // S32
+    instr |= Qn << 17U;
+    instr |= Qd << 13U;
+    instr |= Qm << 1U;
+    return instr;
+}
+
+Instruction32 Vector::vrshl(VectorRegister Qd, VectorRegister Qm, VectorRegister Qn) {
+    return vshl(Qd, Qm, Qn) | 1 << 8U; // R = 1
+}
+
+// imm6 = 32 + imm for 32 bit lanes
+Instruction32 Vector::vshlImmediate(VectorRegister Qd, VectorRegister Qm, uint8_t imm) {
+    if (imm > 31) {
+        Base::printValidationError("vshlImmediate: shift has to be in [0, 31] - inserting nop");
+        return Base::nop32();
+    }
+    Instruction32 instr = 0xEF80'0550;
+    instr |= (32 + imm) << 16U;
+    instr |= Qd << 13U;
+    instr |= Qm << 1U;
+    return instr;
+}
+
+// imm6 = 64 - imm for 32 bit lanes
+Instruction32 Vector::vshrImmediate(VectorRegister Qd, VectorRegister Qm, uint8_t imm) {
+    if (imm < 1 || imm > 32) {
+        Base::printValidationError("vshrImmediate: shift has to be in [1, 32] - inserting nop");
+        return Base::nop32();
+    }
+    Instruction32 instr = 0xEF80'0050;
+    instr |= (64 - imm) << 16U;
+    instr |= Qd << 13U;
+    instr |= Qm << 1U;
+    return instr;
+}
+
+Instruction32 Vector::vrshrImmediate(VectorRegister Qd, VectorRegister Qm, uint8_t imm) {
+    if (imm < 1 || imm > 32) {
+        Base::printValidationError("vrshrImmediate: shift has to be in [1, 32] - inserting nop");
+        return Base::nop32();
+    }
+    return vshrImmediate(Qd, Qm, imm) | 0x2 << 8U; // opcode 0010
+}
+
 Instruction32 Vector::vctp(Size size, Register Rn) {
     Instruction32 instr = 0xf000'e801;
     instr |= Rn << 16;
@@ -23,11 +23,97 @@ class JIT::Instructions::Vector {
 
         static Instruction32 vldrw(VectorRegister Qd, Register Rn, int16_t imm = 0, bool preIndexed = true, bool writeBack = false);
         static Instruction32 vstrw(VectorRegister Qd, Register Rn, int16_t imm = 0, bool preIndexed = true, bool writeBack = false);
+        /// @brief Loads/stores eight halfwords (16 bit elements). imm has to be a multiple of 2 in [-254, 254]
+        static Instruction32 vldrh(VectorRegister Qd, Register Rn, int16_t imm = 0, bool preIndexed = true, bool writeBack = false);
+        static Instruction32 vstrh(VectorRegister Qd, Register Rn, int16_t imm = 0, bool preIndexed = true, bool writeBack = false);
+        /**
+         * Widening load: four halfwords are zero extended into the 32 bit lanes (VLDRH.U32).
+         * The narrowing store writes the bottom halfword of each 32 bit lane (VSTRH.32).
+         * @param Rn has to be a low register
+         */
+        static Instruction32 vldrhWidening(VectorRegister Qd, Register Rn, int16_t imm = 0, bool preIndexed = true, bool writeBack = false);
+        static Instruction32 vstrhNarrowing(VectorRegister Qd, Register Rn, int16_t imm = 0, bool preIndexed = true, bool writeBack = false);
+        /// @brief Loads/stores 16 bytes. imm has to be in [-127, 127]
+        static Instruction32 vldrb(VectorRegister Qd, Register Rn, int16_t imm = 0, bool preIndexed = true, bool writeBack = false);
+        static Instruction32 vstrb(VectorRegister Qd, Register Rn, int16_t imm = 0, bool preIndexed = true, bool writeBack = false);
+        /**
+         * Narrowing store: writes the bottom byte of each 32 bit lane (VSTRB.32)
+         * @param Rn has to be a low register
+         */
+        static Instruction32 vstrbNarrowing(VectorRegister Qd, Register Rn, int16_t imm = 0, bool preIndexed = true, bool writeBack = false);
+        /**
+         * Gather load: Qd[i] = Mem[Rn + (Qm[i] << 2)]
+         * ARM V8M Reference: VLDRW (scalar base plus vector offsets, UXTW #2)
+         */
+        static Instruction32 vldrwGather(VectorRegister Qd, Register Rn, VectorRegister Qm);
 
         static Instruction32 vorr(VectorRegister Qd, VectorRegister Qn, VectorRegister Qm);
+        static Instruction32 vand(VectorRegister Qd, VectorRegister Qn, VectorRegister Qm);
 
         static Instruction32 vfmaVectorByScalarPlusVector(VectorRegister Qda, VectorRegister Qn, Register Rm, bool bf16 = false);
         static Instruction32 vfma(VectorRegister Qda, VectorRegister Qn, VectorRegister Qm, bool bf16 = false);
+        static Instruction32 vmulVectorByScalar(VectorRegister Qd, VectorRegister Qn, Register Rm, bool bf16 = false);
+        static Instruction32 vmulIntegerVectorByScalar(VectorRegister Qd, VectorRegister Qn, Register Rm, Size size = Size32);
+        static Instruction32 vaddFloat(VectorRegister Qd, VectorRegister Qn, VectorRegister Qm, bool bf16 = false);
+        static Instruction32 vaddFloatScalar(VectorRegister Qd, VectorRegister Qn, Register Rm, bool bf16 = false);
+        /// @brief IEEE 754 maxNum/minNum: if one lane is NaN, the other lane is returned
+        static Instruction32 vmaxnm(VectorRegister Qd, VectorRegister Qn, VectorRegister Qm, bool bf16 = false);
+        static Instruction32 vminnm(VectorRegister Qd, VectorRegister Qn, VectorRegister Qm, bool bf16 = false);
+
+        /**
+         * Vector increment and duplicate: Qd = [Rn, Rn + imm, Rn + 2imm, ...], Rn is written back with the next value
+         * @param Rn has to be an even register
+         * @param imm 1, 2, 4 or 8
+         */
+        static Instruction32 vidup(VectorRegister Qd, Register Rn, uint8_t imm, Size size = Size32);
+
+        /**
+         * Converts between half and single precision using the bottom (VCVTB) or top (VCVTT) halfword of each 32 bit lane.
+         * @param toSingle true: F16 -> F32, false: F32 -> F16 (the other halfword of each lane is kept)
+         */
+        static Instruction32 vcvtb(VectorRegister Qd, VectorRegister Qm, bool toSingle);
+        static Instruction32 vcvtt(VectorRegister Qd, VectorRegister Qm, bool toSingle);
+
+        /**
+         * Moves two 32 bit lanes to GP registers: Rt = Qd[2 + oddLanes], Rt2 = Qd[oddLanes]
+         * ARM V8M Reference: VMOV (two 32-bit vector lanes to two general-purpose registers)
+         */
+        static Instruction32 vmovLanesToGP(Register Rt, Register Rt2, VectorRegister Qd, bool oddLanes);
+
+        /// @brief Moves two GP registers into 32 bit lanes: Qd[2 + oddLanes] = Rt, Qd[oddLanes] = Rt2
+        static Instruction32 vmovGPToLanes(VectorRegister Qd, Register Rt, Register Rt2, bool oddLanes);
+        /// @brief Qd[i] = Rt for all 32 bit lanes
+        static Instruction32 vdup(VectorRegister Qd, Register Rt);
+
+        /**
+         * Dot product of two vectors of signed bytes into a GP register: Rda (+)= sum(Qn[i] * Qm[i])
+         * ARM V8M Reference: VMLADAV (VMLAV.S8)
+         * @param Rda has to be an even register
+         */
+        static Instruction32 vmladav(Register Rda, VectorRegister Qn, VectorRegister Qm, bool accumulate = true);
+
+        /* integer arithmetic, signed for VMAX/VMIN and VQRDMULH */
+        static Instruction32 vadd(VectorRegister Qd, VectorRegister Qn, VectorRegister Qm, Size size = Size32);
+        static Instruction32 vaddScalar(VectorRegister Qd, VectorRegister Qn, Register Rm, Size size = Size32);
+        static Instruction32 vsub(VectorRegister Qd, VectorRegister Qn, VectorRegister Qm, Size size = Size32);
+        static Instruction32 vmax(VectorRegister Qd, VectorRegister Qn, VectorRegister Qm, Size size = Size32);
+        static Instruction32 vmin(VectorRegister Qd, VectorRegister Qn, VectorRegister Qm, Size size = Size32);
+        /// @brief Saturating add of signed lanes
+        static Instruction32 vqadd(VectorRegister Qd, VectorRegister Qn, VectorRegister Qm, Size size = Size32);
+        /// @brief Saturating rounding doubling multiply returning high half: Qd = sat((2 * Qn * Qm + (1 << (bits - 1))) >> bits)
+        static Instruction32 vqrdmulh(VectorRegister Qd, VectorRegister Qn, VectorRegister Qm, Size size = Size32);
+
+        /**
+         * Shifts of signed 32 bit lanes by the signed amounts in the lanes of Qn (negative: shift right).
+         * VSHL truncates, VRSHL rounds when shifting right.
+         */
+        static Instruction32 vshl(VectorRegister Qd, VectorRegister Qm, VectorRegister Qn);
+        static Instruction32 vrshl(VectorRegister Qd, VectorRegister Qm, VectorRegister Qn);
+        /// @brief Shifts 32 bit lanes left by imm in [0, 31]
+        static Instruction32 vshlImmediate(VectorRegister Qd, VectorRegister Qm, uint8_t imm);
+        /// @brief Truncating (VSHR) and rounding (VRSHR) right shift of signed 32 bit lanes by imm in [1, 32]
+        static Instruction32 vshrImmediate(VectorRegister Qd, VectorRegister Qm, uint8_t imm);
+        static Instruction32 vrshrImmediate(VectorRegister Qd, VectorRegister Qm, uint8_t imm);
 
         static Instruction32 vctp(Size size, Register Rn);
         static Instruction32 vpst(uint8_t predicatedInstructions);
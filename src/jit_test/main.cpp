@@ -109,7 +109,7 @@ __NO_RETURN int main() {
 	LPRTC::getInstance().enable();
     // enableCpuClock();
     // testThroughput(globalBuffer, globalBufferSram0, globalBufferDtcm, arrayMaxSize, bigA);
-    // testPeakPerformance(globalBuffer, globalBufferSram0, globalBufferDtcm, arrayMaxSize);
+    // testPeakPerformance(globalBuffer, globalBufferSram0, globalBufferDtcm, 8192, arrayMaxSize);
     // disableCpuClock();
     // configureMPU();
 
@@ -183,6 +183,22 @@ __NO_RETURN int main() {
     // testGrowingN(aSram0, bSram0, cSram0, cRefSram0, globalBuffer, testArm, testJitter, testIntrinsics, testReference);
 
     // testAllSizes(bigA, bigB, bigC, bigCRef, globalBuffer, testArm, testJitter, testIntrinsics, testReference, 1, 16, 13, false);
+    // testPredicatedEdges(bigA, bigB, bigC, bigCRef, globalBuffer, 1, 64);
+    // testKernelCache(bigA, bigB, bigC, bigCRef, globalBuffer, 8192, globalBufferDtcm);
+    // testAlphaBeta(bigA, bigB, bigC, bigCRef, globalBuffer);
+    // testLayouts(bigA, bigB, bigC, bigCRef, globalBuffer);
+    // testF16(bigA, bigB, bigC, bigCRef, globalBuffer);
+    // testS8(bigA, bigB, bigC, bigCRef, globalBuffer);
+    // packed A and B panels of the blocked driver in DTCM
+    // static float blockedScratch[4096];
+    // testBlocked(aSram0, bSram0, cSram0, cRefSram0, globalBuffer, 8192, globalBufferDtcm, blockedScratch, 4096, arrayMaxSize);
+    // packed panels (up to 48x48)
+    // static float packedA[48*48];
+    // static float packedB[48*48];
+    // testPacked(bigA, bigB, bigC, bigCRef, packedA, packedB, globalBuffer, 200);
+    // testEpilogue(bigA, bigB, bigC, bigCRef, globalBuffer);
+    // testBatched(bigA, bigB, bigC, bigCRef, globalBuffer);
+    // testTuning(bigA, bigB, bigC, bigCRef, globalBuffer);
 #endif
 	LPRTC::getInstance().disable();
 	while (1) {
@@ -0,0 +1,133 @@
+#ifndef GEMM_TEST_HELPER_HPP
+#define GEMM_TEST_HELPER_HPP
+#include "catch2/catch_amalgamated.hpp"
+#include "emulator/Emulator.hpp"
+#include "generators/Gemm.hpp"
+#include "helper/gemm_reference.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Emulator harness of the generated routines and checks of column-major (COLUMN_MAJOR_NN) C += A * B kernels, shared by the generators with their own entry points
+namespace GemmTestHelper {
+    // the code buffer and the arguments in R0-R2 are mapped at these addresses
+    constexpr uint32_t CODE_ADDRESS = 0x0001'0000;
+    constexpr uint32_t X_ADDRESS = 0x1000'0000;
+    constexpr uint32_t Y_ADDRESS = 0x2000'0000;
+    constexpr uint32_t Z_ADDRESS = 0x3000'0000;
+    constexpr uint32_t PADDING = 16;
+    // program arena of the Gemm generators of the tests, sized for the largest code buffer of the tests
+    alignas(4) inline uint8_t programStorage[JIT::Generators::Gemm::programStorageSize(1 << 15)];
+
+    /// @brief Emulator address of pointer into the host area at hostBase, which is mapped at base (keeps the Thumb bit of code)
+    inline uint32_t emulatorAddress(uint32_t base, void const * hostBase, void const * pointer) {
+        return base + static_cast<uint32_t>(reinterpret_cast<uintptr_t>(pointer) - reinterpret_cast<uintptr_t>(hostBase));
+    }
+
+    /// @brief Entry (with the Thumb bit) of a routine generated into buffer, which is mapped at CODE_ADDRESS
+    template <typename Func>
+    uint32_t entryOf(Func routine, JIT::Instructions::Instruction16 const * buffer) {
+        return emulatorAddress(CODE_ADDRESS, buffer, reinterpret_cast<void const *>(routine));
+    }
+
+    /*
+    Calls the routine at entry with the arguments in R0-R2 and requires that it returns. R4-R11 are set to 0x1000 + register
+    before the call, the callee saved registers and SP must be restored.
+    */
+    template <typename... Args>
+    void callAndCheck(JIT::Emulator & emulator, uint32_t entry, Args... args) {
+        using namespace JIT;
+        static_assert(sizeof...(Args) <= 3, "the routines take up to three arguments in R0-R2");
+        for (uint8_t reg = Instructions::R4; reg <= Instructions::R11; reg++) emulator.setRegister(static_cast<Instructions::Register>(reg), 0x1000u + reg);
+        Emulator::Status const status = emulator.call(entry, static_cast<uint32_t>(args)...);
+        CAPTURE(emulator.getFaultAddress());
+        REQUIRE(status == Emulator::RETURNED);
+        for (uint8_t reg = Instructions::R4; reg <= Instructions::R11; reg++) REQUIRE(emulator.getRegister(static_cast<Instructions::Register>(reg)) == 0x1000u + reg);
+        REQUIRE(emulator.getRegister(Instructions::SP) == Emulator::STACK_TOP);
+    }
+
+    struct Shape {
+        uint32_t m;
+        uint32_t k;
+        uint32_t n;
+        uint32_t lda;
+        uint32_t ldb;
+        uint32_t ldc;
+    };
+
+    /*
+    Maps A, B and C of the shape and the code buffer into the emulator, calls the kernel which generate(emulator, shape)
+    returns (a pointer into buffer with the Thumb bit) and compares C with the reference. The callable may map and pass
+    further arguments in R3 or the vector registers. The gaps of ldc and the padding behind C are not written.
+    T is the element type of A, B and C (float or _Float16), the reference is computed in FP32.
+    */
+    template <typename T = float, typename Generate>
+    void checkKernel(JIT::Emulator & emulator, JIT::Instructions::Instruction16 * buffer, uint32_t bufferSize, Shape const & shape, Generate && generate) {
+        using namespace JIT;
+        uint32_t const aSize = shape.k * shape.lda;
+        uint32_t const bSize = shape.n * shape.ldb;
+        uint32_t const cSize = shape.n * shape.ldc;
+        CAPTURE(shape.m, shape.n, shape.k, shape.lda, shape.ldb, shape.ldc);
+
+        // multiples of 1/8 with small magnitudes, all sums are exact (in FP16 up to k = 17)
+        std::vector<float> aValues(aSize + PADDING, NAN);
+        std::vector<float> bValues(bSize + PADDING, NAN);
+        std::vector<float> cValues(cSize + PADDING, -1234.0f);
+        for (uint32_t i = 0; i < aSize; i++) aValues[i] = static_cast<float>(i % 5) - 2.0f + 0.25f * (i % 3);
+        for (uint32_t i = 0; i < bSize; i++) bValues[i] = static_cast<float>(i % 7) - 3.0f + 0.5f * (i % 5);
+        for (uint32_t i = 0; i < cSize; i++) cValues[i] = static_cast<float>(i % 11) - 5.0f;
+        std::vector<float> expected(cValues);
+        gemm_reference(aValues.data(), bValues.data(), expected.data(), shape.n, shape.k, shape.m, shape.lda, shape.ldb, shape.ldc, Generators::Gemm::COLUMN_MAJOR_NN);
+        std::vector<T> a(aValues.begin(), aValues.end());
+        std::vector<T> b(bValues.begin(), bValues.end());
+        std::vector<T> c(cValues.begin(), cValues.end());
+
+        emulator.unmapAll();
+        REQUIRE(emulator.map(CODE_ADDRESS, buffer, bufferSize * sizeof(Instructions::Instruction16)));
+        REQUIRE(emulator.map(X_ADDRESS, a.data(), a.size() * sizeof(T)));
+        REQUIRE(emulator.map(Y_ADDRESS, b.data(), b.size() * sizeof(T)));
+        REQUIRE(emulator.map(Z_ADDRESS, c.data(), c.size() * sizeof(T)));
+        auto const kernel = generate(emulator, shape);
+        REQUIRE(kernel != nullptr);
+
+        callAndCheck(emulator, entryOf(kernel, buffer), X_ADDRESS, Y_ADDRESS, Z_ADDRESS);
+        for (uint32_t i = 0; i < c.size(); i++) {
+            CAPTURE(i);
+            REQUIRE(static_cast<float>(c[i]) == expected[i]);
+        }
+    }
+
+    /// @brief Checks m = 1..20, n = 1..7 and k in {1, 2, 5, 12} with small paddings of the leading dimensions, returns the number of shapes
+    template <typename Generate>
+    uint32_t checkSmallShapes(JIT::Emulator & emulator, JIT::Instructions::Instruction16 * buffer, uint32_t bufferSize, Generate && generate) {
+        uint32_t shapes = 0;
+        for (uint32_t m = 1; m <= 20; m++) {
+            for (uint32_t n = 1; n <= 7; n++) {
+                for (uint32_t k : {1U, 2U, 5U, 12U}) {
+                    Shape const shape = {m, k, n, m + shapes % 3, k + shapes % 2, m + (shapes % 5 == 0 ? 7 : 0)};
+                    checkKernel(emulator, buffer, bufferSize, shape, generate);
+                    shapes++;
+                }
+            }
+        }
+        return shapes;
+    }
+
+    /// @brief Checks k beyond the unrolling and the loop counts and leading dimensions beyond the immediate offsets of VLDRW (127 floats) and LDR (1023 floats)
+    template <typename Generate>
+    uint32_t checkLargeShapes(JIT::Emulator & emulator, JIT::Instructions::Instruction16 * buffer, uint32_t bufferSize, Generate && generate) {
+        Shape const shapes[] = {
+            {13, 300, 7, 13, 300, 13},
+            {21, 1100, 5, 21 + 130, 1100, 21},
+            {13, 7, 14, 13 + 1100, 7 + 600, 13 + 1100},
+            {12, 5, 1, 12 + 2000, 5, 12},
+            {45, 3, 13, 45 + 200, 3 + 300, 45 + 1100},
+            {5, 2, 3, 5 + 1100, 2 + 1100, 5 + 1100},
+        };
+        for (Shape const & shape : shapes) checkKernel(emulator, buffer, bufferSize, shape, generate);
+        return sizeof(shapes) / sizeof(shapes[0]);
+    }
+}
+
+#endif // GEMM_TEST_HELPER_HPP
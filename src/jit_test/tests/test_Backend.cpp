@@ -2,6 +2,7 @@
 #include "backend/Backend.hpp"
 #include "instructions/Arithmetic.hpp"
 #include "instructions/Base.hpp"
+#include "instructions/DataProcessing.hpp"
 #include "instructions/Vector.hpp"
 
 #include <cstdint>
@@ -14,7 +15,8 @@ using namespace JIT;
  * 
  */
 TEST_CASE("Helium instructions are correctly aligned", "[BACKEND]") {
-    Backend backend;
+    Instructions::Instruction16 buffer[16];
+    Backend backend(buffer, 16);
     Instructions::Instruction16 * instructions = backend.getInstructions();
     if (reinterpret_cast<uintptr_t>(instructions) % 4 == 0) {
         backend.addInstruction(Instructions::Base::nop16());
@@ -26,6 +28,38 @@ TEST_CASE("Helium instructions are correctly aligned", "[BACKEND]") {
     Instructions::Instruction16 * heliumStart = &instructions[backend.getInstructionCount() - 2];
     REQUIRE(reinterpret_cast<uintptr_t>(heliumStart) % 4 == 0);
 }
+TEST_CASE("Immediate helpers fall back to the temp register", "[BACKEND]") {
+    Instructions::Instruction16 buffer[16];
+    Backend backend(buffer, 16);
+    auto instruction32 = [&](uint32_t index) {
+        return static_cast<Instructions::Instruction32>(buffer[index]) << 16 | buffer[index + 1];
+    };
+    SECTION("move") {
+        backend.addMoveImmediate(Instructions::R3, 0x1234);
+        REQUIRE(backend.getInstructionCount() == 2);
+        backend.addMoveImmediate(Instructions::R3, 0x0001'1234);
+        REQUIRE(backend.getInstructionCount() == 6);
+        REQUIRE(instruction32(2) == Instructions::DataProcessing::movImmediate32(Instructions::R3, 0x1234));
+        REQUIRE(instruction32(4) == Instructions::DataProcessing::movtImmediate32(Instructions::R3, 1));
+    }
+    SECTION("add") {
+        backend.addAddImmediate(Instructions::R2, Instructions::R2, 0, Instructions::R9);
+        REQUIRE(backend.getInstructionCount() == 0);
+        backend.addAddImmediate(Instructions::R2, Instructions::R3, 4095, Instructions::R9, true);
+        REQUIRE(instruction32(0) == Instructions::Arithmetic::subImmediate32(Instructions::R2, Instructions::R3, 4095));
+        backend.addAddImmediate(Instructions::R2, Instructions::R3, 4096, Instructions::R9);
+        REQUIRE(instruction32(2) == Instructions::DataProcessing::movImmediate32(Instructions::R9, 4096));
+        REQUIRE(instruction32(4) == Instructions::Arithmetic::addRegister32(Instructions::R2, Instructions::R3, Instructions::R9));
+    }
+    SECTION("compare") {
+        backend.addCompareImmediate(Instructions::R4, 0x1ff, Instructions::R9);
+        REQUIRE(instruction32(0) == Instructions::DataProcessing::movImmediate32(Instructions::R9, 0x1ff));
+        REQUIRE(instruction32(2) == Instructions::Base::cmpRegister32(Instructions::R4, Instructions::R9));
+        backend.addCompareImmediate(Instructions::R4, 0x200, Instructions::R9);
+        REQUIRE(instruction32(4) == Instructions::Base::cmpImmediate32(Instructions::R4, 0x200));
+    }
+}
+
 /*
 TEST_CASE("Branching Operations", "[BRANCH]") {
     SECTION("Low Overhead Branch - Backwards LE/LETP") {
@@ -129,4 +129,22 @@ TEST_CASE("Immediate Constants", "[Immediate]") {
         REQUIRE(Base::canEncodeImmediateConstant(0xaeae'afae) == false);
         REQUIRE(Base::canEncodeImmediateConstant(0xaeae'afaf) == false);
     }
-}
\ No newline at end of file
+}
+TEST_CASE("B.W encodes correctly", "[B]") {
+    REQUIRE(Base::b32(4096) == 0xf001'b800);
+    REQUIRE(Base::b32(-260) == 0xf7ff'bf7e);
+}
+TEST_CASE("CBZ and CBNZ encode correctly", "[CBZ]") {
+    REQUIRE(Base::cbz(R3, 10) == 0xb12b);
+    REQUIRE(Base::cbz(R0, 0) == 0xb100);
+    REQUIRE(Base::cbnz(R7, 126) == 0xbbff);
+    REQUIRE(Base::cbz(R8, 10) == Base::nop16());
+    REQUIRE(Base::cbnz(R1, 128) == Base::nop16());
+}
+TEST_CASE("WLS and WLSTP encode correctly", "[WLS]") {
+    REQUIRE(Base::wls(R4, 4) == 0xf044'c003);
+    REQUIRE(Base::wls(R10, 4094) == 0xf04a'cfff);
+    REQUIRE(Base::wlstp(R5, Size32, 2) == 0xf025'c801);
+    REQUIRE(Base::wlstp(R2, Size8, 200) == 0xf002'c065);
+    REQUIRE(Base::wls(R4, 4096) == Base::nop32());
+}
@@ -0,0 +1,162 @@
+#include "catch2/catch_amalgamated.hpp"
+#include "backend/CodeMemory.hpp"
+
+#include <cstdint>
+
+using namespace JIT;
+using namespace JIT::Instructions;
+
+namespace {
+    using Func = void (*)();
+
+    // kernel i consists of the halfwords 0x100 * i + j
+    void fill(Instruction16 * code, uint32_t size, uint16_t id) {
+        for (uint32_t j = 0; j < size; j++) code[j] = static_cast<Instruction16>(0x100 * id + j);
+    }
+    bool matches(CodeMemory const & memory, CodeMemory::Handle handle, uint32_t size, uint16_t id) {
+        Instruction16 const * code = reinterpret_cast<Instruction16 const *>(memory.getThumbAddress(handle) & ~static_cast<uintptr_t>(1));
+        for (uint32_t j = 0; j < size; j++) {
+            if (code[j] != static_cast<Instruction16>(0x100 * id + j)) return false;
+        }
+        return true;
+    }
+    void call(CodeMemory & memory, CodeMemory::Handle handle, uint32_t calls) {
+        for (uint32_t i = 0; i < calls; i++) REQUIRE(memory.get<Func>(handle) != nullptr);
+    }
+}
+
+
+TEST_CASE("Code memory places kernels by priority", "[CODE_MEMORY]") {
+    alignas(4) static Instruction16 itcm[64];
+    alignas(4) static Instruction16 dtcm[64];
+    alignas(4) static Instruction16 sram0[256];
+    alignas(4) Instruction16 staging[64];
+    CodeMemory memory;
+    REQUIRE(memory.addRegion(CodeMemory::ITCM, itcm, 64));
+    REQUIRE(memory.addRegion(CodeMemory::DTCM, dtcm, 64));
+    REQUIRE(memory.addRegion(CodeMemory::SRAM0, sram0, 256));
+    REQUIRE_FALSE(memory.addRegion(CodeMemory::SRAM0, sram0 + 1, 64));
+
+    fill(staging, 40, 1);
+    CodeMemory::Handle const hot = memory.add(staging, 40, CodeMemory::HOT);
+    fill(staging, 31, 2);
+    CodeMemory::Handle const secondHot = memory.add(staging, 31, CodeMemory::HOT);
+    fill(staging, 20, 3);
+    CodeMemory::Handle const cold = memory.add(staging, 20);
+    REQUIRE(memory.getKernelCount() == 3);
+    REQUIRE(memory.getRegion(hot) == CodeMemory::ITCM);
+    REQUIRE(memory.getRegion(secondHot) == CodeMemory::DTCM); // ITCM has 24 halfwords left
+    REQUIRE(memory.getRegion(cold) == CodeMemory::SRAM0);
+    REQUIRE(memory.getUsedSize(CodeMemory::DTCM) == 32); // padded, the next kernel starts word aligned
+    REQUIRE(dtcm[31] == Base::nop16());
+    REQUIRE(matches(memory, hot, 40, 1));
+    REQUIRE(matches(memory, secondHot, 31, 2));
+    REQUIRE(matches(memory, cold, 20, 3));
+    REQUIRE((memory.getThumbAddress(cold) & 1) == 1);
+
+    REQUIRE(memory.add(staging, 300, CodeMemory::HOT) == CodeMemory::NONE);
+
+    SECTION("explicit moves") {
+        REQUIRE(memory.move(cold, CodeMemory::ITCM));
+        REQUIRE(memory.getRegion(cold) == CodeMemory::ITCM);
+        REQUIRE(matches(memory, cold, 20, 3));
+        REQUIRE_FALSE(memory.move(secondHot, CodeMemory::ITCM));
+        REQUIRE(memory.getRegion(secondHot) == CodeMemory::DTCM);
+        REQUIRE(memory.move(secondHot, CodeMemory::DTCM));
+        REQUIRE_FALSE(memory.move(CodeMemory::NONE, CodeMemory::ITCM));
+    }
+    SECTION("removed kernels free their space") {
+        memory.remove(hot);
+        REQUIRE(memory.getKernelCount() == 2);
+        REQUIRE(memory.getUsedSize(CodeMemory::ITCM) == 0);
+        REQUIRE(memory.add(staging, 64, CodeMemory::HOT) == hot);
+        REQUIRE(memory.getRegion(hot) == CodeMemory::ITCM);
+    }
+}
+
+TEST_CASE("Code memory promotes the most called kernels", "[CODE_MEMORY]") {
+    alignas(4) static Instruction16 itcm[64];
+    alignas(4) static Instruction16 sram0[256];
+    alignas(4) Instruction16 staging[64];
+    CodeMemory memory;
+    REQUIRE(memory.addRegion(CodeMemory::ITCM, itcm, 64));
+    REQUIRE(memory.addRegion(CodeMemory::SRAM0, sram0, 256));
+
+    fill(staging, 48, 1);
+    CodeMemory::Handle const first = memory.add(staging, 48, CodeMemory::HOT);
+    fill(staging, 32, 2);
+    CodeMemory::Handle const second = memory.add(staging, 32);
+    fill(staging, 16, 3);
+    CodeMemory::Handle const third = memory.add(staging, 16);
+    REQUIRE(memory.getRegion(first) == CodeMemory::ITCM);
+    REQUIRE(memory.getRegion(second) == CodeMemory::SRAM0);
+    REQUIRE(memory.getRegion(third) == CodeMemory::SRAM0);
+
+    // without calls the hot kernel stays, the free space of the ITCM is used
+    REQUIRE(memory.rebalance() == 1);
+    REQUIRE(memory.getRegion(first) == CodeMemory::ITCM);
+    REQUIRE(memory.getRegion(third) == CodeMemory::ITCM);
+    REQUIRE(memory.getRegion(second) == CodeMemory::SRAM0);
+
+    // the second kernel is called most: the others are demoted to make room for it
+    call(memory, second, 100);
+    call(memory, first, 10);
+    call(memory, third, 20);
+    REQUIRE(memory.rebalance() == 2);
+    REQUIRE(memory.getRegion(second) == CodeMemory::ITCM);
+    REQUIRE(memory.getRegion(third) == CodeMemory::ITCM);
+    REQUIRE(memory.getRegion(first) == CodeMemory::SRAM0);
+    REQUIRE(matches(memory, first, 48, 1));
+    REQUIRE(matches(memory, second, 32, 2));
+    REQUIRE(matches(memory, third, 16, 3));
+    REQUIRE(memory.getCalls(second) == 50);
+
+    // nothing is demoted if the colder kernels can't make enough room
+    call(memory, first, 30);
+    REQUIRE(memory.rebalance() == 0);
+    REQUIRE(memory.getRegion(first) == CodeMemory::SRAM0);
+    call(memory, first, 100);
+    REQUIRE(memory.rebalance() == 2);
+    REQUIRE(memory.getRegion(first) == CodeMemory::ITCM);
+    REQUIRE(memory.getRegion(second) == CodeMemory::SRAM0);
+    REQUIRE(memory.getRegion(third) == CodeMemory::ITCM); // demoted for the first kernel and promoted into the rest
+    REQUIRE(matches(memory, first, 48, 1));
+    REQUIRE(matches(memory, second, 32, 2));
+    REQUIRE(matches(memory, third, 16, 3));
+}
+
+TEST_CASE("Code memory doesn't demote kernels for a promotion which fails", "[CODE_MEMORY]") {
+    alignas(4) static Instruction16 itcm[16];
+    alignas(4) static Instruction16 sram0[64];
+    alignas(4) Instruction16 staging[16];
+    CodeMemory memory;
+    REQUIRE(memory.addRegion(CodeMemory::ITCM, itcm, 16));
+    REQUIRE(memory.addRegion(CodeMemory::SRAM0, sram0, 64));
+
+    // ITCM: [hot A][cold B][hot C][cold D], the cold kernels free 4 halfwords, but not in one gap
+    uint32_t const sizes[] = {6, 2, 6, 2};
+    CodeMemory::Handle handles[4];
+    for (uint16_t i = 0; i < 4; i++) {
+        fill(staging, sizes[i], i + 1);
+        handles[i] = memory.add(staging, sizes[i], CodeMemory::HOT);
+        REQUIRE(memory.getRegion(handles[i]) == CodeMemory::ITCM);
+    }
+    fill(staging, 4, 5);
+    CodeMemory::Handle const e = memory.add(staging, 4, CodeMemory::HOT);
+    REQUIRE(memory.getRegion(e) == CodeMemory::SRAM0);
+    call(memory, handles[0], 50);
+    call(memory, handles[2], 50);
+    call(memory, e, 20);
+    call(memory, handles[1], 5);
+    call(memory, handles[3], 5);
+
+    // nothing is copied: the free part of the SRAM0 keeps its contents
+    for (uint32_t i = 4; i < 64; i++) sram0[i] = 0xdead;
+    REQUIRE(memory.rebalance() == 0);
+    for (uint32_t i = 4; i < 64; i++) REQUIRE(sram0[i] == 0xdead);
+    for (uint16_t i = 0; i < 4; i++) {
+        REQUIRE(memory.getRegion(handles[i]) == CodeMemory::ITCM);
+        REQUIRE(matches(memory, handles[i], sizes[i], i + 1));
+    }
+    REQUIRE(memory.getRegion(e) == CodeMemory::SRAM0);
+}
@@ -0,0 +1,278 @@
+#include "catch2/catch_amalgamated.hpp"
+#include "emulator/CycleEstimator.hpp"
+#include "emulator/Emulator.hpp"
+#include "generators/Gemm.hpp"
+#include "gemm_test_helper.hpp"
+#include "instructions/Arithmetic.hpp"
+#include "instructions/Base.hpp"
+#include "instructions/DataProcessing.hpp"
+#include "instructions/Vector.hpp"
+
+#include <cstdint>
+#include <vector>
+
+using namespace JIT;
+using namespace JIT::Instructions;
+using namespace GemmTestHelper;
+
+namespace {
+    // Hand written loops of the micro benchmarks (helium_instructions/instructions.s), positions are in halfwords
+    struct Code {
+        alignas(4) Instruction16 buffer[64];
+        uint16_t count = 0;
+
+        uint16_t add(Instruction16 instruction) {
+            buffer[count] = instruction;
+            return count++;
+        }
+        uint16_t add(Instruction32 instruction) {
+            buffer[count] = static_cast<Instruction16>(instruction >> 16);
+            buffer[count + 1] = static_cast<Instruction16>(instruction);
+            count += 2;
+            return count - 2;
+        }
+        static int16_t offset(uint16_t position, uint16_t target) {
+            return static_cast<int16_t>(2 * target - (2 * position + 4));
+        }
+
+        /// @brief Estimated cycles of one loop iteration, the difference between 20 and 10 iterations (R0)
+        uint64_t cyclesPerIteration() {
+            Emulator emulator;
+            uint32_t memory[4] = {};
+            REQUIRE(emulator.map(CODE_ADDRESS, buffer, sizeof(buffer)));
+            REQUIRE(emulator.map(X_ADDRESS, memory, sizeof(memory)));
+            CycleEstimator estimator;
+            REQUIRE(estimator.run(emulator, CODE_ADDRESS | 1, 10, X_ADDRESS) == Emulator::RETURNED);
+            uint64_t const cycles = estimator.getEstimate().cycles;
+            REQUIRE(estimator.run(emulator, CODE_ADDRESS | 1, 20, X_ADDRESS) == Emulator::RETURNED);
+            return (estimator.getEstimate().cycles - cycles) / 10;
+        }
+    };
+
+    void independentVfmas(Code & code) {
+        code.add(Vector::vfma(Q0, Q1, Q2));
+        code.add(Vector::vfma(Q1, Q2, Q3));
+        code.add(Vector::vfma(Q2, Q3, Q4));
+        code.add(Vector::vfma(Q3, Q4, Q5));
+    }
+}
+
+
+TEST_CASE("Branches match the branch_operations measurements", "[CYCLE_ESTIMATOR]") {
+    Code code;
+
+    SECTION("low overhead loop") {
+        code.add(DataProcessing::push16(R4, LR));
+        code.add(Base::dls(R0));
+        uint16_t const loop = code.count;
+        independentVfmas(code);
+        uint16_t const end = code.count;
+        code.add(Base::le(Code::offset(end, loop)));
+        code.add(DataProcessing::pop16(R4, PC));
+        REQUIRE(code.cyclesPerIteration() == 8);
+    }
+    SECTION("backward branch") {
+        code.add(DataProcessing::push16(R4, LR));
+        code.add(DataProcessing::movImmediate16(R1, 0));
+        uint16_t const loop = code.add(Vector::vfma(Q0, Q1, Q2));
+        code.add(Vector::vfma(Q1, Q2, Q3));
+        code.add(Arithmetic::addImmediate16(R1, 1));
+        code.add(Vector::vfma(Q2, Q3, Q4));
+        code.add(Base::cmpRegister16(R1, R0));
+        code.add(Vector::vfma(Q3, Q4, Q5));
+        uint16_t const branch = code.count;
+        code.add(Base::bCond16(LT, Code::offset(branch, loop)));
+        code.add(DataProcessing::pop16(R4, PC));
+        REQUIRE(code.cyclesPerIteration() == 9);
+    }
+    SECTION("forward branch") {
+        code.add(DataProcessing::push16(R4, LR));
+        code.add(DataProcessing::movImmediate16(R1, 0));
+        uint16_t const loop = code.add(Base::cmpRegister16(R1, R0));
+        uint16_t const exit = code.add(Base::nop16()); // BGE, the offset is known after the loop
+        code.add(Vector::vfma(Q0, Q1, Q2));
+        code.add(Vector::vfma(Q1, Q2, Q3));
+        code.add(Arithmetic::addImmediate16(R1, 1));
+        code.add(Vector::vfma(Q2, Q3, Q4));
+        code.add(Vector::vfma(Q3, Q4, Q5));
+        uint16_t const branch = code.count;
+        code.add(Base::b16(Code::offset(branch, loop)));
+        uint16_t const after = code.add(DataProcessing::pop16(R4, PC));
+        code.buffer[exit] = Base::bCond16(GE, Code::offset(exit, after));
+        REQUIRE(code.cyclesPerIteration() == 10);
+    }
+    SECTION("compare and branch on zero") {
+        code.add(DataProcessing::push16(R4, LR));
+        uint16_t const loop = code.add(Base::nop16()); // CBZ
+        code.add(Vector::vfma(Q0, Q1, Q2));
+        code.add(Vector::vfma(Q1, Q2, Q3));
+        code.add(Arithmetic::subImmediate16(R0, 1));
+        code.add(Vector::vfma(Q2, Q3, Q4));
+        code.add(Vector::vfma(Q3, Q4, Q5));
+        uint16_t const branch = code.count;
+        code.add(Base::b16(Code::offset(branch, loop)));
+        uint16_t const after = code.add(DataProcessing::pop16(R4, PC));
+        code.buffer[loop] = Base::cbz(R0, static_cast<uint8_t>(Code::offset(loop, after)));
+        REQUIRE(code.cyclesPerIteration() == 10);
+    }
+}
+
+TEST_CASE("Low overhead loops match the lob_alignment measurements", "[CYCLE_ESTIMATOR]") {
+    Code code;
+    bool const aligned = GENERATE(true, false);
+    CAPTURE(aligned);
+
+    code.add(DataProcessing::push32(R4, LR));
+    if (!aligned) code.add(Base::nop16());
+    code.add(Base::dls(R0));
+    uint16_t const loop = code.count;
+    REQUIRE((loop % 2 == 0) == aligned);
+
+    SECTION("loads overlap with FMAs") {
+        code.add(Vector::vldrw(Q3, R1));
+        code.add(Vector::vfma(Q0, Q1, Q2));
+        code.add(Vector::vldrw(Q3, R1));
+        code.add(Vector::vfma(Q0, Q1, Q2));
+        uint16_t const end = code.count;
+        code.add(Base::le(Code::offset(end, loop)));
+        code.add(DataProcessing::pop32(R4, PC));
+        // 40245 and 50179 cycles for 10000 iterations
+        REQUIRE(code.cyclesPerIteration() == (aligned ? 4 : 5));
+    }
+    SECTION("FMAs into the same accumulator") {
+        for (uint8_t i = 0; i < 4; i++) code.add(Vector::vfma(Q0, Q1, Q2));
+        uint16_t const end = code.count;
+        code.add(Base::le(Code::offset(end, loop)));
+        code.add(DataProcessing::pop32(R4, PC));
+        // 80174 and 80018 cycles for 10000 iterations
+        REQUIRE(code.cyclesPerIteration() == 8);
+    }
+}
+
+TEST_CASE("Load results stall floating point instructions but not stores", "[CYCLE_ESTIMATOR]") {
+    Emulator emulator;
+    Code code;
+    uint32_t memory[8] = {};
+    REQUIRE(emulator.map(CODE_ADDRESS, code.buffer, sizeof(code.buffer)));
+    REQUIRE(emulator.map(X_ADDRESS, memory, sizeof(memory)));
+
+    code.add(Vector::vldrw(Q0, R0));
+    uint16_t const fma = code.add(Vector::vfma(Q1, Q0, Q2));
+    uint16_t const store = code.add(Vector::vstrw(Q1, R0, 16));
+    code.add(Base::bx(LR));
+
+    CycleEstimator::InstructionStatistics statistics[64];
+    CycleEstimator estimator(CODE_ADDRESS, statistics, 64);
+    REQUIRE(estimator.run(emulator, CODE_ADDRESS | 1, X_ADDRESS) == Emulator::RETURNED);
+    CycleEstimator::Estimate const & estimate = estimator.getEstimate();
+    REQUIRE(estimate.instructions == 4);
+    REQUIRE(estimator.getStatistics(CODE_ADDRESS + 2 * fma)->executions == 1);
+    REQUIRE(estimator.getStatistics(CODE_ADDRESS + 2 * fma)->stalls[CycleEstimator::LOAD_FP_INTERLOCK] == 1);
+    // the store waits for the FMA result
+    REQUIRE(estimator.getStatistics(CODE_ADDRESS + 2 * store)->stalls[CycleEstimator::VECTOR_RESULT] == 2);
+    REQUIRE(estimate.flops == 8);
+    REQUIRE(estimator.getStatistics(CODE_ADDRESS + 2 * 64) == nullptr);
+}
+
+TEST_CASE("Generated GEMM kernels are estimated below the peak", "[CYCLE_ESTIMATOR][GEMM]") {
+    constexpr uint32_t BUFFER_SIZE = 1 << 14;
+    alignas(4) static Instructions::Instruction16 buffer[BUFFER_SIZE];
+    static CycleEstimator::InstructionStatistics statistics[BUFFER_SIZE];
+    Generators::Gemm gemm(buffer, BUFFER_SIZE, programStorage, sizeof(programStorage));
+
+    // cycles per call of gemm_square_all (TillJIT), the estimate has to be within 10%
+    struct Measurement {
+        uint32_t size;
+        uint32_t cycles;
+    };
+    Measurement const measurements[] = {{8, 346}, {16, 2386}, {24, 7486}};
+    for (Measurement const & measurement : measurements) {
+        uint32_t const size = measurement.size;
+        CAPTURE(size);
+        std::vector<float> a(size * size + 16, 1.0f);
+        std::vector<float> b(size * size + 16, 1.0f);
+        std::vector<float> c(size * size + 16, 0.0f);
+        auto kernel = gemm.generate(size, size, size, size, size, size, false, 1.0f, 1.0f);
+        REQUIRE(kernel != nullptr);
+        uint32_t const entry = entryOf(kernel, buffer);
+
+        Emulator emulator;
+        REQUIRE(emulator.map(CODE_ADDRESS, buffer, sizeof(buffer)));
+        REQUIRE(emulator.map(X_ADDRESS, a.data(), a.size() * sizeof(float)));
+        REQUIRE(emulator.map(Y_ADDRESS, b.data(), b.size() * sizeof(float)));
+        REQUIRE(emulator.map(Z_ADDRESS, c.data(), c.size() * sizeof(float)));
+        CycleEstimator estimator(CODE_ADDRESS, statistics, BUFFER_SIZE);
+        REQUIRE(estimator.run(emulator, entry, X_ADDRESS, Y_ADDRESS, Z_ADDRESS) == Emulator::RETURNED);
+        REQUIRE(c[0] == static_cast<float>(size));
+
+        CycleEstimator::Estimate const & estimate = estimator.getEstimate();
+        CAPTURE(estimate.cycles, estimate.flops, estimate.dualIssued);
+        REQUIRE(estimate.flops == 2ULL * size * size * size);
+        REQUIRE(estimate.getFlopsPerCycle() <= 4.0f);
+        REQUIRE(estimate.cycles > measurement.cycles * 0.9);
+        REQUIRE(estimate.cycles < measurement.cycles * 1.1);
+
+        uint64_t executions = 0;
+        uint64_t stalls = 0;
+        for (CycleEstimator::InstructionStatistics const & entry : statistics) {
+            executions += entry.executions;
+            for (uint32_t stall : entry.stalls) stalls += stall;
+        }
+        uint64_t totalStalls = 0;
+        for (uint64_t stall : estimate.stalls) totalStalls += stall;
+        REQUIRE(executions == estimate.instructions);
+        REQUIRE(stalls == totalStalls);
+    }
+}
+
+TEST_CASE("Fused epilogues cost only a few cycles per stored vector", "[CYCLE_ESTIMATOR][GEMM]") {
+    constexpr uint32_t BUFFER_SIZE = 1 << 14;
+    constexpr uint32_t BIAS_ADDRESS = 0x4000'0000;
+    using Epilogue = Generators::Gemm::Epilogue;
+    alignas(4) static Instructions::Instruction16 buffer[BUFFER_SIZE];
+    static CycleEstimator::InstructionStatistics statistics[BUFFER_SIZE];
+    Generators::Gemm gemm(buffer, BUFFER_SIZE, programStorage, sizeof(programStorage));
+
+    float const * const biasValues = reinterpret_cast<float const *>(static_cast<uintptr_t>(BIAS_ADDRESS));
+    Epilogue const epilogues[] = {
+        {Epilogue::BIAS_NONE, nullptr, Epilogue::ACTIVATION_NONE, 0.0f, 0.0f},
+        {Epilogue::BIAS_PER_ROW, biasValues, Epilogue::ACTIVATION_RELU, 0.0f, 0.0f},
+        {Epilogue::BIAS_PER_COLUMN, biasValues, Epilogue::ACTIVATION_RELU6, 0.0f, 0.0f},
+        {Epilogue::BIAS_PER_ROW, biasValues, Epilogue::ACTIVATION_CLAMP, -20.0f, 20.0f},
+    };
+    for (uint32_t size : {24U, 48U, 96U}) {
+        std::vector<float> a(size * size + 16, 1.0f);
+        std::vector<float> b(size * size + 16, 1.0f);
+        std::vector<float> c(size * size + 16, 0.0f);
+        std::vector<float> bias(size, 0.5f);
+        uint64_t plainCycles = 0;
+        for (Epilogue const & epilogue : epilogues) {
+            CAPTURE(size, epilogue.bias, epilogue.activation);
+            auto kernel = gemm.generate(size, size, size, size, size, size, false, 1.0f, 1.0f, Generators::Gemm::COLUMN_MAJOR_NN, epilogue);
+            REQUIRE(kernel != nullptr);
+            uint32_t const entry = entryOf(kernel, buffer);
+
+            Emulator emulator;
+            REQUIRE(emulator.map(CODE_ADDRESS, buffer, sizeof(buffer)));
+            REQUIRE(emulator.map(X_ADDRESS, a.data(), a.size() * sizeof(float)));
+            REQUIRE(emulator.map(Y_ADDRESS, b.data(), b.size() * sizeof(float)));
+            REQUIRE(emulator.map(Z_ADDRESS, c.data(), c.size() * sizeof(float)));
+            REQUIRE(emulator.map(BIAS_ADDRESS, bias.data(), bias.size() * sizeof(float)));
+            CycleEstimator estimator(CODE_ADDRESS, statistics, BUFFER_SIZE);
+            REQUIRE(estimator.run(emulator, entry, X_ADDRESS, Y_ADDRESS, Z_ADDRESS) == Emulator::RETURNED);
+
+            // the epilogue is applied in the store path of the NN microkernels, the k loops are the same:
+            // the added cycles are about the 2 cycles of each vector operation of the epilogue on the FP pipeline
+            CycleEstimator::Estimate const & estimate = estimator.getEstimate();
+            CAPTURE(estimate.cycles, plainCycles);
+            if (plainCycles == 0) {
+                plainCycles = estimate.cycles;
+                continue;
+            }
+            uint32_t const storedVectors = size * size / 4;
+            uint32_t const operations = 1 + (epilogue.activation == Epilogue::ACTIVATION_RELU ? 1 : 2);
+            REQUIRE(estimate.cycles - plainCycles <= storedVectors * 2 * (operations + 1));
+            if (size == 96) REQUIRE(estimate.cycles < plainCycles * 1.05);
+        }
+    }
+}
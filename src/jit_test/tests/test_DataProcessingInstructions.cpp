@@ -76,6 +76,41 @@ TEST_CASE("LDR (register) 32 Bit encodes correctly", "[LDR]") {
     }
 }
 
+TEST_CASE("LDR (literal) encodes correctly", "[LDR]") {
+    SECTION("16 bit") {
+        REQUIRE(DataProcessing::ldrLiteral16(R3, 8) == 0x4b02);
+        REQUIRE(DataProcessing::ldrLiteral16(R0, 1020) == 0x48ff);
+    }
+    SECTION("32 bit") {
+        REQUIRE(DataProcessing::ldrLiteral32(R9, 12) == 0xf8df'900c);
+        REQUIRE(DataProcessing::ldrLiteral32(R10, -8) == 0xf85f'a008);
+        REQUIRE(DataProcessing::ldrLiteral32(R4, 4095) == 0xf8df'4fff);
+    }
+    SECTION("validation errors") {
+        REQUIRE(DataProcessing::ldrLiteral16(R8, 8) == Base::nop16());
+        REQUIRE(DataProcessing::ldrLiteral16(R1, 6) == Base::nop16());
+        REQUIRE(DataProcessing::ldrLiteral32(R1, 4096) == Base::nop32());
+    }
+}
+
+TEST_CASE("LDRH 32 Bit encodes correctly", "[LDR]") {
+    SECTION("immediate") {
+        REQUIRE(DataProcessing::ldrhImmediate32(R8, R1) == 0xf8b1'8000);
+        REQUIRE(DataProcessing::ldrhImmediate32(R7, R1, 4094) == 0xf8b1'7ffe);
+        REQUIRE(DataProcessing::ldrhImmediate32(R8, R1, 2, false, true) == 0xf831'8b02);
+        REQUIRE(DataProcessing::ldrhImmediate32(R8, R1, -2) == 0xf831'8c02);
+        REQUIRE(DataProcessing::ldrhImmediate32(R6, R1, 2, true, true) == 0xf831'6f02);
+    }
+    SECTION("register") {
+        REQUIRE(DataProcessing::ldrhRegister32(R8, R1, R9) == 0xf831'8009);
+        REQUIRE(DataProcessing::ldrhRegister32(R12, R0, R3, 1) == 0xf830'c013);
+    }
+    SECTION("validation errors") {
+        REQUIRE(DataProcessing::ldrhImmediate32(R8, R1, 0x1fff) == Base::nop32());
+        REQUIRE(DataProcessing::ldrhRegister32(R8, R1, SP) == Base::nop32());
+    }
+}
+
 TEST_CASE("MOV Immediate 16 Bit encodes correctly", "[MOV]") {
     SECTION("Test 1") {
         REQUIRE(DataProcessing::movImmediate16(R5, 231) == 0x25e7);
@@ -0,0 +1,237 @@
+#include "catch2/catch_amalgamated.hpp"
+#include "backend/Annotations.hpp"
+#include "backend/Backend.hpp"
+#include "disassembler/Disassembler.hpp"
+#include "generators/Gemm.hpp"
+#include "gemm_test_helper.hpp"
+#include "instructions/Arithmetic.hpp"
+#include "instructions/Base.hpp"
+#include "instructions/DataProcessing.hpp"
+#include "instructions/Vector.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace JIT;
+using namespace JIT::Instructions;
+
+namespace {
+    std::string decode(Instruction32 instruction, uint32_t offset = 0) {
+        Instruction16 const code[2] = {static_cast<Instruction16>(instruction >> 16), static_cast<Instruction16>(instruction)};
+        Disassembler disassembler;
+        char text[Disassembler::MAX_TEXT];
+        REQUIRE(disassembler.decode(code, 2, offset, text, sizeof(text)) == 2);
+        return text;
+    }
+
+    std::string decode(Instruction16 instruction, uint32_t offset = 0) {
+        Disassembler disassembler;
+        char text[Disassembler::MAX_TEXT];
+        REQUIRE(disassembler.decode(&instruction, 1, offset, text, sizeof(text)) == 1);
+        return text;
+    }
+
+    void append(void * context, char const * text) {
+        static_cast<std::string *>(context)->append(text);
+    }
+}
+
+
+// expected texts are the output of llvm-objdump (thumbv8.1m.main, +mve.fp)
+TEST_CASE("Scalar instructions are printed in the syntax of objdump", "[DISASSEMBLER]") {
+    REQUIRE(decode(Arithmetic::addImmediate16(R0, R1, 3)) == "adds r0, r1, #3");
+    REQUIRE(decode(Arithmetic::addImmediate16(R2, 200)) == "adds r2, #200");
+    REQUIRE(decode(Arithmetic::addImmediate32(R3, R4, 4095)) == "addw r3, r4, #4095");
+    REQUIRE(decode(Arithmetic::addRegister16(R8, R1)) == "add r8, r1");
+    REQUIRE(decode(Arithmetic::addRegister32(R0, R1, R2, LSL, 2)) == "add.w r0, r1, r2, lsl #2");
+    REQUIRE(decode(Arithmetic::addRegister32(R0, R1, R2, LSR, 3, true)) == "adds.w r0, r1, r2, lsr #3");
+    REQUIRE(decode(Arithmetic::subImmediate32(R3, 12)) == "subw r3, r3, #12");
+    REQUIRE(decode(Arithmetic::subRegister32(R0, R1, R2, ASR, 2)) == "sub.w r0, r1, r2, asr #2");
+    REQUIRE(decode(Arithmetic::mul16(R0, R1)) == "muls r0, r1, r0");
+    REQUIRE(decode(Arithmetic::mul32(R0, R1, R9)) == "mul r0, r1, r9");
+    REQUIRE(decode(Arithmetic::andImmediate32(R0, R1, 0x3fc, true)) == "ands r0, r1, #1020");
+    REQUIRE(decode(Base::nop16()) == "nop");
+    REQUIRE(decode(Base::nop32()) == "nop.w");
+    REQUIRE(decode(Base::bx(LR)) == "bx lr");
+    REQUIRE(decode(Base::udf(3)) == "udf #3");
+    REQUIRE(decode(Base::cmpImmediate32(R9, 0x100)) == "cmp.w r9, #256");
+    REQUIRE(decode(Base::cmpRegister16(R1, R9)) == "cmp r1, r9");
+    REQUIRE(decode(Base::cmpRegister32(R1, R9, LSL, 2)) == "cmp.w r1, r9, lsl #2");
+    REQUIRE(decode(Base::pldImmediate(R1, 64)) == "pld [r1, #64]");
+    REQUIRE(decode(DataProcessing::ldrImmediate16(R0, R1, 4)) == "ldr r0, [r1, #4]");
+    REQUIRE(decode(DataProcessing::ldrImmediate32(R0, R1, 100)) == "ldr.w r0, [r1, #100]");
+    REQUIRE(decode(DataProcessing::ldrImmediate32(R0, R1, 8, true, true)) == "ldr r0, [r1, #8]!");
+    REQUIRE(decode(DataProcessing::ldrImmediate32(R0, R1, -8, false, true)) == "ldr r0, [r1], #-8");
+    REQUIRE(decode(DataProcessing::ldrRegister16(R0, R1, R2)) == "ldr r0, [r1, r2]");
+    REQUIRE(decode(DataProcessing::ldrRegister32(R0, R1, R2, 2)) == "ldr.w r0, [r1, r2, lsl #2]");
+    REQUIRE(decode(DataProcessing::ldrhImmediate32(R0, R1, 6)) == "ldrh.w r0, [r1, #6]");
+    REQUIRE(decode(DataProcessing::movImmediate32(R9, 0x1234)) == "movw r9, #4660");
+    REQUIRE(decode(DataProcessing::movtImmediate32(R9, 0xabcd)) == "movt r9, #43981");
+    REQUIRE(decode(DataProcessing::movRegister16(R0, R1, LSL, 2)) == "lsls r0, r1, #2");
+    REQUIRE(decode(DataProcessing::movRegister32(R0, R9)) == "mov.w r0, r9");
+    REQUIRE(decode(DataProcessing::movRegister32(R0, R9, ASR, 3, true)) == "asrs.w r0, r9, #3");
+    REQUIRE(decode(DataProcessing::push16(R4, R5, LR)) == "push {r4, r5, lr}");
+    REQUIRE(decode(DataProcessing::pop32(R4, R8, PC)) == "pop.w {r4, r8, pc}");
+    REQUIRE(decode(DataProcessing::vpush(Q4, 4)) == "vpush {d8, d9, d10, d11, d12, d13, d14, d15}");
+    REQUIRE(decode(DataProcessing::vpop(Q4, 4)) == "vpop {d8, d9, d10, d11, d12, d13, d14, d15}");
+}
+
+TEST_CASE("Branch and literal targets are offsets from the start of the code", "[DISASSEMBLER]") {
+    REQUIRE(decode(Base::dlstp(R2, Size32)) == "dlstp.32 lr, r2");
+    REQUIRE(decode(Base::dls(R3)) == "dls lr, r3");
+    REQUIRE(decode(Base::letp(-8), 0x50) == "letp lr, 0x4c");
+    REQUIRE(decode(Base::le(-12), 0x54) == "le lr, 0x4c");
+    REQUIRE(decode(Base::wls(R4, 20), 0x58) == "wls lr, r4, 0x70");
+    REQUIRE(decode(Base::wlstp(R5, Size16, 40), 0x5c) == "wlstp.16 lr, r5, 0x88");
+    REQUIRE(decode(Base::bCond16(NE, -10), 0x6e) == "bne 0x68");
+    REQUIRE(decode(Base::b16(-100), 0x72) == "b 0x12");
+    REQUIRE(decode(Base::cbz(R1, 10), 0x74) == "cbz r1, 0x82");
+    REQUIRE(decode(Base::bCond32(LT, -1000), 0x78) == "blt.w 0xfffffc94");
+    REQUIRE(decode(Base::b32(3000), 0x7c) == "b.w 0xc38");
+    REQUIRE(decode(DataProcessing::ldrLiteral16(R0, 16), 0x9e) == "ldr r0, [pc, #16] @ 0xb0");
+    REQUIRE(decode(DataProcessing::ldrLiteral32(R8, -16), 0xa0) == "ldr.w r8, [pc, #-16] @ 0x94");
+}
+
+TEST_CASE("Vector instructions are printed in the syntax of objdump", "[DISASSEMBLER]") {
+    REQUIRE(decode(Vector::vmovGPxScalar(true, S3, R2)) == "vmov r2, s3");
+    REQUIRE(decode(Vector::vmovImmediate(Q1, 0x82, I16)) == "vmov.i16 q1, #0x82");
+    REQUIRE(decode(Vector::vmovRegister(Q1, Q2)) == "vmov q1, q2");
+    REQUIRE(decode(Vector::vldrw(Q0, R1, -16)) == "vldrw.u32 q0, [r1, #-16]");
+    REQUIRE(decode(Vector::vldrw(Q0, R1, 16, true, true)) == "vldrw.u32 q0, [r1, #16]!");
+    REQUIRE(decode(Vector::vldrw(Q0, R1, 16, false, true)) == "vldrw.u32 q0, [r1], #16");
+    REQUIRE(decode(Vector::vstrw(Q7, R12, 508)) == "vstrw.32 q7, [r12, #508]");
+    REQUIRE(decode(Vector::vstrh(Q0, R1, -8, false, true)) == "vstrh.16 q0, [r1], #-8");
+    REQUIRE(decode(Vector::vldrhWidening(Q0, R1, 8)) == "vldrh.u32 q0, [r1, #8]");
+    REQUIRE(decode(Vector::vstrbNarrowing(Q0, R1, 5)) == "vstrb.32 q0, [r1, #5]");
+    REQUIRE(decode(Vector::vldrwGather(Q0, R1, Q2)) == "vldrw.u32 q0, [r1, q2, uxtw #2]");
+    REQUIRE(decode(Vector::vfmaVectorByScalarPlusVector(Q0, Q1, R2)) == "vfma.f32 q0, q1, r2");
+    REQUIRE(decode(Vector::vfma(Q0, Q1, Q2, true)) == "vfma.f16 q0, q1, q2");
+    REQUIRE(decode(Vector::vmulVectorByScalar(Q0, Q1, R3)) == "vmul.f32 q0, q1, r3");
+    REQUIRE(decode(Vector::vmulIntegerVectorByScalar(Q0, Q1, R3, Size8)) == "vmul.i8 q0, q1, r3");
+    REQUIRE(decode(Vector::vaddFloatScalar(Q0, Q1, R3)) == "vadd.f32 q0, q1, r3");
+    REQUIRE(decode(Vector::vminnm(Q0, Q1, Q2, true)) == "vminnm.f16 q0, q1, q2");
+    REQUIRE(decode(Vector::vidup(Q0, R2, 4)) == "vidup.u32 q0, r2, #4");
+    REQUIRE(decode(Vector::vcvtb(Q0, Q1, true)) == "vcvtb.f32.f16 q0, q1");
+    REQUIRE(decode(Vector::vmovLanesToGP(R0, R1, Q2, true)) == "vmov r0, r1, q2[3], q2[1]");
+    REQUIRE(decode(Vector::vmovGPToLanes(Q2, R0, R1, false)) == "vmov q2[2], q2[0], r0, r1");
+    REQUIRE(decode(Vector::vdup(Q3, R4)) == "vdup.32 q3, r4");
+    REQUIRE(decode(Vector::vmladav(R2, Q0, Q1)) == "vmlava.s8 r2, q0, q1");
+    REQUIRE(decode(Vector::vsub(Q0, Q1, Q2, Size16)) == "vsub.i16 q0, q1, q2");
+    REQUIRE(decode(Vector::vmin(Q0, Q1, Q2, Size8)) == "vmin.s8 q0, q1, q2");
+    REQUIRE(decode(Vector::vqrdmulh(Q0, Q1, Q2)) == "vqrdmulh.s32 q0, q1, q2");
+    REQUIRE(decode(Vector::vrshl(Q0, Q1, Q2)) == "vrshl.s32 q0, q1, q2");
+    REQUIRE(decode(Vector::vshlImmediate(Q0, Q1, 5)) == "vshl.i32 q0, q1, #5");
+    REQUIRE(decode(Vector::vrshrImmediate(Q0, Q1, 7)) == "vrshr.s32 q0, q1, #7");
+    REQUIRE(decode(Vector::vshrImmediate(Q0, Q1, 31)) == "vshr.s32 q0, q1, #31");
+    REQUIRE(decode(Vector::vand(Q0, Q1, Q2)) == "vand q0, q1, q2");
+    REQUIRE(decode(Vector::vqadd(Q0, Q1, Q2)) == "vqadd.s32 q0, q1, q2");
+    REQUIRE(decode(Vector::vctp(Size16, R1)) == "vctp.16 r1");
+    REQUIRE(decode(0xffff'ffffU) == ".inst.w 0xffffffff");
+}
+
+TEST_CASE("Instructions in a VPT block get the T suffix", "[DISASSEMBLER]") {
+    std::vector<Instruction16> code;
+    auto add = [&code](Instruction32 instruction) {
+        code.push_back(static_cast<Instruction16>(instruction >> 16));
+        code.push_back(static_cast<Instruction16>(instruction));
+    };
+    add(Vector::vpst(2));
+    add(Vector::vldrw(Q0, R1));
+    add(Vector::vstrw(Q0, R1));
+    add(Vector::vldrw(Q0, R1));
+
+    std::string dump;
+    Disassembler disassembler;
+    disassembler.print(code.data(), code.size(), nullptr, append, &dump);
+    REQUIRE(dump ==
+        "       0:  fe31 8f4d  vpstt\n"
+        "       4:  ed91 1f00  vldrwt.u32 q0, [r1]\n"
+        "       8:  ed81 1f00  vstrwt.32 q0, [r1]\n"
+        "       c:  ed91 1f00  vldrw.u32 q0, [r1]\n");
+}
+
+TEST_CASE("Annotations follow their instructions through the passes", "[DISASSEMBLER][IR]") {
+    alignas(4) Instruction16 annotated[64] = {};
+    alignas(4) Instruction16 plain[64] = {};
+    Annotations::Entry entries[4];
+    Annotations annotations(entries, 4);
+    alignas(4) uint8_t storage[IR::Program::storageSize(32, 4, 2)];
+
+    for (bool annotate : {true, false}) {
+        Backend backend(annotate ? annotated : plain, 64);
+        backend.setAnnotations(annotate ? &annotations : nullptr);
+        backend.resetKernel();
+        IR::Arena arena(storage, sizeof(storage));
+        IR::Program program(arena, 32, 4, 2);
+        backend.beginProgram(program);
+        backend.addMoveImmediate(R5, 0x12345678); // literal load
+        backend.addInstruction(Base::nop32()); // removed by the peephole pass
+        backend.annotate("k-loop start");
+        IR::Program::Label const loop = backend.newLabel();
+        backend.bindLabel(loop);
+        backend.addInstruction(Arithmetic::addImmediate32(R0, R0, 4)); // narrowed
+        backend.addInstruction(Base::cmpRegister32(R0, R1));
+        backend.addBranch(loop, LT);
+        backend.annotate("return");
+        backend.addInstruction(Base::bx(LR));
+        backend.endProgram();
+    }
+    // ldr r5 (literal), adds, cmp.w, blt, bx, literal
+    REQUIRE(std::vector<Instruction16>(annotated, annotated + 64) == std::vector<Instruction16>(plain, plain + 64));
+    REQUIRE(annotations.getCount() == 3);
+    REQUIRE(entries[0].offset == 1);
+    REQUIRE(entries[1].offset == 5);
+    REQUIRE(entries[2].offset == 6);
+    REQUIRE(entries[2].dataHalfwords == 2);
+
+    std::string dump;
+    Disassembler disassembler;
+    disassembler.print(annotated, 8, &annotations, append, &dump);
+    REQUIRE(dump ==
+        "       0:  4d02       ldr r5, [pc, #8] @ 0xc\n"
+        "          @ k-loop start\n"
+        "       2:  3004       adds r0, #4\n"
+        "       4:  ebb0 0f01  cmp.w r0, r1\n"
+        "       8:  dbfb       blt 0x2\n"
+        "          @ return\n"
+        "       a:  4770       bx lr\n"
+        "          @ literal pool\n"
+        "       c:  5678 1234  .word 0x12345678\n");
+}
+
+TEST_CASE("Generated GEMM kernels disassemble completely", "[DISASSEMBLER][GEMM]") {
+    constexpr uint32_t BUFFER_SIZE = 1 << 14;
+    alignas(4) static Instruction16 buffer[BUFFER_SIZE];
+    static Annotations::Entry entries[256];
+    Annotations annotations(entries, 256);
+    Generators::Gemm gemm(buffer, BUFFER_SIZE, GemmTestHelper::programStorage, sizeof(GemmTestHelper::programStorage));
+
+    struct Shape {
+        uint32_t m;
+        uint32_t k;
+        uint32_t n;
+    };
+    Shape const shapes[] = {{16, 16, 16}, {20, 9, 7}, {4, 1, 6}};
+    for (Shape const & shape : shapes) {
+        CAPTURE(shape.m, shape.k, shape.n);
+        gemm.setAnnotations(nullptr);
+        REQUIRE(gemm.generate(shape.m, shape.k, shape.n, shape.m, shape.k, shape.m, false, 1.0f, 0.5f) != nullptr);
+        std::vector<Instruction16> const plain(buffer, buffer + gemm.getInstructionCount());
+        gemm.setAnnotations(&annotations);
+        REQUIRE(gemm.generate(shape.m, shape.k, shape.n, shape.m, shape.k, shape.m, false, 1.0f, 0.5f) != nullptr);
+        REQUIRE(std::vector<Instruction16>(buffer, buffer + gemm.getInstructionCount()) == plain);
+
+        std::string dump;
+        Disassembler disassembler;
+        disassembler.print(buffer, gemm.getInstructionCount(), &annotations, append, &dump);
+        CAPTURE(dump);
+        REQUIRE(dump.find(".inst") == std::string::npos);
+        REQUIRE(dump.find("@ save registers\n") != std::string::npos);
+        REQUIRE(dump.find("@ C store\n") != std::string::npos);
+        REQUIRE(dump.find("@ restore registers\n") != std::string::npos);
+        if (shape.k > 3) REQUIRE(dump.find("@ k-loop start\n") != std::string::npos);
+        REQUIRE(dump.rfind("pop.w {r4, r5, r6, r7, r8, r9, r10, r11, r12, pc}") != std::string::npos);
+    }
+    gemm.setAnnotations(nullptr);
+}
@@ -0,0 +1,937 @@
+#include "catch2/catch_amalgamated.hpp"
+#include "emulator/Emulator.hpp"
+#include "generators/Gemm.hpp"
+#include "generators/GemmTuningTable.hpp"
+#include "generators/Throughput.hpp"
+#include "generators/Triad.hpp"
+#include "gemm_test_helper.hpp"
+#include "helper/gemm_reference.hpp"
+#include "instructions/Arithmetic.hpp"
+#include "instructions/Base.hpp"
+#include "instructions/DataProcessing.hpp"
+#include "instructions/Vector.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using namespace JIT;
+using namespace JIT::Instructions;
+using namespace GemmTestHelper;
+
+namespace {
+    // Hand written kernels, positions are in halfwords
+    struct Code {
+        alignas(4) Instruction16 buffer[64];
+        uint16_t count = 0;
+
+        uint16_t add(Instruction16 instruction) {
+            buffer[count] = instruction;
+            return count++;
+        }
+        uint16_t add(Instruction32 instruction) {
+            buffer[count] = static_cast<Instruction16>(instruction >> 16);
+            buffer[count + 1] = static_cast<Instruction16>(instruction);
+            count += 2;
+            return count - 2;
+        }
+        /// @brief Offset of a branch at position to target, relative to the PC
+        static int16_t offset(uint16_t position, uint16_t target) {
+            return static_cast<int16_t>(2 * target - (2 * position + 4));
+        }
+        void map(Emulator & emulator) {
+            REQUIRE(emulator.map(CODE_ADDRESS, buffer, sizeof(buffer)));
+        }
+    };
+
+    uint32_t bits(float value) {
+        uint32_t result;
+        std::memcpy(&result, &value, sizeof(result));
+        return result;
+    }
+}
+
+
+TEST_CASE("Scalar instructions, branches and the stack are executed", "[EMULATOR]") {
+    Emulator emulator;
+    Code code;
+    uint32_t memory[2] = {};
+    code.map(emulator);
+    REQUIRE(emulator.map(X_ADDRESS, memory, sizeof(memory)));
+
+    code.add(DataProcessing::push32(R4, LR));
+    code.add(DataProcessing::movImmediate32(R4, 0x1234));
+    code.add(DataProcessing::movtImmediate32(R4, 0xabcd));
+    code.add(DataProcessing::movImmediate16(R0, 0));
+    code.add(DataProcessing::movImmediate16(R1, 10));
+    uint16_t const loop = code.add(Arithmetic::addRegister16(R0, R0, R1));
+    code.add(Arithmetic::subImmediate16(R1, 1));
+    uint16_t const branch = code.count;
+    code.add(Base::bCond16(NE, Code::offset(branch, loop)));
+    code.add(DataProcessing::movImmediate32(R3, X_ADDRESS >> 16));
+    code.add(DataProcessing::movRegister32(R3, R3, LSL, 16));
+    code.add(DataProcessing::str(R3, R4));
+    code.add(DataProcessing::ldrImmediate32(R2, R3, 4, false, true));
+    code.add(Base::cmpImmediate16(R0, 55));
+    code.add(DataProcessing::pop32(R4, PC));
+
+    emulator.setRegister(R4, 0x4444);
+    REQUIRE(emulator.call(CODE_ADDRESS | 1) == Emulator::RETURNED);
+    REQUIRE(emulator.getRegister(R0) == 55);
+    REQUIRE(memory[0] == 0xabcd'1234);
+    REQUIRE(emulator.getRegister(R2) == 0xabcd'1234);
+    REQUIRE(emulator.getRegister(R3) == X_ADDRESS + 4);
+    REQUIRE(emulator.getRegister(R4) == 0x4444);
+    REQUIRE(emulator.getRegister(SP) == Emulator::STACK_TOP);
+    REQUIRE(emulator.getSteps() == 5 + 3 * 10 + 6);
+}
+
+TEST_CASE("Tail predicated loops leave the elements behind the vectors untouched", "[EMULATOR]") {
+    Emulator emulator;
+    Code code;
+    float x[8];
+    float y[8];
+    code.map(emulator);
+    REQUIRE(emulator.map(X_ADDRESS, x, sizeof(x)));
+    REQUIRE(emulator.map(Y_ADDRESS, y, sizeof(y)));
+
+    // y[i] += x[i] * R3 for i < R2, the loop counts in LR
+    code.add(DataProcessing::push16(R4, LR));
+    uint16_t const start = code.count;
+    code.add(Base::nop32()); // WLSTP, the offset is known after the loop
+    uint16_t const loop = code.add(Vector::vldrw(Q0, R0, 16, false, true));
+    code.add(Vector::vldrw(Q1, R1));
+    code.add(Vector::vfmaVectorByScalarPlusVector(Q1, Q0, R3));
+    code.add(Vector::vstrw(Q1, R1, 16, false, true));
+    uint16_t const end = code.count;
+    code.add(Base::letp(Code::offset(end, loop)));
+    uint16_t const after = code.add(DataProcessing::pop16(R4, PC));
+    code.count = start;
+    code.add(Base::wlstp(R2, Size32, Code::offset(start, after)));
+    code.count = after + 1;
+
+    for (uint32_t n : {6U, 8U, 0U, 1U}) {
+        for (uint8_t i = 0; i < 8; i++) {
+            x[i] = static_cast<float>(i + 1);
+            y[i] = -1.0f;
+        }
+        emulator.setRegister(R3, bits(2.0f));
+        REQUIRE(emulator.call(CODE_ADDRESS | 1, X_ADDRESS, Y_ADDRESS, n) == Emulator::RETURNED);
+        for (uint8_t i = 0; i < 8; i++) {
+            REQUIRE(y[i] == (i < n ? 2.0f * (i + 1) - 1.0f : -1.0f));
+        }
+        REQUIRE(emulator.getRegister(R0) == X_ADDRESS + 16 * ((n + 3) / 4));
+    }
+}
+
+TEST_CASE("VCTP and VPST predicate loads and stores", "[EMULATOR]") {
+    Emulator emulator;
+    Code code;
+    float x[4] = {1.0f, 2.0f, 3.0f, 4.0f};
+    float y[4] = {};
+    code.map(emulator);
+    REQUIRE(emulator.map(X_ADDRESS, x, sizeof(x)));
+    REQUIRE(emulator.map(Y_ADDRESS, y, sizeof(y)));
+
+    code.add(Vector::vctp(Size32, R2));
+    code.add(Vector::vpst(2));
+    code.add(Vector::vldrw(Q0, R0));
+    code.add(Vector::vstrw(Q0, R1));
+    code.add(Vector::vstrw(Q0, R1)); // outside of the block
+    code.add(Base::bx(LR));
+
+    emulator.setVectorLane(Q0, 3, bits(7.0f));
+    REQUIRE(emulator.call(CODE_ADDRESS | 1, X_ADDRESS, Y_ADDRESS, 3) == Emulator::RETURNED);
+    REQUIRE(emulator.getVectorLane(Q0, 2) == bits(3.0f));
+    REQUIRE(emulator.getVectorLane(Q0, 3) == 0); // predicated-false lanes of loads are zeroed
+    REQUIRE(y[2] == 3.0f);
+    REQUIRE(y[3] == 0.0f);
+}
+
+TEST_CASE("Faults stop the execution", "[EMULATOR]") {
+    Emulator emulator;
+    Code code;
+    code.map(emulator);
+
+    SECTION("unmapped memory") {
+        code.add(DataProcessing::ldrImmediate32(R0, R1, 8));
+        REQUIRE(emulator.call(CODE_ADDRESS | 1, 0, Z_ADDRESS) == Emulator::MEMORY_FAULT);
+        REQUIRE(emulator.getFaultAddress() == Z_ADDRESS + 8);
+    }
+    SECTION("undefined instructions") {
+        code.add(Base::nop16());
+        code.add(Base::udf(0));
+        REQUIRE(emulator.call(CODE_ADDRESS | 1) == Emulator::UNDEFINED_INSTRUCTION);
+        REQUIRE(emulator.getFaultAddress() == CODE_ADDRESS + 2);
+    }
+    SECTION("endless loops") {
+        code.add(Base::b16(-4));
+        REQUIRE(emulator.call(CODE_ADDRESS | 1, 0, 0, 0, 100) == Emulator::STEP_LIMIT);
+        REQUIRE(emulator.getSteps() == 100);
+    }
+    SECTION("overlapping regions") {
+        uint32_t memory[4];
+        REQUIRE_FALSE(emulator.map(CODE_ADDRESS + 4, memory, sizeof(memory)));
+        REQUIRE_FALSE(emulator.map(Emulator::STACK_TOP - 4, memory, sizeof(memory)));
+    }
+}
+
+TEST_CASE("Generated GEMM kernels match the reference for all layouts", "[EMULATOR][GEMM]") {
+    constexpr uint32_t BUFFER_SIZE = 1 << 15;
+    constexpr uint32_t PADDING = 16; // elements behind the matrices, the NN kernels load whole vectors at the M edges
+    alignas(4) static Instructions::Instruction16 buffer[BUFFER_SIZE];
+    Generators::Gemm gemm(buffer, BUFFER_SIZE, programStorage, sizeof(programStorage));
+    Emulator emulator;
+    struct Scaling {
+        float alpha;
+        float beta;
+    };
+    // alpha = 3 and -1.5: beta / alpha is not exact, C is added after scaling the accumulators
+    Scaling const scalings[] = {{1.0f, 1.0f}, {1.0f, 0.0f}, {2.0f, 1.0f}, {0.5f, 2.0f}, {3.0f, 1.0f}, {-1.5f, 2.0f}};
+
+    uint32_t kernels = 0;
+    for (uint8_t layout = 0; layout < 8; layout++) {
+        bool const rowMajor = (layout & Generators::Gemm::ROW_MAJOR) != 0;
+        bool const transposeA = (layout & Generators::Gemm::TRANSPOSE_A) != 0;
+        bool const transposeB = (layout & Generators::Gemm::TRANSPOSE_B) != 0;
+        for (uint32_t m = 1; m <= 20; m++) {
+            for (uint32_t n = 1; n <= 7; n++) {
+                for (uint32_t k : {1U, 2U, 5U, 12U}) {
+                    Scaling const scaling = scalings[kernels % 6];
+                    // rows and columns of the stored matrices, the leading dimensions get some padding
+                    uint32_t const aRows = transposeA ? k : m;
+                    uint32_t const aColumns = transposeA ? m : k;
+                    uint32_t const bRows = transposeB ? n : k;
+                    uint32_t const bColumns = transposeB ? k : n;
+                    uint32_t const lda = (rowMajor ? aColumns : aRows) + kernels % 3;
+                    uint32_t const ldb = (rowMajor ? bColumns : bRows) + kernels % 2;
+                    uint32_t const ldc = (rowMajor ? n : m) + (kernels % 5 == 0 ? 7 : 0);
+                    uint32_t const aSize = (rowMajor ? aRows : aColumns) * lda;
+                    uint32_t const bSize = (rowMajor ? bRows : bColumns) * ldb;
+                    uint32_t const cSize = (rowMajor ? m : n) * ldc;
+                    CAPTURE(layout, m, n, k, lda, ldb, ldc, scaling.alpha, scaling.beta);
+
+                    // multiples of 1/8 with small magnitudes, all sums are exact
+                    std::vector<float> a(aSize + PADDING, NAN);
+                    std::vector<float> b(bSize + PADDING, NAN);
+                    std::vector<float> c(cSize + PADDING, -1234.0f);
+                    for (uint32_t i = 0; i < aSize; i++) a[i] = static_cast<float>(i % 13) - 6.0f + 0.25f * (i % 3);
+                    for (uint32_t i = 0; i < bSize; i++) b[i] = static_cast<float>(i % 7) - 3.0f + 0.5f * (i % 5);
+                    for (uint32_t i = 0; i < cSize; i++) c[i] = static_cast<float>(i % 11) - 5.0f;
+
+                    std::vector<float> product(cSize, 0.0f);
+                    gemm_reference(a.data(), b.data(), product.data(), n, k, m, lda, ldb, ldc, static_cast<Generators::Gemm::Layout>(layout));
+                    std::vector<float> expected(c);
+                    for (uint32_t i = 0; i < cSize; i++) {
+                        expected[i] = scaling.alpha * product[i] + (scaling.beta == 0.0f ? 0.0f : scaling.beta * c[i]);
+                    }
+
+                    auto kernel = gemm.generate(m, k, n, lda, ldb, ldc, false, scaling.alpha, scaling.beta, static_cast<Generators::Gemm::Layout>(layout));
+                    REQUIRE(kernel != nullptr);
+                    uint32_t const entry = entryOf(kernel, buffer);
+                    emulator.unmapAll();
+                    REQUIRE(emulator.map(CODE_ADDRESS, buffer, sizeof(buffer)));
+                    REQUIRE(emulator.map(X_ADDRESS, a.data(), a.size() * sizeof(float)));
+                    REQUIRE(emulator.map(Y_ADDRESS, b.data(), b.size() * sizeof(float)));
+                    REQUIRE(emulator.map(Z_ADDRESS, c.data(), c.size() * sizeof(float)));
+                    callAndCheck(emulator, entry, X_ADDRESS, Y_ADDRESS, Z_ADDRESS);
+
+                    uint32_t const rows = rowMajor ? n : m; // elements of C per leading dimension
+                    for (uint32_t i = 0; i < cSize + PADDING; i++) {
+                        CAPTURE(i);
+                        if (i >= cSize || i % ldc >= rows) REQUIRE(c[i] == (i < cSize ? static_cast<float>(i % 11) - 5.0f : -1234.0f));
+                        else REQUIRE(c[i] == expected[i]);
+                    }
+                    kernels++;
+                }
+            }
+        }
+    }
+    REQUIRE(kernels == 8 * 20 * 7 * 4);
+}
+
+TEST_CASE("Generated GEMM kernels match the reference for large leading dimensions", "[EMULATOR][GEMM]") {
+    constexpr uint32_t BUFFER_SIZE = 1 << 15;
+    constexpr uint32_t PADDING = 16;
+    alignas(4) static Instructions::Instruction16 buffer[BUFFER_SIZE];
+    Generators::Gemm gemm(buffer, BUFFER_SIZE, programStorage, sizeof(programStorage));
+    Emulator emulator;
+    struct Scaling {
+        float alpha;
+        float beta;
+    };
+    Scaling const scalings[] = {{1.0f, 1.0f}, {1.0f, 0.0f}, {2.0f, 1.0f}, {3.0f, 1.0f}};
+    // padding of lda, ldb and ldc beyond the immediate offsets of VLDRW (127 floats) and of LDR and ADDW (1023 floats)
+    struct Padding {
+        uint32_t a;
+        uint32_t b;
+        uint32_t c;
+    };
+    Padding const paddings[] = {{2000, 0, 0}, {0, 300, 0}, {0, 0, 200}, {1100, 600, 1100}};
+    // unrolled and looped i and j loops, the looped ones have fewer registers for the C rows
+    Generators::Gemm::Tuning tunings[2] = {Generators::Gemm::defaultTuning(), Generators::Gemm::defaultTuning()};
+    tunings[1].mMaxUnroll = 0;
+    tunings[1].nMaxUnroll = 0;
+
+    uint32_t kernels = 0;
+    for (uint8_t layout = 0; layout < 8; layout++) {
+        bool const rowMajor = (layout & Generators::Gemm::ROW_MAJOR) != 0;
+        bool const transposeA = (layout & Generators::Gemm::TRANSPOSE_A) != 0;
+        bool const transposeB = (layout & Generators::Gemm::TRANSPOSE_B) != 0;
+        for (uint32_t m : {1U, 5U, 12U, 13U, 16U, 21U, 45U}) {
+            for (uint32_t n : {1U, 2U, 6U, 12U, 14U}) {
+                for (uint32_t k : {1U, 7U}) for (Padding const & padding : paddings) {
+                    // the paddings change with every kernel, the scalings are shifted against them for every shape
+                    Scaling const scaling = scalings[(kernels + kernels / 4) % 4];
+                    Generators::Gemm::Tuning const & tuning = tunings[kernels / 4 % 2];
+                    uint32_t const aRows = transposeA ? k : m;
+                    uint32_t const aColumns = transposeA ? m : k;
+                    uint32_t const bRows = transposeB ? n : k;
+                    uint32_t const bColumns = transposeB ? k : n;
+                    uint32_t const lda = (rowMajor ? aColumns : aRows) + padding.a;
+                    uint32_t const ldb = (rowMajor ? bColumns : bRows) + padding.b;
+                    uint32_t const ldc = (rowMajor ? n : m) + padding.c;
+                    uint32_t const aSize = (rowMajor ? aRows : aColumns) * lda;
+                    uint32_t const bSize = (rowMajor ? bRows : bColumns) * ldb;
+                    uint32_t const cSize = (rowMajor ? m : n) * ldc;
+                    CAPTURE(layout, m, n, k, lda, ldb, ldc, scaling.alpha, scaling.beta, tuning.mMaxUnroll);
+
+                    std::vector<float> a(aSize + PADDING, NAN);
+                    std::vector<float> b(bSize + PADDING, NAN);
+                    std::vector<float> c(cSize + PADDING, -1234.0f);
+                    for (uint32_t i = 0; i < aSize; i++) a[i] = static_cast<float>(i % 13) - 6.0f + 0.25f * (i % 3);
+                    for (uint32_t i = 0; i < bSize; i++) b[i] = static_cast<float>(i % 7) - 3.0f + 0.5f * (i % 5);
+                    for (uint32_t i = 0; i < cSize; i++) c[i] = static_cast<float>(i % 11) - 5.0f;
+
+                    std::vector<float> product(cSize, 0.0f);
+                    gemm_reference(a.data(), b.data(), product.data(), n, k, m, lda, ldb, ldc, static_cast<Generators::Gemm::Layout>(layout));
+                    std::vector<float> expected(c);
+                    uint32_t const rows = rowMajor ? n : m; // elements of C per leading dimension
+                    for (uint32_t i = 0; i < cSize; i++) {
+                        if (i % ldc >= rows) continue;
+                        expected[i] = scaling.alpha * product[i] + (scaling.beta == 0.0f ? 0.0f : scaling.beta * c[i]);
+                    }
+
+                    auto kernel = gemm.generateTuned(m, k, n, lda, ldb, ldc, tuning, false, scaling.alpha, scaling.beta, static_cast<Generators::Gemm::Layout>(layout));
+                    REQUIRE(kernel != nullptr);
+                    uint32_t const entry = entryOf(kernel, buffer);
+                    emulator.unmapAll();
+                    REQUIRE(emulator.map(CODE_ADDRESS, buffer, sizeof(buffer)));
+                    REQUIRE(emulator.map(X_ADDRESS, a.data(), a.size() * sizeof(float)));
+                    REQUIRE(emulator.map(Y_ADDRESS, b.data(), b.size() * sizeof(float)));
+                    REQUIRE(emulator.map(Z_ADDRESS, c.data(), c.size() * sizeof(float)));
+                    callAndCheck(emulator, entry, X_ADDRESS, Y_ADDRESS, Z_ADDRESS);
+                    // the gaps of ldc and the padding are not written
+                    for (uint32_t i = 0; i < c.size(); i++) {
+                        CAPTURE(i);
+                        REQUIRE(c[i] == expected[i]);
+                    }
+                    kernels++;
+                }
+            }
+        }
+    }
+    REQUIRE(kernels == 8 * 7 * 5 * 2 * 4);
+}
+
+TEST_CASE("Generated Triad kernels compute c = a + scalar * b", "[EMULATOR]") {
+    constexpr uint32_t BUFFER_SIZE = 256;
+    constexpr uint32_t PADDING = 8;
+    alignas(4) static Instructions::Instruction16 buffer[BUFFER_SIZE];
+    Generators::Triad triad(buffer, BUFFER_SIZE);
+    Emulator emulator;
+
+    for (uint32_t count : {1U, 3U, 4U, 5U, 17U, 64U}) {
+        CAPTURE(count);
+        float const scalar = 1.5f;
+        // a and b are mapped without padding, the tail predicated loads must not read behind them
+        std::vector<float> a(count);
+        std::vector<float> b(count);
+        std::vector<float> c(count + PADDING, -1234.0f);
+        for (uint32_t i = 0; i < count; i++) {
+            a[i] = static_cast<float>(i % 13) - 6.0f;
+            b[i] = 0.5f * (i % 7);
+        }
+        auto kernel = triad.generate(count);
+        REQUIRE(kernel != nullptr);
+        uint32_t const entry = entryOf(kernel, buffer);
+        emulator.unmapAll();
+        REQUIRE(emulator.map(CODE_ADDRESS, buffer, sizeof(buffer)));
+        REQUIRE(emulator.map(X_ADDRESS, a.data(), a.size() * sizeof(float)));
+        REQUIRE(emulator.map(Y_ADDRESS, b.data(), b.size() * sizeof(float)));
+        REQUIRE(emulator.map(Z_ADDRESS, c.data(), c.size() * sizeof(float)));
+        // the scalar is passed in S0 (hard float ABI)
+        emulator.setVectorLane(Q0, 0, bits(scalar));
+        callAndCheck(emulator, entry, X_ADDRESS, Y_ADDRESS, Z_ADDRESS);
+        for (uint32_t i = 0; i < c.size(); i++) {
+            CAPTURE(i);
+            REQUIRE(c[i] == (i < count ? a[i] + scalar * b[i] : -1234.0f));
+        }
+    }
+}
+
+TEST_CASE("Generated Throughput kernels read the whole array", "[EMULATOR]") {
+    constexpr uint32_t BUFFER_SIZE = 256;
+    alignas(4) static Instructions::Instruction16 buffer[BUFFER_SIZE];
+    Generators::Throughput throughput(buffer, BUFFER_SIZE);
+    Emulator emulator;
+    auto kernel = throughput.generate();
+    REQUIRE(kernel != nullptr);
+    uint32_t const entry = entryOf(kernel, buffer);
+
+    for (uint32_t length : {1U, 4U, 6U, 64U, 1001U}) {
+        CAPTURE(length);
+        // mapped without padding, the last iteration is tail predicated
+        std::vector<float> a(length, 1.0f);
+        emulator.unmapAll();
+        REQUIRE(emulator.map(CODE_ADDRESS, buffer, sizeof(buffer)));
+        REQUIRE(emulator.map(X_ADDRESS, a.data(), a.size() * sizeof(float)));
+        callAndCheck(emulator, entry, X_ADDRESS, length);
+        // one post-incremented load per vector
+        REQUIRE(emulator.getRegister(R0) == X_ADDRESS + 16 * ((length + 3) / 4));
+    }
+}
+
+TEST_CASE("Fused epilogues match the reference", "[EMULATOR][GEMM]") {
+    constexpr uint32_t BUFFER_SIZE = 1 << 15;
+    constexpr uint32_t PADDING = 16;
+    constexpr uint32_t BIAS_ADDRESS = 0x4000'0000;
+    using Epilogue = Generators::Gemm::Epilogue;
+    alignas(4) static Instructions::Instruction16 buffer[BUFFER_SIZE];
+    Generators::Gemm gemm(buffer, BUFFER_SIZE, programStorage, sizeof(programStorage));
+    Generators::GemmTuningTable table;
+    gemm.setTuningTable(&table);
+    Emulator emulator;
+    // the kernels read the bias through the embedded emulator address
+    float const * const biasValues = reinterpret_cast<float const *>(static_cast<uintptr_t>(BIAS_ADDRESS));
+    Epilogue const epilogues[] = {
+        {Epilogue::BIAS_PER_ROW, biasValues, Epilogue::ACTIVATION_RELU, 0.0f, 0.0f},
+        {Epilogue::BIAS_PER_COLUMN, biasValues, Epilogue::ACTIVATION_NONE, 0.0f, 0.0f},
+        {Epilogue::BIAS_NONE, nullptr, Epilogue::ACTIVATION_RELU6, 0.0f, 0.0f},
+        {Epilogue::BIAS_PER_ROW, biasValues, Epilogue::ACTIVATION_CLAMP, -20.0f, 20.0f},
+        {Epilogue::BIAS_PER_COLUMN, biasValues, Epilogue::ACTIVATION_CLAMP, -1.0f, 30.0f},
+    };
+    struct Scaling {
+        float alpha;
+        float beta;
+    };
+    Scaling const scalings[] = {{1.0f, 1.0f}, {3.0f, 1.0f}, {2.0f, 0.0f}};
+    Generators::Gemm::Layout const layouts[] = {Generators::Gemm::COLUMN_MAJOR_NN, Generators::Gemm::ROW_MAJOR_NN, Generators::Gemm::TRANSPOSE_B};
+
+    uint32_t kernels = 0;
+    for (Generators::Gemm::Layout const layout : layouts) {
+        bool const rowMajor = (layout & Generators::Gemm::ROW_MAJOR) != 0;
+        // all NN microkernels and loops: 16x1, 8x3 and 4x6 edges, unrolled and looped i and j loops
+        for (uint32_t m : {1U, 3U, 4U, 5U, 8U, 12U, 13U, 16U, 21U, 45U, 53U}) {
+            for (uint32_t n : {1U, 2U, 3U, 5U, 6U, 7U, 12U, 13U, 14U}) {
+                for (uint32_t k : {1U, 4U}) {
+                    Epilogue const & epilogue = epilogues[kernels % 5];
+                    Scaling const scaling = scalings[kernels % 3];
+                    uint32_t const lda = (rowMajor ? k : m) + kernels % 2;
+                    bool const transposeB = layout == Generators::Gemm::TRANSPOSE_B;
+                    uint32_t const ldb = (rowMajor || transposeB ? n : k) + kernels % 3;
+                    uint32_t const ldc = (rowMajor ? n : m) + (kernels % 4 == 0 ? 5 : 0);
+                    uint32_t const aSize = (rowMajor ? m : k) * lda;
+                    uint32_t const bSize = (rowMajor || transposeB ? k : n) * ldb;
+                    uint32_t const cSize = (rowMajor ? m : n) * ldc;
+                    std::vector<float> a(aSize + PADDING, NAN);
+                    std::vector<float> b(bSize + PADDING, NAN);
+                    std::vector<float> original(cSize + PADDING, -1234.0f);
+                    // exactly one value per row / column, reading behind the bias faults
+                    std::vector<float> bias(epilogue.bias == Epilogue::BIAS_PER_ROW ? m : n);
+                    for (uint32_t i = 0; i < aSize; i++) a[i] = static_cast<float>(i % 13) - 6.0f + 0.25f * (i % 3);
+                    for (uint32_t i = 0; i < bSize; i++) b[i] = static_cast<float>(i % 7) - 3.0f + 0.5f * (i % 5);
+                    for (uint32_t i = 0; i < cSize; i++) original[i] = static_cast<float>(i % 11) - 5.0f;
+                    for (uint32_t i = 0; i < bias.size(); i++) bias[i] = static_cast<float>(i % 9) * 1.5f - 6.0f;
+
+                    std::vector<float> product(cSize, 0.0f);
+                    gemm_reference(a.data(), b.data(), product.data(), n, k, m, lda, ldb, ldc, layout);
+                    std::vector<float> expected(original);
+                    float const lower = epilogue.activation == Epilogue::ACTIVATION_CLAMP ? epilogue.clampMin : 0.0f;
+                    float const upper = epilogue.activation == Epilogue::ACTIVATION_RELU6 ? 6.0f : epilogue.clampMax;
+                    for (uint32_t i = 0; i < m; i++) {
+                        for (uint32_t j = 0; j < n; j++) {
+                            uint32_t const index = rowMajor ? i * ldc + j : j * ldc + i;
+                            float value = scaling.alpha * product[index] + (scaling.beta == 0.0f ? 0.0f : scaling.beta * original[index]);
+                            if (epilogue.bias == Epilogue::BIAS_PER_ROW) value += bias[i];
+                            if (epilogue.bias == Epilogue::BIAS_PER_COLUMN) value += bias[j];
+                            if (epilogue.activation != Epilogue::ACTIVATION_NONE && value < lower) value = lower;
+                            if ((epilogue.activation == Epilogue::ACTIVATION_RELU6 || epilogue.activation == Epilogue::ACTIVATION_CLAMP) && value > upper) value = upper;
+                            expected[index] = value;
+                        }
+                    }
+
+                    // default tuning and fully looped i and j loops with predicated edges
+                    for (bool looped : {false, true}) {
+                        CAPTURE(layout, m, n, k, lda, ldb, ldc, kernels % 5, scaling.alpha, scaling.beta, looped);
+                        table.clear();
+                        if (looped) {
+                            Generators::Gemm::Tuning tuning = Generators::Gemm::defaultTuning();
+                            tuning.mMaxUnroll = 0;
+                            tuning.nMaxUnroll = 0;
+                            tuning.predicatedEdges = true;
+                            REQUIRE(table.insert({m, k, n, lda, ldb, ldc, layout, tuning}));
+                        }
+                        auto kernel = gemm.generate(m, k, n, lda, ldb, ldc, false, scaling.alpha, scaling.beta, layout, epilogue);
+                        REQUIRE(kernel != nullptr);
+
+                        std::vector<float> c(original);
+                        uint32_t const entry = entryOf(kernel, buffer);
+                        emulator.unmapAll();
+                        REQUIRE(emulator.map(CODE_ADDRESS, buffer, sizeof(buffer)));
+                        REQUIRE(emulator.map(X_ADDRESS, a.data(), a.size() * sizeof(float)));
+                        REQUIRE(emulator.map(Y_ADDRESS, b.data(), b.size() * sizeof(float)));
+                        REQUIRE(emulator.map(Z_ADDRESS, c.data(), c.size() * sizeof(float)));
+                        REQUIRE(emulator.map(BIAS_ADDRESS, bias.data(), bias.size() * sizeof(float)));
+                        callAndCheck(emulator, entry, X_ADDRESS, Y_ADDRESS, Z_ADDRESS);
+                        // the gaps of ldc and the padding are not written
+                        for (uint32_t i = 0; i < c.size(); i++) {
+                            CAPTURE(i);
+                            REQUIRE(c[i] == expected[i]);
+                        }
+                    }
+                    kernels++;
+                }
+            }
+        }
+    }
+    REQUIRE(kernels == 3 * 11 * 9 * 2);
+}
+
+TEST_CASE("Batched GEMM kernels match the reference for every matrix", "[EMULATOR][GEMM]") {
+    constexpr uint32_t BUFFER_SIZE = 1 << 15;
+    constexpr uint32_t PADDING = 16;
+    alignas(4) static Instructions::Instruction16 buffer[BUFFER_SIZE];
+    Generators::Gemm gemm(buffer, BUFFER_SIZE, programStorage, sizeof(programStorage));
+    Emulator emulator;
+    struct Scaling {
+        float alpha;
+        float beta;
+    };
+    Scaling const scalings[] = {{1.0f, 1.0f}, {3.0f, 1.0f}, {2.0f, 0.0f}};
+    Generators::Gemm::Layout const layouts[] = {Generators::Gemm::COLUMN_MAJOR_NN, Generators::Gemm::ROW_MAJOR_NN, Generators::Gemm::TRANSPOSE_B};
+
+    /*
+    Runs the batched kernel on batch matrices of the given shape which are stride elements apart and compares them with
+    the reference of every single matrix. A stride of 0 shares the operand, the gaps between the C matrices are not written.
+    */
+    auto check = [&](Generators::Gemm::Layout layout, uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc,
+                     uint32_t batch, uint32_t strideA, uint32_t strideB, uint32_t strideC, Scaling const & scaling) {
+        bool const rowMajor = (layout & Generators::Gemm::ROW_MAJOR) != 0;
+        bool const transposeB = layout == Generators::Gemm::TRANSPOSE_B;
+        uint32_t const aSize = (rowMajor ? m : k) * lda;
+        uint32_t const bSize = (rowMajor || transposeB ? k : n) * ldb;
+        uint32_t const cSize = (rowMajor ? m : n) * ldc;
+        uint32_t const rows = rowMajor ? n : m; // elements of C per leading dimension
+        CAPTURE(layout, m, n, k, lda, ldb, ldc, batch, strideA, strideB, strideC, scaling.alpha, scaling.beta);
+
+        std::vector<float> a((batch - 1) * strideA + aSize + PADDING, NAN);
+        std::vector<float> b((batch - 1) * strideB + bSize + PADDING, NAN);
+        std::vector<float> original((batch - 1) * strideC + cSize + PADDING, -1234.0f);
+        for (uint32_t i = 0; i < a.size() - PADDING; i++) a[i] = static_cast<float>(i % 13) - 6.0f + 0.25f * (i % 3);
+        for (uint32_t i = 0; i < b.size() - PADDING; i++) b[i] = static_cast<float>(i % 7) - 3.0f + 0.5f * (i % 5);
+        for (uint32_t i = 0; i < original.size() - PADDING; i++) original[i] = static_cast<float>(i % 11) - 5.0f;
+
+        std::vector<float> expected(original);
+        for (uint32_t matrix = 0; matrix < batch; matrix++) {
+            std::vector<float> product(cSize, 0.0f);
+            gemm_reference(a.data() + matrix * strideA, b.data() + matrix * strideB, product.data(), n, k, m, lda, ldb, ldc, layout);
+            float * const cMatrix = expected.data() + matrix * strideC;
+            for (uint32_t i = 0; i < cSize; i++) {
+                if (i % ldc < rows) cMatrix[i] = scaling.alpha * product[i] + (scaling.beta == 0.0f ? 0.0f : scaling.beta * cMatrix[i]);
+            }
+        }
+
+        auto kernel = gemm.generateBatched(m, k, n, lda, ldb, ldc, batch, strideA, strideB, strideC, false, scaling.alpha, scaling.beta, layout);
+        REQUIRE(kernel != nullptr);
+        std::vector<float> c(original);
+        emulator.unmapAll();
+        REQUIRE(emulator.map(CODE_ADDRESS, buffer, sizeof(buffer)));
+        REQUIRE(emulator.map(X_ADDRESS, a.data(), a.size() * sizeof(float)));
+        REQUIRE(emulator.map(Y_ADDRESS, b.data(), b.size() * sizeof(float)));
+        REQUIRE(emulator.map(Z_ADDRESS, c.data(), c.size() * sizeof(float)));
+        // R9 holds the batch counter inside the kernel and is restored
+        callAndCheck(emulator, entryOf(kernel, buffer), X_ADDRESS, Y_ADDRESS, Z_ADDRESS);
+        for (uint32_t i = 0; i < c.size(); i++) {
+            CAPTURE(i);
+            REQUIRE(c[i] == expected[i]);
+        }
+    };
+
+    uint32_t kernels = 0;
+    for (Generators::Gemm::Layout const layout : layouts) {
+        bool const rowMajor = (layout & Generators::Gemm::ROW_MAJOR) != 0;
+        bool const transposeB = layout == Generators::Gemm::TRANSPOSE_B;
+        for (uint32_t m : {1U, 5U, 8U, 13U, 21U}) {
+            for (uint32_t n : {1U, 3U, 7U, 14U}) {
+                for (uint32_t k : {1U, 3U, 5U}) {
+                    uint32_t const lda = (rowMajor ? k : m) + kernels % 2;
+                    uint32_t const ldb = (rowMajor || transposeB ? n : k) + kernels % 3;
+                    uint32_t const ldc = (rowMajor ? n : m) + (kernels % 4 == 0 ? 5 : 0);
+                    uint32_t const aSize = (rowMajor ? m : k) * lda;
+                    uint32_t const bSize = (rowMajor || transposeB ? k : n) * ldb;
+                    uint32_t const cSize = (rowMajor ? m : n) * ldc;
+                    uint32_t const batch = 2 + kernels % 3;
+                    // consecutive matrices, gaps between them, shared A, shared B and strides beyond the 12 bit immediates
+                    switch (kernels % 5) {
+                        case 0: check(layout, m, k, n, lda, ldb, ldc, batch, aSize, bSize, cSize, scalings[kernels % 3]); break;
+                        case 1: check(layout, m, k, n, lda, ldb, ldc, batch, aSize + 3, bSize + 1, cSize + 2, scalings[kernels % 3]); break;
+                        case 2: check(layout, m, k, n, lda, ldb, ldc, batch, 0, bSize, cSize + 1, scalings[kernels % 3]); break;
+                        case 3: check(layout, m, k, n, lda, ldb, ldc, batch, aSize, 0, cSize, scalings[kernels % 3]); break;
+                        default: check(layout, m, k, n, lda, ldb, ldc, batch, aSize + 1100, bSize + 1200, cSize + 1300, scalings[kernels % 3]); break;
+                    }
+                    kernels++;
+                }
+            }
+        }
+    }
+    REQUIRE(kernels == 3 * 5 * 4 * 3);
+
+    // a counter beyond the 8 bit immediates, only C advances
+    check(Generators::Gemm::COLUMN_MAJOR_NN, 3, 2, 2, 3, 2, 3, 300, 0, 0, 6, scalings[1]);
+    // a single matrix is generated without the batch loop
+    check(Generators::Gemm::COLUMN_MAJOR_NN, 13, 5, 7, 13, 5, 13, 1, 1000, 1000, 1000, scalings[0]);
+    REQUIRE(gemm.generateBatched(13, 5, 7, 13, 5, 13, 0, 65, 35, 91) == nullptr);
+}
+
+TEST_CASE("Kernels with alpha == 0 scale C without reading A and B", "[EMULATOR][GEMM]") {
+    constexpr uint32_t BUFFER_SIZE = 1 << 12;
+    constexpr uint32_t PADDING = 16;
+    constexpr uint32_t BIAS_ADDRESS = 0x4000'0000;
+    using Epilogue = Generators::Gemm::Epilogue;
+    alignas(4) static Instructions::Instruction16 buffer[BUFFER_SIZE];
+    Generators::Gemm gemm(buffer, BUFFER_SIZE, programStorage, sizeof(programStorage));
+    Emulator emulator;
+    float const * const biasValues = reinterpret_cast<float const *>(static_cast<uintptr_t>(BIAS_ADDRESS));
+    Epilogue const epilogues[] = {
+        {},
+        {Epilogue::BIAS_PER_ROW, biasValues, Epilogue::ACTIVATION_RELU, 0.0f, 0.0f},
+        {Epilogue::BIAS_PER_COLUMN, biasValues, Epilogue::ACTIVATION_CLAMP, -3.0f, 4.0f},
+    };
+    Generators::Gemm::Layout const layouts[] = {Generators::Gemm::COLUMN_MAJOR_NN, Generators::Gemm::ROW_MAJOR_NN, Generators::Gemm::TRANSPOSE_B, Generators::Gemm::PACKED};
+
+    // A and B are not mapped, every access faults
+    auto check = [&](Generators::Gemm::Layout layout, uint32_t m, uint32_t n, uint32_t ldc, float beta, Epilogue const & epilogue, uint32_t batch, uint32_t strideC) {
+        bool const rowMajor = (layout & Generators::Gemm::ROW_MAJOR) != 0;
+        uint32_t const cSize = (rowMajor ? m : n) * ldc;
+        CAPTURE(layout, m, n, ldc, beta, static_cast<uint32_t>(epilogue.bias), static_cast<uint32_t>(epilogue.activation), batch, strideC);
+        std::vector<float> original((batch - 1) * strideC + cSize + PADDING, -1234.0f);
+        std::vector<float> bias(epilogue.bias == Epilogue::BIAS_PER_ROW ? m : n);
+        // beta == 0 must not load C, NaNs are overwritten
+        for (uint32_t i = 0; i < original.size() - PADDING; i++) original[i] = beta == 0.0f ? NAN : static_cast<float>(i % 11) - 5.0f;
+        for (uint32_t i = 0; i < bias.size(); i++) bias[i] = static_cast<float>(i % 9) * 1.5f - 6.0f;
+
+        std::vector<float> expected(original);
+        float const lower = epilogue.activation == Epilogue::ACTIVATION_CLAMP ? epilogue.clampMin : 0.0f;
+        for (uint32_t matrix = 0; matrix < batch; matrix++) {
+            for (uint32_t i = 0; i < m; i++) {
+                for (uint32_t j = 0; j < n; j++) {
+                    uint32_t const index = matrix * strideC + (rowMajor ? i * ldc + j : j * ldc + i);
+                    float value = beta == 0.0f ? 0.0f : beta * original[index];
+                    if (epilogue.bias == Epilogue::BIAS_PER_ROW) value += bias[i];
+                    if (epilogue.bias == Epilogue::BIAS_PER_COLUMN) value += bias[j];
+                    if (epilogue.activation != Epilogue::ACTIVATION_NONE && value < lower) value = lower;
+                    if (epilogue.activation == Epilogue::ACTIVATION_CLAMP && value > epilogue.clampMax) value = epilogue.clampMax;
+                    expected[index] = value;
+                }
+            }
+        }
+
+        auto kernel = batch == 1 ? gemm.generate(m, 4, n, m, 4, ldc, false, 0.0f, beta, layout, epilogue)
+            : gemm.generateBatched(m, 4, n, m, 4, ldc, batch, 0, 0, strideC, false, 0.0f, beta, layout, epilogue);
+        REQUIRE(kernel != nullptr);
+        std::vector<float> c(original);
+        uint32_t const entry = entryOf(kernel, buffer);
+        emulator.unmapAll();
+        REQUIRE(emulator.map(CODE_ADDRESS, buffer, sizeof(buffer)));
+        REQUIRE(emulator.map(Z_ADDRESS, c.data(), c.size() * sizeof(float)));
+        if (epilogue.bias != Epilogue::BIAS_NONE) REQUIRE(emulator.map(BIAS_ADDRESS, bias.data(), bias.size() * sizeof(float)));
+        callAndCheck(emulator, entry, X_ADDRESS, Y_ADDRESS, Z_ADDRESS);
+        // the gaps of ldc and between the matrices and the padding are not written
+        for (uint32_t i = 0; i < c.size(); i++) {
+            CAPTURE(i);
+            if (std::isnan(expected[i])) REQUIRE(std::isnan(c[i]));
+            else REQUIRE(c[i] == expected[i]);
+        }
+    };
+
+    uint32_t kernels = 0;
+    for (Generators::Gemm::Layout const layout : layouts) {
+        bool const rowMajor = (layout & Generators::Gemm::ROW_MAJOR) != 0;
+        // full and tail predicated vectors of the column loop
+        for (uint32_t m : {1U, 3U, 4U, 5U, 8U, 13U, 21U}) {
+            for (uint32_t n : {1U, 2U, 7U}) {
+                for (float beta : {0.0f, 1.0f, 2.5f, -0.5f}) {
+                    uint32_t const ldc = (rowMajor ? n : m) + (kernels % 3 == 0 ? 5 : 0);
+                    check(layout, m, n, ldc, beta, epilogues[kernels % 3], 1, 0);
+                    kernels++;
+                }
+            }
+        }
+    }
+    REQUIRE(kernels == 4 * 7 * 3 * 4);
+
+    // the column bias restarts with every matrix of the batch, large strides and ldc need a temp register
+    check(Generators::Gemm::COLUMN_MAJOR_NN, 13, 3, 13 + 2, 2.5f, epilogues[2], 3, 3 * 15 + 7);
+    check(Generators::Gemm::ROW_MAJOR_NN, 5, 6, 6, 0.0f, epilogues[1], 2, 30);
+    check(Generators::Gemm::COLUMN_MAJOR_NN, 7, 3, 7 + 1100, -0.5f, epilogues[1], 2, 3 * 1107 + 1200);
+    check(Generators::Gemm::COLUMN_MAJOR_NN, 6, 2, 6, 1.0f, epilogues[0], 3, 12);
+}
+
+TEST_CASE("Single column 8x3 edges don't store behind C", "[EMULATOR][GEMM]") {
+    constexpr uint32_t BUFFER_SIZE = 1 << 14;
+    constexpr uint32_t PADDING = 16;
+    alignas(4) static Instructions::Instruction16 buffer[BUFFER_SIZE];
+    Generators::Gemm gemm(buffer, BUFFER_SIZE, programStorage, sizeof(programStorage));
+    Emulator emulator;
+
+    // n % 3 == 1 ends with an 8x1 corner for m % 8 >= 5, unscaled its right vector is predicated with a VPT block.
+    // without a gap (ldc == m) the rows behind the last column are the padding
+    uint32_t kernels = 0;
+    for (uint32_t m : {5U, 6U, 7U, 13U, 14U, 15U, 23U}) {
+        for (uint32_t n : {4U, 7U}) {
+            for (uint32_t k : {1U, 2U, 5U}) {
+                CAPTURE(m, n, k);
+                std::vector<float> a(k * m + PADDING, 1.0f);
+                std::vector<float> b(n * k + PADDING, 0.5f);
+                std::vector<float> c(n * m + PADDING, -1234.0f);
+                for (uint32_t i = 0; i < n * m; i++) c[i] = static_cast<float>(i % 11) - 5.0f;
+                std::vector<float> expected(c);
+                gemm_reference(a.data(), b.data(), expected.data(), n, k, m, m, k, m, Generators::Gemm::COLUMN_MAJOR_NN);
+
+                auto kernel = gemm.generate(m, k, n, m, k, m);
+                REQUIRE(kernel != nullptr);
+                uint32_t const entry = entryOf(kernel, buffer);
+                emulator.unmapAll();
+                REQUIRE(emulator.map(CODE_ADDRESS, buffer, sizeof(buffer)));
+                REQUIRE(emulator.map(X_ADDRESS, a.data(), a.size() * sizeof(float)));
+                REQUIRE(emulator.map(Y_ADDRESS, b.data(), b.size() * sizeof(float)));
+                REQUIRE(emulator.map(Z_ADDRESS, c.data(), c.size() * sizeof(float)));
+                callAndCheck(emulator, entry, X_ADDRESS, Y_ADDRESS, Z_ADDRESS);
+                for (uint32_t i = 0; i < c.size(); i++) {
+                    CAPTURE(i);
+                    REQUIRE(c[i] == expected[i]);
+                }
+                kernels++;
+            }
+        }
+    }
+    REQUIRE(kernels == 7 * 2 * 3);
+}
+
+TEST_CASE("Predicated M edges match the remainder microkernels", "[EMULATOR][GEMM]") {
+    constexpr uint32_t BUFFER_SIZE = 1 << 15;
+    constexpr uint32_t PADDING = 16;
+    alignas(4) static Instructions::Instruction16 buffer[BUFFER_SIZE];
+    Generators::Gemm gemm(buffer, BUFFER_SIZE, programStorage, sizeof(programStorage));
+    Emulator emulator;
+    struct Scaling {
+        float alpha;
+        float beta;
+    };
+    Scaling const scalings[] = {{1.0f, 1.0f}, {1.0f, 0.0f}, {2.0f, 1.0f}, {0.5f, 2.0f}};
+
+    uint32_t kernels = 0;
+    for (uint32_t m = 9; m <= 30; m++) {
+        for (uint32_t n = 1; n <= 7; n++) {
+            for (uint32_t k : {1U, 2U, 5U}) {
+                Scaling const scaling = scalings[kernels % 4];
+                uint32_t const lda = m + kernels % 3;
+                uint32_t const ldb = k + kernels % 2;
+                // the large leading dimension moves the C rows into registers
+                uint32_t const ldc = m + (kernels % 3 == 0 ? 150 : kernels % 3);
+                uint32_t const aSize = k * lda;
+                uint32_t const bSize = n * ldb;
+                uint32_t const cSize = n * ldc;
+                std::vector<float> a(aSize + PADDING, NAN);
+                std::vector<float> b(bSize + PADDING, NAN);
+                std::vector<float> original(cSize + PADDING, -1234.0f);
+                for (uint32_t i = 0; i < aSize; i++) a[i] = static_cast<float>(i % 13) - 6.0f + 0.25f * (i % 3);
+                for (uint32_t i = 0; i < bSize; i++) b[i] = static_cast<float>(i % 7) - 3.0f + 0.5f * (i % 5);
+                for (uint32_t i = 0; i < cSize; i++) original[i] = static_cast<float>(i % 11) - 5.0f;
+
+                std::vector<float> product(cSize, 0.0f);
+                gemm_reference(a.data(), b.data(), product.data(), n, k, m, lda, ldb, ldc, Generators::Gemm::COLUMN_MAJOR_NN);
+                std::vector<float> expected(original);
+                for (uint32_t i = 0; i < cSize; i++) {
+                    if (i % ldc >= m) continue;
+                    expected[i] = scaling.alpha * product[i] + (scaling.beta == 0.0f ? 0.0f : scaling.beta * original[i]);
+                }
+
+                // the looped i loop uses the predicated edge, the unrolled one places the edge microkernel
+                for (uint8_t mMaxUnroll : {0, 8}) {
+                    uint16_t sizes[2];
+                    for (bool predicatedEdges : {false, true}) {
+                        CAPTURE(m, n, k, lda, ldb, ldc, scaling.alpha, scaling.beta, mMaxUnroll, predicatedEdges);
+                        Generators::Gemm::Tuning tuning = Generators::Gemm::defaultTuning();
+                        tuning.mMaxUnroll = mMaxUnroll;
+                        tuning.predicatedEdges = predicatedEdges;
+                        auto kernel = gemm.generateTuned(m, k, n, lda, ldb, ldc, tuning, false, scaling.alpha, scaling.beta);
+                        REQUIRE(kernel != nullptr);
+                        sizes[predicatedEdges] = gemm.getInstructionCount();
+
+                        std::vector<float> c(original);
+                        uint32_t const entry = entryOf(kernel, buffer);
+                        emulator.unmapAll();
+                        REQUIRE(emulator.map(CODE_ADDRESS, buffer, sizeof(buffer)));
+                        REQUIRE(emulator.map(X_ADDRESS, a.data(), a.size() * sizeof(float)));
+                        REQUIRE(emulator.map(Y_ADDRESS, b.data(), b.size() * sizeof(float)));
+                        REQUIRE(emulator.map(Z_ADDRESS, c.data(), c.size() * sizeof(float)));
+                        callAndCheck(emulator, entry, X_ADDRESS, Y_ADDRESS, Z_ADDRESS);
+                        // the rows behind the last block are not written, neither are the gaps of ldc and the padding
+                        for (uint32_t i = 0; i < c.size(); i++) {
+                            CAPTURE(i);
+                            REQUIRE(c[i] == expected[i]);
+                        }
+                    }
+                    // the edge microkernels of the i loops are dropped, the n tail (n > 3) always loops over i
+                    bool const iLoop = !(m <= 16 && n == 1) && (mMaxUnroll == 0 || (n > 3 && n % 3 != 0));
+                    if (m % 8 > 4 && iLoop) REQUIRE(sizes[1] < sizes[0]);
+                    else REQUIRE(sizes[1] == sizes[0]);
+                    kernels++;
+                }
+            }
+        }
+    }
+    REQUIRE(kernels == 22 * 7 * 3 * 2);
+}
+
+TEST_CASE("Kernels which don't fit into the buffer use predicated edges", "[EMULATOR][GEMM]") {
+    constexpr uint32_t BUFFER_SIZE = 1 << 15;
+    alignas(4) static Instructions::Instruction16 buffer[BUFFER_SIZE];
+    Generators::Gemm large(buffer, BUFFER_SIZE, programStorage, sizeof(programStorage));
+    // m % 8 == 5 with a looped i loop
+    GemmTestHelper::Shape const shape = {15, 40, 7, 15, 40, 15};
+    Generators::Gemm::Tuning tuning = Generators::Gemm::defaultTuning();
+    tuning.predicatedEdges = true;
+    REQUIRE(large.generateTuned(shape.m, shape.k, shape.n, shape.lda, shape.ldb, shape.ldc, tuning) != nullptr);
+    uint32_t const predicatedSize = large.getInstructionCount();
+    REQUIRE(large.generate(shape.m, shape.k, shape.n, shape.lda, shape.ldb, shape.ldc) != nullptr);
+    REQUIRE(large.getInstructionCount() > predicatedSize + 2U);
+
+    uint32_t const bufferSize = predicatedSize + 3;
+    Generators::Gemm small(buffer, bufferSize, programStorage, sizeof(programStorage));
+    Emulator emulator;
+    GemmTestHelper::checkKernel(emulator, buffer, bufferSize, shape, [&](Emulator &, GemmTestHelper::Shape const & s) {
+        Generators::Gemm::Func const kernel = small.generate(s.m, s.k, s.n, s.lda, s.ldb, s.ldc);
+        REQUIRE(small.getInstructionCount() == predicatedSize);
+        return kernel;
+    });
+}
+
+TEST_CASE("Kernels which don't fit into the buffer are not returned", "[EMULATOR][GEMM]") {
+    constexpr uint32_t BUFFER_SIZE = 128;
+    alignas(4) static Instructions::Instruction16 buffer[BUFFER_SIZE];
+    Generators::Gemm gemm(buffer, BUFFER_SIZE, programStorage, sizeof(programStorage));
+    GemmTestHelper::Shape const fitting = {8, 4, 3, 8, 4, 8};
+    Emulator emulator;
+    auto generate = [&](Emulator &, GemmTestHelper::Shape const & s) {
+        return gemm.generate(s.m, s.k, s.n, s.lda, s.ldb, s.ldc);
+    };
+    GemmTestHelper::checkKernel(emulator, buffer, BUFFER_SIZE, fitting, generate);
+
+    // the buffer still holds the previous kernel, which must not be returned for the other shape
+    Generators::Gemm::Tuning tuning = Generators::Gemm::defaultTuning();
+    tuning.predicatedEdges = true;
+    REQUIRE(gemm.generate(61, 16, 24, 61, 16, 61) == nullptr);
+    REQUIRE(gemm.generateTuned(61, 16, 24, 61, 16, 61, tuning) == nullptr);
+    REQUIRE(gemm.generateBatched(61, 16, 24, 61, 16, 61, 2, 61 * 16, 16 * 24, 61 * 24) == nullptr);
+    REQUIRE(gemm.getInstructionCount() == 0);
+    GemmTestHelper::checkKernel(emulator, buffer, BUFFER_SIZE, fitting, generate);
+}
+
+TEST_CASE("Kernels whose program doesn't fit into the arena are not returned", "[EMULATOR][GEMM]") {
+    constexpr uint32_t BUFFER_SIZE = 1 << 12;
+    alignas(4) static Instructions::Instruction16 buffer[BUFFER_SIZE];
+    // the arena of the buffer size holds the program of any kernel which fits into the buffer
+    Generators::Gemm sized(buffer, BUFFER_SIZE, programStorage, Generators::Gemm::programStorageSize(BUFFER_SIZE));
+    GemmTestHelper::Shape const shape = {15, 40, 7, 15, 40, 15};
+    Emulator emulator;
+    uint32_t size = 0;
+    GemmTestHelper::checkKernel(emulator, buffer, BUFFER_SIZE, shape, [&](Emulator &, GemmTestHelper::Shape const & s) {
+        Generators::Gemm::Func const kernel = sized.generate(s.m, s.k, s.n, s.lda, s.ldb, s.ldc);
+        size = sized.getInstructionCount();
+        return kernel;
+    });
+    // at most 4 halfwords per node, the small arena drops some of them
+    REQUIRE(size > 4 * Generators::Gemm::PROGRAM_MAX_LABELS);
+    Generators::Gemm small(buffer, BUFFER_SIZE, programStorage, Generators::Gemm::programStorageSize(0));
+    REQUIRE(small.generate(shape.m, shape.k, shape.n, shape.lda, shape.ldb, shape.ldc) == nullptr);
+    REQUIRE(small.getInstructionCount() == 0);
+}
+
+TEST_CASE("Large leading dimensions use the allocated registers", "[EMULATOR][GEMM]") {
+    constexpr uint32_t BUFFER_SIZE = 1 << 15;
+    constexpr uint32_t PADDING = 16;
+    alignas(4) static Instructions::Instruction16 buffer[BUFFER_SIZE];
+    Generators::Gemm gemm(buffer, BUFFER_SIZE, programStorage, sizeof(programStorage));
+    Emulator emulator;
+    struct Shape {
+        uint32_t m;
+        uint32_t n;
+    };
+    // both loops with 4x6 edges, only the j loop (4x6), only the i loop, a single microkernel and M / N compares in registers
+    Shape const shapes[] = {{12, 12}, {13, 14}, {20, 14}, {45, 12}, {4, 13}, {21, 2}, {16, 1}, {257, 4}, {12, 257}};
+    struct Scaling {
+        float alpha;
+        float beta;
+    };
+    // without scaling and k loops LR holds allocated values as well
+    Scaling const scalings[] = {{1.0f, 1.0f}, {2.0f, 1.0f}};
+
+    uint32_t kernels = 0;
+    for (Shape const & shape : shapes) {
+        uint32_t const m = shape.m, n = shape.n;
+        for (uint32_t k : {1U, 3U, 7U}) {
+            // lda, ldb (and the second B pointer of the 4x6 microkernels) and the C rows don't fit into the immediates
+            uint32_t const lda = m + 1100;
+            uint32_t const ldb = k + 600;
+            uint32_t const ldc = m + 1100;
+            uint32_t const aSize = k * lda;
+            uint32_t const bSize = n * ldb;
+            uint32_t const cSize = n * ldc;
+            std::vector<float> a(aSize + PADDING, NAN);
+            std::vector<float> b(bSize + PADDING, NAN);
+            std::vector<float> original(cSize + PADDING, -1234.0f);
+            for (uint32_t i = 0; i < aSize; i++) a[i] = static_cast<float>(i % 13) - 6.0f + 0.25f * (i % 3);
+            for (uint32_t i = 0; i < bSize; i++) b[i] = static_cast<float>(i % 7) - 3.0f + 0.5f * (i % 5);
+            for (uint32_t i = 0; i < cSize; i++) original[i] = static_cast<float>(i % 11) - 5.0f;
+            std::vector<float> product(cSize, 0.0f);
+            gemm_reference(a.data(), b.data(), product.data(), n, k, m, lda, ldb, ldc, Generators::Gemm::COLUMN_MAJOR_NN);
+
+            for (Scaling const & scaling : scalings) {
+                std::vector<float> expected(original);
+                for (uint32_t i = 0; i < cSize; i++) {
+                    if (i % ldc >= m) continue;
+                    expected[i] = scaling.alpha * product[i] + scaling.beta * original[i];
+                }
+                // unrolled and looped i and j loops
+                for (uint8_t maxUnroll : {0, 8}) {
+                    CAPTURE(m, n, k, lda, ldb, ldc, scaling.alpha, scaling.beta, maxUnroll);
+                    Generators::Gemm::Tuning tuning = Generators::Gemm::defaultTuning();
+                    tuning.mMaxUnroll = maxUnroll;
+                    tuning.nMaxUnroll = maxUnroll;
+                    auto kernel = gemm.generateTuned(m, k, n, lda, ldb, ldc, tuning, false, scaling.alpha, scaling.beta);
+                    REQUIRE(kernel != nullptr);
+
+                    std::vector<float> c(original);
+                    uint32_t const entry = entryOf(kernel, buffer);
+                    emulator.unmapAll();
+                    REQUIRE(emulator.map(CODE_ADDRESS, buffer, sizeof(buffer)));
+                    REQUIRE(emulator.map(X_ADDRESS, a.data(), a.size() * sizeof(float)));
+                    REQUIRE(emulator.map(Y_ADDRESS, b.data(), b.size() * sizeof(float)));
+                    REQUIRE(emulator.map(Z_ADDRESS, c.data(), c.size() * sizeof(float)));
+                    callAndCheck(emulator, entry, X_ADDRESS, Y_ADDRESS, Z_ADDRESS);
+                    // the gaps of ldc and the padding are not written
+                    for (uint32_t i = 0; i < c.size(); i++) {
+                        CAPTURE(i);
+                        REQUIRE(c[i] == expected[i]);
+                    }
+                    kernels++;
+                }
+            }
+        }
+    }
+    REQUIRE(kernels == 9 * 3 * 2 * 2);
+}
@@ -0,0 +1,123 @@
+#include "catch2/catch_amalgamated.hpp"
+#include "emulator/Emulator.hpp"
+#include "generators/Gemm.hpp"
+#include "generators/GemmBlocked.hpp"
+#include "generators/GemmCache.hpp"
+#include "gemm_test_helper.hpp"
+#include "helper/gemm_reference.hpp"
+
+#include <cstdint>
+#include <vector>
+
+using namespace JIT;
+using namespace JIT::Instructions;
+using namespace GemmTestHelper;
+
+namespace {
+    constexpr uint32_t STAGING_SIZE = 1 << 14;
+    constexpr uint32_t SCRATCH_SIZE = 1024; // packed panels, mapped at X_ADDRESS
+
+    // host addresses of the mapped areas, the kernels are called with their emulator addresses
+    struct EmulatedCalls {
+        Emulator emulator;
+        Instruction16 const * region;
+        float const * scratch;
+        float const * c;
+        uint32_t calls;
+    };
+
+    void callInEmulator(Generators::Gemm::Func kernel, float const * a, float const * b, float * c, void * context) {
+        EmulatedCalls & calls = *static_cast<EmulatedCalls *>(context);
+        CAPTURE(calls.calls);
+        callAndCheck(calls.emulator, entryOf(kernel, calls.region),
+            emulatorAddress(X_ADDRESS, calls.scratch, a), emulatorAddress(X_ADDRESS, calls.scratch, b), emulatorAddress(Z_ADDRESS, calls.c, c));
+        calls.calls++;
+    }
+}
+
+
+TEST_CASE("Blocks fit into the scratch area", "[GEMM][BLOCKED]") {
+    using Blocked = Generators::GemmBlocked;
+    Blocked::Blocking const whole = Blocked::chooseBlocking(24, 24, 24, 4096);
+    REQUIRE((whole.mc == 24 && whole.kc == 24 && whole.nc == 24));
+
+    Blocked::Blocking const blocking = Blocked::chooseBlocking(37, 300, 29, SCRATCH_SIZE);
+    REQUIRE(blocking.kc > 0);
+    REQUIRE(blocking.kc * (blocking.mc + blocking.nc) <= SCRATCH_SIZE);
+    REQUIRE(blocking.mc % Blocked::MR == 0);
+    REQUIRE(blocking.nc % Blocked::NR == 0);
+    REQUIRE(Blocked::chooseBlocking(37, 300, 29, 8).kc == 0);
+}
+
+TEST_CASE("Blocked GEMM matches the reference for several blocks", "[EMULATOR][GEMM][BLOCKED]") {
+    alignas(4) static Instruction16 staging[STAGING_SIZE];
+    alignas(4) static Instruction16 region[STAGING_SIZE];
+    alignas(4) static float scratch[SCRATCH_SIZE + PADDING];
+    Generators::Gemm generator(staging, STAGING_SIZE, programStorage, sizeof(programStorage));
+    Generators::GemmCache cache(generator, region, STAGING_SIZE);
+    Generators::GemmBlocked blocked(cache, scratch, SCRATCH_SIZE);
+
+    struct Problem {
+        uint32_t m, k, n;
+        uint32_t lda, ldb, ldc;
+        float alpha, beta;
+        Generators::GemmBlocked::Blocking blocking; // {0, 0, 0}: chosen for the scratch area
+    };
+    // every dimension is split into several blocks, the last blocks are partial
+    Problem const problems[] = {
+        {37, 300, 29, 37, 300, 37, 1.0f, 1.0f, {0, 0, 0}},
+        {37, 300, 29, 40, 301, 45, 2.0f, 0.5f, {0, 0, 0}},
+        {45, 70, 20, 45, 70, 50, 1.0f, 0.0f, {16, 30, 12}},
+        {21, 50, 13, 23, 50, 21, 3.0f, 1.0f, {16, 20, 6}},
+    };
+    EmulatedCalls calls;
+    for (Problem const & problem : problems) {
+        uint32_t const m = problem.m, k = problem.k, n = problem.n;
+        CAPTURE(m, k, n, problem.lda, problem.ldb, problem.ldc, problem.alpha, problem.beta, problem.blocking.mc, problem.blocking.kc, problem.blocking.nc);
+        uint32_t const aSize = k * problem.lda;
+        uint32_t const bSize = n * problem.ldb;
+        uint32_t const cSize = n * problem.ldc;
+        // multiples of 1/8 with small magnitudes, all sums are exact in any order
+        std::vector<float> a(aSize);
+        std::vector<float> b(bSize);
+        std::vector<float> c(cSize + PADDING, -1234.0f);
+        for (uint32_t i = 0; i < aSize; i++) a[i] = static_cast<float>(i % 13) - 6.0f + 0.25f * (i % 3);
+        for (uint32_t i = 0; i < bSize; i++) b[i] = static_cast<float>(i % 7) - 3.0f + 0.5f * (i % 5);
+        for (uint32_t i = 0; i < cSize; i++) c[i] = static_cast<float>(i % 11) - 5.0f;
+
+        std::vector<float> product(cSize, 0.0f);
+        gemm_reference(a.data(), b.data(), product.data(), n, k, m, problem.lda, problem.ldb, problem.ldc, Generators::Gemm::COLUMN_MAJOR_NN);
+        std::vector<float> expected(c);
+        for (uint32_t i = 0; i < cSize; i++) {
+            if (i % problem.ldc >= m) continue;
+            expected[i] = problem.alpha * product[i] + (problem.beta == 0.0f ? 0.0f : problem.beta * c[i]);
+        }
+
+        // the packed panels and C are accessed by the kernels, A and B only by the packing on the host
+        calls.emulator.unmapAll();
+        REQUIRE(calls.emulator.map(CODE_ADDRESS, region, sizeof(region)));
+        REQUIRE(calls.emulator.map(X_ADDRESS, scratch, sizeof(scratch)));
+        REQUIRE(calls.emulator.map(Z_ADDRESS, c.data(), c.size() * sizeof(float)));
+        calls.region = region;
+        calls.scratch = scratch;
+        calls.c = c.data();
+        calls.calls = 0;
+        blocked.setKernelCaller(callInEmulator, &calls);
+
+        bool const chosen = problem.blocking.kc == 0;
+        bool const success = chosen
+            ? blocked.run(a.data(), b.data(), c.data(), m, k, n, problem.lda, problem.ldb, problem.ldc, problem.alpha, problem.beta)
+            : blocked.run(a.data(), b.data(), c.data(), m, k, n, problem.lda, problem.ldb, problem.ldc, problem.blocking, problem.alpha, problem.beta);
+        REQUIRE(success);
+        Generators::GemmBlocked::Blocking const blocking = chosen ? Generators::GemmBlocked::chooseBlocking(m, k, n, SCRATCH_SIZE) : problem.blocking;
+        uint32_t const blocks = (m + blocking.mc - 1) / blocking.mc * ((k + blocking.kc - 1) / blocking.kc) * ((n + blocking.nc - 1) / blocking.nc);
+        REQUIRE(blocks > 8);
+        REQUIRE(calls.calls == blocks);
+
+        // the rows behind m (ldc gap) and the padding behind C are not written
+        for (uint32_t i = 0; i < c.size(); i++) {
+            CAPTURE(i);
+            REQUIRE(c[i] == expected[i]);
+        }
+    }
+}
@@ -0,0 +1,173 @@
+#include "catch2/catch_amalgamated.hpp"
+#include "emulator/Emulator.hpp"
+#include "generators/Gemm.hpp"
+#include "generators/GemmCache.hpp"
+#include "gemm_test_helper.hpp"
+#include "helper/gemm_reference.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using namespace JIT;
+using namespace JIT::Instructions;
+using namespace GemmTestHelper;
+
+namespace {
+    constexpr uint32_t STAGING_SIZE = 1 << 12;
+
+    Instruction16 const * code(Generators::Gemm::Func func) {
+        return reinterpret_cast<Instruction16 const *>(reinterpret_cast<uintptr_t>(func) & ~static_cast<uintptr_t>(1));
+    }
+
+    // size of the kernel in the cache (word aligned)
+    uint32_t kernelSize(Generators::Gemm & generator, uint32_t m, uint32_t k, uint32_t n) {
+        REQUIRE(generator.generate(m, k, n, m, k, m) != nullptr);
+        return (generator.getInstructionCount() + 1) & ~1U;
+    }
+}
+
+
+TEST_CASE("Kernel cache keys", "[GEMM][CACHE]") {
+    using Cache = Generators::GemmCache;
+    REQUIRE(Cache::makeKey(8, 4, 3, 8, 4, 8) == Cache::makeKey(8, 4, 3, 8, 4, 8, false, 1.0f, 1.0f, Generators::Gemm::COLUMN_MAJOR_NN));
+    REQUIRE_FALSE(Cache::makeKey(8, 4, 3, 8, 4, 8) == Cache::makeKey(8, 4, 3, 9, 4, 8));
+    REQUIRE_FALSE(Cache::makeKey(8, 4, 3, 8, 4, 8) == Cache::makeKey(8, 4, 3, 8, 4, 8, true));
+    REQUIRE_FALSE(Cache::makeKey(8, 4, 3, 8, 4, 8) == Cache::makeKey(8, 4, 3, 8, 4, 8, false, 2.0f));
+    REQUIRE_FALSE(Cache::makeKey(8, 4, 3, 8, 4, 8) == Cache::makeKey(8, 4, 3, 8, 4, 8, false, 1.0f, 0.0f));
+    REQUIRE_FALSE(Cache::makeKey(8, 4, 3, 8, 4, 8) == Cache::makeKey(8, 4, 3, 8, 4, 8, false, 1.0f, 1.0f, Generators::Gemm::ROW_MAJOR_NN));
+    // the scalars are compared bitwise
+    REQUIRE_FALSE(Cache::makeKey(8, 4, 3, 8, 4, 8, false, 1.0f, 0.0f) == Cache::makeKey(8, 4, 3, 8, 4, 8, false, 1.0f, -0.0f));
+
+    // the epilogue is part of the key, only the values which end up in the kernel are compared
+    using Epilogue = Generators::Gemm::Epilogue;
+    float const * const bias = reinterpret_cast<float const *>(static_cast<uintptr_t>(0x4000'0000));
+    auto const withEpilogue = [](Epilogue const & epilogue) {
+        return Cache::makeKey(8, 4, 3, 8, 4, 8, false, 1.0f, 1.0f, Generators::Gemm::COLUMN_MAJOR_NN, epilogue);
+    };
+    Epilogue const rowBias = {Epilogue::BIAS_PER_ROW, bias, Epilogue::ACTIVATION_NONE, 0.0f, 0.0f};
+    REQUIRE(withEpilogue({}) == Cache::makeKey(8, 4, 3, 8, 4, 8));
+    REQUIRE_FALSE(withEpilogue(rowBias) == Cache::makeKey(8, 4, 3, 8, 4, 8));
+    REQUIRE_FALSE(withEpilogue(rowBias) == withEpilogue({Epilogue::BIAS_PER_COLUMN, bias, Epilogue::ACTIVATION_NONE, 0.0f, 0.0f}));
+    REQUIRE_FALSE(withEpilogue(rowBias) == withEpilogue({Epilogue::BIAS_PER_ROW, bias + 8, Epilogue::ACTIVATION_NONE, 0.0f, 0.0f}));
+    REQUIRE_FALSE(withEpilogue(rowBias) == withEpilogue({Epilogue::BIAS_PER_ROW, bias, Epilogue::ACTIVATION_RELU, 0.0f, 0.0f}));
+    REQUIRE_FALSE(withEpilogue({Epilogue::BIAS_NONE, nullptr, Epilogue::ACTIVATION_RELU, 0.0f, 0.0f}) == withEpilogue({Epilogue::BIAS_NONE, nullptr, Epilogue::ACTIVATION_RELU6, 0.0f, 0.0f}));
+    REQUIRE_FALSE(withEpilogue({Epilogue::BIAS_NONE, nullptr, Epilogue::ACTIVATION_CLAMP, -1.0f, 1.0f}) == withEpilogue({Epilogue::BIAS_NONE, nullptr, Epilogue::ACTIVATION_CLAMP, -1.0f, 2.0f}));
+    // the bias address without a bias and the bounds of the fixed activations are ignored
+    REQUIRE(withEpilogue({Epilogue::BIAS_NONE, bias, Epilogue::ACTIVATION_NONE, 0.0f, 0.0f}) == withEpilogue({}));
+    REQUIRE(withEpilogue({Epilogue::BIAS_NONE, nullptr, Epilogue::ACTIVATION_RELU6, -1.0f, 1.0f}) == withEpilogue({Epilogue::BIAS_NONE, nullptr, Epilogue::ACTIVATION_RELU6, 0.0f, 0.0f}));
+    REQUIRE(Cache::epilogueOf(withEpilogue(rowBias)).biasValues == bias);
+    REQUIRE(withEpilogue(Cache::epilogueOf(withEpilogue({Epilogue::BIAS_PER_COLUMN, bias, Epilogue::ACTIVATION_CLAMP, -1.0f, 2.0f})))
+        == withEpilogue({Epilogue::BIAS_PER_COLUMN, bias, Epilogue::ACTIVATION_CLAMP, -1.0f, 2.0f}));
+}
+
+TEST_CASE("Kernel cache hits return the resident kernel", "[EMULATOR][GEMM][CACHE]") {
+    alignas(4) static Instruction16 staging[STAGING_SIZE];
+    alignas(4) static Instruction16 region[STAGING_SIZE];
+    Generators::Gemm generator(staging, STAGING_SIZE, programStorage, sizeof(programStorage));
+    Generators::GemmCache cache(generator, region, STAGING_SIZE);
+
+    Generators::Gemm::Func const first = cache.get(12, 5, 7, 12, 5, 12);
+    REQUIRE(first != nullptr);
+    uint32_t const size = generator.getInstructionCount();
+    // copied out of the staging buffer
+    REQUIRE(code(first) == region);
+    REQUIRE(std::memcmp(region, staging, size * sizeof(Instruction16)) == 0);
+    REQUIRE(cache.getStatistics().misses == 1);
+    REQUIRE(cache.getStatistics().hits == 0);
+
+    Generators::Gemm::Func const other = cache.get(12, 5, 7, 12, 5, 12, false, 2.0f);
+    REQUIRE(other != first);
+    REQUIRE(cache.get(12, 5, 7, 12, 5, 12) == first);
+    REQUIRE(cache.get(12, 5, 7, 12, 5, 12, false, 2.0f) == other);
+    REQUIRE(cache.getStatistics().misses == 2);
+    REQUIRE(cache.getStatistics().hits == 2);
+    REQUIRE(cache.getStatistics().evictions == 0);
+    REQUIRE(cache.getKernelCount() == 2);
+
+    // the resident copy computes C += A * B after the staging buffer was reused
+    std::vector<float> a(12 * 5), b(5 * 7), c(12 * 7, 1.0f);
+    for (uint32_t i = 0; i < a.size(); i++) a[i] = static_cast<float>(i % 7) - 3.0f;
+    for (uint32_t i = 0; i < b.size(); i++) b[i] = static_cast<float>(i % 5) - 2.0f;
+    std::vector<float> expected(c);
+    gemm_reference(a.data(), b.data(), expected.data(), 7, 5, 12, 12, 5, 12, Generators::Gemm::COLUMN_MAJOR_NN);
+    Emulator emulator;
+    REQUIRE(emulator.map(CODE_ADDRESS, region, sizeof(region)));
+    REQUIRE(emulator.map(X_ADDRESS, a.data(), a.size() * sizeof(float)));
+    REQUIRE(emulator.map(Y_ADDRESS, b.data(), b.size() * sizeof(float)));
+    REQUIRE(emulator.map(Z_ADDRESS, c.data(), c.size() * sizeof(float)));
+    callAndCheck(emulator, entryOf(first, region), X_ADDRESS, Y_ADDRESS, Z_ADDRESS);
+    REQUIRE(c == expected);
+
+    // kernels with an epilogue are separate entries
+    Generators::Gemm::Epilogue const relu = {Generators::Gemm::Epilogue::BIAS_NONE, nullptr, Generators::Gemm::Epilogue::ACTIVATION_RELU, 0.0f, 0.0f};
+    Generators::Gemm::Func const activated = cache.get(12, 5, 7, 12, 5, 12, false, 1.0f, 1.0f, Generators::Gemm::COLUMN_MAJOR_NN, relu);
+    REQUIRE(activated != nullptr);
+    REQUIRE(activated != first);
+    REQUIRE(cache.get(12, 5, 7, 12, 5, 12, false, 1.0f, 1.0f, Generators::Gemm::COLUMN_MAJOR_NN, relu) == activated);
+    REQUIRE(cache.get(12, 5, 7, 12, 5, 12) == first);
+
+    cache.clear();
+    REQUIRE(cache.getKernelCount() == 0);
+    REQUIRE(cache.getUsedSize() == 0);
+    REQUIRE(cache.get(12, 5, 7, 12, 5, 12) != nullptr);
+    REQUIRE(cache.getStatistics().misses == 4);
+}
+
+TEST_CASE("Kernel cache evicts the least recently used kernels", "[GEMM][CACHE]") {
+    alignas(4) static Instruction16 staging[STAGING_SIZE];
+    alignas(4) static Instruction16 region[STAGING_SIZE];
+    Generators::Gemm generator(staging, STAGING_SIZE, programStorage, sizeof(programStorage));
+
+    SECTION("region full") {
+        uint32_t const sizeA = kernelSize(generator, 8, 4, 3);
+        uint32_t const sizeB = kernelSize(generator, 8, 5, 3);
+        uint32_t const sizeC = kernelSize(generator, 8, 6, 3);
+        // room for two of the kernels
+        uint32_t const regionSize = sizeA + sizeB + (sizeC > sizeB ? sizeC - sizeB : 0);
+        Generators::GemmCache cache(generator, region, regionSize);
+
+        Generators::Gemm::Func const a = cache.get(8, 4, 3, 8, 4, 8);
+        cache.get(8, 5, 3, 8, 5, 8);
+        REQUIRE(cache.getUsedSize() == sizeA + sizeB);
+        REQUIRE(cache.get(8, 4, 3, 8, 4, 8) == a); // B is now the least recently used one
+        cache.get(8, 6, 3, 8, 6, 8);
+        REQUIRE(cache.getStatistics().evictions == 1);
+        REQUIRE(cache.getKernelCount() == 2);
+        REQUIRE(cache.get(8, 4, 3, 8, 4, 8) == a);
+        REQUIRE(cache.getStatistics().hits == 2);
+        cache.get(8, 5, 3, 8, 5, 8);
+        REQUIRE(cache.getStatistics().misses == 4);
+        REQUIRE(cache.getUsedSize() <= regionSize);
+    }
+    SECTION("entry table full") {
+        Generators::GemmCache cache(generator, region, STAGING_SIZE);
+        for (uint32_t k = 1; k <= Generators::GemmCache::MAX_KERNELS + 1; k++) REQUIRE(cache.get(8, k, 3, 8, k, 8) != nullptr);
+        REQUIRE(cache.getKernelCount() == Generators::GemmCache::MAX_KERNELS);
+        REQUIRE(cache.getStatistics().evictions == 1);
+        // the first kernel was evicted, the others are resident
+        cache.get(8, 2, 3, 8, 2, 8);
+        REQUIRE(cache.getStatistics().hits == 1);
+        cache.get(8, 1, 3, 8, 1, 8);
+        REQUIRE(cache.getStatistics().misses == Generators::GemmCache::MAX_KERNELS + 2);
+    }
+    SECTION("kernel larger than the staging buffer") {
+        alignas(4) static Instruction16 smallStaging[128];
+        Generators::Gemm small(smallStaging, 128, programStorage, sizeof(programStorage));
+        Generators::GemmCache cache(small, region, STAGING_SIZE);
+        REQUIRE(cache.get(8, 4, 3, 8, 4, 8) != nullptr);
+        uint32_t const used = cache.getUsedSize();
+        REQUIRE(cache.get(61, 16, 24, 61, 16, 61) == nullptr);
+        REQUIRE(cache.getKernelCount() == 1);
+        REQUIRE(cache.getUsedSize() == used);
+        // still a miss
+        REQUIRE(cache.get(61, 16, 24, 61, 16, 61) == nullptr);
+        REQUIRE(cache.getStatistics().misses == 3);
+    }
+    SECTION("kernel larger than the region") {
+        Generators::GemmCache cache(generator, region, 8);
+        Generators::Gemm::Func const staged = cache.get(8, 4, 3, 8, 4, 8);
+        REQUIRE(code(staged) == staging);
+        REQUIRE(cache.getKernelCount() == 0);
+    }
+}
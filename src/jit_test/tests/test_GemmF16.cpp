@@ -0,0 +1,55 @@
+#include "catch2/catch_amalgamated.hpp"
+#include "emulator/Emulator.hpp"
+#include "generators/GemmF16.hpp"
+#include "gemm_test_helper.hpp"
+
+#include <cstdint>
+
+using namespace JIT;
+using namespace JIT::Instructions;
+
+namespace {
+    constexpr uint32_t BUFFER_SIZE = 1 << 12;
+}
+
+
+TEST_CASE("FP16 GEMM kernels match the reference", "[EMULATOR][GEMM][F16]") {
+    alignas(4) static Instruction16 buffer[BUFFER_SIZE];
+    Generators::GemmF16 gemm(buffer, BUFFER_SIZE);
+    Emulator emulator;
+
+    for (Generators::GemmF16::Accumulation accumulation : {Generators::GemmF16::ACCUMULATE_F16, Generators::GemmF16::ACCUMULATE_F32}) {
+        CAPTURE(static_cast<uint32_t>(accumulation));
+        auto const generate = [&](Emulator &, GemmTestHelper::Shape const & shape) {
+            return gemm.generate(shape.m, shape.k, shape.n, shape.lda, shape.ldb, shape.ldc, accumulation);
+        };
+        // 8x6 (m <= 8), full and partial 16x3 and 4x3 microkernels, all k tails of the FP32 unrolling
+        uint32_t shapes = 0;
+        for (uint32_t m = 1; m <= 33; m++) {
+            for (uint32_t n = 1; n <= 7; n++) {
+                for (uint32_t k : {1U, 2U, 3U, 4U, 7U, 12U}) {
+                    GemmTestHelper::Shape const shape = {m, k, n, m + shapes % 3, k + shapes % 2, m + (shapes % 5 == 0 ? 7 : 0)};
+                    GemmTestHelper::checkKernel<_Float16>(emulator, buffer, BUFFER_SIZE, shape, generate);
+                    shapes++;
+                }
+            }
+        }
+        REQUIRE(shapes == 33 * 7 * 6);
+
+        // beyond the immediate offsets of VLDRH (127 elements) and LDRH (2047 elements)
+        GemmTestHelper::Shape const largeShapes[] = {
+            {21, 5, 7, 21 + 200, 5 + 1100, 21 + 300},
+            {5, 3, 12, 5 + 130, 3 + 140, 5 + 700},
+            {40, 9, 4, 40 + 90, 9, 40},
+            {16, 17, 3, 16, 17 + 2100, 16 + 2000},
+        };
+        for (GemmTestHelper::Shape const & shape : largeShapes) GemmTestHelper::checkKernel<_Float16>(emulator, buffer, BUFFER_SIZE, shape, generate);
+    }
+}
+
+TEST_CASE("FP16 GEMM kernels which don't fit into the buffer are not returned", "[GEMM][F16]") {
+    alignas(4) static Instruction16 small[64];
+    Generators::GemmF16 gemm(small, 64);
+    REQUIRE(gemm.generate(33, 12, 7, 33, 12, 33) == nullptr);
+    REQUIRE(gemm.generate(33, 12, 7, 33, 12, 33, Generators::GemmF16::ACCUMULATE_F32) == nullptr);
+}
@@ -0,0 +1,60 @@
+#include "catch2/catch_amalgamated.hpp"
+#include "emulator/Emulator.hpp"
+#include "generators/GemmGeneric.hpp"
+#include "gemm_test_helper.hpp"
+
+#include <cstdint>
+#include <vector>
+
+using namespace JIT;
+using namespace JIT::Instructions;
+using GemmTestHelper::CODE_ADDRESS;
+using GemmTestHelper::X_ADDRESS;
+using GemmTestHelper::Y_ADDRESS;
+using GemmTestHelper::Z_ADDRESS;
+
+namespace {
+    constexpr uint32_t SHAPE_ADDRESS = 0x0008'0000;
+    constexpr uint32_t BUFFER_SIZE = 1 << 12;
+}
+
+
+TEST_CASE("The generic GEMM kernel matches the reference for all shapes", "[EMULATOR][GEMM][GENERIC]") {
+    alignas(4) static Instruction16 buffer[BUFFER_SIZE];
+    Generators::GemmGeneric generator(buffer, BUFFER_SIZE);
+    Generators::GemmGeneric::Func const kernel = generator.generate();
+    REQUIRE(kernel != nullptr);
+    REQUIRE(generator.getInstructionCount() > 0);
+    Emulator emulator;
+
+    // one kernel for all shapes, which are passed in R3
+    Generators::GemmGeneric::Shape shape;
+    auto const call = [&](Emulator & emulator, GemmTestHelper::Shape const & checked) {
+        shape = {checked.m, checked.k, checked.n, checked.lda, checked.ldb, checked.ldc};
+        REQUIRE(emulator.map(SHAPE_ADDRESS, &shape, sizeof(shape)));
+        emulator.setRegister(R3, SHAPE_ADDRESS);
+        return kernel;
+    };
+    REQUIRE(GemmTestHelper::checkSmallShapes(emulator, buffer, BUFFER_SIZE, call) == 20 * 7 * 4);
+    REQUIRE(GemmTestHelper::checkLargeShapes(emulator, buffer, BUFFER_SIZE, call) == 6);
+}
+
+TEST_CASE("The generic GEMM kernel returns for empty shapes", "[EMULATOR][GEMM][GENERIC]") {
+    alignas(4) static Instruction16 buffer[BUFFER_SIZE];
+    Generators::GemmGeneric generator(buffer, BUFFER_SIZE);
+    REQUIRE(generator.generate() != nullptr);
+    Emulator emulator;
+
+    std::vector<float> c(16, 1.0f);
+    for (Generators::GemmGeneric::Shape shape : {Generators::GemmGeneric::Shape{0, 4, 4, 4, 4, 4}, {4, 0, 4, 4, 4, 4}, {4, 4, 0, 4, 4, 4}}) {
+        CAPTURE(shape.m, shape.k, shape.n);
+        emulator.unmapAll();
+        REQUIRE(emulator.map(CODE_ADDRESS, buffer, sizeof(buffer)));
+        REQUIRE(emulator.map(SHAPE_ADDRESS, &shape, sizeof(shape)));
+        REQUIRE(emulator.map(Z_ADDRESS, c.data(), c.size() * sizeof(float)));
+        emulator.setRegister(R3, SHAPE_ADDRESS);
+        // A and B are not mapped, any access faults
+        GemmTestHelper::callAndCheck(emulator, CODE_ADDRESS | 1, X_ADDRESS, Y_ADDRESS, Z_ADDRESS);
+        for (float value : c) REQUIRE(value == 1.0f);
+    }
+}
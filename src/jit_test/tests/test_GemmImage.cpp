@@ -0,0 +1,168 @@
+#include "catch2/catch_amalgamated.hpp"
+#include "emulator/Emulator.hpp"
+#include "generators/Gemm.hpp"
+#include "generators/GemmCache.hpp"
+#include "generators/GemmImage.hpp"
+#include "generators/GemmImageLoader.hpp"
+#include "gemm_test_helper.hpp"
+#include "helper/gemm_reference.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using namespace JIT;
+using namespace JIT::Instructions;
+using namespace JIT::Generators;
+using namespace GemmTestHelper;
+
+namespace {
+    constexpr uint32_t BUFFER_SIZE = 1 << 14;
+    constexpr uint32_t BLOB_SIZE = 1 << 16;
+
+    alignas(4) Instruction16 buffer[BUFFER_SIZE];
+    alignas(4) Instruction16 region[BUFFER_SIZE];
+    alignas(4) uint8_t blob[BLOB_SIZE];
+}
+
+
+TEST_CASE("Kernel images are loaded and match the reference", "[EMULATOR][GEMM][IMAGE]") {
+    Gemm generator(buffer, BUFFER_SIZE, programStorage, sizeof(programStorage));
+    Gemm::Epilogue const relu = {Gemm::Epilogue::BIAS_NONE, nullptr, Gemm::Epilogue::ACTIVATION_RELU, 0.0f, 0.0f};
+    GemmCache::Key const keys[] = {
+        GemmCache::makeKey(20, 12, 7, 20, 12, 20),
+        GemmCache::makeKey(9, 5, 4, 11, 6, 9, false, 2.0f, 0.0f),
+        GemmCache::makeKey(6, 7, 5, 8, 5, 5, false, 1.0f, 1.0f, Gemm::ROW_MAJOR),
+        GemmCache::makeKey(12, 6, 5, 12, 6, 12, false, 1.0f, 1.0f, Gemm::COLUMN_MAJOR_NN, relu),
+    };
+    uint32_t size = 0;
+    for (GemmCache::Key const & key : keys) {
+        uint32_t const imageSize = GemmImage::write(generator, key, GemmImage::CORE_ANY, blob + size, BLOB_SIZE - size);
+        REQUIRE(imageSize > sizeof(GemmImage::Header));
+        REQUIRE(imageSize % 4 == 0);
+        size += imageSize;
+    }
+    // the image of the other core is skipped (the host is CORE_ANY, so any specific core is skipped)
+    size += GemmImage::write(generator, GemmCache::makeKey(4, 4, 4, 4, 4, 4), GemmImage::CORE_HE, blob + size, BLOB_SIZE - size);
+
+    GemmImageLoader loader(region, BUFFER_SIZE);
+    REQUIRE(loader.load(blob, size) == 4);
+    REQUIRE(loader.getKernelCount() == 4);
+    REQUIRE(loader.get(4, 4, 4, 4, 4, 4) == nullptr);
+    REQUIRE(loader.get(20, 12, 7, 20, 12, 21) == nullptr);
+    REQUIRE(loader.get(9, 5, 4, 11, 6, 9, false, 2.0f, 1.0f) == nullptr);
+    // the kernel with the epilogue is only returned for it
+    REQUIRE(loader.get(12, 6, 5, 12, 6, 12) == nullptr);
+
+    Emulator emulator;
+    for (GemmCache::Key const & key : keys) {
+        Gemm::Layout const layout = static_cast<Gemm::Layout>(key.flags >> GemmCache::FLAG_LAYOUT_SHIFT);
+        float const alpha = std::bit_cast<float>(key.alpha);
+        float const beta = std::bit_cast<float>(key.beta);
+        bool const rowMajor = layout & Gemm::ROW_MAJOR;
+        CAPTURE(key.m, key.k, key.n, layout);
+        Gemm::Epilogue const epilogue = GemmCache::epilogueOf(key);
+        Gemm::Func const kernel = loader.get(key.m, key.k, key.n, key.lda, key.ldb, key.ldc, false, alpha, beta, layout, epilogue);
+        REQUIRE(kernel != nullptr);
+        uintptr_t const offset = (reinterpret_cast<uintptr_t>(kernel) & ~1U) - reinterpret_cast<uintptr_t>(region);
+        REQUIRE(offset % 4 == 0);
+
+        uint32_t const aSize = (rowMajor ? key.m : key.k) * key.lda;
+        uint32_t const bSize = (rowMajor ? key.k : key.n) * key.ldb;
+        uint32_t const cSize = (rowMajor ? key.m : key.n) * key.ldc;
+        std::vector<float> a(aSize + PADDING, NAN);
+        std::vector<float> b(bSize + PADDING, NAN);
+        std::vector<float> c(cSize + PADDING, 0.0f);
+        for (uint32_t i = 0; i < aSize; i++) a[i] = static_cast<float>(i % 13) - 6.0f;
+        for (uint32_t i = 0; i < bSize; i++) b[i] = static_cast<float>(i % 7) - 3.0f;
+        for (uint32_t i = 0; i < cSize; i++) c[i] = static_cast<float>(i % 11) - 5.0f;
+        std::vector<float> product(cSize, 0.0f);
+        gemm_reference(a.data(), b.data(), product.data(), key.n, key.k, key.m, key.lda, key.ldb, key.ldc, layout);
+
+        std::vector<float> expected(c);
+        for (uint32_t i = 0; i < cSize; i++) {
+            expected[i] = alpha * product[i] + (beta == 0.0f ? 0.0f : beta * c[i]);
+            if (epilogue.activation == Gemm::Epilogue::ACTIVATION_RELU) expected[i] = std::max(expected[i], 0.0f);
+        }
+
+        emulator.unmapAll();
+        REQUIRE(emulator.map(CODE_ADDRESS, region, sizeof(region)));
+        REQUIRE(emulator.map(X_ADDRESS, a.data(), a.size() * sizeof(float)));
+        REQUIRE(emulator.map(Y_ADDRESS, b.data(), b.size() * sizeof(float)));
+        REQUIRE(emulator.map(Z_ADDRESS, c.data(), c.size() * sizeof(float)));
+        callAndCheck(emulator, entryOf(kernel, region), X_ADDRESS, Y_ADDRESS, Z_ADDRESS);
+
+        uint32_t const rows = rowMajor ? key.n : key.m;
+        for (uint32_t i = 0; i < cSize; i++) {
+            if (i % key.ldc >= rows) continue;
+            CAPTURE(i);
+            REQUIRE(c[i] == expected[i]);
+        }
+    }
+}
+
+TEST_CASE("Invalid kernel images are rejected", "[GEMM][IMAGE]") {
+    Gemm generator(buffer, BUFFER_SIZE, programStorage, sizeof(programStorage));
+    uint32_t const first = GemmImage::write(generator, GemmCache::makeKey(8, 8, 8, 8, 8, 8), GemmImage::CORE_ANY, blob, BLOB_SIZE);
+    REQUIRE(first > 0);
+    uint32_t const second = GemmImage::write(generator, GemmCache::makeKey(16, 8, 6, 16, 8, 16), GemmImage::CORE_ANY, blob + first, BLOB_SIZE - first);
+    REQUIRE(second > 0);
+    GemmImageLoader loader(region, BUFFER_SIZE);
+
+    SECTION("checksum") {
+        blob[sizeof(GemmImage::Header) + 2] ^= 0x10;
+        REQUIRE(loader.load(blob, first + second) == 1);
+        REQUIRE(loader.get(8, 8, 8, 8, 8, 8) == nullptr);
+        REQUIRE(loader.get(16, 8, 6, 16, 8, 16) != nullptr);
+    }
+    SECTION("header") {
+        blob[first] ^= 0x01;
+        REQUIRE(loader.load(blob, first + second) == 1);
+        REQUIRE(loader.load(blob, first - 4) == 0);
+    }
+    SECTION("corrupted header fields") {
+        GemmImage::Header header;
+        std::memcpy(&header, blob, sizeof(header));
+        // covered by the checksum: the kernel of 8x8x8 is not served for another shape
+        GemmImage::Header corrupted = header;
+        corrupted.key.m = 9;
+        std::memcpy(blob, &corrupted, sizeof(corrupted));
+        REQUIRE(loader.load(blob, first + second) == 1);
+        REQUIRE(loader.get(9, 8, 8, 8, 8, 8) == nullptr);
+        loader.clear();
+        // an entry outside of the code is rejected even with a matching checksum
+        corrupted = header;
+        corrupted.entryOffset = header.codeSize;
+        corrupted.checksum = GemmImage::checksum(corrupted, blob + sizeof(corrupted));
+        std::memcpy(blob, &corrupted, sizeof(corrupted));
+        REQUIRE(loader.load(blob, first + second) == 1);
+        REQUIRE(loader.get(8, 8, 8, 8, 8, 8) == nullptr);
+        loader.clear();
+        // the image size would wrap around and pass the bounds check
+        corrupted = header;
+        corrupted.codeSize = 0xffff'fffe;
+        std::memcpy(blob, &corrupted, sizeof(corrupted));
+        REQUIRE(loader.load(blob, first + second) == 0);
+    }
+    SECTION("region full") {
+        GemmImageLoader small(region, (first - sizeof(GemmImage::Header)) / 2 + 4);
+        REQUIRE(small.load(blob, first + second) == 1);
+        REQUIRE(small.getUsedSize() <= (first - sizeof(GemmImage::Header)) / 2);
+        small.clear();
+        REQUIRE(small.get(8, 8, 8, 8, 8, 8) == nullptr);
+        REQUIRE(small.load(blob + first, second) == 0);
+    }
+    SECTION("alignment") {
+        REQUIRE(GemmImage::write(generator, GemmCache::makeKey(8, 8, 8, 8, 8, 8), GemmImage::CORE_ANY, blob + 2, BLOB_SIZE - 2) == 0);
+        REQUIRE(GemmImage::write(generator, GemmCache::makeKey(8, 8, 8, 8, 8, 8), GemmImage::CORE_ANY, blob, first - 4) == 0);
+    }
+    SECTION("kernel larger than the generator buffer") {
+        alignas(4) static Instruction16 smallBuffer[128];
+        Gemm small(smallBuffer, 128, programStorage, sizeof(programStorage));
+        REQUIRE(GemmImage::write(small, GemmCache::makeKey(8, 4, 3, 8, 4, 8), GemmImage::CORE_ANY, blob, BLOB_SIZE) > 0);
+        REQUIRE(GemmImage::write(small, GemmCache::makeKey(61, 16, 24, 61, 16, 61), GemmImage::CORE_ANY, blob, BLOB_SIZE) == 0);
+    }
+}
@@ -0,0 +1,128 @@
+#include "catch2/catch_amalgamated.hpp"
+#include "emulator/Emulator.hpp"
+#include "generators/Gemm.hpp"
+#include "generators/GemmPack.hpp"
+#include "gemm_test_helper.hpp"
+#include "helper/gemm_reference.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+using namespace JIT;
+using namespace JIT::Instructions;
+using namespace GemmTestHelper;
+
+namespace {
+    constexpr uint32_t PACKED_A_ADDRESS = 0x4000'0000;
+    constexpr uint32_t PACKED_B_ADDRESS = 0x5000'0000;
+    // the kernel and both packing routines share one buffer (and one region of the emulator)
+    constexpr uint32_t BUFFER_SIZE = 1 << 14;
+    constexpr uint32_t PACK_A_OFFSET = BUFFER_SIZE / 2;
+    constexpr uint32_t PACK_B_OFFSET = BUFFER_SIZE / 2 + BUFFER_SIZE / 4;
+
+    struct Scaling {
+        float alpha;
+        float beta;
+    };
+
+    /*
+    Packs the column-major A and B with the GemmPack routines, runs the PACKED kernel on the panels and compares C with the
+    reference of the unpacked matrices. The panels are mapped without padding, so the routines must not access anything
+    behind packedSizeA and packedSizeB.
+    */
+    void checkPacked(Emulator & emulator, Instruction16 * buffer, uint32_t m, uint32_t k, uint32_t n, uint32_t lda, uint32_t ldb, uint32_t ldc, Scaling const & scaling) {
+        CAPTURE(m, n, k, lda, ldb, ldc, scaling.alpha, scaling.beta);
+        uint32_t const aSize = k * lda;
+        uint32_t const bSize = n * ldb;
+        uint32_t const cSize = n * ldc;
+
+        // multiples of 1/8 with small magnitudes, all sums are exact. The packing of A loads whole vectors at the M edges (PADDING)
+        std::vector<float> a(aSize + PADDING, NAN);
+        std::vector<float> b(bSize + PADDING, NAN);
+        std::vector<float> c(cSize + PADDING, -1234.0f);
+        for (uint32_t i = 0; i < aSize; i++) a[i] = static_cast<float>(i % 13) - 6.0f + 0.25f * (i % 3);
+        for (uint32_t i = 0; i < bSize; i++) b[i] = static_cast<float>(i % 7) - 3.0f + 0.5f * (i % 5);
+        for (uint32_t i = 0; i < cSize; i++) c[i] = static_cast<float>(i % 11) - 5.0f;
+        // every element of the panels is written by the packing
+        std::vector<float> packedA(Generators::GemmPack::packedSizeA(m, k), NAN);
+        std::vector<float> packedB(Generators::GemmPack::packedSizeB(k, n), NAN);
+
+        std::vector<float> product(cSize, 0.0f);
+        gemm_reference(a.data(), b.data(), product.data(), n, k, m, lda, ldb, ldc, Generators::Gemm::COLUMN_MAJOR_NN);
+        std::vector<float> expected(c);
+        for (uint32_t i = 0; i < cSize; i++) {
+            if (i % ldc < m) expected[i] = scaling.alpha * product[i] + (scaling.beta == 0.0f ? 0.0f : scaling.beta * c[i]);
+        }
+
+        Generators::Gemm gemm(buffer, PACK_A_OFFSET, programStorage, sizeof(programStorage));
+        Generators::GemmPack packA(buffer + PACK_A_OFFSET, PACK_B_OFFSET - PACK_A_OFFSET);
+        Generators::GemmPack packB(buffer + PACK_B_OFFSET, BUFFER_SIZE - PACK_B_OFFSET);
+        // lda and ldb are ignored by the PACKED kernel
+        Generators::Gemm::Func const kernel = gemm.generate(m, k, n, 0, 0, ldc, false, scaling.alpha, scaling.beta, Generators::Gemm::PACKED);
+        Generators::GemmPack::Func const packARoutine = packA.generatePackA(m, k, lda);
+        Generators::GemmPack::Func const packBRoutine = packB.generatePackB(k, n, ldb);
+        REQUIRE(kernel != nullptr);
+        REQUIRE(packARoutine != nullptr);
+        REQUIRE(packBRoutine != nullptr);
+
+        emulator.unmapAll();
+        REQUIRE(emulator.map(CODE_ADDRESS, buffer, BUFFER_SIZE * sizeof(Instruction16)));
+        REQUIRE(emulator.map(X_ADDRESS, a.data(), a.size() * sizeof(float)));
+        REQUIRE(emulator.map(Y_ADDRESS, b.data(), b.size() * sizeof(float)));
+        REQUIRE(emulator.map(Z_ADDRESS, c.data(), c.size() * sizeof(float)));
+        REQUIRE(emulator.map(PACKED_A_ADDRESS, packedA.data(), packedA.size() * sizeof(float)));
+        REQUIRE(emulator.map(PACKED_B_ADDRESS, packedB.data(), packedB.size() * sizeof(float)));
+
+        callAndCheck(emulator, entryOf(packARoutine, buffer), X_ADDRESS, PACKED_A_ADDRESS);
+        callAndCheck(emulator, entryOf(packBRoutine, buffer), Y_ADDRESS, PACKED_B_ADDRESS);
+        for (uint32_t i = 0; i < packedA.size(); i++) REQUIRE(!std::isnan(packedA[i]));
+        for (uint32_t i = 0; i < packedB.size(); i++) REQUIRE(!std::isnan(packedB[i]));
+        callAndCheck(emulator, entryOf(kernel, buffer), PACKED_A_ADDRESS, PACKED_B_ADDRESS, Z_ADDRESS);
+
+        // the gaps of ldc and the padding behind C are not written
+        for (uint32_t i = 0; i < c.size(); i++) {
+            CAPTURE(i);
+            REQUIRE(c[i] == expected[i]);
+        }
+    }
+}
+
+
+TEST_CASE("Packed GEMM kernels match the reference on the panels of GemmPack", "[EMULATOR][GEMM][PACK]") {
+    alignas(4) static Instruction16 buffer[BUFFER_SIZE];
+    Emulator emulator;
+    // alpha = 3: beta / alpha is not exact, C is added after scaling the accumulators
+    Scaling const scalings[] = {{1.0f, 1.0f}, {1.0f, 0.0f}, {2.0f, 1.0f}, {3.0f, 1.0f}};
+
+    uint32_t shapes = 0;
+    // full and partial slivers of A (PACKED_MR = 8) and B (PACKED_NR = 3), the sliver loops start at two slivers
+    for (uint32_t m = 1; m <= 20; m++) {
+        for (uint32_t n = 1; n <= 7; n++) {
+            for (uint32_t k : {1U, 2U, 5U, 12U}) {
+                uint32_t const lda = m + shapes % 3;
+                uint32_t const ldb = k + shapes % 2;
+                uint32_t const ldc = m + (shapes % 5 == 0 ? 7 : 0);
+                checkPacked(emulator, buffer, m, k, n, lda, ldb, ldc, scalings[shapes % 4]);
+                shapes++;
+            }
+        }
+    }
+    REQUIRE(shapes == 20 * 7 * 4);
+
+    // strides of A beyond the immediates, B sliver strides beyond 12 bit and a long k loop
+    checkPacked(emulator, buffer, 45, 3, 13, 45 + 1100, 3 + 1500, 45 + 200, scalings[0]);
+    checkPacked(emulator, buffer, 13, 300, 7, 13, 300, 13, scalings[3]);
+    checkPacked(emulator, buffer, 21, 9, 10, 21 + 130, 9 + 2000, 21, scalings[2]);
+}
+
+TEST_CASE("Packing routines of empty matrices are not generated", "[GEMM][PACK]") {
+    alignas(4) static Instruction16 buffer[256];
+    Generators::GemmPack pack(buffer, 256);
+    REQUIRE(pack.generatePackA(0, 4, 4) == nullptr);
+    REQUIRE(pack.generatePackA(4, 0, 4) == nullptr);
+    REQUIRE(pack.generatePackB(0, 4, 4) == nullptr);
+    REQUIRE(pack.generatePackB(4, 0, 4) == nullptr);
+    REQUIRE(Generators::GemmPack::packedSizeA(9, 2) == 12 * 2);
+    REQUIRE(Generators::GemmPack::packedSizeB(2, 7) == 14);
+}
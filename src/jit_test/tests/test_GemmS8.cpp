@@ -0,0 +1,172 @@
+#include "catch2/catch_amalgamated.hpp"
+#include "emulator/Emulator.hpp"
+#include "generators/GemmS8.hpp"
+#include "gemm_test_helper.hpp"
+#include "helper/gemm_reference.hpp"
+
+#include <cstdint>
+#include <vector>
+
+using namespace JIT;
+using namespace JIT::Instructions;
+using namespace GemmTestHelper;
+
+namespace {
+    // the kernels read the per-channel parameters through the embedded addresses, each array is mapped on its own
+    constexpr uint32_t BIAS_ADDRESS = 0x4000'0000;
+    constexpr uint32_t MULTIPLIERS_ADDRESS = 0x5000'0000;
+    constexpr uint32_t SHIFTS_ADDRESS = 0x6000'0000;
+    constexpr uint32_t BUFFER_SIZE = 1 << 12;
+
+    template <typename T>
+    T const * emulated(uint32_t address) {
+        return reinterpret_cast<T const *>(static_cast<uintptr_t>(address));
+    }
+}
+
+
+TEST_CASE("Int8 GEMM kernels match the CMSIS-NN requantization", "[EMULATOR][GEMM][S8]") {
+    alignas(4) static Instruction16 buffer[BUFFER_SIZE];
+    Generators::GemmS8 gemm(buffer, BUFFER_SIZE);
+    Emulator emulator;
+    constexpr int32_t inputOffset = 128;
+
+    uint32_t kernels = 0;
+    for (uint32_t m : {1U, 2U, 5U}) {
+        // column tails of 1 to 3 and the column loop (n >= 8)
+        for (uint32_t n : {1U, 2U, 3U, 4U, 5U, 7U, 8U, 11U}) {
+            // tails of the tail predicated k loop
+            for (uint32_t k : {1U, 5U, 16U, 17U, 40U}) {
+                uint32_t const lda = k + kernels % 3;
+                uint32_t const ldb = k + kernels % 2;
+                uint32_t const ldc = n + (kernels % 4 == 0 ? 5 : 0);
+                std::vector<int8_t> a(m * lda + PADDING);
+                std::vector<int8_t> b(n * ldb + PADDING);
+                for (uint32_t i = 0; i < a.size(); i++) a[i] = static_cast<int8_t>((i * 7) % 256 - 128);
+                for (uint32_t i = 0; i < b.size(); i++) b[i] = static_cast<int8_t>((i * 13) % 251 - 125);
+                // exactly one value per column, reading behind the arrays faults
+                std::vector<int32_t> bias(n), multipliers(n), shifts(n), kernelSums(n);
+                for (uint32_t j = 0; j < n; j++) {
+                    bias[j] = static_cast<int32_t>(j * 97) - 1000;
+                    // a left shift needs a small multiplier, otherwise all results are clamped
+                    multipliers[j] = j % 5 == 4 ? 4194304 + static_cast<int32_t>(j * 4567) : 1073741824 + static_cast<int32_t>(j * 12345678);
+                    shifts[j] = j % 5 == 4 ? 2 : -static_cast<int32_t>(8 + j % 4);
+                }
+
+                for (uint32_t variant = 0; variant < 4; variant++) {
+                    bool const perChannel = variant % 2 == 1;
+                    bool const hasBias = variant < 2;
+                    Generators::GemmS8::Requantization reference = {};
+                    reference.bias = hasBias ? bias.data() : nullptr;
+                    reference.multipliers = perChannel ? multipliers.data() : nullptr;
+                    reference.shifts = perChannel ? shifts.data() : nullptr;
+                    reference.multiplier = variant == 0 ? 8388608 : 1518500250;
+                    reference.shift = variant == 0 ? 1 : -9;
+                    reference.outputOffset = variant == 2 ? 0 : -3;
+                    // the narrow range clamps some of the results
+                    reference.activationMin = variant < 2 ? -128 : -100;
+                    reference.activationMax = variant < 2 ? 127 : 90;
+                    CAPTURE(m, n, k, lda, ldb, ldc, perChannel, hasBias);
+
+                    std::vector<int8_t> c(m * ldc + PADDING, 0x55);
+                    std::vector<int8_t> expected(c);
+                    gemm_reference_s8(a.data(), b.data(), expected.data(), m, k, n, lda, ldb, ldc, inputOffset, reference);
+
+                    Generators::GemmS8::computeKernelSums(b.data(), k, n, ldb, reference.bias, inputOffset, kernelSums.data());
+                    Generators::GemmS8::Requantization requantization = reference;
+                    requantization.bias = emulated<int32_t>(BIAS_ADDRESS);
+                    requantization.multipliers = perChannel ? emulated<int32_t>(MULTIPLIERS_ADDRESS) : nullptr;
+                    requantization.shifts = perChannel ? emulated<int32_t>(SHIFTS_ADDRESS) : nullptr;
+                    Generators::GemmS8::Func const kernel = gemm.generate(m, k, n, lda, ldb, ldc, requantization);
+                    REQUIRE(kernel != nullptr);
+
+                    emulator.unmapAll();
+                    REQUIRE(emulator.map(CODE_ADDRESS, buffer, sizeof(buffer)));
+                    REQUIRE(emulator.map(X_ADDRESS, a.data(), a.size()));
+                    REQUIRE(emulator.map(Y_ADDRESS, b.data(), b.size()));
+                    REQUIRE(emulator.map(Z_ADDRESS, c.data(), c.size()));
+                    REQUIRE(emulator.map(BIAS_ADDRESS, kernelSums.data(), n * sizeof(int32_t)));
+                    if (perChannel) {
+                        REQUIRE(emulator.map(MULTIPLIERS_ADDRESS, multipliers.data(), n * sizeof(int32_t)));
+                        REQUIRE(emulator.map(SHIFTS_ADDRESS, shifts.data(), n * sizeof(int32_t)));
+                    }
+                    callAndCheck(emulator, entryOf(kernel, buffer), X_ADDRESS, Y_ADDRESS, Z_ADDRESS);
+                    // the gaps of ldc and the padding behind C are not written
+                    for (uint32_t i = 0; i < c.size(); i++) {
+                        CAPTURE(i);
+                        REQUIRE(static_cast<int32_t>(c[i]) == static_cast<int32_t>(expected[i]));
+                    }
+                    kernels++;
+                }
+            }
+        }
+    }
+    REQUIRE(kernels == 3 * 8 * 5 * 4);
+}
+
+TEST_CASE("Int8 GEMM kernels round ties away from zero", "[EMULATOR][GEMM][S8]") {
+    alignas(4) static Instruction16 buffer[BUFFER_SIZE];
+    Generators::GemmS8 gemm(buffer, BUFFER_SIZE);
+    Emulator emulator;
+    constexpr uint32_t m = 8, k = 1, n = 4;
+    // multiplier 0.5 halves the even accumulators exactly, the right shift then lands on .5:
+    // column j has B = 2 << j and shift -(j + 1), so row i gives +-(2i + 1) / 2 in all columns
+    std::vector<int8_t> a(m * k + PADDING), b(n * k + PADDING);
+    std::vector<int32_t> multipliers(n, 1 << 30), shifts(n), kernelSums(n);
+    for (uint32_t i = 0; i < m; i++) a[i] = static_cast<int8_t>((i % 2 == 0 ? -1 : 1) * static_cast<int32_t>(2 * i + 1));
+    for (uint32_t j = 0; j < n; j++) {
+        b[j] = static_cast<int8_t>(2 << j);
+        shifts[j] = -static_cast<int32_t>(j + 1);
+    }
+
+    for (bool perChannel : {false, true}) {
+        CAPTURE(perChannel);
+        Generators::GemmS8::Requantization reference = {nullptr, nullptr, nullptr, 1 << 30, -1, 0, -128, 127};
+        reference.multipliers = perChannel ? multipliers.data() : nullptr;
+        reference.shifts = perChannel ? shifts.data() : nullptr;
+        std::vector<int8_t> c(m * n + PADDING, 0x55);
+        std::vector<int8_t> expected(c);
+        gemm_reference_s8(a.data(), b.data(), expected.data(), m, k, n, k, k, n, 0, reference);
+        for (uint32_t i = 0; i < m; i++) {
+            // the per-tensor shift only matches the first column
+            for (uint32_t j = 0; j < (perChannel ? n : 1); j++) {
+                REQUIRE(static_cast<int32_t>(expected[i * n + j]) == (i % 2 == 0 ? -1 : 1) * static_cast<int32_t>(i + 1));
+            }
+        }
+
+        Generators::GemmS8::computeKernelSums(b.data(), k, n, k, nullptr, 0, kernelSums.data());
+        Generators::GemmS8::Requantization requantization = reference;
+        requantization.bias = emulated<int32_t>(BIAS_ADDRESS);
+        requantization.multipliers = perChannel ? emulated<int32_t>(MULTIPLIERS_ADDRESS) : nullptr;
+        requantization.shifts = perChannel ? emulated<int32_t>(SHIFTS_ADDRESS) : nullptr;
+        Generators::GemmS8::Func const kernel = gemm.generate(m, k, n, k, k, n, requantization);
+        REQUIRE(kernel != nullptr);
+
+        emulator.unmapAll();
+        REQUIRE(emulator.map(CODE_ADDRESS, buffer, sizeof(buffer)));
+        REQUIRE(emulator.map(X_ADDRESS, a.data(), a.size()));
+        REQUIRE(emulator.map(Y_ADDRESS, b.data(), b.size()));
+        REQUIRE(emulator.map(Z_ADDRESS, c.data(), c.size()));
+        REQUIRE(emulator.map(BIAS_ADDRESS, kernelSums.data(), n * sizeof(int32_t)));
+        if (perChannel) {
+            REQUIRE(emulator.map(MULTIPLIERS_ADDRESS, multipliers.data(), n * sizeof(int32_t)));
+            REQUIRE(emulator.map(SHIFTS_ADDRESS, shifts.data(), n * sizeof(int32_t)));
+        }
+        callAndCheck(emulator, entryOf(kernel, buffer), X_ADDRESS, Y_ADDRESS, Z_ADDRESS);
+        for (uint32_t i = 0; i < c.size(); i++) {
+            CAPTURE(i);
+            REQUIRE(static_cast<int32_t>(c[i]) == static_cast<int32_t>(expected[i]));
+        }
+    }
+}
+
+TEST_CASE("Int8 GEMM arguments are checked", "[GEMM][S8]") {
+    alignas(4) static Instruction16 buffer[BUFFER_SIZE];
+    Generators::GemmS8 gemm(buffer, BUFFER_SIZE);
+    Generators::GemmS8::Requantization requantization = {nullptr, nullptr, nullptr, 1073741824, 0, 0, -128, 127};
+    REQUIRE(gemm.generate(4, 0, 4, 4, 4, 4, requantization) == nullptr);
+    requantization.shift = 32;
+    REQUIRE(gemm.generate(4, 8, 4, 8, 8, 4, requantization) == nullptr);
+    requantization.shift = -33;
+    REQUIRE(gemm.generate(4, 8, 4, 8, 8, 4, requantization) == nullptr);
+}
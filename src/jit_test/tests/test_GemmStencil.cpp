@@ -0,0 +1,55 @@
+#include "catch2/catch_amalgamated.hpp"
+#include "emulator/Emulator.hpp"
+#include "generators/GemmStencil.hpp"
+#include "gemm_test_helper.hpp"
+
+#include <cstdint>
+
+using namespace JIT;
+using namespace JIT::Instructions;
+
+namespace {
+    constexpr uint32_t BUFFER_SIZE = 1 << 12;
+}
+
+
+TEST_CASE("Stencil GEMM kernels match the reference", "[EMULATOR][GEMM][STENCIL]") {
+    alignas(4) static Instruction16 buffer[BUFFER_SIZE];
+    Generators::GemmStencil stencil(buffer, BUFFER_SIZE);
+    Emulator emulator;
+
+    // the stencils are copied to the start of the buffer, the tails are predicated
+    auto const generate = [&](Emulator &, GemmTestHelper::Shape const & shape) {
+        Generators::GemmStencil::Func const kernel = stencil.generate(shape.m, shape.k, shape.n, shape.lda, shape.ldb, shape.ldc);
+        REQUIRE(reinterpret_cast<uintptr_t>(kernel) == (reinterpret_cast<uintptr_t>(buffer) | 1));
+        return kernel;
+    };
+    REQUIRE(GemmTestHelper::checkSmallShapes(emulator, buffer, BUFFER_SIZE, generate) == 20 * 7 * 4);
+    REQUIRE(GemmTestHelper::checkLargeShapes(emulator, buffer, BUFFER_SIZE, generate) == 6);
+}
+
+TEST_CASE("Stencil GEMM kernels only consist of the copied stencils", "[GEMM][STENCIL]") {
+    alignas(4) static Instruction16 buffer[BUFFER_SIZE];
+    Generators::GemmStencil stencil(buffer, BUFFER_SIZE);
+
+    // the size only depends on the number of loops and tails, not on k and the leading dimensions
+    REQUIRE(stencil.generate(24, 16, 24, 24, 16, 24) != nullptr);
+    uint32_t const size = stencil.getInstructionCount();
+    REQUIRE(size % 2 == 0);
+    REQUIRE(stencil.generate(32, 1000, 30, 40, 1000, 32) != nullptr);
+    REQUIRE(stencil.getInstructionCount() == size);
+    REQUIRE(stencil.generate(27, 16, 26, 27, 16, 27) != nullptr);
+    REQUIRE(stencil.getInstructionCount() > size);
+
+    SECTION("invalid shapes") {
+        REQUIRE(stencil.generate(0, 16, 24, 24, 16, 24) == nullptr);
+        REQUIRE(stencil.generate(24, 0, 24, 24, 16, 24) == nullptr);
+        REQUIRE(stencil.generate(24, 16, 0, 24, 16, 24) == nullptr);
+        REQUIRE(stencil.generate(24, Generators::GemmStencil::MAX_K + 1, 24, 24, 16, 24) == nullptr);
+    }
+    SECTION("buffer too small") {
+        alignas(4) static Instruction16 small[32];
+        Generators::GemmStencil tiny(small, 32);
+        REQUIRE(tiny.generate(24, 16, 24, 24, 16, 24) == nullptr);
+    }
+}
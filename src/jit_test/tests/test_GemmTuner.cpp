@@ -0,0 +1,175 @@
+#include "catch2/catch_amalgamated.hpp"
+#include "emulator/CycleEstimator.hpp"
+#include "emulator/Emulator.hpp"
+#include "generators/Gemm.hpp"
+#include "generators/GemmTuner.hpp"
+#include "generators/GemmTuningTable.hpp"
+#include "gemm_test_helper.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace JIT;
+using namespace JIT::Instructions;
+using namespace GemmTestHelper;
+
+namespace {
+    constexpr uint32_t BUFFER_SIZE = 1 << 14;
+
+    // the candidates run in the emulator, the matrices are passed as emulated addresses
+    struct EstimatedTimer {
+        Emulator & emulator;
+        Instruction16 const * buffer;
+
+        uint32_t entry(Generators::Gemm::Func kernel) const {
+            return entryOf(kernel, buffer);
+        }
+
+        static uint32_t time(void * context, Generators::Gemm::Func kernel, float const * a, float const * b, float * c, uint32_t iterations) {
+            EstimatedTimer & timer = *static_cast<EstimatedTimer *>(context);
+            uint32_t const r0 = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(a));
+            uint32_t const r1 = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(b));
+            uint32_t const r2 = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(c));
+            CycleEstimator estimator;
+            if (estimator.run(timer.emulator, timer.entry(kernel), r0, r1, r2) != Emulator::RETURNED) return UINT32_MAX;
+            uint64_t cycles = 0;
+            for (uint32_t it = 0; it < iterations; it++) {
+                if (estimator.run(timer.emulator, timer.entry(kernel), r0, r1, r2) != Emulator::RETURNED) return UINT32_MAX;
+                cycles += estimator.getEstimate().cycles;
+            }
+            return static_cast<uint32_t>(cycles);
+        }
+    };
+
+    template <typename T>
+    T * emulated(uint32_t address) {
+        return reinterpret_cast<T *>(static_cast<uintptr_t>(address));
+    }
+
+    void appendLine(void * context, char const * text) {
+        static_cast<std::string *>(context)->append(text);
+    }
+}
+
+
+TEST_CASE("The tuner stores the fastest estimated candidate", "[EMULATOR][GEMM][TUNER]") {
+    alignas(4) static Instruction16 buffer[BUFFER_SIZE];
+    Generators::Gemm gemm(buffer, BUFFER_SIZE, programStorage, sizeof(programStorage));
+    Generators::GemmTuningTable table;
+    Emulator emulator;
+    EstimatedTimer timer = {emulator, buffer};
+    Generators::GemmTuner tuner(gemm, BUFFER_SIZE, table, EstimatedTimer::time, &timer);
+
+    // m % 8 = 4 rows for the 4x6 tail and n beyond the unrolling of the defaults
+    Shape const shape = {20, 10, 12, 20, 10, 20};
+    std::vector<float> a(shape.k * shape.lda + PADDING, 1.0f);
+    std::vector<float> b(shape.n * shape.ldb + PADDING, 0.5f);
+    std::vector<float> c(shape.n * shape.ldc + PADDING, 0.0f);
+    REQUIRE(emulator.map(CODE_ADDRESS, buffer, sizeof(buffer)));
+    REQUIRE(emulator.map(X_ADDRESS, a.data(), a.size() * sizeof(float)));
+    REQUIRE(emulator.map(Y_ADDRESS, b.data(), b.size() * sizeof(float)));
+    REQUIRE(emulator.map(Z_ADDRESS, c.data(), c.size() * sizeof(float)));
+
+    Generators::Gemm::Tuning const best = tuner.tune(emulated<float const>(X_ADDRESS), emulated<float const>(Y_ADDRESS), emulated<float>(Z_ADDRESS),
+        shape.m, shape.k, shape.n, shape.lda, shape.ldb, shape.ldc, Generators::Gemm::COLUMN_MAJOR_NN, 2);
+    // the defaults and at most one candidate per value of the search
+    REQUIRE(tuner.getCandidateCount() > 1);
+    REQUIRE(tuner.getCandidateCount() <= 13);
+    REQUIRE(tuner.getBestCycles() <= tuner.getDefaultCycles());
+    REQUIRE(tuner.isStored());
+    REQUIRE(table.getCount() == 1);
+    Generators::Gemm::Tuning const * entry = table.find(shape.m, shape.k, shape.n, shape.lda, shape.ldb, shape.ldc, Generators::Gemm::COLUMN_MAJOR_NN);
+    REQUIRE(entry != nullptr);
+    REQUIRE(entry->use46Microkernel == best.use46Microkernel);
+    REQUIRE(entry->kMaxUnroll == best.kMaxUnroll);
+    REQUIRE(entry->mMaxUnroll == best.mMaxUnroll);
+    REQUIRE(entry->nMaxUnroll == best.nMaxUnroll);
+    REQUIRE(entry->predicatedEdges == best.predicatedEdges);
+
+    // the estimate is deterministic, the winner is timed again with the same result
+    Generators::Gemm::Func const tuned = gemm.generateTuned(shape.m, shape.k, shape.n, shape.lda, shape.ldb, shape.ldc, best);
+    REQUIRE(tuned != nullptr);
+    uint16_t const tunedSize = gemm.getInstructionCount();
+    REQUIRE(EstimatedTimer::time(&timer, tuned, emulated<float const>(X_ADDRESS), emulated<float const>(Y_ADDRESS), emulated<float>(Z_ADDRESS), 2) == tuner.getBestCycles());
+
+    // generate picks up the winner from the table
+    gemm.setTuningTable(&table);
+    checkKernel(emulator, buffer, BUFFER_SIZE, shape, [&](Emulator &, Shape const & s) {
+        return gemm.generate(s.m, s.k, s.n, s.lda, s.ldb, s.ldc);
+    });
+    REQUIRE(gemm.getInstructionCount() == tunedSize);
+}
+
+TEST_CASE("The tuner reports a full table", "[EMULATOR][GEMM][TUNER]") {
+    alignas(4) static Instruction16 buffer[BUFFER_SIZE];
+    Generators::Gemm gemm(buffer, BUFFER_SIZE, programStorage, sizeof(programStorage));
+    Generators::GemmTuningTable table;
+    Emulator emulator;
+    EstimatedTimer timer = {emulator, buffer};
+    Generators::GemmTuner tuner(gemm, BUFFER_SIZE, table, EstimatedTimer::time, &timer);
+    for (uint32_t i = 0; i < Generators::GemmTuningTable::MAX_ENTRIES; i++) {
+        REQUIRE(table.insert({8, 4, 3 + i, 8, 4, 8, Generators::Gemm::COLUMN_MAJOR_NN, Generators::Gemm::defaultTuning()}));
+    }
+
+    std::vector<float> a(16 * 4 + PADDING, 1.0f);
+    std::vector<float> b(4 * 6 + PADDING, 1.0f);
+    std::vector<float> c(16 * 6 + PADDING, 0.0f);
+    REQUIRE(emulator.map(CODE_ADDRESS, buffer, sizeof(buffer)));
+    REQUIRE(emulator.map(X_ADDRESS, a.data(), a.size() * sizeof(float)));
+    REQUIRE(emulator.map(Y_ADDRESS, b.data(), b.size() * sizeof(float)));
+    REQUIRE(emulator.map(Z_ADDRESS, c.data(), c.size() * sizeof(float)));
+
+    tuner.tune(emulated<float const>(X_ADDRESS), emulated<float const>(Y_ADDRESS), emulated<float>(Z_ADDRESS), 16, 4, 6, 16, 4, 16, Generators::Gemm::COLUMN_MAJOR_NN, 1);
+    REQUIRE(tuner.getCandidateCount() > 1);
+    REQUIRE_FALSE(tuner.isStored());
+    REQUIRE(table.getCount() == Generators::GemmTuningTable::MAX_ENTRIES);
+    REQUIRE(table.find(16, 4, 6, 16, 4, 16, Generators::Gemm::COLUMN_MAJOR_NN) == nullptr);
+
+    // the entry of a shape in the table is replaced
+    tuner.tune(emulated<float const>(X_ADDRESS), emulated<float const>(Y_ADDRESS), emulated<float>(Z_ADDRESS), 8, 4, 3, 8, 4, 8, Generators::Gemm::COLUMN_MAJOR_NN, 1);
+    REQUIRE(tuner.isStored());
+    REQUIRE(table.getCount() == Generators::GemmTuningTable::MAX_ENTRIES);
+}
+
+TEST_CASE("The default timer doesn't time candidates on the host", "[GEMM][TUNER]") {
+    alignas(4) static Instruction16 buffer[BUFFER_SIZE];
+    Generators::Gemm gemm(buffer, BUFFER_SIZE, programStorage, sizeof(programStorage));
+    Generators::GemmTuningTable table;
+    Generators::GemmTuner tuner(gemm, BUFFER_SIZE, table);
+    // the kernels are never called
+    Generators::Gemm::Tuning const tuning = tuner.tune(nullptr, nullptr, nullptr, 20, 10, 12, 20, 10, 20);
+    Generators::Gemm::Tuning const defaults = Generators::Gemm::defaultTuning();
+    REQUIRE(tuning.kMaxUnroll == defaults.kMaxUnroll);
+    REQUIRE(tuning.mMaxUnroll == defaults.mMaxUnroll);
+    REQUIRE(tuning.nMaxUnroll == defaults.nMaxUnroll);
+    REQUIRE(tuner.getCandidateCount() == 0);
+    REQUIRE_FALSE(tuner.isStored());
+    REQUIRE(table.getCount() == 0);
+}
+
+TEST_CASE("Tuning tables are printed as initializers", "[GEMM][TUNER]") {
+    Generators::Gemm::Tuning tuning = Generators::Gemm::defaultTuning();
+    tuning.kMaxUnroll = 2;
+    tuning.predicatedEdges = true;
+    Generators::GemmTuningTable::Entry const entries[] = {
+        {24, 24, 24, 24, 24, 24, Generators::Gemm::COLUMN_MAJOR_NN, tuning},
+        {20, 10, 12, 21, 10, 20, Generators::Gemm::ROW_MAJOR_NN, {false, 1, 0, 5, false}},
+    };
+    Generators::GemmTuningTable table(entries, 2);
+    std::string text;
+    table.print(appendLine, &text);
+    REQUIRE(text ==
+        "{24, 24, 24, 24, 24, 24, static_cast<JIT::Generators::Gemm::Layout>(0), {true, 2, 5, 3, true}},\n"
+        "{20, 10, 12, 21, 10, 20, static_cast<JIT::Generators::Gemm::Layout>(4), {false, 1, 0, 5, false}},\n");
+
+    // the printed entries are a valid initializer of the table
+    Generators::GemmTuningTable::Entry const printed[] = {
+        {24, 24, 24, 24, 24, 24, static_cast<JIT::Generators::Gemm::Layout>(0), {true, 2, 5, 3, true}},
+        {20, 10, 12, 21, 10, 20, static_cast<JIT::Generators::Gemm::Layout>(4), {false, 1, 0, 5, false}},
+    };
+    Generators::GemmTuningTable copy(printed, 2);
+    std::string copyText;
+    copy.print(appendLine, &copyText);
+    REQUIRE(copyText == text);
+}
@@ -0,0 +1,426 @@
+#include "catch2/catch_amalgamated.hpp"
+#include "backend/Backend.hpp"
+#include "backend/IR.hpp"
+#include "instructions/Arithmetic.hpp"
+#include "instructions/Base.hpp"
+#include "instructions/DataProcessing.hpp"
+#include "instructions/Vector.hpp"
+
+#include <cstdint>
+
+using namespace JIT;
+
+namespace {
+    Instructions::Instruction32 read(Instructions::Instruction16 const * buffer, uint32_t position) {
+        return static_cast<Instructions::Instruction32>(buffer[position]) << 16 | buffer[position + 1];
+    }
+}
+
+
+TEST_CASE("The arena hands out aligned storage until it is exhausted", "[IR]") {
+    alignas(4) uint8_t memory[16];
+    IR::Arena arena(memory, sizeof(memory));
+    uint8_t * bytes = arena.allocate<uint8_t>(3);
+    uint32_t * words = arena.allocate<uint32_t>(2);
+    REQUIRE(bytes == memory);
+    REQUIRE(reinterpret_cast<uint8_t *>(words) == memory + 4);
+    REQUIRE(arena.getUsed() == 12);
+    REQUIRE(arena.allocate<uint32_t>(2) == nullptr);
+    arena.reset();
+    REQUIRE(arena.allocate<uint32_t>(4) == reinterpret_cast<uint32_t *>(memory));
+}
+
+TEST_CASE("Programs which dropped nodes or labels are not encoded", "[IR]") {
+    constexpr uint32_t bytes = IR::Program::storageSize(4, 1);
+    REQUIRE(IR::Program::nodeCapacity(bytes, 1) == 4);
+    REQUIRE(IR::Program::nodeCapacity(bytes - 1, 1) == 3);
+    REQUIRE(IR::Program::nodeCapacity(IR::Program::storageSize(0, 1), 1) == 0);
+    alignas(4) uint8_t storage[bytes];
+    IR::Arena arena(storage, sizeof(storage));
+    IR::Program program(arena, 4, 1);
+    Instructions::Instruction16 buffer[16];
+    for (uint32_t i = 0; i < 4; i++) program.addInstruction(Instructions::Base::nop16());
+    REQUIRE(program.encode(buffer, 16) == 4);
+
+    SECTION("node") {
+        program.addInstruction(Instructions::Base::nop16());
+        REQUIRE(program.getNodeCount() == 4);
+        REQUIRE(program.encode(buffer, 16) == 0);
+    }
+    SECTION("label") {
+        program.newLabel();
+        REQUIRE(program.newLabel() == IR::Program::NO_LABEL);
+        REQUIRE(program.encode(buffer, 16) == 0);
+    }
+    program.reset();
+    program.addInstruction(Instructions::Base::nop16());
+    REQUIRE(program.encode(buffer, 16) == 1);
+}
+
+TEST_CASE("Branches are relaxed to the shortest encoding", "[IR]") {
+    alignas(4) uint8_t storage[IR::Program::storageSize(128, 2)];
+    IR::Arena arena(storage, sizeof(storage));
+    IR::Program program(arena, 128, 2);
+    IR::Program::Label near = program.newLabel();
+    IR::Program::Label far = program.newLabel();
+    program.addBranch(near, Instructions::NE);
+    program.addBranch(far, Instructions::EQ);
+    program.addInstruction(Instructions::Arithmetic::addImmediate32(Instructions::R0, Instructions::R0, 4));
+    program.bindLabel(near);
+    for (uint32_t i = 0; i < 100; i++) program.addInstruction(Instructions::Arithmetic::addImmediate32(Instructions::R1, Instructions::R1, 4));
+    program.bindLabel(far);
+    program.addInstruction(Instructions::Base::nop16());
+
+    Instructions::Instruction16 buffer[256];
+    SECTION("without relaxation all branches are 32-bit") {
+        REQUIRE(program.encode(buffer, 256) == 2 + 2 + 2 + 200 + 1);
+        REQUIRE(read(buffer, 0) == Instructions::Base::bCond32(Instructions::NE, 8));
+    }
+    SECTION("relaxed") {
+        IR::Passes::relaxBranches(program);
+        REQUIRE(program.encode(buffer, 256) == 1 + 2 + 2 + 200 + 1);
+        REQUIRE(buffer[0] == Instructions::Base::bCond16(Instructions::NE, 6));
+        REQUIRE(read(buffer, 1) == Instructions::Base::bCond32(Instructions::EQ, 404));
+    }
+    SECTION("the buffer is too small") {
+        REQUIRE(program.encode(buffer, 100) == 0);
+    }
+}
+
+TEST_CASE("Loop ends branch back to their label", "[IR]") {
+    alignas(4) uint8_t storage[IR::Program::storageSize(8, 2)];
+    IR::Arena arena(storage, sizeof(storage));
+    IR::Program program(arena, 8, 2);
+    Instructions::Instruction16 buffer[16];
+    IR::Program::Label loop = program.newLabel();
+    program.addInstruction(Instructions::Base::dlstp(Instructions::R4, Instructions::Size32));
+    program.bindLabel(loop);
+    program.addInstruction(Instructions::Vector::vldrw(Instructions::Q0, Instructions::R0, 16, false, true));
+    program.addInstruction(Instructions::Vector::vstrw(Instructions::Q0, Instructions::R1, 16, false, true));
+    program.addLoopEnd(loop, true);
+    REQUIRE(program.encode(buffer, 16) == 8);
+    REQUIRE(read(buffer, 6) == Instructions::Base::letp(-12));
+
+    SECTION("unbound labels are rejected") {
+        program.addBranch(program.newLabel());
+        REQUIRE(program.encode(buffer, 16) == 0);
+    }
+}
+
+TEST_CASE("Aligned instructions and loop starts are padded to words", "[IR]") {
+    alignas(4) uint8_t storage[IR::Program::storageSize(8, 1)];
+    IR::Arena arena(storage, sizeof(storage));
+    IR::Program program(arena, 8, 1);
+    Instructions::Instruction16 buffer[16];
+    Instructions::Instruction32 const load = Instructions::Vector::vldrw(Instructions::Q0, Instructions::R0);
+    program.addInstruction(Instructions::Base::nop16());
+    program.addInstruction(load, true);
+
+    SECTION("word aligned base") {
+        REQUIRE(program.encode(buffer, 16) == 4);
+        REQUIRE(buffer[1] == Instructions::Base::nop16());
+        REQUIRE(read(buffer, 2) == load);
+    }
+    SECTION("halfword aligned base") {
+        program.setBaseAddress(2);
+        REQUIRE(program.encode(buffer, 16) == 3);
+        REQUIRE(read(buffer, 1) == load);
+    }
+    SECTION("not inside a VPT block") {
+        program.reset();
+        program.addInstruction(Instructions::Base::nop16());
+        program.addInstruction(Instructions::Vector::vpst(1));
+        program.addInstruction(load, true);
+        REQUIRE(program.encode(buffer, 16) == 5);
+    }
+    SECTION("loop starts") {
+        program.reset();
+        IR::Program::Label loop = program.newLabel();
+        program.addInstruction(Instructions::Base::nop16());
+        program.bindLabel(loop);
+        program.addInstruction(load);
+        program.addLoopEnd(loop);
+        IR::Passes::alignLoops(program);
+        REQUIRE(program.encode(buffer, 16) == 6);
+        REQUIRE(read(buffer, 2) == load);
+        REQUIRE(read(buffer, 4) == Instructions::Base::le(-8));
+    }
+}
+
+TEST_CASE("The peephole pass removes instructions without effect", "[IR]") {
+    alignas(4) uint8_t storage[IR::Program::storageSize(8, 1)];
+    IR::Arena arena(storage, sizeof(storage));
+    IR::Program program(arena, 8, 1);
+    Instructions::Instruction32 const add = Instructions::Arithmetic::addImmediate32(Instructions::R1, Instructions::R1, 4);
+    program.addInstruction(Instructions::Base::nop32());
+    program.addInstruction(Instructions::DataProcessing::movRegister32(Instructions::R3, Instructions::R3));
+    program.addInstruction(add);
+    program.addInstruction(Instructions::Arithmetic::addImmediate32(Instructions::R2, Instructions::R2, 0));
+    program.addInstruction(Instructions::Arithmetic::addImmediate32(Instructions::R2, Instructions::R3, 0));
+    program.addInstruction(Instructions::DataProcessing::movRegister32(Instructions::R3, Instructions::R3, Instructions::LSL, 2));
+    IR::Passes::peephole(program);
+    REQUIRE(program.getNodeCount() == 3);
+    REQUIRE(program.getNodes()[0].encoding == add);
+}
+
+TEST_CASE("The peephole pass folds pointer updates and drops overwritten results", "[IR]") {
+    alignas(4) uint8_t storage[IR::Program::storageSize(8, 1)];
+    IR::Arena arena(storage, sizeof(storage));
+    IR::Program program(arena, 8, 1);
+    Instructions::Instruction32 const fma = Instructions::Vector::vfmaVectorByScalarPlusVector(Instructions::Q1, Instructions::Q2, Instructions::R3);
+    IR::Program::Node const * nodes = program.getNodes();
+
+    SECTION("pre- and post-indexed writeback") {
+        program.addInstruction(Instructions::Vector::vldrw(Instructions::Q0, Instructions::R0, 16));
+        program.addInstruction(fma);
+        program.addInstruction(Instructions::Arithmetic::addImmediate32(Instructions::R0, Instructions::R0, 16));
+        program.addInstruction(Instructions::DataProcessing::ldrImmediate32(Instructions::R4, Instructions::R1));
+        program.addInstruction(Instructions::Arithmetic::subImmediate32(Instructions::R1, Instructions::R1, 8));
+        IR::Passes::peephole(program);
+        REQUIRE(program.getNodeCount() == 3);
+        REQUIRE(nodes[0].encoding == Instructions::Vector::vldrw(Instructions::Q0, Instructions::R0, 16, true, true));
+        REQUIRE(nodes[2].encoding == Instructions::DataProcessing::ldrImmediate32(Instructions::R4, Instructions::R1, -8, false, true));
+    }
+    SECTION("the update is folded into the last access of the pointer") {
+        program.addInstruction(Instructions::Vector::vldrw(Instructions::Q0, Instructions::R0, 16));
+        program.addInstruction(Instructions::Vector::vstrw(Instructions::Q1, Instructions::R0));
+        program.addInstruction(Instructions::Arithmetic::addImmediate32(Instructions::R0, Instructions::R0, 16));
+        IR::Passes::peephole(program);
+        REQUIRE(program.getNodeCount() == 2);
+        REQUIRE(nodes[0].encoding == Instructions::Vector::vldrw(Instructions::Q0, Instructions::R0, 16));
+        REQUIRE(nodes[1].encoding == Instructions::Vector::vstrw(Instructions::Q1, Instructions::R0, 16, false, true));
+    }
+    SECTION("rewinds are merged or dropped") {
+        program.addInstruction(Instructions::Arithmetic::subImmediate32(Instructions::R2, Instructions::R2, 20));
+        program.addInstruction(fma);
+        program.addInstruction(Instructions::Arithmetic::addImmediate32(Instructions::R2, Instructions::R2, 20));
+        program.addInstruction(Instructions::Arithmetic::addImmediate32(Instructions::R5, Instructions::R5, 8));
+        program.addInstruction(Instructions::Arithmetic::addImmediate32(Instructions::R5, Instructions::R5, 24));
+        program.addInstruction(Instructions::Arithmetic::addImmediate32(Instructions::R6, Instructions::R6, 8));
+        program.addInstruction(Instructions::Arithmetic::addRegister32(Instructions::R6, Instructions::R3, Instructions::R4));
+        IR::Passes::peephole(program);
+        REQUIRE(program.getNodeCount() == 3);
+        REQUIRE(nodes[0].encoding == fma);
+        REQUIRE(nodes[1].encoding == Instructions::Arithmetic::addImmediate32(Instructions::R5, Instructions::R5, 32));
+    }
+    SECTION("labels end the search") {
+        program.addInstruction(Instructions::Arithmetic::addImmediate32(Instructions::R6, Instructions::R6, 8));
+        program.bindLabel(program.newLabel());
+        program.addInstruction(Instructions::Arithmetic::addRegister32(Instructions::R6, Instructions::R3, Instructions::R4));
+        IR::Passes::peephole(program);
+        REQUIRE(program.getNodeCount() == 3);
+    }
+}
+
+TEST_CASE("The narrow pass picks 16-bit encodings", "[IR]") {
+    alignas(4) uint8_t storage[IR::Program::storageSize(16, 2)];
+    IR::Arena arena(storage, sizeof(storage));
+    IR::Program program(arena, 16, 2);
+    IR::Program::Node const * nodes = program.getNodes();
+    Instructions::Instruction32 const addw = Instructions::Arithmetic::addImmediate32(Instructions::R2, Instructions::R2, 32);
+
+    SECTION("loads and moves keep the flags") {
+        program.addInstruction(Instructions::DataProcessing::ldrImmediate32(Instructions::R7, Instructions::R1, 20));
+        program.addInstruction(Instructions::DataProcessing::ldrImmediate32(Instructions::R7, Instructions::R1, 128));
+        program.addInstruction(Instructions::DataProcessing::ldrImmediate32(Instructions::R8, Instructions::R1, 20));
+        program.addInstruction(Instructions::DataProcessing::movRegister32(Instructions::R9, Instructions::R0));
+        program.addInstruction(Instructions::Arithmetic::addRegister32(Instructions::R10, Instructions::R10, Instructions::R3));
+        IR::Passes::narrow(program);
+        REQUIRE(nodes[0].size == 1);
+        REQUIRE(nodes[0].encoding == Instructions::DataProcessing::ldrImmediate16(Instructions::R7, Instructions::R1, 20));
+        REQUIRE(nodes[1].size == 2);
+        REQUIRE(nodes[2].size == 2);
+        REQUIRE(nodes[3].encoding == Instructions::DataProcessing::movRegister16(Instructions::R9, Instructions::R0));
+        REQUIRE(nodes[4].encoding == Instructions::Arithmetic::addRegister16(Instructions::R10, Instructions::R3));
+    }
+    SECTION("flag setting encodings only where the flags are dead") {
+        IR::Program::Label loop = program.newLabel();
+        program.bindLabel(loop);
+        program.addInstruction(addw);
+        program.addInstruction(Instructions::DataProcessing::movImmediate32(Instructions::R3, 200));
+        program.addInstruction(Instructions::Base::cmpImmediate32(Instructions::R4, 15));
+        program.addInstruction(addw);
+        program.addBranch(loop, Instructions::LT);
+        IR::Passes::narrow(program);
+        REQUIRE(nodes[1].encoding == Instructions::Arithmetic::addImmediate16(Instructions::R2, 32));
+        REQUIRE(nodes[2].encoding == Instructions::DataProcessing::movImmediate16(Instructions::R3, 200));
+        REQUIRE(nodes[4].encoding == addw);
+    }
+    SECTION("nothing sets the flags if a branch does not follow its compare") {
+        IR::Program::Label loop = program.newLabel();
+        program.bindLabel(loop);
+        program.addInstruction(Instructions::Base::cmpImmediate32(Instructions::R4, 15));
+        program.bindLabel(program.newLabel());
+        program.addInstruction(addw);
+        program.addBranch(loop, Instructions::NE);
+        IR::Passes::narrow(program);
+        REQUIRE(nodes[3].encoding == addw);
+    }
+}
+
+TEST_CASE("The schedule pass reorders inside basic blocks", "[IR]") {
+    alignas(4) uint8_t storage[IR::Program::storageSize(8, 1)];
+    IR::Arena arena(storage, sizeof(storage));
+    IR::Program program(arena, 8, 1);
+    Instructions::Instruction32 const loadQ0 = Instructions::Vector::vldrw(Instructions::Q0, Instructions::R0, 16, false, true);
+    Instructions::Instruction32 const loadQ2 = Instructions::Vector::vldrw(Instructions::Q2, Instructions::R1, 16, false, true);
+    Instructions::Instruction32 const fmaQ1 = Instructions::Vector::vfmaVectorByScalarPlusVector(Instructions::Q1, Instructions::Q0, Instructions::R3);
+    Instructions::Instruction32 const fmaQ3 = Instructions::Vector::vfmaVectorByScalarPlusVector(Instructions::Q3, Instructions::Q2, Instructions::R3);
+    program.addInstruction(loadQ0);
+    program.addInstruction(loadQ2);
+    program.addInstruction(fmaQ1);
+    program.addInstruction(fmaQ3);
+    program.bindLabel(program.newLabel());
+    program.addInstruction(loadQ0);
+    program.addInstruction(loadQ2);
+
+    IR::Passes::schedule(program);
+    IR::Program::Node const * nodes = program.getNodes();
+    REQUIRE(nodes[1].encoding == fmaQ1);
+    REQUIRE(nodes[2].encoding == loadQ2);
+    REQUIRE(nodes[4].opcode == IR::Program::LABEL);
+    REQUIRE(nodes[5].encoding == loadQ0);
+}
+
+TEST_CASE("The backend emits programs through the pipeline", "[IR]") {
+    Instructions::Instruction16 buffer[32];
+    Backend backend(buffer, 32);
+    alignas(4) uint8_t storage[IR::Program::storageSize(8, 1)];
+    IR::Arena arena(storage, sizeof(storage));
+    IR::Program program(arena, 8, 1);
+
+    backend.addInstruction(Instructions::Base::nop16());
+    backend.beginProgram(program);
+    IR::Program::Label loop = backend.newLabel();
+    backend.bindLabel(loop);
+    backend.addInstruction(Instructions::Base::nop32()); // removed by the peephole pass
+    backend.addInstruction(Instructions::Arithmetic::subImmediate32(Instructions::R0, Instructions::R0, 1));
+    REQUIRE(backend.addBranchTargetInstruction(Instructions::Base::nop16()) == nullptr);
+    backend.addBranch(loop, Instructions::NE);
+    REQUIRE(backend.getInstructionCount() == 1);
+    backend.endProgram();
+
+    REQUIRE(backend.getInstructionCount() == 4);
+    REQUIRE(read(buffer, 1) == Instructions::Arithmetic::subImmediate32(Instructions::R0, Instructions::R0, 1));
+    REQUIRE(buffer[3] == Instructions::Base::bCond16(Instructions::NE, -8));
+    REQUIRE(backend.newLabel() == IR::Program::NO_LABEL);
+}
+
+TEST_CASE("Compare branches use CBZ when the label is in reach", "[IR]") {
+    alignas(4) uint8_t storage[IR::Program::storageSize(128, 1)];
+    IR::Arena arena(storage, sizeof(storage));
+    IR::Program program(arena, 128, 1);
+    Instructions::Instruction16 buffer[256];
+    Instructions::Instruction32 const add = Instructions::Arithmetic::addImmediate32(Instructions::R1, Instructions::R1, 4);
+    IR::Program::Label skip = program.newLabel();
+
+    SECTION("CBZ") {
+        program.addCompareBranch(Instructions::R2, skip);
+        program.addInstruction(add);
+        program.bindLabel(skip);
+        IR::Passes::relaxBranches(program);
+        REQUIRE(program.encode(buffer, 256) == 3);
+        REQUIRE(buffer[0] == Instructions::Base::cbz(Instructions::R2, 2));
+    }
+    SECTION("CBNZ out of reach becomes CMP + Bcc") {
+        program.addCompareBranch(Instructions::R2, skip, true);
+        for (uint32_t i = 0; i < 40; i++) program.addInstruction(add);
+        program.bindLabel(skip);
+        IR::Passes::relaxBranches(program);
+        REQUIRE(program.encode(buffer, 256) == 2 + 80);
+        REQUIRE(buffer[0] == Instructions::Base::cmpImmediate16(Instructions::R2, 0));
+        REQUIRE(buffer[1] == Instructions::Base::bCond16(Instructions::NE, 158));
+    }
+    SECTION("high registers are compared with CMP.W") {
+        program.addCompareBranch(Instructions::R9, skip);
+        for (uint32_t i = 0; i < 100; i++) program.addInstruction(add);
+        program.bindLabel(skip);
+        IR::Passes::relaxBranches(program);
+        REQUIRE(program.encode(buffer, 256) == 4 + 200);
+        REQUIRE(read(buffer, 0) == Instructions::Base::cmpImmediate32(Instructions::R9, 0));
+        REQUIRE(read(buffer, 2) == Instructions::Base::bCond32(Instructions::EQ, 400));
+    }
+}
+
+TEST_CASE("While loop starts branch past the loop end", "[IR]") {
+    alignas(4) uint8_t storage[IR::Program::storageSize(8, 2)];
+    IR::Arena arena(storage, sizeof(storage));
+    IR::Program program(arena, 8, 2);
+    Instructions::Instruction16 buffer[16];
+    IR::Program::Label loop = program.newLabel();
+    IR::Program::Label exit = program.newLabel();
+    program.addLoopStart(Instructions::R4, exit, true, Instructions::Size32);
+    program.bindLabel(loop);
+    program.addInstruction(Instructions::Vector::vldrw(Instructions::Q0, Instructions::R0, 16, false, true));
+    program.addLoopEnd(loop, true);
+    program.bindLabel(exit);
+    REQUIRE(program.encode(buffer, 16) == 6);
+    REQUIRE(read(buffer, 0) == Instructions::Base::wlstp(Instructions::R4, Instructions::Size32, 8));
+    REQUIRE(read(buffer, 4) == Instructions::Base::letp(-8));
+}
+
+TEST_CASE("Literal loads read from a pool behind the code", "[IR]") {
+    alignas(4) uint8_t storage[IR::Program::storageSize(16, 1, 4)];
+    IR::Arena arena(storage, sizeof(storage));
+    IR::Program program(arena, 16, 1, 4);
+    Instructions::Instruction16 buffer[32];
+    program.addLiteralLoad(Instructions::R3, 0x1234'5678);
+    program.addLiteralLoad(Instructions::R9, 0xdead'beef);
+    program.addLiteralLoad(Instructions::R0, 0x1234'5678); // shares the first literal
+    program.addInstruction(Instructions::DataProcessing::pop32(Instructions::R4, Instructions::PC));
+    IR::Passes::placeLiteralPools(program);
+    IR::Passes::relaxBranches(program);
+
+    REQUIRE(program.encode(buffer, 32) == 10);
+    REQUIRE(buffer[0] == Instructions::DataProcessing::ldrLiteral16(Instructions::R3, 8));
+    REQUIRE(read(buffer, 1) == Instructions::DataProcessing::ldrLiteral32(Instructions::R9, 12));
+    REQUIRE(buffer[3] == Instructions::DataProcessing::ldrLiteral16(Instructions::R0, 4));
+    REQUIRE(buffer[6] == 0x5678);
+    REQUIRE(buffer[7] == 0x1234);
+    REQUIRE(buffer[8] == 0xbeef);
+    REQUIRE(buffer[9] == 0xdead);
+}
+
+TEST_CASE("Distant literals get a pool with a branch around it", "[IR]") {
+    constexpr uint16_t ADDS = 1100;
+    alignas(4) static uint8_t storage[IR::Program::storageSize(ADDS + 8, 1, 1)];
+    IR::Arena arena(storage, sizeof(storage));
+    IR::Program program(arena, ADDS + 8, 1, 1);
+    static Instructions::Instruction16 buffer[2 * ADDS + 16];
+    Instructions::Instruction32 const add = Instructions::Arithmetic::addImmediate32(Instructions::R1, Instructions::R1, 4);
+    program.addLiteralLoad(Instructions::R1, 0x8000'0000);
+    for (uint16_t i = 0; i < ADDS; i++) program.addInstruction(add);
+    program.addInstruction(Instructions::DataProcessing::pop32(Instructions::R4, Instructions::PC));
+    IR::Passes::placeLiteralPools(program);
+    IR::Passes::relaxBranches(program);
+
+    // the pool is placed in front of the add at which it would be out of reach of the (then still 32-bit) load
+    REQUIRE(program.encode(buffer, 2 * ADDS + 16) == 2 + 2 * ADDS + 1 + 1 + 2 + 2);
+    REQUIRE(read(buffer, 0) == Instructions::DataProcessing::ldrLiteral32(Instructions::R1, 4016));
+    REQUIRE(read(buffer, 2006) == add);
+    REQUIRE(buffer[2008] == Instructions::Base::b16(4));
+    REQUIRE(buffer[2009] == Instructions::Base::nop16());
+    REQUIRE(buffer[2010] == 0x0000);
+    REQUIRE(buffer[2011] == 0x8000);
+    REQUIRE(read(buffer, 2012) == add);
+}
+
+TEST_CASE("The backend loads large constants from literal pools", "[IR]") {
+    alignas(4) Instructions::Instruction16 buffer[32];
+    Backend backend(buffer, 32);
+    alignas(4) uint8_t storage[IR::Program::storageSize(8, 1, 2)];
+    IR::Arena arena(storage, sizeof(storage));
+    IR::Program program(arena, 8, 1, 2);
+
+    backend.beginProgram(program);
+    backend.addMoveImmediate(Instructions::R2, 0x3f80'0000);
+    backend.addMoveImmediate(Instructions::R3, 100); // MOVW only, narrowed to MOVS
+    backend.addInstruction(Instructions::DataProcessing::pop32(Instructions::R4, Instructions::PC));
+    backend.endProgram();
+
+    REQUIRE(backend.getInstructionCount() == 6);
+    REQUIRE(buffer[0] == Instructions::DataProcessing::ldrLiteral16(Instructions::R2, 4));
+    REQUIRE(buffer[1] == Instructions::DataProcessing::movImmediate16(Instructions::R3, 100));
+    REQUIRE(buffer[4] == 0x0000);
+    REQUIRE(buffer[5] == 0x3f80);
+}
@@ -0,0 +1,101 @@
+#include "catch2/catch_amalgamated.hpp"
+#include "backend/RegisterAllocator.hpp"
+#include "instructions/Base.hpp"
+
+#include <cstdint>
+
+using namespace JIT;
+
+
+TEST_CASE("Registers are handed out in pool order", "[REGISTER_ALLOCATOR]") {
+    RegisterAllocator allocator;
+    allocator.addRegister(Instructions::R10);
+    allocator.addRegister(Instructions::R11);
+    allocator.addRegister(Instructions::R4);
+    RegisterAllocator::Interval first = allocator.addInterval(0, 4, 1);
+    RegisterAllocator::Interval second = allocator.addInterval(0, 4, 1);
+    RegisterAllocator::Interval third = allocator.addInterval(0, 4, 1);
+    allocator.allocate();
+    REQUIRE(allocator.getRegister(first) == Instructions::R10);
+    REQUIRE(allocator.getRegister(second) == Instructions::R11);
+    REQUIRE(allocator.getRegister(third) == Instructions::R4);
+}
+
+TEST_CASE("Lighter intervals are spilled", "[REGISTER_ALLOCATOR]") {
+    RegisterAllocator allocator;
+    allocator.addRegister(Instructions::R10);
+    allocator.addRegister(Instructions::R11);
+    SECTION("equal starts: higher weights are allocated first") {
+        RegisterAllocator::Interval light = allocator.addInterval(0, 4, 1);
+        RegisterAllocator::Interval heavy = allocator.addInterval(0, 4, 3);
+        RegisterAllocator::Interval medium = allocator.addInterval(0, 4, 2);
+        allocator.allocate();
+        REQUIRE_FALSE(allocator.isAllocated(light));
+        REQUIRE(allocator.getRegister(heavy) == Instructions::R10);
+        REQUIRE(allocator.getRegister(medium) == Instructions::R11);
+    }
+    SECTION("a later heavy interval takes the register of an active light one") {
+        RegisterAllocator::Interval light = allocator.addInterval(0, 4, 1);
+        RegisterAllocator::Interval medium = allocator.addInterval(0, 4, 2);
+        RegisterAllocator::Interval heavy = allocator.addInterval(2, 3, 3);
+        allocator.allocate();
+        REQUIRE_FALSE(allocator.isAllocated(light));
+        REQUIRE(allocator.getRegister(medium) == Instructions::R10);
+        REQUIRE(allocator.getRegister(heavy) == Instructions::R11);
+    }
+    SECTION("a later light interval is spilled itself") {
+        RegisterAllocator::Interval first = allocator.addInterval(0, 4, 2);
+        RegisterAllocator::Interval second = allocator.addInterval(0, 4, 2);
+        RegisterAllocator::Interval late = allocator.addInterval(1, 4, 2);
+        allocator.allocate();
+        REQUIRE(allocator.isAllocated(first));
+        REQUIRE(allocator.isAllocated(second));
+        REQUIRE_FALSE(allocator.isAllocated(late));
+    }
+}
+
+TEST_CASE("Registers are reused after the live range ended", "[REGISTER_ALLOCATOR]") {
+    RegisterAllocator allocator;
+    allocator.addRegister(Instructions::R12);
+    RegisterAllocator::Interval first = allocator.addInterval(0, 2, 1);
+    RegisterAllocator::Interval second = allocator.addInterval(2, 4, 1);
+    RegisterAllocator::Interval overlapping = allocator.addInterval(3, 5, 1);
+    allocator.allocate();
+    REQUIRE(allocator.getRegister(first) == Instructions::R12);
+    REQUIRE(allocator.getRegister(second) == Instructions::R12);
+    REQUIRE_FALSE(allocator.isAllocated(overlapping));
+}
+
+TEST_CASE("General-purpose and vector registers are allocated independently", "[REGISTER_ALLOCATOR]") {
+    RegisterAllocator allocator;
+    allocator.addRegister(Instructions::R10);
+    allocator.addVectorRegister(Instructions::Q7);
+    allocator.addVectorRegister(Instructions::Q6);
+    RegisterAllocator::Interval scalar = allocator.addInterval(0, 4, 1);
+    RegisterAllocator::Interval bound = allocator.addVectorInterval(0, 4, 1);
+    RegisterAllocator::Interval temp = allocator.addVectorInterval(1, 4, 2);
+    allocator.allocate();
+    REQUIRE(allocator.getRegister(scalar) == Instructions::R10);
+    REQUIRE(allocator.getVectorRegister(bound) == Instructions::Q7);
+    REQUIRE(allocator.getVectorRegister(temp) == Instructions::Q6);
+
+    SECTION("allocation can be repeated with further intervals") {
+        RegisterAllocator::Interval second = allocator.addVectorInterval(0, 4, 3);
+        allocator.allocate();
+        REQUIRE(allocator.getVectorRegister(second) == Instructions::Q7);
+        REQUIRE(allocator.getVectorRegister(temp) == Instructions::Q6);
+        REQUIRE_FALSE(allocator.isAllocated(bound));
+    }
+}
+
+TEST_CASE("Invalid intervals are rejected", "[REGISTER_ALLOCATOR]") {
+    RegisterAllocator allocator;
+    REQUIRE(allocator.addInterval(2, 2, 1) == RegisterAllocator::NO_INTERVAL);
+    for (uint8_t i = 0; i < RegisterAllocator::MAX_INTERVALS; i++) {
+        REQUIRE(allocator.addInterval(0, 1, 1) == i);
+    }
+    REQUIRE(allocator.addInterval(0, 1, 1) == RegisterAllocator::NO_INTERVAL);
+    allocator.allocate();
+    REQUIRE_FALSE(allocator.isAllocated(0));
+    REQUIRE_FALSE(allocator.isAllocated(RegisterAllocator::NO_INTERVAL));
+}
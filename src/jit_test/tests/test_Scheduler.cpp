@@ -0,0 +1,194 @@
+#include "catch2/catch_amalgamated.hpp"
+#include "backend/Backend.hpp"
+#include "backend/Scheduler.hpp"
+#include "instructions/Arithmetic.hpp"
+#include "instructions/Base.hpp"
+#include "instructions/DataProcessing.hpp"
+#include "instructions/Vector.hpp"
+
+#include <cstdint>
+
+using namespace JIT;
+
+namespace {
+    void write(Instructions::Instruction16 * buffer, Instructions::Instruction32 const * instructions, uint8_t count) {
+        for (uint8_t i = 0; i < count; i++) {
+            buffer[2 * i] = static_cast<Instructions::Instruction16>(instructions[i] >> 16);
+            buffer[2 * i + 1] = static_cast<Instructions::Instruction16>(instructions[i]);
+        }
+    }
+
+    Instructions::Instruction32 read(Instructions::Instruction16 const * buffer, uint16_t position) {
+        return static_cast<Instructions::Instruction32>(buffer[position]) << 16 | buffer[position + 1];
+    }
+}
+
+
+TEST_CASE("Movable instructions are decoded", "[SCHEDULER]") {
+    SECTION("vector loads and stores") {
+        Scheduler::Operation op = Scheduler::decode(Instructions::Vector::vldrw(Instructions::Q2, Instructions::R0, 16, false, true));
+        REQUIRE(op.type == Scheduler::VECTOR_LOAD);
+        REQUIRE(op.uses == 1 << Instructions::R0);
+        REQUIRE(op.defs == 1 << Instructions::R0);
+        REQUIRE(op.vectorDefs == 1 << Instructions::Q2);
+        op = Scheduler::decode(Instructions::Vector::vstrw(Instructions::Q3, Instructions::R2, 32));
+        REQUIRE(op.type == Scheduler::VECTOR_STORE);
+        REQUIRE(op.defs == 0);
+        REQUIRE(op.vectorUses == 1 << Instructions::Q3);
+    }
+    SECTION("multiply accumulate") {
+        Scheduler::Operation op = Scheduler::decode(Instructions::Vector::vfmaVectorByScalarPlusVector(Instructions::Q1, Instructions::Q6, Instructions::R7));
+        REQUIRE(op.type == Scheduler::VECTOR_MAC);
+        REQUIRE(op.uses == 1 << Instructions::R7);
+        REQUIRE(op.vectorDefs == 1 << Instructions::Q1);
+        REQUIRE(op.vectorUses == ((1 << Instructions::Q1) | (1 << Instructions::Q6)));
+        op = Scheduler::decode(Instructions::Vector::vmulVectorByScalar(Instructions::Q1, Instructions::Q6, Instructions::R7));
+        REQUIRE(op.type == Scheduler::VECTOR_MAC);
+        REQUIRE(op.vectorUses == 1 << Instructions::Q6);
+        op = Scheduler::decode(Instructions::Vector::vfma(Instructions::Q0, Instructions::Q1, Instructions::Q2));
+        REQUIRE(op.type == Scheduler::VECTOR_MAC);
+        REQUIRE(op.vectorUses == 0b111);
+        // the epilogue operations use the FP pipeline like the multiply accumulates
+        op = Scheduler::decode(Instructions::Vector::vaddFloat(Instructions::Q0, Instructions::Q0, Instructions::Q6));
+        REQUIRE(op.type == Scheduler::VECTOR_MAC);
+        REQUIRE(op.vectorDefs == 1 << Instructions::Q0);
+        REQUIRE(op.vectorUses == ((1 << Instructions::Q0) | (1 << Instructions::Q6)));
+        op = Scheduler::decode(Instructions::Vector::vaddFloatScalar(Instructions::Q2, Instructions::Q1, Instructions::R6));
+        REQUIRE(op.type == Scheduler::VECTOR_MAC);
+        REQUIRE(op.uses == 1 << Instructions::R6);
+        REQUIRE(op.vectorDefs == 1 << Instructions::Q2);
+        REQUIRE(op.vectorUses == 1 << Instructions::Q1);
+        REQUIRE(Scheduler::decode(Instructions::Vector::vmaxnm(Instructions::Q3, Instructions::Q3, Instructions::Q7)).type == Scheduler::VECTOR_MAC);
+        op = Scheduler::decode(Instructions::Vector::vminnm(Instructions::Q3, Instructions::Q4, Instructions::Q7));
+        REQUIRE(op.type == Scheduler::VECTOR_MAC);
+        REQUIRE(op.vectorUses == ((1 << Instructions::Q4) | (1 << Instructions::Q7)));
+    }
+    SECTION("scalar instructions") {
+        Scheduler::Operation op = Scheduler::decode(Instructions::DataProcessing::ldrImmediate32(Instructions::R6, Instructions::R1, 4, false, true));
+        REQUIRE(op.type == Scheduler::SCALAR_LOAD);
+        REQUIRE(op.defs == ((1 << Instructions::R6) | (1 << Instructions::R1)));
+        op = Scheduler::decode(Instructions::DataProcessing::ldrImmediate32(Instructions::R6, Instructions::R1, 400));
+        REQUIRE(op.type == Scheduler::SCALAR_LOAD);
+        REQUIRE(op.defs == 1 << Instructions::R6);
+        op = Scheduler::decode(Instructions::Arithmetic::addImmediate32(Instructions::R3, Instructions::R0, 64));
+        REQUIRE(op.type == Scheduler::SCALAR_ALU);
+        REQUIRE(op.uses == 1 << Instructions::R0);
+        REQUIRE(op.defs == 1 << Instructions::R3);
+        op = Scheduler::decode(Instructions::DataProcessing::movtImmediate32(Instructions::R10, 1));
+        REQUIRE(op.type == Scheduler::SCALAR_ALU);
+        REQUIRE(op.uses == 1 << Instructions::R10);
+    }
+    SECTION("everything else is a barrier") {
+        REQUIRE(Scheduler::decode(Instructions::DataProcessing::push32(Instructions::R4, Instructions::R5)).type == Scheduler::BARRIER);
+        REQUIRE(Scheduler::decode(Instructions::Base::nop32()).type == Scheduler::BARRIER);
+        REQUIRE(Scheduler::decode(Instructions::Arithmetic::addImmediate32(Instructions::SP, Instructions::SP, 8)).type == Scheduler::BARRIER);
+        REQUIRE(Scheduler::decode(Instructions::DataProcessing::ldrImmediate32(Instructions::PC, Instructions::R1, 4)).type == Scheduler::BARRIER);
+        REQUIRE(Scheduler::decode(Instructions::Vector::vpst(2)).type == Scheduler::BARRIER);
+        REQUIRE(Scheduler::predicatedInstructions(Instructions::Vector::vpst(2)) == 2);
+        REQUIRE(Scheduler::predicatedInstructions(Instructions::Base::nop32()) == 0);
+    }
+}
+
+TEST_CASE("Independent loads and multiply accumulates are interleaved", "[SCHEDULER]") {
+    Instructions::Instruction32 const emitted[] = {
+        Instructions::Vector::vldrw(Instructions::Q0, Instructions::R0, 16, false, true),
+        Instructions::Vector::vldrw(Instructions::Q2, Instructions::R1, 16, false, true),
+        Instructions::Vector::vfmaVectorByScalarPlusVector(Instructions::Q1, Instructions::Q0, Instructions::R3),
+        Instructions::Vector::vfmaVectorByScalarPlusVector(Instructions::Q3, Instructions::Q2, Instructions::R3),
+    };
+    Instructions::Instruction16 buffer[8];
+    write(buffer, emitted, 4);
+    Scheduler::schedule(buffer, 8);
+    Instructions::Instruction32 const scheduled[] = {read(buffer, 0), read(buffer, 2), read(buffer, 4), read(buffer, 6)};
+    REQUIRE(scheduled[0] == emitted[0]);
+    REQUIRE(scheduled[1] == emitted[2]);
+    REQUIRE(scheduled[2] == emitted[1]);
+    REQUIRE(scheduled[3] == emitted[3]);
+    REQUIRE(Scheduler::estimateCycles(scheduled, 4) < Scheduler::estimateCycles(emitted, 4));
+}
+
+TEST_CASE("Dependencies keep their order", "[SCHEDULER]") {
+    Instructions::Instruction16 buffer[8];
+    SECTION("register reuse") {
+        Instructions::Instruction32 const emitted[] = {
+            Instructions::Vector::vldrw(Instructions::Q0, Instructions::R0, 16, false, true),
+            Instructions::Vector::vfmaVectorByScalarPlusVector(Instructions::Q1, Instructions::Q0, Instructions::R3),
+            Instructions::Vector::vldrw(Instructions::Q0, Instructions::R1, 16, false, true),
+            Instructions::Vector::vfmaVectorByScalarPlusVector(Instructions::Q1, Instructions::Q0, Instructions::R4),
+        };
+        write(buffer, emitted, 4);
+        Scheduler::schedule(buffer, 8);
+        for (uint8_t i = 0; i < 4; i++) REQUIRE(read(buffer, 2 * i) == emitted[i]);
+    }
+    SECTION("loads are not moved above stores") {
+        Instructions::Instruction32 const emitted[] = {
+            Instructions::Vector::vfmaVectorByScalarPlusVector(Instructions::Q1, Instructions::Q0, Instructions::R3),
+            Instructions::Vector::vstrw(Instructions::Q1, Instructions::R2, 16, false, true),
+            Instructions::Vector::vldrw(Instructions::Q4, Instructions::R0),
+        };
+        write(buffer, emitted, 3);
+        Scheduler::schedule(buffer, 6);
+        for (uint8_t i = 0; i < 3; i++) REQUIRE(read(buffer, 2 * i) == emitted[i]);
+    }
+}
+
+TEST_CASE("Barriers and VPT blocks keep their position", "[SCHEDULER]") {
+    Instructions::Instruction16 buffer[16];
+    uint16_t count = 0;
+    auto add = [&](Instructions::Instruction32 instr) {
+        buffer[count++] = static_cast<Instructions::Instruction16>(instr >> 16);
+        buffer[count++] = static_cast<Instructions::Instruction16>(instr);
+    };
+    add(Instructions::Vector::vldrw(Instructions::Q0, Instructions::R0, 16, false, true));
+    add(Instructions::Vector::vldrw(Instructions::Q2, Instructions::R1, 16, false, true));
+    buffer[count++] = Instructions::Base::nop16();
+    add(Instructions::Vector::vpst(2));
+    add(Instructions::Vector::vldrw(Instructions::Q4, Instructions::R0));
+    add(Instructions::Vector::vldrw(Instructions::Q5, Instructions::R1));
+    add(Instructions::Vector::vfmaVectorByScalarPlusVector(Instructions::Q1, Instructions::Q0, Instructions::R3));
+    Instructions::Instruction16 expected[16];
+    for (uint16_t i = 0; i < count; i++) expected[i] = buffer[i];
+
+    Scheduler::schedule(buffer, count);
+    for (uint16_t i = 0; i < count; i++) REQUIRE(buffer[i] == expected[i]);
+}
+
+TEST_CASE("The backend schedules basic blocks", "[SCHEDULER]") {
+    Instructions::Instruction16 buffer[16];
+    Backend backend(buffer, 16);
+    Instructions::Instruction32 const loadQ0 = Instructions::Vector::vldrw(Instructions::Q0, Instructions::R0, 16, false, true);
+    Instructions::Instruction32 const loadQ2 = Instructions::Vector::vldrw(Instructions::Q2, Instructions::R1, 16, false, true);
+    Instructions::Instruction32 const fmaQ1 = Instructions::Vector::vfmaVectorByScalarPlusVector(Instructions::Q1, Instructions::Q0, Instructions::R3);
+    Instructions::Instruction32 const fmaQ3 = Instructions::Vector::vfmaVectorByScalarPlusVector(Instructions::Q3, Instructions::Q2, Instructions::R3);
+
+    SECTION("scheduling is off by default") {
+        backend.addInstruction(loadQ0);
+        backend.addInstruction(loadQ2);
+        backend.addInstruction(fmaQ1);
+        backend.clearCaches();
+        REQUIRE(read(buffer, 2) == loadQ2);
+    }
+    SECTION("the block is scheduled with clearCaches") {
+        backend.enableScheduling();
+        backend.addInstruction(loadQ0);
+        backend.addInstruction(loadQ2);
+        backend.addInstruction(fmaQ1);
+        backend.addInstruction(fmaQ3);
+        backend.clearCaches();
+        REQUIRE(read(buffer, 2) == fmaQ1);
+        REQUIRE(read(buffer, 4) == loadQ2);
+    }
+    SECTION("branch targets start a new block") {
+        backend.enableScheduling();
+        backend.addInstruction(loadQ0);
+        backend.addInstruction(loadQ2);
+        Instructions::Instruction16 * target = backend.addBranchTargetInstruction(fmaQ1);
+        backend.addInstruction(fmaQ3);
+        backend.clearCaches();
+        REQUIRE(target == &buffer[4]);
+        REQUIRE(read(buffer, 0) == loadQ0);
+        REQUIRE(read(buffer, 2) == loadQ2);
+        REQUIRE(read(buffer, 4) == fmaQ1);
+        REQUIRE(read(buffer, 6) == fmaQ3);
+    }
+}
@@ -31,6 +31,7 @@ TEST_CASE("VORR encodes correctly", "[VORR]") {
     SECTION("Test 1") {
         REQUIRE(Vector::vorr(Q1, Q2, Q3) == 0xef24'2156);
         REQUIRE(Vector::vorr(Q7, Q5, Q3) == 0xef2a'e156);
+        REQUIRE(Vector::vand(Q1, Q2, Q3) == 0xef04'2156);
     }
 }
 
@@ -62,6 +63,47 @@ TEST_CASE("VFMA Vector*Scalar encodes correctly", "[VFMA]") {
     }
 }
 
+TEST_CASE("VMUL Vector*Scalar encodes correctly", "[VMUL]") {
+    SECTION("Test 1") {
+        REQUIRE(Vector::vmulVectorByScalar(Q0, Q1, LR) == 0xee33'0e6e);
+        REQUIRE(Vector::vmulVectorByScalar(Q2, Q3, R4, true) == 0xfe37'4e64);
+    }
+}
+
+TEST_CASE("VMUL Integer Vector*Scalar encodes correctly", "[VMUL]") {
+    SECTION("Test 1") {
+        REQUIRE(Vector::vmulIntegerVectorByScalar(Q7, Q7, R12) == 0xee2f'fe6c);
+        REQUIRE(Vector::vmulIntegerVectorByScalar(Q1, Q2, R3, Size16) == 0xee15'3e63);
+        REQUIRE(Vector::vmulIntegerVectorByScalar(Q0, Q0, R0, Size8) == 0xee01'1e60);
+    }
+}
+
+TEST_CASE("VIDUP encodes correctly", "[VIDUP]") {
+    SECTION("Test 1") {
+        REQUIRE(Vector::vidup(Q7, R8, 1) == 0xee29'ef6e);
+        REQUIRE(Vector::vidup(Q2, R4, 4) == 0xee25'4fee);
+        REQUIRE(Vector::vidup(Q0, R0, 2) == 0xee21'0f6f);
+        REQUIRE(Vector::vidup(Q0, R0, 8) == 0xee21'0fef);
+    }
+
+    SECTION("validate errors") {
+        REQUIRE(Vector::vidup(Q0, R1, 1) == Base::nop32());
+        REQUIRE(Vector::vidup(Q0, R0, 3) == Base::nop32());
+    }
+}
+
+TEST_CASE("VLDRW Gather encodes correctly", "[VLDR]") {
+    SECTION("Test 1") {
+        REQUIRE(Vector::vldrwGather(Q6, R0, Q7) == 0xfc90'cf4f);
+        REQUIRE(Vector::vldrwGather(Q1, R3, Q2) == 0xfc93'2f45);
+        REQUIRE(Vector::vldrwGather(Q0, R11, Q5) == 0xfc9b'0f4b);
+    }
+
+    SECTION("validate errors") {
+        REQUIRE(Vector::vldrwGather(Q1, R0, Q1) == Base::nop32());
+    }
+}
+
 TEST_CASE("VLDRW encodes correctly", "[VLDR]") {
     SECTION("Test 1") {
         REQUIRE(Vector::vldrw(Q3, R11, 4) == 0xed9b'7f01);
@@ -90,6 +132,144 @@ TEST_CASE("VSTRW encodes correctly", "[VSTRW]") {
     }
 }
 
+TEST_CASE("VLDRH/VSTRH encode correctly", "[VLDR]") {
+    SECTION("16 bit elements") {
+        REQUIRE(Vector::vldrh(Q0, R0) == 0xed90'1e80);
+        REQUIRE(Vector::vldrh(Q1, R2, 2) == 0xed92'3e81);
+        REQUIRE(Vector::vldrh(Q7, R12, 254) == 0xed9c'feff);
+        REQUIRE(Vector::vldrh(Q0, R0, -2) == 0xed10'1e81);
+        REQUIRE(Vector::vldrh(Q0, R0, 16, true, true) == 0xedb0'1e88);
+        REQUIRE(Vector::vldrh(Q0, R0, 16, false, true) == 0xecb0'1e88);
+        REQUIRE(Vector::vstrh(Q0, R0) == 0xed80'1e80);
+        REQUIRE(Vector::vstrh(Q3, R5, 32) == 0xed85'7e90);
+    }
+    SECTION("widening load / narrowing store") {
+        REQUIRE(Vector::vldrhWidening(Q0, R0) == 0xfd98'0f00);
+        REQUIRE(Vector::vldrhWidening(Q1, R2, 2) == 0xfd9a'2f01);
+        REQUIRE(Vector::vldrhWidening(Q6, R1, 8, true, true) == 0xfdb9'cf04);
+        REQUIRE(Vector::vstrhNarrowing(Q0, R0) == 0xed88'0f00);
+        REQUIRE(Vector::vstrhNarrowing(Q2, R3, 8) == 0xed8b'4f04);
+    }
+    SECTION("validate errors") {
+        REQUIRE(Vector::vldrh(Q0, R0, 3) == Base::nop32());
+        REQUIRE(Vector::vstrh(Q0, R0, 256) == Base::nop32());
+        REQUIRE(Vector::vldrhWidening(Q0, R8) == Base::nop32());
+        REQUIRE(Vector::vstrhNarrowing(Q0, R1, 255) == Base::nop32());
+    }
+}
+
+TEST_CASE("VLDRB/VSTRB encode correctly", "[VLDRB]") {
+    SECTION("8 bit elements") {
+        REQUIRE(Vector::vldrb(Q0, R3, 16, false, true) == 0xecb3'1e10);
+        REQUIRE(Vector::vldrb(Q7, R11, -16) == 0xed1b'fe10);
+        REQUIRE(Vector::vldrb(Q0, R0, 127) == 0xed90'1e7f);
+        REQUIRE(Vector::vldrb(Q0, R0, 16, true, true) == 0xedb0'1e10);
+        REQUIRE(Vector::vstrb(Q0, R0) == 0xed80'1e00);
+        REQUIRE(Vector::vstrb(Q5, R9, -3) == 0xed09'be03);
+    }
+    SECTION("narrowing store") {
+        REQUIRE(Vector::vstrbNarrowing(Q2, R2, 4) == 0xed82'4f04);
+        REQUIRE(Vector::vstrbNarrowing(Q7, R7, -127) == 0xed07'ef7f);
+        REQUIRE(Vector::vstrbNarrowing(Q1, R4, 4, false, true) == 0xeca4'2f04);
+    }
+    SECTION("validate errors") {
+        REQUIRE(Vector::vldrb(Q0, R0, 128) == Base::nop32());
+        REQUIRE(Vector::vstrb(Q0, R0, -128) == Base::nop32());
+        REQUIRE(Vector::vstrbNarrowing(Q0, R8) == Base::nop32());
+    }
+}
+
+TEST_CASE("VCVTB/VCVTT encode correctly", "[VCVT]") {
+    SECTION("Test 1") {
+        REQUIRE(Vector::vcvtb(Q0, Q0, true) == 0xfe3f'0e01);
+        REQUIRE(Vector::vcvtb(Q1, Q2, true) == 0xfe3f'2e05);
+        REQUIRE(Vector::vcvtb(Q3, Q4, false) == 0xee3f'6e09);
+        REQUIRE(Vector::vcvtt(Q0, Q0, true) == 0xfe3f'1e01);
+    }
+}
+
+TEST_CASE("VMOV two lanes to GP encodes correctly", "[VMOV]") {
+    SECTION("Test 1") {
+        REQUIRE(Vector::vmovLanesToGP(R0, R1, Q0, false) == 0xec01'0f00);
+        REQUIRE(Vector::vmovLanesToGP(R6, R7, Q7, false) == 0xec07'ef06);
+        REQUIRE(Vector::vmovLanesToGP(R8, R12, Q7, true) == 0xec0c'ef18);
+    }
+    SECTION("validate errors") {
+        REQUIRE(Vector::vmovLanesToGP(R0, R0, Q0, false) == Base::nop32());
+        REQUIRE(Vector::vmovLanesToGP(R0, SP, Q0, false) == Base::nop32());
+    }
+}
+
+TEST_CASE("VMOV two GP registers to lanes and VDUP encode correctly", "[VMOV]") {
+    SECTION("Test 1") {
+        REQUIRE(Vector::vmovGPToLanes(Q2, R8, R4, false) == 0xec14'4f08);
+        REQUIRE(Vector::vmovGPToLanes(Q7, R10, R6, true) == 0xec16'ef1a);
+        REQUIRE(Vector::vdup(Q7, R12) == 0xeeae'cb10);
+    }
+    SECTION("validate errors") {
+        REQUIRE(Vector::vmovGPToLanes(Q0, PC, R0, false) == Base::nop32());
+    }
+}
+
+TEST_CASE("VMLADAV encodes correctly", "[VMLADAV]") {
+    SECTION("Test 1") {
+        REQUIRE(Vector::vmladav(R10, Q7, Q2) == 0xeefe'af24);
+        REQUIRE(Vector::vmladav(R4, Q0, Q1, false) == 0xeef0'4f02);
+        REQUIRE(Vector::vmladav(R12, Q1, Q6) == 0xeef2'cf2c);
+    }
+    SECTION("validate errors") {
+        REQUIRE(Vector::vmladav(R3, Q0, Q1) == Base::nop32());
+    }
+}
+
+TEST_CASE("Integer arithmetic encodes correctly", "[VADD]") {
+    SECTION("add / sub") {
+        REQUIRE(Vector::vadd(Q7, Q1, Q6) == 0xef22'e84c);
+        REQUIRE(Vector::vadd(Q1, Q2, Q3, Size8) == 0xef04'2846);
+        REQUIRE(Vector::vaddScalar(Q7, Q1, R12) == 0xee23'ef4c);
+        REQUIRE(Vector::vsub(Q0, Q7, Q1) == 0xff2e'0842);
+    }
+    SECTION("max / min") {
+        REQUIRE(Vector::vmax(Q7, Q1, Q6) == 0xef22'e64c);
+        REQUIRE(Vector::vmin(Q7, Q1, Q6) == 0xef22'e65c);
+        REQUIRE(Vector::vmin(Q2, Q3, Q4, Size16) == 0xef16'4658);
+    }
+    SECTION("requantization") {
+        REQUIRE(Vector::vqrdmulh(Q7, Q1, Q6) == 0xff22'eb4c);
+        REQUIRE(Vector::vshl(Q7, Q1, Q6) == 0xef2c'e442);
+        REQUIRE(Vector::vrshl(Q7, Q1, Q5) == 0xef2a'e542);
+        REQUIRE(Vector::vshlImmediate(Q7, Q1, 31) == 0xefbf'e552);
+        REQUIRE(Vector::vshlImmediate(Q2, Q3, 0) == 0xefa0'4556);
+        REQUIRE(Vector::vrshrImmediate(Q7, Q1, 32) == 0xefa0'e252);
+        REQUIRE(Vector::vrshrImmediate(Q2, Q3, 5) == 0xefbb'4256);
+        REQUIRE(Vector::vshrImmediate(Q7, Q1, 31) == 0xefa1'e052);
+        REQUIRE(Vector::vshrImmediate(Q2, Q3, 5) == 0xefbb'4056);
+        REQUIRE(Vector::vqadd(Q7, Q1, Q6) == 0xef22'e05c);
+    }
+    SECTION("validate errors") {
+        REQUIRE(Vector::vshlImmediate(Q0, Q0, 32) == Base::nop32());
+        REQUIRE(Vector::vrshrImmediate(Q0, Q0, 0) == Base::nop32());
+        REQUIRE(Vector::vshrImmediate(Q0, Q0, 33) == Base::nop32());
+    }
+}
+
+TEST_CASE("Floating point add and min / max encode correctly", "[VADD]") {
+    SECTION("add") {
+        REQUIRE(Vector::vaddFloat(Q0, Q0, Q0) == 0xef00'0d40);
+        REQUIRE(Vector::vaddFloat(Q7, Q1, Q6) == 0xef02'ed4c);
+        REQUIRE(Vector::vaddFloat(Q0, Q0, Q0, true) == 0xef10'0d40);
+        REQUIRE(Vector::vaddFloatScalar(Q0, Q0, R0) == 0xee30'0f40);
+        REQUIRE(Vector::vaddFloatScalar(Q7, Q1, R12) == 0xee32'ef4c);
+        REQUIRE(Vector::vaddFloatScalar(Q0, Q0, R0, true) == 0xfe30'0f40);
+    }
+    SECTION("max / min") {
+        REQUIRE(Vector::vmaxnm(Q0, Q0, Q0) == 0xff00'0f50);
+        REQUIRE(Vector::vmaxnm(Q7, Q1, Q6) == 0xff02'ef5c);
+        REQUIRE(Vector::vminnm(Q0, Q0, Q0) == 0xff20'0f50);
+        REQUIRE(Vector::vmaxnm(Q0, Q0, Q0, true) == 0xff10'0f50);
+    }
+}
+
 TEST_CASE("VCTP encodes correctly", "[VCTP]") {
     SECTION("Test 1") {
         REQUIRE(Vector::vctp(Size32, R3) == 0xf023'e801);
@@ -0,0 +1,158 @@
+/*
+Host tool which generates the GEMM kernels of fixed shapes and writes their images (see GemmImage).
+The images are loaded on the target with GemmImageLoader, so the kernels don't have to be generated at boot.
+
+    gemm_images <output> <hp|he|any> [--tuning=<file>] <shape>...
+
+shape: m,k,n[,lda,ldb,ldc[,alpha,beta[,layout]]], the leading dimensions default to the column-major NN ones,
+layout is the value of Gemm::Layout.
+The kernels are only tuned for the core if the tuning table of a GemmTuner run on that core is passed: the file holds the
+lines of GemmTuningTable::print, all other lines (e.g. the declaration of the array) are ignored. Without it the
+kernels use the default heuristics and the core only selects where the images are loaded.
+An output ending in .h is written as C array gemm_images (for the target build), all others as raw blob.
+*/
+#include "generators/Gemm.hpp"
+#include "generators/GemmCache.hpp"
+#include "generators/GemmImage.hpp"
+#include "generators/GemmTuningTable.hpp"
+#include "instructions/Base.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+    constexpr uint32_t BUFFER_SIZE = 1 << 15; // halfwords of the generator
+    constexpr uint32_t BLOB_SIZE = 1 << 20; // bytes of all images
+
+    alignas(4) JIT::Instructions::Instruction16 buffer[BUFFER_SIZE];
+    alignas(4) uint8_t programStorage[JIT::Generators::Gemm::programStorageSize(BUFFER_SIZE)];
+    alignas(4) uint8_t blob[BLOB_SIZE];
+    JIT::Generators::GemmTuningTable tuningTable;
+
+    bool parseShape(char const * text, JIT::Generators::GemmCache::Key & key) {
+        uint32_t m = 0, k = 0, n = 0, lda = 0, ldb = 0, ldc = 0, layout = JIT::Generators::Gemm::COLUMN_MAJOR_NN;
+        float alpha = 1.0f, beta = 1.0f;
+        int const fields = std::sscanf(text, "%u,%u,%u,%u,%u,%u,%f,%f,%u", &m, &k, &n, &lda, &ldb, &ldc, &alpha, &beta, &layout);
+        if (fields != 3 && fields != 6 && fields != 8 && fields != 9) return false;
+        if (fields == 3) {
+            lda = m;
+            ldb = k;
+            ldc = m;
+        }
+        key = JIT::Generators::GemmCache::makeKey(m, k, n, lda, ldb, ldc, false, alpha, beta, static_cast<JIT::Generators::Gemm::Layout>(layout));
+        return true;
+    }
+
+    bool parseCore(char const * text, JIT::Generators::GemmImage::Core & core) {
+        if (std::strcmp(text, "hp") == 0) core = JIT::Generators::GemmImage::CORE_HP;
+        else if (std::strcmp(text, "he") == 0) core = JIT::Generators::GemmImage::CORE_HE;
+        else if (std::strcmp(text, "any") == 0) core = JIT::Generators::GemmImage::CORE_ANY;
+        else return false;
+        return true;
+    }
+
+    bool parseBool(char const * text, bool & value) {
+        if (std::strcmp(text, "true") == 0) value = true;
+        else if (std::strcmp(text, "false") == 0) value = false;
+        else return false;
+        return true;
+    }
+
+    // reads the entries printed by GemmTuningTable::print into tuningTable
+    bool readTuningTable(char const * path) {
+        FILE * file = std::fopen(path, "r");
+        if (file == nullptr) {
+            std::fprintf(stderr, "could not open %s\n", path);
+            return false;
+        }
+        char line[JIT::Generators::GemmTuningTable::MAX_LINE];
+        bool valid = true;
+        while (valid && std::fgets(line, sizeof(line), file) != nullptr) {
+            char const * start = line + std::strspn(line, " \t");
+            if (*start != '{') continue;
+            JIT::Generators::GemmTuningTable::Entry entry = {};
+            unsigned m, k, n, lda, ldb, ldc, layout, kMaxUnroll, mMaxUnroll, nMaxUnroll;
+            char use46Microkernel[6], predicatedEdges[6];
+            int const fields = std::sscanf(start, "{%u, %u, %u, %u, %u, %u, static_cast<JIT::Generators::Gemm::Layout>(%u), {%5[a-z], %u, %u, %u, %5[a-z]}}",
+                &m, &k, &n, &lda, &ldb, &ldc, &layout, use46Microkernel, &kMaxUnroll, &mMaxUnroll, &nMaxUnroll, predicatedEdges);
+            valid = fields == 12 && parseBool(use46Microkernel, entry.tuning.use46Microkernel) && parseBool(predicatedEdges, entry.tuning.predicatedEdges);
+            entry.m = m;
+            entry.k = k;
+            entry.n = n;
+            entry.lda = lda;
+            entry.ldb = ldb;
+            entry.ldc = ldc;
+            entry.layout = static_cast<JIT::Generators::Gemm::Layout>(layout);
+            entry.tuning.kMaxUnroll = static_cast<uint8_t>(kMaxUnroll);
+            entry.tuning.mMaxUnroll = static_cast<uint8_t>(mMaxUnroll);
+            entry.tuning.nMaxUnroll = static_cast<uint8_t>(nMaxUnroll);
+            if (!valid) std::fprintf(stderr, "invalid tuning entry %s", start);
+            else if (!tuningTable.insert(entry)) {
+                std::fprintf(stderr, "more than %u tuning entries\n", JIT::Generators::GemmTuningTable::MAX_ENTRIES);
+                valid = false;
+            }
+        }
+        std::fclose(file);
+        return valid;
+    }
+
+    bool writeHeader(FILE * file, uint32_t size) {
+        std::fprintf(file, "// generated by gemm_images, load with JIT::Generators::GemmImageLoader\n");
+        std::fprintf(file, "#include <cstdint>\n\n");
+        std::fprintf(file, "alignas(4) static uint8_t const gemm_images[%u] = {", size);
+        for (uint32_t i = 0; i < size; i++) {
+            std::fprintf(file, "%s0x%02x,", i % 16 == 0 ? "\n    " : " ", blob[i]);
+        }
+        return std::fprintf(file, "\n};\n") > 0;
+    }
+}
+
+int main(int argc, char ** argv) {
+    JIT::Generators::GemmImage::Core core;
+    constexpr char TUNING_OPTION[] = "--tuning=";
+    bool const tuned = argc > 3 && std::strncmp(argv[3], TUNING_OPTION, sizeof(TUNING_OPTION) - 1) == 0;
+    int const firstShape = tuned ? 4 : 3;
+    if (argc <= firstShape || !parseCore(argv[2], core)) {
+        std::fprintf(stderr, "usage: %s <output> <hp|he|any> [--tuning=<file>] m,k,n[,lda,ldb,ldc[,alpha,beta[,layout]]]...\n", argv[0]);
+        return 1;
+    }
+
+    JIT::Generators::Gemm generator(buffer, BUFFER_SIZE, programStorage, sizeof(programStorage));
+    if (tuned) {
+        if (!readTuningTable(argv[3] + sizeof(TUNING_OPTION) - 1)) return 1;
+        generator.setTuningTable(&tuningTable);
+        std::printf("%u tuning entries\n", tuningTable.getCount());
+    }
+    uint32_t size = 0;
+    for (int i = firstShape; i < argc; i++) {
+        JIT::Generators::GemmCache::Key key;
+        if (!parseShape(argv[i], key)) {
+            std::fprintf(stderr, "invalid shape %s\n", argv[i]);
+            return 1;
+        }
+        uint32_t const imageSize = JIT::Generators::GemmImage::write(generator, key, core, blob + size, BLOB_SIZE - size);
+        if (imageSize == 0) {
+            std::fprintf(stderr, "could not generate %s\n", argv[i]);
+            return 1;
+        }
+        std::printf("%s: %u bytes\n", argv[i], imageSize);
+        size += imageSize;
+    }
+
+    char const * output = argv[1];
+    size_t const length = std::strlen(output);
+    bool const header = length > 2 && std::strcmp(output + length - 2, ".h") == 0;
+    FILE * file = std::fopen(output, header ? "w" : "wb");
+    if (file == nullptr) {
+        std::fprintf(stderr, "could not open %s\n", output);
+        return 1;
+    }
+    bool const written = header ? writeHeader(file, size) : std::fwrite(blob, 1, size, file) == size;
+    std::fclose(file);
+    if (!written) {
+        std::fprintf(stderr, "could not write %s\n", output);
+        return 1;
+    }
+    std::printf("%d images, %u bytes\n", argc - firstShape, size);
+    return 0;
+}